@@ -15,6 +15,7 @@ set( _OTK_PROJECT_OPTIONS_SET ON )
 option( OTK_USE_VCPKG         "Use vcpkg for third party libraries" ON )
 option( OTK_USE_OPENEXR       "Use OpenEXR in DemandLoading to read EXRs" ON )
 option( OTK_USE_OIIO          "Use OpenImageIO to allow DemandLoading to read PNGs and JPGs" OFF )
+option( OTK_USE_ZSTD          "Use zstd in DemandLoading to read supercompressed KTX2 files" ON )
 # OTK_USE_VCPKG takes precedence over FetchContent if both are ON.
 option( OTK_FETCH_CONTENT     "Use FetchContent for third party libraries, if OTK_USE_VCPKG is OFF" ON )
 option( OTK_BUILD_EXAMPLES    "Enable build of OptiXToolkit examples" ON )
@@ -64,6 +65,7 @@ if( OTK_USE_VCPKG )
     otk_vcpkg_feature( OTK_USE_OPENEXR        "otk-openexr" )
     # OpenImageIO is too costly to include by default (it depends on Boost).
     otk_vcpkg_feature( OTK_USE_OIIO           "otk-openimageio" )
+    otk_vcpkg_feature( OTK_USE_ZSTD           "otk-zstd" )
     otk_vcpkg_feature( OTK_BUILD_EXAMPLES     "otk-examples" )
     otk_vcpkg_feature( OTK_BUILD_TESTS        "otk-tests" )
 
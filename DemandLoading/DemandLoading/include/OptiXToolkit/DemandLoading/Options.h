@@ -51,6 +51,9 @@ struct Options
 
     // Trace file
     std::string traceFile;  ///< trace filename (disabled if empty).
+
+    // Image hash index
+    std::string imageHashIndexFile;  ///< persistent image hashes for coalesceDuplicateImages (if empty, only coarse mip levels are hashed).
 };
 // clang-format on
 
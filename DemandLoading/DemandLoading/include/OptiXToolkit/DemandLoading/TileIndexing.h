@@ -51,6 +51,14 @@ HD_INLINE unsigned int getLevelDimInTiles( unsigned int textureDim, unsigned int
     return ( calculateLevelDim( mipLevel, textureDim ) + tileDim - 1 ) / tileDim;
 }
 
+// Return the number of blocks spanned by the given number of texels.  The block dimension is 4 for
+// block-compressed formats and 1 otherwise.  Tile dimensions are always multiples of the block
+// dimension, but the smallest mip levels are padded to whole blocks.
+HD_INLINE unsigned int getDimInBlocks( unsigned int dimInTexels, unsigned int blockDim )
+{
+    return ( dimInTexels + blockDim - 1 ) / blockDim;
+}
+
 HD_INLINE unsigned int calculateNumTilesInLevel( unsigned int levelWidthInTiles, unsigned int levelHeightInTiles )
 {
     return levelWidthInTiles * levelHeightInTiles;
@@ -18,6 +18,7 @@
 #include <OptiXToolkit/Error/ErrorCheck.h>
 #include <OptiXToolkit/Error/cuErrorCheck.h>
 #include <OptiXToolkit/ImageSource/CascadeImage.h>
+#include <OptiXToolkit/ImageSource/ImageHash.h>
 
 #include <cuda.h>
 
@@ -130,6 +131,10 @@ DemandLoaderImpl::DemandLoaderImpl( const Options& options )
     , m_cascadeRequestHandler( this )
     , m_deviceTransferPool( new otk::DeviceAsyncAllocator(), new RingSuballocator(), DEFAULT_ALLOC_SIZE, options.maxPinnedMemory )
 {
+    // Load previously computed image hashes so that unchanged files need not be hashed again.
+    if( options.coalesceDuplicateImages && !options.imageHashIndexFile.empty() )
+        m_imageHashIndex.reset( new imageSource::ImageHashIndex( options.imageHashIndexFile ) );
+
     // The demand loader is for the current cuda context
     OTK_ERROR_CHECK( cuCtxGetCurrent( &m_cudaContext ) );
 
@@ -245,10 +250,15 @@ DemandTextureImpl* DemandLoaderImpl::makeTextureOrVariant( unsigned int textureI
 
     // Check to see if the image source is identical to another in use.
     // TODO: Move this to SamplerRequestHandler to keep lazy opening of image files.
-    unsigned long long hash = 0;
+    imageSource::ImageHash hash{};
     if( m_options->coalesceDuplicateImages )
     {
-        hash = imageSource->getHash( (CUstream)0 );
+        // Without an index, the hash is recomputed by every loader in every run, so only the coarse
+        // mip levels are hashed.
+        imageSource::ImageHashOptions coarseLevels;
+        coarseLevels.maxLevelSize = imageSource::COARSE_HASH_LEVEL_SIZE;
+        hash = m_imageHashIndex ? m_imageHashIndex->getHash( *imageSource, CUstream{} ) :
+                                  imageSource::computeImageHash( *imageSource, coarseLevels, CUstream{} );
         auto hashIt = m_hashToTextureId.find( hash );
         if( hashIt != m_hashToTextureId.end() )
         {
@@ -259,7 +269,7 @@ DemandTextureImpl* DemandLoaderImpl::makeTextureOrVariant( unsigned int textureI
 
     // Record the textureId for the current image and its hash.
     m_imageToTextureId[imageSource.get()] = textureId;
-    if( hash )
+    if( hash.isValid() )
         m_hashToTextureId[hash] = textureId;
 
     // For cascading texture sizes, make a CascadeImage wrapper.
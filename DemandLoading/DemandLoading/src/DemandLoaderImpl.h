@@ -18,6 +18,7 @@
 #include "Textures/SamplerRequestHandler.h"
 #include "Textures/CascadeRequestHandler.h"
 #include <OptiXToolkit/DemandLoading/TextureCascade.h>
+#include <OptiXToolkit/ImageSource/ImageHash.h>
 #include "TransferBufferDesc.h"
 
 #include <cuda.h>
@@ -183,7 +184,8 @@ class DemandLoaderImpl : public DemandLoader
 
     std::map<unsigned int, std::unique_ptr<DemandTextureImpl>> m_textures; // demand-loaded textures, indexed by textureId
     std::map<imageSource::ImageSource*, unsigned int> m_imageToTextureId;  // look up textureId from image*
-    std::map<unsigned long long, unsigned int> m_hashToTextureId; // look up textureId from image hash
+    std::map<imageSource::ImageHash, unsigned int> m_hashToTextureId; // look up textureId from image hash
+    std::unique_ptr<imageSource::ImageHashIndex> m_imageHashIndex;    // persistent image hashes (optional)
 
     SamplerRequestHandler m_samplerRequestHandler;  // Handles requests for texture samplers.
     CascadeRequestHandler m_cascadeRequestHandler;  // Handles cascading texture sizes.
@@ -121,7 +121,7 @@ void DemandTextureImpl::init()
             m_mipTailSize       = m_mipTailFirstLevel < m_info.numMipLevels ? m_sparseTexture.getMipTailSize() : 0;
 
             // Verify that the tile size agrees with TilePool.
-            OTK_ASSERT( m_tileWidth * m_tileHeight * imageSource::getBytesPerChannel( m_info.format ) <= TILE_SIZE_IN_BYTES );
+            OTK_ASSERT( imageSource::getImageSizeInBytes( m_info.format, m_info.numChannels, m_tileWidth, m_tileHeight ) <= TILE_SIZE_IN_BYTES );
 
             // Record the dimensions of each miplevel.
             const unsigned int numMipLevels = m_info.numMipLevels;
@@ -163,8 +163,8 @@ void DemandTextureImpl::init()
 
                 m_mipLevelDims[i] = m_denseTexture.getMipLevelDims( i );
 
-                m_mipTailSize += m_mipLevelDims[i].x * m_mipLevelDims[i].y * m_info.numChannels
-                                 * imageSource::getBytesPerChannel( m_info.format );
+                m_mipTailSize += imageSource::getImageSizeInBytes( m_info.format, m_info.numChannels, m_mipLevelDims[i].x,
+                                                                   m_mipLevelDims[i].y );
             }
             initSampler();
         }
@@ -345,8 +345,8 @@ bool DemandTextureImpl::readTile( unsigned int mipLevel, unsigned int tileX, uns
     OTK_ASSERT( mipLevel < m_info.numMipLevels );
 
     // Resize buffer if necessary.
-    const unsigned int bytesPerPixel = imageSource::getBytesPerChannel( getInfo().format ) * getInfo().numChannels;
-    const unsigned int bytesPerTile  = getTileWidth() * getTileHeight() * bytesPerPixel;
+    const size_t bytesPerTile =
+        imageSource::getImageSizeInBytes( getInfo().format, getInfo().numChannels, getTileWidth(), getTileHeight() );
     OTK_ASSERT_MSG( bytesPerTile <= tileBufferSize, "Maximum tile size exceeded" );
     (void)bytesPerTile;  // silence unused variable warning
     (void)tileBufferSize;
@@ -409,8 +409,12 @@ bool DemandTextureImpl::readMipLevels( char* buffer, size_t bufferSize, unsigned
     OTK_ASSERT( m_isInitialized );
     OTK_ASSERT( startLevel < getInfo().numMipLevels );
 
-    const unsigned int pixelSize = getInfo().numChannels * imageSource::getBytesPerChannel( getInfo().format );
-    size_t dataSize = ( m_mipLevelDims[startLevel].x * m_mipLevelDims[startLevel].y * pixelSize * 4 ) / 3;
+    // Block-compressed images have no pixel size; their readers compute level sizes from the format.
+    const imageSource::TextureInfo& info = getInfo();
+    const unsigned int pixelSize = imageSource::isBlockCompressed( info.format ) ? 0 : info.numChannels * imageSource::getBytesPerChannel( info.format );
+    size_t dataSize = 0;
+    for( unsigned int mipLevel = startLevel; mipLevel < info.numMipLevels; ++mipLevel )
+        dataSize += imageSource::getImageSizeInBytes( info.format, info.numChannels, m_mipLevelDims[mipLevel].x, m_mipLevelDims[mipLevel].y );
     OTK_ASSERT_MSG( dataSize <= bufferSize, "Provided buffer is too small." );
     (void)dataSize;  // silence unused variable warning
     (void)bufferSize;
@@ -5,6 +5,7 @@
 #include "Textures/DenseTexture.h"
 #include "Util/ContextSaver.h"
 
+#include <OptiXToolkit/DemandLoading/TileIndexing.h>
 #include <OptiXToolkit/Error/ErrorCheck.h>
 #include <OptiXToolkit/Error/cuErrorCheck.h>
 #include <OptiXToolkit/ImageSource/ImageSource.h>
@@ -94,7 +95,8 @@ void DenseTexture::fillTexture( CUstream stream, const char* textureData, unsign
 
     // Fill each level.
     size_t             offset    = 0;
-    const unsigned int pixelSize = m_info.numChannels * imageSource::getBytesPerChannel( m_info.format );
+    const unsigned int blockDim  = imageSource::getBlockDim( m_info.format );
+    const unsigned int blockSize = imageSource::getBytesPerBlock( m_info.format, m_info.numChannels );
 
     for( unsigned int mipLevel = 0; mipLevel < m_info.numMipLevels; ++mipLevel )
     {
@@ -106,20 +108,20 @@ void DenseTexture::fillTexture( CUstream stream, const char* textureData, unsign
         CUDA_MEMCPY2D copyArgs{};
         copyArgs.srcMemoryType = CU_MEMORYTYPE_HOST;
         copyArgs.srcHost       = textureData + offset;
-        copyArgs.srcPitch      = levelDims.x * pixelSize;
+        copyArgs.srcPitch      = getDimInBlocks( levelDims.x, blockDim ) * blockSize;
 
         copyArgs.dstMemoryType = CU_MEMORYTYPE_ARRAY;
         copyArgs.dstArray      = mipLevelArray;
 
-        copyArgs.WidthInBytes = levelDims.x * pixelSize;
-        copyArgs.Height       = levelDims.y;
+        copyArgs.WidthInBytes = copyArgs.srcPitch;
+        copyArgs.Height       = getDimInBlocks( levelDims.y, blockDim );
 
         if( bufferPinned )
             OTK_ERROR_CHECK( cuMemcpy2DAsync( &copyArgs, stream ) );
         else 
             OTK_ERROR_CHECK( cuMemcpy2D( &copyArgs ) );
 
-        offset += levelDims.x * levelDims.y * pixelSize;
+        offset += copyArgs.WidthInBytes * copyArgs.Height;
         m_numBytesFilled += copyArgs.WidthInBytes * copyArgs.Height;
     }
 }
@@ -130,7 +130,9 @@ bool SamplerRequestHandler::fillDenseTexture( CUstream stream, unsigned int page
 
     // Try to get transfer buffer from the demand loader. We prefer it because it allows asynchronous fill.
     // The buffer needs to be a little larger than the texture size for some reason to prevent a crash, hence the extra 4 / 3.
-    size_t transferBufferSize = getTextureSizeInBytes( info ) * 4 / 3;
+    // The mip tail of a dense texture spans every level, which exceeds the estimate for small
+    // block-compressed textures whose coarsest levels are padded to whole blocks.
+    size_t transferBufferSize = std::max( getTextureSizeInBytes( info ) * 4 / 3, texture->getMipTailSize() );
     TransferBufferDesc transferBuffer =
         m_loader->allocateTransferBuffer( texture->getFillType(), transferBufferSize, stream );
     char* dataPtr = reinterpret_cast<char*>( transferBuffer.memoryBlock.ptr );
@@ -5,6 +5,7 @@
 #include "Textures/SparseTexture.h"
 #include "Util/ContextSaver.h"
 
+#include <OptiXToolkit/DemandLoading/TileIndexing.h>
 #include <OptiXToolkit/Error/ErrorCheck.h>
 #include <OptiXToolkit/Error/cuErrorCheck.h>
 #include <OptiXToolkit/ImageSource/ImageSource.h>
@@ -269,26 +270,27 @@ void SparseTexture::fillTile( CUstream                     stream,
     // Get CUDA array for the specified miplevel.
     CUarray mipLevelArray = m_array->getLevel( mipLevel );
 
-    // Copy tile data into CUDA array
-    const unsigned int pixelSize = m_info.numChannels * imageSource::getBytesPerChannel( m_info.format );
+    // Copy tile data into CUDA array.  Block-compressed arrays are addressed in rows of blocks.
+    const unsigned int blockDim  = imageSource::getBlockDim( m_info.format );
+    const unsigned int blockSize = imageSource::getBytesPerBlock( m_info.format, m_info.numChannels );
 
     CUDA_MEMCPY2D copyArgs{};
     copyArgs.srcMemoryType = tileMemoryType;
     copyArgs.srcHost       = ( tileMemoryType == CU_MEMORYTYPE_HOST ) ? tileData : nullptr;
     copyArgs.srcDevice     = ( tileMemoryType == CU_MEMORYTYPE_DEVICE ) ? reinterpret_cast<CUdeviceptr>( tileData ) : 0;
-    copyArgs.srcPitch      = getTileWidth() * pixelSize;
+    copyArgs.srcPitch      = getTileWidth() / blockDim * blockSize;
 
-    copyArgs.dstXInBytes = tileX * getTileWidth() * pixelSize;
-    copyArgs.dstY        = tileY * getTileHeight();
+    copyArgs.dstXInBytes = tileX * getTileWidth() / blockDim * blockSize;
+    copyArgs.dstY        = tileY * getTileHeight() / blockDim;
 
     copyArgs.dstMemoryType = CU_MEMORYTYPE_ARRAY;
     copyArgs.dstArray      = mipLevelArray;
 
-    copyArgs.WidthInBytes = tileDims.x * pixelSize;
-    copyArgs.Height       = tileDims.y;
+    copyArgs.WidthInBytes = getDimInBlocks( tileDims.x, blockDim ) * blockSize;
+    copyArgs.Height       = getDimInBlocks( tileDims.y, blockDim );
 
     OTK_ERROR_CHECK( cuMemcpy2DAsync( &copyArgs, stream ) );
-    m_numBytesFilled += getTileWidth() * getTileHeight() * pixelSize;
+    m_numBytesFilled += imageSource::getImageSizeInBytes( m_info.format, m_info.numChannels, getTileWidth(), getTileHeight() );
 }
 
 
@@ -325,7 +327,8 @@ void SparseTexture::fillMipTail( CUstream                     stream,
 
     // Fill each level in the mip tail.
     size_t             offset    = 0;
-    const unsigned int pixelSize = m_info.numChannels * imageSource::getBytesPerChannel( m_info.format );
+    const unsigned int blockDim  = imageSource::getBlockDim( m_info.format );
+    const unsigned int blockSize = imageSource::getBytesPerBlock( m_info.format, m_info.numChannels );
     for( unsigned int mipLevel = getMipTailFirstLevel(); mipLevel < m_info.numMipLevels; ++mipLevel )
     {
         CUarray mipLevelArray = m_array->getLevel( mipLevel );
@@ -335,17 +338,17 @@ void SparseTexture::fillMipTail( CUstream                     stream,
         copyArgs.srcMemoryType = mipTailMemoryType;
         copyArgs.srcHost       = ( mipTailMemoryType == CU_MEMORYTYPE_HOST ) ? mipTailData + offset : nullptr;
         copyArgs.srcDevice     = ( mipTailMemoryType == CU_MEMORYTYPE_DEVICE ) ? reinterpret_cast<CUdeviceptr>( mipTailData + offset ) : 0;
-        copyArgs.srcPitch      = levelDims.x * pixelSize;
+        copyArgs.srcPitch      = getDimInBlocks( levelDims.x, blockDim ) * blockSize;
 
         copyArgs.dstMemoryType = CU_MEMORYTYPE_ARRAY;
         copyArgs.dstArray      = mipLevelArray;
 
-        copyArgs.WidthInBytes = levelDims.x * pixelSize;
-        copyArgs.Height       = levelDims.y;
+        copyArgs.WidthInBytes = copyArgs.srcPitch;
+        copyArgs.Height       = getDimInBlocks( levelDims.y, blockDim );
 
         OTK_ERROR_CHECK( cuMemcpy2DAsync( &copyArgs, stream ) );
 
-        offset += levelDims.x * levelDims.y * pixelSize;
+        offset += copyArgs.WidthInBytes * copyArgs.Height;
     }
 
     m_numBytesFilled += getMipTailSize();
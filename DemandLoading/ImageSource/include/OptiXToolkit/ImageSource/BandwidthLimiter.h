@@ -0,0 +1,140 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file BandwidthLimiter.h
+/// Token-bucket throttling of image reads, shared by the readers on a storage device.
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace imageSource {
+
+/// Priority classes for throttled reads.  Waiting reads of a higher class are always granted
+/// first: the mip tail is needed to render anything, while fine tiles only add detail.
+enum IOPriority
+{
+    IO_PRIORITY_TILE = 0,
+    IO_PRIORITY_MIP_LEVEL,
+    IO_PRIORITY_MIP_TAIL,
+    NUM_IO_PRIORITIES
+};
+
+/// Throughput limits for a BandwidthLimiter.  A rate of zero is unlimited.
+struct BandwidthLimits
+{
+    /// Sustained read bandwidth in bytes per second.
+    double bytesPerSecond = 0.0;
+
+    /// Sustained read operations (IOPS) per second.
+    double opsPerSecond = 0.0;
+
+    /// The buckets hold this many seconds' worth of tokens, which bounds the size of a burst
+    /// after an idle period.
+    double burstSeconds = 0.1;
+};
+
+/// BandwidthLimiter is a token bucket for bytes and operations, shared by all the readers that
+/// draw on one storage device.  A read acquires its bytes and one operation before it is issued,
+/// blocking until the buckets have refilled, so no work is wasted on reads that overrun a budget.
+///
+/// Waiting reads are granted in priority order.  Within a priority class, clients (e.g. textures)
+/// are served by start-time fair queuing on bytes, so a texture issuing many large reads cannot
+/// starve the others.  A read larger than a bucket is granted once the bucket is full, leaving it
+/// in debt.
+class BandwidthLimiter
+{
+  public:
+    /// Time source for the limiter, which tests replace with a fake clock.
+    class Clock
+    {
+      public:
+        virtual ~Clock() = default;
+
+        /// Current time in seconds.
+        virtual double now() const = 0;
+
+        /// Wait on the given condition variable for up to the given number of seconds.
+        virtual void waitFor( std::condition_variable& cond, std::unique_lock<std::mutex>& lock, double seconds ) = 0;
+    };
+
+    /// Construct a limiter with the given limits, which starts with full buckets.  The default
+    /// clock is std::chrono::steady_clock.
+    explicit BandwidthLimiter( const BandwidthLimits& limits = BandwidthLimits(), std::shared_ptr<Clock> clock = nullptr );
+
+    /// Change the limits.  The buckets are clamped to their new capacity.
+    void setLimits( const BandwidthLimits& limits );
+
+    /// Get the current limits.
+    BandwidthLimits getLimits() const;
+
+    /// Block until the given number of bytes and one operation are available to the given client.
+    void acquire( const void* client, IOPriority priority, size_t numBytes );
+
+    /// Draw the given number of bytes from the bucket without blocking, or return them if the number
+    /// is negative.  Used to correct an acquired estimate once the size of a read is known.  The
+    /// bucket may go into debt, which delays later reads.
+    void charge( long long numBytes );
+
+    /// Returns the total number of bytes granted.
+    unsigned long long getNumBytesGranted() const;
+
+    /// Returns the total number of operations granted.
+    unsigned long long getNumOpsGranted() const;
+
+    /// Returns the total time in seconds that reads spent waiting.
+    double getTotalWaitTime() const;
+
+    /// Returns the number of reads currently waiting.
+    unsigned int getNumWaiting() const;
+
+    /// Get the limiter shared by files on the same storage device as the given path (the device ID
+    /// on POSIX systems, the drive on Windows), creating an unlimited limiter for a new device.
+    static std::shared_ptr<BandwidthLimiter> getDeviceLimiter( const std::string& path );
+
+  private:
+    struct Request
+    {
+        const void*        client;
+        size_t             numBytes;
+        double             startTag;
+        unsigned long long sequence;
+        bool               granted;
+    };
+
+    // A priority class, with the waiting requests ordered by start tag, and the finish tag of the
+    // last request of each client.
+    struct PriorityClass
+    {
+        std::map<std::pair<double, unsigned long long>, Request*> waiting;
+        std::map<const void*, double>                             lastFinish;
+        double                                                    virtualTime = 0.0;
+    };
+
+    std::shared_ptr<Clock>  m_clock;
+    mutable std::mutex      m_mutex;
+    std::condition_variable m_cond;
+    BandwidthLimits         m_limits;
+    double                  m_byteTokens;
+    double                  m_opTokens;
+    double                  m_lastRefill;
+    PriorityClass           m_classes[NUM_IO_PRIORITIES];
+    unsigned long long      m_nextSequence    = 0;
+    unsigned int            m_numWaiting      = 0;
+    unsigned long long      m_numBytesGranted = 0;
+    unsigned long long      m_numOpsGranted   = 0;
+    double                  m_totalWaitTime   = 0.0;
+
+    void   refill( double now );
+    bool   grantRequests();
+    double getTimeUntilNextGrant() const;
+};
+
+}  // namespace imageSource
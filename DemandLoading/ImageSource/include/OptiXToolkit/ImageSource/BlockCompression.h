@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file BlockCompression.h
+/// CPU encoders and decoders for block-compressed (BCn) texture formats.
+
+#include <cuda.h>
+#include <vector_types.h>
+
+namespace imageSource {
+
+/// Returns true if compressBlock supports the given format: BC1, BC4, BC5, BC6H (unsigned) and
+/// BC7.  The sRGB variants are encoded like their linear counterparts; the texels are assumed to
+/// be in the stored color space.
+bool canCompressBlocks( CUarray_format format );
+
+/// Compress a 4x4 block of texels, given in row-major order, into the given block-compressed
+/// format.  Texel values should be in [0,1], except for BC6H, which accepts non-negative floats.
+/// BC4 uses the red channel and BC5 the red and green channels.  The destination must hold
+/// getBytesPerBlock(format) bytes.
+///
+/// The encoders favor speed over quality: BC1, BC4 and BC5 fit endpoints along the principal axis
+/// of the block, BC6H uses mode 11 (single region, 10-bit endpoints), and BC7 uses mode 6 (single
+/// subset RGBA, 7-bit endpoints with p-bits).  The search for the nearest palette entries uses AVX
+/// instructions when the processor supports them, which does not change the encoded blocks.
+void compressBlock( CUarray_format format, const float4 texels[16], void* dest );
+
+/// Compress an image of the given dimensions, stored as rows of RGBA texels, writing rows of
+/// blocks to dest.  Partial blocks at the edges are padded by replicating the last row and column.
+void compressImage( CUarray_format format, const float4* texels, unsigned int width, unsigned int height, void* dest );
+
+/// Decompress a block into 16 texels in row-major order.  Handles every BC1, BC4 and BC5 block,
+/// but only the BC6H and BC7 modes produced by compressBlock.  Returns false if the format or
+/// mode is not supported.
+bool decompressBlock( CUarray_format format, const void* block, float4 texels[16] );
+
+}  // namespace imageSource
@@ -0,0 +1,148 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file BlockImageReader.h
+/// Base class for readers of GPU-ready image files (DDS, KTX2) that store each mip level as a
+/// contiguous array of texels or compressed blocks.
+
+#include <OptiXToolkit/ImageSource/ImageSource.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace imageSource {
+
+class RandomAccessFile;
+struct FileRead;
+
+/// BlockImageReader streams tiles of GPU-ready image files without decoding them.  Each mip level
+/// is stored in the file as rows of texels (or rows of 4x4 blocks for BC formats), so a tile is
+/// read by a positional read of each of its block rows, and a mip level or mip tail by a single
+/// read.  Reads do not share a file position, so tiles can be read concurrently.  The rows of a
+/// tile are fetched with vectored reads, and readTileAsync queues them on a pool of I/O threads.
+///
+/// Levels that are supercompressed as a whole (zstd in KTX2) cannot be read a tile at a time.
+/// Such a level is read and decompressed when it is first accessed, and the decompressed level is
+/// kept in memory until the image is closed, so later tiles of that level are copied from memory.
+///
+/// Derived classes parse the file header, which is small, so opening an image is fast.
+class BlockImageReader : public ImageSourceBase
+{
+  public:
+    /// The constructor copies the given filename.  The file is not opened until open() is called.
+    explicit BlockImageReader( const std::string& filename );
+
+    /// Destructor
+    ~BlockImageReader() override;
+
+    /// Open the image and read header info, including dimensions and format.  Throws an exception on error.
+    void open( TextureInfo* info ) override;
+
+    /// Close the image.
+    void close() override;
+
+    /// Check if image is currently open.
+    bool isOpen() const override;
+
+    /// Get the image info.  Valid only after calling open().
+    const TextureInfo& getInfo() const override { return m_info; }
+
+    /// Return the mode in which the image fills part of itself
+    CUmemorytype getFillType() const override { return CU_MEMORYTYPE_HOST; }
+
+    /// Read the specified tile, returning the data in dest.  For block-compressed images the
+    /// destination holds rows of blocks.  Parts of the tile outside the bounds of the mip level are
+    /// filled with zeros.  Throws an exception on error.
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Queue the reads of the specified tile on the process-wide pool of I/O threads.
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Read the specified mip level.  Throws an exception on error.
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override;
+
+    /// Read the levels of the mip tail, which are packed consecutively.  The given pixel size is
+    /// ignored for block-compressed images in favor of the size of the blocks.  Levels that are
+    /// contiguous in the file are read with a single read.
+    bool readMipTail( char*        dest,
+                      unsigned int mipTailFirstLevel,
+                      unsigned int numMipLevels,
+                      const uint2* mipLevelDims,
+                      unsigned int pixelSizeInBytes,
+                      CUstream     stream ) override;
+
+    /// Read the base color of the image from its coarsest mip level.  Returns false if the image
+    /// has a partial mip chain or a block mode that cannot be decoded on the host.
+    bool readBaseColor( float4& dest ) override;
+
+    /// Returns the number of tiles that have been read.
+    unsigned long long getNumTilesRead() const override;
+
+    /// Returns the number of bytes that have been read.
+    unsigned long long getNumBytesRead() const override;
+
+    /// Returns the time in seconds spent reading image tiles.
+    double getTotalReadTime() const override;
+
+    /// Returns the filename given to the constructor.
+    std::string getFilename() const override { return m_filename; }
+
+    /// Returns true if the color channels of the image are sRGB-encoded.  Block-compressed sRGB
+    /// images have sRGB formats, which the texture unit decodes; textures of uncompressed sRGB
+    /// images should be created with the CU_TRSF_SRGB flag.  Valid only after calling open().
+    bool isSRGB() const { return m_isSRGB; }
+
+  protected:
+    /// Parse the file header, filling in the texture info and the byte offset of each mip level
+    /// (finest first).  Throws an exception if the file is invalid or unsupported.
+    virtual void readHeader( const RandomAccessFile& file, TextureInfo& info, std::vector<unsigned long long>& levelOffsets ) = 0;
+
+    /// Record whether the color channels are sRGB-encoded, while reading the header.
+    void setSRGB( bool isSRGB ) { m_isSRGB = isSRGB; }
+
+    /// Record the size in the file of each supercompressed mip level (finest first), while reading
+    /// the header.  Each level is decompressed by decompressLevel when it is first read.
+    void setCompressedLevelSizes( std::vector<unsigned long long> sizes ) { m_compressedLevelSizes = std::move( sizes ); }
+
+    /// Decompress a supercompressed mip level into dest, which holds destSize bytes.  Throws an
+    /// exception on error.  The default implementation throws, since images without
+    /// supercompressed levels never call it.
+    virtual void decompressLevel( const char* src, size_t srcSize, char* dest, size_t destSize ) const;
+
+    /// Throw an exception with the given message, prefixed with the filename.
+    [[noreturn]] void throwError( const std::string& message ) const;
+
+  private:
+    std::string                       m_filename;
+    std::shared_ptr<RandomAccessFile> m_file;
+    TextureInfo                       m_info{};
+    std::vector<unsigned long long>   m_levelOffsets;
+    std::vector<unsigned long long>   m_compressedLevelSizes;  // empty unless levels are supercompressed
+    bool                              m_isSRGB = false;
+    std::mutex                        m_initMutex;
+
+    // Decompressed levels of a supercompressed image, decoded on first use.
+    std::vector<std::shared_ptr<const std::vector<char>>> m_decompressedLevels;
+    std::mutex                                            m_levelMutex;
+
+    // Read statistics, which are shared with asynchronous reads that may outlive the reader.
+    struct ReadStats;
+    std::shared_ptr<ReadStats> m_stats;
+
+    unsigned int getLevelWidth( unsigned int mipLevel ) const;
+    unsigned int getLevelHeight( unsigned int mipLevel ) const;
+    size_t       getLevelSize( unsigned int mipLevel ) const;
+    void         readBytes( void* dest, size_t numBytes, unsigned long long offset ) const;
+    bool         getTileReads( char* dest, unsigned int mipLevel, const Tile& tile, std::vector<FileRead>& reads, size_t& numBytes ) const;
+    bool         isSupercompressed() const { return !m_compressedLevelSizes.empty(); }
+    std::shared_ptr<const std::vector<char>> getDecompressedLevel( unsigned int mipLevel );
+    void         readLevelBytes( void* dest, unsigned int mipLevel, size_t numBytes, size_t offsetInLevel );
+};
+
+}  // namespace imageSource
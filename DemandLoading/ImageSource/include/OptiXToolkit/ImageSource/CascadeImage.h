@@ -74,6 +74,12 @@ class CascadeImage : public ImageSourceBase
     // Return whether the image has a cascade
     bool hasCascade() const override { return m_info.width < m_backingImage->getInfo().width; }
 
+    // Return the filename of the backing image
+    std::string getFilename() const override { return m_backingImage ? m_backingImage->getFilename() : std::string(); }
+
+    // Return the file variant of the backing image
+    std::string getFileVariant() const override { return m_backingImage ? m_backingImage->getFileVariant() : std::string(); }
+
   private:
     std::shared_ptr<ImageSource> m_backingImage;
     unsigned int                 m_backingMipLevel;
@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file CompressingImageSource.h
+/// Adapts an uncompressed ImageSource to a block-compressed format.
+
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+#include <OptiXToolkit/ImageSource/WrappedImageSource.h>
+
+#include <memory>
+
+namespace imageSource {
+
+/// Choose a block-compressed format for an image with the given info: BC4 or BC5 for one and two
+/// channel images, BC6H for half and float images, and BC7 otherwise.  Block-compressed images
+/// keep their format.
+CUarray_format chooseBlockCompressedFormat( const TextureInfo& info );
+
+/// CompressingImageSource adapts an ImageSource to a block-compressed format, encoding tiles and
+/// mip levels as they are read.  Since a block-compressed tile covers 2-8x as many texels as an
+/// uncompressed one, this multiplies the effective size of the demand-loaded texture cache.
+///
+/// Encoding is done on the calling thread, which is typically a demand loader fill thread.  The
+/// wrapped ImageSource must fill host memory.  Images that are already block compressed (e.g. DDS
+/// files) are passed through unchanged.
+class CompressingImageSource : public WrappedImageSource
+{
+  public:
+    /// Adapt the given ImageSource to the given block-compressed format, which must satisfy
+    /// canCompressBlocks().  Channels of the wrapped image are converted to floats, normalizing
+    /// integer formats to [0,1].
+    CompressingImageSource( std::shared_ptr<ImageSource> imageSource, CUarray_format compressedFormat );
+
+    /// Open the wrapped image, returning the info of the compressed image.
+    void open( TextureInfo* info ) override;
+
+    /// Get the info of the compressed image.
+    const TextureInfo& getInfo() const override;
+
+    /// The compressed data is always produced in host memory.
+    CUmemorytype getFillType() const override { return CU_MEMORYTYPE_HOST; }
+
+    /// Read the specified tile from the wrapped image and compress it.  The destination holds rows of
+    /// blocks, with the tile width rounded up to whole blocks.
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Start reading the specified tile from the wrapped image.  Tiles that need compressing are
+    /// read and compressed synchronously.
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Read the specified mip level from the wrapped image and compress it.
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override;
+
+    /// Bands of rows are not compressed, so partial mip levels can't be read.
+    bool readScanlines( char* /*dest*/, unsigned int /*mipLevel*/, unsigned int /*firstRow*/, unsigned int /*numRows*/, CUstream /*stream*/ ) override
+    {
+        return false;
+    }
+
+    /// Bands of rows are not compressed, so partial mip levels can't be read.
+    unsigned int getScanlineChunkHeight() const override { return 0; }
+
+    /// Read and compress the levels of the mip tail, which are packed consecutively.  The given
+    /// pixel size is ignored in favor of the size of the compressed blocks.
+    bool readMipTail( char*        dest,
+                      unsigned int mipTailFirstLevel,
+                      unsigned int numMipLevels,
+                      const uint2* mipLevelDims,
+                      unsigned int pixelSizeInBytes,
+                      CUstream     stream ) override;
+
+    /// Returns false if the wrapped image is already compressed.
+    bool isCompressing() const { return m_isCompressing; }
+
+  private:
+    // Compress an image of the given dimensions, read from the wrapped image in its own format.
+    void compress( const char* src, unsigned int width, unsigned int height, char* dest ) const;
+
+    CUarray_format m_compressedFormat;
+    TextureInfo    m_info{};
+    TextureInfo    m_sourceInfo{};
+    bool           m_isCompressing = false;
+};
+
+}  // namespace imageSource
@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file ConvertingImageSource.h
+/// Adapts an ImageSource to a requested channel format and layout.
+
+#include <OptiXToolkit/ImageSource/FormatConversion.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+#include <OptiXToolkit/ImageSource/WrappedImageSource.h>
+
+#include <memory>
+
+namespace imageSource {
+
+/// ConvertingImageSource converts the tiles and mip levels of an ImageSource to the given output
+/// format as they are read, e.g. to store float images as half or UNORM8 textures, which halves or
+/// quarters the memory used by each tile.
+///
+/// Conversion is done on the calling thread, immediately after the wrapped image decodes the
+/// data.  The wrapped ImageSource must fill host memory.  Images that are block compressed, or
+/// that already have the requested format, are passed through unchanged.
+class ConvertingImageSource : public WrappedImageSource
+{
+  public:
+    /// Adapt the given ImageSource to the given output format, which must satisfy isValidOutputFormat().
+    ConvertingImageSource( std::shared_ptr<ImageSource> imageSource, const OutputFormat& outputFormat );
+
+    /// Open the wrapped image, returning the info of the converted image.
+    void open( TextureInfo* info ) override;
+
+    /// Get the info of the converted image.
+    const TextureInfo& getInfo() const override;
+
+    /// The converted data is always produced in host memory.
+    CUmemorytype getFillType() const override { return CU_MEMORYTYPE_HOST; }
+
+    /// Read the specified tile from the wrapped image and convert it.
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Start reading the specified tile from the wrapped image.  Tiles that need converting are
+    /// read and converted synchronously.
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Read the specified mip level from the wrapped image and convert it.
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override;
+
+    /// Read the given rows of the specified mip level from the wrapped image and convert them.
+    bool readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream ) override;
+
+    /// Read and convert the levels of the mip tail, which are packed consecutively.  The given pixel
+    /// size is ignored in favor of the size of the converted pixels.
+    bool readMipTail( char*        dest,
+                      unsigned int mipTailFirstLevel,
+                      unsigned int numMipLevels,
+                      const uint2* mipLevelDims,
+                      unsigned int pixelSizeInBytes,
+                      CUstream     stream ) override;
+
+    /// Read the base color of the wrapped image, rearranging its channels.
+    bool readBaseColor( float4& dest ) override;
+
+    /// Returns the variant of the wrapped image followed by the output format, channel swizzle and
+    /// transfer function, e.g. "unorm8:rgba:srgb".
+    std::string getFileVariant() const override;
+
+    /// Returns false if the wrapped image is passed through unchanged.
+    bool isConverting() const { return m_isConverting; }
+
+  private:
+    OutputFormat m_outputFormat;
+    TextureInfo  m_info{};
+    TextureInfo  m_sourceInfo{};
+    bool         m_isConverting = false;
+};
+
+}  // namespace imageSource
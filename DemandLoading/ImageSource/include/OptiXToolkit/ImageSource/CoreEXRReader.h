@@ -17,14 +17,39 @@ using exr_context_t = struct _priv_exr_context_t*;
 
 namespace imageSource {
 
+class RandomAccessFile;
+
+/// Selects the channels of a multi-layer (AOV) EXR file that CoreEXRReader loads as a texture.
+/// Channels are named by OpenEXR convention, "<layer>.<channel>" (e.g. "diffuse.R").
+struct EXRChannelSelection
+{
+    /// Name of the part to read from a multi-part file.  Empty selects the first part.
+    std::string part;
+
+    /// Layer of the selected channels, e.g. "diffuse".  Empty selects channels without a layer.
+    std::string layer;
+
+    /// Names of the selected channels within the layer, in texture channel order (at most four),
+    /// e.g. { "R", "G", "B" } or { "A" }.  Empty selects whichever of R, G, B and A are present,
+    /// in their usual slots, or Y (and A) for luminance images.
+    std::vector<std::string> channels;
+};
+
 /// OpenEXR Core image reader. Uses OpenEXR 3.0. This is preferred because
 /// it allows concurrent reading of tiles in the same EXR file.
+///
+/// Only the selected channels are decoded; other channels of each chunk are skipped.  For
+/// uncompressed files, the unselected channel data is not read from disk at all.
 class CoreEXRReader : public ImageSourceBase
 {
   public:
     /// The constructor copies the given filename.  The file is not opened until open() is called.
     explicit CoreEXRReader( const std::string& filename, bool readBaseColor = true );
 
+    /// Construct a reader for the given channels of a multi-layer or multi-part file.  Throws an
+    /// exception from open() if the part or a requested channel is missing.
+    CoreEXRReader( const std::string& filename, const EXRChannelSelection& selection, bool readBaseColor = true );
+
     /// Destructor
     ~CoreEXRReader() override;
 
@@ -54,6 +79,13 @@ class CoreEXRReader : public ImageSourceBase
     bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight,
                        CUstream stream ) override;
 
+    /// Read the given rows of a scanline image, decoding only the chunks that overlap them.  Returns
+    /// false for tiled images.  Throws an exception on error.
+    bool readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream ) override;
+
+    /// Returns the number of scanlines per chunk of a scanline image, or zero for tiled images.
+    unsigned int getScanlineChunkHeight() const override { return m_isScanline ? m_scanlinesPerChunk : 0; }
+
     /// Read the base color of the image (1x1 mip level) as an array of floats. Returns true on success.
     bool readBaseColor( float4& dest ) override;
 
@@ -72,21 +104,39 @@ class CoreEXRReader : public ImageSourceBase
     /// Returns the time in seconds spent reading image tiles.
     double getTotalReadTime() const override { return m_totalReadTime; }
 
+    /// Returns the filename given to the constructor.
+    std::string getFilename() const override { return m_filename; }
+
+    /// Returns a description of the channel selection, e.g. "part=beauty;layer=diffuse;channels=R,G,B",
+    /// or an empty string for the default selection.  Readers of different parts, layers or
+    /// channels of a file thereby have distinct identities in hash indices and tile caches.
+    std::string getFileVariant() const override;
+
   private:
-    std::string        m_filename;
-    exr_context_t      m_exrCtx = nullptr;
-    bool               m_isScanline = false;
-    TextureInfo        m_info{};
-    unsigned int       m_tileWidth{};
-    unsigned int       m_tileHeight{};
-    float4             m_baseColor{};
-    bool               m_readBaseColor    = false;
-    bool               m_baseColorWasRead = false;
-    std::mutex         m_initMutex;
-    std::mutex         m_statsMutex;
-    unsigned long long m_numTilesRead  = 0;
-    unsigned long long m_numBytesRead  = 0;
-    double             m_totalReadTime = 0.0;
+    // A selected channel of an uncompressed part, with the offset of its samples within each line of
+    // a chunk, in units of the chunk width.
+    struct ChunkChannel
+    {
+        unsigned int outputIndex;
+        unsigned int lineOffset;
+    };
+
+    std::string         m_filename;
+    EXRChannelSelection m_selection;
+    exr_context_t       m_exrCtx = nullptr;
+    bool                m_isScanline = false;
+    unsigned int        m_scanlinesPerChunk = 0;
+    TextureInfo         m_info{};
+    unsigned int        m_tileWidth{};
+    unsigned int        m_tileHeight{};
+    float4              m_baseColor{};
+    bool                m_readBaseColor    = false;
+    bool                m_baseColorWasRead = false;
+    std::mutex          m_initMutex;
+    std::mutex          m_statsMutex;
+    unsigned long long  m_numTilesRead  = 0;
+    unsigned long long  m_numBytesRead  = 0;
+    double              m_totalReadTime = 0.0;
 
     int m_tileWidths[20]{};
     int m_tileHeights[20]{};
@@ -97,9 +147,19 @@ class CoreEXRReader : public ImageSourceBase
     unsigned int m_roundMode;
     unsigned int m_levelMode;
 
-    // We are only supporting one-part files for now
-    static constexpr int m_partIndex = 0;
+    int                      m_partIndex = 0;
+    std::vector<std::string> m_channelNames;  // full name of each texture channel, empty if unfilled
+    bool                     m_hasUnfilledChannels = false;
+
+    // Uncompressed parts with unselected channels are read directly, skipping those channels.
+    std::shared_ptr<RandomAccessFile> m_file;
+    std::vector<ChunkChannel>         m_chunkChannels;
+    unsigned int                      m_fileBytesPerPixel = 0;
 
+    void selectPart();
+    void selectChannels();
+    int  getOutputChannel( const char* channelName ) const;
+    void readChunk( bool isTile, int mipLevel, int tileX, int tileY, char* dest, int rowPitch );
     void readActualTile( char* dest, int rowPitch, int mipLevel, int tileX, int tileY );
     void readScanlineData( char* dest );
 };
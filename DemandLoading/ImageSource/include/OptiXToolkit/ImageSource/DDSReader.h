@@ -0,0 +1,32 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file DDSReader.h
+/// Reader for DirectDraw Surface (DDS) images.
+
+#include <OptiXToolkit/ImageSource/BlockImageReader.h>
+
+#include <string>
+
+namespace imageSource {
+
+/// DDSReader streams tiles of 2D DDS images, including BC1-BC7 compressed images, directly from
+/// the file without decoding them.  Both legacy (FourCC) headers and DX10 extended headers are
+/// supported.  Cube maps, volumes, and texture arrays are not supported.
+class DDSReader : public BlockImageReader
+{
+  public:
+    /// The constructor copies the given filename.  The file is not opened until open() is called.
+    explicit DDSReader( const std::string& filename )
+        : BlockImageReader( filename )
+    {
+    }
+
+  protected:
+    void readHeader( const RandomAccessFile& file, TextureInfo& info, std::vector<unsigned long long>& levelOffsets ) override;
+};
+
+}  // namespace imageSource
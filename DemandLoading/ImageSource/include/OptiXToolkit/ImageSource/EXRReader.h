@@ -94,6 +94,9 @@ class EXRReader : public ImageSourceBase
         return m_totalReadTime;
     }
 
+    /// Returns the filename given to the constructor.
+    std::string getFilename() const override { return m_filename; }
+
     /// Serialize the image filename (etc.) to the give stream.
     void serialize( std::ostream& stream ) const;
 
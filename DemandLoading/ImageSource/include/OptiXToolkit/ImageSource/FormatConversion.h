@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file FormatConversion.h
+/// Host kernels that convert texels between channel formats and layouts.
+
+#include <cuda.h>
+#include <cuda_fp16.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace imageSource {
+
+/// The format of the texels produced by an image, requested from createImageSource.
+struct OutputFormat
+{
+    /// Channel format: CU_AD_FORMAT_UNSIGNED_INT8 (normalized), CU_AD_FORMAT_HALF or
+    /// CU_AD_FORMAT_FLOAT.
+    CUarray_format format = CU_AD_FORMAT_FLOAT;
+
+    /// Number of output channels (1, 2 or 4).  Zero keeps the number of channels of the image.
+    unsigned int numChannels = 0;
+
+    /// The source channel of each output channel.  Output channels whose source channel is
+    /// negative or missing are filled with zero, except the fourth (alpha), which is filled with one.
+    int channels[4] = { 0, 1, 2, 3 };
+
+    /// Encode UNORM8 color channels with the sRGB transfer function.  The fourth channel (alpha) is
+    /// always linear.  Textures of such images should be created with the CU_TRSF_SRGB flag.
+    bool srgb = false;
+};
+
+/// Returns true if the given output format is supported.
+bool isValidOutputFormat( const OutputFormat& format );
+
+/// Returns true if converting an image with the given format and number of channels to the
+/// given output format changes its texels.
+bool isConversionNeeded( CUarray_format format, unsigned int numChannels, const OutputFormat& outputFormat );
+
+/// Returns the number of channels produced by converting an image with the given number of
+/// channels to the given output format.
+inline unsigned int getNumOutputChannels( unsigned int numChannels, const OutputFormat& outputFormat )
+{
+    return outputFormat.numChannels != 0 ? outputFormat.numChannels : numChannels;
+}
+
+/// Convert floats to half floats, rounding to nearest even.  Uses F16C instructions when the
+/// processor supports them.
+void convertFloatToHalf( const float* src, size_t count, half* dest );
+
+/// Convert half floats to floats.  Uses F16C instructions when the processor supports them.
+void convertHalfToFloat( const half* src, size_t count, float* dest );
+
+/// Convert pixels with the given number of float channels to UNORM8, clamping to [0,1] and
+/// rounding to nearest.  With srgb, the first three channels are sRGB encoded, to within one
+/// code of the exact transfer function.
+void convertFloatToUnorm8( const float* src, size_t numPixels, unsigned int numChannels, bool srgb, std::uint8_t* dest );
+
+/// Rearrange the channels of float pixels, as described by OutputFormat::channels.  The source
+/// and destination must not overlap.
+void swizzleChannels( const float* src, unsigned int srcChannels, size_t numPixels, const int channels[4], unsigned int destChannels, float* dest );
+
+/// Convert pixels in the given format (UNORM8, UNORM16, half or float channels) to the given output
+/// format.  Integer channels are normalized to [0,1].  The conversion is done in cache-sized
+/// chunks, without allocation.
+void convertPixels( const void*         src,
+                    CUarray_format      srcFormat,
+                    unsigned int        srcChannels,
+                    size_t              numPixels,
+                    const OutputFormat& outputFormat,
+                    void*               dest );
+
+}  // namespace imageSource
@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file ImageHash.h
+/// Content hashing of ImageSources, used to coalesce duplicate images.
+
+#include <OptiXToolkit/ImageSource/ImageSource.h>
+
+#include <cuda.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace imageSource {
+
+/// A 128-bit image hash (BLAKE2b with a 16 byte digest).  A zero hash indicates that the image
+/// could not be hashed.  Hashes identify image contents in persistent caches (see TileDiskCache),
+/// where a collision would silently substitute one texture for another, so a cryptographic hash is
+/// used rather than a non-cryptographic one such as xxHash3-128.  BLAKE2b is self-contained
+/// (checked against the RFC 7693 reference digests), adds no third-party dependency, and hashing
+/// is parallelized over blocks, so it is not the bottleneck compared to decoding the image.
+struct ImageHash
+{
+    unsigned long long lo;
+    unsigned long long hi;
+
+    /// Return true if the hash is valid (non-zero).
+    bool isValid() const { return lo != 0 || hi != 0; }
+
+    /// Fold the hash to 64 bits.
+    unsigned long long fold() const { return lo ^ hi; }
+};
+
+inline bool operator==( const ImageHash& lhs, const ImageHash& rhs )
+{
+    return lhs.lo == rhs.lo && lhs.hi == rhs.hi;
+}
+
+inline bool operator!=( const ImageHash& lhs, const ImageHash& rhs )
+{
+    return !( lhs == rhs );
+}
+
+inline bool operator<( const ImageHash& lhs, const ImageHash& rhs )
+{
+    return lhs.hi < rhs.hi || ( lhs.hi == rhs.hi && lhs.lo < rhs.lo );
+}
+
+/// The maxLevelSize used by ImageSource::getHash, which hashes only the coarse mip levels.
+const unsigned int COARSE_HASH_LEVEL_SIZE = 128;
+
+/// Options controlling which parts of an image are hashed.
+struct ImageHashOptions
+{
+    unsigned int firstMipLevel = 0;          ///< finest mip level to hash
+    unsigned int numMipLevels  = ~0u;        ///< number of mip levels to hash (clamped to the available levels)
+    unsigned int maxLevelSize  = 0;          ///< skip finer levels whose width plus height exceeds this (0 means no limit)
+    unsigned int numThreads    = 0;          ///< threads used to hash each level (0 means std::thread::hardware_concurrency)
+    size_t       maxReadSize   = 64 << 20;   ///< read larger levels in bands of about this many bytes, if possible (0 means whole levels)
+};
+
+/// Compute a hash of the image header (dimensions, format, channel count and number of mip
+/// levels) and the pixels of the selected mip levels.  The coarsest selected level is hashed even
+/// if it exceeds maxLevelSize.  Each level is hashed as a tree of fixed-size blocks, so the result
+/// does not depend on the number of threads or on how the level is read.  Levels larger than
+/// maxReadSize are read in bands, via readScanlines or one row of native tiles at a time, when the
+/// image supports it; other levels are read whole via readMipLevel.  Device-filled images are read
+/// into a temporary device buffer and copied to the host; the CUDA context associated with the
+/// stream must be current.  Returns a zero hash for fill types that cannot be hashed.  Throws an
+/// exception on error.
+ImageHash computeImageHash( ImageSource& image, const ImageHashOptions& options = ImageHashOptions(), CUstream stream = 0 );
+
+/// ImageHashIndex is a small persistent index of image hashes, keyed by file path and variant (see
+/// ImageSource::getFileVariant) and validated by the file's modification time and size, so that
+/// hashes of unchanged files need not be recomputed from one run to the next.  Images without a
+/// filename are always hashed.  All methods are threadsafe.
+class ImageHashIndex
+{
+  public:
+    /// Construct an index backed by the given file, loading any existing entries.  An empty
+    /// filename makes an index that is not persisted.
+    explicit ImageHashIndex( const std::string& indexFilename, const ImageHashOptions& options = ImageHashOptions() );
+
+    /// Save the index if it has been modified.
+    ~ImageHashIndex();
+
+    /// Return the hash of the given image, looking it up by filename if possible.  Otherwise the
+    /// hash is computed and recorded in the index.
+    ImageHash getHash( ImageSource& image, CUstream stream );
+
+    /// Look up the hash for the given variant of the given file, which is valid only if the file has
+    /// not been modified since the hash was recorded.  Returns true on success.
+    bool find( const std::string& path, const TextureInfo& info, ImageHash& hash, const std::string& variant = std::string() ) const;
+
+    /// Record the hash of the given variant of the given file.
+    void insert( const std::string& path, const TextureInfo& info, const ImageHash& hash, const std::string& variant = std::string() );
+
+    /// Write the index to its file, replacing the previous contents atomically.  Returns true on
+    /// success.
+    bool save();
+
+    /// Return the number of entries in the index.
+    size_t size() const;
+
+  private:
+    struct Entry
+    {
+        long long          modificationTime;
+        long long          fileSize;
+        unsigned long long infoKey;
+        ImageHash          hash;
+    };
+
+    void load();
+
+    std::string                  m_indexFilename;
+    ImageHashOptions             m_options;
+    mutable std::mutex           m_mutex;
+    std::map<std::string, Entry> m_entries;
+    bool                         m_modified = false;
+};
+
+}  // namespace imageSource
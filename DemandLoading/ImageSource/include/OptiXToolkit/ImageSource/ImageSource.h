@@ -11,11 +11,13 @@
 #include <vector_types.h>
 
 #include <cmath>
+#include <future>
 #include <memory>
 #include <string>
 
 namespace imageSource {
 
+struct OutputFormat;
 struct TextureInfo;
 
 struct PixelPosition
@@ -70,10 +72,33 @@ class ImageSource
     /// Returns true if the request was satisfied and data was copied into dest.
     virtual bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) = 0;
 
+    /// Start reading the specified tile, returning a future that holds the result of readTile (or
+    /// the exception it threw).  dest must remain valid, and the image open, until the future is
+    /// ready.  Readers with an asynchronous I/O backend keep many tile reads in flight, so a caller
+    /// can issue a batch of reads and then wait for them, overlapping I/O with other work.  Wrapped
+    /// images may return a deferred future, so wait for the result with get() or wait() rather
+    /// than polling it with wait_for().  The default implementation calls readTile synchronously.
+    virtual std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream );
+
     /// Read the specified mipLevel. Throws an exception on error.
     /// Returns true if the request was satisfied and data was copied into dest.
     virtual bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) = 0;
 
+    /// Read the given rows of the specified mip level into dest, which holds numRows packed rows of
+    /// the full level width.  Rows past the bottom of the level are not written.  Readers that
+    /// decode scanline images in chunks implement this so that large images can be streamed in
+    /// bands rather than loaded a level at a time.  Throws an exception on error.
+    /// Returns false if the image can't read partial mip levels (the default).
+    virtual bool readScanlines( char* /*dest*/, unsigned int /*mipLevel*/, unsigned int /*firstRow*/, unsigned int /*numRows*/, CUstream /*stream*/ )
+    {
+        return false;
+    }
+
+    /// Returns the number of scanlines that readScanlines decodes together, or zero if the image
+    /// can't read partial mip levels (the default).  Reading whole chunks avoids decoding the same
+    /// chunk more than once.
+    virtual unsigned int getScanlineChunkHeight() const { return 0; }
+
     /// Read the mip tail into the given buffer, starting with the specified level.  An array
     /// containing the expected dimensions of all the miplevels is provided (starting from miplevel
     /// zero), along with the pixel size.
@@ -109,7 +134,19 @@ class ImageSource
     /// Return true if the image has a cascade (larger size) that could be switched to.
     virtual bool hasCascade() const = 0;
 
-    /// Return a hash of the image, using a small mip level.
+    /// Return the path of the file from which the image is read, or an empty string if the image
+    /// is not backed by a file (e.g. procedural images).
+    virtual std::string getFilename() const { return std::string(); }
+
+    /// Return a description of how the image's texels differ from the file's default contents (e.g.
+    /// a format conversion or a selection of channels), or an empty string if they don't.  Images of
+    /// the same file with different variants have different contents, so caches keyed by filename
+    /// must also be keyed by the variant.
+    virtual std::string getFileVariant() const { return std::string(); }
+
+    /// Return a 64-bit hash of the image header and its coarse mip levels (those whose width plus
+    /// height is at most COARSE_HASH_LEVEL_SIZE, or else the coarsest level), which is cheap enough
+    /// to compute for every image.  Use computeImageHash to hash every mip level.
     unsigned long long getHash( CUstream stream );
 };
 
@@ -148,4 +185,8 @@ inline unsigned int calculateNumMipLevels( unsigned int width, unsigned int heig
 
 std::shared_ptr<ImageSource> createImageSource( const std::string& filename, const std::string& directory = "" );
 
+/// Create an ImageSource for the given file that converts its texels to the given output format
+/// as they are read.  See ConvertingImageSource.
+std::shared_ptr<ImageSource> createImageSource( const std::string& filename, const OutputFormat& outputFormat, const std::string& directory = "" );
+
 }  // namespace imageSource
@@ -10,23 +10,40 @@
 #include <OptiXToolkit/ImageSource/ImageSource.h>
 #include <OptiXToolkit/ImageSource/ImageSourceCacheStatistics.h>
 
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
 namespace imageSource {
 
-/// Cache for ImageSource instances.
+class OpenImageLimiter;
+
+/// Cache for ImageSource instances.  All methods are threadsafe.
+///
+/// Images created by the cache are opened lazily and may be limited in number: when more than the
+/// given number of images are open, the least recently used images are closed.  Closed images are
+/// transparently reopened when they are read again.  Images with reads in flight are never closed.
+/// Images created by the cache may also be throttled, drawing their reads from the BandwidthLimiter
+/// of the device holding the file (see ThrottledImageSource).  Images supplied via set() are not
+/// managed.
 class ImageSourceCache
 {
   public:
+    /// Function used to create an ImageSource for a path.  The ImageSource should not be opened.
+    using Factory = std::function<std::shared_ptr<ImageSource>( const std::string& path )>;
+
+    /// Construct a cache that keeps at most maxOpenImages of the images it creates open at once
+    /// (0 means unlimited).  Images are created with createImageSource unless a factory is given.
+    /// If throttleReads is true, reads of images created by the cache are throttled.
+    explicit ImageSourceCache( unsigned int maxOpenImages = 0, Factory factory = Factory(), bool throttleReads = false );
+
+    ~ImageSourceCache();
+
     /// Returns the image source from the cache associated with the given path.
     /// If no such image source exists, returns an empty shared_ptr.
-    std::shared_ptr<ImageSource> find( const std::string& path ) const
-    {
-        auto it = m_cache.find( path );
-        return it == m_cache.end() ? std::shared_ptr<ImageSource>() : it->second;
-    }
+    std::shared_ptr<ImageSource> find( const std::string& path ) const;
 
     /// Get the specified ImageSource.  Returns a cached ImageSource if possible; otherwise a new
     /// instance is created.  The type of the ImageSource is determined by the filename extension.
@@ -37,13 +54,30 @@ class ImageSourceCache
     /// to insert their own ImageSources into the cache without relying on createImageSource to create
     /// the image from the associated filename.  For instance, this allows tiled or mipmap adapted
     /// images to be inserted into the cache.
-    void set( const std::string& path, const std::shared_ptr<ImageSource>& image ) { m_cache[path] = image; }
+    void set( const std::string& path, const std::shared_ptr<ImageSource>& image );
+
+    /// Return the number of images created by the cache that are currently open.
+    unsigned int getNumOpenImages() const;
 
     /// Return aggregate statistics for all ImageSources in the cache
     CacheStatistics getStatistics() const;
 
 private:
-    std::map<std::string, std::shared_ptr<ImageSource>> m_cache;
+    static const unsigned int NUM_SHARDS = 16;
+
+    struct Shard
+    {
+        mutable std::mutex                                  mutex;
+        std::map<std::string, std::shared_ptr<ImageSource>> images;
+    };
+
+    Shard&       getShard( const std::string& path );
+    const Shard& getShard( const std::string& path ) const;
+
+    Factory                           m_factory;
+    std::shared_ptr<OpenImageLimiter> m_limiter;
+    bool                              m_throttleReads;
+    Shard                             m_shards[NUM_SHARDS];
 };
 
 }  // namespace imageSource
@@ -12,6 +12,10 @@ struct CacheStatistics
     unsigned long long totalTilesRead;
     unsigned long long totalBytesRead;
     double             totalReadTime;
+    unsigned long long numOpens;         // number of times an image created by the cache was opened
+    unsigned long long numCloses;        // number of times an open image was closed to stay under the limit
+    unsigned long long numHandleHits;    // number of reads from images that were already open
+    unsigned long long numHandleMisses;  // number of reads that had to reopen their image
 };
 
 }  // namespace imageSource
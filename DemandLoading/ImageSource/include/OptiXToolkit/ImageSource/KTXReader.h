@@ -0,0 +1,36 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file KTXReader.h
+/// Reader for Khronos KTX2 images.
+
+#include <OptiXToolkit/ImageSource/BlockImageReader.h>
+
+#include <string>
+
+namespace imageSource {
+
+/// KTXReader streams tiles of 2D KTX2 images, including BC1-BC7 compressed images, directly from
+/// the file without decoding them.  The level index in the header gives the location of each mip
+/// level.  Zstd supercompressed images are supported when the library is built with OTK_USE_ZSTD;
+/// each of their levels is decompressed as a whole when it is first read and then kept in memory,
+/// so they use more host memory than uncompressed images.  Basis and zlib supercompression, cube
+/// maps, volumes, and texture arrays are not supported.
+class KTXReader : public BlockImageReader
+{
+  public:
+    /// The constructor copies the given filename.  The file is not opened until open() is called.
+    explicit KTXReader( const std::string& filename )
+        : BlockImageReader( filename )
+    {
+    }
+
+  protected:
+    void readHeader( const RandomAccessFile& file, TextureInfo& info, std::vector<unsigned long long>& levelOffsets ) override;
+    void decompressLevel( const char* src, size_t srcSize, char* dest, size_t destSize ) const override;
+};
+
+}  // namespace imageSource
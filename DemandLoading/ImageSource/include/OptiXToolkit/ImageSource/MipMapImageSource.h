@@ -26,6 +26,8 @@ class MipMapImageSource : public WrappedImageSource
 
     bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
 
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
     bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override;
 
     bool readMipTail( char*        dest,
@@ -35,6 +37,15 @@ class MipMapImageSource : public WrappedImageSource
                       unsigned int pixelSizeInBytes,
                       CUstream     stream ) override;
 
+    /// Partial mip levels can't be read, since the coarser levels are built from whole levels.
+    bool readScanlines( char* /*dest*/, unsigned int /*mipLevel*/, unsigned int /*firstRow*/, unsigned int /*numRows*/, CUstream /*stream*/ ) override
+    {
+        return false;
+    }
+
+    /// Partial mip levels can't be read, since the coarser levels are built from whole levels.
+    unsigned int getScanlineChunkHeight() const override { return 0; }
+
     unsigned long long getNumTilesRead() const override;
 
   private:
@@ -7,6 +7,8 @@
 #include <OptiXToolkit/ImageSource/ImageSource.h>
 #include <OptiXToolkit/ImageSource/TextureInfo.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -17,6 +19,11 @@
 namespace imageSource {
 
 /// OIIO image reader.
+///
+/// An OIIO ImageInput decodes one tile at a time, so the reader keeps a small pool of ImageInputs
+/// for each image, opening another when all are busy.  Concurrent reads of the same image then
+/// decode in parallel.  The number of ImageInputs is bounded per image and across all readers;
+/// when the bound is reached, reads wait for an ImageInput to become idle.
 class OIIOReader : public ImageSourceBase
 {
   public:
@@ -30,6 +37,11 @@ class OIIOReader : public ImageSourceBase
     /// Destructor
     ~OIIOReader() override { close(); }
 
+    /// Set the maximum number of ImageInputs opened for each image (default 8), and the maximum
+    /// opened by all readers (default 64).  Each open image may always use one ImageInput, which
+    /// doesn't count towards the total.
+    static void setInputLimits( unsigned int maxInputsPerImage, unsigned int maxTotalInputs );
+
     /// Open the image and read header info, including dimensions and format. Throws an exception on error.
     void open( TextureInfo* info ) override;
 
@@ -37,7 +49,7 @@ class OIIOReader : public ImageSourceBase
     void close() override;
 
     /// Check if image is currently open.
-    bool isOpen() const override { return static_cast<bool>( m_input ); }
+    bool isOpen() const override { return m_isOpen; }
 
     /// Get the image info.  Valid only after calling open().
     const TextureInfo& getInfo() const override { return m_info; }
@@ -68,47 +80,50 @@ class OIIOReader : public ImageSourceBase
     unsigned int getTileHeight() const override { return m_tileHeight; }
 
     /// Returns the number of tiles that have been read.
-    unsigned long long getNumTilesRead() const override
-    {
-        std::unique_lock<std::mutex> lock( m_statsMutex );
-        return m_numTilesRead;
-    };
+    unsigned long long getNumTilesRead() const override { return m_numTilesRead; }
 
     /// Returns the number of bytes that have been read.
-    unsigned long long getNumBytesRead() const override
-    {
-        std::unique_lock<std::mutex> lock( m_statsMutex );
-        return m_numBytesRead;
-    };
+    unsigned long long getNumBytesRead() const override { return m_numBytesRead; }
 
     /// Returns the time in seconds spent reading image tiles.
-    double getTotalReadTime() const override
-    {
-        std::unique_lock<std::mutex> lock( m_statsMutex );
-        return m_totalReadTime;
-    }
+    double getTotalReadTime() const override { return m_totalReadTime; }
+
+    /// Returns the number of ImageInputs currently open for the image.
+    unsigned int getNumInputs() const;
+
+    /// Returns the filename given to the constructor.
+    std::string getFilename() const override { return m_filename; }
 
   private:
-    void readActualTile( char* dest, unsigned int rowPitch, unsigned int mipLevel, unsigned int tileX, unsigned int tileY );
+    class InputLease;
+
+    void readActualTile( OIIO::ImageInput& input, char* dest, unsigned int rowPitch, unsigned int mipLevel, unsigned int tileX, unsigned int tileY );
+    std::unique_ptr<OIIO::ImageInput> acquireInput();
+    void                              releaseInput( std::unique_ptr<OIIO::ImageInput> input );
+    void                              recordRead( unsigned long long numTiles, unsigned long long numBytes, double time );
+
+    std::string       m_filename;
+    TextureInfo       m_info{};
+    unsigned int      m_depth{ 1 };
+    unsigned int      m_tileWidth{ 0 };
+    unsigned int      m_tileHeight{ 0 };
+    std::atomic<bool> m_isOpen{ false };
 
-    std::string                       m_filename;
-    std::unique_ptr<OIIO::ImageInput> m_input;
-    TextureInfo                       m_info{};
-    unsigned int                      m_depth{1};
-    unsigned int                      m_tileWidth{ 0 };
-    unsigned int                      m_tileHeight{0};
-    mutable std::mutex                m_mutex;
+    // Pool of ImageInputs.  Leased inputs are removed from the pool and returned when idle.
+    mutable std::mutex                             m_mutex;
+    std::condition_variable                        m_inputReturned;
+    std::vector<std::unique_ptr<OIIO::ImageInput>> m_idleInputs;
+    unsigned int                                   m_numInputs = 0;
 
-    std::vector<int> m_levelWidths, m_levelHeights;
+    std::vector<OIIO::ImageSpec> m_levelSpecs;
 
     float4 m_baseColor{};
     bool   m_readBaseColor    = false;
     bool   m_baseColorWasRead = false;
 
-    mutable std::mutex m_statsMutex;
-    unsigned long long m_numTilesRead  = 0;
-    unsigned long long m_numBytesRead  = 0;
-    double             m_totalReadTime = 0.0;
+    std::atomic<unsigned long long> m_numTilesRead{ 0 };
+    std::atomic<unsigned long long> m_numBytesRead{ 0 };
+    std::atomic<double>             m_totalReadTime{ 0.0 };
 };
 
 }  // namespace demandLoading
@@ -0,0 +1,189 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file ProceduralImage.h
+/// Host procedural textures described by a node graph and evaluated a block of texels at a time.
+
+#include <OptiXToolkit/ImageSource/ImageSource.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <vector>
+
+namespace imageSource {
+
+/// ProceduralGraph describes a scalar function of the texture coordinates (u,v) in [0,1]^2 as a
+/// graph of pattern and remap nodes.  Each method adds a node and returns its index, which later
+/// nodes use as an input, so nodes are always in evaluation order.
+///
+/// Patterns are box filtered over the footprint of the texel being evaluated, so that each mip level
+/// is an (approximate, for noise) average of the finer levels rather than an aliased point sample.
+/// Checkers and gradients are filtered exactly; noise octaves finer than a texel fade to their mean.
+class ProceduralGraph
+{
+  public:
+    typedef unsigned int Node;
+
+    /// A constant value.
+    Node constant( float value );
+
+    /// The linear gradient offset + du * u + dv * v.
+    Node gradient( float du, float dv, float offset = 0.f );
+
+    /// A checkerboard with the given number of squares along u and v, which is 1 in squares whose
+    /// row and column have different parities (like the odd squares of CheckerBoardImage), and 0
+    /// elsewhere.
+    Node checker( float squaresU, float squaresV );
+
+    /// Fractal value noise in [0,1] with the given base frequency (lattice cells along u and v) and
+    /// number of octaves, each of twice the frequency and half the amplitude of the previous one.
+    Node noise( float frequency, unsigned int octaves = 1, unsigned int seed = 0 );
+
+    /// a + b
+    Node add( Node a, Node b );
+
+    /// a * b
+    Node multiply( Node a, Node b );
+
+    /// a * (1 - t) + b * t
+    Node mix( Node a, Node b, Node t );
+
+    /// a * scale + offset
+    Node remap( Node a, float scale, float offset );
+
+    /// a clamped to [low, high].
+    Node clamp( Node a, float low, float high );
+
+    /// Hermite interpolation from 0 at edge0 to 1 at edge1.
+    Node smoothstep( Node a, float edge0, float edge1 );
+
+    /// @private
+    enum Op
+    {
+        CONSTANT,
+        GRADIENT,
+        CHECKER,
+        NOISE,
+        ADD,
+        MULTIPLY,
+        MIX,
+        REMAP,
+        CLAMP,
+        SMOOTHSTEP
+    };
+
+    /// @private
+    struct NodeDesc
+    {
+        Op           op;
+        Node         inputs[3];
+        float        params[3];
+        unsigned int octaves;
+        unsigned int seed;
+    };
+
+    /// @private
+    const std::vector<NodeDesc>& getNodes() const { return m_nodes; }
+
+  private:
+    Node addNode( Op op, Node a, Node b, Node c, float p0, float p1, float p2 );
+
+    std::vector<NodeDesc> m_nodes;
+};
+
+/// ProceduralImage evaluates a ProceduralGraph per channel on the threads that read its tiles.  The
+/// graph is compiled to a program of block instructions with dead nodes removed and scratch
+/// registers reused, and each instruction runs over a block of texels along a row, which the
+/// compiler vectorizes.  On x86-64 the block kernels are compiled for both SSE2 and AVX2, and the
+/// AVX2 kernels are used when the processor supports them; both produce the same texels.  Tiles are
+/// evaluated a column of blocks at a time, so patterns evaluate their dependence on u once per
+/// column.  Texels outside the mip level are black.
+class ProceduralImage : public ImageSourceBase
+{
+  public:
+    /// Create an image whose channels are the given graph nodes (1, 2 or 4 of them).  The format
+    /// is CU_AD_FORMAT_FLOAT or CU_AD_FORMAT_UNSIGNED_INT8 (normalized).
+    ProceduralImage( const ProceduralGraph&                   graph,
+                     const std::vector<ProceduralGraph::Node>& channels,
+                     unsigned int                              width,
+                     unsigned int                              height,
+                     CUarray_format                            format     = CU_AD_FORMAT_FLOAT,
+                     bool                                      useMipmaps = true );
+
+    /// The open method simply initializes the given image info struct.
+    void open( TextureInfo* info ) override;
+
+    /// The close operation is a no-op.
+    void close() override {}
+
+    /// Check if image is currently open.
+    bool isOpen() const override { return true; }
+
+    /// Get the image info.
+    const TextureInfo& getInfo() const override { return m_info; }
+
+    /// Return the mode in which the image fills part of itself
+    CUmemorytype getFillType() const override { return CU_MEMORYTYPE_HOST; }
+
+    /// Evaluate the specified tile.  Texels outside the bounds of the mip level are black.
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Evaluate the specified mip level.
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int width, unsigned int height, CUstream stream ) override;
+
+    /// Evaluate the average of the image, i.e. its 1x1 mip level.
+    bool readBaseColor( float4& dest ) override;
+
+    /// Returns the number of block instructions per texel block after compilation.
+    unsigned int getNumInstructions() const { return static_cast<unsigned int>( m_program.size() ); }
+
+    /// Enable or disable the AVX2 kernels for all procedural images (e.g. to compare them with the
+    /// SSE2 kernels).  They are enabled by default, and used only if the processor supports AVX2.
+    static void setUseAVX2( bool useAVX2 );
+
+  private:
+    struct Instruction
+    {
+        ProceduralGraph::NodeDesc node;
+        unsigned int              dest;
+        unsigned int              inputs[3];
+        unsigned int              cache;  // first block of the column cache of a pattern
+    };
+
+    void compile( const ProceduralGraph& graph, const std::vector<ProceduralGraph::Node>& channels );
+
+    // Returns the number of blocks of floats used to evaluate a block of texels.
+    unsigned int getWorkspaceBlocks() const;
+
+    // Evaluate a block of texels along a row of a level with the given dimensions, starting at (x,y),
+    // leaving the channels in their registers.  newColumn is true for the first block of a column,
+    // whose u dependence is cached in the workspace for the following blocks.  The kernels are
+    // those of the target instruction set.
+    template <class Kernels>
+    void evaluateBlock( unsigned int levelWidth,
+                        unsigned int levelHeight,
+                        unsigned int x,
+                        unsigned int y,
+                        bool         newColumn,
+                        float*       workspace ) const;
+
+    // Evaluate a rectangle of texels of a level with the given dimensions into dest, whose rows are
+    // rowPitch bytes apart, with the kernels of the processor.
+    void evaluate( char* dest, size_t rowPitch, unsigned int levelWidth, unsigned int levelHeight, unsigned int x0,
+                   unsigned int y0, unsigned int width, unsigned int height ) const;
+    template <class Kernels>
+    void evaluateRect( char* dest, size_t rowPitch, unsigned int levelWidth, unsigned int levelHeight, unsigned int x0,
+                       unsigned int y0, unsigned int width, unsigned int height ) const;
+    void evaluateAVX2( char* dest, size_t rowPitch, unsigned int levelWidth, unsigned int levelHeight, unsigned int x0,
+                       unsigned int y0, unsigned int width, unsigned int height ) const;
+
+    TextureInfo               m_info{};
+    std::vector<Instruction>  m_program;
+    std::vector<unsigned int> m_channelRegisters;
+    unsigned int              m_numRegisters   = 0;
+    unsigned int              m_numCacheBlocks = 0;
+};
+
+}  // namespace imageSource
@@ -40,10 +40,20 @@ class RateLimitedImageSource : public WrappedImageSource
     /// remaining, in which case nothing is done and false is returned.
     bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
 
+    /// Read the tile synchronously, since the time remaining is charged when the read finishes.
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override
+    {
+        return ImageSource::readTileAsync( dest, mipLevel, tile, stream );
+    }
+
     /// Delegate to the wrapped ImageSource and update the time remaining, unless there is no time
     /// remaining, in which case nothing is done and false is returned.
     bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override;
 
+    /// Delegate to the wrapped ImageSource and update the time remaining, unless there is no time
+    /// remaining, in which case nothing is done and false is returned.
+    bool readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream ) override;
+
     /// Delegate to the wrapped ImageSource and update the time remaining, unless there is no time
     /// remaining, in which case nothing is done and false is returned.
     bool readMipTail( char*        dest,
@@ -0,0 +1,178 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file SharedTileCache.h
+/// In-memory cache of decoded tiles, shared by the demand loaders of a process.
+
+#include <OptiXToolkit/ImageSource/WrappedImageSource.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace imageSource {
+
+/// SharedTileCache holds decoded tiles, mip levels and mip tails in host memory, so that the
+/// demand loaders of several devices decode each of them once and copy it to their own devices.
+///
+/// Concurrent requests for the same tile are coalesced: the first request decodes the tile, and
+/// the others wait for it and share the result.  Failed decodes are not cached, so the tile is
+/// decoded again by the next request.  When the cached tiles exceed the maximum size, the least
+/// recently used tiles are evicted.  Tiles larger than the maximum size are not cached.  Evicted
+/// tiles remain valid for requests that are still copying them.  All methods are threadsafe.
+class SharedTileCache
+{
+  public:
+    /// The kind of read that decoded a cached buffer.
+    enum ReadType
+    {
+        READ_TILE = 0,
+        READ_MIP_LEVEL,
+        READ_MIP_TAIL
+    };
+
+    /// Identifies a tile of an image.  For mip level reads, the tile covers the whole level.  For mip
+    /// tail reads, mipLevel is the first level of the tail and the tile width is the number of mip
+    /// levels.
+    struct Key
+    {
+        unsigned long long imageId;
+        unsigned int       mipLevel;
+        Tile               tile;
+        ReadType           type;
+    };
+
+    using TileBuffer = std::shared_ptr<const std::vector<char>>;
+
+    /// Decodes a tile into a zero-filled buffer, returning false if the tile could not be read.
+    using DecodeFunction = std::function<bool( char* dest )>;
+
+    /// Create a cache holding at most maxSize bytes of tiles.
+    explicit SharedTileCache( size_t maxSize );
+
+    /// Returns a new id that identifies the tiles of an image in the cache.
+    unsigned long long createImageId() { return ++m_lastImageId; }
+
+    /// Returns the tile with the given key, decoding it with the given function if it is neither
+    /// cached nor being decoded by another request.  Returns a null buffer if decoding failed.
+    /// Exceptions thrown by the decode function are rethrown to all waiting requests.
+    TileBuffer findOrDecode( const Key& key, size_t size, const DecodeFunction& decode );
+
+    /// Remove the cached tiles of the given image.
+    void removeImage( unsigned long long imageId );
+
+    /// Remove all cached tiles.
+    void clear();
+
+    /// Returns the maximum size of the cached tiles in bytes.
+    size_t getMaxSize() const { return m_maxSize; }
+
+    /// Returns the size of the cached tiles in bytes.
+    size_t getSize() const;
+
+    /// Returns the number of cached tiles.
+    size_t getNumTiles() const;
+
+    /// Returns the number of requests for cached tiles.
+    unsigned long long getNumHits() const;
+
+    /// Returns the number of requests that decoded a tile.
+    unsigned long long getNumMisses() const;
+
+    /// Returns the number of requests that waited for another request to decode a tile.
+    unsigned long long getNumCoalesced() const;
+
+    /// Returns the number of tiles evicted to stay within the maximum size.
+    unsigned long long getNumEvictions() const;
+
+  private:
+    struct KeyHash
+    {
+        size_t operator()( const Key& key ) const;
+    };
+    struct KeyEqual
+    {
+        bool operator()( const Key& lhs, const Key& rhs ) const;
+    };
+
+    struct Entry
+    {
+        TileBuffer               buffer;
+        std::list<Key>::iterator lruPosition;
+    };
+
+    using EntryMap   = std::unordered_map<Key, Entry, KeyHash, KeyEqual>;
+    using PendingMap = std::unordered_map<Key, std::shared_future<TileBuffer>, KeyHash, KeyEqual>;
+
+    void insert( const Key& key, const TileBuffer& buffer );
+
+    const size_t                    m_maxSize;
+    std::atomic<unsigned long long> m_lastImageId{ 0 };
+
+    mutable std::mutex m_mutex;
+    EntryMap           m_entries;
+    PendingMap         m_pending;  // tiles being decoded
+    std::list<Key>     m_lru;      // most recently used first
+    size_t             m_size         = 0;
+    unsigned long long m_numHits      = 0;
+    unsigned long long m_numMisses    = 0;
+    unsigned long long m_numCoalesced = 0;
+    unsigned long long m_numEvictions = 0;
+};
+
+/// SharedCachedImageSource reads the tiles, mip levels and mip tails of an ImageSource through a
+/// SharedTileCache.  Wrap an image once and give the wrapper to the demand loaders of all devices,
+/// so that each is decoded once for all of them, whether the loaders use sparse or dense textures.
+/// Images that fill device memory are passed through unchanged.  The cached data of the image is
+/// removed when the wrapper is destroyed.
+class SharedCachedImageSource : public WrappedImageSource
+{
+  public:
+    /// Read the tiles of the given image through the given cache.
+    SharedCachedImageSource( std::shared_ptr<ImageSource> imageSource, std::shared_ptr<SharedTileCache> cache );
+
+    /// Remove the cached tiles of the image.
+    ~SharedCachedImageSource() override;
+
+    /// Read the specified tile from the cache, or from the wrapped image if it isn't cached.  Tiles
+    /// read from the wrapped image are zero-filled beyond the image bounds before being cached.
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Read the specified mip level from the cache, or from the wrapped image if it isn't cached.
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override;
+
+    /// Read the mip tail from the cache, or from the wrapped image if it isn't cached.
+    bool readMipTail( char*        dest,
+                      unsigned int mipTailFirstLevel,
+                      unsigned int numMipLevels,
+                      const uint2* mipLevelDims,
+                      unsigned int pixelSizeInBytes,
+                      CUstream     stream ) override;
+
+    /// Start reading the specified tile from the wrapped image.  Tiles of images that fill host
+    /// memory are read synchronously through the cache.
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override
+    {
+        if( WrappedImageSource::getFillType() != CU_MEMORYTYPE_HOST )
+            return WrappedImageSource::readTileAsync( dest, mipLevel, tile, stream );
+        return ImageSource::readTileAsync( dest, mipLevel, tile, stream );
+    }
+
+  private:
+    // Copy the buffer with the given key to dest, decoding it with the given function if necessary.
+    bool readCached( char* dest, const SharedTileCache::Key& key, size_t size, const SharedTileCache::DecodeFunction& decode );
+
+    std::shared_ptr<SharedTileCache> m_cache;
+    const unsigned long long         m_imageId;
+};
+
+}  // namespace imageSource
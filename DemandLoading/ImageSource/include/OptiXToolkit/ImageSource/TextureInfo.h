@@ -6,6 +6,8 @@
 
 #include <cuda.h>
 
+#include <cstddef>
+
 namespace imageSource {
 
 /// Image info, including dimensions and format.
@@ -20,9 +22,31 @@ struct TextureInfo
     bool           isTiled;
 };
 
-/// Get the channel size in bytes.
+/// Get the channel size in bytes.  Block-compressed formats have no per-channel size; use
+/// getBytesPerBlock instead.
 unsigned int getBytesPerChannel( CUarray_format format );
 
+/// Returns true for the block-compressed (BC1-BC7) formats, which store 4x4 blocks of texels.
+/// Block-compressed formats require CUDA 11.5 or later.
+bool isBlockCompressed( CUarray_format format );
+
+/// Get the width and height in texels of a block: 4 for block-compressed formats, 1 otherwise.
+inline unsigned int getBlockDim( CUarray_format format )
+{
+    return isBlockCompressed( format ) ? 4 : 1;
+}
+
+/// Get the size in bytes of a block, which is a single pixel for uncompressed formats.
+unsigned int getBytesPerBlock( CUarray_format format, unsigned int numChannels );
+
+/// Get the number of channels in a block-compressed format (e.g. 2 for BC5).  Returns zero for
+/// uncompressed formats.
+unsigned int getNumChannelsInBlockFormat( CUarray_format format );
+
+/// Get the size in bytes of an image (or tile) of the given dimensions.  Partial blocks at the
+/// right and bottom edges of block-compressed images occupy whole blocks.
+size_t getImageSizeInBytes( CUarray_format format, unsigned int numChannels, unsigned int width, unsigned int height );
+
 /// Get total texture size
 size_t getTextureSizeInBytes( const TextureInfo& info );
 
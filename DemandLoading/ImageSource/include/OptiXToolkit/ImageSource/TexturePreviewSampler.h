@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file TexturePreviewSampler.h
+/// Host reference sampler that filters an image with the same math as the device textureCubic.
+
+#include <OptiXToolkit/ImageSource/ImageSource.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+#include <OptiXToolkit/ShaderUtil/TextureUtil.h>
+
+#include <cuda.h>
+
+#include <memory>
+#include <vector>
+
+namespace imageSource {
+
+/// Filter settings of a TexturePreviewSampler, with the same meaning as the corresponding fields of
+/// demandLoading::TextureDescriptor.
+struct TexturePreviewDescriptor
+{
+    /// Address mode (wrap, clamp, mirror or border)
+    CUaddress_mode addressMode[2]{ CU_TR_ADDRESS_MODE_WRAP, CU_TR_ADDRESS_MODE_WRAP };
+
+    /// Filter mode (point, bilinear, bicubic, smartbicubic)
+    unsigned int filterMode = FILTER_SMARTBICUBIC;
+
+    /// Filter mode between miplevels (linear or point)
+    CUfilter_mode mipmapFilterMode = CU_TR_FILTER_MODE_LINEAR;
+
+    /// Maximum anisotropy.  A value of 1 disables anisotropic filtering.
+    unsigned int maxAnisotropy = 16;
+
+    /// Apply conservative filtering (overblur to prevent aliasing for very anisotropic samples).
+    bool conservativeFilter = true;
+};
+
+/// TexturePreviewSampler reads every mip level of an image (e.g. a MipMapImageSource or
+/// TiledImageSource) into host memory as float4 texels, and samples it on the host following
+/// textureCubic in CubicFiltering.h, sharing its weight, gradient and mip level functions.  This
+/// gives a CPU reference for device results without a GPU.
+///
+/// Bicubic filtering evaluates the 16 taps exactly, where the device combines four hardware bilinear
+/// fetches with 8-bit interpolation weights.  Bilinear (tex2DGrad) fetches are emulated with
+/// trilinear probes spaced along the longer gradient, up to maxAnisotropy of them, which
+/// approximates the hardware anisotropic filter, so compare against device results with a tolerance.
+///
+/// Samples are evaluated in batches: the filter setup of a batch is computed first, then its cubic
+/// weights in loops over the batch that the compiler vectorizes, then the texel fetches, which
+/// accumulate all four channels at once.  sampleImage distributes tiles of pixels over threads.
+/// Channels missing from the image read as zero, except alpha, which reads as one.
+class TexturePreviewSampler
+{
+  public:
+    /// Read all mip levels of the image, opening it if necessary.  Block-compressed images are not
+    /// supported.
+    TexturePreviewSampler( std::shared_ptr<ImageSource> image, const TexturePreviewDescriptor& desc = TexturePreviewDescriptor() );
+
+    /// Get the image info.
+    const TextureInfo& getInfo() const { return m_info; }
+
+    /// Get the filter settings.
+    const TexturePreviewDescriptor& getDescriptor() const { return m_desc; }
+
+    /// Sample the texture at (s,t) with the given texture gradients.  Results are stored in the
+    /// non-null locations pointed to by result, dresultds, and dresultdt, as in textureCubic.
+    void sample( float s, float t, float2 ddx, float2 ddy, float4* result, float4* dresultds = nullptr, float4* dresultdt = nullptr ) const;
+
+    /// Sample the texture at count coordinates (s[i], t[i]) with gradients ddx[i] and ddy[i].  The
+    /// output arrays may be null.
+    void sampleBatch( unsigned int count,
+                      const float*  s,
+                      const float*  t,
+                      const float2* ddx,
+                      const float2* ddy,
+                      float4*       result,
+                      float4*       dresultds = nullptr,
+                      float4*       dresultdt = nullptr ) const;
+
+    /// Fill width x height images with samples at the pixel centers of the texture coordinate
+    /// rectangle from uv00 to uv11, with constant gradients, like the cubic filtering test kernels.
+    /// The output images may be null.  Tiles of pixels are sampled on numThreads threads (zero for
+    /// the hardware concurrency).
+    void sampleImage( unsigned int width,
+                      unsigned int height,
+                      float2       uv00,
+                      float2       uv11,
+                      float2       ddx,
+                      float2       ddy,
+                      float4*      result,
+                      float4*      dresultds  = nullptr,
+                      float4*      dresultdt  = nullptr,
+                      unsigned int numThreads = 0 ) const;
+
+  private:
+    struct Level
+    {
+        int                 width;
+        int                 height;
+        std::vector<float4> texels;
+    };
+
+    struct Setup;
+
+    // Texel fetch with the address mode applied.  Border texels are zero.
+    float4 fetch( const Level& level, int x, int y ) const;
+
+    // Point or bilinear lookup of a level, following the filter mode.
+    float4 lookup( const Level& level, float s, float t ) const;
+
+    // Emulation of tex2DGrad: anisotropic probes of one or two mip levels.
+    float4 sampleGrad( float s, float t, float2 ddx, float2 ddy ) const;
+
+    // Sum of the 16 taps around texel (i,j) of a level weighted by the outer product of wx and wy.
+    float4 sampleWeighted( const Level& level, int i, int j, const float* wx, const float* wy ) const;
+
+    void filterBatch( unsigned int count, const Setup* setups, float4* result, float4* dresultds, float4* dresultdt ) const;
+
+    TextureInfo              m_info{};
+    TexturePreviewDescriptor m_desc;
+    std::vector<Level>       m_levels;
+};
+
+}  // namespace imageSource
@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file ThrottledImageSource.h
+
+#include <OptiXToolkit/ImageSource/BandwidthLimiter.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+#include <OptiXToolkit/ImageSource/WrappedImageSource.h>
+
+#include <memory>
+#include <mutex>
+
+namespace imageSource {
+
+/// ThrottledImageSource adapts an ImageSource to draw the bytes and operations of each read from a
+/// BandwidthLimiter, blocking until the limiter grants them.  Unlike RateLimitedImageSource, reads
+/// are delayed rather than refused, and mip tail reads take priority over tile reads.
+///
+/// Each read is charged one operation and the bytes it reads from storage, which differ from the
+/// decoded size for compressed files.  Before a read, the bytes are estimated from the ratio of
+/// the bytes the wrapped image has read (getNumBytesRead) to the decoded bytes requested so far.
+/// After a read, the limiter is charged or refunded the difference between the bytes actually read
+/// and the estimates.  Images that do not count the bytes they read are charged their decoded size.
+class ThrottledImageSource : public WrappedImageSource
+{
+  public:
+    /// Throttle the given ImageSource with the given limiter.  If the limiter is null, the limiter
+    /// of the storage device holding the image file is used (see BandwidthLimiter::getDeviceLimiter),
+    /// and images without a filename (e.g. procedural images) are not throttled.
+    ThrottledImageSource( std::shared_ptr<ImageSource> imageSource, std::shared_ptr<BandwidthLimiter> limiter = nullptr );
+
+    /// Acquire the estimated size of the tile from the limiter at tile priority, then delegate.
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Acquire the estimated size of the tile from the limiter at tile priority, then start the
+    /// read.  The estimate is corrected by the next read.
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Acquire the estimated size of the mip level from the limiter at mip level priority, then delegate.
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override;
+
+    /// Acquire the estimated size of the rows from the limiter at tile priority, then delegate.
+    bool readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream ) override;
+
+    /// Acquire the estimated size of the mip tail from the limiter at mip tail priority, then delegate.
+    bool readMipTail( char*        dest,
+                      unsigned int mipTailFirstLevel,
+                      unsigned int numMipLevels,
+                      const uint2* mipLevelDims,
+                      unsigned int pixelSizeInBytes,
+                      CUstream     stream ) override;
+
+    /// Get the limiter, which is null if the image is not throttled.
+    std::shared_ptr<BandwidthLimiter> getLimiter() const { return m_limiter; }
+
+  private:
+    std::shared_ptr<BandwidthLimiter> m_limiter;
+
+    std::mutex         m_mutex;
+    unsigned long long m_decodedBytes  = 0;  // decoded size of the reads requested
+    unsigned long long m_bytesCharged  = 0;  // bytes charged to the limiter
+    unsigned long long m_bytesRead     = 0;  // bytes the wrapped image has read since it was wrapped
+    unsigned long long m_lastBytesRead = 0;  // last value of the wrapped image's byte count
+
+    void acquire( IOPriority priority, size_t decodedBytes );
+    void settle();
+};
+
+}  // namespace imageSource
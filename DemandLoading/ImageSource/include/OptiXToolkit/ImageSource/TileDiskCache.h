@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file TileDiskCache.h
+/// Persistent cache of decoded tiles, shared by the processes on a node.
+
+#include <OptiXToolkit/ImageSource/ImageHash.h>
+#include <OptiXToolkit/ImageSource/WrappedImageSource.h>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace imageSource {
+
+/// Options for a TileDiskCache.
+struct TileDiskCacheOptions
+{
+    std::string        directory;                   ///< cache directory, which is created if necessary
+    unsigned long long maxSize        = 8ULL << 30;  ///< size in bytes above which least recently used tiles are removed
+    unsigned int       maxPendingUses = 64;          ///< cache hits recorded in memory before the index is updated
+};
+
+/// TileDiskCache is a directory of decoded tiles that persists from one run to the next, and that
+/// many processes may use concurrently, e.g. the renderers on a farm node that share a texture set.
+///
+/// Each tile is stored in a blob file named by a 128-bit key that identifies its contents, with a
+/// checksum that is validated when the tile is read; corrupt blobs are removed and treated as misses.
+/// Blobs are written to temporary files and renamed into place, so readers never see partial
+/// blobs.  An index file records the size and last use of each blob.  When the cache exceeds its
+/// maximum size, the least recently used blobs are removed.  The size is measured from the blobs in
+/// the directory, so it includes the tiles written by all processes.  Updates to the index are
+/// serialized by a lock file.  All methods are threadsafe.
+class TileDiskCache
+{
+  public:
+    /// Open the cache in the given directory, creating it if necessary.  Throws an exception if the
+    /// directory can't be created.
+    explicit TileDiskCache( const TileDiskCacheOptions& options );
+
+    /// Record pending uses in the index.
+    ~TileDiskCache();
+
+    /// Read the tile with the given key into dest, which holds size bytes.  Returns false if the tile
+    /// is not cached, or its blob is corrupt or of a different size.
+    bool read( const ImageHash& key, char* dest, size_t size );
+
+    /// Store the given tile, and clean up the cache if this process has written more than an eighth
+    /// of its maximum size since it last cleaned up.  Each process cleans up on its own writes, so
+    /// the cache may exceed its maximum size by an eighth per process between cleanups.
+    void write( const ImageHash& key, const char* data, size_t size );
+
+    /// Remove least recently used tiles until the cache is at most three quarters of its maximum
+    /// size, and compact the index.  Blobs missing from the index are added to it, and temporary
+    /// files abandoned by failed writers are removed.
+    void cleanup();
+
+    /// Record pending uses in the index.
+    void flush();
+
+    /// Return the path of the blob holding the tile with the given key.
+    std::string getBlobPath( const ImageHash& key ) const;
+
+    /// Returns the number of tiles read from the cache.
+    unsigned long long getNumHits() const;
+
+    /// Returns the number of tiles requested that were not cached.
+    unsigned long long getNumMisses() const;
+
+    /// Returns the number of blobs that failed validation.
+    unsigned long long getNumCorruptBlobs() const;
+
+  private:
+    struct Use
+    {
+        ImageHash          key;
+        unsigned long long size;
+        long long          time;
+    };
+
+    class DirectoryLock;
+
+    void appendUses( const std::vector<Use>& uses );
+
+    TileDiskCacheOptions           m_options;
+    std::string                    m_indexPath;
+    std::unique_ptr<DirectoryLock> m_lock;
+
+    mutable std::mutex m_mutex;
+    std::vector<Use>   m_pendingUses;
+    unsigned long long m_bytesSinceCleanup   = 0;  // written by this process
+    unsigned long long m_numUsesSinceCleanup = 0;
+    unsigned long long m_numHits             = 0;
+    unsigned long long m_numMisses           = 0;
+    unsigned long long m_numCorruptBlobs     = 0;
+};
+
+/// DiskCachedImageSource reads the tiles of an ImageSource through a TileDiskCache, decoding only
+/// the tiles that are not already cached.  Tiles are keyed by the image's file path and variant,
+/// modification time and size, and the image info, so edited files are not read from stale tiles,
+/// and conversions or channel selections of one file do not share tiles.  Images that
+/// are not backed by a file, or that fill device memory, are passed through unchanged.
+class DiskCachedImageSource : public WrappedImageSource
+{
+  public:
+    /// Read the tiles of the given image through the given cache.
+    DiskCachedImageSource( std::shared_ptr<ImageSource> imageSource, std::shared_ptr<TileDiskCache> cache );
+
+    /// Open the wrapped image and compute the key that identifies its tiles.
+    void open( TextureInfo* info ) override;
+
+    /// Read the specified tile from the cache, or from the wrapped image if it isn't cached.  Tiles
+    /// read from the wrapped image are zero-filled beyond the image bounds before being cached.
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    /// Start reading the specified tile from the wrapped image.  Tiles that are cached are read
+    /// synchronously, since they are written to the cache when the read finishes.
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override
+    {
+        if( !m_isCaching )
+            return WrappedImageSource::readTileAsync( dest, mipLevel, tile, stream );
+        return ImageSource::readTileAsync( dest, mipLevel, tile, stream );
+    }
+
+    /// Returns true if tiles are cached, i.e. the wrapped image is a file that fills host memory.
+    bool isCaching() const { return m_isCaching; }
+
+  private:
+    std::shared_ptr<TileDiskCache> m_cache;
+    ImageHash                      m_imageKey{};
+    bool                           m_isCaching = false;
+};
+
+}  // namespace imageSource
@@ -9,6 +9,8 @@
 
 #include <vector_types.h>
 
+#include <future>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <utility>
@@ -16,10 +18,22 @@
 
 namespace imageSource {
 
+/// TiledImageSource adapts an untiled image (e.g. a scanline EXR, PNG or JPEG) to provide tiles.
+///
+/// If the base image can read partial mip levels (see ImageSource::readScanlines), tiles are
+/// copied from horizontal bands of rows that are decoded on demand and kept in a small LRU cache,
+/// so the memory used by a texture is bounded by the cache size rather than the image size.
+/// Optionally, coarser mip levels that the base image lacks are built from those bands, each band
+/// being point sampled from two bands of the next finer level.
+///
+/// Otherwise, each mip level is read from the base image in its entirety when a tile of it is
+/// first requested, and kept until the image is destroyed.
 class TiledImageSource : public WrappedImageSource
 {
   public:
-    explicit TiledImageSource( std::shared_ptr<ImageSource> baseImage );
+    /// Adapt the given image.  At most maxCachedBands bands of decoded rows are kept; if
+    /// buildMipLevels is true, a full mip chain is provided for streamed single-level images.
+    explicit TiledImageSource( std::shared_ptr<ImageSource> baseImage, unsigned int maxCachedBands = 8, bool buildMipLevels = false );
     ~TiledImageSource() override = default;
 
     void open( TextureInfo* info ) override;
@@ -30,6 +44,10 @@ class TiledImageSource : public WrappedImageSource
 
     bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
 
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override;
+
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override;
+
     bool readMipTail( char*        dest,
                       unsigned int mipTailFirstLevel,
                       unsigned int numMipLevels,
@@ -37,18 +55,58 @@ class TiledImageSource : public WrappedImageSource
                       unsigned int pixelSizeInBytes,
                       CUstream     stream ) override;
 
+    /// The adapted image is tiled, so partial mip levels are read as tiles rather than scanlines.
+    bool readScanlines( char* /*dest*/, unsigned int /*mipLevel*/, unsigned int /*firstRow*/, unsigned int /*numRows*/, CUstream /*stream*/ ) override
+    {
+        return false;
+    }
+
+    /// The adapted image is tiled, so partial mip levels are read as tiles rather than scanlines.
+    unsigned int getScanlineChunkHeight() const override { return 0; }
+
     unsigned long long getNumTilesRead() const override;
 
+    /// Returns true if tiles are streamed from bands of rows rather than whole mip levels.
+    bool isStreaming() const;
+
+    /// Returns the number of bands of rows in the cache.
+    unsigned int getNumCachedBands() const;
+
   private:
-    void getBaseInfo();
+    using Band = std::shared_ptr<const std::vector<char>>;
 
-    mutable std::mutex m_dataMutex;
-    bool               m_baseIsTiled{};
-    TextureInfo        m_tiledInfo{};
-    unsigned long long m_numTilesRead{};
-    std::vector<char>  m_buffer;
-    std::vector<char*> m_mipLevels;
-    std::vector<uint2> m_mipDimensions;
+    struct CachedBand
+    {
+        std::shared_future<Band> band;
+        unsigned long long       lastUsed;
+    };
+
+    void getBaseInfo();
+    uint2 getLevelDimensions( unsigned int mipLevel ) const;
+
+    // Streaming helpers, which must be called without holding the mutex.
+    Band getBand( unsigned int mipLevel, unsigned int bandIndex, CUstream stream );
+    Band loadBand( unsigned int mipLevel, unsigned int bandIndex, CUstream stream );
+    void copyFromBands( char* dest, size_t destRowPitch, unsigned int mipLevel, PixelPosition start, uint2 size, CUstream stream );
+
+    std::shared_ptr<ImageSource> m_baseImage;
+    mutable std::mutex           m_dataMutex;
+    bool                         m_baseIsTiled{};
+    TextureInfo                  m_tiledInfo{};
+    unsigned long long           m_numTilesRead{};
+    std::vector<char>            m_buffer;
+    std::vector<char*>           m_mipLevels;
+    std::vector<uint2>           m_mipDimensions;
+
+    // Band streaming state.  Bands are keyed by (mipLevel, bandIndex).
+    const unsigned int                                          m_maxCachedBands;
+    const bool                                                  m_buildMipLevels;
+    bool                                                        m_isStreaming{};
+    unsigned int                                                m_bandHeight{};
+    unsigned int                                                m_numBaseLevels{};
+    unsigned int                                                m_pixelSizeInBytes{};
+    std::map<std::pair<unsigned int, unsigned int>, CachedBand> m_bands;
+    unsigned long long                                          m_bandClock{};
 };
 
 /// A simple convenience function to reliably get a tiled image source.
@@ -6,7 +6,10 @@
 
 #include <OptiXToolkit/ImageSource/ImageSource.h>
 
+#include <chrono>
+#include <future>
 #include <memory>
+#include <string>
 #include <utility>
 
 namespace imageSource {
@@ -47,12 +50,30 @@ class WrappedImageSource : public ImageSource
         return m_imageSource->readTile( dest, mipLevel, tile, stream);
     }
 
+    /// Delegates to the wrapped ImageSource, which is retained until the read completes.  Wrappers
+    /// that change the tile data must override this, e.g. by calling ImageSource::readTileAsync,
+    /// which reads the tile synchronously with their readTile.
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override
+    {
+        return retainUntilRead( m_imageSource->readTileAsync( dest, mipLevel, tile, stream ), m_imageSource );
+    }
+
     /// Delegates to the wrapped ImageSource.
     bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override
     {
         return m_imageSource->readMipLevel( dest, mipLevel, expectedWidth, expectedHeight, stream );
     }
 
+    /// Delegates to the wrapped ImageSource.  Wrappers that change the pixel data must override
+    /// this (returning false if they can't convert partial mip levels).
+    bool readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream ) override
+    {
+        return m_imageSource->readScanlines( dest, mipLevel, firstRow, numRows, stream );
+    }
+
+    /// Delegates to the wrapped ImageSource.
+    unsigned int getScanlineChunkHeight() const override { return m_imageSource->getScanlineChunkHeight(); }
+
     /// Delegates to the wrapped ImageSource.
     bool readMipTail( char*        dest,
                       unsigned int mipTailFirstLevel,
@@ -85,6 +106,23 @@ class WrappedImageSource : public ImageSource
     /// Delegates to the wrapped ImageSource.
     bool hasCascade() const override { return m_imageSource->hasCascade(); }
 
+    /// Delegates to the wrapped ImageSource.
+    std::string getFilename() const override { return m_imageSource->getFilename(); }
+
+    /// Delegates to the wrapped ImageSource.  Wrappers that change the pixel data must override
+    /// this, appending a description of the change.
+    std::string getFileVariant() const override { return m_imageSource->getFileVariant(); }
+
+  protected:
+    /// Returns a future for the result of the given read that retains the given object until the
+    /// result is retrieved.  Reads that have already completed are returned unchanged.
+    static std::future<bool> retainUntilRead( std::future<bool> read, std::shared_ptr<void> object )
+    {
+        if( read.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready )
+            return read;
+        return std::async( std::launch::deferred, [object]( std::future<bool> pending ) { return pending.get(); }, std::move( read ) );
+    }
+
   private:
     std::shared_ptr<ImageSource> m_imageSource;
 };
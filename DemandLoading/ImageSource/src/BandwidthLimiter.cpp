@@ -0,0 +1,234 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/BandwidthLimiter.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <limits>
+#include <sstream>
+
+namespace imageSource {
+
+namespace {
+
+class SteadyClock : public BandwidthLimiter::Clock
+{
+  public:
+    double now() const override
+    {
+        using namespace std::chrono;
+        return duration_cast<duration<double>>( steady_clock::now().time_since_epoch() ).count();
+    }
+
+    void waitFor( std::condition_variable& cond, std::unique_lock<std::mutex>& lock, double seconds ) override
+    {
+        // Wake up at least once a second to pick up changes to the limits.
+        cond.wait_for( lock, std::chrono::duration<double>( std::min( seconds, 1.0 ) ) );
+    }
+};
+
+double getByteCapacity( const BandwidthLimits& limits )
+{
+    return limits.bytesPerSecond * limits.burstSeconds;
+}
+
+// The operation bucket holds at least one operation, so that every read can proceed.
+double getOpCapacity( const BandwidthLimits& limits )
+{
+    return std::max( 1.0, limits.opsPerSecond * limits.burstSeconds );
+}
+
+// Identify the storage device holding the given path.
+std::string getDeviceKey( const std::string& path )
+{
+#ifdef _WIN32
+    if( path.size() >= 2 && path[1] == ':' )
+        return std::string( 1, static_cast<char>( toupper( path[0] ) ) ) + ':';
+    return std::string();
+#else
+    struct stat status;
+    if( stat( path.c_str(), &status ) != 0 )
+        return std::string();
+    std::stringstream key;
+    key << status.st_dev;
+    return key.str();
+#endif
+}
+
+}  // namespace
+
+BandwidthLimiter::BandwidthLimiter( const BandwidthLimits& limits, std::shared_ptr<Clock> clock )
+    : m_clock( clock ? clock : std::make_shared<SteadyClock>() )
+    , m_limits( limits )
+    , m_byteTokens( getByteCapacity( limits ) )
+    , m_opTokens( getOpCapacity( limits ) )
+    , m_lastRefill( m_clock->now() )
+{
+}
+
+void BandwidthLimiter::setLimits( const BandwidthLimits& limits )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    refill( m_clock->now() );
+    m_limits     = limits;
+    m_byteTokens = std::min( m_byteTokens, getByteCapacity( limits ) );
+    m_opTokens   = std::min( m_opTokens, getOpCapacity( limits ) );
+    m_cond.notify_all();
+}
+
+BandwidthLimits BandwidthLimiter::getLimits() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_limits;
+}
+
+void BandwidthLimiter::refill( double now )
+{
+    const double elapsed = now - m_lastRefill;
+    if( elapsed <= 0.0 )
+        return;
+    m_byteTokens = std::min( getByteCapacity( m_limits ), m_byteTokens + elapsed * m_limits.bytesPerSecond );
+    m_opTokens   = std::min( getOpCapacity( m_limits ), m_opTokens + elapsed * m_limits.opsPerSecond );
+    m_lastRefill = now;
+}
+
+bool BandwidthLimiter::grantRequests()
+{
+    bool granted = false;
+    for( int priority = NUM_IO_PRIORITIES - 1; priority >= 0; )
+    {
+        PriorityClass& priorityClass = m_classes[priority];
+        if( priorityClass.waiting.empty() )
+        {
+            --priority;
+            continue;
+        }
+
+        // Grant the request with the earliest start tag once the buckets can cover it.  A lower
+        // priority class never bypasses a waiting request of a higher one.
+        Request*     request   = priorityClass.waiting.begin()->second;
+        const double byteLimit = std::min( static_cast<double>( request->numBytes ), getByteCapacity( m_limits ) );
+        if( ( m_limits.bytesPerSecond > 0.0 && m_byteTokens < byteLimit ) || ( m_limits.opsPerSecond > 0.0 && m_opTokens < 1.0 ) )
+            break;
+        if( m_limits.bytesPerSecond > 0.0 )
+            m_byteTokens -= static_cast<double>( request->numBytes );
+        if( m_limits.opsPerSecond > 0.0 )
+            m_opTokens -= 1.0;
+
+        priorityClass.virtualTime = request->startTag;
+        priorityClass.waiting.erase( priorityClass.waiting.begin() );
+        if( priorityClass.waiting.empty() )
+        {
+            // The class is idle, so its clients start afresh.
+            priorityClass.lastFinish.clear();
+            priorityClass.virtualTime = 0.0;
+        }
+        request->granted = true;
+        --m_numWaiting;
+        m_numBytesGranted += request->numBytes;
+        ++m_numOpsGranted;
+        granted = true;
+    }
+    return granted;
+}
+
+double BandwidthLimiter::getTimeUntilNextGrant() const
+{
+    for( int priority = NUM_IO_PRIORITIES - 1; priority >= 0; --priority )
+    {
+        const PriorityClass& priorityClass = m_classes[priority];
+        if( priorityClass.waiting.empty() )
+            continue;
+        const Request* request   = priorityClass.waiting.begin()->second;
+        const double   byteLimit = std::min( static_cast<double>( request->numBytes ), getByteCapacity( m_limits ) );
+        double         seconds   = 0.0;
+        if( m_limits.bytesPerSecond > 0.0 )
+            seconds = std::max( seconds, ( byteLimit - m_byteTokens ) / m_limits.bytesPerSecond );
+        if( m_limits.opsPerSecond > 0.0 )
+            seconds = std::max( seconds, ( 1.0 - m_opTokens ) / m_limits.opsPerSecond );
+        return seconds;
+    }
+    return std::numeric_limits<double>::max();
+}
+
+void BandwidthLimiter::acquire( const void* client, IOPriority priority, size_t numBytes )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    const double                 startTime = m_clock->now();
+
+    // The request is tagged with its virtual start time, which follows the previous request of the
+    // same client, so each client gets an equal share of the bytes.
+    PriorityClass& priorityClass = m_classes[priority];
+    double&        lastFinish    = priorityClass.lastFinish[client];
+    Request        request{ client, numBytes, std::max( priorityClass.virtualTime, lastFinish ), m_nextSequence++, false };
+    lastFinish = request.startTag + static_cast<double>( std::max<size_t>( numBytes, 1 ) );
+    priorityClass.waiting[std::make_pair( request.startTag, request.sequence )] = &request;
+    ++m_numWaiting;
+
+    while( true )
+    {
+        refill( m_clock->now() );
+        if( grantRequests() )
+            m_cond.notify_all();
+        if( request.granted )
+            break;
+        m_clock->waitFor( m_cond, lock, getTimeUntilNextGrant() );
+    }
+    m_totalWaitTime += m_clock->now() - startTime;
+}
+
+void BandwidthLimiter::charge( long long numBytes )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    refill( m_clock->now() );
+    if( m_limits.bytesPerSecond > 0.0 )
+        m_byteTokens = std::min( getByteCapacity( m_limits ), m_byteTokens - static_cast<double>( numBytes ) );
+    m_numBytesGranted = static_cast<unsigned long long>( std::max( 0LL, static_cast<long long>( m_numBytesGranted ) + numBytes ) );
+    if( numBytes < 0 && grantRequests() )
+        m_cond.notify_all();
+}
+
+unsigned long long BandwidthLimiter::getNumBytesGranted() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numBytesGranted;
+}
+
+unsigned long long BandwidthLimiter::getNumOpsGranted() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numOpsGranted;
+}
+
+double BandwidthLimiter::getTotalWaitTime() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_totalWaitTime;
+}
+
+unsigned int BandwidthLimiter::getNumWaiting() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numWaiting;
+}
+
+std::shared_ptr<BandwidthLimiter> BandwidthLimiter::getDeviceLimiter( const std::string& path )
+{
+    static std::mutex                                               mutex;
+    static std::map<std::string, std::shared_ptr<BandwidthLimiter>> limiters;
+
+    std::unique_lock<std::mutex>       lock( mutex );
+    std::shared_ptr<BandwidthLimiter>& limiter = limiters[getDeviceKey( path )];
+    if( !limiter )
+        limiter = std::make_shared<BandwidthLimiter>();
+    return limiter;
+}
+
+}  // namespace imageSource
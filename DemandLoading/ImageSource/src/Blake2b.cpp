@@ -0,0 +1,141 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "Blake2b.h"
+
+#include <OptiXToolkit/Error/ErrorCheck.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace imageSource {
+
+namespace {
+
+const uint64_t BLAKE2B_IV[8] = { 0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+                                 0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+                                 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL };
+
+const uint8_t BLAKE2B_SIGMA[12][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },  //
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },  //
+    { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },  //
+    { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },  //
+    { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },  //
+    { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },  //
+    { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },  //
+    { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },  //
+    { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },  //
+    { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },  //
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },  //
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },  //
+};
+
+inline uint64_t rotr64( uint64_t x, unsigned int n )
+{
+    return ( x >> n ) | ( x << ( 64 - n ) );
+}
+
+// Load a little-endian 64-bit word, independent of host byte order.
+inline uint64_t load64( const uint8_t* p )
+{
+    uint64_t result = 0;
+    for( int i = 7; i >= 0; --i )
+        result = ( result << 8 ) | p[i];
+    return result;
+}
+
+inline void mix( uint64_t* v, int a, int b, int c, int d, uint64_t x, uint64_t y )
+{
+    v[a] = v[a] + v[b] + x;
+    v[d] = rotr64( v[d] ^ v[a], 32 );
+    v[c] = v[c] + v[d];
+    v[b] = rotr64( v[b] ^ v[c], 24 );
+    v[a] = v[a] + v[b] + y;
+    v[d] = rotr64( v[d] ^ v[a], 16 );
+    v[c] = v[c] + v[d];
+    v[b] = rotr64( v[b] ^ v[c], 63 );
+}
+
+}  // namespace
+
+Blake2b::Blake2b( unsigned int digestSize )
+    : m_digestSize( digestSize )
+{
+    OTK_ASSERT_MSG( digestSize > 0 && digestSize <= MAX_DIGEST_SIZE, "Invalid BLAKE2b digest size" );
+    std::copy( BLAKE2B_IV, BLAKE2B_IV + 8, m_state );
+    // Parameter block: digest length, no key, fanout 1, depth 1.
+    m_state[0] ^= 0x01010000ULL ^ digestSize;
+    m_counter[0] = 0;
+    m_counter[1] = 0;
+}
+
+void Blake2b::compress( const uint8_t* block, bool isLastBlock )
+{
+    uint64_t m[16];
+    for( int i = 0; i < 16; ++i )
+        m[i] = load64( block + i * 8 );
+
+    uint64_t v[16];
+    std::copy( m_state, m_state + 8, v );
+    std::copy( BLAKE2B_IV, BLAKE2B_IV + 8, v + 8 );
+    v[12] ^= m_counter[0];
+    v[13] ^= m_counter[1];
+    if( isLastBlock )
+        v[14] = ~v[14];
+
+    for( int round = 0; round < 12; ++round )
+    {
+        const uint8_t* s = BLAKE2B_SIGMA[round];
+        mix( v, 0, 4, 8, 12, m[s[0]], m[s[1]] );
+        mix( v, 1, 5, 9, 13, m[s[2]], m[s[3]] );
+        mix( v, 2, 6, 10, 14, m[s[4]], m[s[5]] );
+        mix( v, 3, 7, 11, 15, m[s[6]], m[s[7]] );
+        mix( v, 0, 5, 10, 15, m[s[8]], m[s[9]] );
+        mix( v, 1, 6, 11, 12, m[s[10]], m[s[11]] );
+        mix( v, 2, 7, 8, 13, m[s[12]], m[s[13]] );
+        mix( v, 3, 4, 9, 14, m[s[14]], m[s[15]] );
+    }
+
+    for( int i = 0; i < 8; ++i )
+        m_state[i] ^= v[i] ^ v[i + 8];
+}
+
+void Blake2b::update( const void* data, size_t size )
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>( data );
+    while( size > 0 )
+    {
+        // The final block must be compressed with the last-block flag, so a full buffer is only
+        // compressed once more input arrives.
+        if( m_bufferSize == BLOCK_SIZE )
+        {
+            m_counter[0] += BLOCK_SIZE;
+            if( m_counter[0] < BLOCK_SIZE )
+                ++m_counter[1];
+            compress( m_buffer, false );
+            m_bufferSize = 0;
+        }
+        const size_t count = std::min( size, BLOCK_SIZE - m_bufferSize );
+        std::memcpy( m_buffer + m_bufferSize, bytes, count );
+        m_bufferSize += count;
+        bytes += count;
+        size -= count;
+    }
+}
+
+void Blake2b::finish( void* digest )
+{
+    m_counter[0] += m_bufferSize;
+    if( m_counter[0] < m_bufferSize )
+        ++m_counter[1];
+    std::fill( m_buffer + m_bufferSize, m_buffer + BLOCK_SIZE, uint8_t( 0 ) );
+    compress( m_buffer, true );
+
+    uint8_t* out = static_cast<uint8_t*>( digest );
+    for( unsigned int i = 0; i < m_digestSize; ++i )
+        out[i] = static_cast<uint8_t>( m_state[i / 8] >> ( 8 * ( i % 8 ) ) );
+}
+
+}  // namespace imageSource
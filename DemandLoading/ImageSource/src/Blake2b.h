@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace imageSource {
+
+/// Streaming BLAKE2b hash (RFC 7693), unkeyed, with a configurable digest size of up to 64 bytes.
+class Blake2b
+{
+  public:
+    static const unsigned int BLOCK_SIZE      = 128;
+    static const unsigned int MAX_DIGEST_SIZE = 64;
+
+    /// Begin a new hash producing a digest of the given size in bytes.
+    explicit Blake2b( unsigned int digestSize = 16 );
+
+    /// Append the given bytes to the hashed message.
+    void update( const void* data, size_t size );
+
+    /// Append a trivially copyable value to the hashed message.
+    template <typename T>
+    void updateValue( const T& value )
+    {
+        update( &value, sizeof( T ) );
+    }
+
+    /// Finish the hash, writing getDigestSize() bytes to digest.  No further updates are allowed.
+    void finish( void* digest );
+
+    unsigned int getDigestSize() const { return m_digestSize; }
+
+  private:
+    void compress( const uint8_t* block, bool isLastBlock );
+
+    uint64_t     m_state[8];
+    uint64_t     m_counter[2];
+    uint8_t      m_buffer[BLOCK_SIZE];
+    size_t       m_bufferSize = 0;
+    unsigned int m_digestSize;
+};
+
+}  // namespace imageSource
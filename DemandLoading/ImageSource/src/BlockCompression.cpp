@@ -0,0 +1,758 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/BlockCompression.h>
+
+#include "CpuFeatures.h"
+
+#include <OptiXToolkit/Error/ErrorCheck.h>
+#include <OptiXToolkit/ImageSource/FormatConversion.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace imageSource {
+
+namespace {
+
+const int NUM_TEXELS = 16;
+
+// Interpolation weights for 4-bit indices, shared by BC6H and BC7.
+const int WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Texel values for up to four channels, in the working range of each encoder.
+using Points = float[NUM_TEXELS][4];
+
+float clamp01( float x )
+{
+    // Written so that NaN maps to zero.
+    return x > 0.f ? ( x < 1.f ? x : 1.f ) : 0.f;
+}
+
+int clampInt( int x, int lo, int hi )
+{
+    return std::min( std::max( x, lo ), hi );
+}
+
+// Writes fields least significant bit first into a zero-initialized block.
+class BitWriter
+{
+  public:
+    explicit BitWriter( unsigned char* dest )
+        : m_dest( dest )
+    {
+    }
+
+    void write( unsigned int value, unsigned int numBits )
+    {
+        for( unsigned int i = 0; i < numBits; ++i, ++m_pos )
+        {
+            if( ( value >> i ) & 1 )
+                m_dest[m_pos >> 3] |= static_cast<unsigned char>( 1 << ( m_pos & 7 ) );
+        }
+    }
+
+  private:
+    unsigned char* m_dest;
+    unsigned int   m_pos = 0;
+};
+
+class BitReader
+{
+  public:
+    explicit BitReader( const unsigned char* src )
+        : m_src( src )
+    {
+    }
+
+    unsigned int read( unsigned int numBits )
+    {
+        unsigned int value = 0;
+        for( unsigned int i = 0; i < numBits; ++i, ++m_pos )
+            value |= ( ( m_src[m_pos >> 3] >> ( m_pos & 7 ) ) & 1U ) << i;
+        return value;
+    }
+
+  private:
+    const unsigned char* m_src;
+    unsigned int         m_pos = 0;
+};
+
+// Fit a line to the points along their principal axis, returning the endpoints of their projection
+// onto it.  Only the first numChannels components are considered.
+void fitPrincipalAxis( const Points& points, int numChannels, float lo[4], float hi[4] )
+{
+    float mean[4] = {};
+    for( int i = 0; i < NUM_TEXELS; ++i )
+        for( int c = 0; c < numChannels; ++c )
+            mean[c] += points[i][c];
+    for( int c = 0; c < numChannels; ++c )
+        mean[c] /= NUM_TEXELS;
+
+    float cov[4][4] = {};
+    for( int i = 0; i < NUM_TEXELS; ++i )
+        for( int a = 0; a < numChannels; ++a )
+            for( int b = 0; b < numChannels; ++b )
+                cov[a][b] += ( points[i][a] - mean[a] ) * ( points[i][b] - mean[b] );
+
+    // Start the power iteration from the covariance row of the channel with the largest variance.
+    int largest = 0;
+    for( int c = 1; c < numChannels; ++c )
+        largest = cov[c][c] > cov[largest][largest] ? c : largest;
+    float axis[4] = {};
+    for( int c = 0; c < numChannels; ++c )
+        axis[c] = cov[largest][c];
+
+    float length = 0.f;
+    for( int iteration = 0; iteration < 8; ++iteration )
+    {
+        float next[4] = {};
+        for( int a = 0; a < numChannels; ++a )
+            for( int b = 0; b < numChannels; ++b )
+                next[a] += cov[a][b] * axis[b];
+        length = 0.f;
+        for( int c = 0; c < numChannels; ++c )
+            length += next[c] * next[c];
+        length = std::sqrt( length );
+        if( !( length > 0.f ) )
+            break;
+        for( int c = 0; c < numChannels; ++c )
+            axis[c] = next[c] / length;
+    }
+
+    // All the points coincide.
+    if( !( length > 0.f ) )
+    {
+        std::copy( mean, mean + 4, lo );
+        std::copy( mean, mean + 4, hi );
+        return;
+    }
+
+    float tmin = 0.f;
+    float tmax = 0.f;
+    for( int i = 0; i < NUM_TEXELS; ++i )
+    {
+        float t = 0.f;
+        for( int c = 0; c < numChannels; ++c )
+            t += ( points[i][c] - mean[c] ) * axis[c];
+        tmin = std::min( tmin, t );
+        tmax = std::max( tmax, t );
+    }
+    for( int c = 0; c < 4; ++c )
+    {
+        lo[c] = mean[c] + tmin * axis[c];
+        hi[c] = mean[c] + tmax * axis[c];
+    }
+}
+
+// Return the index of the palette entry nearest to the point, and its squared distance.
+int nearestIndex( const float* point, const float ( *palette )[4], int paletteSize, int numChannels, float& error )
+{
+    int   best      = 0;
+    float bestError = 0.f;
+    for( int k = 0; k < paletteSize; ++k )
+    {
+        float e = 0.f;
+        for( int c = 0; c < numChannels; ++c )
+        {
+            const float d = point[c] - palette[k][c];
+            e += d * d;
+        }
+        if( k == 0 || e < bestError )
+        {
+            best      = k;
+            bestError = e;
+        }
+    }
+    error = bestError;
+    return best;
+}
+
+#if OTK_USE_X86_INTRINSICS
+// Find the nearest palette entries of eight points at a time, returning the number of points
+// done.  The arithmetic matches nearestIndex operation for operation, so both produce the same
+// indices and errors.
+OTK_TARGET_AVX int nearestIndicesAVX( const Points& points, const float ( *palette )[4], int paletteSize, int numChannels, int indices[NUM_TEXELS], float errors[NUM_TEXELS] )
+{
+    for( int i = 0; i < NUM_TEXELS; i += 8 )
+    {
+        __m256 channels[4];
+        for( int c = 0; c < numChannels; ++c )
+            channels[c] = _mm256_setr_ps( points[i][c], points[i + 1][c], points[i + 2][c], points[i + 3][c], points[i + 4][c],
+                                          points[i + 5][c], points[i + 6][c], points[i + 7][c] );
+        __m256 bestError = _mm256_setzero_ps();
+        __m256 bestIndex = _mm256_setzero_ps();
+        for( int k = 0; k < paletteSize; ++k )
+        {
+            __m256 e = _mm256_setzero_ps();
+            for( int c = 0; c < numChannels; ++c )
+            {
+                const __m256 d = _mm256_sub_ps( channels[c], _mm256_set1_ps( palette[k][c] ) );
+                e              = _mm256_add_ps( e, _mm256_mul_ps( d, d ) );
+            }
+            const __m256 closer = k == 0 ? _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) ) : _mm256_cmp_ps( e, bestError, _CMP_LT_OQ );
+            bestError           = _mm256_blendv_ps( bestError, e, closer );
+            bestIndex           = _mm256_blendv_ps( bestIndex, _mm256_set1_ps( static_cast<float>( k ) ), closer );
+        }
+        _mm256_storeu_ps( errors + i, bestError );
+        _mm256_storeu_si256( reinterpret_cast<__m256i*>( indices + i ), _mm256_cvttps_epi32( bestIndex ) );
+    }
+    return NUM_TEXELS;
+}
+#endif
+
+// Choose the nearest palette entry for each point, returning the total squared error.
+float chooseIndices( const Points& points, const float ( *palette )[4], int paletteSize, int numChannels, int indices[NUM_TEXELS] )
+{
+    float errors[NUM_TEXELS];
+    int   i = 0;
+#if OTK_USE_X86_INTRINSICS
+    if( hasAVX() )
+        i = nearestIndicesAVX( points, palette, paletteSize, numChannels, indices, errors );
+#endif
+    for( ; i < NUM_TEXELS; ++i )
+        indices[i] = nearestIndex( points[i], palette, paletteSize, numChannels, errors[i] );
+
+    // Sum in texel order, so that the encoded blocks do not depend on the instruction set.
+    float error = 0.f;
+    for( i = 0; i < NUM_TEXELS; ++i )
+        error += errors[i];
+    return error;
+}
+
+//------------------------------------------------------------------------------
+// BC1
+
+unsigned short packRgb565( const float color[4] )
+{
+    const unsigned int r = static_cast<unsigned int>( clamp01( color[0] ) * 31.f + 0.5f );
+    const unsigned int g = static_cast<unsigned int>( clamp01( color[1] ) * 63.f + 0.5f );
+    const unsigned int b = static_cast<unsigned int>( clamp01( color[2] ) * 31.f + 0.5f );
+    return static_cast<unsigned short>( ( r << 11 ) | ( g << 5 ) | b );
+}
+
+void unpackRgb565( unsigned int packed, float color[4] )
+{
+    const unsigned int r = packed >> 11;
+    const unsigned int g = ( packed >> 5 ) & 63;
+    const unsigned int b = packed & 31;
+    color[0]             = ( ( r << 3 ) | ( r >> 2 ) ) / 255.f;
+    color[1]             = ( ( g << 2 ) | ( g >> 4 ) ) / 255.f;
+    color[2]             = ( ( b << 3 ) | ( b >> 2 ) ) / 255.f;
+    color[3]             = 1.f;
+}
+
+// Returns the number of opaque palette entries: 4 if color0 > color1, otherwise 3 (the fourth
+// entry is transparent black).
+int makeBC1Palette( unsigned int color0, unsigned int color1, float palette[4][4] )
+{
+    unpackRgb565( color0, palette[0] );
+    unpackRgb565( color1, palette[1] );
+    if( color0 > color1 )
+    {
+        for( int c = 0; c < 3; ++c )
+        {
+            palette[2][c] = ( 2.f * palette[0][c] + palette[1][c] ) / 3.f;
+            palette[3][c] = ( palette[0][c] + 2.f * palette[1][c] ) / 3.f;
+        }
+        palette[2][3] = palette[3][3] = 1.f;
+        return 4;
+    }
+    for( int c = 0; c < 3; ++c )
+    {
+        palette[2][c] = ( palette[0][c] + palette[1][c] ) / 2.f;
+        palette[3][c] = 0.f;
+    }
+    palette[2][3] = 1.f;
+    palette[3][3] = 0.f;
+    return 3;
+}
+
+float chooseBC1Indices( const Points& points, unsigned int color0, unsigned int color1, int indices[NUM_TEXELS] )
+{
+    float     palette[4][4];
+    const int paletteSize = makeBC1Palette( color0, color1, palette );
+    return chooseIndices( points, palette, paletteSize, 3, indices );
+}
+
+void compressBC1( const float4 texels[NUM_TEXELS], unsigned char* dest )
+{
+    Points points;
+    for( int i = 0; i < NUM_TEXELS; ++i )
+    {
+        points[i][0] = clamp01( texels[i].x );
+        points[i][1] = clamp01( texels[i].y );
+        points[i][2] = clamp01( texels[i].z );
+        points[i][3] = 1.f;
+    }
+
+    float lo[4], hi[4];
+    fitPrincipalAxis( points, 3, lo, hi );
+    unsigned int color0 = packRgb565( hi );
+    unsigned int color1 = packRgb565( lo );
+    if( color0 < color1 )
+        std::swap( color0, color1 );
+    int   indices[NUM_TEXELS];
+    float error = chooseBC1Indices( points, color0, color1, indices );
+
+    // Refine the endpoints by a least squares fit given the indices, keeping them if the error decreases.
+    if( color0 != color1 )
+    {
+        const float weights[4] = { 1.f, 0.f, 2.f / 3.f, 1.f / 3.f };  // weight of color0 for each index
+        float       aa = 0.f, ab = 0.f, bb = 0.f;
+        float       ap[3] = {}, bp[3] = {};
+        for( int i = 0; i < NUM_TEXELS; ++i )
+        {
+            const float a = weights[indices[i]];
+            const float b = 1.f - a;
+            aa += a * a;
+            ab += a * b;
+            bb += b * b;
+            for( int c = 0; c < 3; ++c )
+            {
+                ap[c] += a * points[i][c];
+                bp[c] += b * points[i][c];
+            }
+        }
+        const float det = aa * bb - ab * ab;
+        if( std::fabs( det ) > 1e-6f )
+        {
+            float end0[4] = {}, end1[4] = {};
+            for( int c = 0; c < 3; ++c )
+            {
+                end0[c] = ( bb * ap[c] - ab * bp[c] ) / det;
+                end1[c] = ( aa * bp[c] - ab * ap[c] ) / det;
+            }
+            unsigned int refined0 = packRgb565( end0 );
+            unsigned int refined1 = packRgb565( end1 );
+            if( refined0 < refined1 )
+                std::swap( refined0, refined1 );
+            int         refinedIndices[NUM_TEXELS];
+            const float refinedError = chooseBC1Indices( points, refined0, refined1, refinedIndices );
+            if( refined0 != refined1 && refinedError < error )
+            {
+                color0 = refined0;
+                color1 = refined1;
+                std::copy( refinedIndices, refinedIndices + NUM_TEXELS, indices );
+            }
+        }
+    }
+
+    std::memset( dest, 0, 8 );
+    BitWriter writer( dest );
+    writer.write( color0, 16 );
+    writer.write( color1, 16 );
+    for( int i = 0; i < NUM_TEXELS; ++i )
+        writer.write( indices[i], 2 );
+}
+
+void decompressBC1( const unsigned char* block, float4 texels[NUM_TEXELS] )
+{
+    BitReader          reader( block );
+    const unsigned int color0 = reader.read( 16 );
+    const unsigned int color1 = reader.read( 16 );
+    float              palette[4][4];
+    makeBC1Palette( color0, color1, palette );
+    for( int i = 0; i < NUM_TEXELS; ++i )
+    {
+        const float* color = palette[reader.read( 2 )];
+        texels[i]          = float4{ color[0], color[1], color[2], color[3] };
+    }
+}
+
+//------------------------------------------------------------------------------
+// BC4 and BC5
+
+void makeBC4Palette( unsigned int red0, unsigned int red1, float palette[8][4] )
+{
+    std::memset( palette, 0, 8 * sizeof( palette[0] ) );
+    palette[0][0] = red0 / 255.f;
+    palette[1][0] = red1 / 255.f;
+    if( red0 > red1 )
+    {
+        for( int k = 2; k < 8; ++k )
+            palette[k][0] = ( ( 8 - k ) * palette[0][0] + ( k - 1 ) * palette[1][0] ) / 7.f;
+    }
+    else
+    {
+        for( int k = 2; k < 6; ++k )
+            palette[k][0] = ( ( 6 - k ) * palette[0][0] + ( k - 1 ) * palette[1][0] ) / 5.f;
+        palette[6][0] = 0.f;
+        palette[7][0] = 1.f;
+    }
+}
+
+// Compress one channel of the texels.
+void compressBC4( const float4 texels[NUM_TEXELS], int channel, unsigned char* dest )
+{
+    Points points;
+    float  lo = 1.f;
+    float  hi = 0.f;
+    for( int i = 0; i < NUM_TEXELS; ++i )
+    {
+        const float* texel = reinterpret_cast<const float*>( &texels[i] );
+        points[i][0]       = clamp01( texel[channel] );
+        lo                 = std::min( lo, points[i][0] );
+        hi                 = std::max( hi, points[i][0] );
+    }
+
+    // Use the eight-value mode, which requires red0 > red1, unless the block is uniform.
+    const unsigned int red0 = static_cast<unsigned int>( hi * 255.f + 0.5f );
+    const unsigned int red1 = static_cast<unsigned int>( lo * 255.f + 0.5f );
+    float              palette[8][4];
+    makeBC4Palette( red0, red1, palette );
+    const int paletteSize = red0 > red1 ? 8 : 1;
+
+    std::memset( dest, 0, 8 );
+    BitWriter writer( dest );
+    writer.write( red0, 8 );
+    writer.write( red1, 8 );
+    int indices[NUM_TEXELS];
+    chooseIndices( points, palette, paletteSize, 1, indices );
+    for( int i = 0; i < NUM_TEXELS; ++i )
+        writer.write( indices[i], 3 );
+}
+
+void decompressBC4( const unsigned char* block, int channel, float4 texels[NUM_TEXELS] )
+{
+    BitReader          reader( block );
+    const unsigned int red0 = reader.read( 8 );
+    const unsigned int red1 = reader.read( 8 );
+    float              palette[8][4];
+    makeBC4Palette( red0, red1, palette );
+    for( int i = 0; i < NUM_TEXELS; ++i )
+        reinterpret_cast<float*>( &texels[i] )[channel] = palette[reader.read( 3 )][0];
+}
+
+//------------------------------------------------------------------------------
+// BC6H (unsigned, mode 11)
+//
+// Endpoints and interpolated values live in a 16-bit domain that maps linearly onto half float
+// bit patterns, which makes interpolation roughly logarithmic in the texel values.
+
+const unsigned int BC6H_MODE11 = 0x03;
+
+int unquantizeBC6H( int value )
+{
+    // Unsigned unquantization of a 10-bit endpoint.
+    if( value == 0 )
+        return 0;
+    if( value == 1023 )
+        return 0xffff;
+    return ( ( value << 16 ) + 0x8000 ) >> 10;
+}
+
+int quantizeBC6H( float value )
+{
+    return clampInt( static_cast<int>( std::floor( ( value - 32.f ) / 64.f + 0.5f ) ), 0, 1023 );
+}
+
+void makeBC6HPalette( const int end0[3], const int end1[3], float palette[16][4] )
+{
+    for( int k = 0; k < 16; ++k )
+    {
+        for( int c = 0; c < 3; ++c )
+        {
+            const int a = unquantizeBC6H( end0[c] );
+            const int b = unquantizeBC6H( end1[c] );
+            palette[k][c] = static_cast<float>( ( ( 64 - WEIGHTS4[k] ) * a + WEIGHTS4[k] * b + 32 ) >> 6 );
+        }
+        palette[k][3] = 0.f;
+    }
+}
+
+void compressBC6H( const float4 texels[NUM_TEXELS], unsigned char* dest )
+{
+    float values[NUM_TEXELS * 3];
+    for( int i = 0; i < NUM_TEXELS; ++i )
+    {
+        const float* texel = reinterpret_cast<const float*>( &texels[i] );
+        for( int c = 0; c < 3; ++c )
+            values[i * 3 + c] = texel[c] > 0.f ? std::min( texel[c], 65504.f ) : 0.f;
+    }
+    std::uint16_t halves[NUM_TEXELS * 3];
+    convertFloatToHalf( values, NUM_TEXELS * 3, reinterpret_cast<half*>( halves ) );
+
+    // The decoder scales interpolated values by 31/64 to obtain half bit patterns, so invert that.
+    Points points;
+    for( int i = 0; i < NUM_TEXELS; ++i )
+    {
+        for( int c = 0; c < 3; ++c )
+            points[i][c] = halves[i * 3 + c] * ( 64.f / 31.f );
+        points[i][3] = 0.f;
+    }
+
+    float lo[4], hi[4];
+    fitPrincipalAxis( points, 3, lo, hi );
+    int end0[3], end1[3];
+    for( int c = 0; c < 3; ++c )
+    {
+        end0[c] = quantizeBC6H( lo[c] );
+        end1[c] = quantizeBC6H( hi[c] );
+    }
+
+    float palette[16][4];
+    makeBC6HPalette( end0, end1, palette );
+    int indices[NUM_TEXELS];
+    chooseIndices( points, palette, 16, 3, indices );
+
+    // The most significant bit of the first index is implicitly zero.
+    if( indices[0] >= 8 )
+    {
+        std::swap( end0, end1 );
+        for( int& index : indices )
+            index = 15 - index;
+    }
+
+    std::memset( dest, 0, 16 );
+    BitWriter writer( dest );
+    writer.write( BC6H_MODE11, 5 );
+    for( int c = 0; c < 3; ++c )
+        writer.write( end0[c], 10 );
+    for( int c = 0; c < 3; ++c )
+        writer.write( end1[c], 10 );
+    for( int i = 0; i < NUM_TEXELS; ++i )
+        writer.write( indices[i], i == 0 ? 3 : 4 );
+}
+
+bool decompressBC6H( const unsigned char* block, float4 texels[NUM_TEXELS] )
+{
+    BitReader reader( block );
+    if( reader.read( 5 ) != BC6H_MODE11 )
+        return false;
+    int end0[3], end1[3];
+    for( int c = 0; c < 3; ++c )
+        end0[c] = reader.read( 10 );
+    for( int c = 0; c < 3; ++c )
+        end1[c] = reader.read( 10 );
+    float palette[16][4];
+    makeBC6HPalette( end0, end1, palette );
+    std::uint16_t halves[NUM_TEXELS * 3];
+    for( int i = 0; i < NUM_TEXELS; ++i )
+    {
+        const float* entry = palette[reader.read( i == 0 ? 3 : 4 )];
+        for( int c = 0; c < 3; ++c )
+            halves[i * 3 + c] = static_cast<std::uint16_t>( ( static_cast<unsigned int>( entry[c] ) * 31 ) >> 6 );
+    }
+    float rgb[NUM_TEXELS * 3];
+    convertHalfToFloat( reinterpret_cast<const half*>( halves ), NUM_TEXELS * 3, rgb );
+    for( int i = 0; i < NUM_TEXELS; ++i )
+        texels[i] = float4{ rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], 1.f };
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// BC7 (mode 6)
+
+const unsigned int BC7_MODE6 = 1 << 6;
+
+void makeBC7Palette( const int end0[4], const int end1[4], float palette[16][4] )
+{
+    for( int k = 0; k < 16; ++k )
+        for( int c = 0; c < 4; ++c )
+            palette[k][c] = static_cast<float>( ( ( 64 - WEIGHTS4[k] ) * end0[c] + WEIGHTS4[k] * end1[c] + 32 ) >> 6 );
+}
+
+void compressBC7( const float4 texels[NUM_TEXELS], unsigned char* dest )
+{
+    Points points;
+    for( int i = 0; i < NUM_TEXELS; ++i )
+    {
+        points[i][0] = clamp01( texels[i].x ) * 255.f;
+        points[i][1] = clamp01( texels[i].y ) * 255.f;
+        points[i][2] = clamp01( texels[i].z ) * 255.f;
+        points[i][3] = clamp01( texels[i].w ) * 255.f;
+    }
+
+    float lo[4], hi[4];
+    fitPrincipalAxis( points, 4, lo, hi );
+
+    // Try each combination of p-bits, which supply the least significant bit of each endpoint.
+    int   bestQuant0[4] = {}, bestQuant1[4] = {}, bestIndices[NUM_TEXELS] = {};
+    int   bestPbit0 = 0, bestPbit1 = 0;
+    float bestError = 0.f;
+    for( int combo = 0; combo < 4; ++combo )
+    {
+        const int pbit0 = combo & 1;
+        const int pbit1 = combo >> 1;
+        int       quant0[4], quant1[4], end0[4], end1[4];
+        for( int c = 0; c < 4; ++c )
+        {
+            quant0[c] = clampInt( static_cast<int>( std::floor( ( lo[c] - pbit0 ) / 2.f + 0.5f ) ), 0, 127 );
+            quant1[c] = clampInt( static_cast<int>( std::floor( ( hi[c] - pbit1 ) / 2.f + 0.5f ) ), 0, 127 );
+            end0[c]   = ( quant0[c] << 1 ) | pbit0;
+            end1[c]   = ( quant1[c] << 1 ) | pbit1;
+        }
+        float palette[16][4];
+        makeBC7Palette( end0, end1, palette );
+        int         indices[NUM_TEXELS];
+        const float error = chooseIndices( points, palette, 16, 4, indices );
+
+        if( combo == 0 || error < bestError )
+        {
+            bestError = error;
+            bestPbit0 = pbit0;
+            bestPbit1 = pbit1;
+            std::copy( quant0, quant0 + 4, bestQuant0 );
+            std::copy( quant1, quant1 + 4, bestQuant1 );
+            std::copy( indices, indices + NUM_TEXELS, bestIndices );
+        }
+    }
+
+    // The most significant bit of the first index is implicitly zero.
+    if( bestIndices[0] >= 8 )
+    {
+        std::swap( bestQuant0, bestQuant1 );
+        std::swap( bestPbit0, bestPbit1 );
+        for( int& index : bestIndices )
+            index = 15 - index;
+    }
+
+    std::memset( dest, 0, 16 );
+    BitWriter writer( dest );
+    writer.write( BC7_MODE6, 7 );
+    for( int c = 0; c < 4; ++c )
+    {
+        writer.write( bestQuant0[c], 7 );
+        writer.write( bestQuant1[c], 7 );
+    }
+    writer.write( bestPbit0, 1 );
+    writer.write( bestPbit1, 1 );
+    for( int i = 0; i < NUM_TEXELS; ++i )
+        writer.write( bestIndices[i], i == 0 ? 3 : 4 );
+}
+
+bool decompressBC7( const unsigned char* block, float4 texels[NUM_TEXELS] )
+{
+    BitReader reader( block );
+    if( reader.read( 7 ) != BC7_MODE6 )
+        return false;
+    int end0[4], end1[4];
+    for( int c = 0; c < 4; ++c )
+    {
+        end0[c] = reader.read( 7 ) << 1;
+        end1[c] = reader.read( 7 ) << 1;
+    }
+    const int pbit0 = reader.read( 1 );
+    const int pbit1 = reader.read( 1 );
+    for( int c = 0; c < 4; ++c )
+    {
+        end0[c] |= pbit0;
+        end1[c] |= pbit1;
+    }
+    float palette[16][4];
+    makeBC7Palette( end0, end1, palette );
+    for( int i = 0; i < NUM_TEXELS; ++i )
+    {
+        const float* entry = palette[reader.read( i == 0 ? 3 : 4 )];
+        texels[i]          = float4{ entry[0] / 255.f, entry[1] / 255.f, entry[2] / 255.f, entry[3] / 255.f };
+    }
+    return true;
+}
+
+}  // namespace
+
+bool canCompressBlocks( CUarray_format format )
+{
+    switch( format )
+    {
+#if CUDA_VERSION >= 11050
+        case CU_AD_FORMAT_BC1_UNORM:
+        case CU_AD_FORMAT_BC1_UNORM_SRGB:
+        case CU_AD_FORMAT_BC4_UNORM:
+        case CU_AD_FORMAT_BC5_UNORM:
+        case CU_AD_FORMAT_BC6H_UF16:
+        case CU_AD_FORMAT_BC7_UNORM:
+        case CU_AD_FORMAT_BC7_UNORM_SRGB:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+void compressBlock( CUarray_format format, const float4 texels[16], void* dest )
+{
+    unsigned char* block = static_cast<unsigned char*>( dest );
+    switch( format )
+    {
+#if CUDA_VERSION >= 11050
+        case CU_AD_FORMAT_BC1_UNORM:
+        case CU_AD_FORMAT_BC1_UNORM_SRGB:
+            compressBC1( texels, block );
+            return;
+        case CU_AD_FORMAT_BC4_UNORM:
+            compressBC4( texels, 0, block );
+            return;
+        case CU_AD_FORMAT_BC5_UNORM:
+            compressBC4( texels, 0, block );
+            compressBC4( texels, 1, block + 8 );
+            return;
+        case CU_AD_FORMAT_BC6H_UF16:
+            compressBC6H( texels, block );
+            return;
+        case CU_AD_FORMAT_BC7_UNORM:
+        case CU_AD_FORMAT_BC7_UNORM_SRGB:
+            compressBC7( texels, block );
+            return;
+#endif
+        default:
+            OTK_ASSERT_MSG( false, "Unsupported block-compressed format" );
+    }
+}
+
+void compressImage( CUarray_format format, const float4* texels, unsigned int width, unsigned int height, void* dest )
+{
+    const unsigned int blockSize = getBytesPerBlock( format, 0 );
+    unsigned char*     block     = static_cast<unsigned char*>( dest );
+    float4             blockTexels[NUM_TEXELS];
+    for( unsigned int y = 0; y < height; y += 4 )
+    {
+        for( unsigned int x = 0; x < width; x += 4 )
+        {
+            for( unsigned int j = 0; j < 4; ++j )
+            {
+                const float4* row = texels + static_cast<size_t>( std::min( y + j, height - 1 ) ) * width;
+                for( unsigned int i = 0; i < 4; ++i )
+                    blockTexels[j * 4 + i] = row[std::min( x + i, width - 1 )];
+            }
+            compressBlock( format, blockTexels, block );
+            block += blockSize;
+        }
+    }
+}
+
+bool decompressBlock( CUarray_format format, const void* block, float4 texels[16] )
+{
+    const unsigned char* src = static_cast<const unsigned char*>( block );
+    switch( format )
+    {
+#if CUDA_VERSION >= 11050
+        case CU_AD_FORMAT_BC1_UNORM:
+        case CU_AD_FORMAT_BC1_UNORM_SRGB:
+            decompressBC1( src, texels );
+            return true;
+        case CU_AD_FORMAT_BC4_UNORM:
+        case CU_AD_FORMAT_BC5_UNORM:
+            std::fill( texels, texels + NUM_TEXELS, float4{ 0.f, 0.f, 0.f, 1.f } );
+            decompressBC4( src, 0, texels );
+            if( format == CU_AD_FORMAT_BC5_UNORM )
+                decompressBC4( src + 8, 1, texels );
+            return true;
+        case CU_AD_FORMAT_BC6H_UF16:
+            return decompressBC6H( src, texels );
+        case CU_AD_FORMAT_BC7_UNORM:
+        case CU_AD_FORMAT_BC7_UNORM_SRGB:
+            return decompressBC7( src, texels );
+#endif
+        default:
+            return false;
+    }
+}
+
+}  // namespace imageSource
@@ -0,0 +1,388 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/BlockImageReader.h>
+
+#include <OptiXToolkit/Error/ErrorCheck.h>
+#include <OptiXToolkit/ImageSource/BlockCompression.h>
+
+#include "RandomAccessFile.h"
+#include "ReadQueue.h"
+#include "Stopwatch.h"
+
+#include <cuda_fp16.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+namespace imageSource {
+
+namespace {
+
+unsigned int divideRoundUp( unsigned int value, unsigned int divisor )
+{
+    return ( value + divisor - 1 ) / divisor;
+}
+
+// Convert the first pixel of an uncompressed image to RGBA.  Missing channels are zero, except
+// alpha, which is one.
+template <typename T>
+float4 toFloat4( const char* src, unsigned int numChannels, float scale )
+{
+    const T* channels = reinterpret_cast<const T*>( src );
+    float    rgba[4]  = { 0.f, 0.f, 0.f, 1.f };
+    for( unsigned int c = 0; c < std::min( numChannels, 4U ); ++c )
+        rgba[c] = static_cast<float>( channels[c] ) * scale;
+    return float4{ rgba[0], rgba[1], rgba[2], rgba[3] };
+}
+
+}  // namespace
+
+struct BlockImageReader::ReadStats
+{
+    std::mutex         mutex;
+    unsigned long long numTilesRead  = 0;
+    unsigned long long numBytesRead  = 0;
+    double             totalReadTime = 0.0;
+
+    void record( unsigned long long numTiles, unsigned long long numBytes, double time )
+    {
+        std::unique_lock<std::mutex> lock( mutex );
+        numTilesRead += numTiles;
+        numBytesRead += numBytes;
+        totalReadTime += time;
+    }
+};
+
+BlockImageReader::BlockImageReader( const std::string& filename )
+    : m_filename( filename )
+    , m_stats( new ReadStats )
+{
+}
+
+BlockImageReader::~BlockImageReader() = default;
+
+void BlockImageReader::throwError( const std::string& message ) const
+{
+    throw std::runtime_error( m_filename + ": " + message );
+}
+
+void BlockImageReader::open( TextureInfo* info )
+{
+    std::unique_lock<std::mutex> lock( m_initMutex );
+    if( !isOpen() )
+    {
+        m_info   = TextureInfo{};
+        m_isSRGB = false;
+        m_compressedLevelSizes.clear();
+        std::shared_ptr<RandomAccessFile> file( new RandomAccessFile );
+        if( !file->open( m_filename ) )
+            throwError( "cannot open file" );
+
+        std::vector<unsigned long long> levelOffsets;
+        readHeader( *file, m_info, levelOffsets );
+        if( m_info.width == 0 || m_info.height == 0 || m_info.numChannels == 0 )
+            throwError( "invalid image dimensions" );
+        if( m_info.numMipLevels == 0 || m_info.numMipLevels != levelOffsets.size()
+            || m_info.numMipLevels > calculateNumMipLevels( m_info.width, m_info.height ) )
+            throwError( "invalid number of mip levels" );
+        if( isSupercompressed() && m_compressedLevelSizes.size() != m_info.numMipLevels )
+            throwError( "invalid number of supercompressed mip levels" );
+        m_levelOffsets = std::move( levelOffsets );
+
+        // Make sure every mip level is present, so that reads cannot fail later.
+        for( unsigned int mipLevel = 0; mipLevel < m_info.numMipLevels; ++mipLevel )
+        {
+            const unsigned long long offset = m_levelOffsets[mipLevel];
+            const unsigned long long size = isSupercompressed() ? m_compressedLevelSizes[mipLevel] : getLevelSize( mipLevel );
+            if( offset > file->size() || size > file->size() - offset )
+                throwError( "file is truncated" );
+        }
+        {
+            std::unique_lock<std::mutex> levelLock( m_levelMutex );
+            m_decompressedLevels.assign( isSupercompressed() ? m_info.numMipLevels : 0, nullptr );
+        }
+        m_info.isValid = true;
+        m_info.isTiled = true;
+        m_file         = std::move( file );
+    }
+    if( info != nullptr )
+        *info = m_info;
+}
+
+void BlockImageReader::close()
+{
+    std::unique_lock<std::mutex> lock( m_initMutex );
+    m_file.reset();
+    std::unique_lock<std::mutex> levelLock( m_levelMutex );
+    m_decompressedLevels.clear();
+}
+
+bool BlockImageReader::isOpen() const
+{
+    return m_file && m_file->isOpen();
+}
+
+unsigned int BlockImageReader::getLevelWidth( unsigned int mipLevel ) const
+{
+    return std::max( 1U, m_info.width >> mipLevel );
+}
+
+unsigned int BlockImageReader::getLevelHeight( unsigned int mipLevel ) const
+{
+    return std::max( 1U, m_info.height >> mipLevel );
+}
+
+size_t BlockImageReader::getLevelSize( unsigned int mipLevel ) const
+{
+    return getImageSizeInBytes( m_info.format, m_info.numChannels, getLevelWidth( mipLevel ), getLevelHeight( mipLevel ) );
+}
+
+void BlockImageReader::readBytes( void* dest, size_t numBytes, unsigned long long offset ) const
+{
+    if( !m_file->read( dest, numBytes, offset ) )
+        throwError( "read failed" );
+}
+
+void BlockImageReader::decompressLevel( const char* /*src*/, size_t /*srcSize*/, char* /*dest*/, size_t /*destSize*/ ) const
+{
+    throwError( "unsupported supercompression" );
+}
+
+std::shared_ptr<const std::vector<char>> BlockImageReader::getDecompressedLevel( unsigned int mipLevel )
+{
+    {
+        std::unique_lock<std::mutex> lock( m_levelMutex );
+        if( m_decompressedLevels[mipLevel] )
+            return m_decompressedLevels[mipLevel];
+    }
+
+    // Decompress outside the lock, so that other levels can be read meanwhile.  Threads that race
+    // to decompress the same level keep whichever result is stored first.
+    Stopwatch         stopwatch;
+    std::vector<char> compressed( m_compressedLevelSizes[mipLevel] );
+    readBytes( compressed.data(), compressed.size(), m_levelOffsets[mipLevel] );
+    std::shared_ptr<std::vector<char>> level( new std::vector<char>( getLevelSize( mipLevel ) ) );
+    decompressLevel( compressed.data(), compressed.size(), level->data(), level->size() );
+    m_stats->record( 0, compressed.size(), stopwatch.elapsed() );
+
+    std::unique_lock<std::mutex> lock( m_levelMutex );
+    if( !m_decompressedLevels[mipLevel] )
+        m_decompressedLevels[mipLevel] = level;
+    return m_decompressedLevels[mipLevel];
+}
+
+void BlockImageReader::readLevelBytes( void* dest, unsigned int mipLevel, size_t numBytes, size_t offsetInLevel )
+{
+    if( isSupercompressed() )
+        std::memcpy( dest, getDecompressedLevel( mipLevel )->data() + offsetInLevel, numBytes );
+    else
+        readBytes( dest, numBytes, m_levelOffsets[mipLevel] + offsetInLevel );
+}
+
+bool BlockImageReader::getTileReads( char* dest, unsigned int mipLevel, const Tile& tile, std::vector<FileRead>& reads, size_t& numBytes ) const
+{
+    OTK_ASSERT_MSG( isOpen(), "Attempt to read from an image that is not open." );
+    OTK_ASSERT_MSG( mipLevel < m_info.numMipLevels, "Attempt to read from non-existent mip-level." );
+
+    const PixelPosition start       = pixelPosition( tile );
+    const unsigned int  levelWidth  = getLevelWidth( mipLevel );
+    const unsigned int  levelHeight = getLevelHeight( mipLevel );
+    if( start.x >= levelWidth || start.y >= levelHeight )
+        return false;
+
+    // Work in units of blocks, which are single texels for uncompressed formats.
+    const unsigned int blockDim           = getBlockDim( m_info.format );
+    const size_t       blockSize          = getBytesPerBlock( m_info.format, m_info.numChannels );
+    const unsigned int levelWidthInBlocks = divideRoundUp( levelWidth, blockDim );
+    const unsigned int startX             = start.x / blockDim;
+    const unsigned int startY             = start.y / blockDim;
+    const unsigned int tileWidth          = divideRoundUp( tile.width, blockDim );
+    const unsigned int tileHeight         = divideRoundUp( tile.height, blockDim );
+    const unsigned int copyWidth          = std::min( tileWidth, levelWidthInBlocks - startX );
+    const unsigned int copyHeight         = std::min( tileHeight, divideRoundUp( levelHeight, blockDim ) - startY );
+    const size_t       destPitch          = tileWidth * blockSize;
+    const size_t       srcPitch           = levelWidthInBlocks * blockSize;
+
+    if( copyWidth < tileWidth || copyHeight < tileHeight )
+        std::memset( dest, 0, destPitch * tileHeight );
+
+    reads.clear();
+    const unsigned long long offset = m_levelOffsets[mipLevel] + startY * srcPitch + startX * blockSize;
+    if( copyWidth == levelWidthInBlocks && destPitch == srcPitch )
+    {
+        // The tile spans whole rows of the level, so its rows are contiguous in the file.
+        reads.push_back( FileRead{ dest, copyHeight * srcPitch, offset } );
+    }
+    else
+    {
+        for( unsigned int y = 0; y < copyHeight; ++y )
+            reads.push_back( FileRead{ dest + y * destPitch, copyWidth * blockSize, offset + y * srcPitch } );
+    }
+    numBytes = copyWidth * copyHeight * blockSize;
+    return true;
+}
+
+bool BlockImageReader::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream /*stream*/ )
+{
+    Stopwatch             stopwatch;
+    std::vector<FileRead> reads;
+    size_t                numBytes;
+    if( !getTileReads( dest, mipLevel, tile, reads, numBytes ) )
+        return false;
+    if( isSupercompressed() )
+    {
+        // Copy the rows of the tile from the decompressed level rather than the file.
+        std::shared_ptr<const std::vector<char>> level = getDecompressedLevel( mipLevel );
+        for( const FileRead& read : reads )
+            std::memcpy( read.dest, level->data() + ( read.offset - m_levelOffsets[mipLevel] ), read.size );
+        m_stats->record( 1, 0, stopwatch.elapsed() );
+        return true;
+    }
+    if( !m_file->read( reads.data(), reads.size() ) )
+        throwError( "read failed" );
+    m_stats->record( 1, numBytes, stopwatch.elapsed() );
+    return true;
+}
+
+std::future<bool> BlockImageReader::readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    // Supercompressed tiles are copied from the decompressed level, which is read synchronously.
+    if( isSupercompressed() )
+        return ImageSourceBase::readTileAsync( dest, mipLevel, tile, stream );
+
+    std::shared_ptr<std::promise<bool>> result( new std::promise<bool> );
+    std::future<bool>                   future = result->get_future();
+    std::vector<FileRead>               reads;
+    size_t                              numBytes;
+    if( !getTileReads( dest, mipLevel, tile, reads, numBytes ) )
+    {
+        result->set_value( false );
+        return future;
+    }
+
+    // The completion runs on an I/O thread, and may run after the reader is destroyed, so it
+    // retains the file and the statistics rather than the reader.
+    std::shared_ptr<Stopwatch> stopwatch( new Stopwatch );
+    std::shared_ptr<ReadStats> stats    = m_stats;
+    const std::string          filename = m_filename;
+    ReadQueue::getInstance().submit( m_file, std::move( reads ), [result, stopwatch, stats, filename, numBytes]( bool ok ) {
+        if( !ok )
+        {
+            result->set_exception( std::make_exception_ptr( std::runtime_error( filename + ": read failed" ) ) );
+            return;
+        }
+        stats->record( 1, numBytes, stopwatch->elapsed() );
+        result->set_value( true );
+    } );
+    return future;
+}
+
+bool BlockImageReader::readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream /*stream*/ )
+{
+    OTK_ASSERT_MSG( isOpen(), "Attempt to read from an image that is not open." );
+    OTK_ASSERT_MSG( mipLevel < m_info.numMipLevels, "Attempt to read from non-existent mip-level." );
+    OTK_ASSERT_MSG( expectedWidth == getLevelWidth( mipLevel ) && expectedHeight == getLevelHeight( mipLevel ),
+                    "Unexpected mip level dimensions." );
+
+    Stopwatch    stopwatch;
+    const size_t size = getLevelSize( mipLevel );
+    readLevelBytes( dest, mipLevel, size, 0 );
+    m_stats->record( 0, isSupercompressed() ? 0 : size, stopwatch.elapsed() );
+    return true;
+}
+
+bool BlockImageReader::readMipTail( char*        dest,
+                                    unsigned int mipTailFirstLevel,
+                                    unsigned int numMipLevels,
+                                    const uint2* mipLevelDims,
+                                    unsigned int /*pixelSizeInBytes*/,
+                                    CUstream     stream )
+{
+    OTK_ASSERT_MSG( isOpen(), "Attempt to read from an image that is not open." );
+    numMipLevels = std::min( numMipLevels, m_info.numMipLevels );
+    if( mipTailFirstLevel >= numMipLevels )
+        return false;
+
+    // When the levels of the tail are stored consecutively (as in DDS files), read them at once.
+    size_t tailSize     = getLevelSize( mipTailFirstLevel );
+    bool   isContiguous = !isSupercompressed();
+    for( unsigned int mipLevel = mipTailFirstLevel + 1; mipLevel < numMipLevels; ++mipLevel )
+    {
+        isContiguous = isContiguous && m_levelOffsets[mipLevel] == m_levelOffsets[mipTailFirstLevel] + tailSize;
+        tailSize += getLevelSize( mipLevel );
+    }
+    if( isContiguous )
+    {
+        Stopwatch stopwatch;
+        readBytes( dest, tailSize, m_levelOffsets[mipTailFirstLevel] );
+        m_stats->record( 0, tailSize, stopwatch.elapsed() );
+        return true;
+    }
+
+    size_t offset = 0;
+    for( unsigned int mipLevel = mipTailFirstLevel; mipLevel < numMipLevels; ++mipLevel )
+    {
+        const uint2 levelDims = mipLevelDims[mipLevel];
+        readMipLevel( dest + offset, mipLevel, levelDims.x, levelDims.y, stream );
+        offset += getLevelSize( mipLevel );
+    }
+    return true;
+}
+
+bool BlockImageReader::readBaseColor( float4& dest )
+{
+    OTK_ASSERT_MSG( isOpen(), "Attempt to read from an image that is not open." );
+    const unsigned int lastLevel = m_info.numMipLevels - 1;
+    if( getLevelWidth( lastLevel ) != 1 || getLevelHeight( lastLevel ) != 1 )
+        return false;
+
+    char buffer[16];
+    readLevelBytes( buffer, lastLevel, getLevelSize( lastLevel ), 0 );
+    if( isBlockCompressed( m_info.format ) )
+    {
+        float4 texels[16];
+        if( !decompressBlock( m_info.format, buffer, texels ) )
+            return false;
+        dest = texels[0];
+        return true;
+    }
+    switch( m_info.format )
+    {
+        case CU_AD_FORMAT_UNSIGNED_INT8:
+            dest = toFloat4<std::uint8_t>( buffer, m_info.numChannels, 1.f / 255.f );
+            return true;
+        case CU_AD_FORMAT_HALF:
+            dest = toFloat4<half>( buffer, m_info.numChannels, 1.f );
+            return true;
+        case CU_AD_FORMAT_FLOAT:
+            dest = toFloat4<float>( buffer, m_info.numChannels, 1.f );
+            return true;
+        default:
+            return false;
+    }
+}
+
+unsigned long long BlockImageReader::getNumTilesRead() const
+{
+    std::unique_lock<std::mutex> lock( m_stats->mutex );
+    return m_stats->numTilesRead;
+}
+
+unsigned long long BlockImageReader::getNumBytesRead() const
+{
+    std::unique_lock<std::mutex> lock( m_stats->mutex );
+    return m_stats->numBytesRead;
+}
+
+double BlockImageReader::getTotalReadTime() const
+{
+    std::unique_lock<std::mutex> lock( m_stats->mutex );
+    return m_stats->totalReadTime;
+}
+
+}  // namespace imageSource
@@ -0,0 +1,136 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/CompressingImageSource.h>
+
+#include "ScratchBuffer.h"
+
+#include <OptiXToolkit/Error/ErrorCheck.h>
+#include <OptiXToolkit/ImageSource/BlockCompression.h>
+#include <OptiXToolkit/ImageSource/FormatConversion.h>
+
+#include <utility>
+#include <vector>
+
+namespace imageSource {
+
+namespace {
+
+// Tags of the per-thread scratch buffers.
+struct SourceBuffer;
+struct TexelBuffer;
+
+}  // namespace
+
+CUarray_format chooseBlockCompressedFormat( const TextureInfo& info )
+{
+    if( isBlockCompressed( info.format ) )
+        return info.format;
+#if CUDA_VERSION >= 11050
+    if( info.numChannels == 1 )
+        return CU_AD_FORMAT_BC4_UNORM;
+    if( info.numChannels == 2 )
+        return CU_AD_FORMAT_BC5_UNORM;
+    if( info.format == CU_AD_FORMAT_HALF || info.format == CU_AD_FORMAT_FLOAT )
+        return CU_AD_FORMAT_BC6H_UF16;
+    return CU_AD_FORMAT_BC7_UNORM;
+#else
+    OTK_ASSERT_MSG( false, "Block-compressed formats require CUDA 11.5" );
+    return info.format;
+#endif
+}
+
+CompressingImageSource::CompressingImageSource( std::shared_ptr<ImageSource> imageSource, CUarray_format compressedFormat )
+    : WrappedImageSource( std::move( imageSource ) )
+    , m_compressedFormat( compressedFormat )
+{
+    OTK_ASSERT_MSG( canCompressBlocks( compressedFormat ), "Unsupported block-compressed format" );
+}
+
+void CompressingImageSource::open( TextureInfo* info )
+{
+    WrappedImageSource::open( &m_sourceInfo );
+    m_info          = m_sourceInfo;
+    m_isCompressing = m_sourceInfo.isValid && !isBlockCompressed( m_sourceInfo.format );
+    if( m_isCompressing )
+    {
+        OTK_ASSERT_MSG( WrappedImageSource::getFillType() == CU_MEMORYTYPE_HOST,
+                        "CompressingImageSource requires an image that fills host memory" );
+        m_info.format      = m_compressedFormat;
+        m_info.numChannels = getNumChannelsInBlockFormat( m_compressedFormat );
+    }
+    if( info != nullptr )
+        *info = m_info;
+}
+
+const TextureInfo& CompressingImageSource::getInfo() const
+{
+    return m_info;
+}
+
+void CompressingImageSource::compress( const char* src, unsigned int width, unsigned int height, char* dest ) const
+{
+    const size_t         numPixels = static_cast<size_t>( width ) * height;
+    std::vector<float4>& texels    = getScratchBuffer<TexelBuffer, float4>( numPixels );
+    OutputFormat         rgba;
+    rgba.numChannels = 4;
+    convertPixels( src, m_sourceInfo.format, m_sourceInfo.numChannels, numPixels, rgba, texels.data() );
+    compressImage( m_compressedFormat, texels.data(), width, height, dest );
+}
+
+bool CompressingImageSource::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    if( !m_isCompressing )
+        return WrappedImageSource::readTile( dest, mipLevel, tile, stream );
+
+    std::vector<char>& src =
+        getScratchBuffer<SourceBuffer>( getImageSizeInBytes( m_sourceInfo.format, m_sourceInfo.numChannels, tile.width, tile.height ) );
+    if( !WrappedImageSource::readTile( src.data(), mipLevel, tile, stream ) )
+        return false;
+    compress( src.data(), tile.width, tile.height, dest );
+    return true;
+}
+
+std::future<bool> CompressingImageSource::readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    if( !m_isCompressing )
+        return WrappedImageSource::readTileAsync( dest, mipLevel, tile, stream );
+    return ImageSource::readTileAsync( dest, mipLevel, tile, stream );
+}
+
+bool CompressingImageSource::readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream )
+{
+    if( !m_isCompressing )
+        return WrappedImageSource::readMipLevel( dest, mipLevel, expectedWidth, expectedHeight, stream );
+
+    std::vector<char>& src =
+        getScratchBuffer<SourceBuffer>( getImageSizeInBytes( m_sourceInfo.format, m_sourceInfo.numChannels, expectedWidth, expectedHeight ) );
+    if( !WrappedImageSource::readMipLevel( src.data(), mipLevel, expectedWidth, expectedHeight, stream ) )
+        return false;
+    compress( src.data(), expectedWidth, expectedHeight, dest );
+    return true;
+}
+
+bool CompressingImageSource::readMipTail( char*        dest,
+                                          unsigned int mipTailFirstLevel,
+                                          unsigned int numMipLevels,
+                                          const uint2* mipLevelDims,
+                                          unsigned int pixelSizeInBytes,
+                                          CUstream     stream )
+{
+    if( !m_isCompressing )
+        return WrappedImageSource::readMipTail( dest, mipTailFirstLevel, numMipLevels, mipLevelDims, pixelSizeInBytes, stream );
+
+    size_t offset = 0;
+    for( unsigned int mipLevel = mipTailFirstLevel; mipLevel < numMipLevels; ++mipLevel )
+    {
+        const uint2 levelDims = mipLevelDims[mipLevel];
+        if( !readMipLevel( dest + offset, mipLevel, levelDims.x, levelDims.y, stream ) )
+            return false;
+        offset += getImageSizeInBytes( m_info.format, m_info.numChannels, levelDims.x, levelDims.y );
+    }
+    return true;
+}
+
+}  // namespace imageSource
@@ -0,0 +1,186 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/ConvertingImageSource.h>
+
+#include "ScratchBuffer.h"
+
+#include <OptiXToolkit/Error/ErrorCheck.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace imageSource {
+
+namespace {
+
+// Tag of the per-thread scratch buffer holding source texels.
+struct SourceBuffer;
+
+bool isConvertibleFormat( CUarray_format format )
+{
+    return format == CU_AD_FORMAT_UNSIGNED_INT8 || format == CU_AD_FORMAT_UNSIGNED_INT16 || format == CU_AD_FORMAT_HALF
+           || format == CU_AD_FORMAT_FLOAT;
+}
+
+}  // namespace
+
+ConvertingImageSource::ConvertingImageSource( std::shared_ptr<ImageSource> imageSource, const OutputFormat& outputFormat )
+    : WrappedImageSource( std::move( imageSource ) )
+    , m_outputFormat( outputFormat )
+{
+    OTK_ASSERT_MSG( isValidOutputFormat( outputFormat ), "Unsupported output format" );
+}
+
+void ConvertingImageSource::open( TextureInfo* info )
+{
+    WrappedImageSource::open( &m_sourceInfo );
+    m_info         = m_sourceInfo;
+    m_isConverting = m_sourceInfo.isValid && !isBlockCompressed( m_sourceInfo.format )
+                     && isConversionNeeded( m_sourceInfo.format, m_sourceInfo.numChannels, m_outputFormat );
+    if( m_isConverting )
+    {
+        OTK_ASSERT_MSG( isConvertibleFormat( m_sourceInfo.format ), "Unsupported image format for conversion" );
+        OTK_ASSERT_MSG( WrappedImageSource::getFillType() == CU_MEMORYTYPE_HOST,
+                        "ConvertingImageSource requires an image that fills host memory" );
+        m_info.format      = m_outputFormat.format;
+        m_info.numChannels = getNumOutputChannels( m_sourceInfo.numChannels, m_outputFormat );
+    }
+    if( info != nullptr )
+        *info = m_info;
+}
+
+const TextureInfo& ConvertingImageSource::getInfo() const
+{
+    return m_info;
+}
+
+bool ConvertingImageSource::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    if( !m_isConverting )
+        return WrappedImageSource::readTile( dest, mipLevel, tile, stream );
+
+    std::vector<char>& src =
+        getScratchBuffer<SourceBuffer>( getImageSizeInBytes( m_sourceInfo.format, m_sourceInfo.numChannels, tile.width, tile.height ) );
+    if( !WrappedImageSource::readTile( src.data(), mipLevel, tile, stream ) )
+        return false;
+    convertPixels( src.data(), m_sourceInfo.format, m_sourceInfo.numChannels, static_cast<size_t>( tile.width ) * tile.height,
+                   m_outputFormat, dest );
+    return true;
+}
+
+std::future<bool> ConvertingImageSource::readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    if( !m_isConverting )
+        return WrappedImageSource::readTileAsync( dest, mipLevel, tile, stream );
+    return ImageSource::readTileAsync( dest, mipLevel, tile, stream );
+}
+
+bool ConvertingImageSource::readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream )
+{
+    if( !m_isConverting )
+        return WrappedImageSource::readMipLevel( dest, mipLevel, expectedWidth, expectedHeight, stream );
+
+    std::vector<char>& src =
+        getScratchBuffer<SourceBuffer>( getImageSizeInBytes( m_sourceInfo.format, m_sourceInfo.numChannels, expectedWidth, expectedHeight ) );
+    if( !WrappedImageSource::readMipLevel( src.data(), mipLevel, expectedWidth, expectedHeight, stream ) )
+        return false;
+    convertPixels( src.data(), m_sourceInfo.format, m_sourceInfo.numChannels,
+                   static_cast<size_t>( expectedWidth ) * expectedHeight, m_outputFormat, dest );
+    return true;
+}
+
+bool ConvertingImageSource::readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream )
+{
+    if( !m_isConverting )
+        return WrappedImageSource::readScanlines( dest, mipLevel, firstRow, numRows, stream );
+
+    // Rows past the bottom of the level are neither read nor converted.
+    const unsigned int levelWidth  = std::max( m_sourceInfo.width >> mipLevel, 1U );
+    const unsigned int levelHeight = std::max( m_sourceInfo.height >> mipLevel, 1U );
+    numRows                        = firstRow < levelHeight ? std::min( numRows, levelHeight - firstRow ) : 0;
+
+    std::vector<char>& src =
+        getScratchBuffer<SourceBuffer>( getImageSizeInBytes( m_sourceInfo.format, m_sourceInfo.numChannels, levelWidth, numRows ) );
+    if( !WrappedImageSource::readScanlines( src.data(), mipLevel, firstRow, numRows, stream ) )
+        return false;
+    convertPixels( src.data(), m_sourceInfo.format, m_sourceInfo.numChannels, static_cast<size_t>( levelWidth ) * numRows,
+                   m_outputFormat, dest );
+    return true;
+}
+
+bool ConvertingImageSource::readMipTail( char*        dest,
+                                         unsigned int mipTailFirstLevel,
+                                         unsigned int numMipLevels,
+                                         const uint2* mipLevelDims,
+                                         unsigned int pixelSizeInBytes,
+                                         CUstream     stream )
+{
+    if( !m_isConverting )
+        return WrappedImageSource::readMipTail( dest, mipTailFirstLevel, numMipLevels, mipLevelDims, pixelSizeInBytes, stream );
+
+    size_t offset = 0;
+    for( unsigned int mipLevel = mipTailFirstLevel; mipLevel < numMipLevels; ++mipLevel )
+    {
+        const uint2 levelDims = mipLevelDims[mipLevel];
+        if( !readMipLevel( dest + offset, mipLevel, levelDims.x, levelDims.y, stream ) )
+            return false;
+        offset += getImageSizeInBytes( m_info.format, m_info.numChannels, levelDims.x, levelDims.y );
+    }
+    return true;
+}
+
+std::string ConvertingImageSource::getFileVariant() const
+{
+    // The output format describes the converted texels even when the wrapped image is passed
+    // through unchanged, since its texels then already have that format.
+    std::string variant = WrappedImageSource::getFileVariant();
+    if( !variant.empty() )
+        variant += '/';
+    switch( m_outputFormat.format )
+    {
+        case CU_AD_FORMAT_UNSIGNED_INT8:
+            variant += "unorm8";
+            break;
+        case CU_AD_FORMAT_HALF:
+            variant += "half";
+            break;
+        default:
+            variant += "float";
+            break;
+    }
+    // The number of channels is part of the image info, so only the sources of the channels are
+    // listed (all four if the image keeps its number of channels).
+    variant += ':';
+    const unsigned int numChannels = m_outputFormat.numChannels != 0 ? m_outputFormat.numChannels : 4;
+    for( unsigned int c = 0; c < numChannels; ++c )
+    {
+        const int source = m_outputFormat.channels[c];
+        variant += source >= 0 && source < 4 ? "rgba"[source] : '0';
+    }
+    if( m_outputFormat.srgb )
+        variant += ":srgb";
+    return variant;
+}
+
+bool ConvertingImageSource::readBaseColor( float4& dest )
+{
+    float4 color;
+    if( !WrappedImageSource::readBaseColor( color ) )
+        return false;
+    if( !m_isConverting )
+    {
+        dest = color;
+        return true;
+    }
+
+    const float src[4]    = { color.x, color.y, color.z, color.w };
+    float       result[4] = { 0.f, 0.f, 0.f, 1.f };
+    swizzleChannels( src, m_sourceInfo.numChannels, 1, m_outputFormat.channels, m_info.numChannels, result );
+    dest = float4{ result[0], result[1], result[2], result[3] };
+    return true;
+}
+
+}  // namespace imageSource
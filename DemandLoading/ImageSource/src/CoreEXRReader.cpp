@@ -4,6 +4,8 @@
 
 #include <OptiXToolkit/ImageSource/CoreEXRReader.h>
 
+#include "RandomAccessFile.h"
+#include "ScratchBuffer.h"
 #include "Stopwatch.h"
 
 #include <OptiXToolkit/Error/ErrorCheck.h>
@@ -15,12 +17,34 @@
 #include <cmath>
 #include <cstring>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 
 namespace imageSource {
 
+namespace {
+
+unsigned int getBytesPerSample( exr_pixel_type_t type )
+{
+    return type == EXR_PIXEL_HALF ? 2 : 4;
+}
+
+// Tags of the per-thread scratch buffers.  The chunk buffer holds the selected channels of
+// uncompressed chunks.  The partial chunk buffer holds a scanline chunk that is only partly copied
+// to the destination, and is distinct from the chunk buffer, which readChunk uses while decoding.
+struct ChunkBuffer;
+struct PartialChunkBuffer;
+
+}  // namespace
 
 CoreEXRReader::CoreEXRReader( const std::string& filename, bool readBaseColor )
+    : CoreEXRReader( filename, EXRChannelSelection(), readBaseColor )
+{
+}
+
+CoreEXRReader::CoreEXRReader( const std::string& filename, const EXRChannelSelection& selection, bool readBaseColor )
     : m_filename( filename )
+    , m_selection( selection )
     , m_readBaseColor( readBaseColor )
     , m_pixelType( EXR_PIXEL_LAST_TYPE )
 {
@@ -56,6 +80,15 @@ void CoreEXRReader::open( TextureInfo* info )
         cinit.error_handler_fn          = nullptr;
 
         OTK_ERROR_CHECK( exr_start_read( &m_exrCtx, m_filename.c_str(), &cinit ) );
+        try
+        {
+            selectPart();
+        }
+        catch( ... )
+        {
+            close();
+            throw;
+        }
 
         // Get the width and height from the data window of the finest mipLevel.
         exr_attr_box2i_t dw;
@@ -68,6 +101,12 @@ void CoreEXRReader::open( TextureInfo* info )
         OTK_ASSERT_MSG( storageType == EXR_STORAGE_SCANLINE || storageType == EXR_STORAGE_TILED,
                            "CoreEXR Reader doesn't support deep files." );
         m_isScanline = storageType == EXR_STORAGE_SCANLINE;
+        if( m_isScanline )
+        {
+            int scanlinesPerChunk;
+            OTK_ERROR_CHECK( exr_get_scanlines_per_chunk( m_exrCtx, m_partIndex, &scanlinesPerChunk ) );
+            m_scanlinesPerChunk = static_cast<unsigned int>( scanlinesPerChunk );
+        }
 
         // Note that non-power-of-two EXR files often have one fewer miplevel than one would expect
         // (they don't round up from 1+log2(max(width/height))).
@@ -99,16 +138,15 @@ void CoreEXRReader::open( TextureInfo* info )
             }
         }
 
-        // Get channel list.
-        const exr_attr_chlist_t* chlist = nullptr;
-        OTK_ERROR_CHECK( exr_get_channels( m_exrCtx, m_partIndex, &chlist ) );
-        OTK_ASSERT_MSG( chlist->num_channels > 0, "No channels found in EXR file" );
-        OTK_ASSERT_MSG( chlist->num_channels <= 4, "More than four channels found in EXR file" );
-
-        // CUDA textures don't support float3, so we round up to four channels.
-        m_info.numChannels = ( chlist->num_channels == 3 ) ? 4 : chlist->num_channels;
-        m_pixelType        = static_cast<exr_pixel_type_t>( chlist->entries[0].pixel_type );
-        m_info.format      = pixelTypeToArrayFormat( static_cast<exr_pixel_type_t>( m_pixelType ) );
+        try
+        {
+            selectChannels();
+        }
+        catch( ... )
+        {
+            close();
+            throw;
+        }
 
         m_info.isTiled = !m_isScanline;
         m_info.isValid = true;
@@ -152,6 +190,17 @@ void CoreEXRReader::open( TextureInfo* info )
 }
 
 // Close the image.
+std::string CoreEXRReader::getFileVariant() const
+{
+    if( m_selection.part.empty() && m_selection.layer.empty() && m_selection.channels.empty() )
+        return std::string();
+
+    std::string variant = "part=" + m_selection.part + ";layer=" + m_selection.layer + ";channels=";
+    for( size_t i = 0; i < m_selection.channels.size(); ++i )
+        variant += ( i > 0 ? "," : "" ) + m_selection.channels[i];
+    return variant;
+}
+
 void CoreEXRReader::close()
 {
     if( m_exrCtx != nullptr )
@@ -161,6 +210,209 @@ void CoreEXRReader::close()
     m_exrCtx = nullptr;
 }
 
+void CoreEXRReader::selectPart()
+{
+    m_partIndex = 0;
+    if( m_selection.part.empty() )
+        return;
+
+    int numParts = 0;
+    OTK_ERROR_CHECK( exr_get_count( m_exrCtx, &numParts ) );
+    for( int part = 0; part < numParts; ++part )
+    {
+        const char* name = nullptr;
+        if( exr_get_name( m_exrCtx, part, &name ) == EXR_ERR_SUCCESS && name != nullptr && m_selection.part == name )
+        {
+            m_partIndex = part;
+            return;
+        }
+    }
+    throw std::runtime_error( "Part \"" + m_selection.part + "\" not found in EXR file " + m_filename );
+}
+
+void CoreEXRReader::selectChannels()
+{
+    const exr_attr_chlist_t* chlist = nullptr;
+    OTK_ERROR_CHECK( exr_get_channels( m_exrCtx, m_partIndex, &chlist ) );
+    OTK_ASSERT_MSG( chlist->num_channels > 0, "No channels found in EXR file" );
+
+    auto findChannel = [chlist]( const std::string& name ) {
+        for( int c = 0; c < chlist->num_channels; ++c )
+        {
+            if( name == chlist->entries[c].name.str )
+                return c;
+        }
+        return -1;
+    };
+
+    // Resolve the full name of each texture channel.
+    const std::string prefix = m_selection.layer.empty() ? "" : m_selection.layer + ".";
+    m_channelNames.clear();
+    if( !m_selection.channels.empty() )
+    {
+        if( m_selection.channels.size() > 4 )
+            throw std::runtime_error( "At most four channels can be selected from EXR file " + m_filename );
+        for( const std::string& channel : m_selection.channels )
+        {
+            const std::string name = prefix + channel;
+            if( findChannel( name ) < 0 )
+                throw std::runtime_error( "Channel \"" + name + "\" not found in EXR file " + m_filename );
+            if( getOutputChannel( name.c_str() ) >= 0 )
+                throw std::runtime_error( "Channel \"" + name + "\" selected twice from EXR file " + m_filename );
+            m_channelNames.push_back( name );
+        }
+    }
+    else
+    {
+        const char* const rgba[] = { "R", "G", "B", "A" };
+        for( const char* channel : rgba )
+            m_channelNames.push_back( findChannel( prefix + channel ) >= 0 ? prefix + channel : "" );
+
+        // Support luminance-only files, with optional alpha.
+        if( m_channelNames[0].empty() && m_channelNames[1].empty() && m_channelNames[2].empty() && findChannel( prefix + "Y" ) >= 0 )
+            m_channelNames = { prefix + "Y", m_channelNames[3] };
+
+        while( !m_channelNames.empty() && m_channelNames.back().empty() )
+            m_channelNames.pop_back();
+        if( m_channelNames.empty() )
+            throw std::runtime_error( "No RGBA or Y channels found in EXR file " + m_filename + ( prefix.empty() ? "" : " layer " + m_selection.layer ) );
+    }
+
+    // CUDA textures don't support float3, so we round up to four channels.
+    if( m_channelNames.size() == 3 )
+        m_channelNames.push_back( "" );
+    m_hasUnfilledChannels = std::find( m_channelNames.begin(), m_channelNames.end(), "" ) != m_channelNames.end();
+
+    // The selected channels must share a pixel type.
+    m_pixelType = EXR_PIXEL_LAST_TYPE;
+    for( const std::string& name : m_channelNames )
+    {
+        if( name.empty() )
+            continue;
+        const unsigned int pixelType = chlist->entries[findChannel( name )].pixel_type;
+        OTK_ASSERT_MSG( m_pixelType == EXR_PIXEL_LAST_TYPE || m_pixelType == pixelType, "All channels must have same bit depth" );
+        m_pixelType = pixelType;
+    }
+    m_info.numChannels = static_cast<unsigned int>( m_channelNames.size() );
+    m_info.format      = pixelTypeToArrayFormat( static_cast<exr_pixel_type_t>( m_pixelType ) );
+
+    // Locate the selected channels within the lines of uncompressed chunks, which list the samples of
+    // each channel in turn.  If unselected channels can be skipped, the file is read directly.
+    exr_compression_t compression;
+    OTK_ERROR_CHECK( exr_get_compression( m_exrCtx, m_partIndex, &compression ) );
+    bool isSubsampled   = false;
+    m_fileBytesPerPixel = 0;
+    m_chunkChannels.clear();
+    for( int c = 0; c < chlist->num_channels; ++c )
+    {
+        const exr_attr_chlist_entry_t& entry = chlist->entries[c];
+        isSubsampled                         = isSubsampled || entry.x_sampling != 1 || entry.y_sampling != 1;
+        const int outputIndex                = getOutputChannel( entry.name.str );
+        if( outputIndex >= 0 )
+            m_chunkChannels.push_back( ChunkChannel{ static_cast<unsigned int>( outputIndex ), m_fileBytesPerPixel } );
+        m_fileBytesPerPixel += getBytesPerSample( entry.pixel_type );
+    }
+    m_file.reset();
+    if( compression == EXR_COMPRESSION_NONE && !isSubsampled && static_cast<int>( m_chunkChannels.size() ) < chlist->num_channels )
+    {
+        m_file.reset( new RandomAccessFile );
+        if( !m_file->open( m_filename ) )
+            m_file.reset();
+    }
+    if( !m_file )
+        m_chunkChannels.clear();
+}
+
+int CoreEXRReader::getOutputChannel( const char* channelName ) const
+{
+    for( size_t i = 0; i < m_channelNames.size(); ++i )
+    {
+        if( !m_channelNames[i].empty() && m_channelNames[i] == channelName )
+            return static_cast<int>( i );
+    }
+    return -1;
+}
+
+void CoreEXRReader::readChunk( bool isTile, int mipLevel, int tileX, int tileY, char* dest, int rowPitch )
+{
+    // For scanline images, tileY is the first line of the chunk.
+    exr_chunk_info_t cinfo;
+    if( isTile )
+        OTK_ERROR_CHECK( exr_read_tile_chunk_info( m_exrCtx, m_partIndex, tileX, tileY, mipLevel, mipLevel, &cinfo ) );
+    else
+        OTK_ERROR_CHECK( exr_read_scanline_chunk_info( m_exrCtx, m_partIndex, tileY, &cinfo ) );
+
+    const int bytesPerChannel = getBytesPerChannel( m_info.format );
+    const int pixelStride     = bytesPerChannel * m_info.numChannels;
+
+    // Texture channels without a source channel are filled with zeros.
+    if( m_hasUnfilledChannels )
+    {
+        for( int y = 0; y < cinfo.height; ++y )
+            std::memset( dest + y * rowPitch, 0, cinfo.width * pixelStride );
+    }
+
+    if( !m_chunkChannels.empty() )
+    {
+        // Read only the lines of the selected channels, which the file coalesces where they are
+        // close together.  EXR data is little-endian, like the supported hosts.
+        const size_t channelLineSize = static_cast<size_t>( cinfo.width ) * bytesPerChannel;
+        const size_t fileLineSize    = static_cast<size_t>( cinfo.width ) * m_fileBytesPerPixel;
+        const size_t numChannels     = m_chunkChannels.size();
+        OTK_ASSERT_MSG( cinfo.packed_size == cinfo.height * fileLineSize, "Unexpected size of uncompressed EXR chunk" );
+
+        std::vector<char>&    buffer = getScratchBuffer<ChunkBuffer>( cinfo.height * numChannels * channelLineSize );
+        std::vector<FileRead> reads;
+        reads.reserve( cinfo.height * numChannels );
+        for( int y = 0; y < cinfo.height; ++y )
+        {
+            for( size_t c = 0; c < numChannels; ++c )
+                reads.push_back( FileRead{ &buffer[( y * numChannels + c ) * channelLineSize], channelLineSize,
+                                           cinfo.data_offset + y * fileLineSize + m_chunkChannels[c].lineOffset * cinfo.width } );
+        }
+        if( !m_file->read( reads.data(), reads.size() ) )
+            throw std::runtime_error( "Error reading EXR file " + m_filename );
+
+        // Interleave the channels.
+        for( int y = 0; y < cinfo.height; ++y )
+        {
+            for( size_t c = 0; c < numChannels; ++c )
+            {
+                const char* src   = &buffer[( y * numChannels + c ) * channelLineSize];
+                char*       texel = dest + y * rowPitch + m_chunkChannels[c].outputIndex * bytesPerChannel;
+                for( int x = 0; x < cinfo.width; ++x, src += bytesPerChannel, texel += pixelStride )
+                    std::memcpy( texel, src, bytesPerChannel );
+            }
+        }
+        return;
+    }
+
+    exr_decode_pipeline_t decoder;
+    OTK_ERROR_CHECK( exr_decoding_initialize( m_exrCtx, m_partIndex, &cinfo, &decoder ) );
+
+    // Setup the outputs.  The decoder skips channels without an output.
+    for( int c = 0; c < decoder.channel_count; ++c )
+    {
+        const int channelIdx = getOutputChannel( decoder.channels[c].channel_name );
+        if( channelIdx < 0 )
+        {
+            decoder.channels[c].decode_to_ptr = nullptr;
+            continue;
+        }
+        OTK_ASSERT_MSG( decoder.channels[c].bytes_per_element == bytesPerChannel, "All channels must have same bit depth" );
+
+        decoder.channels[c].decode_to_ptr          = reinterpret_cast<uint8_t*>( dest ) + channelIdx * bytesPerChannel;
+        decoder.channels[c].user_pixel_stride      = pixelStride;
+        decoder.channels[c].user_line_stride       = rowPitch;
+        decoder.channels[c].user_bytes_per_element = decoder.channels[c].bytes_per_element;
+    }
+
+    // Run the decoder
+    OTK_ERROR_CHECK( exr_decoding_choose_default_routines( m_exrCtx, m_partIndex, &decoder ) );
+    OTK_ERROR_CHECK( exr_decoding_run( m_exrCtx, m_partIndex, &decoder ) );
+    OTK_ERROR_CHECK( exr_decoding_destroy( m_exrCtx, &decoder ) );
+}
+
 void CoreEXRReader::readActualTile( char* dest, int rowPitch, int mipLevel, int tileX, int tileY )
 {
     OTK_ASSERT( !m_isScanline );
@@ -183,48 +435,13 @@ void CoreEXRReader::readActualTile( char* dest, int rowPitch, int mipLevel, int
     const int  actualTileWidth  = partialX ? m_levelWidths[mipLevel] % sourceTileWidth : sourceTileWidth;
     const int  actualTileHeight = partialY ? m_levelHeights[mipLevel] % sourceTileHeight : sourceTileHeight;
 
-    exr_chunk_info_t      cinfo;
-    exr_decode_pipeline_t decoder;
-    OTK_ERROR_CHECK( exr_read_tile_chunk_info( m_exrCtx, m_partIndex, tileX, tileY, mipLevel, mipLevel, &cinfo ) );
-    OTK_ERROR_CHECK( exr_decoding_initialize( m_exrCtx, 0, &cinfo, &decoder ) );
-
-    const int bytesPerChannel = decoder.channels[0].bytes_per_element;
-
-    // Setup the outputs
-    for( int c = 0; c < decoder.channel_count; ++c )
-    {
-        OTK_ASSERT_MSG( decoder.channels[c].bytes_per_element == bytesPerChannel,
-                           "All channels must have same bit depth" );
-
-        int channelIdx = -1;
-        if( strcmp( "R", decoder.channels[c].channel_name ) == 0 ||
-            ( strcmp( "Y", decoder.channels[c].channel_name ) == 0 && decoder.channel_count == 1 ) ) // Support single-channel, luminance-only files.
-            channelIdx = 0;
-        else if( strcmp( "G", decoder.channels[c].channel_name ) == 0 )
-            channelIdx = 1;
-        else if( strcmp( "B", decoder.channels[c].channel_name ) == 0 )
-            channelIdx = 2;
-        else if( strcmp( "A", decoder.channels[c].channel_name ) == 0 )
-            channelIdx = 3;
-
-        OTK_ASSERT_MSG( channelIdx >= 0 && channelIdx < 4, "Channel index out of range" );
-
-        decoder.channels[c].decode_to_ptr = reinterpret_cast<uint8_t*>( dest ) + channelIdx * decoder.channels[c].bytes_per_element;
-        decoder.channels[c].user_pixel_stride      = m_info.numChannels * decoder.channels[c].bytes_per_element;
-        decoder.channels[c].user_line_stride       = rowPitch;
-        decoder.channels[c].user_bytes_per_element = decoder.channels[c].bytes_per_element;
-    }
-
-    // Run the decoder
-    OTK_ERROR_CHECK( exr_decoding_choose_default_routines( m_exrCtx, 0, &decoder ) );
-    OTK_ERROR_CHECK( exr_decoding_run( m_exrCtx, 0, &decoder ) );
-    OTK_ERROR_CHECK( exr_decoding_destroy( m_exrCtx, &decoder ) );
+    readChunk( /*isTile=*/true, mipLevel, tileX, tileY, dest, rowPitch );
 
     // Stats tracking
     {
         std::unique_lock<std::mutex> lock( m_statsMutex );
         m_numTilesRead += 1;
-        m_numBytesRead += actualTileWidth * actualTileHeight * bytesPerChannel * m_info.numChannels;
+        m_numBytesRead += actualTileWidth * actualTileHeight * getBytesPerChannel( m_info.format ) * m_info.numChannels;
     }
 }
 
@@ -232,57 +449,61 @@ void CoreEXRReader::readScanlineData( char* dest )
 {
     OTK_ASSERT( m_isScanline );
 
-    int scanlinesPerChunk;
-    OTK_ERROR_CHECK( exr_get_scanlines_per_chunk( m_exrCtx, m_partIndex, &scanlinesPerChunk ) );
-
-    size_t offset = 0;
+    const int scanlinesPerChunk = static_cast<int>( m_scanlinesPerChunk );
+    const int rowPitch          = m_info.width * m_info.numChannels * getBytesPerChannel( m_info.format );
     for( int y = 0; y < (int)m_info.height; y += scanlinesPerChunk )
     {
-        exr_chunk_info_t      cinfo;
-        exr_decode_pipeline_t decoder;
-        OTK_ERROR_CHECK( exr_read_scanline_chunk_info( m_exrCtx, m_partIndex, y, &cinfo ) );
-        OTK_ERROR_CHECK( exr_decoding_initialize( m_exrCtx, 0, &cinfo, &decoder ) );
+        readChunk( /*isTile=*/false, 0, 0, y, dest + static_cast<size_t>( y ) * rowPitch, rowPitch );
+    }
 
-        const int bytesPerElement = decoder.channels[0].bytes_per_element;
+    // Stats tracking
+    {
+        std::unique_lock<std::mutex> lock(m_statsMutex);
+        m_numTilesRead += 1;
+        m_numBytesRead += m_info.height * m_info.width * m_info.numChannels * getBytesPerChannel( m_info.format );
+    }
+}
+
+bool CoreEXRReader::readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream /*stream*/ )
+{
+    OTK_ASSERT_MSG( isOpen(), "Attempting to read from image that isn't open." );
+    if( !m_isScanline )
+        return false;
+    OTK_ASSERT( mipLevel == 0 );
+    (void)mipLevel;  // silence unused variable warning
+
+    Stopwatch stopwatch;
 
-        // Setup the outputs
-        for( int c = 0; c < decoder.channel_count; ++c )
+    const int    chunkHeight = static_cast<int>( m_scanlinesPerChunk );
+    const int    beginRow    = static_cast<int>( firstRow );
+    const int    endRow      = std::min( static_cast<int>( m_info.height ), beginRow + static_cast<int>( numRows ) );
+    const size_t rowPitch    = static_cast<size_t>( m_info.width ) * m_info.numChannels * getBytesPerChannel( m_info.format );
+    for( int y = beginRow - beginRow % chunkHeight; y < endRow; y += chunkHeight )
+    {
+        const int chunkEnd = std::min( static_cast<int>( m_info.height ), y + chunkHeight );
+        if( y >= beginRow && chunkEnd <= endRow )
         {
-            OTK_ASSERT_MSG( decoder.channels[c].bytes_per_element == bytesPerElement,
-                                "All channels must have same bit depth" );
-
-            int channelIdx = -1;
-            if( strcmp( "R", decoder.channels[c].channel_name ) == 0 || strcmp( "Y", decoder.channels[c].channel_name ) == 0 )
-                channelIdx = 0;
-            else if( strcmp( "G", decoder.channels[c].channel_name ) == 0 )
-                channelIdx = 1;
-            else if( strcmp( "B", decoder.channels[c].channel_name ) == 0 )
-                channelIdx = 2;
-            else if( strcmp( "A", decoder.channels[c].channel_name ) == 0 )
-                channelIdx = 3;
-
-            OTK_ASSERT_MSG( channelIdx >= 0 && channelIdx < 4, "Channel index out of range" );
-
-            decoder.channels[c].decode_to_ptr = reinterpret_cast<uint8_t*>( dest ) + offset + channelIdx * decoder.channels[c].bytes_per_element;
-            decoder.channels[c].user_pixel_stride      = m_info.numChannels * decoder.channels[c].bytes_per_element;
-            decoder.channels[c].user_line_stride       = m_info.width * decoder.channels[c].user_pixel_stride;
-            decoder.channels[c].user_bytes_per_element = decoder.channels[c].bytes_per_element;
+            readChunk( /*isTile=*/false, 0, 0, y, dest + ( y - beginRow ) * rowPitch, static_cast<int>( rowPitch ) );
+            continue;
         }
 
-        // Run the decoder
-        OTK_ERROR_CHECK( exr_decoding_choose_default_routines( m_exrCtx, 0, &decoder ) );
-        OTK_ERROR_CHECK( exr_decoding_run( m_exrCtx, 0, &decoder ) );
-        OTK_ERROR_CHECK( exr_decoding_destroy( m_exrCtx, &decoder ) );
-
-        offset += m_info.width * m_info.numChannels * bytesPerElement * scanlinesPerChunk;
+        // Decode a chunk that straddles the requested rows aside, and copy the overlap.
+        std::vector<char>& buffer = getScratchBuffer<PartialChunkBuffer>( ( chunkEnd - y ) * rowPitch );
+        readChunk( /*isTile=*/false, 0, 0, y, buffer.data(), static_cast<int>( rowPitch ) );
+        const int overlapBegin = std::max( y, beginRow );
+        const int overlapEnd   = std::min( chunkEnd, endRow );
+        std::memcpy( dest + ( overlapBegin - beginRow ) * rowPitch, buffer.data() + ( overlapBegin - y ) * rowPitch,
+                     ( overlapEnd - overlapBegin ) * rowPitch );
     }
 
     // Stats tracking
     {
-        std::unique_lock<std::mutex> lock(m_statsMutex);
+        std::unique_lock<std::mutex> lock( m_statsMutex );
         m_numTilesRead += 1;
-        m_numBytesRead += m_info.height * m_info.width * m_info.numChannels * getBytesPerChannel( m_info.format );
+        m_numBytesRead += std::max( endRow - beginRow, 0 ) * rowPitch;
+        m_totalReadTime += stopwatch.elapsed();
     }
+    return true;
 }
 
 bool CoreEXRReader::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream /*stream*/  )
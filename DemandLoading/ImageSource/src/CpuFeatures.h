@@ -0,0 +1,104 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+// Runtime detection of x86 instruction set extensions.  Kernels that use an extension are compiled
+// with the matching OTK_TARGET attribute, so the library itself needs no per-target flags, and are
+// called only when the corresponding has function returns true.  Code shared by kernels for several
+// targets is marked OTK_FORCE_INLINE, so that it is compiled for the target of each caller.
+
+#if defined( _MSC_VER )
+#define OTK_FORCE_INLINE __forceinline
+#else
+#define OTK_FORCE_INLINE inline __attribute__( ( always_inline ) )
+#endif
+
+#if defined( __x86_64__ ) || defined( _M_X64 )
+#define OTK_USE_X86_INTRINSICS 1
+#include <immintrin.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#define OTK_TARGET_AVX
+#define OTK_TARGET_AVX2
+#define OTK_TARGET_F16C
+#else
+#include <cpuid.h>
+#define OTK_TARGET_AVX __attribute__( ( target( "avx" ) ) )
+#define OTK_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#define OTK_TARGET_F16C __attribute__( ( target( "avx,f16c" ) ) )
+#endif
+#endif
+
+namespace imageSource {
+
+#if OTK_USE_X86_INTRINSICS
+const unsigned int CPUID1_ECX_AVX  = 1U << 28;
+const unsigned int CPUID1_ECX_F16C = 1U << 29;
+
+/// Returns true if the processor supports the given CPUID leaf 1 ECX features and the OS saves
+/// the AVX registers they use.
+inline bool detectAVXFeatures( unsigned int features )
+{
+#if defined( _MSC_VER )
+    int info[4];
+    __cpuid( info, 1 );
+    const unsigned int ecx = static_cast<unsigned int>( info[2] );
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+        return false;
+#endif
+    const unsigned int OSXSAVE = 1U << 27;
+    features |= OSXSAVE | CPUID1_ECX_AVX;
+    if( ( ecx & features ) != features )
+        return false;
+#if defined( _MSC_VER )
+    const unsigned long long xcr0 = _xgetbv( 0 );
+#else
+    unsigned int xcr0Low, xcr0High;
+    __asm__( "xgetbv" : "=a"( xcr0Low ), "=d"( xcr0High ) : "c"( 0 ) );
+    const unsigned long long xcr0 = xcr0Low;
+#endif
+    return ( xcr0 & 6 ) == 6;
+}
+
+inline bool hasAVX()
+{
+    static const bool result = detectAVXFeatures( 0 );
+    return result;
+}
+
+/// Returns true if the processor supports AVX2 (CPUID leaf 7 EBX) and the OS saves the AVX registers.
+inline bool detectAVX2()
+{
+    if( !detectAVXFeatures( 0 ) )
+        return false;
+#if defined( _MSC_VER )
+    int info[4];
+    __cpuidex( info, 7, 0 );
+    const unsigned int ebx = static_cast<unsigned int>( info[1] );
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if( !__get_cpuid_count( 7, 0, &eax, &ebx, &ecx, &edx ) )
+        return false;
+#endif
+    const unsigned int CPUID7_EBX_AVX2 = 1U << 5;
+    return ( ebx & CPUID7_EBX_AVX2 ) != 0;
+}
+
+inline bool hasAVX2()
+{
+    static const bool result = detectAVX2();
+    return result;
+}
+
+inline bool hasF16C()
+{
+    static const bool result = detectAVXFeatures( CPUID1_ECX_F16C );
+    return result;
+}
+#endif
+
+}  // namespace imageSource
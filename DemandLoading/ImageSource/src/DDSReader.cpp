@@ -0,0 +1,254 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/DDSReader.h>
+
+#include "RandomAccessFile.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace imageSource {
+
+namespace {
+
+// Layout of the DDS header, as byte offsets from the start of the file.
+const unsigned int DDS_HEADER_SIZE        = 128;
+const unsigned int DDS_DX10_HEADER_SIZE   = 148;
+const unsigned int DDS_FLAGS              = 8;
+const unsigned int DDS_HEIGHT             = 12;
+const unsigned int DDS_WIDTH              = 16;
+const unsigned int DDS_MIP_MAP_COUNT      = 28;
+const unsigned int DDS_PF_FLAGS           = 80;
+const unsigned int DDS_PF_FOURCC          = 84;
+const unsigned int DDS_PF_RGB_BIT_COUNT   = 88;
+const unsigned int DDS_PF_MASKS           = 92;
+const unsigned int DDS_CAPS2              = 112;
+const unsigned int DDS_DXGI_FORMAT        = 128;
+const unsigned int DDS_RESOURCE_DIMENSION = 132;
+const unsigned int DDS_MISC_FLAG          = 136;
+const unsigned int DDS_ARRAY_SIZE         = 140;
+
+const std::uint32_t DDSD_MIPMAPCOUNT                   = 0x20000;
+const std::uint32_t DDPF_FOURCC                        = 0x4;
+const std::uint32_t DDPF_RGB                           = 0x40;
+const std::uint32_t DDSCAPS2_CUBEMAP                   = 0x200;
+const std::uint32_t DDSCAPS2_VOLUME                    = 0x200000;
+const std::uint32_t D3D10_RESOURCE_DIMENSION_TEXTURE2D = 3;
+const std::uint32_t D3D11_RESOURCE_MISC_TEXTURECUBE    = 0x4;
+
+std::uint32_t readU32( const unsigned char* bytes, unsigned int offset )
+{
+    return std::uint32_t( bytes[offset] ) | std::uint32_t( bytes[offset + 1] ) << 8 | std::uint32_t( bytes[offset + 2] ) << 16
+           | std::uint32_t( bytes[offset + 3] ) << 24;
+}
+
+constexpr std::uint32_t fourCC( char a, char b, char c, char d )
+{
+    return std::uint32_t( a ) | std::uint32_t( b ) << 8 | std::uint32_t( c ) << 16 | std::uint32_t( d ) << 24;
+}
+
+// Get the format and channel count for a DXGI_FORMAT value.  Returns false if unsupported.
+bool getDxgiFormat( std::uint32_t dxgiFormat, CUarray_format& format, unsigned int& numChannels )
+{
+    switch( dxgiFormat )
+    {
+        case 2:  // R32G32B32A32_FLOAT
+            format = CU_AD_FORMAT_FLOAT, numChannels = 4;
+            return true;
+        case 10:  // R16G16B16A16_FLOAT
+            format = CU_AD_FORMAT_HALF, numChannels = 4;
+            return true;
+        case 16:  // R32G32_FLOAT
+            format = CU_AD_FORMAT_FLOAT, numChannels = 2;
+            return true;
+        case 28:  // R8G8B8A8_UNORM
+        case 29:  // R8G8B8A8_UNORM_SRGB
+            format = CU_AD_FORMAT_UNSIGNED_INT8, numChannels = 4;
+            return true;
+        case 34:  // R16G16_FLOAT
+            format = CU_AD_FORMAT_HALF, numChannels = 2;
+            return true;
+        case 41:  // R32_FLOAT
+            format = CU_AD_FORMAT_FLOAT, numChannels = 1;
+            return true;
+        case 49:  // R8G8_UNORM
+            format = CU_AD_FORMAT_UNSIGNED_INT8, numChannels = 2;
+            return true;
+        case 54:  // R16_FLOAT
+            format = CU_AD_FORMAT_HALF, numChannels = 1;
+            return true;
+        case 61:  // R8_UNORM
+            format = CU_AD_FORMAT_UNSIGNED_INT8, numChannels = 1;
+            return true;
+#if CUDA_VERSION >= 11050
+        case 71:  // BC1_UNORM
+            format = CU_AD_FORMAT_BC1_UNORM;
+            break;
+        case 72:  // BC1_UNORM_SRGB
+            format = CU_AD_FORMAT_BC1_UNORM_SRGB;
+            break;
+        case 74:  // BC2_UNORM
+            format = CU_AD_FORMAT_BC2_UNORM;
+            break;
+        case 75:  // BC2_UNORM_SRGB
+            format = CU_AD_FORMAT_BC2_UNORM_SRGB;
+            break;
+        case 77:  // BC3_UNORM
+            format = CU_AD_FORMAT_BC3_UNORM;
+            break;
+        case 78:  // BC3_UNORM_SRGB
+            format = CU_AD_FORMAT_BC3_UNORM_SRGB;
+            break;
+        case 80:  // BC4_UNORM
+            format = CU_AD_FORMAT_BC4_UNORM;
+            break;
+        case 81:  // BC4_SNORM
+            format = CU_AD_FORMAT_BC4_SNORM;
+            break;
+        case 83:  // BC5_UNORM
+            format = CU_AD_FORMAT_BC5_UNORM;
+            break;
+        case 84:  // BC5_SNORM
+            format = CU_AD_FORMAT_BC5_SNORM;
+            break;
+        case 95:  // BC6H_UF16
+            format = CU_AD_FORMAT_BC6H_UF16;
+            break;
+        case 96:  // BC6H_SF16
+            format = CU_AD_FORMAT_BC6H_SF16;
+            break;
+        case 98:  // BC7_UNORM
+            format = CU_AD_FORMAT_BC7_UNORM;
+            break;
+        case 99:  // BC7_UNORM_SRGB
+            format = CU_AD_FORMAT_BC7_UNORM_SRGB;
+            break;
+#endif
+        default:
+            return false;
+    }
+    numChannels = getNumChannelsInBlockFormat( format );
+    return true;
+}
+
+// Returns true for the DXGI_FORMAT values of sRGB-encoded formats.
+bool isSRGBDxgiFormat( std::uint32_t dxgiFormat )
+{
+    return dxgiFormat == 29 || dxgiFormat == 72 || dxgiFormat == 75 || dxgiFormat == 78 || dxgiFormat == 99;
+}
+
+// Get the format and channel count from a legacy pixel format.  Returns false if unsupported.
+bool getLegacyFormat( const unsigned char* header, CUarray_format& format, unsigned int& numChannels )
+{
+    const std::uint32_t flags = readU32( header, DDS_PF_FLAGS );
+    if( flags & DDPF_FOURCC )
+    {
+        switch( readU32( header, DDS_PF_FOURCC ) )
+        {
+#if CUDA_VERSION >= 11050
+            case fourCC( 'D', 'X', 'T', '1' ):
+                format = CU_AD_FORMAT_BC1_UNORM;
+                break;
+            case fourCC( 'D', 'X', 'T', '2' ):
+            case fourCC( 'D', 'X', 'T', '3' ):
+                format = CU_AD_FORMAT_BC2_UNORM;
+                break;
+            case fourCC( 'D', 'X', 'T', '4' ):
+            case fourCC( 'D', 'X', 'T', '5' ):
+                format = CU_AD_FORMAT_BC3_UNORM;
+                break;
+            case fourCC( 'A', 'T', 'I', '1' ):
+            case fourCC( 'B', 'C', '4', 'U' ):
+                format = CU_AD_FORMAT_BC4_UNORM;
+                break;
+            case fourCC( 'B', 'C', '4', 'S' ):
+                format = CU_AD_FORMAT_BC4_SNORM;
+                break;
+            case fourCC( 'A', 'T', 'I', '2' ):
+            case fourCC( 'B', 'C', '5', 'U' ):
+                format = CU_AD_FORMAT_BC5_UNORM;
+                break;
+            case fourCC( 'B', 'C', '5', 'S' ):
+                format = CU_AD_FORMAT_BC5_SNORM;
+                break;
+#endif
+            // D3DFORMAT values stored in the FourCC field.
+            case 111:  // D3DFMT_R16F
+                return getDxgiFormat( 54, format, numChannels );
+            case 112:  // D3DFMT_G16R16F
+                return getDxgiFormat( 34, format, numChannels );
+            case 113:  // D3DFMT_A16B16G16R16F
+                return getDxgiFormat( 10, format, numChannels );
+            case 114:  // D3DFMT_R32F
+                return getDxgiFormat( 41, format, numChannels );
+            case 115:  // D3DFMT_G32R32F
+                return getDxgiFormat( 16, format, numChannels );
+            case 116:  // D3DFMT_A32B32G32R32F
+                return getDxgiFormat( 2, format, numChannels );
+            default:
+                return false;
+        }
+        numChannels = getNumChannelsInBlockFormat( format );
+        return true;
+    }
+
+    // Only uncompressed layouts that need no swizzling are supported.
+    if( ( flags & DDPF_RGB ) && readU32( header, DDS_PF_RGB_BIT_COUNT ) == 32 && readU32( header, DDS_PF_MASKS ) == 0xff
+        && readU32( header, DDS_PF_MASKS + 4 ) == 0xff00 && readU32( header, DDS_PF_MASKS + 8 ) == 0xff0000 )
+        return getDxgiFormat( 28, format, numChannels );
+    return false;
+}
+
+}  // namespace
+
+void DDSReader::readHeader( const RandomAccessFile& file, TextureInfo& info, std::vector<unsigned long long>& levelOffsets )
+{
+    // Read the largest possible header at once; the legacy header is shorter.
+    unsigned char header[DDS_DX10_HEADER_SIZE]{};
+    const size_t  headerSize = static_cast<size_t>( std::min<unsigned long long>( file.size(), DDS_DX10_HEADER_SIZE ) );
+    if( headerSize < DDS_HEADER_SIZE || !file.read( header, headerSize, 0 ) || readU32( header, 0 ) != fourCC( 'D', 'D', 'S', ' ' ) )
+        throwError( "not a DDS file" );
+
+    if( readU32( header, DDS_CAPS2 ) & ( DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME ) )
+        throwError( "DDS cube maps and volumes are not supported" );
+
+    unsigned long long dataOffset = DDS_HEADER_SIZE;
+    bool               supported  = false;
+    if( ( readU32( header, DDS_PF_FLAGS ) & DDPF_FOURCC ) && readU32( header, DDS_PF_FOURCC ) == fourCC( 'D', 'X', '1', '0' ) )
+    {
+        if( headerSize < DDS_DX10_HEADER_SIZE )
+            throwError( "truncated DX10 header" );
+        if( readU32( header, DDS_RESOURCE_DIMENSION ) != D3D10_RESOURCE_DIMENSION_TEXTURE2D
+            || ( readU32( header, DDS_MISC_FLAG ) & D3D11_RESOURCE_MISC_TEXTURECUBE ) || readU32( header, DDS_ARRAY_SIZE ) > 1 )
+            throwError( "only 2D DDS textures are supported" );
+        const std::uint32_t dxgiFormat = readU32( header, DDS_DXGI_FORMAT );
+        supported                      = getDxgiFormat( dxgiFormat, info.format, info.numChannels );
+        dataOffset                     = DDS_DX10_HEADER_SIZE;
+        setSRGB( isSRGBDxgiFormat( dxgiFormat ) );
+    }
+    else
+    {
+        supported = getLegacyFormat( header, info.format, info.numChannels );
+    }
+    if( !supported )
+        throwError( "unsupported DDS pixel format" );
+
+    info.width        = readU32( header, DDS_WIDTH );
+    info.height       = readU32( header, DDS_HEIGHT );
+    info.numMipLevels = ( readU32( header, DDS_FLAGS ) & DDSD_MIPMAPCOUNT ) ? std::max( 1U, readU32( header, DDS_MIP_MAP_COUNT ) ) : 1;
+    if( info.width == 0 || info.height == 0 || info.numMipLevels > calculateNumMipLevels( info.width, info.height ) )
+        throwError( "invalid DDS dimensions" );
+
+    // Mip levels are stored consecutively, finest first.
+    levelOffsets.resize( info.numMipLevels );
+    for( unsigned int mipLevel = 0; mipLevel < info.numMipLevels; ++mipLevel )
+    {
+        levelOffsets[mipLevel] = dataOffset;
+        dataOffset += getImageSizeInBytes( info.format, info.numChannels, std::max( 1U, info.width >> mipLevel ),
+                                           std::max( 1U, info.height >> mipLevel ) );
+    }
+}
+
+}  // namespace imageSource
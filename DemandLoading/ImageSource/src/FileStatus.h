@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <process.h>
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+namespace imageSource {
+
+/// Get the modification time, in nanoseconds since the epoch, and the size of the given file.
+/// Returns false if the file doesn't exist.  A file rewritten within the same second gets a new
+/// modification time on file systems that record sub-second times.
+inline bool getFileStatus( const std::string& path, long long& modificationTime, long long& fileSize )
+{
+    if( path.empty() )
+        return false;
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if( !GetFileAttributesExA( path.c_str(), GetFileExInfoStandard, &data ) )
+        return false;
+    // FILETIME counts 100 nanosecond intervals since 1601.
+    const unsigned long long ticks =
+        ( static_cast<unsigned long long>( data.ftLastWriteTime.dwHighDateTime ) << 32 ) | data.ftLastWriteTime.dwLowDateTime;
+    modificationTime = static_cast<long long>( ticks - 116444736000000000ULL ) * 100;
+    fileSize         = static_cast<long long>( ( static_cast<unsigned long long>( data.nFileSizeHigh ) << 32 ) | data.nFileSizeLow );
+#else
+    struct stat status;
+    if( stat( path.c_str(), &status ) != 0 )
+        return false;
+#ifdef __APPLE__
+    const struct timespec& time = status.st_mtimespec;
+#else
+    const struct timespec& time = status.st_mtim;
+#endif
+    modificationTime = static_cast<long long>( time.tv_sec ) * 1000000000LL + static_cast<long long>( time.tv_nsec );
+    fileSize         = static_cast<long long>( status.st_size );
+#endif
+    return true;
+}
+
+inline long long getProcessId()
+{
+#ifdef _WIN32
+    return static_cast<long long>( _getpid() );
+#else
+    return static_cast<long long>( getpid() );
+#endif
+}
+
+/// Return a temporary filename next to the given path that is unique to this process and call, so
+/// that concurrent writers of the same file (in this or other processes) never share a temp file.
+inline std::string getTempFilename( const std::string& path )
+{
+    static std::atomic<unsigned long long> tempCounter( 0 );
+    std::ostringstream                     tempPath;
+    tempPath << path << '.' << getProcessId() << '.' << tempCounter++ << ".tmp";
+    return tempPath.str();
+}
+
+/// Rename the temporary file over the given path.  The temporary file is removed on failure.
+/// Returns true on success.
+inline bool replaceFile( const std::string& tempPath, const std::string& path )
+{
+    if( std::rename( tempPath.c_str(), path.c_str() ) == 0 )
+        return true;
+    // Windows does not allow renaming over an existing file.
+    std::remove( path.c_str() );
+    if( std::rename( tempPath.c_str(), path.c_str() ) == 0 )
+        return true;
+    std::remove( tempPath.c_str() );
+    return false;
+}
+
+}  // namespace imageSource
@@ -0,0 +1,337 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/FormatConversion.h>
+
+#include "CpuFeatures.h"
+
+#include <OptiXToolkit/Error/ErrorCheck.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace imageSource {
+
+namespace {
+
+// Number of pixels converted at a time, which keeps the scratch buffers in L1 cache.
+const size_t CHUNK_SIZE = 512;
+
+std::uint16_t floatToHalfBits( float value )
+{
+    std::uint32_t bits;
+    std::memcpy( &bits, &value, sizeof( bits ) );
+    const std::uint32_t sign    = ( bits >> 16 ) & 0x8000;
+    const std::uint32_t absBits = bits & 0x7fffffff;
+
+    // Infinity and NaN, which is quieted.
+    if( absBits >= 0x7f800000 )
+        return static_cast<std::uint16_t>( sign | 0x7c00 | ( absBits > 0x7f800000 ? 0x200 | ( ( absBits >> 13 ) & 0x3ff ) : 0 ) );
+    // Values that round to 65520 or more overflow to infinity.
+    if( absBits >= 0x477ff000 )
+        return static_cast<std::uint16_t>( sign | 0x7c00 );
+    // Values that round to zero, including 2^-25, which ties to even.
+    if( absBits <= 0x33000000 )
+        return static_cast<std::uint16_t>( sign );
+
+    std::uint32_t result;
+    std::uint32_t remainder;
+    std::uint32_t halfway;
+    if( absBits < 0x38800000 )
+    {
+        // Denormal half: shift the mantissa, with its implicit bit, to units of 2^-24.
+        const std::uint32_t shift    = 126 - ( absBits >> 23 );
+        const std::uint32_t mantissa = ( absBits & 0x7fffff ) | 0x800000;
+        result                       = mantissa >> shift;
+        remainder                    = mantissa & ( ( 1U << shift ) - 1 );
+        halfway                      = 1U << ( shift - 1 );
+    }
+    else
+    {
+        // Normal half: rebias the exponent.  Rounding may carry into the exponent.
+        result    = ( absBits - 0x38000000 ) >> 13;
+        remainder = absBits & 0x1fff;
+        halfway   = 0x1000;
+    }
+    if( remainder > halfway || ( remainder == halfway && ( result & 1 ) ) )
+        ++result;
+    return static_cast<std::uint16_t>( sign | result );
+}
+
+float halfBitsToFloat( std::uint16_t value )
+{
+    const std::uint32_t sign     = static_cast<std::uint32_t>( value & 0x8000 ) << 16;
+    const std::uint32_t exponent = ( value >> 10 ) & 0x1f;
+    const std::uint32_t mantissa = value & 0x3ff;
+
+    std::uint32_t bits;
+    if( exponent == 0 )
+    {
+        // Zero or denormal.
+        const float magnitude = static_cast<float>( mantissa ) * ( 1.f / 16777216.f );
+        return sign ? -magnitude : magnitude;
+    }
+    if( exponent == 31 )
+        bits = sign | 0x7f800000 | ( mantissa << 13 );
+    else
+        bits = sign | ( ( exponent + 112 ) << 23 ) | ( mantissa << 13 );
+    float result;
+    std::memcpy( &result, &bits, sizeof( result ) );
+    return result;
+}
+
+#if OTK_USE_X86_INTRINSICS
+OTK_TARGET_F16C size_t convertFloatToHalfF16C( const float* src, size_t count, std::uint16_t* dest )
+{
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+    {
+        const __m128i halves = _mm256_cvtps_ph( _mm256_loadu_ps( src + i ), _MM_FROUND_TO_NEAREST_INT );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + i ), halves );
+    }
+    return i;
+}
+
+OTK_TARGET_F16C size_t convertHalfToFloatF16C( const std::uint16_t* src, size_t count, float* dest )
+{
+    size_t i = 0;
+    for( ; i + 8 <= count; i += 8 )
+        _mm256_storeu_ps( dest + i, _mm256_cvtph_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>( src + i ) ) ) );
+    return i;
+}
+#endif
+
+float encodeSRGB( float value )
+{
+    return value <= 0.0031308f ? 12.92f * value : 1.055f * std::pow( value, 1.f / 2.4f ) - 0.055f;
+}
+
+std::uint8_t toUnorm8( float value )
+{
+    // Written so that NaN maps to zero.
+    const float clamped = value > 0.f ? ( value < 1.f ? value : 1.f ) : 0.f;
+    return static_cast<std::uint8_t>( clamped * 255.f + 0.5f );
+}
+
+// The sRGB encoding of linear values in [2^-13, 1), indexed by their exponent and the top eight
+// bits of their mantissa.  Smaller values encode to zero.
+const unsigned int SRGB_MIN_EXPONENT = 114;  // 2^-13, biased
+const unsigned int SRGB_TABLE_SIZE   = ( 127 - SRGB_MIN_EXPONENT ) * 256;
+
+const std::uint8_t* getSRGBTable()
+{
+    static const struct Table
+    {
+        std::uint8_t codes[SRGB_TABLE_SIZE];
+        Table()
+        {
+            for( unsigned int i = 0; i < SRGB_TABLE_SIZE; ++i )
+            {
+                // Encode the midpoint of the range of values with this index.
+                const int   exponent = static_cast<int>( i / 256 + SRGB_MIN_EXPONENT ) - 127;
+                const float value    = std::ldexp( 1.f + ( ( i % 256 ) + 0.5f ) / 256.f, exponent );
+                codes[i]             = toUnorm8( encodeSRGB( value ) );
+            }
+        }
+    } table;
+    return table.codes;
+}
+
+std::uint8_t toUnorm8SRGB( float value, const std::uint8_t* table )
+{
+    std::uint32_t bits;
+    std::memcpy( &bits, &value, sizeof( bits ) );
+    if( bits >= 0x3f800000 )
+        return ( bits & 0x80000000 ) || bits > 0x7f800000 ? 0 : 255;  // negative, NaN, or >= 1
+    const std::uint32_t exponent = bits >> 23;
+    if( exponent < SRGB_MIN_EXPONENT )
+        return 0;
+    return table[( exponent - SRGB_MIN_EXPONENT ) * 256 + ( ( bits >> 15 ) & 0xff )];
+}
+
+template <typename T>
+void normalizeToFloat( const T* src, size_t count, float scale, float* dest )
+{
+    for( size_t i = 0; i < count; ++i )
+        dest[i] = static_cast<float>( src[i] ) * scale;
+}
+
+bool isIdentitySwizzle( unsigned int srcChannels, const int channels[4], unsigned int destChannels )
+{
+    if( srcChannels != destChannels )
+        return false;
+    for( unsigned int c = 0; c < destChannels; ++c )
+    {
+        if( channels[c] != static_cast<int>( c ) )
+            return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+bool isValidOutputFormat( const OutputFormat& format )
+{
+    const bool validFormat =
+        format.format == CU_AD_FORMAT_UNSIGNED_INT8 || format.format == CU_AD_FORMAT_HALF || format.format == CU_AD_FORMAT_FLOAT;
+    const bool validChannels = format.numChannels == 0 || format.numChannels == 1 || format.numChannels == 2 || format.numChannels == 4;
+    return validFormat && validChannels && ( !format.srgb || format.format == CU_AD_FORMAT_UNSIGNED_INT8 );
+}
+
+bool isConversionNeeded( CUarray_format format, unsigned int numChannels, const OutputFormat& outputFormat )
+{
+    return format != outputFormat.format || outputFormat.srgb
+           || !isIdentitySwizzle( numChannels, outputFormat.channels, getNumOutputChannels( numChannels, outputFormat ) );
+}
+
+void convertFloatToHalf( const float* src, size_t count, half* dest )
+{
+    std::uint16_t* halves = reinterpret_cast<std::uint16_t*>( dest );
+    size_t         i      = 0;
+#if OTK_USE_X86_INTRINSICS
+    if( hasF16C() )
+        i = convertFloatToHalfF16C( src, count, halves );
+#endif
+    for( ; i < count; ++i )
+        halves[i] = floatToHalfBits( src[i] );
+}
+
+void convertHalfToFloat( const half* src, size_t count, float* dest )
+{
+    const std::uint16_t* halves = reinterpret_cast<const std::uint16_t*>( src );
+    size_t               i      = 0;
+#if OTK_USE_X86_INTRINSICS
+    if( hasF16C() )
+        i = convertHalfToFloatF16C( halves, count, dest );
+#endif
+    for( ; i < count; ++i )
+        dest[i] = halfBitsToFloat( halves[i] );
+}
+
+void convertFloatToUnorm8( const float* src, size_t numPixels, unsigned int numChannels, bool srgb, std::uint8_t* dest )
+{
+    const size_t count = numPixels * numChannels;
+    if( srgb )
+    {
+        const std::uint8_t* table         = getSRGBTable();
+        const unsigned int  colorChannels = std::min( numChannels, 3U );
+        for( size_t i = 0; i < count; i += numChannels )
+        {
+            for( unsigned int c = 0; c < colorChannels; ++c )
+                dest[i + c] = toUnorm8SRGB( src[i + c], table );
+            for( unsigned int c = colorChannels; c < numChannels; ++c )
+                dest[i + c] = toUnorm8( src[i + c] );
+        }
+        return;
+    }
+
+    size_t i = 0;
+#if OTK_USE_X86_INTRINSICS
+    // SSE2 is part of x86-64.  Max returns its second operand for NaN, which maps NaN to zero.
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 one   = _mm_set1_ps( 1.f );
+    const __m128 scale = _mm_set1_ps( 255.f );
+    const __m128 round = _mm_set1_ps( 0.5f );
+    for( ; i + 16 <= count; i += 16 )
+    {
+        __m128i codes[4];
+        for( int k = 0; k < 4; ++k )
+        {
+            const __m128 value = _mm_min_ps( _mm_max_ps( _mm_loadu_ps( src + i + 4 * k ), zero ), one );
+            codes[k]           = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( value, scale ), round ) );
+        }
+        const __m128i words = _mm_packus_epi16( _mm_packs_epi32( codes[0], codes[1] ), _mm_packs_epi32( codes[2], codes[3] ) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( dest + i ), words );
+    }
+#endif
+    for( ; i < count; ++i )
+        dest[i] = toUnorm8( src[i] );
+}
+
+void swizzleChannels( const float* src, unsigned int srcChannels, size_t numPixels, const int channels[4], unsigned int destChannels, float* dest )
+{
+    OTK_ASSERT_MSG( destChannels <= 4, "Too many output channels" );
+
+    // Resolve each output channel to a source channel or a constant.
+    int   sources[4];
+    float constants[4];
+    for( unsigned int c = 0; c < destChannels; ++c )
+    {
+        sources[c]   = channels[c] >= 0 && channels[c] < static_cast<int>( srcChannels ) ? channels[c] : -1;
+        constants[c] = c == 3 ? 1.f : 0.f;
+    }
+
+    for( size_t i = 0; i < numPixels; ++i, src += srcChannels, dest += destChannels )
+    {
+        for( unsigned int c = 0; c < destChannels; ++c )
+            dest[c] = sources[c] >= 0 ? src[sources[c]] : constants[c];
+    }
+}
+
+void convertPixels( const void* src, CUarray_format srcFormat, unsigned int srcChannels, size_t numPixels, const OutputFormat& outputFormat, void* dest )
+{
+    OTK_ASSERT_MSG( isValidOutputFormat( outputFormat ), "Unsupported output format" );
+    const unsigned int destChannels  = getNumOutputChannels( srcChannels, outputFormat );
+    const bool         swizzle       = !isIdentitySwizzle( srcChannels, outputFormat.channels, destChannels );
+    const size_t       srcPixelSize  = getBytesPerChannel( srcFormat ) * srcChannels;
+    const size_t       destPixelSize = getBytesPerChannel( outputFormat.format ) * destChannels;
+
+    float widened[CHUNK_SIZE * 4];
+    float swizzled[CHUNK_SIZE * 4];
+    for( size_t first = 0; first < numPixels; first += CHUNK_SIZE )
+    {
+        const size_t numChunkPixels = std::min( CHUNK_SIZE, numPixels - first );
+        const size_t numSrcValues   = numChunkPixels * srcChannels;
+        const char*  chunkSrc       = static_cast<const char*>( src ) + first * srcPixelSize;
+        char*        chunkDest      = static_cast<char*>( dest ) + first * destPixelSize;
+
+        // Widen the source channels to floats.
+        const float* values = widened;
+        switch( srcFormat )
+        {
+            case CU_AD_FORMAT_UNSIGNED_INT8:
+                normalizeToFloat( reinterpret_cast<const std::uint8_t*>( chunkSrc ), numSrcValues, 1.f / 255.f, widened );
+                break;
+            case CU_AD_FORMAT_UNSIGNED_INT16:
+                normalizeToFloat( reinterpret_cast<const std::uint16_t*>( chunkSrc ), numSrcValues, 1.f / 65535.f, widened );
+                break;
+            case CU_AD_FORMAT_HALF:
+                convertHalfToFloat( reinterpret_cast<const half*>( chunkSrc ), numSrcValues, widened );
+                break;
+            case CU_AD_FORMAT_FLOAT:
+                values = reinterpret_cast<const float*>( chunkSrc );
+                break;
+            default:
+                OTK_ASSERT_MSG( false, "Unsupported source format for conversion" );
+        }
+
+        // Rearrange the channels, writing float output directly to the destination.
+        if( swizzle )
+        {
+            float* swizzleDest = outputFormat.format == CU_AD_FORMAT_FLOAT ? reinterpret_cast<float*>( chunkDest ) : swizzled;
+            swizzleChannels( values, srcChannels, numChunkPixels, outputFormat.channels, destChannels, swizzleDest );
+            values = swizzleDest;
+        }
+
+        // Narrow the floats to the output format.
+        const size_t numDestValues = numChunkPixels * destChannels;
+        switch( outputFormat.format )
+        {
+            case CU_AD_FORMAT_UNSIGNED_INT8:
+                convertFloatToUnorm8( values, numChunkPixels, destChannels, outputFormat.srgb, reinterpret_cast<std::uint8_t*>( chunkDest ) );
+                break;
+            case CU_AD_FORMAT_HALF:
+                convertFloatToHalf( values, numDestValues, reinterpret_cast<half*>( chunkDest ) );
+                break;
+            default:
+                if( values != reinterpret_cast<const float*>( chunkDest ) )
+                    std::memcpy( chunkDest, values, numDestValues * sizeof( float ) );
+                break;
+        }
+    }
+}
+
+}  // namespace imageSource
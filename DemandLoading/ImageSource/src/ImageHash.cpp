@@ -0,0 +1,468 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/ImageHash.h>
+
+#include "Blake2b.h"
+#include "FileStatus.h"
+
+#include <OptiXToolkit/Error/ErrorCheck.h>
+#include <OptiXToolkit/Error/cuErrorCheck.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace imageSource {
+
+namespace {
+
+// Levels are hashed as a sequence of blocks of this size, whose digests are then hashed in order.
+const size_t HASH_BLOCK_SIZE = 1 << 20;
+
+const unsigned int DIGEST_SIZE = 16;
+
+struct Digest
+{
+    unsigned char bytes[DIGEST_SIZE];
+};
+
+ImageHash toImageHash( const Digest& digest )
+{
+    ImageHash hash{};
+    for( unsigned int i = 0; i < 8; ++i )
+    {
+        hash.lo |= static_cast<unsigned long long>( digest.bytes[i] ) << ( 8 * i );
+        hash.hi |= static_cast<unsigned long long>( digest.bytes[i + 8] ) << ( 8 * i );
+    }
+    // Reserve the zero hash to indicate failure.
+    if( !hash.isValid() )
+        hash.lo = 1;
+    return hash;
+}
+
+void hashInfo( Blake2b& hasher, const TextureInfo& info, unsigned int firstMipLevel, unsigned int numMipLevels )
+{
+    // Hash the fields individually, since TextureInfo has padding and a tiled file has the same
+    // content as its scanline equivalent.
+    hasher.updateValue( info.width );
+    hasher.updateValue( info.height );
+    hasher.updateValue( static_cast<unsigned int>( info.format ) );
+    hasher.updateValue( info.numChannels );
+    hasher.updateValue( info.numMipLevels );
+    hasher.updateValue( firstMipLevel );
+    hasher.updateValue( numMipLevels );
+}
+
+unsigned int getNumThreads( const ImageHashOptions& options )
+{
+    unsigned int numThreads = options.numThreads ? options.numThreads : std::thread::hardware_concurrency();
+    return std::max( numThreads, 1U );
+}
+
+// Hash the given bytes as a sequence of fixed-size blocks (the last of which may be partial),
+// distributing the blocks over threads and appending their digests.
+void hashBlocks( const char* data, size_t size, unsigned int numThreads, std::vector<Digest>& blockDigests )
+{
+    const size_t        numBlocks  = ( size + HASH_BLOCK_SIZE - 1 ) / HASH_BLOCK_SIZE;
+    const size_t        firstBlock = blockDigests.size();
+    std::atomic<size_t> nextBlock( 0 );
+    blockDigests.resize( firstBlock + numBlocks );
+
+    auto worker = [&]() {
+        for( size_t block = nextBlock++; block < numBlocks; block = nextBlock++ )
+        {
+            const size_t begin = block * HASH_BLOCK_SIZE;
+            Blake2b      hasher( DIGEST_SIZE );
+            hasher.update( data + begin, std::min( HASH_BLOCK_SIZE, size - begin ) );
+            hasher.finish( blockDigests[firstBlock + block].bytes );
+        }
+    };
+
+    numThreads = static_cast<unsigned int>( std::min<size_t>( numThreads, numBlocks ) );
+    std::vector<std::thread> threads;
+    for( unsigned int i = 1; i < numThreads; ++i )
+        threads.emplace_back( worker );
+    worker();
+    for( std::thread& thread : threads )
+        thread.join();
+}
+
+// LevelHasher hashes a mip level that is supplied in consecutive pieces (bands of rows) as a
+// sequence of fixed-size blocks, whose digests are then hashed in order.  The block boundaries do
+// not depend on how the level is split, so the digest is the same however the level is read.
+class LevelHasher
+{
+  public:
+    LevelHasher( unsigned int mipLevel, unsigned int numThreads )
+        : m_mipLevel( mipLevel )
+        , m_numThreads( numThreads )
+    {
+    }
+
+    void update( const char* data, size_t size )
+    {
+        m_size += size;
+        if( !m_partial.empty() )
+        {
+            const size_t count = std::min( HASH_BLOCK_SIZE - m_partial.size(), size );
+            m_partial.insert( m_partial.end(), data, data + count );
+            data += count;
+            size -= count;
+            if( m_partial.size() < HASH_BLOCK_SIZE )
+                return;
+            hashBlocks( m_partial.data(), m_partial.size(), 1, m_blockDigests );
+            m_partial.clear();
+        }
+        const size_t wholeSize = size / HASH_BLOCK_SIZE * HASH_BLOCK_SIZE;
+        hashBlocks( data, wholeSize, m_numThreads, m_blockDigests );
+        m_partial.assign( data + wholeSize, data + size );
+    }
+
+    Digest finish()
+    {
+        hashBlocks( m_partial.data(), m_partial.size(), 1, m_blockDigests );
+        Blake2b hasher( DIGEST_SIZE );
+        hasher.updateValue( m_mipLevel );
+        hasher.updateValue( static_cast<unsigned long long>( m_size ) );
+        for( const Digest& digest : m_blockDigests )
+            hasher.update( digest.bytes, DIGEST_SIZE );
+        Digest result;
+        hasher.finish( result.bytes );
+        return result;
+    }
+
+  private:
+    unsigned int        m_mipLevel;
+    unsigned int        m_numThreads;
+    unsigned long long  m_size = 0;
+    std::vector<char>   m_partial;
+    std::vector<Digest> m_blockDigests;
+};
+
+// Read a mip level into host memory, staging through device memory for device-filled images.
+bool readLevel( ImageSource& image, std::vector<char>& buffer, unsigned int mipLevel, unsigned int width, unsigned int height, CUstream stream )
+{
+    if( image.getFillType() == CU_MEMORYTYPE_HOST )
+        return image.readMipLevel( buffer.data(), mipLevel, width, height, stream );
+
+    CUdeviceptr devBuffer{};
+    OTK_ERROR_CHECK( cuMemAlloc( &devBuffer, buffer.size() ) );
+    bool result = image.readMipLevel( reinterpret_cast<char*>( devBuffer ), mipLevel, width, height, stream );
+    if( result )
+    {
+        OTK_ERROR_CHECK( cuStreamSynchronize( stream ) );
+        OTK_ERROR_CHECK( cuMemcpyDtoH( buffer.data(), devBuffer, buffer.size() ) );
+    }
+    OTK_ERROR_CHECK( cuMemFree( devBuffer ) );
+    return result;
+}
+
+// The layout of a mip level in memory: rows of blocks (of pixels, for uncompressed formats).
+struct LevelLayout
+{
+    CUarray_format format;
+    unsigned int   numChannels;
+    unsigned int   width;
+    unsigned int   height;
+    unsigned int   blockDim;
+
+    unsigned int numBlockRows() const { return ( height + blockDim - 1 ) / blockDim; }
+
+    // Bytes in one row of blocks of the given width (in pixels).
+    size_t rowSize( unsigned int rowWidth ) const { return getImageSizeInBytes( format, numChannels, rowWidth, blockDim ); }
+};
+
+// Hash a level band by band via readScanlines, reading whole chunks.  Returns false if the image
+// can't read partial levels, in which case nothing has been hashed.
+bool hashScanlineBands( ImageSource& image, const LevelLayout& level, unsigned int mipLevel, size_t maxReadSize, LevelHasher& hasher, std::vector<char>& buffer, CUstream stream )
+{
+    const unsigned int chunkHeight = image.getScanlineChunkHeight();
+    if( chunkHeight == 0 || level.blockDim != 1 )
+        return false;
+
+    const size_t       rowSize    = level.rowSize( level.width );
+    const unsigned int bandChunks = static_cast<unsigned int>( std::max<size_t>( 1, maxReadSize / ( rowSize * chunkHeight ) ) );
+    const unsigned int bandHeight = std::min( level.height, bandChunks * chunkHeight );
+    buffer.resize( rowSize * bandHeight );
+    for( unsigned int firstRow = 0; firstRow < level.height; firstRow += bandHeight )
+    {
+        const unsigned int numRows = std::min( bandHeight, level.height - firstRow );
+        if( !image.readScanlines( buffer.data(), mipLevel, firstRow, numRows, stream ) )
+        {
+            if( firstRow == 0 )
+                return false;
+            throw std::runtime_error( "Failed to read scanlines for image hash" );
+        }
+        hasher.update( buffer.data(), rowSize * numRows );
+    }
+    return true;
+}
+
+// Hash a level one band of tile rows at a time, using the image's native tile size and copying the
+// tiles into packed rows.  Returns false if the image has no native tiles, in which case nothing
+// has been hashed.
+bool hashTileBands( ImageSource& image, const TextureInfo& info, const LevelLayout& level, unsigned int mipLevel, size_t maxReadSize, LevelHasher& hasher, std::vector<char>& buffer, CUstream stream )
+{
+    const unsigned int tileWidth  = image.getTileWidth();
+    const unsigned int tileHeight = image.getTileHeight();
+    if( !info.isTiled || tileWidth == 0 || tileHeight == 0 || tileWidth % level.blockDim != 0 || tileHeight % level.blockDim != 0 )
+        return false;
+
+    const unsigned int numTilesX     = ( level.width + tileWidth - 1 ) / tileWidth;
+    const unsigned int numTilesY     = ( level.height + tileHeight - 1 ) / tileHeight;
+    const size_t       tileSize      = getImageSizeInBytes( level.format, level.numChannels, tileWidth, tileHeight );
+    const size_t       tileRowSize   = level.rowSize( tileWidth );
+    const size_t       levelRowSize  = level.rowSize( level.width );
+    const size_t       tileRowsSize  = levelRowSize * ( tileHeight / level.blockDim );
+    const unsigned int bandTileRows  = static_cast<unsigned int>( std::min<size_t>( numTilesY, std::max<size_t>( 1, maxReadSize / tileRowsSize ) ) );
+    std::vector<char>  tiles( tileSize * numTilesX );
+    buffer.resize( tileRowsSize * bandTileRows );
+
+    for( unsigned int bandY = 0; bandY < numTilesY; bandY += bandTileRows )
+    {
+        const unsigned int endY = std::min( numTilesY, bandY + bandTileRows );
+        for( unsigned int tileY = bandY; tileY < endY; ++tileY )
+        {
+            std::vector<std::future<bool>> reads;
+            for( unsigned int tileX = 0; tileX < numTilesX; ++tileX )
+                reads.push_back( image.readTileAsync( &tiles[tileX * tileSize], mipLevel, Tile{tileX, tileY, tileWidth, tileHeight}, stream ) );
+            bool ok = true;
+            for( std::future<bool>& read : reads )
+                ok = read.get() && ok;
+            if( !ok )
+                throw std::runtime_error( "Failed to read tile for image hash" );
+
+            // Copy the part of each tile that lies within the level into the band.
+            const unsigned int rows = ( std::min( tileHeight, level.height - tileY * tileHeight ) + level.blockDim - 1 ) / level.blockDim;
+            char*              dest = &buffer[( tileY - bandY ) * tileRowsSize];
+            for( unsigned int tileX = 0; tileX < numTilesX; ++tileX )
+            {
+                const size_t destX = level.rowSize( tileX * tileWidth );
+                const size_t width = level.rowSize( std::min( tileWidth, level.width - tileX * tileWidth ) );
+                for( unsigned int row = 0; row < rows; ++row )
+                    std::memcpy( dest + row * levelRowSize + destX, &tiles[tileX * tileSize + row * tileRowSize], width );
+            }
+        }
+        const unsigned int lastRows = ( std::min( endY * tileHeight, level.height ) - bandY * tileHeight + level.blockDim - 1 ) / level.blockDim;
+        hasher.update( buffer.data(), levelRowSize * lastRows );
+    }
+    return true;
+}
+
+unsigned long long getInfoKey( const TextureInfo& info, const ImageHashOptions& options )
+{
+    Blake2b hasher( 8 );
+    hashInfo( hasher, info, options.firstMipLevel, options.numMipLevels );
+    hasher.updateValue( options.maxLevelSize );
+    unsigned char digest[8];
+    hasher.finish( digest );
+    unsigned long long key = 0;
+    for( int i = 7; i >= 0; --i )
+        key = ( key << 8 ) | digest[i];
+    return key;
+}
+
+// Entries for variants of a file are keyed by the path followed by the variant.
+std::string getEntryKey( const std::string& path, const std::string& variant )
+{
+    return variant.empty() ? path : path + '#' + variant;
+}
+
+const char* const INDEX_HEADER = "# OptiXToolkit image hash index v3";
+
+}  // namespace
+
+ImageHash computeImageHash( ImageSource& image, const ImageHashOptions& options, CUstream stream )
+{
+    TextureInfo info;
+    image.open( &info );
+
+    const CUmemorytype fillType = image.getFillType();
+    if( !info.isValid || ( fillType != CU_MEMORYTYPE_HOST && fillType != CU_MEMORYTYPE_DEVICE ) )
+        return ImageHash{};
+
+    unsigned int       firstMipLevel = std::min( options.firstMipLevel, info.numMipLevels - 1 );
+    const unsigned int endMipLevel   = static_cast<unsigned int>(
+        std::min<unsigned long long>( static_cast<unsigned long long>( firstMipLevel ) + options.numMipLevels, info.numMipLevels ) );
+    while( options.maxLevelSize != 0 && firstMipLevel + 1 < endMipLevel
+           && std::max( 1U, info.width >> firstMipLevel ) + std::max( 1U, info.height >> firstMipLevel ) > options.maxLevelSize )
+        ++firstMipLevel;
+    const unsigned int numThreads = getNumThreads( options );
+
+    Blake2b hasher( DIGEST_SIZE );
+    hashInfo( hasher, info, firstMipLevel, endMipLevel - firstMipLevel );
+
+    std::vector<char> buffer;
+    for( unsigned int mipLevel = firstMipLevel; mipLevel < endMipLevel; ++mipLevel )
+    {
+        const LevelLayout level{info.format, info.numChannels, std::max( 1U, info.width >> mipLevel ),
+                                std::max( 1U, info.height >> mipLevel ), getBlockDim( info.format )};
+        const size_t      levelSize = getImageSizeInBytes( level.format, level.numChannels, level.width, level.height );
+
+        // Stream large host-filled levels in bands when the image can read partial levels, so that
+        // hashing doesn't hold a whole level in memory.
+        LevelHasher levelHasher( mipLevel, numThreads );
+        const bool  banded = fillType == CU_MEMORYTYPE_HOST && options.maxReadSize != 0 && levelSize > options.maxReadSize
+                            && ( hashScanlineBands( image, level, mipLevel, options.maxReadSize, levelHasher, buffer, stream )
+                                 || hashTileBands( image, info, level, mipLevel, options.maxReadSize, levelHasher, buffer, stream ) );
+        if( !banded )
+        {
+            buffer.assign( levelSize, 0 );
+            if( !readLevel( image, buffer, mipLevel, level.width, level.height, stream ) )
+                return ImageHash{};
+            levelHasher.update( buffer.data(), buffer.size() );
+        }
+
+        const Digest levelDigest = levelHasher.finish();
+        hasher.update( levelDigest.bytes, DIGEST_SIZE );
+    }
+
+    Digest digest;
+    hasher.finish( digest.bytes );
+    return toImageHash( digest );
+}
+
+unsigned long long ImageSource::getHash( CUstream stream )
+{
+    ImageHashOptions options;
+    options.maxLevelSize = COARSE_HASH_LEVEL_SIZE;
+    return computeImageHash( *this, options, stream ).fold();
+}
+
+ImageHashIndex::ImageHashIndex( const std::string& indexFilename, const ImageHashOptions& options )
+    : m_indexFilename( indexFilename )
+    , m_options( options )
+{
+    load();
+}
+
+ImageHashIndex::~ImageHashIndex()
+{
+    if( m_modified )
+        save();
+}
+
+ImageHash ImageHashIndex::getHash( ImageSource& image, CUstream stream )
+{
+    TextureInfo info;
+    image.open( &info );
+
+    const std::string path    = image.getFilename();
+    const std::string variant = image.getFileVariant();
+    ImageHash         hash{};
+    if( find( path, info, hash, variant ) )
+        return hash;
+
+    hash = computeImageHash( image, m_options, stream );
+    if( hash.isValid() )
+        insert( path, info, hash, variant );
+    return hash;
+}
+
+bool ImageHashIndex::find( const std::string& path, const TextureInfo& info, ImageHash& hash, const std::string& variant ) const
+{
+    long long modificationTime;
+    long long fileSize;
+    if( !getFileStatus( path, modificationTime, fileSize ) )
+        return false;
+
+    std::unique_lock<std::mutex> lock( m_mutex );
+    auto                         it = m_entries.find( getEntryKey( path, variant ) );
+    if( it == m_entries.end() )
+        return false;
+
+    const Entry& entry = it->second;
+    if( entry.modificationTime != modificationTime || entry.fileSize != fileSize || entry.infoKey != getInfoKey( info, m_options ) )
+        return false;
+
+    hash = entry.hash;
+    return true;
+}
+
+void ImageHashIndex::insert( const std::string& path, const TextureInfo& info, const ImageHash& hash, const std::string& variant )
+{
+    Entry entry;
+    if( !getFileStatus( path, entry.modificationTime, entry.fileSize ) )
+        return;
+    entry.infoKey = getInfoKey( info, m_options );
+    entry.hash    = hash;
+
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_entries[getEntryKey( path, variant )] = entry;
+    m_modified                              = true;
+}
+
+size_t ImageHashIndex::size() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_entries.size();
+}
+
+void ImageHashIndex::load()
+{
+    if( m_indexFilename.empty() )
+        return;
+
+    std::ifstream file( m_indexFilename );
+    std::string   line;
+    if( !std::getline( file, line ) || line != INDEX_HEADER )
+        return;
+
+    // Each line holds the hash, file modification time, file size and info key, followed by the path
+    // (and variant).
+    while( std::getline( file, line ) )
+    {
+        std::istringstream str( line );
+        Entry              entry;
+        std::string        path;
+        str >> std::hex >> entry.hash.hi >> entry.hash.lo >> std::dec >> entry.modificationTime >> entry.fileSize
+            >> std::hex >> entry.infoKey;
+        if( !str || str.get() != ' ' || !std::getline( str, path ) || path.empty() )
+            continue;
+        m_entries[path] = entry;
+    }
+}
+
+bool ImageHashIndex::save()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    if( m_indexFilename.empty() )
+        return false;
+
+    // Write to a temporary file that is unique to this process and call, and rename it into place,
+    // so that concurrent readers never see a partial index and concurrent writers don't clobber
+    // each other's temporary file.
+    const std::string tempFilename = getTempFilename( m_indexFilename );
+    {
+        std::ofstream file( tempFilename, std::ios::trunc );
+        file << INDEX_HEADER << '\n';
+        for( const auto& keyValue : m_entries )
+        {
+            const Entry& entry = keyValue.second;
+            file << std::hex << entry.hash.hi << ' ' << entry.hash.lo << ' ' << std::dec << entry.modificationTime << ' '
+                 << entry.fileSize << ' ' << std::hex << entry.infoKey << ' ' << keyValue.first << '\n';
+        }
+        if( !file )
+        {
+            file.close();
+            std::remove( tempFilename.c_str() );
+            return false;
+        }
+    }
+    if( !replaceFile( tempFilename, m_indexFilename ) )
+        return false;
+    m_modified = false;
+    return true;
+}
+
+}  // namespace imageSource
@@ -8,13 +8,18 @@
 
 #include <OptiXToolkit/Error/cuErrorCheck.h>
 #include <OptiXToolkit/ImageSource/CheckerBoardImage.h>
+#include <OptiXToolkit/ImageSource/ConvertingImageSource.h>
 #include <OptiXToolkit/ImageSource/CoreEXRReader.h>
+#include <OptiXToolkit/ImageSource/DDSReader.h>
+#include <OptiXToolkit/ImageSource/KTXReader.h>
 #if OTK_USE_OIIO
 #include <OptiXToolkit/ImageSource/OIIOReader.h>
 #endif
 
 #include <cstddef>  // for size_t
+#include <exception>
 #include <fstream>
+#include <future>
 #include <memory>
 #include <string>
 
@@ -30,55 +35,37 @@ bool fileExists( const std::string& path )
 
 namespace imageSource {
 
-unsigned long long ImageSource::getHash( CUstream stream )
+std::future<bool> ImageSource::readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
 {
-    TextureInfo info;
-    open( &info );
-
-    // FIXME: Handle non-host fulfilled image types
-    if( getFillType() != CU_MEMORYTYPE_HOST )
-        return 0ULL;
-
-    // Start hash as checksum of info
-    const unsigned long long m = 1013904223ULL;
-    unsigned long long hash = info.width;
-    hash = hash * m + info.height;
-    hash = hash * m + info.format;
-    hash = hash * m + info.numChannels;
-    hash = hash * m + info.numMipLevels;
-
-    // Continue with checksum of a coarse mip level.
-    int mipLevel = static_cast<int>( log2f( (info.width + info.height) / 64.0f ) );
-    mipLevel = std::max( std::min( mipLevel, (int)info.numMipLevels-1 ), 0 );
-
-    unsigned int levelWidth = info.width >> mipLevel;
-    unsigned int levelHeight = info.height >> mipLevel;
-    unsigned int mipLevelSize = levelWidth * levelHeight * getBytesPerChannel( info.format ) * info.numChannels;
-    std::vector<unsigned long long> buffer( ( mipLevelSize + 7 ) / 8 );
-    buffer.back() = 0;
-    readMipLevel( (char*)buffer.data(), mipLevel, levelWidth, levelHeight, stream );
-
-    for( unsigned int i = 0; i < buffer.size(); ++i )
-        hash = hash * m + buffer[i];
-
-    return hash;
+    std::promise<bool> result;
+    try
+    {
+        result.set_value( readTile( dest, mipLevel, tile, stream ) );
+    }
+    catch( ... )
+    {
+        result.set_exception( std::current_exception() );
+    }
+    return result.get_future();
 }
 
 bool ImageSourceBase::readMipTail( char*        dest,
                                    unsigned int mipTailFirstLevel,
                                    unsigned int numMipLevels,
                                    const uint2* mipLevelDims,
-                                   unsigned int pixelSizeInBytes,
+                                   unsigned int /*pixelSizeInBytes*/,
                                    CUstream     stream )
 {
-    size_t offset = 0;
+    // The pixel size is zero for block-compressed formats, so the level sizes are computed from the format.
+    const TextureInfo& info   = getInfo();
+    size_t             offset = 0;
     for( unsigned int mipLevel = mipTailFirstLevel; mipLevel < numMipLevels; ++mipLevel )
     {
         const uint2 levelDims = mipLevelDims[mipLevel];
         readMipLevel( dest + offset, mipLevel, levelDims.x, levelDims.y, stream );
 
         // Increment offset.
-        offset += levelDims.x * levelDims.y * pixelSizeInBytes;
+        offset += getImageSizeInBytes( info.format, info.numChannels, levelDims.x, levelDims.y );
     }
 
     return true;
@@ -99,6 +86,15 @@ std::shared_ptr<ImageSource> createImageSource( const std::string& filename, con
     // Attempt relative path first, then absolute path.
     const std::string path = directory.empty() ? filename : ( fileExists( filename ) ? filename : directory + '/' + filename );
 
+    // GPU-ready formats are streamed directly, without a third-party library.
+    if( extension == ".dds" )
+    {
+        return std::make_shared<DDSReader>( path );
+    }
+    if( extension == ".ktx2" )
+    {
+        return std::make_shared<KTXReader>( path );
+    }
 #if OTK_USE_OPENEXR    
     if( extension == ".exr" )
     {
@@ -112,4 +108,9 @@ std::shared_ptr<ImageSource> createImageSource( const std::string& filename, con
 #endif
 }
 
+std::shared_ptr<ImageSource> createImageSource( const std::string& filename, const OutputFormat& outputFormat, const std::string& directory )
+{
+    return std::make_shared<ConvertingImageSource>( createImageSource( filename, directory ), outputFormat );
+}
+
 }  // namespace imageSource
@@ -4,31 +4,330 @@
 
 #include <OptiXToolkit/ImageSource/ImageSourceCache.h>
 
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+#include <OptiXToolkit/ImageSource/ThrottledImageSource.h>
+#include <OptiXToolkit/ImageSource/WrappedImageSource.h>
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <utility>
+
 namespace imageSource {
 
+class LimitedImageSource;
+
+/// OpenImageLimiter tracks the open images created by an ImageSourceCache in least recently used
+/// order, closing idle images when there are too many open.
+class OpenImageLimiter
+{
+  public:
+    explicit OpenImageLimiter( unsigned int maxOpenImages )
+        : m_maxOpenImages( maxOpenImages )
+    {
+    }
+
+    /// Mark the given open image as most recently used, closing idle images if over the limit.
+    void touch( LimitedImageSource* image );
+
+    /// Stop tracking the given image, which has been closed or destroyed.
+    void remove( LimitedImageSource* image );
+
+    unsigned int getNumOpenImages() const
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        return static_cast<unsigned int>( m_lru.size() );
+    }
+
+    std::atomic<unsigned long long> numOpens{ 0 };
+    std::atomic<unsigned long long> numCloses{ 0 };
+    std::atomic<unsigned long long> numHandleHits{ 0 };
+    std::atomic<unsigned long long> numHandleMisses{ 0 };
+
+  private:
+    mutable std::mutex             m_mutex;
+    unsigned int                   m_maxOpenImages;
+    std::list<LimitedImageSource*> m_lru;  // most recently used first
+};
+
+/// LimitedImageSource wraps an image created by the cache.  The wrapped image is opened lazily and
+/// may be closed by the OpenImageLimiter whenever no reads are in flight.  The TextureInfo is
+/// retained while the wrapped image is closed.
+class LimitedImageSource : public WrappedImageSource, public std::enable_shared_from_this<LimitedImageSource>
+{
+  public:
+    LimitedImageSource( std::shared_ptr<ImageSource> image, std::shared_ptr<OpenImageLimiter> limiter )
+        : WrappedImageSource( std::move( image ) )
+        , m_limiter( std::move( limiter ) )
+    {
+    }
+
+    ~LimitedImageSource() override { m_limiter->remove( this ); }
+
+    void open( TextureInfo* info ) override
+    {
+        acquireHandle( /*isRead=*/false );
+        releaseHandle();
+        if( info != nullptr )
+            *info = m_info;
+    }
+
+    void close() override
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            if( m_handleIsOpen )
+                WrappedImageSource::close();
+            m_handleIsOpen = false;
+            m_isOpen       = false;
+        }
+        m_limiter->remove( this );
+    }
+
+    bool isOpen() const override { return m_isOpen; }
+
+    const TextureInfo& getInfo() const override { return m_isOpen ? m_info : WrappedImageSource::getInfo(); }
+
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override
+    {
+        HandleGuard guard( this );
+        return WrappedImageSource::readTile( dest, mipLevel, tile, stream );
+    }
+
+    // The wrapped image is pinned open until the read completes.  The returned future retains this
+    // image, which releases the handle when the result is retrieved or the future is destroyed.
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override
+    {
+        std::shared_ptr<LimitedImageSource> self( shared_from_this() );
+        acquireHandle( /*isRead=*/true );
+        std::shared_ptr<void>               handle( nullptr, [self]( void* ) { self->releaseHandle(); } );
+        return retainUntilRead( WrappedImageSource::readTileAsync( dest, mipLevel, tile, stream ), handle );
+    }
+
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override
+    {
+        HandleGuard guard( this );
+        return WrappedImageSource::readMipLevel( dest, mipLevel, expectedWidth, expectedHeight, stream );
+    }
+
+    bool readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream ) override
+    {
+        HandleGuard guard( this );
+        return WrappedImageSource::readScanlines( dest, mipLevel, firstRow, numRows, stream );
+    }
+
+    // Like the info, the chunk height is retained while the wrapped image is closed.
+    unsigned int getScanlineChunkHeight() const override
+    {
+        return m_isOpen ? m_scanlineChunkHeight.load() : WrappedImageSource::getScanlineChunkHeight();
+    }
+
+    bool readMipTail( char*        dest,
+                      unsigned int mipTailFirstLevel,
+                      unsigned int numMipLevels,
+                      const uint2* mipLevelDims,
+                      unsigned int pixelSizeInBytes,
+                      CUstream     stream ) override
+    {
+        HandleGuard guard( this );
+        return WrappedImageSource::readMipTail( dest, mipTailFirstLevel, numMipLevels, mipLevelDims, pixelSizeInBytes, stream );
+    }
+
+    bool readBaseColor( float4& dest ) override
+    {
+        HandleGuard guard( this );
+        return WrappedImageSource::readBaseColor( dest );
+    }
+
+    /// Close the wrapped image unless it is busy.  Returns true if the image was closed.  Called by
+    /// the OpenImageLimiter while holding its mutex.
+    bool tryCloseHandle()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex, std::try_to_lock );
+        if( !lock.owns_lock() || !m_handleIsOpen || m_numReadsInFlight > 0 )
+            return false;
+        WrappedImageSource::close();
+        m_handleIsOpen = false;
+        return true;
+    }
+
+  private:
+    friend class OpenImageLimiter;
+
+    struct HandleGuard
+    {
+        explicit HandleGuard( LimitedImageSource* image )
+            : m_image( image )
+        {
+            m_image->acquireHandle( /*isRead=*/true );
+        }
+        ~HandleGuard() { m_image->releaseHandle(); }
+
+        LimitedImageSource* m_image;
+    };
+
+    // Open the wrapped image if necessary and pin it open until releaseHandle is called.
+    void acquireHandle( bool isRead )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            const bool                   wasOpen = m_handleIsOpen;
+            if( !wasOpen )
+            {
+                WrappedImageSource::open( &m_info );
+                m_scanlineChunkHeight = WrappedImageSource::getScanlineChunkHeight();
+                m_handleIsOpen        = true;
+                m_isOpen              = true;
+                ++m_limiter->numOpens;
+            }
+            if( isRead )
+                ++( wasOpen ? m_limiter->numHandleHits : m_limiter->numHandleMisses );
+            ++m_numReadsInFlight;
+        }
+        // The limiter locks images while holding its own mutex, so it must be called without
+        // holding ours.
+        m_limiter->touch( this );
+    }
+
+    void releaseHandle()
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        --m_numReadsInFlight;
+    }
+
+    std::shared_ptr<OpenImageLimiter> m_limiter;
+    std::mutex                        m_mutex;
+    TextureInfo                       m_info{};
+    std::atomic<bool>                 m_isOpen{ false };
+    std::atomic<unsigned int>         m_scanlineChunkHeight{ 0 };
+    bool                              m_handleIsOpen     = false;
+    unsigned int                      m_numReadsInFlight = 0;
+
+    // Guarded by the OpenImageLimiter mutex.
+    bool                                     m_inLru = false;
+    std::list<LimitedImageSource*>::iterator m_lruPosition;
+};
+
+void OpenImageLimiter::touch( LimitedImageSource* image )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    if( image->m_inLru )
+    {
+        m_lru.splice( m_lru.begin(), m_lru, image->m_lruPosition );
+    }
+    else
+    {
+        m_lru.push_front( image );
+        image->m_lruPosition = m_lru.begin();
+        image->m_inLru       = true;
+    }
+
+    if( m_maxOpenImages == 0 )
+        return;
+
+    // Close the least recently used images that are idle.
+    auto it = m_lru.end();
+    while( m_lru.size() > m_maxOpenImages && it != m_lru.begin() )
+    {
+        --it;
+        LimitedImageSource* candidate = *it;
+        if( candidate != image && candidate->tryCloseHandle() )
+        {
+            candidate->m_inLru = false;
+            it                 = m_lru.erase( it );
+            ++numCloses;
+        }
+    }
+}
+
+void OpenImageLimiter::remove( LimitedImageSource* image )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    if( image->m_inLru )
+    {
+        m_lru.erase( image->m_lruPosition );
+        image->m_inLru = false;
+    }
+}
+
+ImageSourceCache::ImageSourceCache( unsigned int maxOpenImages, Factory factory, bool throttleReads )
+    : m_factory( std::move( factory ) )
+    , m_limiter( std::make_shared<OpenImageLimiter>( maxOpenImages ) )
+    , m_throttleReads( throttleReads )
+{
+}
+
+ImageSourceCache::~ImageSourceCache() = default;
+
+ImageSourceCache::Shard& ImageSourceCache::getShard( const std::string& path )
+{
+    return m_shards[std::hash<std::string>()( path ) % NUM_SHARDS];
+}
+
+const ImageSourceCache::Shard& ImageSourceCache::getShard( const std::string& path ) const
+{
+    return m_shards[std::hash<std::string>()( path ) % NUM_SHARDS];
+}
+
+std::shared_ptr<ImageSource> ImageSourceCache::find( const std::string& path ) const
+{
+    const Shard&                 shard = getShard( path );
+    std::unique_lock<std::mutex> lock( shard.mutex );
+    auto                         it = shard.images.find( path );
+    return it == shard.images.end() ? std::shared_ptr<ImageSource>() : it->second;
+}
+
 std::shared_ptr<ImageSource> ImageSourceCache::get( const std::string& path )
 {
+    Shard&                       shard = getShard( path );
+    std::unique_lock<std::mutex> lock( shard.mutex );
+
     // Use a cached ImageSource if possible.
-    std::shared_ptr<ImageSource> imageSource{ find( path ) };
-    if( imageSource )
-        return imageSource;
+    auto it = shard.images.find( path );
+    if( it != shard.images.end() )
+        return it->second;
 
-    // Create a new ImageSource and cache it.
-    imageSource = createImageSource( path );
-    m_cache[path] = imageSource;
+    // Create a new ImageSource and cache it.  Creation does not open the file, so it is cheap
+    // enough to do while holding the shard lock.
+    std::shared_ptr<ImageSource> imageSource = m_factory ? m_factory( path ) : createImageSource( path );
+    // The throttle is inside the limiter, so that it sees the wrapped image open while reading.
+    if( m_throttleReads )
+        imageSource = std::make_shared<ThrottledImageSource>( imageSource );
+    imageSource = std::make_shared<LimitedImageSource>( imageSource, m_limiter );
+    shard.images[path] = imageSource;
     return imageSource;
 }
 
+void ImageSourceCache::set( const std::string& path, const std::shared_ptr<ImageSource>& image )
+{
+    Shard&                       shard = getShard( path );
+    std::unique_lock<std::mutex> lock( shard.mutex );
+    shard.images[path] = image;
+}
+
+unsigned int ImageSourceCache::getNumOpenImages() const
+{
+    return m_limiter->getNumOpenImages();
+}
+
 CacheStatistics ImageSourceCache::getStatistics() const
 {
     CacheStatistics result{};
-    for (const auto &keyValue :  m_cache)
+    for( const Shard& shard : m_shards )
     {
-        ++result.numImageSources;
-        result.totalBytesRead += keyValue.second->getNumBytesRead();
-        result.totalTilesRead += keyValue.second->getNumTilesRead();
-        result.totalReadTime += keyValue.second->getTotalReadTime();
+        std::unique_lock<std::mutex> lock( shard.mutex );
+        for( const auto& keyValue : shard.images )
+        {
+            ++result.numImageSources;
+            result.totalBytesRead += keyValue.second->getNumBytesRead();
+            result.totalTilesRead += keyValue.second->getNumTilesRead();
+            result.totalReadTime += keyValue.second->getTotalReadTime();
+        }
     }
+    result.numOpens        = m_limiter->numOpens;
+    result.numCloses       = m_limiter->numCloses;
+    result.numHandleHits   = m_limiter->numHandleHits;
+    result.numHandleMisses = m_limiter->numHandleMisses;
     return result;
 }
 
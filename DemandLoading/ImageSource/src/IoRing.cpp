@@ -0,0 +1,221 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "IoRing.h"
+
+#if defined( __linux__ ) && defined( __has_include )
+#if __has_include( <linux/io_uring.h> )
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#if defined( __NR_io_uring_setup ) && defined( __NR_io_uring_enter )
+#define OTK_HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+namespace imageSource {
+
+#ifdef OTK_HAVE_IO_URING
+
+namespace {
+
+int ioUringSetup( unsigned int numEntries, io_uring_params* params )
+{
+    return static_cast<int>( syscall( __NR_io_uring_setup, numEntries, params ) );
+}
+
+int ioUringEnter( int fd, unsigned int numToSubmit, unsigned int minComplete, unsigned int flags )
+{
+    return static_cast<int>( syscall( __NR_io_uring_enter, fd, numToSubmit, minComplete, flags, nullptr, 0 ) );
+}
+
+template <typename T>
+T* ringField( void* ring, unsigned int offset )
+{
+    return reinterpret_cast<T*>( static_cast<char*>( ring ) + offset );
+}
+
+}  // namespace
+
+std::unique_ptr<IoRing> IoRing::create( unsigned int numEntries )
+{
+    io_uring_params params;
+    std::memset( &params, 0, sizeof( params ) );
+    const int fd = ioUringSetup( numEntries, &params );
+    if( fd < 0 )
+        return nullptr;
+
+    // The destructor unmaps whatever was mapped if a later step fails.
+    std::unique_ptr<IoRing> ring( new IoRing );
+    ring->m_fd         = fd;
+    ring->m_numEntries = params.sq_entries;
+    ring->m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof( unsigned int );
+    ring->m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+
+    // Newer kernels map both rings with a single mapping.
+    const bool singleMap = ( params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+    if( singleMap )
+        ring->m_sqRingSize = std::max( ring->m_sqRingSize, ring->m_cqRingSize );
+    void* sqRing = mmap( nullptr, ring->m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+    if( sqRing == MAP_FAILED )
+        return nullptr;
+    ring->m_sqRing = sqRing;
+    if( singleMap )
+    {
+        ring->m_cqRing     = sqRing;
+        ring->m_cqRingSize = 0;
+    }
+    else
+    {
+        void* cqRing = mmap( nullptr, ring->m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+        if( cqRing == MAP_FAILED )
+            return nullptr;
+        ring->m_cqRing = cqRing;
+    }
+    ring->m_sqesSize = params.sq_entries * sizeof( io_uring_sqe );
+    void* sqes = mmap( nullptr, ring->m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES );
+    if( sqes == MAP_FAILED )
+        return nullptr;
+    ring->m_sqes = static_cast<io_uring_sqe*>( sqes );
+
+    ring->m_sqTail  = ringField<unsigned int>( ring->m_sqRing, params.sq_off.tail );
+    ring->m_sqMask  = ringField<unsigned int>( ring->m_sqRing, params.sq_off.ring_mask );
+    ring->m_sqArray = ringField<unsigned int>( ring->m_sqRing, params.sq_off.array );
+    ring->m_cqHead  = ringField<unsigned int>( ring->m_cqRing, params.cq_off.head );
+    ring->m_cqTail  = ringField<unsigned int>( ring->m_cqRing, params.cq_off.tail );
+    ring->m_cqMask  = ringField<unsigned int>( ring->m_cqRing, params.cq_off.ring_mask );
+    ring->m_cqes    = ringField<io_uring_cqe>( ring->m_cqRing, params.cq_off.cqes );
+    return ring;
+}
+
+IoRing::~IoRing()
+{
+    if( m_sqes != nullptr )
+        munmap( m_sqes, m_sqesSize );
+    if( m_cqRing != nullptr && m_cqRingSize != 0 )
+        munmap( m_cqRing, m_cqRingSize );
+    if( m_sqRing != nullptr )
+        munmap( m_sqRing, m_sqRingSize );
+    if( m_fd >= 0 )
+        close( m_fd );
+}
+
+bool IoRing::readAll( Read* reads, size_t numReads )
+{
+    if( m_failed )
+        return false;
+    size_t       next        = 0;
+    unsigned int numInFlight = 0;
+    while( next < numReads || numInFlight > 0 )
+    {
+        // Queue as many reads as there are free entries.  The completion ring is twice the size
+        // of the submission ring, so it cannot overflow.
+        const unsigned int numToQueue = static_cast<unsigned int>( std::min<size_t>( m_numEntries - numInFlight, numReads - next ) );
+        if( numToQueue > 0 )
+        {
+            unsigned int tail = *m_sqTail;
+            for( unsigned int i = 0; i < numToQueue; ++i, ++tail, ++next )
+            {
+                const unsigned int index = tail & *m_sqMask;
+                io_uring_sqe&      sqe   = m_sqes[index];
+                std::memset( &sqe, 0, sizeof( sqe ) );
+                sqe.opcode       = IORING_OP_READV;
+                sqe.fd           = reads[next].fd;
+                sqe.addr         = reinterpret_cast<std::uintptr_t>( reads[next].iov );
+                sqe.len          = reads[next].numIov;
+                sqe.off          = reads[next].offset;
+                sqe.user_data    = next;
+                m_sqArray[index] = index;
+            }
+            __atomic_store_n( m_sqTail, tail, __ATOMIC_RELEASE );
+            if( !submit( reads, numToQueue, numInFlight ) )
+                return drain( reads, numInFlight );
+        }
+        if( numInFlight > 0 && !waitForCompletion( reads, numInFlight ) )
+            return drain( reads, numInFlight );
+    }
+    return true;
+}
+
+bool IoRing::submit( Read* reads, unsigned int numToSubmit, unsigned int& numInFlight )
+{
+    while( numToSubmit > 0 )
+    {
+        const int numSubmitted = ioUringEnter( m_fd, numToSubmit, 0, 0 );
+        if( numSubmitted > 0 )
+        {
+            numToSubmit -= static_cast<unsigned int>( numSubmitted );
+            numInFlight += static_cast<unsigned int>( numSubmitted );
+        }
+        else if( numSubmitted < 0 && errno == EINTR )
+            continue;
+        else if( numInFlight == 0 || ( numSubmitted < 0 && errno != EAGAIN && errno != EBUSY ) )
+            return false;
+        // The kernel is short of resources, so make room by reaping a completion.
+        else if( !waitForCompletion( reads, numInFlight ) )
+            return false;
+    }
+    return true;
+}
+
+bool IoRing::waitForCompletion( Read* reads, unsigned int& numInFlight )
+{
+    while( true )
+    {
+        unsigned int       head = *m_cqHead;
+        const unsigned int tail = __atomic_load_n( m_cqTail, __ATOMIC_ACQUIRE );
+        if( head != tail )
+        {
+            for( ; head != tail; ++head )
+            {
+                const io_uring_cqe& cqe     = m_cqes[head & *m_cqMask];
+                reads[cqe.user_data].result = cqe.res;
+                --numInFlight;
+            }
+            __atomic_store_n( m_cqHead, head, __ATOMIC_RELEASE );
+            return true;
+        }
+        if( ioUringEnter( m_fd, 0, 1, IORING_ENTER_GETEVENTS ) < 0 && errno != EINTR )
+            return false;
+    }
+}
+
+bool IoRing::drain( Read* reads, unsigned int& numInFlight )
+{
+    // The destinations of reads in flight must not be released until the reads complete.  Reads
+    // left in the submission ring are never submitted, since the ring is not used again.
+    m_failed = true;
+    while( numInFlight > 0 )
+    {
+        if( !waitForCompletion( reads, numInFlight ) )
+            break;
+    }
+    return false;
+}
+
+#else
+
+std::unique_ptr<IoRing> IoRing::create( unsigned int /*numEntries*/ )
+{
+    return nullptr;
+}
+
+IoRing::~IoRing() = default;
+
+bool IoRing::readAll( Read* /*reads*/, size_t /*numReads*/ )
+{
+    return false;
+}
+
+#endif
+
+}  // namespace imageSource
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+struct iovec;
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace imageSource {
+
+/// IoRing submits batches of positional vectored reads through an io_uring instance (Linux), so
+/// that the reads are in flight together and complete in any order, rather than one preadv call
+/// after another.  It uses the io_uring system calls directly, so it needs no liburing.  A ring
+/// is not thread safe; each thread that reads should create its own.
+class IoRing
+{
+  public:
+    /// A vectored read of a file at an offset.  On completion, result holds the number of bytes
+    /// read, which may be short, or a negated errno value.
+    struct Read
+    {
+        int                fd;
+        const iovec*       iov;
+        unsigned int       numIov;
+        unsigned long long offset;
+        long long          result;
+    };
+
+    /// Create a ring with room for the given number of reads in flight.  Returns null if io_uring
+    /// is unavailable (not Linux, an old kernel, or disabled by a sysctl or seccomp filter).
+    static std::unique_ptr<IoRing> create( unsigned int numEntries );
+
+    ~IoRing();
+
+    IoRing( const IoRing& )            = delete;
+    IoRing& operator=( const IoRing& ) = delete;
+
+    /// Submit the given reads, at most numEntries at a time, and wait for all of them to complete.
+    /// Returns false if the ring itself failed, in which case no read is left in flight, the
+    /// results are undefined, and later calls fail immediately.
+    bool readAll( Read* reads, size_t numReads );
+
+  private:
+    IoRing() = default;
+
+    int           m_fd         = -1;
+    unsigned int  m_numEntries = 0;
+    bool          m_failed     = false;
+    void*         m_sqRing     = nullptr;
+    size_t        m_sqRingSize = 0;
+    void*         m_cqRing     = nullptr;
+    size_t        m_cqRingSize = 0;
+    io_uring_sqe* m_sqes       = nullptr;
+    size_t        m_sqesSize   = 0;
+
+    // Fields of the shared submission and completion rings.
+    unsigned int* m_sqTail  = nullptr;
+    unsigned int* m_sqMask  = nullptr;
+    unsigned int* m_sqArray = nullptr;
+    unsigned int* m_cqHead  = nullptr;
+    unsigned int* m_cqTail  = nullptr;
+    unsigned int* m_cqMask  = nullptr;
+    io_uring_cqe* m_cqes    = nullptr;
+
+    bool submit( Read* reads, unsigned int numToSubmit, unsigned int& numInFlight );
+    bool waitForCompletion( Read* reads, unsigned int& numInFlight );
+    bool drain( Read* reads, unsigned int& numInFlight );
+};
+
+}  // namespace imageSource
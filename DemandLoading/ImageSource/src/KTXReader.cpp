@@ -0,0 +1,225 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/KTXReader.h>
+
+#include "Config.h"  // for OTK_USE_ZSTD
+#include "RandomAccessFile.h"
+
+#if OTK_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace imageSource {
+
+namespace {
+
+// Layout of the KTX2 header, as byte offsets from the start of the file.
+const unsigned int KTX_HEADER_SIZE        = 80;
+const unsigned int KTX_VK_FORMAT          = 12;
+const unsigned int KTX_PIXEL_WIDTH        = 20;
+const unsigned int KTX_PIXEL_HEIGHT       = 24;
+const unsigned int KTX_PIXEL_DEPTH        = 28;
+const unsigned int KTX_LAYER_COUNT        = 32;
+const unsigned int KTX_FACE_COUNT         = 36;
+const unsigned int KTX_LEVEL_COUNT        = 40;
+const unsigned int KTX_SUPERCOMPRESSION   = 44;
+const unsigned int KTX_LEVEL_INDEX_STRIDE = 24;
+
+// Supercompression schemes.
+const std::uint32_t KTX_SUPERCOMPRESSION_NONE = 0;
+const std::uint32_t KTX_SUPERCOMPRESSION_ZSTD = 2;
+
+const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+std::uint32_t readU32( const unsigned char* bytes, unsigned int offset )
+{
+    return std::uint32_t( bytes[offset] ) | std::uint32_t( bytes[offset + 1] ) << 8 | std::uint32_t( bytes[offset + 2] ) << 16
+           | std::uint32_t( bytes[offset + 3] ) << 24;
+}
+
+std::uint64_t readU64( const unsigned char* bytes, unsigned int offset )
+{
+    return std::uint64_t( readU32( bytes, offset ) ) | std::uint64_t( readU32( bytes, offset + 4 ) ) << 32;
+}
+
+// Get the format and channel count for a VkFormat value.  Returns false if unsupported.
+bool getVkFormat( std::uint32_t vkFormat, CUarray_format& format, unsigned int& numChannels )
+{
+    switch( vkFormat )
+    {
+        case 9:  // R8_UNORM
+            format = CU_AD_FORMAT_UNSIGNED_INT8, numChannels = 1;
+            return true;
+        case 16:  // R8G8_UNORM
+            format = CU_AD_FORMAT_UNSIGNED_INT8, numChannels = 2;
+            return true;
+        case 37:  // R8G8B8A8_UNORM
+        case 43:  // R8G8B8A8_SRGB
+            format = CU_AD_FORMAT_UNSIGNED_INT8, numChannels = 4;
+            return true;
+        case 76:  // R16_SFLOAT
+            format = CU_AD_FORMAT_HALF, numChannels = 1;
+            return true;
+        case 83:  // R16G16_SFLOAT
+            format = CU_AD_FORMAT_HALF, numChannels = 2;
+            return true;
+        case 97:  // R16G16B16A16_SFLOAT
+            format = CU_AD_FORMAT_HALF, numChannels = 4;
+            return true;
+        case 100:  // R32_SFLOAT
+            format = CU_AD_FORMAT_FLOAT, numChannels = 1;
+            return true;
+        case 103:  // R32G32_SFLOAT
+            format = CU_AD_FORMAT_FLOAT, numChannels = 2;
+            return true;
+        case 109:  // R32G32B32A32_SFLOAT
+            format = CU_AD_FORMAT_FLOAT, numChannels = 4;
+            return true;
+#if CUDA_VERSION >= 11050
+        case 131:  // BC1_RGB_UNORM_BLOCK
+        case 133:  // BC1_RGBA_UNORM_BLOCK
+            format = CU_AD_FORMAT_BC1_UNORM;
+            break;
+        case 132:  // BC1_RGB_SRGB_BLOCK
+        case 134:  // BC1_RGBA_SRGB_BLOCK
+            format = CU_AD_FORMAT_BC1_UNORM_SRGB;
+            break;
+        case 135:  // BC2_UNORM_BLOCK
+            format = CU_AD_FORMAT_BC2_UNORM;
+            break;
+        case 136:  // BC2_SRGB_BLOCK
+            format = CU_AD_FORMAT_BC2_UNORM_SRGB;
+            break;
+        case 137:  // BC3_UNORM_BLOCK
+            format = CU_AD_FORMAT_BC3_UNORM;
+            break;
+        case 138:  // BC3_SRGB_BLOCK
+            format = CU_AD_FORMAT_BC3_UNORM_SRGB;
+            break;
+        case 139:  // BC4_UNORM_BLOCK
+            format = CU_AD_FORMAT_BC4_UNORM;
+            break;
+        case 140:  // BC4_SNORM_BLOCK
+            format = CU_AD_FORMAT_BC4_SNORM;
+            break;
+        case 141:  // BC5_UNORM_BLOCK
+            format = CU_AD_FORMAT_BC5_UNORM;
+            break;
+        case 142:  // BC5_SNORM_BLOCK
+            format = CU_AD_FORMAT_BC5_SNORM;
+            break;
+        case 143:  // BC6H_UFLOAT_BLOCK
+            format = CU_AD_FORMAT_BC6H_UF16;
+            break;
+        case 144:  // BC6H_SFLOAT_BLOCK
+            format = CU_AD_FORMAT_BC6H_SF16;
+            break;
+        case 145:  // BC7_UNORM_BLOCK
+            format = CU_AD_FORMAT_BC7_UNORM;
+            break;
+        case 146:  // BC7_SRGB_BLOCK
+            format = CU_AD_FORMAT_BC7_UNORM_SRGB;
+            break;
+#endif
+        default:
+            return false;
+    }
+    numChannels = getNumChannelsInBlockFormat( format );
+    return true;
+}
+
+// Returns true for the VkFormat values of sRGB-encoded formats.
+bool isSRGBVkFormat( std::uint32_t vkFormat )
+{
+    return vkFormat == 43 || vkFormat == 132 || vkFormat == 134 || vkFormat == 136 || vkFormat == 138 || vkFormat == 146;
+}
+
+}  // namespace
+
+void KTXReader::readHeader( const RandomAccessFile& file, TextureInfo& info, std::vector<unsigned long long>& levelOffsets )
+{
+    unsigned char header[KTX_HEADER_SIZE];
+    if( !file.read( header, KTX_HEADER_SIZE, 0 ) || std::memcmp( header, KTX_IDENTIFIER, sizeof( KTX_IDENTIFIER ) ) != 0 )
+        throwError( "not a KTX2 file" );
+
+    // Zstd supercompressed levels are decompressed as a whole when first read.  Basis and zlib
+    // supercompression are not supported.
+    const std::uint32_t supercompression = readU32( header, KTX_SUPERCOMPRESSION );
+    if( supercompression != KTX_SUPERCOMPRESSION_NONE && ( supercompression != KTX_SUPERCOMPRESSION_ZSTD || !OTK_USE_ZSTD ) )
+        throwError( "supercompressed KTX2 files (scheme " + std::to_string( supercompression ) + ") are not supported" );
+    if( readU32( header, KTX_PIXEL_DEPTH ) != 0 || readU32( header, KTX_LAYER_COUNT ) > 1 || readU32( header, KTX_FACE_COUNT ) != 1 )
+        throwError( "only 2D KTX2 textures are supported" );
+    const std::uint32_t vkFormat = readU32( header, KTX_VK_FORMAT );
+    if( !getVkFormat( vkFormat, info.format, info.numChannels ) )
+        throwError( "unsupported KTX2 format" );
+    setSRGB( isSRGBVkFormat( vkFormat ) );
+
+    info.width        = readU32( header, KTX_PIXEL_WIDTH );
+    info.height       = readU32( header, KTX_PIXEL_HEIGHT );
+    info.numMipLevels = std::max( 1U, readU32( header, KTX_LEVEL_COUNT ) );
+    if( info.width == 0 || info.height == 0 || info.numMipLevels > calculateNumMipLevels( info.width, info.height ) )
+        throwError( "invalid KTX2 dimensions" );
+
+    // The level index follows the header, giving the location of each level (finest first).
+    std::vector<unsigned char> levelIndex( info.numMipLevels * KTX_LEVEL_INDEX_STRIDE );
+    if( !file.read( levelIndex.data(), levelIndex.size(), KTX_HEADER_SIZE ) )
+        throwError( "truncated KTX2 level index" );
+    levelOffsets.resize( info.numMipLevels );
+    std::vector<unsigned long long> compressedSizes;
+    for( unsigned int mipLevel = 0; mipLevel < info.numMipLevels; ++mipLevel )
+    {
+        const unsigned int entry     = mipLevel * KTX_LEVEL_INDEX_STRIDE;
+        const size_t       levelSize = getImageSizeInBytes( info.format, info.numChannels, std::max( 1U, info.width >> mipLevel ),
+                                                            std::max( 1U, info.height >> mipLevel ) );
+        levelOffsets[mipLevel]       = readU64( levelIndex.data(), entry );
+        if( supercompression != KTX_SUPERCOMPRESSION_NONE )
+        {
+            // The byte length is the compressed size; the uncompressed length follows it.
+            if( readU64( levelIndex.data(), entry + 16 ) < levelSize )
+                throwError( "invalid KTX2 level size" );
+            compressedSizes.push_back( readU64( levelIndex.data(), entry + 8 ) );
+        }
+        else if( readU64( levelIndex.data(), entry + 8 ) < levelSize )
+            throwError( "invalid KTX2 level size" );
+    }
+    setCompressedLevelSizes( std::move( compressedSizes ) );
+}
+
+void KTXReader::decompressLevel( const char* src, size_t srcSize, char* dest, size_t destSize ) const
+{
+#if OTK_USE_ZSTD
+    // The level may hold trailing padding beyond the texels we use, so decompress into a buffer
+    // sized by the frame when it is larger than the destination.
+    const unsigned long long frameSize = ZSTD_getFrameContentSize( src, srcSize );
+    if( frameSize == ZSTD_CONTENTSIZE_ERROR )
+        throwError( "invalid zstd supercompressed KTX2 level" );
+    std::vector<char> padded;
+    char*             buffer     = dest;
+    size_t            bufferSize = destSize;
+    if( frameSize != ZSTD_CONTENTSIZE_UNKNOWN && frameSize > destSize )
+    {
+        padded.resize( static_cast<size_t>( frameSize ) );
+        buffer     = padded.data();
+        bufferSize = padded.size();
+    }
+    const size_t result = ZSTD_decompress( buffer, bufferSize, src, srcSize );
+    if( ZSTD_isError( result ) )
+        throwError( std::string( "zstd decompression failed: " ) + ZSTD_getErrorName( result ) );
+    if( result < destSize )
+        throwError( "truncated zstd supercompressed KTX2 level" );
+    if( buffer != dest )
+        std::memcpy( dest, buffer, destSize );
+#else
+    BlockImageReader::decompressLevel( src, srcSize, dest, destSize );
+#endif
+}
+
+}  // namespace imageSource
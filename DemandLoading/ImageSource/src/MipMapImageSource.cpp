@@ -178,6 +178,19 @@ bool MipMapImageSource::readTile( char* dest, unsigned mipLevel, const Tile& til
     return true;
 }
 
+std::future<bool> MipMapImageSource::readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    {
+        std::unique_lock<std::mutex> lock( m_dataMutex );
+        if( m_mipMappedBase )
+        {
+            return WrappedImageSource::readTileAsync( dest, mipLevel, tile, stream );
+        }
+    }
+    // Tiles are copied from the mip levels built on the host.
+    return ImageSource::readTileAsync( dest, mipLevel, tile, stream );
+}
+
 bool MipMapImageSource::readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream )
 {
     {
@@ -215,12 +228,13 @@ bool MipMapImageSource::readMipTail( char*        dest,
         }
     }
 
-    size_t offset = 0;
+    const TextureInfo& info   = getInfo();
+    size_t             offset = 0;
     for( unsigned int mipLevel = mipTailFirstLevel; mipLevel < numMipLevels; ++mipLevel )
     {
         const uint2 levelDims = mipLevelDims[mipLevel];
         readMipLevel( dest + offset, mipLevel, levelDims.x, levelDims.y, stream );
-        offset += static_cast<size_t>( levelDims.x * levelDims.y * pixelSizeInBytes );
+        offset += getImageSizeInBytes( info.format, info.numChannels, levelDims.x, levelDims.y );
     }
 
     return true;
@@ -11,8 +11,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <half.h>
 #include <mutex>
+#include <sstream>
+#include <utility>
 #include <vector>
 
 #include "Stopwatch.h"
@@ -75,6 +78,68 @@ float toFloat( const char* src, const CUarray_format format )
 
     return 0.f;
 }
+
+// Process-wide bound on the ImageInputs that readers open beyond the first for each image.
+struct InputLimits
+{
+    std::mutex   mutex;
+    unsigned int maxInputsPerImage = 8;
+    unsigned int maxTotalInputs    = 64;
+    unsigned int numExtraInputs    = 0;
+};
+
+InputLimits& getInputLimits()
+{
+    static InputLimits limits;
+    return limits;
+}
+
+// Reserve an additional ImageInput for an image that has the given number open.
+bool reserveExtraInput( unsigned int numInputs )
+{
+    InputLimits&                limits = getInputLimits();
+    std::lock_guard<std::mutex> guard( limits.mutex );
+    if( numInputs >= limits.maxInputsPerImage || limits.numExtraInputs >= limits.maxTotalInputs )
+        return false;
+    ++limits.numExtraInputs;
+    return true;
+}
+
+void releaseExtraInputs( unsigned int count )
+{
+    InputLimits&                limits = getInputLimits();
+    std::lock_guard<std::mutex> guard( limits.mutex );
+    limits.numExtraInputs -= count;
+}
+
+}  // namespace
+
+// Returns an ImageInput from the pool to the reader when the read finishes.
+class OIIOReader::InputLease
+{
+  public:
+    explicit InputLease( OIIOReader& reader )
+        : m_reader( reader )
+        , m_input( reader.acquireInput() )
+    {
+    }
+    ~InputLease() { m_reader.releaseInput( std::move( m_input ) ); }
+
+    OIIO::ImageInput* operator->() const { return m_input.get(); }
+    OIIO::ImageInput& operator*() const { return *m_input; }
+
+  private:
+    OIIOReader&                       m_reader;
+    std::unique_ptr<OIIO::ImageInput> m_input;
+};
+
+void OIIOReader::setInputLimits( unsigned int maxInputsPerImage, unsigned int maxTotalInputs )
+{
+    OTK_ASSERT_MSG( maxInputsPerImage > 0, "An image requires at least one ImageInput" );
+    InputLimits&                limits = getInputLimits();
+    std::lock_guard<std::mutex> guard( limits.mutex );
+    limits.maxInputsPerImage = maxInputsPerImage;
+    limits.maxTotalInputs    = maxTotalInputs;
 }
 
 // Open the image and read header info, including dimensions and format.
@@ -84,15 +149,15 @@ void OIIOReader::open( TextureInfo* info )
         std::unique_lock<std::mutex> lock( m_mutex );
 
         // Check to see if the image is already open
-        if( !m_input )
+        if( m_numInputs == 0 )
         {
-            m_input = OIIO::ImageInput::open( m_filename );
-            if( !m_input )
+            std::unique_ptr<OIIO::ImageInput> input = OIIO::ImageInput::open( m_filename );
+            if( !input )
             {
                 throw std::runtime_error( OIIO::geterror().c_str() );
-            }                
+            }
 
-            OIIO::ImageSpec spec = m_input->spec();
+            OIIO::ImageSpec spec = input->spec();
 
             m_info.width  = spec.width;
             m_info.height = spec.height;
@@ -103,21 +168,25 @@ void OIIOReader::open( TextureInfo* info )
             // CUDA textures don't support float3, so we round up to four channels.
             m_info.numChannels = ( spec.nchannels >= 3 ) ? 4 : spec.nchannels;
 
+            // The image may be reopened after being closed, e.g. by an ImageSourceCache.  The level
+            // specs are cached so that reads need not seek the shared ImageInputs to query them.
+            m_levelSpecs.clear();
             m_info.numMipLevels = 0;
-            while( m_input->seek_subimage( 0, m_info.numMipLevels, spec ) )
+            while( input->seek_subimage( 0, m_info.numMipLevels, spec ) )
             {
                 ++m_info.numMipLevels;
-                m_levelWidths.push_back( spec.width );
-                m_levelHeights.push_back( spec.height );
+                m_levelSpecs.push_back( spec );
             }
-
-            m_levelWidths.shrink_to_fit();
-            m_levelHeights.shrink_to_fit();
+            m_levelSpecs.shrink_to_fit();
 
             m_info.isTiled = spec.tile_width > 0;
             m_info.isValid = true;
             m_tileWidth    = spec.tile_width;
             m_tileHeight   = spec.tile_height;
+
+            m_idleInputs.push_back( std::move( input ) );
+            m_numInputs = 1;
+            m_isOpen    = true;
         }
     }
 
@@ -140,38 +209,95 @@ void OIIOReader::open( TextureInfo* info )
         *info = m_info;
 }
 
-// Close the image.
+// Close the image, waiting for reads in progress to finish.
 void OIIOReader::close()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_inputReturned.wait( lock, [this] { return m_idleInputs.size() == m_numInputs; } );
+    for( std::unique_ptr<OIIO::ImageInput>& input : m_idleInputs )
+        input->close();
+    m_idleInputs.clear();
+    if( m_numInputs > 1 )
+        releaseExtraInputs( m_numInputs - 1 );
+    m_numInputs = 0;
+    m_isOpen    = false;
+}
+
+unsigned int OIIOReader::getNumInputs() const
 {
     std::lock_guard<std::mutex> guard( m_mutex );
-    if( m_input )
+    return m_numInputs;
+}
+
+std::unique_ptr<OIIO::ImageInput> OIIOReader::acquireInput()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    OTK_ASSERT_MSG( m_numInputs > 0, "Attempting to read from image that isn't open." );
+    while( true )
     {
-        m_input->close();
-        m_input.reset();
+        if( !m_idleInputs.empty() )
+        {
+            std::unique_ptr<OIIO::ImageInput> input = std::move( m_idleInputs.back() );
+            m_idleInputs.pop_back();
+            return input;
+        }
+
+        // All inputs are busy.  Open another if the limits allow, otherwise wait for one of ours
+        // to be returned.  Opening the file is slow, so it's done without holding the lock.
+        if( reserveExtraInput( m_numInputs ) )
+        {
+            ++m_numInputs;
+            lock.unlock();
+            std::unique_ptr<OIIO::ImageInput> input = OIIO::ImageInput::open( m_filename );
+            if( !input )
+            {
+                lock.lock();
+                --m_numInputs;
+                releaseExtraInputs( 1 );
+                m_inputReturned.notify_all();
+                throw std::runtime_error( OIIO::geterror().c_str() );
+            }
+            return input;
+        }
+        m_inputReturned.wait( lock );
     }
 }
 
-void OIIOReader::readActualTile( char* dest, unsigned int rowPitch, unsigned int mipLevel, unsigned int tileX, unsigned int tileY )
+void OIIOReader::releaseInput( std::unique_ptr<OIIO::ImageInput> input )
 {
-    std::lock_guard<std::mutex> guard( m_mutex );
-    OTK_ASSERT( m_input.get() );
+    {
+        std::lock_guard<std::mutex> guard( m_mutex );
+        m_idleInputs.push_back( std::move( input ) );
+    }
+    m_inputReturned.notify_all();
+}
+
+void OIIOReader::recordRead( unsigned long long numTiles, unsigned long long numBytes, double time )
+{
+    m_numTilesRead += numTiles;
+    m_numBytesRead += numBytes;
+    double totalTime = m_totalReadTime.load();
+    while( !m_totalReadTime.compare_exchange_weak( totalTime, totalTime + time ) )
+    {
+    }
+}
 
-    OIIO::ImageSpec spec;
-    m_input->seek_subimage( 0, mipLevel, spec );
-    m_input->read_tile( tileX * spec.tile_width, tileY * spec.tile_height, 0, spec.format, dest,
-                        getBytesPerChannel( m_info.format ) * m_info.numChannels, rowPitch );
+void OIIOReader::readActualTile( OIIO::ImageInput& input, char* dest, unsigned int rowPitch, unsigned int mipLevel, unsigned int tileX, unsigned int tileY )
+{
+    const OIIO::ImageSpec& spec = m_levelSpecs[mipLevel];
+    input.read_tile( 0, mipLevel, tileX * spec.tile_width, tileY * spec.tile_height, 0, spec.format, dest,
+                     getBytesPerChannel( m_info.format ) * m_info.numChannels, rowPitch );
 }
 
 bool OIIOReader::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream /*stream*/  )
 {
     OTK_ASSERT_MSG( isOpen(), "Attempting to read from image that isn't open." );
+    OTK_ASSERT_MSG( mipLevel < m_info.numMipLevels, "Attempt to read missing mip level" );
 
-    Stopwatch stopwatch;
-    OIIO::ImageSpec spec;
-    {
-        std::lock_guard<std::mutex> guard( m_mutex );
-        m_input->seek_subimage( 0, mipLevel, spec );
-    }
+    Stopwatch              stopwatch;
+    const OIIO::ImageSpec& spec = m_levelSpecs[mipLevel];
+    InputLease             input( *this );
+    unsigned long long     numBytes = 0;
 
     if( spec.tile_width && spec.tile_height )
     {
@@ -195,8 +321,8 @@ bool OIIOReader::readTile( char* dest, unsigned int mipLevel, const Tile& tile,
         const size_t       actualTileSize = actualTileWidth * actualTileHeight * bytesPerPixel;
 
         // Don't request non-existent tiles on the edge of the texture
-        unsigned int levelWidthInSourceTiles  = ( m_levelWidths[mipLevel] + actualTileWidth - 1 ) / actualTileWidth;
-        unsigned int levelHeightInSourceTiles = ( m_levelHeights[mipLevel] + actualTileHeight - 1 ) / actualTileHeight;
+        unsigned int levelWidthInSourceTiles  = ( spec.width + actualTileWidth - 1 ) / actualTileWidth;
+        unsigned int levelHeightInSourceTiles = ( spec.height + actualTileHeight - 1 ) / actualTileHeight;
         const unsigned int numTilesX = std::min( tile.width / actualTileWidth, levelWidthInSourceTiles - actualTileX );
         const unsigned int numTilesY = std::min( tile.height / actualTileHeight, levelHeightInSourceTiles - actualTileY );
 
@@ -205,9 +331,10 @@ bool OIIOReader::readTile( char* dest, unsigned int mipLevel, const Tile& tile,
             for( unsigned int i = 0; i < numTilesX; ++i )
             {
                 char* start = dest + j * numTilesX * actualTileSize + i * actualTileWidth * bytesPerPixel;
-                readActualTile( start, rowPitch, mipLevel, actualTileX + i, actualTileY + j );
+                readActualTile( *input, start, rowPitch, mipLevel, actualTileX + i, actualTileY + j );
             }
         }
+        numBytes = static_cast<unsigned long long>( numTilesX ) * numTilesY * spec.tile_bytes();
     }
     else  // Scanline image
     {
@@ -223,10 +350,7 @@ bool OIIOReader::readTile( char* dest, unsigned int mipLevel, const Tile& tile,
         char* _dest = dest;
         for( unsigned int y = start_y; y < end_y; ++y )
         {
-            {
-                std::lock_guard<std::mutex> guard( m_mutex );
-                m_input->read_scanline( y, 0, spec.format, tmp.data() );
-            }
+            input->read_scanlines( 0, mipLevel, y, y + 1, 0, 0, spec.nchannels, spec.format, tmp.data() );
 
             for( unsigned int x = start_x; x < end_x; ++x )
             {
@@ -234,12 +358,9 @@ bool OIIOReader::readTile( char* dest, unsigned int mipLevel, const Tile& tile,
                 _dest += bytesPerPixel;
             }
         }
+        numBytes = static_cast<unsigned long long>( end_y - start_y ) * spec.scanline_bytes();
     }
-    {
-        std::unique_lock<std::mutex> lock( m_statsMutex );
-        m_totalReadTime += stopwatch.elapsed();
-        ++m_numTilesRead;
-    }
+    recordRead( 1, numBytes, stopwatch.elapsed() );
     return true;
 }
 
@@ -267,23 +388,20 @@ bool OIIOReader::readMipLevel( char*        dest,
     OTK_ASSERT_MSG( isOpen(), "Attempting to read from image that isn't open." );
     OTK_ASSERT_MSG( mipLevel < m_info.numMipLevels, "Attempt to read missing mip level" );
 
-    Stopwatch stopwatch;
-    OIIO::ImageSpec spec;
-    unsigned int    bytesPerPixel;
-    {
-        std::lock_guard<std::mutex> guard( m_mutex );
-        m_input->seek_subimage( 0, mipLevel, spec );
-
-        OTK_ASSERT( spec.width == static_cast<int>( expectedWidth ) );
-        OTK_ASSERT( spec.height == static_cast<int>( expectedHeight ) );
-        OTK_ASSERT( spec.depth == static_cast<int>( expectedDepth ) );
-        (void)expectedWidth;  // silence unused variable warning.
-        (void)expectedHeight;
-        (void)expectedDepth;
+    Stopwatch              stopwatch;
+    const OIIO::ImageSpec& spec = m_levelSpecs[mipLevel];
 
-        bytesPerPixel = getBytesPerChannel( m_info.format ) * m_info.numChannels;
+    OTK_ASSERT( spec.width == static_cast<int>( expectedWidth ) );
+    OTK_ASSERT( spec.height == static_cast<int>( expectedHeight ) );
+    OTK_ASSERT( spec.depth == static_cast<int>( expectedDepth ) );
+    (void)expectedWidth;  // silence unused variable warning.
+    (void)expectedHeight;
+    (void)expectedDepth;
 
-        m_input->read_image( 0, mipLevel, 0, spec.nchannels, spec.format, dest, bytesPerPixel );
+    const unsigned int bytesPerPixel = getBytesPerChannel( m_info.format ) * m_info.numChannels;
+    {
+        InputLease input( *this );
+        input->read_image( 0, mipLevel, 0, spec.nchannels, spec.format, dest, bytesPerPixel );
     }
 
     if( spec.tile_width )
@@ -296,17 +414,11 @@ bool OIIOReader::readMipLevel( char*        dest,
         const int          numYTiles        = 1 + ( ( spec.height - 1 ) / actualTileHeight );
         const int          numZTiles        = 1 + ( ( spec.depth - 1 ) / actualTileDepth );
 
-        std::lock_guard<std::mutex> guard( m_statsMutex );
-        m_numTilesRead += numXTiles * numYTiles * numZTiles;
-        m_numBytesRead += numXTiles * numYTiles * numZTiles * actualTileSize;
-        m_totalReadTime += stopwatch.elapsed();
+        recordRead( numXTiles * numYTiles * numZTiles, numXTiles * numYTiles * numZTiles * actualTileSize, stopwatch.elapsed() );
     }
     else
     {
-        std::lock_guard<std::mutex> guard( m_statsMutex );
-        m_numTilesRead += 1;
-        m_numBytesRead += spec.width * spec.height * spec.depth * bytesPerPixel;
-        m_totalReadTime += stopwatch.elapsed();
+        recordRead( 1, spec.width * spec.height * spec.depth * bytesPerPixel, stopwatch.elapsed() );
     }
     return true;
 }
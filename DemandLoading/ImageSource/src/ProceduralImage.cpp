@@ -0,0 +1,697 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/ProceduralImage.h>
+
+#include <OptiXToolkit/Error/ErrorCheck.h>
+#include <OptiXToolkit/ImageSource/FormatConversion.h>
+
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+namespace imageSource {
+
+namespace {
+
+// Number of texels evaluated by each block instruction.  Every instruction runs over the whole
+// block, so its loops have a constant trip count that the compiler vectorizes, and the registers of
+// a typical graph stay in L1 cache.
+const unsigned int BLOCK = 64;
+
+const unsigned int NO_INPUT = ~0U;
+
+std::atomic<bool> g_useAVX2( true );
+
+// Interleave the texels of the given channel blocks into dest, starting from texel i.
+OTK_FORCE_INLINE void interleaveRemaining( const float* const* channels, unsigned int numChannels, unsigned int i, unsigned int count, float* dest )
+{
+    for( ; i < count; ++i )
+    {
+        for( unsigned int c = 0; c < numChannels; ++c )
+            dest[i * numChannels + c] = channels[c][i];
+    }
+}
+
+// The kernels that the compiler cannot vectorize on its own, for the x86-64 baseline (SSE2) or
+// portable C++.  The block evaluation is instantiated with these or the AVX2 kernels.
+struct BaselineKernels
+{
+    static OTK_FORCE_INLINE void floorBlock( const float* x, float* result )
+    {
+#if OTK_USE_X86_INTRINSICS
+        // SSE2 has no floor instruction: truncate, and subtract one where that rounded up.
+        const __m128 one = _mm_set1_ps( 1.f );
+        for( unsigned int i = 0; i < BLOCK; i += 4 )
+        {
+            const __m128 value     = _mm_loadu_ps( x + i );
+            const __m128 truncated = _mm_cvtepi32_ps( _mm_cvttps_epi32( value ) );
+            _mm_storeu_ps( result + i, _mm_sub_ps( truncated, _mm_and_ps( _mm_cmplt_ps( value, truncated ), one ) ) );
+        }
+#else
+        for( unsigned int i = 0; i < BLOCK; ++i )
+            result[i] = std::floor( x[i] );
+#endif
+    }
+
+    // Add an octave of noise to dest, interpolating along u between the values of the lattice
+    // columns (indexed from the column of the first texel) with the smoothed fractions.
+    static OTK_FORCE_INLINE void addNoiseOctave( const float* lattice, const float* smoothX, const float* columns, float weight, float* dest )
+    {
+        for( unsigned int i = 0; i < BLOCK; ++i )
+        {
+            const unsigned int j    = static_cast<unsigned int>( lattice[i] - lattice[0] );
+            const float        left = columns[j];
+            dest[i] += weight * ( left + ( columns[j + 1] - left ) * smoothX[i] - 0.5f );
+        }
+    }
+
+    // Interleave count texels of the given channel blocks into dest.
+    static OTK_FORCE_INLINE void interleaveChannels( const float* const* channels, unsigned int numChannels, unsigned int count, float* dest )
+    {
+        if( numChannels == 1 )
+        {
+            std::memcpy( dest, channels[0], count * sizeof( float ) );
+            return;
+        }
+        unsigned int i = 0;
+#if OTK_USE_X86_INTRINSICS
+        if( numChannels == 4 )
+        {
+            for( ; i + 4 <= count; i += 4 )
+            {
+                __m128 c0 = _mm_loadu_ps( channels[0] + i );
+                __m128 c1 = _mm_loadu_ps( channels[1] + i );
+                __m128 c2 = _mm_loadu_ps( channels[2] + i );
+                __m128 c3 = _mm_loadu_ps( channels[3] + i );
+                _MM_TRANSPOSE4_PS( c0, c1, c2, c3 );
+                _mm_storeu_ps( dest + 4 * i, c0 );
+                _mm_storeu_ps( dest + 4 * i + 4, c1 );
+                _mm_storeu_ps( dest + 4 * i + 8, c2 );
+                _mm_storeu_ps( dest + 4 * i + 12, c3 );
+            }
+        }
+        else if( numChannels == 2 )
+        {
+            for( ; i + 4 <= count; i += 4 )
+            {
+                const __m128 c0 = _mm_loadu_ps( channels[0] + i );
+                const __m128 c1 = _mm_loadu_ps( channels[1] + i );
+                _mm_storeu_ps( dest + 2 * i, _mm_unpacklo_ps( c0, c1 ) );
+                _mm_storeu_ps( dest + 2 * i + 4, _mm_unpackhi_ps( c0, c1 ) );
+            }
+        }
+#endif
+        interleaveRemaining( channels, numChannels, i, count, dest );
+    }
+};
+
+#if OTK_USE_X86_INTRINSICS
+// Kernels for processors with AVX2, eight texels at a time.  They produce the same values as the
+// baseline kernels.
+struct AVX2Kernels
+{
+    static OTK_TARGET_AVX2 void floorBlock( const float* x, float* result )
+    {
+        for( unsigned int i = 0; i < BLOCK; i += 8 )
+            _mm256_storeu_ps( result + i, _mm256_floor_ps( _mm256_loadu_ps( x + i ) ) );
+    }
+
+    static OTK_TARGET_AVX2 void addNoiseOctave( const float* lattice, const float* smoothX, const float* columns, float weight, float* dest )
+    {
+        // The column indices are small, so they convert exactly to signed integers for the gathers.
+        const __m256 first   = _mm256_set1_ps( lattice[0] );
+        const __m256 half    = _mm256_set1_ps( 0.5f );
+        const __m256 weight8 = _mm256_set1_ps( weight );
+        for( unsigned int i = 0; i < BLOCK; i += 8 )
+        {
+            const __m256i j     = _mm256_cvttps_epi32( _mm256_sub_ps( _mm256_loadu_ps( lattice + i ), first ) );
+            const __m256  left  = _mm256_i32gather_ps( columns, j, 4 );
+            const __m256  right = _mm256_i32gather_ps( columns + 1, j, 4 );
+            const __m256  value = _mm256_sub_ps( _mm256_add_ps( left, _mm256_mul_ps( _mm256_sub_ps( right, left ), _mm256_loadu_ps( smoothX + i ) ) ), half );
+            _mm256_storeu_ps( dest + i, _mm256_add_ps( _mm256_loadu_ps( dest + i ), _mm256_mul_ps( weight8, value ) ) );
+        }
+    }
+
+    static OTK_TARGET_AVX2 void interleaveChannels( const float* const* channels, unsigned int numChannels, unsigned int count, float* dest )
+    {
+        if( numChannels == 1 )
+        {
+            std::memcpy( dest, channels[0], count * sizeof( float ) );
+            return;
+        }
+        unsigned int i = 0;
+        if( numChannels == 4 )
+        {
+            // Transpose within each 128-bit lane, then exchange the lanes.
+            for( ; i + 8 <= count; i += 8 )
+            {
+                const __m256 c0       = _mm256_loadu_ps( channels[0] + i );
+                const __m256 c1       = _mm256_loadu_ps( channels[1] + i );
+                const __m256 c2       = _mm256_loadu_ps( channels[2] + i );
+                const __m256 c3       = _mm256_loadu_ps( channels[3] + i );
+                const __m256 t0       = _mm256_unpacklo_ps( c0, c1 );
+                const __m256 t1       = _mm256_unpackhi_ps( c0, c1 );
+                const __m256 t2       = _mm256_unpacklo_ps( c2, c3 );
+                const __m256 t3       = _mm256_unpackhi_ps( c2, c3 );
+                const __m256 texels04 = _mm256_shuffle_ps( t0, t2, 0x44 );
+                const __m256 texels15 = _mm256_shuffle_ps( t0, t2, 0xEE );
+                const __m256 texels26 = _mm256_shuffle_ps( t1, t3, 0x44 );
+                const __m256 texels37 = _mm256_shuffle_ps( t1, t3, 0xEE );
+                _mm256_storeu_ps( dest + 4 * i, _mm256_permute2f128_ps( texels04, texels15, 0x20 ) );
+                _mm256_storeu_ps( dest + 4 * i + 8, _mm256_permute2f128_ps( texels26, texels37, 0x20 ) );
+                _mm256_storeu_ps( dest + 4 * i + 16, _mm256_permute2f128_ps( texels04, texels15, 0x31 ) );
+                _mm256_storeu_ps( dest + 4 * i + 24, _mm256_permute2f128_ps( texels26, texels37, 0x31 ) );
+            }
+        }
+        else if( numChannels == 2 )
+        {
+            for( ; i + 8 <= count; i += 8 )
+            {
+                const __m256 c0 = _mm256_loadu_ps( channels[0] + i );
+                const __m256 c1 = _mm256_loadu_ps( channels[1] + i );
+                const __m256 lo = _mm256_unpacklo_ps( c0, c1 );
+                const __m256 hi = _mm256_unpackhi_ps( c0, c1 );
+                _mm256_storeu_ps( dest + 2 * i, _mm256_permute2f128_ps( lo, hi, 0x20 ) );
+                _mm256_storeu_ps( dest + 2 * i + 8, _mm256_permute2f128_ps( lo, hi, 0x31 ) );
+            }
+        }
+        interleaveRemaining( channels, numChannels, i, count, dest );
+    }
+};
+#endif
+
+// Integral from 0 to x of the square wave that is 0 on [0,1) and 1 on [1,2).
+OTK_FORCE_INLINE float squareWaveIntegral( float x, float halfFloor )
+{
+    return halfFloor + std::max( 0.f, 2.f * ( 0.5f * x - halfFloor ) - 1.f );
+}
+
+// Box filter the square wave over [x - width/2, x + width/2].
+OTK_FORCE_INLINE float filteredSquareWave( float x, float width )
+{
+    const float low  = x - 0.5f * width;
+    const float high = low + width;
+    return ( squareWaveIntegral( high, std::floor( 0.5f * high ) ) - squareWaveIntegral( low, std::floor( 0.5f * low ) ) ) / width;
+}
+
+// Box filter the square wave for a block of x = coord * frequency.
+template <class Kernels>
+OTK_FORCE_INLINE void filteredSquareWave( const float* coord, float frequency, float width, float* scratch, float* result )
+{
+    float* low       = scratch;
+    float* high      = scratch + BLOCK;
+    float* lowFloor  = scratch + 2 * BLOCK;
+    float* highFloor = scratch + 3 * BLOCK;
+    for( unsigned int i = 0; i < BLOCK; ++i )
+    {
+        low[i]       = coord[i] * frequency - 0.5f * width;
+        high[i]      = low[i] + width;
+        lowFloor[i]  = 0.5f * low[i];
+        highFloor[i] = 0.5f * high[i];
+    }
+    Kernels::floorBlock( lowFloor, lowFloor );
+    Kernels::floorBlock( highFloor, highFloor );
+    const float invWidth = 1.f / width;
+    for( unsigned int i = 0; i < BLOCK; ++i )
+        result[i] = ( squareWaveIntegral( high[i], highFloor[i] ) - squareWaveIntegral( low[i], lowFloor[i] ) ) * invWidth;
+}
+
+OTK_FORCE_INLINE std::uint32_t hashLattice( std::uint32_t x, std::uint32_t y )
+{
+    std::uint32_t h = x ^ y;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6dU;
+    h ^= h >> 12;
+    h *= 0x297a2d39U;
+    h ^= h >> 15;
+    return h;
+}
+
+// Weight of each octave of a noise node whose texels have the given footprint.  Octaves fade to
+// their mean as their lattice cells shrink from two texels to one.
+OTK_FORCE_INLINE float octaveWeight( float frequency, float footprint )
+{
+    return std::min( 1.f, std::max( 0.f, 2.f - 2.f * footprint * frequency ) );
+}
+
+}  // namespace
+
+ProceduralGraph::Node ProceduralGraph::addNode( Op op, Node a, Node b, Node c, float p0, float p1, float p2 )
+{
+    const Node node = static_cast<Node>( m_nodes.size() );
+    for( Node input : { a, b, c } )
+        OTK_ASSERT_MSG( input == NO_INPUT || input < node, "Invalid procedural graph node" );
+    m_nodes.push_back( NodeDesc{ op, { a, b, c }, { p0, p1, p2 }, 0, 0 } );
+    return node;
+}
+
+ProceduralGraph::Node ProceduralGraph::constant( float value )
+{
+    return addNode( CONSTANT, NO_INPUT, NO_INPUT, NO_INPUT, value, 0.f, 0.f );
+}
+
+ProceduralGraph::Node ProceduralGraph::gradient( float du, float dv, float offset )
+{
+    return addNode( GRADIENT, NO_INPUT, NO_INPUT, NO_INPUT, du, dv, offset );
+}
+
+ProceduralGraph::Node ProceduralGraph::checker( float squaresU, float squaresV )
+{
+    OTK_ASSERT_MSG( squaresU > 0.f && squaresV > 0.f, "Checker must have a positive number of squares" );
+    return addNode( CHECKER, NO_INPUT, NO_INPUT, NO_INPUT, squaresU, squaresV, 0.f );
+}
+
+ProceduralGraph::Node ProceduralGraph::noise( float frequency, unsigned int octaves, unsigned int seed )
+{
+    OTK_ASSERT_MSG( frequency > 0.f && octaves > 0, "Noise must have a positive frequency and octave count" );
+    const Node node       = addNode( NOISE, NO_INPUT, NO_INPUT, NO_INPUT, frequency, 0.f, 0.f );
+    m_nodes[node].octaves = octaves;
+    m_nodes[node].seed    = seed;
+    return node;
+}
+
+ProceduralGraph::Node ProceduralGraph::add( Node a, Node b )
+{
+    return addNode( ADD, a, b, NO_INPUT, 0.f, 0.f, 0.f );
+}
+
+ProceduralGraph::Node ProceduralGraph::multiply( Node a, Node b )
+{
+    return addNode( MULTIPLY, a, b, NO_INPUT, 0.f, 0.f, 0.f );
+}
+
+ProceduralGraph::Node ProceduralGraph::mix( Node a, Node b, Node t )
+{
+    return addNode( MIX, a, b, t, 0.f, 0.f, 0.f );
+}
+
+ProceduralGraph::Node ProceduralGraph::remap( Node a, float scale, float offset )
+{
+    return addNode( REMAP, a, NO_INPUT, NO_INPUT, scale, offset, 0.f );
+}
+
+ProceduralGraph::Node ProceduralGraph::clamp( Node a, float low, float high )
+{
+    return addNode( CLAMP, a, NO_INPUT, NO_INPUT, low, high, 0.f );
+}
+
+ProceduralGraph::Node ProceduralGraph::smoothstep( Node a, float edge0, float edge1 )
+{
+    OTK_ASSERT_MSG( edge0 != edge1, "Smoothstep edges must differ" );
+    return addNode( SMOOTHSTEP, a, NO_INPUT, NO_INPUT, edge0, edge1, 0.f );
+}
+
+ProceduralImage::ProceduralImage( const ProceduralGraph&                   graph,
+                                  const std::vector<ProceduralGraph::Node>& channels,
+                                  unsigned int                              width,
+                                  unsigned int                              height,
+                                  CUarray_format                            format,
+                                  bool                                      useMipmaps )
+{
+    OTK_ASSERT_MSG( channels.size() == 1 || channels.size() == 2 || channels.size() == 4, "Procedural images have 1, 2 or 4 channels" );
+    OTK_ASSERT_MSG( format == CU_AD_FORMAT_FLOAT || format == CU_AD_FORMAT_UNSIGNED_INT8, "Unsupported procedural image format" );
+
+    m_info.width        = width;
+    m_info.height       = height;
+    m_info.format       = format;
+    m_info.numChannels  = static_cast<unsigned int>( channels.size() );
+    m_info.numMipLevels = useMipmaps ? calculateNumMipLevels( width, height ) : 1;
+    m_info.isValid      = true;
+    m_info.isTiled      = true;
+
+    compile( graph, channels );
+}
+
+void ProceduralImage::compile( const ProceduralGraph& graph, const std::vector<ProceduralGraph::Node>& channels )
+{
+    const std::vector<ProceduralGraph::NodeDesc>& nodes = graph.getNodes();
+
+    // Find the nodes the channels depend on, and the last node that uses each of them.  Channel
+    // outputs are used until the end of the block.
+    const unsigned int        endOfBlock = static_cast<unsigned int>( nodes.size() );
+    std::vector<bool>         isLive( nodes.size(), false );
+    std::vector<unsigned int> lastUse( nodes.size(), 0 );
+    for( ProceduralGraph::Node channel : channels )
+    {
+        OTK_ASSERT_MSG( channel < nodes.size(), "Invalid procedural graph node" );
+        isLive[channel]  = true;
+        lastUse[channel] = endOfBlock;
+    }
+    for( unsigned int node = endOfBlock; node-- > 0; )
+    {
+        if( !isLive[node] )
+            continue;
+        for( ProceduralGraph::Node input : nodes[node].inputs )
+        {
+            if( input == NO_INPUT )
+                continue;
+            isLive[input]  = true;
+            lastUse[input] = std::max( lastUse[input], node );
+        }
+    }
+
+    // Assign registers in evaluation order, reusing the registers of values that are no longer
+    // needed.  Instructions are elementwise, so a destination may reuse the register of its input.
+    // Constants are filled once per column of blocks, so their registers are never shared.
+    std::vector<unsigned int> nodeRegisters( nodes.size(), NO_INPUT );
+    std::vector<unsigned int> freeRegisters;
+    for( unsigned int node = 0; node < endOfBlock; ++node )
+    {
+        if( !isLive[node] )
+            continue;
+        Instruction instruction{ nodes[node], 0, { NO_INPUT, NO_INPUT, NO_INPUT }, m_numCacheBlocks };
+        for( int i = 0; i < 3; ++i )
+        {
+            const ProceduralGraph::Node input = nodes[node].inputs[i];
+            if( input == NO_INPUT )
+                continue;
+            instruction.inputs[i] = nodeRegisters[input];
+            if( lastUse[input] == node && nodes[input].op != ProceduralGraph::CONSTANT
+                && std::find( freeRegisters.begin(), freeRegisters.end(), nodeRegisters[input] ) == freeRegisters.end() )
+                freeRegisters.push_back( nodeRegisters[input] );
+        }
+        if( freeRegisters.empty() || nodes[node].op == ProceduralGraph::CONSTANT )
+        {
+            instruction.dest = m_numRegisters++;
+        }
+        else
+        {
+            instruction.dest = freeRegisters.back();
+            freeRegisters.pop_back();
+        }
+        nodeRegisters[node] = instruction.dest;
+        m_program.push_back( instruction );
+
+        // Patterns cache the parts of their evaluation that depend only on u.
+        if( nodes[node].op == ProceduralGraph::CHECKER )
+            m_numCacheBlocks += 1;
+        else if( nodes[node].op == ProceduralGraph::NOISE )
+            m_numCacheBlocks += 2 * nodes[node].octaves;
+    }
+
+    for( ProceduralGraph::Node channel : channels )
+        m_channelRegisters.push_back( nodeRegisters[channel] );
+}
+
+void ProceduralImage::open( TextureInfo* info )
+{
+    if( info != nullptr )
+        *info = m_info;
+}
+
+unsigned int ProceduralImage::getWorkspaceBlocks() const
+{
+    // Registers, u, the column cache, four blocks of scratch space, and interleaved texels.
+    return m_numRegisters + 1 + m_numCacheBlocks + 4 + 4;
+}
+
+void ProceduralImage::setUseAVX2( bool useAVX2 )
+{
+    g_useAVX2 = useAVX2;
+}
+
+template <class Kernels>
+OTK_FORCE_INLINE void ProceduralImage::evaluateBlock( unsigned int levelWidth,
+                                                      unsigned int levelHeight,
+                                                      unsigned int x,
+                                                      unsigned int y,
+                                                      bool         newColumn,
+                                                      float*       workspace ) const
+{
+    // The footprint of a texel in texture coordinates, over which patterns are filtered.
+    const float du        = 1.f / static_cast<float>( levelWidth );
+    const float dv        = 1.f / static_cast<float>( levelHeight );
+    const float v         = ( static_cast<float>( y ) + 0.5f ) * dv;
+    const float footprint = std::max( du, dv );
+
+    float* registers = workspace;
+    float* u         = registers + m_numRegisters * BLOCK;
+    float* cache     = u + BLOCK;
+    float* scratch   = cache + m_numCacheBlocks * BLOCK;
+    auto   getRegister = [registers]( unsigned int index ) -> const float* {
+        return index == NO_INPUT ? nullptr : registers + index * BLOCK;
+    };
+
+    // The blocks of a column share their u coordinates, so patterns evaluate their u dependence once
+    // per column, and their v dependence once per block.  Constants are filled once per column.
+    if( newColumn )
+    {
+        for( unsigned int i = 0; i < BLOCK; ++i )
+            u[i] = ( static_cast<float>( x + i ) + 0.5f ) * du;
+        for( const Instruction& instruction : m_program )
+        {
+            const float* p = instruction.node.params;
+            float*       c = cache + instruction.cache * BLOCK;
+            if( instruction.node.op == ProceduralGraph::CONSTANT )
+            {
+                std::fill( registers + instruction.dest * BLOCK, registers + ( instruction.dest + 1 ) * BLOCK, p[0] );
+            }
+            else if( instruction.node.op == ProceduralGraph::CHECKER )
+            {
+                filteredSquareWave<Kernels>( u, p[0], du * p[0], scratch, c );
+            }
+            else if( instruction.node.op == ProceduralGraph::NOISE )
+            {
+                // The lattice column and smoothed fraction of each octave.
+                float frequency = p[0];
+                for( unsigned int octave = 0; octave < instruction.node.octaves; ++octave, frequency *= 2.f )
+                {
+                    if( octaveWeight( frequency, footprint ) == 0.f )
+                        break;
+                    float* lattice = c + 2 * octave * BLOCK;
+                    float* smooth  = lattice + BLOCK;
+                    for( unsigned int i = 0; i < BLOCK; ++i )
+                        smooth[i] = u[i] * frequency;
+                    Kernels::floorBlock( smooth, lattice );
+                    for( unsigned int i = 0; i < BLOCK; ++i )
+                    {
+                        const float f = smooth[i] - lattice[i];
+                        smooth[i]     = f * f * ( 3.f - 2.f * f );
+                    }
+                }
+            }
+        }
+    }
+
+    for( const Instruction& instruction : m_program )
+    {
+        float*       dest = registers + instruction.dest * BLOCK;
+        const float* a    = getRegister( instruction.inputs[0] );
+        const float* b    = getRegister( instruction.inputs[1] );
+        const float* t    = getRegister( instruction.inputs[2] );
+        const float* c    = cache + instruction.cache * BLOCK;
+        const float* p    = instruction.node.params;
+        switch( instruction.node.op )
+        {
+            case ProceduralGraph::CONSTANT:
+                break;
+            case ProceduralGraph::GRADIENT:
+            {
+                const float offset = p[2] + p[1] * v;
+                for( unsigned int i = 0; i < BLOCK; ++i )
+                    dest[i] = offset + p[0] * u[i];
+                break;
+            }
+            case ProceduralGraph::CHECKER:
+            {
+                // The checker is the exclusive or of square waves along u and v, which is separable
+                // when filtered: a ^ b = a + b - 2ab.
+                const float waveV = filteredSquareWave( v * p[1], dv * p[1] );
+                for( unsigned int i = 0; i < BLOCK; ++i )
+                    dest[i] = c[i] * ( 1.f - 2.f * waveV ) + waveV;
+                break;
+            }
+            case ProceduralGraph::NOISE:
+            {
+                std::fill( dest, dest + BLOCK, 0.f );
+                float frequency      = p[0];
+                float amplitude      = 1.f;
+                float totalAmplitude = 0.f;
+                for( unsigned int octave = 0; octave < instruction.node.octaves; ++octave )
+                {
+                    const float weight = octaveWeight( frequency, footprint ) * amplitude;
+                    if( weight > 0.f )
+                    {
+                        // Cells are wider than a texel, so the block spans few lattice columns.
+                        // Interpolate the lattice values along v once per column, then along u.
+                        const float*        lattice    = c + 2 * octave * BLOCK;
+                        const float*        smoothX    = lattice + BLOCK;
+                        const unsigned int  numColumns = std::min( static_cast<unsigned int>( lattice[BLOCK - 1] - lattice[0] ) + 2, 4 * BLOCK );
+                        const std::uint32_t column0    = static_cast<std::uint32_t>( static_cast<std::int32_t>( lattice[0] ) );
+                        const float         y0         = std::floor( v * frequency );
+                        const float         fy         = v * frequency - y0;
+                        const float         sy         = fy * fy * ( 3.f - 2.f * fy );
+                        const std::uint32_t row0       = static_cast<std::uint32_t>( static_cast<std::int32_t>( y0 ) ) * 0xd8163841U;
+                        const std::uint32_t row1       = row0 + 0xd8163841U;
+                        const std::uint32_t seed       = ( instruction.node.seed + octave * 0x9e3779b9U ) * 0xcb1ab31fU;
+                        const float         toUnit     = 1.f / 16777216.f;
+                        for( unsigned int j = 0; j < numColumns; ++j )
+                        {
+                            const std::uint32_t column = ( ( column0 + j ) * 0x8da6b343U ) ^ seed;
+                            const float         top    = static_cast<float>( hashLattice( column, row0 ) >> 8 ) * toUnit;
+                            const float         bottom = static_cast<float>( hashLattice( column, row1 ) >> 8 ) * toUnit;
+                            scratch[j]                 = top + ( bottom - top ) * sy;
+                        }
+                        Kernels::addNoiseOctave( lattice, smoothX, scratch, weight, dest );
+                    }
+                    totalAmplitude += amplitude;
+                    frequency *= 2.f;
+                    amplitude *= 0.5f;
+                }
+                const float scale = 1.f / totalAmplitude;
+                for( unsigned int i = 0; i < BLOCK; ++i )
+                    dest[i] = 0.5f + dest[i] * scale;
+                break;
+            }
+            case ProceduralGraph::ADD:
+                for( unsigned int i = 0; i < BLOCK; ++i )
+                    dest[i] = a[i] + b[i];
+                break;
+            case ProceduralGraph::MULTIPLY:
+                for( unsigned int i = 0; i < BLOCK; ++i )
+                    dest[i] = a[i] * b[i];
+                break;
+            case ProceduralGraph::MIX:
+                for( unsigned int i = 0; i < BLOCK; ++i )
+                    dest[i] = a[i] + ( b[i] - a[i] ) * t[i];
+                break;
+            case ProceduralGraph::REMAP:
+                for( unsigned int i = 0; i < BLOCK; ++i )
+                    dest[i] = a[i] * p[0] + p[1];
+                break;
+            case ProceduralGraph::CLAMP:
+                for( unsigned int i = 0; i < BLOCK; ++i )
+                    dest[i] = std::min( p[1], std::max( p[0], a[i] ) );
+                break;
+            case ProceduralGraph::SMOOTHSTEP:
+            {
+                const float scale = 1.f / ( p[1] - p[0] );
+                for( unsigned int i = 0; i < BLOCK; ++i )
+                {
+                    const float s = std::min( 1.f, std::max( 0.f, ( a[i] - p[0] ) * scale ) );
+                    dest[i]       = s * s * ( 3.f - 2.f * s );
+                }
+                break;
+            }
+        }
+    }
+}
+
+template <class Kernels>
+OTK_FORCE_INLINE void ProceduralImage::evaluateRect( char*        dest,
+                                                     size_t       rowPitch,
+                                                     unsigned int levelWidth,
+                                                     unsigned int levelHeight,
+                                                     unsigned int x0,
+                                                     unsigned int y0,
+                                                     unsigned int width,
+                                                     unsigned int height ) const
+{
+    thread_local std::vector<float> workspace;
+    workspace.resize( getWorkspaceBlocks() * BLOCK );
+    float* texels = workspace.data() + ( getWorkspaceBlocks() - 4 ) * BLOCK;
+
+    const unsigned int numChannels = m_info.numChannels;
+    const float*       channels[4];
+    for( unsigned int c = 0; c < numChannels; ++c )
+        channels[c] = workspace.data() + m_channelRegisters[c] * BLOCK;
+
+    // Evaluate the texels a column of blocks at a time.
+    const size_t texelSize = numChannels * getBytesPerChannel( m_info.format );
+    for( unsigned int x = 0; x < width; x += BLOCK )
+    {
+        const unsigned int count = std::min( BLOCK, width - x );
+        for( unsigned int y = 0; y < height; ++y )
+        {
+            char* blockDest = dest + y * rowPitch + x * texelSize;
+            evaluateBlock<Kernels>( levelWidth, levelHeight, x0 + x, y0 + y, /*newColumn=*/y == 0, workspace.data() );
+            if( m_info.format == CU_AD_FORMAT_FLOAT )
+            {
+                Kernels::interleaveChannels( channels, numChannels, count, reinterpret_cast<float*>( blockDest ) );
+            }
+            else
+            {
+                Kernels::interleaveChannels( channels, numChannels, count, texels );
+                convertFloatToUnorm8( texels, count, numChannels, /*srgb=*/false, reinterpret_cast<std::uint8_t*>( blockDest ) );
+            }
+        }
+    }
+}
+
+#if OTK_USE_X86_INTRINSICS
+OTK_TARGET_AVX2 void ProceduralImage::evaluateAVX2( char*        dest,
+                                                    size_t       rowPitch,
+                                                    unsigned int levelWidth,
+                                                    unsigned int levelHeight,
+                                                    unsigned int x0,
+                                                    unsigned int y0,
+                                                    unsigned int width,
+                                                    unsigned int height ) const
+{
+    evaluateRect<AVX2Kernels>( dest, rowPitch, levelWidth, levelHeight, x0, y0, width, height );
+}
+#endif
+
+void ProceduralImage::evaluate( char*        dest,
+                                size_t       rowPitch,
+                                unsigned int levelWidth,
+                                unsigned int levelHeight,
+                                unsigned int x0,
+                                unsigned int y0,
+                                unsigned int width,
+                                unsigned int height ) const
+{
+#if OTK_USE_X86_INTRINSICS
+    if( g_useAVX2 && hasAVX2() )
+    {
+        evaluateAVX2( dest, rowPitch, levelWidth, levelHeight, x0, y0, width, height );
+        return;
+    }
+#endif
+    evaluateRect<BaselineKernels>( dest, rowPitch, levelWidth, levelHeight, x0, y0, width, height );
+}
+
+bool ProceduralImage::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream /*stream*/ )
+{
+    OTK_ASSERT_MSG( mipLevel < m_info.numMipLevels, "Attempt to read from non-existent mip-level." );
+
+    const unsigned int  levelWidth  = std::max( 1U, m_info.width >> mipLevel );
+    const unsigned int  levelHeight = std::max( 1U, m_info.height >> mipLevel );
+    const PixelPosition start       = pixelPosition( tile );
+    const size_t        rowPitch    = tile.width * m_info.numChannels * getBytesPerChannel( m_info.format );
+
+    const unsigned int width  = start.x < levelWidth ? std::min( tile.width, levelWidth - start.x ) : 0;
+    const unsigned int height = start.y < levelHeight ? std::min( tile.height, levelHeight - start.y ) : 0;
+    if( width < tile.width || height < tile.height )
+        std::memset( dest, 0, rowPitch * tile.height );
+    evaluate( dest, rowPitch, levelWidth, levelHeight, start.x, start.y, width, height );
+    return true;
+}
+
+bool ProceduralImage::readMipLevel( char* dest, unsigned int mipLevel, unsigned int width, unsigned int height, CUstream /*stream*/ )
+{
+    OTK_ASSERT_MSG( mipLevel < m_info.numMipLevels, "Attempt to read from non-existent mip-level." );
+    evaluate( dest, width * m_info.numChannels * getBytesPerChannel( m_info.format ), width, height, 0, 0, width, height );
+    return true;
+}
+
+bool ProceduralImage::readBaseColor( float4& dest )
+{
+    std::vector<float> workspace( getWorkspaceBlocks() * BLOCK );
+    evaluateBlock<BaselineKernels>( 1, 1, 0, 0, /*newColumn=*/true, workspace.data() );
+
+    float color[4] = { 0.f, 0.f, 0.f, 0.f };
+    for( unsigned int c = 0; c < m_info.numChannels; ++c )
+        color[c] = workspace[m_channelRegisters[c] * BLOCK];
+    dest = float4{ color[0], color[1], color[2], color[3] };
+    return true;
+}
+
+}  // namespace imageSource
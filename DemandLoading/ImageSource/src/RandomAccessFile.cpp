@@ -0,0 +1,326 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "RandomAccessFile.h"
+#include "IoRing.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <memory>
+#include <vector>
+
+namespace imageSource {
+
+namespace {
+
+// Check that each read lies within a file of the given size.
+bool areInBounds( const FileRead* reads, size_t numReads, unsigned long long fileSize )
+{
+    for( size_t i = 0; i < numReads; ++i )
+    {
+        if( reads[i].offset > fileSize || reads[i].size > fileSize - reads[i].offset )
+            return false;
+    }
+    return true;
+}
+
+std::atomic<bool> g_useIoRing( true );
+
+}  // namespace
+
+const size_t RandomAccessFile::MAX_COALESCED_GAP;
+
+void RandomAccessFile::setUseIoRing( bool useIoRing )
+{
+    g_useIoRing = useIoRing;
+}
+
+#ifdef _WIN32
+
+bool RandomAccessFile::open( const std::string& path )
+{
+    close();
+    HANDLE handle = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if( handle == INVALID_HANDLE_VALUE )
+        return false;
+    LARGE_INTEGER size;
+    if( !GetFileSizeEx( handle, &size ) )
+    {
+        CloseHandle( handle );
+        return false;
+    }
+    m_handle = handle;
+    m_size   = static_cast<unsigned long long>( size.QuadPart );
+    return true;
+}
+
+void RandomAccessFile::close()
+{
+    if( m_handle != nullptr )
+        CloseHandle( static_cast<HANDLE>( m_handle ) );
+    m_handle = nullptr;
+    m_size   = 0;
+}
+
+bool RandomAccessFile::isOpen() const
+{
+    return m_handle != nullptr;
+}
+
+bool RandomAccessFile::read( void* dest, size_t numBytes, unsigned long long offset ) const
+{
+    if( m_handle == nullptr || offset > m_size || numBytes > m_size - offset )
+        return false;
+    char* ptr = static_cast<char*>( dest );
+    while( numBytes > 0 )
+    {
+        OVERLAPPED overlapped{};
+        overlapped.Offset     = static_cast<DWORD>( offset );
+        overlapped.OffsetHigh = static_cast<DWORD>( offset >> 32 );
+        const DWORD request   = numBytes > 0x40000000 ? 0x40000000 : static_cast<DWORD>( numBytes );
+        DWORD       numRead   = 0;
+        if( !ReadFile( static_cast<HANDLE>( m_handle ), ptr, request, &numRead, &overlapped ) || numRead == 0 )
+            return false;
+        ptr += numRead;
+        offset += numRead;
+        numBytes -= numRead;
+    }
+    return true;
+}
+
+bool RandomAccessFile::isIoRingAvailable()
+{
+    return false;
+}
+
+bool RandomAccessFile::read( const FileRead* reads, size_t numReads ) const
+{
+    // Windows has no positional vectored read for buffered handles, so the reads are issued in turn.
+    for( size_t i = 0; i < numReads; ++i )
+    {
+        if( !read( reads[i].dest, reads[i].size, reads[i].offset ) )
+            return false;
+    }
+    return true;
+}
+
+#else
+
+bool RandomAccessFile::open( const std::string& path )
+{
+    close();
+    const int fd = ::open( path.c_str(), O_RDONLY );
+    if( fd < 0 )
+        return false;
+    struct stat status;
+    if( fstat( fd, &status ) != 0 )
+    {
+        ::close( fd );
+        return false;
+    }
+    m_fd   = fd;
+    m_size = static_cast<unsigned long long>( status.st_size );
+    return true;
+}
+
+void RandomAccessFile::close()
+{
+    if( m_fd >= 0 )
+        ::close( m_fd );
+    m_fd   = -1;
+    m_size = 0;
+}
+
+bool RandomAccessFile::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+bool RandomAccessFile::read( void* dest, size_t numBytes, unsigned long long offset ) const
+{
+    if( m_fd < 0 || offset > m_size || numBytes > m_size - offset )
+        return false;
+    char* ptr = static_cast<char*>( dest );
+    while( numBytes > 0 )
+    {
+        const ssize_t numRead = ::pread( m_fd, ptr, numBytes, static_cast<off_t>( offset ) );
+        if( numRead < 0 && errno == EINTR )
+            continue;
+        if( numRead <= 0 )
+            return false;
+        ptr += numRead;
+        offset += static_cast<unsigned long long>( numRead );
+        numBytes -= static_cast<size_t>( numRead );
+    }
+    return true;
+}
+
+namespace {
+
+// Maximum number of buffers in a single preadv call (IOV_MAX is at least 1024 on Linux).
+const size_t MAX_IOVECS = 256;
+
+// Number of reads in flight in the io_uring ring of each thread.
+const unsigned int IO_RING_ENTRIES = 64;
+
+// Skip the buffers filled by a read of the given number of bytes, and advance into a partially
+// filled one.
+void advanceIov( iovec*& iov, size_t& numIov, size_t numRead )
+{
+    while( numIov > 0 && numRead >= iov->iov_len )
+    {
+        numRead -= iov->iov_len;
+        ++iov;
+        --numIov;
+    }
+    if( numIov > 0 )
+    {
+        iov->iov_base = static_cast<char*>( iov->iov_base ) + numRead;
+        iov->iov_len -= numRead;
+    }
+}
+
+// Read the given buffers at the given offset, resuming after partial reads.
+bool preadvAll( int fd, iovec* iov, size_t numIov, unsigned long long offset )
+{
+    while( numIov > 0 )
+    {
+        const ssize_t numRead = ::preadv( fd, iov, static_cast<int>( numIov ), static_cast<off_t>( offset ) );
+        if( numRead < 0 && errno == EINTR )
+            continue;
+        if( numRead <= 0 )
+            return false;
+        offset += static_cast<unsigned long long>( numRead );
+        advanceIov( iov, numIov, static_cast<size_t>( numRead ) );
+    }
+    return true;
+}
+
+// Get the io_uring ring of the calling thread, creating it on first use.  Returns null if
+// io_uring is disabled or unavailable; once creation fails, no other thread tries again.
+IoRing* getThreadRing()
+{
+    static std::atomic<bool>             s_unavailable( false );
+    thread_local std::unique_ptr<IoRing> ring;
+    thread_local bool                    created = false;
+    if( !g_useIoRing || s_unavailable )
+        return nullptr;
+    if( !created )
+    {
+        created = true;
+        ring    = IoRing::create( IO_RING_ENTRIES );
+        if( !ring )
+            s_unavailable = true;
+    }
+    return ring.get();
+}
+
+// A run of nearby reads, which is read by a single vectored read.
+struct ReadRun
+{
+    unsigned long long offset;
+    size_t             firstIov;
+    size_t             numIov;
+};
+
+}  // namespace
+
+bool RandomAccessFile::isIoRingAvailable()
+{
+    return getThreadRing() != nullptr;
+}
+
+bool RandomAccessFile::read( const FileRead* reads, size_t numReads ) const
+{
+    if( m_fd < 0 || !areInBounds( reads, numReads, m_size ) )
+        return false;
+
+    std::vector<const FileRead*> sorted;
+    sorted.reserve( numReads );
+    for( size_t i = 0; i < numReads; ++i )
+    {
+        if( reads[i].size > 0 )
+            sorted.push_back( &reads[i] );
+    }
+    std::sort( sorted.begin(), sorted.end(), []( const FileRead* a, const FileRead* b ) { return a->offset < b->offset; } );
+
+    // Bytes in the gaps between coalesced reads are discarded into a scratch buffer, which
+    // concurrent ring reads may share since its contents are never used.
+    thread_local std::vector<char> gapBuffer( MAX_COALESCED_GAP );
+    std::vector<iovec>             iov;
+    std::vector<ReadRun>           runs;
+    iov.reserve( 2 * sorted.size() );
+
+    size_t first = 0;
+    while( first < sorted.size() )
+    {
+        // Gather a run of reads that are close together, without overlaps.
+        const unsigned long long start  = sorted[first]->offset;
+        unsigned long long       end    = start;
+        size_t                   last   = first;
+        const size_t             runIov = iov.size();
+        for( ; last < sorted.size() && iov.size() - runIov + 2 <= MAX_IOVECS; ++last )
+        {
+            const FileRead& next = *sorted[last];
+            if( last > first && ( next.offset < end || next.offset - end > MAX_COALESCED_GAP ) )
+                break;
+            if( next.offset > end )
+                iov.push_back( iovec{ gapBuffer.data(), static_cast<size_t>( next.offset - end ) } );
+            iov.push_back( iovec{ next.dest, next.size } );
+            end = next.offset + next.size;
+        }
+        runs.push_back( ReadRun{ start, runIov, iov.size() - runIov } );
+        first = last;
+    }
+
+    // Submit several runs to the ring of this thread, so that they are in flight together.
+    // Short reads are finished with preadv, as are all the runs if the ring fails.
+    IoRing* ring = runs.size() > 1 ? getThreadRing() : nullptr;
+    if( ring != nullptr )
+    {
+        std::vector<IoRing::Read> ringReads;
+        ringReads.reserve( runs.size() );
+        for( const ReadRun& run : runs )
+            ringReads.push_back( IoRing::Read{ m_fd, &iov[run.firstIov], static_cast<unsigned int>( run.numIov ), run.offset, 0 } );
+        if( ring->readAll( ringReads.data(), ringReads.size() ) )
+        {
+            for( ReadRun& run : runs )
+            {
+                const long long result = ringReads[&run - runs.data()].result;
+                if( result < 0 && result != -EINTR && result != -EAGAIN )
+                    return false;
+                if( result > 0 )
+                {
+                    iovec* runIov = &iov[run.firstIov];
+                    advanceIov( runIov, run.numIov, static_cast<size_t>( result ) );
+                    run.firstIov = static_cast<size_t>( runIov - iov.data() );
+                    run.offset += static_cast<unsigned long long>( result );
+                }
+            }
+        }
+    }
+    for( const ReadRun& run : runs )
+    {
+        if( run.numIov > 0 && !preadvAll( m_fd, &iov[run.firstIov], run.numIov, run.offset ) )
+            return false;
+    }
+    return true;
+}
+
+#endif
+
+}  // namespace imageSource
@@ -0,0 +1,74 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace imageSource {
+
+/// A read of a contiguous range of a file into memory.
+struct FileRead
+{
+    void*              dest;
+    size_t             size;
+    unsigned long long offset;
+};
+
+/// Read-only file supporting concurrent reads at arbitrary offsets (pread on POSIX, overlapped
+/// ReadFile on Windows).  Reads do not move a shared file position, so no locking is required.
+/// The read methods are virtual so that tests can instrument them (e.g. to inject latency).
+class RandomAccessFile
+{
+  public:
+    RandomAccessFile() = default;
+    virtual ~RandomAccessFile() { close(); }
+
+    RandomAccessFile( const RandomAccessFile& )            = delete;
+    RandomAccessFile& operator=( const RandomAccessFile& ) = delete;
+
+    /// Open the file, returning false on failure.
+    bool open( const std::string& path );
+
+    /// Close the file.
+    void close();
+
+    bool isOpen() const;
+
+    /// Get the file size in bytes.
+    unsigned long long size() const { return m_size; }
+
+    /// Read the given number of bytes at the given offset.  Returns false if the read fails or
+    /// extends beyond the end of the file.
+    virtual bool read( void* dest, size_t numBytes, unsigned long long offset ) const;
+
+    /// Perform a batch of reads, which may be given in any order.  Reads of nearby ranges are
+    /// coalesced into a single vectored read (preadv), skipping gaps of up to MAX_COALESCED_GAP bytes,
+    /// which turns the strided rows of a tile into a few system calls.  On Linux, when a batch
+    /// coalesces into several vectored reads, they are submitted together through an io_uring ring
+    /// owned by the calling thread, so that they are in flight at once.  Returns false if any read
+    /// fails.
+    virtual bool read( const FileRead* reads, size_t numReads ) const;
+
+    /// Enable or disable io_uring submission of batches, which is enabled by default.  Batches are
+    /// read with one preadv call after another when it is disabled or unavailable.
+    static void setUseIoRing( bool useIoRing );
+
+    /// Returns true if batches read by the calling thread are submitted through io_uring.
+    static bool isIoRingAvailable();
+
+    /// Largest gap between two reads that is read and discarded to coalesce them.
+    static const size_t MAX_COALESCED_GAP = 4096;
+
+  private:
+#ifdef _WIN32
+    void* m_handle = nullptr;
+#else
+    int m_fd = -1;
+#endif
+    unsigned long long m_size = 0;
+};
+
+}  // namespace imageSource
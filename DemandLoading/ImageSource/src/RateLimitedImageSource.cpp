@@ -63,6 +63,19 @@ bool RateLimitedImageSource::readMipLevel( char* dest, unsigned int mipLevel, un
     return result;
 }
 
+/// Delegates to the wrapped ImageSource and decrements the time remaining, unless the
+/// time limit has been exceeded, in which case nothing is done and false is returned.
+bool RateLimitedImageSource::readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream )
+{
+    if( m_duration->load() <= Microseconds( 0 ) )
+        return false;
+
+    Timer timer;
+    bool  result = WrappedImageSource::readScanlines( dest, mipLevel, firstRow, numRows, stream );
+    *m_duration -= timer.elapsed();
+    return result;
+}
+
 /// Delegates to the wrapped ImageSource and decrements the time remaining, unless the
 /// time limit has been exceeded, in which case nothing is done and false is returned.
 bool RateLimitedImageSource::readMipTail( char*        dest,
@@ -0,0 +1,88 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "ReadQueue.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace imageSource {
+
+const size_t ReadQueue::MAX_MERGED_READS;
+
+ReadQueue::ReadQueue( unsigned int numThreads )
+{
+    for( unsigned int i = 0; i < std::max( 1U, numThreads ); ++i )
+        m_threads.emplace_back( &ReadQueue::worker, this );
+}
+
+ReadQueue::~ReadQueue()
+{
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_shutdown = true;
+    }
+    m_cond.notify_all();
+    for( std::thread& thread : m_threads )
+        thread.join();
+}
+
+ReadQueue& ReadQueue::getInstance()
+{
+    static ReadQueue queue( std::min( 32U, std::max( 4U, std::thread::hardware_concurrency() ) ) );
+    return queue;
+}
+
+void ReadQueue::submit( std::shared_ptr<const RandomAccessFile> file, std::vector<FileRead> reads, Completion completion )
+{
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_batches.push_back( Batch{ std::move( file ), std::move( reads ), std::move( completion ) } );
+    }
+    m_cond.notify_one();
+}
+
+void ReadQueue::worker()
+{
+    std::vector<Batch>    batches;
+    std::vector<FileRead> reads;
+    while( true )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_cond.wait( lock, [this] { return m_shutdown || !m_batches.empty(); } );
+            if( m_batches.empty() )
+                return;
+
+            // Take the next batch, along with any queued batches for the same file.
+            batches.clear();
+            size_t numReads = 0;
+            for( auto it = m_batches.begin(); it != m_batches.end() && numReads < MAX_MERGED_READS; )
+            {
+                if( !batches.empty() && ( it->file != batches[0].file || numReads + it->reads.size() > MAX_MERGED_READS ) )
+                {
+                    ++it;
+                    continue;
+                }
+                numReads += it->reads.size();
+                batches.push_back( std::move( *it ) );
+                it = m_batches.erase( it );
+            }
+        }
+
+        reads.clear();
+        for( const Batch& batch : batches )
+            reads.insert( reads.end(), batch.reads.begin(), batch.reads.end() );
+        const bool merged = batches[0].file->read( reads.data(), reads.size() );
+
+        // If the merged read failed, retry the batches separately to determine which failed.
+        for( Batch& batch : batches )
+        {
+            const bool ok = merged || batches.size() == 1 || batch.file->read( batch.reads.data(), batch.reads.size() );
+            batch.completion( ok );
+        }
+    }
+}
+
+}  // namespace imageSource
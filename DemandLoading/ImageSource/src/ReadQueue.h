@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include "RandomAccessFile.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace imageSource {
+
+/// ReadQueue performs batches of file reads on a pool of I/O threads, so that many reads are in
+/// flight at once rather than one per fill thread.  Batches for the same file that are waiting in
+/// the queue are merged, letting RandomAccessFile coalesce their ranges into vectored reads.
+/// The completion callback of each batch is invoked on an I/O thread; it should hand any
+/// expensive work (e.g. decoding) back to another thread.
+///
+/// On Linux, each I/O thread submits the vectored reads of a merged batch through its own
+/// io_uring ring (see RandomAccessFile), so a batch that spans several ranges of the file keeps
+/// them in flight together.  Elsewhere, or when io_uring is unavailable, the threads issue
+/// blocking preadv calls (ReadFile on Windows) one after another.
+class ReadQueue
+{
+  public:
+    /// Called with true if every read of a batch succeeded.
+    using Completion = std::function<void( bool )>;
+
+    /// Start the given number of I/O threads (at least one).
+    explicit ReadQueue( unsigned int numThreads );
+
+    /// Finish the queued batches and join the I/O threads.
+    ~ReadQueue();
+
+    ReadQueue( const ReadQueue& )            = delete;
+    ReadQueue& operator=( const ReadQueue& ) = delete;
+
+    /// Enqueue a batch of reads from the given file.  The destinations must remain valid until the
+    /// completion callback is invoked.
+    void submit( std::shared_ptr<const RandomAccessFile> file, std::vector<FileRead> reads, Completion completion );
+
+    /// Get the process-wide queue, which has a thread per hardware thread (up to 32) since most
+    /// of its time is spent waiting on the device.
+    static ReadQueue& getInstance();
+
+    /// Maximum number of reads merged from queued batches into a single call.
+    static const size_t MAX_MERGED_READS = 256;
+
+  private:
+    struct Batch
+    {
+        std::shared_ptr<const RandomAccessFile> file;
+        std::vector<FileRead>                   reads;
+        Completion                              completion;
+    };
+
+    std::mutex               m_mutex;
+    std::condition_variable  m_cond;
+    std::deque<Batch>        m_batches;
+    std::vector<std::thread> m_threads;
+    bool                     m_shutdown = false;
+
+    void worker();
+};
+
+}  // namespace imageSource
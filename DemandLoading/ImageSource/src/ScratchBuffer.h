@@ -0,0 +1,24 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace imageSource {
+
+/// Returns a per-thread scratch buffer holding at least the given number of elements, which
+/// avoids allocations on the fill threads.  Each Tag has its own buffer, so that a wrapped image
+/// that also uses a scratch buffer does not reuse the buffer of the image wrapping it.
+template <typename Tag, typename T = char>
+std::vector<T>& getScratchBuffer( size_t size )
+{
+    thread_local std::vector<T> buffer;
+    if( buffer.size() < size )
+        buffer.resize( size );
+    return buffer;
+}
+
+}  // namespace imageSource
@@ -0,0 +1,245 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/SharedTileCache.h>
+
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace imageSource {
+
+size_t SharedTileCache::KeyHash::operator()( const Key& key ) const
+{
+    const unsigned long long values[] = { key.imageId,    key.mipLevel,     key.tile.x, key.tile.y,
+                                          key.tile.width, key.tile.height, key.type };
+
+    // FNV-1a over the key fields.
+    unsigned long long hash = 14695981039346656037ULL;
+    for( unsigned long long value : values )
+    {
+        hash ^= value;
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<size_t>( hash );
+}
+
+bool SharedTileCache::KeyEqual::operator()( const Key& lhs, const Key& rhs ) const
+{
+    return lhs.imageId == rhs.imageId && lhs.mipLevel == rhs.mipLevel && lhs.tile.x == rhs.tile.x && lhs.tile.y == rhs.tile.y
+           && lhs.tile.width == rhs.tile.width && lhs.tile.height == rhs.tile.height && lhs.type == rhs.type;
+}
+
+SharedTileCache::SharedTileCache( size_t maxSize )
+    : m_maxSize( maxSize )
+{
+}
+
+SharedTileCache::TileBuffer SharedTileCache::findOrDecode( const Key& key, size_t size, const DecodeFunction& decode )
+{
+    std::promise<TileBuffer> promise;
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        auto entry = m_entries.find( key );
+        if( entry != m_entries.end() )
+        {
+            ++m_numHits;
+            m_lru.splice( m_lru.begin(), m_lru, entry->second.lruPosition );
+            return entry->second.buffer;
+        }
+
+        // Wait for the request that is decoding the tile.
+        auto pending = m_pending.find( key );
+        if( pending != m_pending.end() )
+        {
+            ++m_numCoalesced;
+            std::shared_future<TileBuffer> future = pending->second;
+            lock.unlock();
+            return future.get();
+        }
+
+        ++m_numMisses;
+        m_pending.emplace( key, promise.get_future().share() );
+    }
+
+    TileBuffer buffer;
+    try
+    {
+        std::shared_ptr<std::vector<char>> tile = std::make_shared<std::vector<char>>( size );
+        if( decode( tile->data() ) )
+            buffer = std::move( tile );
+    }
+    catch( ... )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_pending.erase( key );
+        }
+        promise.set_exception( std::current_exception() );
+        throw;
+    }
+
+    {
+        // The tile is cached before it stops pending, so later requests find one or the other.
+        std::unique_lock<std::mutex> lock( m_mutex );
+        if( buffer )
+            insert( key, buffer );
+        m_pending.erase( key );
+    }
+    promise.set_value( buffer );
+    return buffer;
+}
+
+void SharedTileCache::insert( const Key& key, const TileBuffer& buffer )
+{
+    if( buffer->size() > m_maxSize )
+        return;
+
+    m_lru.push_front( key );
+    m_entries[key] = Entry{ buffer, m_lru.begin() };
+    m_size += buffer->size();
+
+    // The inserted tile is the most recently used, so it is evicted last.
+    while( m_size > m_maxSize )
+    {
+        auto entry = m_entries.find( m_lru.back() );
+        m_size -= entry->second.buffer->size();
+        m_entries.erase( entry );
+        m_lru.pop_back();
+        ++m_numEvictions;
+    }
+}
+
+void SharedTileCache::removeImage( unsigned long long imageId )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    for( auto it = m_lru.begin(); it != m_lru.end(); )
+    {
+        if( it->imageId != imageId )
+        {
+            ++it;
+            continue;
+        }
+        auto entry = m_entries.find( *it );
+        m_size -= entry->second.buffer->size();
+        m_entries.erase( entry );
+        it = m_lru.erase( it );
+    }
+}
+
+void SharedTileCache::clear()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_entries.clear();
+    m_lru.clear();
+    m_size = 0;
+}
+
+size_t SharedTileCache::getSize() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_size;
+}
+
+size_t SharedTileCache::getNumTiles() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_entries.size();
+}
+
+unsigned long long SharedTileCache::getNumHits() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numHits;
+}
+
+unsigned long long SharedTileCache::getNumMisses() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numMisses;
+}
+
+unsigned long long SharedTileCache::getNumCoalesced() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numCoalesced;
+}
+
+unsigned long long SharedTileCache::getNumEvictions() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numEvictions;
+}
+
+SharedCachedImageSource::SharedCachedImageSource( std::shared_ptr<ImageSource> imageSource, std::shared_ptr<SharedTileCache> cache )
+    : WrappedImageSource( std::move( imageSource ) )
+    , m_cache( std::move( cache ) )
+    , m_imageId( m_cache->createImageId() )
+{
+}
+
+SharedCachedImageSource::~SharedCachedImageSource()
+{
+    m_cache->removeImage( m_imageId );
+}
+
+bool SharedCachedImageSource::readCached( char* dest, const SharedTileCache::Key& key, size_t size, const SharedTileCache::DecodeFunction& decode )
+{
+    const SharedTileCache::TileBuffer buffer = m_cache->findOrDecode( key, size, decode );
+    if( !buffer )
+        return false;
+
+    std::copy( buffer->begin(), buffer->end(), dest );
+    return true;
+}
+
+bool SharedCachedImageSource::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    if( WrappedImageSource::getFillType() != CU_MEMORYTYPE_HOST )
+        return WrappedImageSource::readTile( dest, mipLevel, tile, stream );
+
+    const TextureInfo&         info = WrappedImageSource::getInfo();
+    const SharedTileCache::Key key{ m_imageId, mipLevel, tile, SharedTileCache::READ_TILE };
+    return readCached( dest, key, getImageSizeInBytes( info.format, info.numChannels, tile.width, tile.height ), [&]( char* tileDest ) {
+        return WrappedImageSource::readTile( tileDest, mipLevel, tile, stream );
+    } );
+}
+
+bool SharedCachedImageSource::readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream )
+{
+    if( WrappedImageSource::getFillType() != CU_MEMORYTYPE_HOST )
+        return WrappedImageSource::readMipLevel( dest, mipLevel, expectedWidth, expectedHeight, stream );
+
+    const TextureInfo&         info = WrappedImageSource::getInfo();
+    const SharedTileCache::Key key{ m_imageId, mipLevel, Tile{ 0, 0, expectedWidth, expectedHeight }, SharedTileCache::READ_MIP_LEVEL };
+    return readCached( dest, key, getImageSizeInBytes( info.format, info.numChannels, expectedWidth, expectedHeight ), [&]( char* levelDest ) {
+        return WrappedImageSource::readMipLevel( levelDest, mipLevel, expectedWidth, expectedHeight, stream );
+    } );
+}
+
+bool SharedCachedImageSource::readMipTail( char*        dest,
+                                           unsigned int mipTailFirstLevel,
+                                           unsigned int numMipLevels,
+                                           const uint2* mipLevelDims,
+                                           unsigned int pixelSizeInBytes,
+                                           CUstream     stream )
+{
+    if( WrappedImageSource::getFillType() != CU_MEMORYTYPE_HOST )
+        return WrappedImageSource::readMipTail( dest, mipTailFirstLevel, numMipLevels, mipLevelDims, pixelSizeInBytes, stream );
+
+    const TextureInfo& info = WrappedImageSource::getInfo();
+    size_t             size = 0;
+    for( unsigned int mipLevel = mipTailFirstLevel; mipLevel < numMipLevels; ++mipLevel )
+        size += getImageSizeInBytes( info.format, info.numChannels, mipLevelDims[mipLevel].x, mipLevelDims[mipLevel].y );
+
+    const SharedTileCache::Key key{ m_imageId, mipTailFirstLevel, Tile{ 0, 0, numMipLevels, 0 }, SharedTileCache::READ_MIP_TAIL };
+    return readCached( dest, key, size, [&]( char* tailDest ) {
+        return WrappedImageSource::readMipTail( tailDest, mipTailFirstLevel, numMipLevels, mipLevelDims, pixelSizeInBytes, stream );
+    } );
+}
+
+}  // namespace imageSource
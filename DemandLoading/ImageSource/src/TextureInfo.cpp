@@ -43,9 +43,84 @@ unsigned int getBytesPerChannel( const CUarray_format format )
     }
 }
 
+bool isBlockCompressed( CUarray_format format )
+{
+    return getNumChannelsInBlockFormat( format ) != 0;
+}
+
+unsigned int getNumChannelsInBlockFormat( CUarray_format format )
+{
+    switch( format )
+    {
+#if CUDA_VERSION >= 11050
+        case CU_AD_FORMAT_BC4_UNORM:
+        case CU_AD_FORMAT_BC4_SNORM:
+            return 1;
+
+        case CU_AD_FORMAT_BC5_UNORM:
+        case CU_AD_FORMAT_BC5_SNORM:
+            return 2;
+
+        case CU_AD_FORMAT_BC6H_UF16:
+        case CU_AD_FORMAT_BC6H_SF16:
+            return 3;
+
+        case CU_AD_FORMAT_BC1_UNORM:
+        case CU_AD_FORMAT_BC1_UNORM_SRGB:
+        case CU_AD_FORMAT_BC2_UNORM:
+        case CU_AD_FORMAT_BC2_UNORM_SRGB:
+        case CU_AD_FORMAT_BC3_UNORM:
+        case CU_AD_FORMAT_BC3_UNORM_SRGB:
+        case CU_AD_FORMAT_BC7_UNORM:
+        case CU_AD_FORMAT_BC7_UNORM_SRGB:
+            return 4;
+#endif
+
+        default:
+            return 0;
+    }
+}
+
+unsigned int getBytesPerBlock( CUarray_format format, unsigned int numChannels )
+{
+    switch( format )
+    {
+#if CUDA_VERSION >= 11050
+        // BC1 and BC4 store 4x4 texels in 64 bits, the other formats in 128 bits.
+        case CU_AD_FORMAT_BC1_UNORM:
+        case CU_AD_FORMAT_BC1_UNORM_SRGB:
+        case CU_AD_FORMAT_BC4_UNORM:
+        case CU_AD_FORMAT_BC4_SNORM:
+            return 8;
+
+        case CU_AD_FORMAT_BC2_UNORM:
+        case CU_AD_FORMAT_BC2_UNORM_SRGB:
+        case CU_AD_FORMAT_BC3_UNORM:
+        case CU_AD_FORMAT_BC3_UNORM_SRGB:
+        case CU_AD_FORMAT_BC5_UNORM:
+        case CU_AD_FORMAT_BC5_SNORM:
+        case CU_AD_FORMAT_BC6H_UF16:
+        case CU_AD_FORMAT_BC6H_SF16:
+        case CU_AD_FORMAT_BC7_UNORM:
+        case CU_AD_FORMAT_BC7_UNORM_SRGB:
+            return 16;
+#endif
+
+        default:
+            return getBytesPerChannel( format ) * numChannels;
+    }
+}
+
+size_t getImageSizeInBytes( CUarray_format format, unsigned int numChannels, unsigned int width, unsigned int height )
+{
+    const unsigned int blockDim = getBlockDim( format );
+    return static_cast<size_t>( getBytesPerBlock( format, numChannels ) ) * ( ( width + blockDim - 1 ) / blockDim )
+           * ( ( height + blockDim - 1 ) / blockDim );
+}
+
 size_t getTextureSizeInBytes( const TextureInfo& info )
 {
-    size_t texSize = static_cast<size_t>( getBytesPerChannel( info.format ) ) * info.numChannels * info.width * info.height;
+    size_t texSize = getImageSizeInBytes( info.format, info.numChannels, info.width, info.height );
     if( info.numMipLevels > 1 )
         texSize = texSize * 4ULL / 3ULL;
     return texSize;
@@ -0,0 +1,422 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/TexturePreviewSampler.h>
+
+#include <OptiXToolkit/ImageSource/FormatConversion.h>
+#include <OptiXToolkit/ShaderUtil/CubicFiltering.h>
+#include <OptiXToolkit/ShaderUtil/vec_math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace imageSource {
+
+namespace {
+
+// Number of samples whose filter setup and weights are computed together.
+const unsigned int BATCH = 64;
+
+// Width and height of the tiles of pixels distributed over threads by sampleImage.
+const unsigned int TILE_SIZE = 32;
+
+// Apply an address mode to a texel index, returning -1 for border texels.
+inline int applyAddressMode( int i, int n, CUaddress_mode mode )
+{
+    if( i >= 0 && i < n )
+        return i;
+    switch( mode )
+    {
+        case CU_TR_ADDRESS_MODE_WRAP:
+            i %= n;
+            return i < 0 ? i + n : i;
+        case CU_TR_ADDRESS_MODE_MIRROR:
+        {
+            int m = i % ( 2 * n );
+            m     = m < 0 ? m + 2 * n : m;
+            return m < n ? m : 2 * n - 1 - m;
+        }
+        case CU_TR_ADDRESS_MODE_BORDER:
+            return -1;
+        default:
+            return i < 0 ? 0 : n - 1;
+    }
+}
+
+inline float mix( float a, float b, float x )
+{
+    return ( 1.0f - x ) * a + x * b;
+}
+
+}  // namespace
+
+// The filter setup of a sample, computed as in textureCubic.  Level 0 is the cubic level, and level 1
+// the next coarser level blended in FILTER_BICUBIC mode.
+struct TexturePreviewSampler::Setup
+{
+    float  s;
+    float  t;
+    float2 ddx;
+    float2 ddy;
+    float  cubicBlend;
+    float  ml;
+    int    mipLevel;
+    bool   blendLevels;
+    int    level[2];  // index into m_levels
+    float  ts[2];
+    float  tt[2];
+};
+
+TexturePreviewSampler::TexturePreviewSampler( std::shared_ptr<ImageSource> image, const TexturePreviewDescriptor& desc )
+    : m_desc( desc )
+{
+    if( !image->isOpen() )
+        image->open( nullptr );
+    m_info = image->getInfo();
+    if( !m_info.isValid )
+        throw std::runtime_error( "TexturePreviewSampler: invalid image" );
+    if( isBlockCompressed( m_info.format ) )
+        throw std::runtime_error( "TexturePreviewSampler: block-compressed images are not supported" );
+    if( image->getFillType() != CU_MEMORYTYPE_HOST )
+        throw std::runtime_error( "TexturePreviewSampler: only host-filled images are supported" );
+
+    OutputFormat floatFormat;
+    floatFormat.format      = CU_AD_FORMAT_FLOAT;
+    floatFormat.numChannels = 4;
+
+    std::vector<char> buffer;
+    m_levels.resize( m_info.numMipLevels );
+    for( unsigned int mipLevel = 0; mipLevel < m_info.numMipLevels; ++mipLevel )
+    {
+        Level& level = m_levels[mipLevel];
+        level.width  = static_cast<int>( std::max( m_info.width >> mipLevel, 1U ) );
+        level.height = static_cast<int>( std::max( m_info.height >> mipLevel, 1U ) );
+        buffer.resize( getImageSizeInBytes( m_info.format, m_info.numChannels, level.width, level.height ) );
+        if( !image->readMipLevel( buffer.data(), mipLevel, level.width, level.height, CUstream{} ) )
+            throw std::runtime_error( "TexturePreviewSampler: failed to read mip level " + std::to_string( mipLevel ) );
+        level.texels.resize( static_cast<size_t>( level.width ) * level.height );
+        convertPixels( buffer.data(), m_info.format, m_info.numChannels, level.texels.size(), floatFormat, level.texels.data() );
+    }
+}
+
+float4 TexturePreviewSampler::fetch( const Level& level, int x, int y ) const
+{
+    x = applyAddressMode( x, level.width, m_desc.addressMode[0] );
+    y = applyAddressMode( y, level.height, m_desc.addressMode[1] );
+    if( x < 0 || y < 0 )
+        return float4{};
+    return level.texels[static_cast<size_t>( y ) * level.width + x];
+}
+
+float4 TexturePreviewSampler::lookup( const Level& level, float s, float t ) const
+{
+    if( m_desc.filterMode == FILTER_POINT )
+        return fetch( level, static_cast<int>( floorf( s * level.width ) ), static_cast<int>( floorf( t * level.height ) ) );
+
+    const float x  = s * level.width - 0.5f;
+    const float y  = t * level.height - 0.5f;
+    const float fi = floorf( x );
+    const float fj = floorf( y );
+    const float fx = x - fi;
+    const float fy = y - fj;
+    const int   i  = static_cast<int>( fi );
+    const int   j  = static_cast<int>( fj );
+    if( i >= 0 && i + 1 < level.width && j >= 0 && j + 1 < level.height )
+    {
+        const float4* row = &level.texels[static_cast<size_t>( j ) * level.width + i];
+        return lerp( lerp( row[0], row[1], fx ), lerp( row[level.width], row[level.width + 1], fx ), fy );
+    }
+    return lerp( lerp( fetch( level, i, j ), fetch( level, i + 1, j ), fx ),
+                 lerp( fetch( level, i, j + 1 ), fetch( level, i + 1, j + 1 ), fx ), fy );
+}
+
+float4 TexturePreviewSampler::sampleGrad( float s, float t, float2 ddx, float2 ddy ) const
+{
+    const Level& base   = m_levels[0];
+    const int    last   = static_cast<int>( m_levels.size() ) - 1;
+    const int    maxAniso = static_cast<int>( std::max( m_desc.maxAnisotropy, 1U ) );
+
+    // Probes are spaced along the longer gradient, enough of them to cover it with the filter width
+    // used to select the mip level.
+    const float   lengthX = length( float2{ ddx.x * base.width, ddx.y * base.height } );
+    const float   lengthY = length( float2{ ddy.x * base.width, ddy.y * base.height } );
+    const float2  major   = ( lengthX >= lengthY ) ? ddx : ddy;
+    const float   ratio   = fmaxf( lengthX, lengthY ) / fmaxf( fminf( lengthX, lengthY ), 1.0e-8f );
+    const int     numProbes = std::min( maxAniso, std::max( 1, static_cast<int>( ceilf( ratio - 1.0e-3f ) ) ) );
+
+    auto probeLevel = [&]( int mipLevel ) {
+        const Level& level = m_levels[mipLevel];
+        float4       sum{};
+        for( int probe = 0; probe < numProbes; ++probe )
+        {
+            const float offset = ( probe + 0.5f ) / numProbes - 0.5f;
+            sum += lookup( level, s + offset * major.x, t + offset * major.y );
+        }
+        return sum / static_cast<float>( numProbes );
+    };
+
+    float ml = getMipLevel( ddx, ddy, base.width, base.height, 1.0f / maxAniso );
+    if( m_desc.mipmapFilterMode == CU_TR_FILTER_MODE_POINT )
+        return probeLevel( std::min( std::max( static_cast<int>( ceilf( ml - 0.5f ) ), 0 ), last ) );
+
+    ml                  = fminf( fmaxf( ml, 0.0f ), static_cast<float>( last ) );
+    const int   level0  = static_cast<int>( floorf( ml ) );
+    const float fraction = ml - level0;
+    const float4 value  = probeLevel( level0 );
+    return ( fraction > 0.0f ) ? lerp( value, probeLevel( level0 + 1 ), fraction ) : value;
+}
+
+float4 TexturePreviewSampler::sampleWeighted( const Level& level, int i, int j, const float* wx, const float* wy ) const
+{
+    float4 sum{};
+    if( i >= 1 && i + 2 < level.width && j >= 1 && j + 2 < level.height )
+    {
+        // Interior taps need no address mode.
+        const float4* row = &level.texels[static_cast<size_t>( j - 1 ) * level.width + i - 1];
+        for( int b = 0; b < 4; ++b, row += level.width )
+            sum += wy[b] * ( wx[0] * row[0] + wx[1] * row[1] + wx[2] * row[2] + wx[3] * row[3] );
+        return sum;
+    }
+    for( int b = 0; b < 4; ++b )
+    {
+        float4 rowSum{};
+        for( int a = 0; a < 4; ++a )
+            rowSum += wx[a] * fetch( level, i - 1 + a, j - 1 + b );
+        sum += wy[b] * rowSum;
+    }
+    return sum;
+}
+
+void TexturePreviewSampler::filterBatch( unsigned int count, const Setup* setups, float4* result, float4* dresultds, float4* dresultdt ) const
+{
+    const bool derivatives = dresultds || dresultdt;
+
+    // Cubic weights of the whole batch, value and derivative, for both levels, in loops the
+    // compiler vectorizes.  Index as weights[level][kind][tap][sample], where kind is x, y, dx, dy.
+    float weights[2][4][4][BATCH];
+    for( int lvl = 0; lvl < 2; ++lvl )
+    {
+        for( unsigned int k = 0; k < count; ++k )
+        {
+            const float  fx = setups[k].ts[lvl] - floorf( setups[k].ts[lvl] );
+            const float  fy = setups[k].tt[lvl] - floorf( setups[k].tt[lvl] );
+            const float4 wx = cubicWeights( fx );
+            const float4 wy = cubicWeights( fy );
+            weights[lvl][0][0][k] = wx.x;
+            weights[lvl][0][1][k] = wx.y;
+            weights[lvl][0][2][k] = wx.z;
+            weights[lvl][0][3][k] = wx.w;
+            weights[lvl][1][0][k] = wy.x;
+            weights[lvl][1][1][k] = wy.y;
+            weights[lvl][1][2][k] = wy.z;
+            weights[lvl][1][3][k] = wy.w;
+        }
+        if( !derivatives )
+            continue;
+        for( unsigned int k = 0; k < count; ++k )
+        {
+            const float  fx = setups[k].ts[lvl] - floorf( setups[k].ts[lvl] );
+            const float  fy = setups[k].tt[lvl] - floorf( setups[k].tt[lvl] );
+            const float4 dwx = cubicDerivativeWeights( fx );
+            const float4 dwy = cubicDerivativeWeights( fy );
+            weights[lvl][2][0][k] = dwx.x;
+            weights[lvl][2][1][k] = dwx.y;
+            weights[lvl][2][2][k] = dwx.z;
+            weights[lvl][2][3][k] = dwx.w;
+            weights[lvl][3][0][k] = dwy.x;
+            weights[lvl][3][1][k] = dwy.y;
+            weights[lvl][3][2][k] = dwy.z;
+            weights[lvl][3][3][k] = dwy.w;
+        }
+    }
+
+    for( unsigned int k = 0; k < count; ++k )
+    {
+        const Setup& p = setups[k];
+        float4       res{};
+        float4       drds{};
+        float4       drdt{};
+
+        // Linear and point sampling
+        const Level& level0       = m_levels[p.level[0]];
+        const float  levelWidth0  = static_cast<float>( level0.width );
+        const float  levelHeight0 = static_cast<float>( level0.height );
+        if( p.cubicBlend < 1.0f )
+        {
+            if( result )
+                res = sampleGrad( p.s, p.t, p.ddx, p.ddy );
+
+            if( m_desc.filterMode != FILTER_POINT && derivatives )
+            {
+                const float  i  = floorf( p.ts[0] );
+                const float  j  = floorf( p.tt[0] );
+                const float  ii = ( p.ts[0] - i > 0.5f ) ? i + 0.5f : i;
+                const float  jj = ( p.tt[0] - j > 0.5f ) ? j + 0.5f : j;
+                const float  s0 = ( ii + 0.5f ) / levelWidth0;
+                const float  s1 = ( ii + 1.0f ) / levelWidth0;
+                const float  t0 = ( jj + 0.5f ) / levelHeight0;
+                const float  t1 = ( jj + 1.0f ) / levelHeight0;
+                const float4 t00 = sampleGrad( s0, t0, p.ddx, p.ddy ) * levelWidth0 * 2.0f;
+                const float4 t10 = sampleGrad( s1, t0, p.ddx, p.ddy ) * levelWidth0 * 2.0f;
+                const float4 t01 = sampleGrad( s0, t1, p.ddx, p.ddy ) * levelHeight0 * 2.0f;
+                const float4 t11 = sampleGrad( s1, t1, p.ddx, p.ddy ) * levelHeight0 * 2.0f;
+                drds = lerp( t10, t11, 2.0f * ( p.tt[0] - jj ) ) - lerp( t00, t01, 2.0f * ( p.tt[0] - jj ) );
+                drdt = lerp( t01, t11, 2.0f * ( p.ts[0] - ii ) ) - lerp( t00, t10, 2.0f * ( p.ts[0] - ii ) );
+            }
+        }
+
+        // Cubic sampling of one or two levels
+        for( int lvl = 0; lvl < 2 && p.cubicBlend > 0.0f; ++lvl )
+        {
+            if( lvl == 1 && !p.blendLevels )
+                break;
+            const Level& level = m_levels[p.level[lvl]];
+            const int    i     = static_cast<int>( floorf( p.ts[lvl] ) );
+            const int    j     = static_cast<int>( floorf( p.tt[lvl] ) );
+            float        w[4][4];
+            for( int kind = 0; kind < ( derivatives ? 4 : 2 ); ++kind )
+                for( int tap = 0; tap < 4; ++tap )
+                    w[kind][tap] = weights[lvl][kind][tap][k];
+
+            // The first level blends with the linear result, the second with the first level.
+            const float levelBlend = ( lvl == 0 ) ? 1.0f - p.cubicBlend : ( p.mipLevel + 1 ) - p.ml;
+            if( result )
+                res = lerp( sampleWeighted( level, i, j, w[0], w[1] ), res, levelBlend );
+            if( derivatives )
+            {
+                const float4 cubicDrds = sampleWeighted( level, i, j, w[2], w[1] ) * static_cast<float>( level.width );
+                const float4 cubicDrdt = sampleWeighted( level, i, j, w[0], w[3] ) * static_cast<float>( level.height );
+                drds = lerp( cubicDrds, drds, levelBlend );
+                drdt = lerp( cubicDrdt, drdt, levelBlend );
+            }
+        }
+
+        if( result )
+            result[k] = res;
+        if( dresultds )
+            dresultds[k] = drds;
+        if( dresultdt )
+            dresultdt[k] = drdt;
+    }
+}
+
+void TexturePreviewSampler::sample( float s, float t, float2 ddx, float2 ddy, float4* result, float4* dresultds, float4* dresultdt ) const
+{
+    sampleBatch( 1, &s, &t, &ddx, &ddy, result, dresultds, dresultdt );
+}
+
+void TexturePreviewSampler::sampleBatch( unsigned int  count,
+                                         const float*  s,
+                                         const float*  t,
+                                         const float2* ddx,
+                                         const float2* ddy,
+                                         float4*       result,
+                                         float4*       dresultds,
+                                         float4*       dresultdt ) const
+{
+    const bool derivatives = dresultds || dresultdt;
+    const int  texWidth    = static_cast<int>( m_info.width );
+    const int  texHeight   = static_cast<int>( m_info.height );
+    const int  last        = static_cast<int>( m_levels.size() ) - 1;
+    const unsigned int filterMode = m_desc.filterMode;
+
+    Setup setups[BATCH];
+    for( unsigned int begin = 0; begin < count; begin += BATCH )
+    {
+        const unsigned int batchSize = std::min( BATCH, count - begin );
+        for( unsigned int k = 0; k < batchSize; ++k )
+        {
+            Setup& p = setups[k];
+            p.s      = s[begin + k];
+            p.t      = t[begin + k];
+            p.ddx    = ddx[begin + k];
+            p.ddy    = ddy[begin + k];
+
+            // Follow textureCubic: fix the gradients, then determine the blend between linear and
+            // cubic filtering, and the mip level.
+            fixGradients( p.ddx, p.ddy, texWidth, texHeight, filterMode, m_desc.conservativeFilter );
+            const float pixelSpan = getPixelSpan( p.ddx, p.ddy, texWidth, texHeight );
+            p.cubicBlend          = ( filterMode == FILTER_BICUBIC ) ? 1.0f : 0.0f;
+            if( filterMode == FILTER_SMARTBICUBIC && pixelSpan <= 2.0f )
+                p.cubicBlend = fminf( 2.0f - pixelSpan, 1.0f );
+
+            p.ml       = 0.0f;
+            p.mipLevel = 0;
+            if( derivatives || filterMode == FILTER_BICUBIC )
+            {
+                p.ml = getMipLevel( p.ddx, p.ddy, texWidth, texHeight, 1.0f / m_desc.maxAnisotropy );
+                if( m_desc.mipmapFilterMode == CU_TR_FILTER_MODE_POINT )
+                    p.ml = fmaxf( 0.0f, ceilf( p.ml - 0.5f ) );
+                p.mipLevel = std::max( static_cast<int>( floorf( p.ml ) ), 0 );
+            }
+            p.blendLevels = !( filterMode != FILTER_BICUBIC || m_desc.mipmapFilterMode == CU_TR_FILTER_MODE_POINT
+                               || p.ml == p.mipLevel || p.ml <= 0.0f );
+
+            // Levels past the end of the mip chain use the last level, like the hardware.
+            for( int lvl = 0; lvl < 2; ++lvl )
+            {
+                p.level[lvl] = std::min( p.mipLevel + lvl, last );
+                p.ts[lvl]    = p.s * m_levels[p.level[lvl]].width - 0.5f;
+                p.tt[lvl]    = p.t * m_levels[p.level[lvl]].height - 0.5f;
+            }
+        }
+        filterBatch( batchSize, setups, result ? result + begin : nullptr, dresultds ? dresultds + begin : nullptr,
+                     dresultdt ? dresultdt + begin : nullptr );
+    }
+}
+
+void TexturePreviewSampler::sampleImage( unsigned int width,
+                                         unsigned int height,
+                                         float2       uv00,
+                                         float2       uv11,
+                                         float2       ddx,
+                                         float2       ddy,
+                                         float4*      result,
+                                         float4*      dresultds,
+                                         float4*      dresultdt,
+                                         unsigned int numThreads ) const
+{
+    const unsigned int tilesWide = ( width + TILE_SIZE - 1 ) / TILE_SIZE;
+    const unsigned int numTiles  = tilesWide * ( ( height + TILE_SIZE - 1 ) / TILE_SIZE );
+    std::atomic<unsigned int> nextTile( 0 );
+
+    auto worker = [&]() {
+        float  s[TILE_SIZE];
+        float  t[TILE_SIZE];
+        float2 ddxs[TILE_SIZE];
+        float2 ddys[TILE_SIZE];
+        std::fill( ddxs, ddxs + TILE_SIZE, ddx );
+        std::fill( ddys, ddys + TILE_SIZE, ddy );
+        for( unsigned int tile = nextTile++; tile < numTiles; tile = nextTile++ )
+        {
+            const unsigned int x0    = ( tile % tilesWide ) * TILE_SIZE;
+            const unsigned int y0    = ( tile / tilesWide ) * TILE_SIZE;
+            const unsigned int count = std::min( TILE_SIZE, width - x0 );
+            for( unsigned int x = 0; x < count; ++x )
+                s[x] = mix( uv00.x, uv11.x, ( x0 + x + 0.5f ) / width );
+            for( unsigned int y = y0; y < std::min( y0 + TILE_SIZE, height ); ++y )
+            {
+                std::fill( t, t + count, mix( uv00.y, uv11.y, ( y + 0.5f ) / height ) );
+                const size_t offset = static_cast<size_t>( y ) * width + x0;
+                sampleBatch( count, s, t, ddxs, ddys, result ? result + offset : nullptr,
+                             dresultds ? dresultds + offset : nullptr, dresultdt ? dresultdt + offset : nullptr );
+            }
+        }
+    };
+
+    if( numThreads == 0 )
+        numThreads = std::max( std::thread::hardware_concurrency(), 1U );
+    numThreads = std::min( numThreads, numTiles );
+    std::vector<std::thread> threads;
+    for( unsigned int i = 1; i < numThreads; ++i )
+        threads.emplace_back( worker );
+    worker();
+    for( std::thread& thread : threads )
+        thread.join();
+}
+
+}  // namespace imageSource
@@ -0,0 +1,111 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/ThrottledImageSource.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace imageSource {
+
+ThrottledImageSource::ThrottledImageSource( std::shared_ptr<ImageSource> imageSource, std::shared_ptr<BandwidthLimiter> limiter )
+    : WrappedImageSource( std::move( imageSource ) )
+    , m_limiter( std::move( limiter ) )
+{
+    if( !m_limiter && !getFilename().empty() )
+        m_limiter = BandwidthLimiter::getDeviceLimiter( getFilename() );
+    m_lastBytesRead = WrappedImageSource::getNumBytesRead();
+}
+
+void ThrottledImageSource::acquire( IOPriority priority, size_t decodedBytes )
+{
+    if( !m_limiter )
+        return;
+    settle();
+
+    size_t numBytes = decodedBytes;
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        if( m_bytesRead != 0 && m_decodedBytes != 0 )
+            numBytes = static_cast<size_t>( static_cast<double>( decodedBytes ) * m_bytesRead / m_decodedBytes );
+        m_decodedBytes += decodedBytes;
+        m_bytesCharged += numBytes;
+    }
+    m_limiter->acquire( this, priority, numBytes );
+}
+
+void ThrottledImageSource::settle()
+{
+    const unsigned long long bytesRead = WrappedImageSource::getNumBytesRead();
+    long long                correction;
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        // A count that went down was restarted, e.g. by reopening the image.
+        const unsigned long long newBytes = bytesRead >= m_lastBytesRead ? bytesRead - m_lastBytesRead : bytesRead;
+        m_lastBytesRead                   = bytesRead;
+        if( newBytes == 0 )
+            return;
+        m_bytesRead += newBytes;
+        correction     = static_cast<long long>( m_bytesRead ) - static_cast<long long>( m_bytesCharged );
+        m_bytesCharged = m_bytesRead;
+    }
+    m_limiter->charge( correction );
+}
+
+bool ThrottledImageSource::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    const TextureInfo& info = getInfo();
+    acquire( IO_PRIORITY_TILE, getImageSizeInBytes( info.format, info.numChannels, tile.width, tile.height ) );
+    const bool result = WrappedImageSource::readTile( dest, mipLevel, tile, stream );
+    if( m_limiter )
+        settle();
+    return result;
+}
+
+std::future<bool> ThrottledImageSource::readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    const TextureInfo& info = getInfo();
+    acquire( IO_PRIORITY_TILE, getImageSizeInBytes( info.format, info.numChannels, tile.width, tile.height ) );
+    return WrappedImageSource::readTileAsync( dest, mipLevel, tile, stream );
+}
+
+bool ThrottledImageSource::readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream )
+{
+    const TextureInfo& info = getInfo();
+    acquire( IO_PRIORITY_MIP_LEVEL, getImageSizeInBytes( info.format, info.numChannels, expectedWidth, expectedHeight ) );
+    const bool result = WrappedImageSource::readMipLevel( dest, mipLevel, expectedWidth, expectedHeight, stream );
+    if( m_limiter )
+        settle();
+    return result;
+}
+
+bool ThrottledImageSource::readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream )
+{
+    const TextureInfo& info = getInfo();
+    acquire( IO_PRIORITY_TILE, getImageSizeInBytes( info.format, info.numChannels, std::max( info.width >> mipLevel, 1U ), numRows ) );
+    const bool result = WrappedImageSource::readScanlines( dest, mipLevel, firstRow, numRows, stream );
+    if( m_limiter )
+        settle();
+    return result;
+}
+
+bool ThrottledImageSource::readMipTail( char*        dest,
+                                        unsigned int mipTailFirstLevel,
+                                        unsigned int numMipLevels,
+                                        const uint2* mipLevelDims,
+                                        unsigned int pixelSizeInBytes,
+                                        CUstream     stream )
+{
+    const TextureInfo& info     = getInfo();
+    size_t             numBytes = 0;
+    for( unsigned int mipLevel = mipTailFirstLevel; mipLevel < numMipLevels; ++mipLevel )
+        numBytes += getImageSizeInBytes( info.format, info.numChannels, mipLevelDims[mipLevel].x, mipLevelDims[mipLevel].y );
+    acquire( IO_PRIORITY_MIP_TAIL, numBytes );
+    const bool result = WrappedImageSource::readMipTail( dest, mipTailFirstLevel, numMipLevels, mipLevelDims, pixelSizeInBytes, stream );
+    if( m_limiter )
+        settle();
+    return result;
+}
+
+}  // namespace imageSource
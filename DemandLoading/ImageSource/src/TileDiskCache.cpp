@@ -0,0 +1,527 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/TileDiskCache.h>
+
+#include "Blake2b.h"
+#include "FileStatus.h"
+
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <direct.h>
+#include <process.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace imageSource {
+
+namespace {
+
+const char         BLOB_MAGIC[8] = { 'O', 'T', 'K', 'T', 'I', 'L', 'E', '1' };
+const unsigned int DIGEST_SIZE   = 16;
+
+// Uses recorded in the index by one cache before it compacts the index.
+const unsigned long long MAX_USES_BETWEEN_CLEANUPS = 1 << 16;
+
+// Temporary files older than this (in microseconds) were left by writers that failed or were killed.
+const long long MAX_TEMP_FILE_AGE = 3600LL * 1000000;
+
+// Each blob starts with this header, followed by the tile data.
+struct BlobHeader
+{
+    char               magic[8];
+    unsigned long long size;
+    unsigned char      checksum[DIGEST_SIZE];
+};
+
+void computeChecksum( const char* data, size_t size, unsigned char* checksum )
+{
+    Blake2b hasher( DIGEST_SIZE );
+    hasher.update( data, size );
+    hasher.finish( checksum );
+}
+
+ImageHash finishKey( Blake2b& hasher )
+{
+    unsigned char digest[DIGEST_SIZE];
+    hasher.finish( digest );
+    ImageHash key{};
+    for( unsigned int i = 0; i < 8; ++i )
+    {
+        key.lo |= static_cast<unsigned long long>( digest[i] ) << ( 8 * i );
+        key.hi |= static_cast<unsigned long long>( digest[i + 8] ) << ( 8 * i );
+    }
+    return key;
+}
+
+std::string toHex( const ImageHash& key )
+{
+    char buffer[33];
+    std::snprintf( buffer, sizeof( buffer ), "%016llx%016llx", key.hi, key.lo );
+    return buffer;
+}
+
+// Microseconds since the epoch, which orders uses across processes.
+long long getTime()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::system_clock::now().time_since_epoch() ).count();
+}
+
+bool makeDirectory( const std::string& path )
+{
+#ifdef _WIN32
+    return _mkdir( path.c_str() ) == 0 || errno == EEXIST;
+#else
+    return mkdir( path.c_str(), 0777 ) == 0 || errno == EEXIST;
+#endif
+}
+
+bool isHex( const std::string& str )
+{
+    return std::all_of( str.begin(), str.end(), []( char c ) { return std::isxdigit( static_cast<unsigned char>( c ) ) != 0; } );
+}
+
+bool endsWith( const std::string& str, const std::string& suffix )
+{
+    return str.size() >= suffix.size() && str.compare( str.size() - suffix.size(), suffix.size(), suffix ) == 0;
+}
+
+// Returns the names of the entries of the given directory, other than . and ..
+std::vector<std::string> listDirectory( const std::string& path )
+{
+    std::vector<std::string> names;
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE           handle = FindFirstFileA( ( path + "/*" ).c_str(), &data );
+    if( handle == INVALID_HANDLE_VALUE )
+        return names;
+    do
+        names.push_back( data.cFileName );
+    while( FindNextFileA( handle, &data ) );
+    FindClose( handle );
+#else
+    DIR* dir = opendir( path.c_str() );
+    if( dir == nullptr )
+        return names;
+    while( const dirent* entry = readdir( dir ) )
+        names.push_back( entry->d_name );
+    closedir( dir );
+#endif
+    names.erase( std::remove_if( names.begin(), names.end(), []( const std::string& name ) { return name == "." || name == ".."; } ),
+                 names.end() );
+    return names;
+}
+
+// Rename a temporary file over the given path.  Returns false if it could not be moved into place.
+}  // namespace
+
+// Exclusive lock on a file in the cache directory, held by one thread of one process at a time.
+class TileDiskCache::DirectoryLock
+{
+  public:
+    explicit DirectoryLock( const std::string& path )
+    {
+#ifdef _WIN32
+        m_handle = CreateFileA( path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+        if( m_handle == INVALID_HANDLE_VALUE )
+            throw std::runtime_error( "Cannot open tile cache lock file " + path );
+#else
+        m_fd = ::open( path.c_str(), O_RDWR | O_CREAT, 0666 );
+        if( m_fd < 0 )
+            throw std::runtime_error( "Cannot open tile cache lock file " + path );
+#endif
+    }
+
+    ~DirectoryLock()
+    {
+#ifdef _WIN32
+        CloseHandle( m_handle );
+#else
+        ::close( m_fd );
+#endif
+    }
+
+    void lock()
+    {
+        // File locks are held per process (or per open file), so threads are serialized first.
+        m_mutex.lock();
+#ifdef _WIN32
+        OVERLAPPED overlapped{};
+        LockFileEx( m_handle, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped );
+#else
+        while( flock( m_fd, LOCK_EX ) != 0 && errno == EINTR )
+        {
+        }
+#endif
+    }
+
+    void unlock()
+    {
+#ifdef _WIN32
+        OVERLAPPED overlapped{};
+        UnlockFileEx( m_handle, 0, 1, 0, &overlapped );
+#else
+        flock( m_fd, LOCK_UN );
+#endif
+        m_mutex.unlock();
+    }
+
+  private:
+    std::mutex m_mutex;
+#ifdef _WIN32
+    HANDLE m_handle;
+#else
+    int m_fd;
+#endif
+};
+
+TileDiskCache::TileDiskCache( const TileDiskCacheOptions& options )
+    : m_options( options )
+    , m_indexPath( options.directory + "/index" )
+{
+    if( m_options.directory.empty() || !makeDirectory( m_options.directory ) )
+        throw std::runtime_error( "Cannot create tile cache directory " + m_options.directory );
+    m_lock.reset( new DirectoryLock( m_options.directory + "/lock" ) );
+}
+
+TileDiskCache::~TileDiskCache()
+{
+    flush();
+}
+
+std::string TileDiskCache::getBlobPath( const ImageHash& key ) const
+{
+    const std::string hex = toHex( key );
+    return m_options.directory + "/" + hex.substr( 0, 2 ) + "/" + hex + ".tile";
+}
+
+bool TileDiskCache::read( const ImageHash& key, char* dest, size_t size )
+{
+    const std::string path = getBlobPath( key );
+    bool              isCorrupt = false;
+    bool              isHit     = false;
+    {
+        std::ifstream file( path, std::ios::binary );
+        if( file.is_open() )
+        {
+            BlobHeader header;
+            isHit = file.read( reinterpret_cast<char*>( &header ), sizeof( header ) )
+                    && std::memcmp( header.magic, BLOB_MAGIC, sizeof( BLOB_MAGIC ) ) == 0 && header.size == size
+                    && file.read( dest, size ) && file.peek() == std::ifstream::traits_type::eof();
+            if( isHit )
+            {
+                unsigned char checksum[DIGEST_SIZE];
+                computeChecksum( dest, size, checksum );
+                isHit = std::memcmp( checksum, header.checksum, DIGEST_SIZE ) == 0;
+            }
+            isCorrupt = !isHit;
+        }
+    }
+    if( isCorrupt )
+        std::remove( path.c_str() );
+
+    std::vector<Use> uses;
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        if( !isHit )
+        {
+            ++m_numMisses;
+            m_numCorruptBlobs += isCorrupt ? 1 : 0;
+            return false;
+        }
+        ++m_numHits;
+        m_pendingUses.push_back( Use{ key, sizeof( BlobHeader ) + size, getTime() } );
+        if( m_pendingUses.size() < m_options.maxPendingUses )
+            return true;
+        uses.swap( m_pendingUses );
+    }
+    appendUses( uses );
+
+    // Compact the index if it has grown by many uses, even if no tiles are written.
+    bool needsCleanup;
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_numUsesSinceCleanup += uses.size();
+        needsCleanup = m_numUsesSinceCleanup > MAX_USES_BETWEEN_CLEANUPS;
+    }
+    if( needsCleanup )
+        cleanup();
+    return true;
+}
+
+void TileDiskCache::write( const ImageHash& key, const char* data, size_t size )
+{
+    BlobHeader header;
+    std::memcpy( header.magic, BLOB_MAGIC, sizeof( BLOB_MAGIC ) );
+    header.size = size;
+    computeChecksum( data, size, header.checksum );
+
+    // Write a temporary file that is unique to this process and thread, and rename it into place.
+    // Concurrent writers of the same key write the same contents, so either may win.
+    const std::string path     = getBlobPath( key );
+    const std::string tempPath = getTempFilename( path );
+
+    makeDirectory( path.substr( 0, path.rfind( '/' ) ) );
+    {
+        std::ofstream file( tempPath, std::ios::binary | std::ios::trunc );
+        file.write( reinterpret_cast<const char*>( &header ), sizeof( header ) );
+        file.write( data, size );
+        if( !file )
+        {
+            file.close();
+            std::remove( tempPath.c_str() );
+            return;
+        }
+    }
+    if( !replaceFile( tempPath, path ) )
+        return;
+
+    const unsigned long long blobSize = sizeof( BlobHeader ) + size;
+    appendUses( std::vector<Use>{ Use{ key, blobSize, getTime() } } );
+
+    bool needsCleanup;
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_bytesSinceCleanup += blobSize;
+        needsCleanup = m_bytesSinceCleanup > m_options.maxSize / 8;
+    }
+    if( needsCleanup )
+        cleanup();
+}
+
+void TileDiskCache::flush()
+{
+    std::vector<Use> uses;
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        uses.swap( m_pendingUses );
+    }
+    if( !uses.empty() )
+        appendUses( uses );
+}
+
+void TileDiskCache::appendUses( const std::vector<Use>& uses )
+{
+    // Each line holds the key, blob size and time of use.  The index is reopened under the lock,
+    // since cleanup replaces it.
+    std::ostringstream lines;
+    for( const Use& use : uses )
+        lines << toHex( use.key ) << ' ' << use.size << ' ' << use.time << '\n';
+
+    m_lock->lock();
+    {
+        std::ofstream file( m_indexPath, std::ios::app );
+        file << lines.str();
+    }
+    m_lock->unlock();
+}
+
+void TileDiskCache::cleanup()
+{
+    flush();
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_bytesSinceCleanup   = 0;
+        m_numUsesSinceCleanup = 0;
+    }
+
+    struct Entry
+    {
+        unsigned long long size;
+        long long          lastUse;
+    };
+
+    m_lock->lock();
+    try
+    {
+        // Find the last use of each blob recorded in the index.
+        std::map<std::string, long long> lastUses;
+        {
+            std::ifstream file( m_indexPath );
+            std::string   line;
+            while( std::getline( file, line ) )
+            {
+                std::istringstream str( line );
+                std::string        hex;
+                unsigned long long size;
+                long long          lastUse;
+                if( !( str >> hex >> size >> lastUse ) || hex.size() != 32 )
+                    continue;
+                auto it = lastUses.find( hex );
+                if( it == lastUses.end() )
+                    lastUses[hex] = lastUse;
+                else
+                    it->second = std::max( it->second, lastUse );
+            }
+        }
+
+        // Measure the blobs in the directory, which include those written by other processes since
+        // they last cleaned up.  Blobs missing from the index, e.g. because their writer was killed
+        // before recording them, were last used when they were written.  Abandoned temporary files
+        // are removed; recent ones may still be being written.
+        const long long                                 now       = getTime();
+        unsigned long long                              totalSize = 0;
+        std::map<std::string, Entry>                    entries;
+        std::vector<std::pair<long long, std::string>> byLastUse;
+        for( const std::string& subdirectory : listDirectory( m_options.directory ) )
+        {
+            if( subdirectory.size() != 2 || !isHex( subdirectory ) )
+                continue;
+            const std::string subdirectoryPath = m_options.directory + "/" + subdirectory;
+            for( const std::string& name : listDirectory( subdirectoryPath ) )
+            {
+                const std::string path = subdirectoryPath + "/" + name;
+                long long         modificationTime;
+                long long         fileSize;
+                if( !getFileStatus( path, modificationTime, fileSize ) )
+                    continue;
+                if( endsWith( name, ".tmp" ) )
+                {
+                    if( now - modificationTime / 1000 > MAX_TEMP_FILE_AGE )
+                        std::remove( path.c_str() );
+                    continue;
+                }
+                const std::string hex = name.substr( 0, 32 );
+                if( name.size() != 37 || !endsWith( name, ".tile" ) || !isHex( hex ) )
+                    continue;
+
+                auto  use   = lastUses.find( hex );
+                Entry entry = { static_cast<unsigned long long>( fileSize ), use != lastUses.end() ? use->second : modificationTime / 1000 };
+                entries[hex] = entry;
+                totalSize += entry.size;
+                byLastUse.push_back( std::make_pair( entry.lastUse, hex ) );
+            }
+        }
+
+        // Remove the least recently used blobs.
+        if( totalSize > m_options.maxSize )
+        {
+            std::sort( byLastUse.begin(), byLastUse.end() );
+            const unsigned long long targetSize = m_options.maxSize / 4 * 3;
+            for( size_t i = 0; i < byLastUse.size() && totalSize > targetSize; ++i )
+            {
+                const std::string& hex = byLastUse[i].second;
+                std::remove( ( m_options.directory + "/" + hex.substr( 0, 2 ) + "/" + hex + ".tile" ).c_str() );
+                totalSize -= entries[hex].size;
+                entries.erase( hex );
+            }
+        }
+
+        // Replace the index with one line per blob.
+        const std::string tempPath = m_indexPath + ".tmp";
+        {
+            std::ofstream file( tempPath, std::ios::trunc );
+            for( const auto& keyValue : entries )
+                file << keyValue.first << ' ' << keyValue.second.size << ' ' << keyValue.second.lastUse << '\n';
+        }
+        replaceFile( tempPath, m_indexPath );
+    }
+    catch( ... )
+    {
+        m_lock->unlock();
+        throw;
+    }
+    m_lock->unlock();
+}
+
+unsigned long long TileDiskCache::getNumHits() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numHits;
+}
+
+unsigned long long TileDiskCache::getNumMisses() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numMisses;
+}
+
+unsigned long long TileDiskCache::getNumCorruptBlobs() const
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    return m_numCorruptBlobs;
+}
+
+DiskCachedImageSource::DiskCachedImageSource( std::shared_ptr<ImageSource> imageSource, std::shared_ptr<TileDiskCache> cache )
+    : WrappedImageSource( std::move( imageSource ) )
+    , m_cache( std::move( cache ) )
+{
+}
+
+void DiskCachedImageSource::open( TextureInfo* info )
+{
+    TextureInfo baseInfo;
+    WrappedImageSource::open( &baseInfo );
+
+    const std::string path = WrappedImageSource::getFilename();
+    long long         modificationTime;
+    long long         fileSize;
+    m_isCaching = baseInfo.isValid && WrappedImageSource::getFillType() == CU_MEMORYTYPE_HOST
+                  && getFileStatus( path, modificationTime, fileSize );
+    if( m_isCaching )
+    {
+        Blake2b hasher( DIGEST_SIZE );
+        const std::string variant = WrappedImageSource::getFileVariant();
+        hasher.update( path.data(), path.size() );
+        hasher.updateValue( variant.size() );
+        hasher.update( variant.data(), variant.size() );
+        hasher.updateValue( modificationTime );
+        hasher.updateValue( fileSize );
+        hasher.updateValue( baseInfo.width );
+        hasher.updateValue( baseInfo.height );
+        hasher.updateValue( static_cast<unsigned int>( baseInfo.format ) );
+        hasher.updateValue( baseInfo.numChannels );
+        hasher.updateValue( baseInfo.numMipLevels );
+        m_imageKey = finishKey( hasher );
+    }
+    if( info != nullptr )
+        *info = baseInfo;
+}
+
+bool DiskCachedImageSource::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    if( !m_isCaching )
+        return WrappedImageSource::readTile( dest, mipLevel, tile, stream );
+
+    Blake2b hasher( DIGEST_SIZE );
+    hasher.updateValue( m_imageKey );
+    hasher.updateValue( mipLevel );
+    hasher.updateValue( tile );
+    const ImageHash    key  = finishKey( hasher );
+    const TextureInfo& info = WrappedImageSource::getInfo();
+    const size_t       size = getImageSizeInBytes( info.format, info.numChannels, tile.width, tile.height );
+    if( m_cache->read( key, dest, size ) )
+        return true;
+
+    std::fill( dest, dest + size, 0 );
+    if( !WrappedImageSource::readTile( dest, mipLevel, tile, stream ) )
+        return false;
+    m_cache->write( key, dest, size );
+    return true;
+}
+
+}  // namespace imageSource
@@ -7,14 +7,26 @@
 #include <OptiXToolkit/Error/ErrorCheck.h>
 
 #include <algorithm>
+#include <exception>
 #include <memory>
 #include <stdexcept>
 #include <utility>
 
 namespace imageSource {
 
-TiledImageSource::TiledImageSource( std::shared_ptr<ImageSource> baseImage )
+namespace {
+
+// Bands are at least this many rows, which spans the tiles of most formats, rounded up to a
+// whole number of the base image's scanline chunks.
+const unsigned int MIN_BAND_HEIGHT = 64;
+
+}  // namespace
+
+TiledImageSource::TiledImageSource( std::shared_ptr<ImageSource> baseImage, unsigned int maxCachedBands, bool buildMipLevels )
     : WrappedImageSource( baseImage )
+    , m_baseImage( baseImage )
+    , m_maxCachedBands( std::max( maxCachedBands, 1U ) )
+    , m_buildMipLevels( buildMipLevels )
 {
     if( baseImage->isOpen() )
     {
@@ -27,6 +39,22 @@ void TiledImageSource::getBaseInfo()
     m_tiledInfo = WrappedImageSource::getInfo();
     m_baseIsTiled       = m_tiledInfo.isTiled;
     m_tiledInfo.isTiled = true;
+
+    const unsigned int chunkHeight = m_baseIsTiled ? 0 : m_baseImage->getScanlineChunkHeight();
+    m_isStreaming                  = chunkHeight > 0;
+    if( m_isStreaming )
+    {
+        m_bandHeight       = ( MIN_BAND_HEIGHT + chunkHeight - 1 ) / chunkHeight * chunkHeight;
+        m_numBaseLevels    = m_tiledInfo.numMipLevels;
+        m_pixelSizeInBytes = getBytesPerChannel( m_tiledInfo.format ) * m_tiledInfo.numChannels;
+        if( m_buildMipLevels && m_numBaseLevels == 1 )
+            m_tiledInfo.numMipLevels = calculateNumMipLevels( m_tiledInfo.width, m_tiledInfo.height );
+    }
+}
+
+uint2 TiledImageSource::getLevelDimensions( unsigned int mipLevel ) const
+{
+    return uint2{ std::max( m_tiledInfo.width >> mipLevel, 1U ), std::max( m_tiledInfo.height >> mipLevel, 1U ) };
 }
 
 void TiledImageSource::open( TextureInfo* info )
@@ -46,7 +74,9 @@ void TiledImageSource::open( TextureInfo* info )
 void TiledImageSource::close()
 {
     WrappedImageSource::close();
+    std::unique_lock<std::mutex> lock( m_dataMutex );
     m_tiledInfo = TextureInfo{};
+    m_bands.clear();
 }
 
 const TextureInfo& TiledImageSource::getInfo() const
@@ -59,6 +89,124 @@ const TextureInfo& TiledImageSource::getInfo() const
     return m_tiledInfo;
 }
 
+bool TiledImageSource::isStreaming() const
+{
+    std::unique_lock<std::mutex> lock( m_dataMutex );
+    return m_isStreaming;
+}
+
+unsigned int TiledImageSource::getNumCachedBands() const
+{
+    std::unique_lock<std::mutex> lock( m_dataMutex );
+    return static_cast<unsigned int>( m_bands.size() );
+}
+
+TiledImageSource::Band TiledImageSource::getBand( unsigned int mipLevel, unsigned int bandIndex, CUstream stream )
+{
+    const std::pair<unsigned int, unsigned int> key( mipLevel, bandIndex );
+    std::shared_future<Band>                    band;
+    std::promise<Band>                          promise;
+    {
+        std::unique_lock<std::mutex> lock( m_dataMutex );
+        auto                         it = m_bands.find( key );
+        if( it != m_bands.end() )
+        {
+            it->second.lastUsed = ++m_bandClock;
+            band                = it->second.band;
+        }
+        else
+        {
+            // Evict the least recently used bands.  Readers still copying from them hold references.
+            while( m_bands.size() >= m_maxCachedBands )
+            {
+                auto lru = std::min_element( m_bands.begin(), m_bands.end(),
+                                             []( const std::pair<const std::pair<unsigned int, unsigned int>, CachedBand>& lhs,
+                                                 const std::pair<const std::pair<unsigned int, unsigned int>, CachedBand>& rhs ) {
+                                                 return lhs.second.lastUsed < rhs.second.lastUsed;
+                                             } );
+                m_bands.erase( lru );
+            }
+            m_bands[key] = CachedBand{ promise.get_future().share(), ++m_bandClock };
+        }
+    }
+    if( band.valid() )
+        return band.get();
+
+    // This thread decodes the band; others requesting it wait for the result.
+    try
+    {
+        Band result = loadBand( mipLevel, bandIndex, stream );
+        promise.set_value( result );
+        return result;
+    }
+    catch( ... )
+    {
+        {
+            std::unique_lock<std::mutex> lock( m_dataMutex );
+            m_bands.erase( key );
+        }
+        promise.set_exception( std::current_exception() );
+        throw;
+    }
+}
+
+TiledImageSource::Band TiledImageSource::loadBand( unsigned int mipLevel, unsigned int bandIndex, CUstream stream )
+{
+    const uint2        levelDims = getLevelDimensions( mipLevel );
+    const unsigned int firstRow  = bandIndex * m_bandHeight;
+    const unsigned int numRows   = std::min( m_bandHeight, levelDims.y - firstRow );
+    const size_t       rowPitch  = static_cast<size_t>( levelDims.x ) * m_pixelSizeInBytes;
+    std::shared_ptr<std::vector<char>> band( std::make_shared<std::vector<char>>( numRows * rowPitch ) );
+
+    if( mipLevel < m_numBaseLevels )
+    {
+        if( !m_baseImage->readScanlines( band->data(), mipLevel, firstRow, numRows, stream ) )
+            throw std::runtime_error( "Base image failed to read scanlines" );
+        return band;
+    }
+
+    // Point sample the finer level, as MipMapImageSource does, from the bands that cover it.
+    const uint2  sourceDims     = getLevelDimensions( mipLevel - 1 );
+    const size_t sourceRowPitch = static_cast<size_t>( sourceDims.x ) * m_pixelSizeInBytes;
+    Band         sourceBand;
+    unsigned int sourceBandIndex = 0;
+    for( unsigned int y = 0; y < numRows; ++y )
+    {
+        const unsigned int sourceY = std::min( 2 * ( firstRow + y ), sourceDims.y - 1 );
+        if( !sourceBand || sourceY / m_bandHeight != sourceBandIndex )
+        {
+            sourceBandIndex = sourceY / m_bandHeight;
+            sourceBand      = getBand( mipLevel - 1, sourceBandIndex, stream );
+        }
+        const char* source = sourceBand->data() + ( sourceY - sourceBandIndex * m_bandHeight ) * sourceRowPitch;
+        char*       dest   = band->data() + y * rowPitch;
+        for( unsigned int x = 0; x < levelDims.x; ++x )
+        {
+            const unsigned int sourceX = std::min( 2 * x, sourceDims.x - 1 );
+            std::copy_n( source + sourceX * m_pixelSizeInBytes, m_pixelSizeInBytes, dest + x * m_pixelSizeInBytes );
+        }
+    }
+    return band;
+}
+
+void TiledImageSource::copyFromBands( char* dest, size_t destRowPitch, unsigned int mipLevel, PixelPosition start, uint2 size, CUstream stream )
+{
+    const size_t rowPitch       = static_cast<size_t>( getLevelDimensions( mipLevel ).x ) * m_pixelSizeInBytes;
+    const size_t rowSizeInBytes = static_cast<size_t>( size.x ) * m_pixelSizeInBytes;
+    for( unsigned int y = start.y; y < start.y + size.y; )
+    {
+        const unsigned int bandIndex = y / m_bandHeight;
+        const unsigned int bandEnd   = std::min( ( bandIndex + 1 ) * m_bandHeight, start.y + size.y );
+        const Band         band      = getBand( mipLevel, bandIndex, stream );
+        for( ; y < bandEnd; ++y )
+        {
+            const char* source = band->data() + ( y - bandIndex * m_bandHeight ) * rowPitch + start.x * m_pixelSizeInBytes;
+            std::copy_n( source, rowSizeInBytes, dest );
+            dest += destRowPitch;
+        }
+    }
+}
+
 bool TiledImageSource::readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
 {
     {
@@ -69,6 +217,19 @@ bool TiledImageSource::readTile( char* dest, unsigned int mipLevel, const Tile&
         }
     }
 
+    if( m_isStreaming )
+    {
+        const uint2         levelDims = getLevelDimensions( mipLevel );
+        const PixelPosition start     = pixelPosition( tile );
+        // Partial tile dimensions might be less than the nominal dimensions.
+        const uint2 size{ std::min( tile.width, levelDims.x - start.x ), std::min( tile.height, levelDims.y - start.y ) };
+        copyFromBands( dest, static_cast<size_t>( tile.width ) * m_pixelSizeInBytes, mipLevel, start, size, stream );
+
+        std::unique_lock<std::mutex> lock( m_dataMutex );
+        ++m_numTilesRead;
+        return true;
+    }
+
     const char* mipLevelBuffer;
     uint2 mipDimensions;
     {
@@ -130,6 +291,32 @@ bool TiledImageSource::readTile( char* dest, unsigned int mipLevel, const Tile&
     return true;
 }
 
+std::future<bool> TiledImageSource::readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream )
+{
+    {
+        std::unique_lock<std::mutex> lock( m_dataMutex );
+        if( m_baseIsTiled )
+        {
+            return WrappedImageSource::readTileAsync( dest, mipLevel, tile, stream );
+        }
+    }
+    // Tiles are copied from bands or mip levels of the base image.
+    return ImageSource::readTileAsync( dest, mipLevel, tile, stream );
+}
+
+bool TiledImageSource::readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream )
+{
+    if( !m_isStreaming )
+    {
+        return WrappedImageSource::readMipLevel( dest, mipLevel, expectedWidth, expectedHeight, stream );
+    }
+
+    const uint2 levelDims = getLevelDimensions( mipLevel );
+    OTK_ASSERT( levelDims.x == expectedWidth && levelDims.y == expectedHeight );
+    copyFromBands( dest, static_cast<size_t>( levelDims.x ) * m_pixelSizeInBytes, mipLevel, PixelPosition{ 0, 0 }, levelDims, stream );
+    return true;
+}
+
 bool TiledImageSource::readMipTail( char*        dest,
                                     unsigned int mipTailFirstLevel,
                                     unsigned int numMipLevels,
@@ -145,12 +332,13 @@ bool TiledImageSource::readMipTail( char*        dest,
         }
     }
 
-    size_t offset = 0;
+    const TextureInfo& info   = getInfo();
+    size_t             offset = 0;
     for( unsigned int mipLevel = mipTailFirstLevel; mipLevel < numMipLevels; ++mipLevel )
     {
         const uint2 levelDims = mipLevelDims[mipLevel];
         readMipLevel( dest + offset, mipLevel, levelDims.x, levelDims.y, stream );
-        offset += static_cast<size_t>( levelDims.x * levelDims.y * pixelSizeInBytes );
+        offset += getImageSizeInBytes( info.format, info.numChannels, levelDims.x, levelDims.y );
     }
 
     return true;
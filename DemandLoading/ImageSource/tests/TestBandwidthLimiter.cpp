@@ -0,0 +1,279 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/BandwidthLimiter.h>
+#include <OptiXToolkit/ImageSource/CheckerBoardImage.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+#include <OptiXToolkit/ImageSource/ThrottledImageSource.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+// A clock that only advances when told to.  Waiting threads poll it.
+class FakeClock : public BandwidthLimiter::Clock
+{
+  public:
+    double now() const override
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        return m_time;
+    }
+
+    void waitFor( std::condition_variable& cond, std::unique_lock<std::mutex>& lock, double /*seconds*/ ) override
+    {
+        cond.wait_for( lock, std::chrono::milliseconds( 1 ) );
+    }
+
+    void advance( double seconds )
+    {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_time += seconds;
+    }
+
+  private:
+    mutable std::mutex m_mutex;
+    double             m_time = 0.0;
+};
+
+// Wait (in real time) for a condition that other threads will establish.
+bool eventually( const std::function<bool()>& condition )
+{
+    for( int i = 0; i < 5000; ++i )
+    {
+        if( condition() )
+            return true;
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    return false;
+}
+
+class TestBandwidthLimiter : public testing::Test
+{
+  protected:
+    std::shared_ptr<FakeClock> m_clock{ std::make_shared<FakeClock>() };
+
+    BandwidthLimits limits( double bytesPerSecond, double opsPerSecond, double burstSeconds )
+    {
+        BandwidthLimits result;
+        result.bytesPerSecond = bytesPerSecond;
+        result.opsPerSecond   = opsPerSecond;
+        result.burstSeconds   = burstSeconds;
+        return result;
+    }
+};
+
+// A checkerboard that reports reading a fixed number of bytes per read, as a compressed file would.
+class CompressedImage : public CheckerBoardImage
+{
+  public:
+    explicit CompressedImage( unsigned long long bytesPerRead )
+        : CheckerBoardImage( 256, 256, /*squaresPerSide=*/4 )
+        , m_bytesPerRead( bytesPerRead )
+    {
+    }
+
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override
+    {
+        m_numBytesRead += m_bytesPerRead;
+        return CheckerBoardImage::readTile( dest, mipLevel, tile, stream );
+    }
+
+    unsigned long long getNumBytesRead() const override { return m_numBytesRead; }
+
+  private:
+    unsigned long long              m_bytesPerRead;
+    std::atomic<unsigned long long> m_numBytesRead{ 0 };
+};
+
+// Clients are identified by address.
+const int CLIENT_A = 1;
+const int CLIENT_B = 2;
+const int CLIENT_C = 3;
+
+}  // namespace
+
+TEST_F( TestBandwidthLimiter, unlimitedNeverBlocks )
+{
+    BandwidthLimiter limiter( BandwidthLimits(), m_clock );
+    for( int i = 0; i < 100; ++i )
+        limiter.acquire( &CLIENT_A, IO_PRIORITY_TILE, 1 << 20 );
+
+    EXPECT_EQ( 100ULL << 20, limiter.getNumBytesGranted() );
+    EXPECT_EQ( 100ULL, limiter.getNumOpsGranted() );
+    EXPECT_EQ( 0.0, limiter.getTotalWaitTime() );
+}
+
+TEST_F( TestBandwidthLimiter, limitsBandwidthAfterBurst )
+{
+    BandwidthLimiter limiter( limits( 1000.0, 0.0, 1.0 ), m_clock );
+
+    // The initial burst is granted immediately.
+    limiter.acquire( &CLIENT_A, IO_PRIORITY_TILE, 1000 );
+    EXPECT_EQ( 0.0, limiter.getTotalWaitTime() );
+
+    std::thread reader( [&] { limiter.acquire( &CLIENT_A, IO_PRIORITY_TILE, 500 ); } );
+    ASSERT_TRUE( eventually( [&] { return limiter.getNumWaiting() == 1; } ) );
+    m_clock->advance( 0.4 );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    EXPECT_EQ( 1U, limiter.getNumWaiting() );
+
+    m_clock->advance( 0.1 );
+    reader.join();
+    EXPECT_EQ( 1500ULL, limiter.getNumBytesGranted() );
+    EXPECT_DOUBLE_EQ( 0.5, limiter.getTotalWaitTime() );
+}
+
+TEST_F( TestBandwidthLimiter, limitsOperations )
+{
+    // Ten operations per second, with a bucket of a single operation.
+    BandwidthLimiter limiter( limits( 0.0, 10.0, 0.1 ), m_clock );
+    limiter.acquire( &CLIENT_A, IO_PRIORITY_TILE, 16 );
+
+    std::thread reader( [&] { limiter.acquire( &CLIENT_A, IO_PRIORITY_TILE, 16 ); } );
+    ASSERT_TRUE( eventually( [&] { return limiter.getNumWaiting() == 1; } ) );
+    m_clock->advance( 0.05 );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    EXPECT_EQ( 1ULL, limiter.getNumOpsGranted() );
+
+    m_clock->advance( 0.05 );
+    reader.join();
+    EXPECT_EQ( 2ULL, limiter.getNumOpsGranted() );
+}
+
+TEST_F( TestBandwidthLimiter, largeReadsGoIntoDebt )
+{
+    BandwidthLimiter limiter( limits( 100.0, 0.0, 1.0 ), m_clock );
+
+    // A read larger than the bucket is granted from a full bucket, and later reads repay the debt.
+    limiter.acquire( &CLIENT_A, IO_PRIORITY_TILE, 300 );
+    std::thread reader( [&] { limiter.acquire( &CLIENT_A, IO_PRIORITY_TILE, 100 ); } );
+    ASSERT_TRUE( eventually( [&] { return limiter.getNumWaiting() == 1; } ) );
+    m_clock->advance( 2.5 );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+    EXPECT_EQ( 1U, limiter.getNumWaiting() );
+
+    m_clock->advance( 0.5 );
+    reader.join();
+    EXPECT_EQ( 400ULL, limiter.getNumBytesGranted() );
+}
+
+TEST_F( TestBandwidthLimiter, grantsByPriorityThenFairly )
+{
+    // One 100-byte read per second, with the bucket drained.
+    BandwidthLimiter limiter( limits( 100.0, 0.0, 1.0 ), m_clock );
+    limiter.acquire( &CLIENT_C, IO_PRIORITY_TILE, 100 );
+
+    // Client A asks for its tiles before client B; the mip tail arrives last.
+    std::mutex               mutex;
+    std::vector<std::string> order;
+    auto                     reader = [&]( const int* client, IOPriority priority, int numReads, const char* name ) {
+        for( int i = 0; i < numReads; ++i )
+        {
+            limiter.acquire( client, priority, 100 );
+            std::unique_lock<std::mutex> lock( mutex );
+            order.push_back( name );
+        }
+    };
+    std::thread readerA( reader, &CLIENT_A, IO_PRIORITY_TILE, 3, "A" );
+    ASSERT_TRUE( eventually( [&] { return limiter.getNumWaiting() == 1; } ) );
+    std::thread readerB( reader, &CLIENT_B, IO_PRIORITY_TILE, 3, "B" );
+    ASSERT_TRUE( eventually( [&] { return limiter.getNumWaiting() == 2; } ) );
+    std::thread readerTail( reader, &CLIENT_C, IO_PRIORITY_MIP_TAIL, 1, "T" );
+    ASSERT_TRUE( eventually( [&] { return limiter.getNumWaiting() == 3; } ) );
+
+    // Advance one read at a time, letting the granted reader enqueue its next read.
+    const unsigned int numWaiting[] = { 2, 2, 2, 2, 2, 1 };
+    for( unsigned int i = 0; i < 6; ++i )
+    {
+        m_clock->advance( 1.0 );
+        ASSERT_TRUE( eventually( [&] {
+            std::unique_lock<std::mutex> lock( mutex );
+            return order.size() == i + 1;
+        } ) );
+        ASSERT_TRUE( eventually( [&] { return limiter.getNumWaiting() == numWaiting[i]; } ) );
+    }
+    m_clock->advance( 1.0 );
+    readerA.join();
+    readerB.join();
+    readerTail.join();
+
+    const std::vector<std::string> expected{ "T", "A", "B", "A", "B", "A", "B" };
+    EXPECT_EQ( expected, order );
+}
+
+TEST_F( TestBandwidthLimiter, sharesLimitersByDevice )
+{
+    std::shared_ptr<BandwidthLimiter> limiter = BandwidthLimiter::getDeviceLimiter( "." );
+    EXPECT_EQ( limiter, BandwidthLimiter::getDeviceLimiter( "./" ) );
+    EXPECT_EQ( 0.0, limiter->getLimits().bytesPerSecond );
+}
+
+TEST_F( TestBandwidthLimiter, throttlesImageReads )
+{
+    std::shared_ptr<BandwidthLimiter> limiter( new BandwidthLimiter( BandwidthLimits(), m_clock ) );
+    std::shared_ptr<ImageSource>      checkerboard( new CheckerBoardImage( 256, 256, /*squaresPerSide=*/4 ) );
+    ThrottledImageSource              image( checkerboard, limiter );
+    TextureInfo                       info;
+    image.open( &info );
+
+    std::vector<char> buffer( getTextureSizeInBytes( info ) );
+    EXPECT_TRUE( image.readTile( buffer.data(), 0, Tile{ 0, 0, 64, 64 }, nullptr ) );
+    EXPECT_EQ( getImageSizeInBytes( info.format, info.numChannels, 64, 64 ), limiter->getNumBytesGranted() );
+
+    std::vector<uint2> levelDims;
+    size_t             tailSize = 0;
+    for( unsigned int level = 0; level < info.numMipLevels; ++level )
+    {
+        levelDims.push_back( uint2{ 256U >> level, 256U >> level } );
+        if( level >= 4 )
+            tailSize += getImageSizeInBytes( info.format, info.numChannels, levelDims.back().x, levelDims.back().y );
+    }
+    EXPECT_TRUE( image.readMipTail( buffer.data(), 4, info.numMipLevels, levelDims.data(), 16, nullptr ) );
+    EXPECT_EQ( 2ULL, limiter->getNumOpsGranted() );
+    EXPECT_EQ( getImageSizeInBytes( info.format, info.numChannels, 64, 64 ) + tailSize, limiter->getNumBytesGranted() );
+
+    // Images without a file are not throttled by default.
+    EXPECT_EQ( nullptr, ThrottledImageSource( checkerboard ).getLimiter() );
+}
+
+TEST_F( TestBandwidthLimiter, refundedBytesAreAvailableImmediately )
+{
+    BandwidthLimiter limiter( limits( 1000.0, 0.0, 1.0 ), m_clock );
+    limiter.acquire( &CLIENT_A, IO_PRIORITY_TILE, 1000 );
+    limiter.charge( -600 );
+    EXPECT_EQ( 400ULL, limiter.getNumBytesGranted() );
+
+    limiter.acquire( &CLIENT_A, IO_PRIORITY_TILE, 600 );
+    EXPECT_EQ( 1000ULL, limiter.getNumBytesGranted() );
+    EXPECT_EQ( 0.0, limiter.getTotalWaitTime() );
+}
+
+TEST_F( TestBandwidthLimiter, chargesBytesReadFromStorage )
+{
+    std::shared_ptr<BandwidthLimiter> limiter( new BandwidthLimiter( BandwidthLimits(), m_clock ) );
+    ThrottledImageSource              image( std::make_shared<CompressedImage>( 100 ), limiter );
+    TextureInfo                       info;
+    image.open( &info );
+
+    // The first read is estimated at its decoded size and corrected once the bytes read are known.
+    std::vector<char> buffer( getImageSizeInBytes( info.format, info.numChannels, 64, 64 ) );
+    EXPECT_TRUE( image.readTile( buffer.data(), 0, Tile{ 0, 0, 64, 64 }, nullptr ) );
+    EXPECT_EQ( 100ULL, limiter->getNumBytesGranted() );
+
+    // Later reads are estimated from the compression ratio so far.
+    EXPECT_TRUE( image.readTile( buffer.data(), 0, Tile{ 1, 0, 64, 64 }, nullptr ) );
+    EXPECT_EQ( 200ULL, limiter->getNumBytesGranted() );
+    EXPECT_EQ( 2ULL, limiter->getNumOpsGranted() );
+}
@@ -0,0 +1,82 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "Blake2b.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+std::string toHex( const std::vector<unsigned char>& digest )
+{
+    std::string hex;
+    for( unsigned char byte : digest )
+    {
+        char buffer[3];
+        std::snprintf( buffer, sizeof( buffer ), "%02x", byte );
+        hex += buffer;
+    }
+    return hex;
+}
+
+std::string hashHex( const std::vector<unsigned char>& message, unsigned int digestSize, size_t chunkSize )
+{
+    Blake2b hasher( digestSize );
+    for( size_t begin = 0; begin < message.size(); begin += chunkSize )
+        hasher.update( message.data() + begin, std::min( chunkSize, message.size() - begin ) );
+    std::vector<unsigned char> digest( digestSize );
+    hasher.finish( digest.data() );
+    return toHex( digest );
+}
+
+std::vector<unsigned char> makeMessage( size_t size )
+{
+    std::vector<unsigned char> message( size );
+    for( size_t i = 0; i < size; ++i )
+        message[i] = static_cast<unsigned char>( i % 251 );
+    return message;
+}
+
+}  // namespace
+
+// RFC 7693, Appendix A.
+TEST( TestBlake2b, matchesRfc7693Example )
+{
+    const std::vector<unsigned char> abc{ 'a', 'b', 'c' };
+    EXPECT_EQ(
+        "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d1"
+        "7d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923",
+        hashHex( abc, 64, 1 ) );
+}
+
+// The remaining digests are those of the BLAKE2 reference implementation.
+TEST( TestBlake2b, hashesEmptyMessage )
+{
+    EXPECT_EQ(
+        "786a02f742015903c6c6fd852552d272912f4740e15847618a86e217f71f5419"
+        "d25e1031afee585313896444934eb04b903a685b1448b755d56f701afe9be2ce",
+        hashHex( std::vector<unsigned char>(), 64, 1 ) );
+}
+
+TEST( TestBlake2b, hashesExactlyOneBlock )
+{
+    std::vector<unsigned char> block( Blake2b::BLOCK_SIZE );
+    for( unsigned int i = 0; i < Blake2b::BLOCK_SIZE; ++i )
+        block[i] = static_cast<unsigned char>( i );
+    EXPECT_EQ( "a74787004ef589e31149183900d0294a", hashHex( block, 16, Blake2b::BLOCK_SIZE ) );
+}
+
+TEST( TestBlake2b, digestDoesNotDependOnUpdateSizes )
+{
+    const std::vector<unsigned char> message = makeMessage( 1000 );
+    for( size_t chunkSize : { 1, 7, 128, 129, 1000 } )
+        EXPECT_EQ( "bca120dfd89cd95d82898473a5b01c90", hashHex( message, 16, chunkSize ) ) << chunkSize;
+}
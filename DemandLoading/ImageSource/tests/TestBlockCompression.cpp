@@ -0,0 +1,395 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/BlockCompression.h>
+#include <OptiXToolkit/ImageSource/CompressingImageSource.h>
+#include <OptiXToolkit/ImageSource/ConvertingImageSource.h>
+#include <OptiXToolkit/ImageSource/ImageSource.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+// Synthetic image with smooth gradients and hard edges, in float or 8-bit channels.  The HDR
+// variant spans several orders of magnitude.
+class GradientImage : public ImageSourceBase
+{
+  public:
+    GradientImage( unsigned int width, unsigned int height, CUarray_format format, unsigned int numChannels, bool hdr = false )
+        : m_hdr( hdr )
+    {
+        m_info.width        = width;
+        m_info.height       = height;
+        m_info.format       = format;
+        m_info.numChannels  = numChannels;
+        m_info.numMipLevels = calculateNumMipLevels( width, height );
+        m_info.isValid      = true;
+        m_info.isTiled      = true;
+    }
+
+    void open( TextureInfo* info ) override
+    {
+        if( info != nullptr )
+            *info = m_info;
+    }
+    void               close() override {}
+    bool               isOpen() const override { return true; }
+    const TextureInfo& getInfo() const override { return m_info; }
+    CUmemorytype       getFillType() const override { return CU_MEMORYTYPE_HOST; }
+    bool               readBaseColor( float4& /*dest*/ ) override { return false; }
+
+    bool readTile( char* dest, unsigned int mipLevel, const Tile& tile, CUstream /*stream*/ ) override
+    {
+        const PixelPosition start = pixelPosition( tile );
+        fill( dest, mipLevel, start.x, start.y, tile.width, tile.height );
+        return true;
+    }
+
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int width, unsigned int height, CUstream /*stream*/ ) override
+    {
+        fill( dest, mipLevel, 0, 0, width, height );
+        return true;
+    }
+
+    float4 texel( unsigned int mipLevel, unsigned int x, unsigned int y ) const
+    {
+        const float u = ( x + 0.5f ) / std::max( 1U, m_info.width >> mipLevel );
+        const float v = ( y + 0.5f ) / std::max( 1U, m_info.height >> mipLevel );
+        float4      result{ 0.5f + 0.5f * std::sin( 18.f * u ), v, ( static_cast<int>( u * 8 ) + static_cast<int>( v * 8 ) ) & 1 ? 0.9f : 0.1f,
+                       1.f - 0.5f * u };
+        if( m_hdr )
+        {
+            const float scale = std::exp2( 12.f * u - 4.f );
+            result.x *= scale;
+            result.y *= scale;
+            result.z *= scale;
+        }
+        return result;
+    }
+
+  private:
+    void fill( char* dest, unsigned int mipLevel, unsigned int startX, unsigned int startY, unsigned int width, unsigned int height ) const
+    {
+        for( unsigned int y = 0; y < height; ++y )
+        {
+            for( unsigned int x = 0; x < width; ++x )
+            {
+                const float4 value    = texel( mipLevel, startX + x, startY + y );
+                const float  rgba[4]  = { value.x, value.y, value.z, value.w };
+                const size_t pixel    = static_cast<size_t>( y ) * width + x;
+                for( unsigned int c = 0; c < m_info.numChannels; ++c )
+                {
+                    if( m_info.format == CU_AD_FORMAT_FLOAT )
+                        reinterpret_cast<float*>( dest )[pixel * m_info.numChannels + c] = rgba[c];
+                    else
+                        reinterpret_cast<std::uint8_t*>( dest )[pixel * m_info.numChannels + c] =
+                            static_cast<std::uint8_t>( std::min( std::max( rgba[c], 0.f ), 1.f ) * 255.f + 0.5f );
+                }
+            }
+        }
+    }
+
+    TextureInfo m_info{};
+    bool        m_hdr;
+};
+
+std::vector<float4> readLevel( GradientImage& image, unsigned int mipLevel, unsigned int width, unsigned int height )
+{
+    std::vector<float4> texels( static_cast<size_t>( width ) * height );
+    for( unsigned int y = 0; y < height; ++y )
+        for( unsigned int x = 0; x < width; ++x )
+            texels[y * width + x] = image.texel( mipLevel, x, y );
+    return texels;
+}
+
+// Decompress rows of blocks into an image of the given dimensions.
+std::vector<float4> decompressImage( CUarray_format format, const std::vector<char>& blocks, unsigned int width, unsigned int height )
+{
+    const unsigned int  widthInBlocks = ( width + 3 ) / 4;
+    const unsigned int  blockSize     = getBytesPerBlock( format, 0 );
+    std::vector<float4> texels( static_cast<size_t>( width ) * height );
+    float4              blockTexels[16];
+    for( unsigned int by = 0; by < ( height + 3 ) / 4; ++by )
+    {
+        for( unsigned int bx = 0; bx < widthInBlocks; ++bx )
+        {
+            EXPECT_TRUE( decompressBlock( format, &blocks[( by * widthInBlocks + bx ) * blockSize], blockTexels ) );
+            for( unsigned int j = 0; j < 4 && by * 4 + j < height; ++j )
+                for( unsigned int i = 0; i < 4 && bx * 4 + i < width; ++i )
+                    texels[( by * 4 + j ) * width + bx * 4 + i] = blockTexels[j * 4 + i];
+        }
+    }
+    return texels;
+}
+
+// Peak signal to noise ratio over the given number of channels.  HDR values are tone mapped.
+double computePSNR( const std::vector<float4>& expected, const std::vector<float4>& actual, unsigned int numChannels, bool hdr )
+{
+    double sumSquaredError = 0.0;
+    for( size_t i = 0; i < expected.size(); ++i )
+    {
+        const float* a = reinterpret_cast<const float*>( &expected[i] );
+        const float* b = reinterpret_cast<const float*>( &actual[i] );
+        for( unsigned int c = 0; c < numChannels; ++c )
+        {
+            float x = std::min( std::max( a[c], 0.f ), hdr ? 65504.f : 1.f );
+            float y = b[c];
+            if( hdr )
+            {
+                x = x / ( 1.f + x );
+                y = y / ( 1.f + y );
+            }
+            sumSquaredError += ( x - y ) * ( x - y );
+        }
+    }
+    const double mse = sumSquaredError / ( expected.size() * numChannels );
+    return mse > 0.0 ? 10.0 * std::log10( 1.0 / mse ) : 100.0;
+}
+
+struct FormatQuality
+{
+    CUarray_format format;
+    unsigned int   numChannels;
+    bool           hdr;
+    double         minPSNR;
+};
+
+double measurePSNR( const FormatQuality& quality, unsigned int size )
+{
+    GradientImage             image( size, size, CU_AD_FORMAT_FLOAT, 4, quality.hdr );
+    const std::vector<float4> texels = readLevel( image, 0, size, size );
+    std::vector<char>         blocks( getImageSizeInBytes( quality.format, 0, size, size ) );
+    compressImage( quality.format, texels.data(), size, size, blocks.data() );
+    return computePSNR( texels, decompressImage( quality.format, blocks, size, size ), quality.numChannels, quality.hdr );
+}
+
+const FormatQuality FORMAT_QUALITIES[] = {
+    { CU_AD_FORMAT_BC1_UNORM, 3, false, 30.0 },   //
+    { CU_AD_FORMAT_BC4_UNORM, 1, false, 40.0 },   //
+    { CU_AD_FORMAT_BC5_UNORM, 2, false, 40.0 },   //
+    { CU_AD_FORMAT_BC6H_UF16, 3, true, 35.0 },    //
+    { CU_AD_FORMAT_BC7_UNORM, 4, false, 35.0 },   //
+};
+
+}  // namespace
+
+TEST( TestBlockCompression, blockSizes )
+{
+    EXPECT_TRUE( isBlockCompressed( CU_AD_FORMAT_BC1_UNORM ) );
+    EXPECT_FALSE( isBlockCompressed( CU_AD_FORMAT_FLOAT ) );
+    EXPECT_EQ( 4U, getBlockDim( CU_AD_FORMAT_BC7_UNORM ) );
+    EXPECT_EQ( 1U, getBlockDim( CU_AD_FORMAT_HALF ) );
+    EXPECT_EQ( 8U, getBytesPerBlock( CU_AD_FORMAT_BC1_UNORM, 4 ) );
+    EXPECT_EQ( 16U, getBytesPerBlock( CU_AD_FORMAT_BC5_UNORM, 2 ) );
+    EXPECT_EQ( 8U, getBytesPerBlock( CU_AD_FORMAT_HALF, 4 ) );
+    EXPECT_EQ( 2U, getNumChannelsInBlockFormat( CU_AD_FORMAT_BC5_UNORM ) );
+    EXPECT_EQ( 0U, getNumChannelsInBlockFormat( CU_AD_FORMAT_UNSIGNED_INT8 ) );
+
+    // Partial blocks occupy whole blocks.
+    EXPECT_EQ( 4U * 8U, getImageSizeInBytes( CU_AD_FORMAT_BC1_UNORM, 4, 5, 5 ) );
+    EXPECT_EQ( 16U, getImageSizeInBytes( CU_AD_FORMAT_BC7_UNORM, 4, 1, 1 ) );
+    EXPECT_EQ( 5U * 5U * 4U, getImageSizeInBytes( CU_AD_FORMAT_UNSIGNED_INT8, 4, 5, 5 ) );
+
+    TextureInfo info{ 1024, 1024, CU_AD_FORMAT_BC1_UNORM, 4, 1, true, true };
+    EXPECT_EQ( 512U * 1024U, getTextureSizeInBytes( info ) );
+}
+
+TEST( TestBlockCompression, uniformBlocksAreNearlyExact )
+{
+    const float4 color{ 0.25f, 0.5f, 0.75f, 1.f };
+    float4       texels[16];
+    std::fill( texels, texels + 16, color );
+
+    for( const FormatQuality& quality : FORMAT_QUALITIES )
+    {
+        unsigned char block[16];
+        float4        decoded[16];
+        compressBlock( quality.format, texels, block );
+        ASSERT_TRUE( decompressBlock( quality.format, block, decoded ) );
+        const float* expected = reinterpret_cast<const float*>( &color );
+        for( const float4& texel : decoded )
+        {
+            const float* actual = reinterpret_cast<const float*>( &texel );
+            for( unsigned int c = 0; c < quality.numChannels; ++c )
+                EXPECT_NEAR( expected[c], actual[c], 1.f / 64.f ) << "format " << quality.format << " channel " << c;
+        }
+    }
+}
+
+TEST( TestBlockCompression, decodesThreeColorBC1Blocks )
+{
+    // color0 <= color1 selects three colors plus transparent black.
+    const unsigned char block[8] = { 0x00, 0x00, 0xff, 0xff, 0xe4, 0xe4, 0xe4, 0xe4 };
+    float4              texels[16];
+    ASSERT_TRUE( decompressBlock( CU_AD_FORMAT_BC1_UNORM, block, texels ) );
+    EXPECT_EQ( 0.f, texels[0].x );
+    EXPECT_EQ( 1.f, texels[1].x );
+    EXPECT_FLOAT_EQ( 0.5f, texels[2].x );
+    EXPECT_EQ( 0.f, texels[3].w );
+}
+
+TEST( TestBlockCompression, qualityOfGradients )
+{
+    for( const FormatQuality& quality : FORMAT_QUALITIES )
+        EXPECT_GT( measurePSNR( quality, 128 ), quality.minPSNR ) << "format " << quality.format;
+}
+
+TEST( TestBlockCompression, compressesPartialBlocks )
+{
+    // Partial blocks are padded by replicating the last row and column.
+    GradientImage             image( 6, 3, CU_AD_FORMAT_FLOAT, 4 );
+    const std::vector<float4> texels = readLevel( image, 0, 6, 3 );
+    std::vector<float4>       padded( 8 * 4 );
+    for( unsigned int y = 0; y < 4; ++y )
+        for( unsigned int x = 0; x < 8; ++x )
+            padded[y * 8 + x] = texels[std::min( y, 2U ) * 6 + std::min( x, 5U )];
+
+    std::vector<char> expected( getImageSizeInBytes( CU_AD_FORMAT_BC7_UNORM, 4, 8, 4 ) );
+    std::vector<char> actual( getImageSizeInBytes( CU_AD_FORMAT_BC7_UNORM, 4, 6, 3 ) );
+    ASSERT_EQ( expected.size(), actual.size() );
+    compressImage( CU_AD_FORMAT_BC7_UNORM, padded.data(), 8, 4, expected.data() );
+    compressImage( CU_AD_FORMAT_BC7_UNORM, texels.data(), 6, 3, actual.data() );
+    EXPECT_EQ( expected, actual );
+}
+
+TEST( TestCompressingImageSource, choosesFormat )
+{
+    TextureInfo info{ 64, 64, CU_AD_FORMAT_UNSIGNED_INT8, 4, 1, true, true };
+    EXPECT_EQ( CU_AD_FORMAT_BC7_UNORM, chooseBlockCompressedFormat( info ) );
+    info.numChannels = 1;
+    EXPECT_EQ( CU_AD_FORMAT_BC4_UNORM, chooseBlockCompressedFormat( info ) );
+    info.numChannels = 2;
+    EXPECT_EQ( CU_AD_FORMAT_BC5_UNORM, chooseBlockCompressedFormat( info ) );
+    info.numChannels = 3;
+    info.format      = CU_AD_FORMAT_HALF;
+    EXPECT_EQ( CU_AD_FORMAT_BC6H_UF16, chooseBlockCompressedFormat( info ) );
+    info.format = CU_AD_FORMAT_BC1_UNORM;
+    EXPECT_EQ( CU_AD_FORMAT_BC1_UNORM, chooseBlockCompressedFormat( info ) );
+}
+
+TEST( TestCompressingImageSource, describesCompressedImage )
+{
+    auto                   source = std::make_shared<GradientImage>( 256, 128, CU_AD_FORMAT_UNSIGNED_INT8, 2 );
+    CompressingImageSource image( source, CU_AD_FORMAT_BC5_UNORM );
+    TextureInfo            info;
+    image.open( &info );
+
+    EXPECT_TRUE( image.isCompressing() );
+    EXPECT_EQ( CU_AD_FORMAT_BC5_UNORM, info.format );
+    EXPECT_EQ( 2U, info.numChannels );
+    EXPECT_EQ( 256U, info.width );
+    EXPECT_EQ( source->getInfo().numMipLevels, info.numMipLevels );
+    EXPECT_EQ( info, image.getInfo() );
+}
+
+TEST( TestCompressingImageSource, readTileCompressesSourceTile )
+{
+    auto                   source = std::make_shared<GradientImage>( 256, 256, CU_AD_FORMAT_UNSIGNED_INT8, 4 );
+    CompressingImageSource image( source, CU_AD_FORMAT_BC1_UNORM );
+    image.open( nullptr );
+
+    const Tile        tile{ 1, 2, 64, 32 };
+    std::vector<char> actual( getImageSizeInBytes( CU_AD_FORMAT_BC1_UNORM, 4, tile.width, tile.height ) );
+    ASSERT_TRUE( image.readTile( actual.data(), 1, tile, CUstream{} ) );
+
+    // Compress the same texels directly.
+    std::vector<std::uint8_t> pixels( tile.width * tile.height * 4 );
+    source->readTile( reinterpret_cast<char*>( pixels.data() ), 1, tile, CUstream{} );
+    std::vector<float4> texels( tile.width * tile.height );
+    for( size_t i = 0; i < texels.size(); ++i )
+        texels[i] = float4{ pixels[i * 4] / 255.f, pixels[i * 4 + 1] / 255.f, pixels[i * 4 + 2] / 255.f, pixels[i * 4 + 3] / 255.f };
+    std::vector<char> expected( actual.size() );
+    compressImage( CU_AD_FORMAT_BC1_UNORM, texels.data(), tile.width, tile.height, expected.data() );
+
+    EXPECT_EQ( expected, actual );
+}
+
+TEST( TestCompressingImageSource, compressesConvertedImage )
+{
+    // Both adapters read the source into per-thread scratch buffers, which must be distinct.
+    OutputFormat unorm8;
+    unorm8.format = CU_AD_FORMAT_UNSIGNED_INT8;
+    auto converted = std::make_shared<ConvertingImageSource>( std::make_shared<GradientImage>( 64, 64, CU_AD_FORMAT_FLOAT, 4 ), unorm8 );
+    CompressingImageSource image( converted, CU_AD_FORMAT_BC7_UNORM );
+    CompressingImageSource direct( std::make_shared<GradientImage>( 64, 64, CU_AD_FORMAT_UNSIGNED_INT8, 4 ), CU_AD_FORMAT_BC7_UNORM );
+    image.open( nullptr );
+    direct.open( nullptr );
+
+    const Tile        tile{ 0, 0, 64, 64 };
+    std::vector<char> actual( getImageSizeInBytes( CU_AD_FORMAT_BC7_UNORM, 4, tile.width, tile.height ) );
+    std::vector<char> expected( actual.size() );
+    ASSERT_TRUE( image.readTile( actual.data(), 0, tile, CUstream{} ) );
+    ASSERT_TRUE( direct.readTile( expected.data(), 0, tile, CUstream{} ) );
+
+    EXPECT_EQ( expected, actual );
+}
+
+TEST( TestCompressingImageSource, readMipTailPacksBlocks )
+{
+    auto                   source = std::make_shared<GradientImage>( 16, 16, CU_AD_FORMAT_FLOAT, 4 );
+    CompressingImageSource image( source, CU_AD_FORMAT_BC7_UNORM );
+    TextureInfo            info;
+    image.open( &info );
+    ASSERT_EQ( 5U, info.numMipLevels );
+
+    // Levels 16, 8, 4, 2, 1 occupy 16, 4, 1, 1 and 1 blocks.
+    std::vector<uint2> levelDims;
+    for( unsigned int level = 0; level < info.numMipLevels; ++level )
+        levelDims.push_back( uint2{ 16U >> level, 16U >> level } );
+    std::vector<char> tail( 23 * 16, 0 );
+    ASSERT_TRUE( image.readMipTail( tail.data(), 0, info.numMipLevels, levelDims.data(), 0, CUstream{} ) );
+
+    std::vector<char> level1( 4 * 16 );
+    ASSERT_TRUE( image.readMipLevel( level1.data(), 1, 8, 8, CUstream{} ) );
+    EXPECT_TRUE( std::equal( level1.begin(), level1.end(), tail.begin() + 16 * 16 ) );
+
+    std::vector<char> level4( 16 );
+    ASSERT_TRUE( image.readMipLevel( level4.data(), 4, 1, 1, CUstream{} ) );
+    EXPECT_TRUE( std::equal( level4.begin(), level4.end(), tail.begin() + 22 * 16 ) );
+}
+
+TEST( TestCompressingImageSource, passesThroughCompressedImages )
+{
+    auto                   source = std::make_shared<GradientImage>( 64, 64, CU_AD_FORMAT_BC4_UNORM, 1 );
+    CompressingImageSource image( source, CU_AD_FORMAT_BC7_UNORM );
+    TextureInfo            info;
+    image.open( &info );
+
+    EXPECT_FALSE( image.isCompressing() );
+    EXPECT_EQ( CU_AD_FORMAT_BC4_UNORM, info.format );
+    EXPECT_EQ( 1U, info.numChannels );
+}
+
+// Benchmark of encoder throughput and quality.  Run with --gtest_also_run_disabled_tests.
+TEST( TestBlockCompression, DISABLED_benchmarkEncoders )
+{
+    const unsigned int        size = 2048;
+    GradientImage             ldrImage( size, size, CU_AD_FORMAT_FLOAT, 4, false );
+    GradientImage             hdrImage( size, size, CU_AD_FORMAT_FLOAT, 4, true );
+    const std::vector<float4> ldrTexels = readLevel( ldrImage, 0, size, size );
+    const std::vector<float4> hdrTexels = readLevel( hdrImage, 0, size, size );
+
+    for( const FormatQuality& quality : FORMAT_QUALITIES )
+    {
+        const std::vector<float4>& texels = quality.hdr ? hdrTexels : ldrTexels;
+        std::vector<char>          blocks( getImageSizeInBytes( quality.format, 0, size, size ) );
+        const auto                 start = std::chrono::steady_clock::now();
+        compressImage( quality.format, texels.data(), size, size, blocks.data() );
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        const double psnr = computePSNR( texels, decompressImage( quality.format, blocks, size, size ), quality.numChannels, quality.hdr );
+        std::cout << "format 0x" << std::hex << quality.format << std::dec << ": " << size * size / seconds / 1.0e6
+                  << " Mtexels/s per thread, PSNR " << psnr << " dB\n";
+    }
+}
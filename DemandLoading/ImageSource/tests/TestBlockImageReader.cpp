@@ -0,0 +1,595 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/BlockCompression.h>
+#include <OptiXToolkit/ImageSource/DDSReader.h>
+#include <OptiXToolkit/ImageSource/KTXReader.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include "Config.h"  // for OTK_USE_ZSTD
+
+#include <gtest/gtest.h>
+
+#if OTK_USE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+// Contents of a generated image file.  Every byte of each mip level is distinct enough that
+// misplaced blocks are detected.
+struct ImageData
+{
+    CUarray_format                 format;
+    unsigned int                   numChannels;
+    unsigned int                   width;
+    unsigned int                   height;
+    std::vector<std::vector<char>> levels;
+
+    ImageData( CUarray_format format_, unsigned int numChannels_, unsigned int width_, unsigned int height_, unsigned int numLevels )
+        : format( format_ )
+        , numChannels( numChannels_ )
+        , width( width_ )
+        , height( height_ )
+    {
+        for( unsigned int level = 0; level < numLevels; ++level )
+        {
+            std::vector<char> bytes( getImageSizeInBytes( format, numChannels, levelWidth( level ), levelHeight( level ) ) );
+            for( size_t i = 0; i < bytes.size(); ++i )
+                bytes[i] = static_cast<char>( level * 67 + i * 13 + i / 251 );
+            levels.push_back( bytes );
+        }
+    }
+
+    unsigned int levelWidth( unsigned int level ) const { return std::max( 1U, width >> level ); }
+    unsigned int levelHeight( unsigned int level ) const { return std::max( 1U, height >> level ); }
+
+    // Extract a tile in the layout produced by readTile, with zeros outside the level.
+    std::vector<char> tile( unsigned int level, const Tile& tile ) const
+    {
+        const unsigned int blockDim     = getBlockDim( format );
+        const unsigned int blockSize    = getBytesPerBlock( format, numChannels );
+        const unsigned int levelBlocksX = ( levelWidth( level ) + blockDim - 1 ) / blockDim;
+        const unsigned int levelBlocksY = ( levelHeight( level ) + blockDim - 1 ) / blockDim;
+        const unsigned int tileBlocksX  = ( tile.width + blockDim - 1 ) / blockDim;
+        const unsigned int tileBlocksY  = ( tile.height + blockDim - 1 ) / blockDim;
+
+        std::vector<char> result( tileBlocksX * tileBlocksY * blockSize, 0 );
+        for( unsigned int y = 0; y < tileBlocksY; ++y )
+        {
+            for( unsigned int x = 0; x < tileBlocksX; ++x )
+            {
+                const unsigned int srcX = tile.x * tile.width / blockDim + x;
+                const unsigned int srcY = tile.y * tile.height / blockDim + y;
+                if( srcX < levelBlocksX && srcY < levelBlocksY )
+                    std::copy_n( &levels[level][( srcY * levelBlocksX + srcX ) * blockSize], blockSize,
+                                 &result[( y * tileBlocksX + x ) * blockSize] );
+            }
+        }
+        return result;
+    }
+};
+
+void putU32( std::vector<char>& bytes, size_t offset, std::uint32_t value )
+{
+    for( int i = 0; i < 4; ++i )
+        bytes[offset + i] = static_cast<char>( value >> ( 8 * i ) );
+}
+
+void putU64( std::vector<char>& bytes, size_t offset, std::uint64_t value )
+{
+    putU32( bytes, offset, static_cast<std::uint32_t>( value ) );
+    putU32( bytes, offset + 4, static_cast<std::uint32_t>( value >> 32 ) );
+}
+
+void writeFile( const std::string& filename, const std::vector<char>& bytes )
+{
+    std::ofstream file( filename, std::ios::binary );
+    file.write( bytes.data(), bytes.size() );
+}
+
+// Write a DDS file.  A non-zero dxgiFormat selects the DX10 header; otherwise the legacy FourCC is used.
+void writeDDS( const std::string& filename, const ImageData& image, std::uint32_t fourCC, std::uint32_t dxgiFormat = 0 )
+{
+    std::vector<char> bytes( dxgiFormat ? 148 : 128, 0 );
+    putU32( bytes, 0, 0x20534444 );  // "DDS "
+    putU32( bytes, 4, 124 );
+    putU32( bytes, 8, 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 );
+    putU32( bytes, 12, image.height );
+    putU32( bytes, 16, image.width );
+    putU32( bytes, 28, static_cast<std::uint32_t>( image.levels.size() ) );
+    putU32( bytes, 76, 32 );
+    putU32( bytes, 80, 0x4 );  // DDPF_FOURCC
+    putU32( bytes, 84, dxgiFormat ? 0x30315844 : fourCC );
+    putU32( bytes, 108, 0x1000 | 0x400000 | 0x8 );
+    if( dxgiFormat )
+    {
+        putU32( bytes, 128, dxgiFormat );
+        putU32( bytes, 132, 3 );  // TEXTURE2D
+        putU32( bytes, 140, 1 );
+    }
+    for( const std::vector<char>& level : image.levels )
+        bytes.insert( bytes.end(), level.begin(), level.end() );
+    writeFile( filename, bytes );
+}
+
+const std::uint32_t KTX_SUPERCOMPRESSION_ZSTD = 2;
+
+// Write a KTX2 file, storing the mip levels coarsest first, as the KTX2 specification recommends.
+// Levels are zstd compressed when requested (and supported); other supercompression schemes only
+// set the header field.
+void writeKTX( const std::string& filename, const ImageData& image, std::uint32_t vkFormat, std::uint32_t supercompression = 0 )
+{
+    const unsigned int  numLevels = static_cast<unsigned int>( image.levels.size() );
+    std::vector<char>   bytes( 80 + 24 * numLevels, 0 );
+    const unsigned char identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+    std::copy_n( identifier, 12, reinterpret_cast<unsigned char*>( bytes.data() ) );
+    putU32( bytes, 12, vkFormat );
+    putU32( bytes, 16, 1 );
+    putU32( bytes, 20, image.width );
+    putU32( bytes, 24, image.height );
+    putU32( bytes, 36, 1 );
+    putU32( bytes, 40, numLevels );
+    putU32( bytes, 44, supercompression );
+    for( unsigned int level = numLevels; level-- > 0; )
+    {
+        // Align each level to 16 bytes, which leaves gaps between small levels.
+        bytes.resize( ( bytes.size() + 15 ) & ~size_t( 15 ), 0 );
+        std::vector<char> data( image.levels[level] );
+#if OTK_USE_ZSTD
+        if( supercompression == KTX_SUPERCOMPRESSION_ZSTD )
+        {
+            data.resize( ZSTD_compressBound( image.levels[level].size() ) );
+            data.resize( ZSTD_compress( data.data(), data.size(), image.levels[level].data(), image.levels[level].size(), 3 ) );
+        }
+#endif
+        putU64( bytes, 80 + 24 * level, bytes.size() );
+        putU64( bytes, 80 + 24 * level + 8, data.size() );
+        putU64( bytes, 80 + 24 * level + 16, image.levels[level].size() );
+        bytes.insert( bytes.end(), data.begin(), data.end() );
+    }
+    writeFile( filename, bytes );
+}
+
+std::vector<char> readTile( ImageSource& reader, unsigned int level, const Tile& tile )
+{
+    const TextureInfo& info = reader.getInfo();
+    std::vector<char>  dest( getImageSizeInBytes( info.format, info.numChannels, tile.width, tile.height ), 0x55 );
+    EXPECT_TRUE( reader.readTile( dest.data(), level, tile, nullptr ) );
+    return dest;
+}
+
+const std::uint32_t FOURCC_DXT1     = 0x31545844;
+const std::uint32_t DXGI_RGBA8_SRGB = 29;
+const std::uint32_t DXGI_BC7        = 98;
+const std::uint32_t VK_RGBA8        = 37;
+const std::uint32_t VK_RGBA8_SRGB   = 43;
+const std::uint32_t VK_BC5          = 141;
+
+class TestBlockImageReader : public testing::Test
+{
+  public:
+    void TearDown() override
+    {
+        for( const std::string& filename : m_files )
+            std::remove( filename.c_str() );
+    }
+
+  protected:
+    std::string temporaryFile( const std::string& filename )
+    {
+        m_files.push_back( filename );
+        return filename;
+    }
+
+  private:
+    std::vector<std::string> m_files;
+};
+
+}  // namespace
+
+TEST_F( TestBlockImageReader, readsLegacyDDSHeader )
+{
+    const std::string filename = temporaryFile( "TestBlockImageReader-dxt1.dds" );
+    const ImageData   image( CU_AD_FORMAT_BC1_UNORM, 4, 128, 64, 8 );
+    writeDDS( filename, image, FOURCC_DXT1 );
+
+    DDSReader   reader( filename );
+    TextureInfo info{};
+    reader.open( &info );
+
+    EXPECT_TRUE( reader.isOpen() );
+    EXPECT_TRUE( info.isValid );
+    EXPECT_TRUE( info.isTiled );
+    EXPECT_EQ( 128U, info.width );
+    EXPECT_EQ( 64U, info.height );
+    EXPECT_EQ( CU_AD_FORMAT_BC1_UNORM, info.format );
+    EXPECT_EQ( 4U, info.numChannels );
+    EXPECT_EQ( 8U, info.numMipLevels );
+    EXPECT_EQ( filename, reader.getFilename() );
+}
+
+TEST_F( TestBlockImageReader, readsTilesWithoutDecoding )
+{
+    const std::string filename = temporaryFile( "TestBlockImageReader-bc7.dds" );
+    const ImageData   image( CU_AD_FORMAT_BC7_UNORM, 4, 256, 128, 9 );
+    writeDDS( filename, image, 0, DXGI_BC7 );
+
+    DDSReader reader( filename );
+    reader.open( nullptr );
+    EXPECT_EQ( CU_AD_FORMAT_BC7_UNORM, reader.getInfo().format );
+
+    for( unsigned int y = 0; y < 2; ++y )
+    {
+        for( unsigned int x = 0; x < 4; ++x )
+        {
+            const Tile tile{ x, y, 64, 64 };
+            EXPECT_EQ( image.tile( 0, tile ), readTile( reader, 0, tile ) );
+        }
+    }
+    EXPECT_EQ( 8ULL, reader.getNumTilesRead() );
+    EXPECT_EQ( 256ULL * 128, reader.getNumBytesRead() );
+}
+
+TEST_F( TestBlockImageReader, fillsPartialTilesWithZeros )
+{
+    const std::string filename = temporaryFile( "TestBlockImageReader-partial.dds" );
+    const ImageData   image( CU_AD_FORMAT_BC7_UNORM, 4, 100, 60, 7 );
+    writeDDS( filename, image, 0, DXGI_BC7 );
+
+    DDSReader reader( filename );
+    reader.open( nullptr );
+
+    // Tiles straddling the right and bottom edges, and a level smaller than a tile.
+    const Tile edgeTiles[] = { { 1, 0, 64, 64 }, { 0, 0, 64, 64 }, { 1, 1, 32, 32 } };
+    for( const Tile& tile : edgeTiles )
+        EXPECT_EQ( image.tile( 0, tile ), readTile( reader, 0, tile ) );
+    EXPECT_EQ( image.tile( 2, Tile{ 0, 0, 64, 64 } ), readTile( reader, 2, Tile{ 0, 0, 64, 64 } ) );
+
+    // Tiles outside the level are not read.
+    std::vector<char> dest( getImageSizeInBytes( CU_AD_FORMAT_BC7_UNORM, 4, 64, 64 ) );
+    EXPECT_FALSE( reader.readTile( dest.data(), 0, Tile{ 2, 0, 64, 64 }, nullptr ) );
+}
+
+TEST_F( TestBlockImageReader, readsUncompressedTiles )
+{
+    const std::string filename = temporaryFile( "TestBlockImageReader-rgba8.ktx2" );
+    const ImageData   image( CU_AD_FORMAT_UNSIGNED_INT8, 4, 96, 80, 7 );
+    writeKTX( filename, image, VK_RGBA8 );
+
+    KTXReader   reader( filename );
+    TextureInfo info{};
+    reader.open( &info );
+    EXPECT_EQ( CU_AD_FORMAT_UNSIGNED_INT8, info.format );
+    EXPECT_EQ( 4U, info.numChannels );
+    EXPECT_EQ( 7U, info.numMipLevels );
+
+    const Tile tiles[] = { { 0, 0, 32, 32 }, { 2, 1, 32, 32 }, { 1, 2, 32, 32 }, { 1, 1, 64, 64 } };
+    for( const Tile& tile : tiles )
+        EXPECT_EQ( image.tile( 0, tile ), readTile( reader, 0, tile ) );
+}
+
+TEST_F( TestBlockImageReader, readsMipLevels )
+{
+    const std::string filename = temporaryFile( "TestBlockImageReader-bc5.ktx2" );
+    const ImageData   image( CU_AD_FORMAT_BC5_UNORM, 2, 64, 32, 7 );
+    writeKTX( filename, image, VK_BC5 );
+
+    KTXReader reader( filename );
+    reader.open( nullptr );
+    EXPECT_EQ( 2U, reader.getInfo().numChannels );
+    for( unsigned int level = 0; level < 7; ++level )
+    {
+        std::vector<char> dest( image.levels[level].size() );
+        EXPECT_TRUE( reader.readMipLevel( dest.data(), level, image.levelWidth( level ), image.levelHeight( level ), nullptr ) );
+        EXPECT_EQ( image.levels[level], dest );
+    }
+}
+
+TEST_F( TestBlockImageReader, readsMipTails )
+{
+    const ImageData image( CU_AD_FORMAT_BC1_UNORM, 4, 64, 64, 7 );
+    std::vector<uint2> levelDims;
+    std::vector<char>  expected;
+    for( unsigned int level = 0; level < 7; ++level )
+    {
+        levelDims.push_back( uint2{ image.levelWidth( level ), image.levelHeight( level ) } );
+        if( level >= 2 )
+            expected.insert( expected.end(), image.levels[level].begin(), image.levels[level].end() );
+    }
+
+    // DDS levels are contiguous, while the KTX2 levels are stored in reverse order.
+    const std::string ddsFile = temporaryFile( "TestBlockImageReader-tail.dds" );
+    const std::string ktxFile = temporaryFile( "TestBlockImageReader-tail.ktx2" );
+    writeDDS( ddsFile, image, FOURCC_DXT1 );
+    writeKTX( ktxFile, image, 131 );
+    std::unique_ptr<ImageSource> readers[] = { std::unique_ptr<ImageSource>( new DDSReader( ddsFile ) ),
+                                               std::unique_ptr<ImageSource>( new KTXReader( ktxFile ) ) };
+    for( std::unique_ptr<ImageSource>& reader : readers )
+    {
+        reader->open( nullptr );
+        std::vector<char> dest( expected.size() );
+        EXPECT_TRUE( reader->readMipTail( dest.data(), 2, 7, levelDims.data(), 4, nullptr ) );
+        EXPECT_EQ( expected, dest );
+    }
+}
+
+TEST_F( TestBlockImageReader, readsBaseColor )
+{
+    // Encode a uniform coarsest level, so that the base color can be decoded.
+    ImageData    image( CU_AD_FORMAT_BC1_UNORM, 4, 16, 16, 5 );
+    const float4 color = float4{ 1.f, 0.f, 0.f, 1.f };
+    float4       texels[16];
+    std::fill_n( texels, 16, color );
+    compressBlock( CU_AD_FORMAT_BC1_UNORM, texels, image.levels.back().data() );
+    const std::string ddsFile = temporaryFile( "TestBlockImageReader-base.dds" );
+    writeDDS( ddsFile, image, FOURCC_DXT1 );
+
+    DDSReader reader( ddsFile );
+    reader.open( nullptr );
+    float4 baseColor{};
+    EXPECT_TRUE( reader.readBaseColor( baseColor ) );
+    EXPECT_NEAR( color.x, baseColor.x, 1e-2f );
+    EXPECT_NEAR( color.y, baseColor.y, 1e-2f );
+    EXPECT_NEAR( color.z, baseColor.z, 1e-2f );
+
+    ImageData rgba( CU_AD_FORMAT_UNSIGNED_INT8, 4, 4, 4, 3 );
+    rgba.levels.back().assign( { char( 255 ), char( 0 ), char( 51 ), char( 255 ) } );
+    const std::string ktxFile = temporaryFile( "TestBlockImageReader-base.ktx2" );
+    writeKTX( ktxFile, rgba, VK_RGBA8 );
+
+    KTXReader ktxReader( ktxFile );
+    ktxReader.open( nullptr );
+    EXPECT_TRUE( ktxReader.readBaseColor( baseColor ) );
+    EXPECT_FLOAT_EQ( 1.f, baseColor.x );
+    EXPECT_FLOAT_EQ( 0.f, baseColor.y );
+    EXPECT_FLOAT_EQ( 0.2f, baseColor.z );
+    EXPECT_FLOAT_EQ( 1.f, baseColor.w );
+}
+
+TEST_F( TestBlockImageReader, readsTilesConcurrently )
+{
+    const std::string filename = temporaryFile( "TestBlockImageReader-threads.dds" );
+    const ImageData   image( CU_AD_FORMAT_BC7_UNORM, 4, 512, 512, 10 );
+    writeDDS( filename, image, 0, DXGI_BC7 );
+
+    DDSReader reader( filename );
+    reader.open( nullptr );
+    std::vector<std::thread> threads;
+    std::vector<int>         mismatches( 8, 0 );
+    for( unsigned int i = 0; i < 8; ++i )
+    {
+        threads.emplace_back( [&, i] {
+            for( unsigned int tileIndex = 0; tileIndex < 64; ++tileIndex )
+            {
+                const Tile        tile{ tileIndex % 8, ( tileIndex / 8 + i ) % 8, 64, 64 };
+                std::vector<char> dest( image.tile( 0, tile ).size() );
+                reader.readTile( dest.data(), 0, tile, nullptr );
+                mismatches[i] += dest != image.tile( 0, tile );
+            }
+        } );
+    }
+    for( std::thread& thread : threads )
+        thread.join();
+    EXPECT_EQ( std::vector<int>( 8, 0 ), mismatches );
+    EXPECT_EQ( 8ULL * 64, reader.getNumTilesRead() );
+}
+
+TEST_F( TestBlockImageReader, rejectsInvalidFiles )
+{
+    const ImageData image( CU_AD_FORMAT_BC1_UNORM, 4, 64, 64, 7 );
+
+    // Basis supercompression is not supported, nor is zstd without OTK_USE_ZSTD.
+    const std::string basis = temporaryFile( "TestBlockImageReader-basis.ktx2" );
+    writeKTX( basis, image, 131, /*supercompression=*/1 );
+    EXPECT_THROW( KTXReader( basis ).open( nullptr ), std::runtime_error );
+#if !OTK_USE_ZSTD
+    const std::string supercompressed = temporaryFile( "TestBlockImageReader-zstd.ktx2" );
+    writeKTX( supercompressed, image, 131, KTX_SUPERCOMPRESSION_ZSTD );
+    EXPECT_THROW( KTXReader( supercompressed ).open( nullptr ), std::runtime_error );
+#endif
+
+    const std::string notDDS = temporaryFile( "TestBlockImageReader-notdds.dds" );
+    writeFile( notDDS, std::vector<char>( 256, 'x' ) );
+    EXPECT_THROW( DDSReader( notDDS ).open( nullptr ), std::runtime_error );
+    EXPECT_THROW( KTXReader( notDDS ).open( nullptr ), std::runtime_error );
+
+    // A file missing its finest level is rejected when opened, rather than failing during reads.
+    const std::string truncated = temporaryFile( "TestBlockImageReader-truncated.dds" );
+    ImageData         missingLevel( image );
+    missingLevel.levels.pop_back();
+    writeDDS( truncated, missingLevel, FOURCC_DXT1 );
+    {
+        std::vector<char> bytes( 128 );
+        std::ifstream( truncated, std::ios::binary ).read( bytes.data(), bytes.size() );
+        putU32( bytes, 28, 7 );
+        std::fstream file( truncated, std::ios::binary | std::ios::in | std::ios::out );
+        file.write( bytes.data(), bytes.size() );
+    }
+    EXPECT_THROW( DDSReader( truncated ).open( nullptr ), std::runtime_error );
+
+    EXPECT_THROW( DDSReader( "TestBlockImageReader-missing.dds" ).open( nullptr ), std::runtime_error );
+}
+
+#if OTK_USE_ZSTD
+TEST_F( TestBlockImageReader, readsZstdSupercompressedKTX )
+{
+    const std::string filename = temporaryFile( "TestBlockImageReader-zstd.ktx2" );
+    const ImageData   image( CU_AD_FORMAT_UNSIGNED_INT8, 4, 96, 80, 7 );
+    writeKTX( filename, image, VK_RGBA8, KTX_SUPERCOMPRESSION_ZSTD );
+
+    KTXReader   reader( filename );
+    TextureInfo info{};
+    reader.open( &info );
+    EXPECT_EQ( 7U, info.numMipLevels );
+
+    const Tile tiles[] = { { 0, 0, 32, 32 }, { 2, 1, 32, 32 }, { 1, 2, 32, 32 }, { 1, 1, 64, 64 } };
+    for( const Tile& tile : tiles )
+    {
+        EXPECT_EQ( image.tile( 0, tile ), readTile( reader, 0, tile ) );
+        std::vector<char> dest( image.tile( 0, tile ).size() );
+        EXPECT_TRUE( reader.readTileAsync( dest.data(), 0, tile, nullptr ).get() );
+        EXPECT_EQ( image.tile( 0, tile ), dest );
+    }
+    EXPECT_EQ( 8U, reader.getNumTilesRead() );
+    for( unsigned int level = 0; level < 7; ++level )
+    {
+        std::vector<char> dest( image.levels[level].size() );
+        EXPECT_TRUE( reader.readMipLevel( dest.data(), level, image.levelWidth( level ), image.levelHeight( level ), nullptr ) );
+        EXPECT_EQ( image.levels[level], dest );
+    }
+
+    // Each level is read from the file once, however many times it is accessed.
+    const unsigned long long numBytesRead = reader.getNumBytesRead();
+    for( const Tile& tile : tiles )
+        EXPECT_EQ( image.tile( 0, tile ), readTile( reader, 0, tile ) );
+    EXPECT_EQ( numBytesRead, reader.getNumBytesRead() );
+
+    std::vector<uint2> levelDims;
+    std::vector<char>  expected;
+    for( unsigned int level = 0; level < 7; ++level )
+    {
+        levelDims.push_back( uint2{ image.levelWidth( level ), image.levelHeight( level ) } );
+        if( level >= 2 )
+            expected.insert( expected.end(), image.levels[level].begin(), image.levels[level].end() );
+    }
+    std::vector<char> tail( expected.size() );
+    EXPECT_TRUE( reader.readMipTail( tail.data(), 2, 7, levelDims.data(), 4, nullptr ) );
+    EXPECT_EQ( expected, tail );
+
+    float4 color;
+    EXPECT_TRUE( reader.readBaseColor( color ) );
+
+    // A corrupt level is reported when it is read.
+    std::vector<char> bytes;
+    {
+        std::ifstream file( filename, std::ios::binary | std::ios::ate );
+        bytes.resize( static_cast<size_t>( file.tellg() ) );
+        file.seekg( 0 );
+        file.read( bytes.data(), bytes.size() );
+    }
+    const size_t finestOffset = static_cast<size_t>( bytes[80] & 0xff ) | static_cast<size_t>( bytes[81] & 0xff ) << 8;
+    for( size_t i = finestOffset; i < bytes.size(); ++i )
+        bytes[i] = 'x';
+    const std::string corrupt = temporaryFile( "TestBlockImageReader-zstd-corrupt.ktx2" );
+    writeFile( corrupt, bytes );
+    KTXReader corruptReader( corrupt );
+    corruptReader.open( nullptr );
+    std::vector<char> dest( image.tile( 0, tiles[0] ).size() );
+    EXPECT_THROW( corruptReader.readTile( dest.data(), 0, tiles[0], nullptr ), std::runtime_error );
+}
+#endif
+
+TEST_F( TestBlockImageReader, createImageSourceDispatchesOnExtension )
+{
+    const ImageData   image( CU_AD_FORMAT_BC1_UNORM, 4, 64, 64, 7 );
+    const std::string ddsFile = temporaryFile( "TestBlockImageReader-create.dds" );
+    const std::string ktxFile = temporaryFile( "TestBlockImageReader-create.ktx2" );
+    writeDDS( ddsFile, image, FOURCC_DXT1 );
+    writeKTX( ktxFile, image, 131 );
+
+    std::shared_ptr<ImageSource> dds = createImageSource( ddsFile );
+    std::shared_ptr<ImageSource> ktx = createImageSource( ktxFile );
+    EXPECT_NE( nullptr, std::dynamic_pointer_cast<DDSReader>( dds ) );
+    EXPECT_NE( nullptr, std::dynamic_pointer_cast<KTXReader>( ktx ) );
+
+    TextureInfo ddsInfo{};
+    TextureInfo ktxInfo{};
+    dds->open( &ddsInfo );
+    ktx->open( &ktxInfo );
+    EXPECT_EQ( ddsInfo, ktxInfo );
+}
+
+TEST_F( TestBlockImageReader, readsTilesAsynchronously )
+{
+    const std::string filename = temporaryFile( "TestBlockImageReader-async.dds" );
+    const ImageData   image( CU_AD_FORMAT_BC7_UNORM, 4, 300, 200, 9 );
+    writeDDS( filename, image, 0, DXGI_BC7 );
+
+    DDSReader reader( filename );
+    reader.open( nullptr );
+
+    // Issue all the tile reads before waiting for any of them.
+    std::vector<Tile>              tiles;
+    std::vector<std::vector<char>> dests;
+    for( unsigned int y = 0; y < 4; ++y )
+    {
+        for( unsigned int x = 0; x < 5; ++x )
+        {
+            tiles.push_back( Tile{ x, y, 64, 64 } );
+            dests.push_back( std::vector<char>( image.tile( 0, tiles.back() ).size(), 0x55 ) );
+        }
+    }
+    std::vector<std::future<bool>> results;
+    for( size_t i = 0; i < tiles.size(); ++i )
+        results.push_back( reader.readTileAsync( dests[i].data(), 0, tiles[i], nullptr ) );
+    for( size_t i = 0; i < tiles.size(); ++i )
+    {
+        EXPECT_TRUE( results[i].get() );
+        EXPECT_EQ( image.tile( 0, tiles[i] ), dests[i] );
+    }
+    EXPECT_EQ( tiles.size(), reader.getNumTilesRead() );
+
+    // Tiles outside the level are not read.
+    std::vector<char> dest( dests[0].size() );
+    EXPECT_FALSE( reader.readTileAsync( dest.data(), 0, Tile{ 5, 0, 64, 64 }, nullptr ).get() );
+}
+
+TEST_F( TestBlockImageReader, asyncReadsOutliveReader )
+{
+    const std::string filename = temporaryFile( "TestBlockImageReader-async-lifetime.dds" );
+    const ImageData   image( CU_AD_FORMAT_BC7_UNORM, 4, 256, 256, 1 );
+    writeDDS( filename, image, 0, DXGI_BC7 );
+
+    std::vector<std::vector<char>> dests( 16, std::vector<char>( image.tile( 0, Tile{ 0, 0, 64, 64 } ).size() ) );
+    std::vector<std::future<bool>> results;
+    {
+        DDSReader reader( filename );
+        reader.open( nullptr );
+        for( unsigned int i = 0; i < 16; ++i )
+            results.push_back( reader.readTileAsync( dests[i].data(), 0, Tile{ i % 4, i / 4, 64, 64 }, nullptr ) );
+    }
+    for( unsigned int i = 0; i < 16; ++i )
+    {
+        EXPECT_TRUE( results[i].get() );
+        EXPECT_EQ( image.tile( 0, Tile{ i % 4, i / 4, 64, 64 } ), dests[i] );
+    }
+}
+
+TEST_F( TestBlockImageReader, reportsSRGBFormats )
+{
+    const ImageData   rgba( CU_AD_FORMAT_UNSIGNED_INT8, 4, 16, 16, 1 );
+    const std::string srgbDDS = temporaryFile( "TestBlockImageReader-srgb.dds" );
+    writeDDS( srgbDDS, rgba, 0, DXGI_RGBA8_SRGB );
+    DDSReader   ddsReader( srgbDDS );
+    TextureInfo info{};
+    ddsReader.open( &info );
+    EXPECT_EQ( CU_AD_FORMAT_UNSIGNED_INT8, info.format );
+    EXPECT_TRUE( ddsReader.isSRGB() );
+
+    const std::string srgbKTX = temporaryFile( "TestBlockImageReader-srgb.ktx2" );
+    writeKTX( srgbKTX, rgba, VK_RGBA8_SRGB );
+    KTXReader ktxReader( srgbKTX );
+    ktxReader.open( nullptr );
+    EXPECT_TRUE( ktxReader.isSRGB() );
+
+    const std::string linearKTX = temporaryFile( "TestBlockImageReader-linear.ktx2" );
+    writeKTX( linearKTX, rgba, VK_RGBA8 );
+    KTXReader linearReader( linearKTX );
+    linearReader.open( nullptr );
+    EXPECT_FALSE( linearReader.isSRGB() );
+}
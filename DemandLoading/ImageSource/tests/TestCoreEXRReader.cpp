@@ -0,0 +1,269 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/CoreEXRReader.h>
+#include <OptiXToolkit/ImageSource/ImageHash.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <gtest/gtest.h>
+
+#include <ImfChannelList.h>
+#include <ImfCompression.h>
+#include <ImfFrameBuffer.h>
+#include <ImfHeader.h>
+#include <ImfMultiPartOutputFile.h>
+#include <ImfOutputPart.h>
+#include <ImfPartType.h>
+#include <ImfTileDescription.h>
+#include <ImfTiledOutputPart.h>
+#include <half.h>
+
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+const int WIDTH  = 64;
+const int HEIGHT = 48;  // a partial row of 32x32 tiles
+
+// Each channel has distinct values that are exact in half precision.
+float channelValue( int channelIndex, int x, int y )
+{
+    return channelIndex * 8.f + x % 8 + ( y % 8 ) / 8.f;
+}
+
+struct PartChannel
+{
+    const char*    name;
+    Imf::PixelType type;
+};
+
+// Multi-part, multi-layer EXR file with a tiled uncompressed part, the same part compressed, and a
+// compressed scanline part.  Channels are numbered in the order they are listed.
+class TestCoreEXRReader : public testing::Test
+{
+  public:
+    void SetUp() override
+    {
+        const std::vector<PartChannel> beauty{ { "R", Imf::HALF },         { "G", Imf::HALF },         { "B", Imf::HALF },
+                                               { "A", Imf::HALF },         { "diffuse.R", Imf::HALF }, { "diffuse.G", Imf::HALF },
+                                               { "diffuse.B", Imf::HALF }, { "mask.A", Imf::HALF },    { "Z", Imf::FLOAT } };
+        const std::vector<PartChannel> aovs{ { "specular.R", Imf::FLOAT }, { "specular.G", Imf::FLOAT }, { "specular.B", Imf::FLOAT },
+                                             { "depth.Z", Imf::FLOAT } };
+
+        std::vector<Imf::Header> headers;
+        headers.push_back( makeHeader( "beauty", Imf::TILEDIMAGE, Imf::NO_COMPRESSION, beauty ) );
+        headers.push_back( makeHeader( "beautyZip", Imf::TILEDIMAGE, Imf::ZIP_COMPRESSION, beauty ) );
+        headers.push_back( makeHeader( "aovs", Imf::SCANLINEIMAGE, Imf::ZIP_COMPRESSION, aovs ) );
+        Imf::MultiPartOutputFile file( m_filename.c_str(), headers.data(), static_cast<int>( headers.size() ) );
+
+        for( int partIndex = 0; partIndex < 2; ++partIndex )
+        {
+            Imf::TiledOutputPart part( file, partIndex );
+            part.setFrameBuffer( makeFrameBuffer( beauty ) );
+            part.writeTiles( 0, part.numXTiles() - 1, 0, part.numYTiles() - 1 );
+        }
+        Imf::OutputPart part( file, 2 );
+        part.setFrameBuffer( makeFrameBuffer( aovs ) );
+        part.writePixels( HEIGHT );
+    }
+
+    void TearDown() override { std::remove( m_filename.c_str() ); }
+
+  protected:
+    const std::string                        m_filename{ "TestCoreEXRReader.exr" };
+    std::map<std::string, std::vector<char>> m_channelData;
+
+    static Imf::Header makeHeader( const char* name, const std::string& type, Imf::Compression compression, const std::vector<PartChannel>& channels )
+    {
+        Imf::Header header( WIDTH, HEIGHT );
+        header.setName( name );
+        header.setType( type );
+        header.compression() = compression;
+        if( type == Imf::TILEDIMAGE )
+            header.setTileDescription( Imf::TileDescription( 32, 32, Imf::ONE_LEVEL ) );
+        for( const PartChannel& channel : channels )
+            header.channels().insert( channel.name, Imf::Channel( channel.type ) );
+        return header;
+    }
+
+    Imf::FrameBuffer makeFrameBuffer( const std::vector<PartChannel>& channels )
+    {
+        Imf::FrameBuffer frameBuffer;
+        for( size_t c = 0; c < channels.size(); ++c )
+        {
+            const size_t       size = channels[c].type == Imf::HALF ? sizeof( half ) : sizeof( float );
+            std::vector<char>& data = m_channelData[channels[c].name];
+            data.resize( WIDTH * HEIGHT * size );
+            for( int y = 0; y < HEIGHT; ++y )
+            {
+                for( int x = 0; x < WIDTH; ++x )
+                {
+                    const float value = channelValue( static_cast<int>( c ), x, y );
+                    char*       dest  = &data[( y * WIDTH + x ) * size];
+                    if( channels[c].type == Imf::HALF )
+                        *reinterpret_cast<half*>( dest ) = half( value );
+                    else
+                        *reinterpret_cast<float*>( dest ) = value;
+                }
+            }
+            frameBuffer.insert( channels[c].name, Imf::Slice( channels[c].type, data.data(), size, WIDTH * size ) );
+        }
+        return frameBuffer;
+    }
+
+    static EXRChannelSelection selection( const std::string& part, const std::string& layer, const std::vector<std::string>& channels = {} )
+    {
+        EXRChannelSelection result;
+        result.part     = part;
+        result.layer    = layer;
+        result.channels = channels;
+        return result;
+    }
+
+    // Read the tile at the given tile coordinates (in 32x32 tiles) as floats.
+    static std::vector<float> readTile( CoreEXRReader& reader, unsigned int tileX, unsigned int tileY )
+    {
+        const TextureInfo& info = reader.getInfo();
+        std::vector<char>  data( 32 * 32 * getBytesPerChannel( info.format ) * info.numChannels );
+        reader.readTile( data.data(), 0, Tile{ tileX, tileY, 32, 32 }, nullptr );
+
+        std::vector<float> values( 32 * 32 * info.numChannels );
+        for( size_t i = 0; i < values.size(); ++i )
+            values[i] = info.format == CU_AD_FORMAT_HALF ? float( reinterpret_cast<const half*>( data.data() )[i] ) :
+                                                           reinterpret_cast<const float*>( data.data() )[i];
+        return values;
+    }
+};
+
+}  // namespace
+
+TEST_F( TestCoreEXRReader, readsStandardChannelsByDefault )
+{
+    CoreEXRReader reader( m_filename, /*readBaseColor=*/false );
+    TextureInfo   info;
+    reader.open( &info );
+    EXPECT_EQ( static_cast<unsigned int>( WIDTH ), info.width );
+    EXPECT_EQ( CU_AD_FORMAT_HALF, info.format );
+    EXPECT_EQ( 4U, info.numChannels );
+
+    // The tile straddles the bottom of the image.
+    const std::vector<float> texels = readTile( reader, 1, 1 );
+    for( int y = 0; y < HEIGHT - 32; ++y )
+    {
+        for( int x = 0; x < 32; ++x )
+        {
+            for( int c = 0; c < 4; ++c )
+                ASSERT_EQ( channelValue( c, 32 + x, 32 + y ), texels[( y * 32 + x ) * 4 + c] );
+        }
+    }
+}
+
+TEST_F( TestCoreEXRReader, readsLayerWithPaddedChannel )
+{
+    CoreEXRReader reader( m_filename, selection( "", "diffuse" ), /*readBaseColor=*/false );
+    TextureInfo   info;
+    reader.open( &info );
+    EXPECT_EQ( 4U, info.numChannels );
+
+    const std::vector<float> texels = readTile( reader, 0, 0 );
+    for( int i = 0; i < 32 * 32; ++i )
+    {
+        const int x = i % 32;
+        const int y = i / 32;
+        ASSERT_EQ( channelValue( 4, x, y ), texels[i * 4 + 0] );
+        ASSERT_EQ( channelValue( 5, x, y ), texels[i * 4 + 1] );
+        ASSERT_EQ( channelValue( 6, x, y ), texels[i * 4 + 2] );
+        ASSERT_EQ( 0.f, texels[i * 4 + 3] );
+    }
+}
+
+TEST_F( TestCoreEXRReader, layersOfOneFileHaveDistinctHashes )
+{
+    // The default channels and the diffuse layer have the same format, so only the channel
+    // selection distinguishes them in the hash index.
+    CoreEXRReader  beauty( m_filename, /*readBaseColor=*/false );
+    CoreEXRReader  diffuse( m_filename, selection( "", "diffuse" ), /*readBaseColor=*/false );
+    ImageHashIndex index( "" );
+
+    EXPECT_EQ( beauty.getFilename(), diffuse.getFilename() );
+    EXPECT_NE( beauty.getFileVariant(), diffuse.getFileVariant() );
+    const ImageHash beautyHash  = index.getHash( beauty, CUstream{} );
+    const ImageHash diffuseHash = index.getHash( diffuse, CUstream{} );
+    EXPECT_EQ( beauty.getInfo(), diffuse.getInfo() );
+    EXPECT_NE( beautyHash, diffuseHash );
+    EXPECT_EQ( 2U, index.size() );
+    EXPECT_EQ( diffuseHash, index.getHash( diffuse, CUstream{} ) );
+}
+
+TEST_F( TestCoreEXRReader, skipsUnselectedChannelsOfCompressedParts )
+{
+    // The uncompressed part is read directly, and the compressed part is decoded; both must agree.
+    CoreEXRReader uncompressed( m_filename, selection( "beauty", "", { "mask.A", "B" } ), /*readBaseColor=*/false );
+    CoreEXRReader compressed( m_filename, selection( "beautyZip", "", { "mask.A", "B" } ), /*readBaseColor=*/false );
+    uncompressed.open( nullptr );
+    compressed.open( nullptr );
+    EXPECT_EQ( 2U, uncompressed.getInfo().numChannels );
+
+    const std::vector<float> texels = readTile( uncompressed, 1, 0 );
+    EXPECT_EQ( texels, readTile( compressed, 1, 0 ) );
+    for( int i = 0; i < 32 * 32; ++i )
+    {
+        ASSERT_EQ( channelValue( 7, 32 + i % 32, i / 32 ), texels[i * 2 + 0] );
+        ASSERT_EQ( channelValue( 2, 32 + i % 32, i / 32 ), texels[i * 2 + 1] );
+    }
+}
+
+TEST_F( TestCoreEXRReader, readsScanlinePartByName )
+{
+    CoreEXRReader reader( m_filename, selection( "aovs", "depth", { "Z" } ), /*readBaseColor=*/false );
+    TextureInfo   info;
+    reader.open( &info );
+    EXPECT_FALSE( info.isTiled );
+    EXPECT_EQ( CU_AD_FORMAT_FLOAT, info.format );
+    EXPECT_EQ( 1U, info.numChannels );
+
+    std::vector<float> depth( WIDTH * HEIGHT );
+    reader.readMipLevel( reinterpret_cast<char*>( depth.data() ), 0, WIDTH, HEIGHT, nullptr );
+    for( int i = 0; i < WIDTH * HEIGHT; ++i )
+        ASSERT_EQ( channelValue( 3, i % WIDTH, i / WIDTH ), depth[i] );
+}
+
+TEST_F( TestCoreEXRReader, rejectsMissingPartsAndChannels )
+{
+    EXPECT_THROW( CoreEXRReader( m_filename, selection( "missing", "" ) ).open( nullptr ), std::runtime_error );
+    EXPECT_THROW( CoreEXRReader( m_filename, selection( "", "diffuse", { "A" } ) ).open( nullptr ), std::runtime_error );
+    EXPECT_THROW( CoreEXRReader( m_filename, selection( "aovs", "" ) ).open( nullptr ), std::runtime_error );
+
+    // A failed open can be retried with the file left closed.
+    CoreEXRReader reader( m_filename, selection( "", "mask", { "A", "A" } ) );
+    EXPECT_THROW( reader.open( nullptr ), std::runtime_error );
+    EXPECT_FALSE( reader.isOpen() );
+}
+
+TEST_F( TestCoreEXRReader, readsScanlinesStraddlingChunks )
+{
+    // ZIP compressed scanline chunks hold 16 lines.
+    CoreEXRReader reader( m_filename, selection( "aovs", "depth", { "Z" } ), /*readBaseColor=*/false );
+    reader.open( nullptr );
+    EXPECT_EQ( 16U, reader.getScanlineChunkHeight() );
+
+    const unsigned int firstRow = 10;
+    const unsigned int numRows  = 30;
+    std::vector<float> depth( WIDTH * numRows );
+    ASSERT_TRUE( reader.readScanlines( reinterpret_cast<char*>( depth.data() ), 0, firstRow, numRows, nullptr ) );
+    for( unsigned int i = 0; i < depth.size(); ++i )
+        ASSERT_EQ( channelValue( 3, i % WIDTH, firstRow + i / WIDTH ), depth[i] );
+
+    // Tiled parts can't be read by scanline.
+    CoreEXRReader tiled( m_filename, /*readBaseColor=*/false );
+    tiled.open( nullptr );
+    EXPECT_EQ( 0U, tiled.getScanlineChunkHeight() );
+    EXPECT_FALSE( tiled.readScanlines( reinterpret_cast<char*>( depth.data() ), 0, 0, 1, nullptr ) );
+}
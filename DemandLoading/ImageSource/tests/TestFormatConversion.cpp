@@ -0,0 +1,266 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/CheckerBoardImage.h>
+#include <OptiXToolkit/ImageSource/ConvertingImageSource.h>
+#include <OptiXToolkit/ImageSource/FormatConversion.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+std::vector<std::uint16_t> toHalf( const std::vector<float>& values )
+{
+    std::vector<std::uint16_t> result( values.size() );
+    convertFloatToHalf( values.data(), values.size(), reinterpret_cast<half*>( result.data() ) );
+    return result;
+}
+
+float encodeSRGB( float value )
+{
+    return value <= 0.0031308f ? 12.92f * value : 1.055f * std::pow( value, 1.f / 2.4f ) - 0.055f;
+}
+
+OutputFormat outputFormat( CUarray_format format, unsigned int numChannels = 0, bool srgb = false )
+{
+    OutputFormat result;
+    result.format      = format;
+    result.numChannels = numChannels;
+    result.srgb        = srgb;
+    return result;
+}
+
+}  // namespace
+
+TEST( TestFormatConversion, roundsFloatsToNearestEvenHalf )
+{
+    // Repeated to cover both the vectorized loop and the remainder.
+    const std::vector<float> values{ 1.f,
+                                     -2.f,
+                                     65504.f,
+                                     65519.f,
+                                     65520.f,
+                                     std::numeric_limits<float>::infinity(),
+                                     std::ldexp( 1.f, -24 ),
+                                     std::ldexp( 1.f, -25 ),
+                                     std::ldexp( 1.5f, -25 ),
+                                     1.f + std::ldexp( 1.f, -11 ),
+                                     1.f + std::ldexp( 3.f, -11 ),
+                                     std::ldexp( 1.f, -14 ) };
+    const std::vector<std::uint16_t> expected{ 0x3c00, 0xc000, 0x7bff, 0x7bff, 0x7c00, 0x7c00,
+                                               0x0001, 0x0000, 0x0001, 0x3c00, 0x3c02, 0x0400 };
+    std::vector<float>         repeated;
+    std::vector<std::uint16_t> repeatedExpected;
+    for( int i = 0; i < 3; ++i )
+    {
+        repeated.insert( repeated.end(), values.begin(), values.end() );
+        repeatedExpected.insert( repeatedExpected.end(), expected.begin(), expected.end() );
+    }
+    EXPECT_EQ( repeatedExpected, toHalf( repeated ) );
+
+    const std::vector<std::uint16_t> nan = toHalf( std::vector<float>( 9, std::numeric_limits<float>::quiet_NaN() ) );
+    for( std::uint16_t bits : nan )
+        EXPECT_TRUE( ( bits & 0x7c00 ) == 0x7c00 && ( bits & 0x3ff ) != 0 );
+}
+
+TEST( TestFormatConversion, roundTripsEveryHalf )
+{
+    std::vector<std::uint16_t> halves( 65536 );
+    for( size_t i = 0; i < halves.size(); ++i )
+        halves[i] = static_cast<std::uint16_t>( i );
+    std::vector<float> floats( halves.size() );
+    convertHalfToFloat( reinterpret_cast<const half*>( halves.data() ), halves.size(), floats.data() );
+
+    EXPECT_EQ( 1.f, floats[0x3c00] );
+    EXPECT_EQ( std::ldexp( 1.f, -24 ), floats[0x0001] );
+    EXPECT_EQ( -65504.f, floats[0xfbff] );
+    const std::vector<std::uint16_t> roundTrip = toHalf( floats );
+    for( size_t i = 0; i < halves.size(); ++i )
+    {
+        if( std::isnan( floats[i] ) )
+            EXPECT_TRUE( std::isnan( floats[i] ) && ( roundTrip[i] & 0x7c00 ) == 0x7c00 );
+        else
+            EXPECT_EQ( halves[i], roundTrip[i] ) << "half 0x" << std::hex << i;
+    }
+}
+
+TEST( TestFormatConversion, convertsFloatsToUnorm8 )
+{
+    std::vector<float> values{ 0.f, 1.f, 0.5f, -1.f, 2.f, std::numeric_limits<float>::quiet_NaN(), 0.25f, 1.f / 255.f, 0.998f };
+    std::vector<std::uint8_t> expected{ 0, 255, 128, 0, 255, 0, 64, 1, 254 };
+    for( int i = 0; i < 2; ++i )
+    {
+        values.insert( values.end(), values.begin(), values.begin() + 9 );
+        expected.insert( expected.end(), expected.begin(), expected.begin() + 9 );
+    }
+    std::vector<std::uint8_t> codes( values.size() );
+    convertFloatToUnorm8( values.data(), values.size(), 1, false, codes.data() );
+    EXPECT_EQ( expected, codes );
+}
+
+TEST( TestFormatConversion, encodesSRGBExceptAlpha )
+{
+    const unsigned int numPixels = 4096;
+    std::vector<float> values( numPixels * 4 );
+    for( unsigned int i = 0; i < numPixels; ++i )
+    {
+        const float value = std::pow( static_cast<float>( i ) / ( numPixels - 1 ), 3.f );
+        for( unsigned int c = 0; c < 4; ++c )
+            values[i * 4 + c] = value;
+    }
+    std::vector<std::uint8_t> codes( values.size() );
+    convertFloatToUnorm8( values.data(), numPixels, 4, true, codes.data() );
+
+    EXPECT_EQ( 0, codes[0] );
+    EXPECT_EQ( 255, codes[( numPixels - 1 ) * 4] );
+    for( unsigned int i = 0; i < numPixels; ++i )
+    {
+        const float value = values[i * 4];
+        EXPECT_NEAR( encodeSRGB( value ) * 255.f + 0.5f, codes[i * 4] + 0.5f, 1.f ) << value;
+        EXPECT_EQ( static_cast<std::uint8_t>( value * 255.f + 0.5f ), codes[i * 4 + 3] );
+    }
+}
+
+TEST( TestFormatConversion, swizzlesAndFillsChannels )
+{
+    const std::vector<float> rgb{ 0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f };
+    const int                bgra[4] = { 2, 1, 0, 3 };
+    std::vector<float>       dest( 8 );
+    swizzleChannels( rgb.data(), 3, 2, bgra, 4, dest.data() );
+    EXPECT_EQ( ( std::vector<float>{ 0.3f, 0.2f, 0.1f, 1.f, 0.6f, 0.5f, 0.4f, 1.f } ), dest );
+
+    const int blueOnly[4] = { -1, -1, 2, 3 };
+    swizzleChannels( rgb.data(), 3, 2, blueOnly, 4, dest.data() );
+    EXPECT_EQ( ( std::vector<float>{ 0.f, 0.f, 0.3f, 1.f, 0.f, 0.f, 0.6f, 1.f } ), dest );
+}
+
+TEST( TestFormatConversion, convertsPixelsAcrossChunks )
+{
+    // UNORM8 RGBA to float RG, over more pixels than are converted at a time.
+    const size_t              numPixels = 1500;
+    std::vector<std::uint8_t> rgba( numPixels * 4 );
+    for( size_t i = 0; i < rgba.size(); ++i )
+        rgba[i] = static_cast<std::uint8_t>( i * 7 );
+    std::vector<float> rg( numPixels * 2 );
+    convertPixels( rgba.data(), CU_AD_FORMAT_UNSIGNED_INT8, 4, numPixels, outputFormat( CU_AD_FORMAT_FLOAT, 2 ), rg.data() );
+    for( size_t i = 0; i < numPixels; ++i )
+    {
+        EXPECT_FLOAT_EQ( rgba[i * 4] / 255.f, rg[i * 2] );
+        EXPECT_FLOAT_EQ( rgba[i * 4 + 1] / 255.f, rg[i * 2 + 1] );
+    }
+
+    // Float to half and back to UNORM8.
+    std::vector<float> floats( numPixels * 4 );
+    for( size_t i = 0; i < floats.size(); ++i )
+        floats[i] = static_cast<float>( i % 256 ) / 255.f;
+    std::vector<std::uint16_t> halves( floats.size() );
+    convertPixels( floats.data(), CU_AD_FORMAT_FLOAT, 4, numPixels, outputFormat( CU_AD_FORMAT_HALF ), halves.data() );
+    EXPECT_EQ( toHalf( floats ), halves );
+    std::vector<std::uint8_t> codes( floats.size() );
+    convertPixels( halves.data(), CU_AD_FORMAT_HALF, 4, numPixels, outputFormat( CU_AD_FORMAT_UNSIGNED_INT8 ), codes.data() );
+    for( size_t i = 0; i < codes.size(); ++i )
+        EXPECT_EQ( i % 256, codes[i] );
+}
+
+TEST( TestFormatConversion, validatesOutputFormats )
+{
+    EXPECT_TRUE( isValidOutputFormat( outputFormat( CU_AD_FORMAT_UNSIGNED_INT8, 4, true ) ) );
+    EXPECT_FALSE( isValidOutputFormat( outputFormat( CU_AD_FORMAT_HALF, 4, true ) ) );
+    EXPECT_FALSE( isValidOutputFormat( outputFormat( CU_AD_FORMAT_HALF, 3 ) ) );
+    EXPECT_FALSE( isValidOutputFormat( outputFormat( CU_AD_FORMAT_SIGNED_INT8 ) ) );
+
+    EXPECT_FALSE( isConversionNeeded( CU_AD_FORMAT_HALF, 4, outputFormat( CU_AD_FORMAT_HALF ) ) );
+    EXPECT_FALSE( isConversionNeeded( CU_AD_FORMAT_HALF, 4, outputFormat( CU_AD_FORMAT_HALF, 4 ) ) );
+    EXPECT_TRUE( isConversionNeeded( CU_AD_FORMAT_HALF, 4, outputFormat( CU_AD_FORMAT_HALF, 2 ) ) );
+    EXPECT_TRUE( isConversionNeeded( CU_AD_FORMAT_UNSIGNED_INT8, 4, outputFormat( CU_AD_FORMAT_UNSIGNED_INT8, 4, true ) ) );
+}
+
+TEST( TestFormatConversion, convertsImageTiles )
+{
+    std::shared_ptr<ImageSource> checkerboard( new CheckerBoardImage( 256, 256, /*squaresPerSide=*/4 ) );
+    ConvertingImageSource        image( checkerboard, outputFormat( CU_AD_FORMAT_HALF ) );
+    TextureInfo                  info;
+    image.open( &info );
+    EXPECT_TRUE( image.isConverting() );
+    EXPECT_EQ( CU_AD_FORMAT_HALF, info.format );
+    EXPECT_EQ( 4U, info.numChannels );
+    EXPECT_EQ( info, image.getInfo() );
+
+    // Tiles match the converted tiles of the wrapped image.
+    const Tile         tile{ 1, 2, 64, 64 };
+    std::vector<float> source( 64 * 64 * 4 );
+    ASSERT_TRUE( checkerboard->readTile( reinterpret_cast<char*>( source.data() ), 1, tile, nullptr ) );
+    std::vector<std::uint16_t> converted( source.size() );
+    ASSERT_TRUE( image.readTile( reinterpret_cast<char*>( converted.data() ), 1, tile, nullptr ) );
+    EXPECT_EQ( toHalf( source ), converted );
+
+    // The mip tail is packed with the converted pixel size.
+    std::vector<uint2> levelDims;
+    size_t             tailSize = 0;
+    for( unsigned int level = 0; level < info.numMipLevels; ++level )
+    {
+        levelDims.push_back( uint2{ 256U >> level, 256U >> level } );
+        if( level >= 4 )
+            tailSize += levelDims.back().x * levelDims.back().y * 4;
+    }
+    std::vector<std::uint16_t> tail( tailSize + 1, 0xffff );
+    EXPECT_TRUE( image.readMipTail( reinterpret_cast<char*>( tail.data() ), 4, info.numMipLevels, levelDims.data(), 16, nullptr ) );
+    EXPECT_EQ( 0xffff, tail.back() );
+
+    // Images already in the requested format are passed through.
+    ConvertingImageSource passThrough( checkerboard, outputFormat( CU_AD_FORMAT_FLOAT, 4 ) );
+    passThrough.open( nullptr );
+    EXPECT_FALSE( passThrough.isConverting() );
+    EXPECT_EQ( CU_AD_FORMAT_FLOAT, passThrough.getInfo().format );
+}
+
+// Measure conversion throughput of tiles on one thread.
+TEST( TestFormatConversion, DISABLED_benchmarkConversion )
+{
+    const size_t       numPixels = 1 << 22;
+    std::vector<float> floats( numPixels * 4 );
+    for( size_t i = 0; i < floats.size(); ++i )
+        floats[i] = static_cast<float>( i % 1021 ) / 1020.f;
+    std::vector<std::uint16_t> halves( floats.size() );
+    convertFloatToHalf( floats.data(), floats.size(), reinterpret_cast<half*>( halves.data() ) );
+    std::vector<char> dest( numPixels * 16 );
+
+    struct Case
+    {
+        const char*    name;
+        const void*    src;
+        CUarray_format srcFormat;
+        OutputFormat   format;
+    };
+    OutputFormat bgra = outputFormat( CU_AD_FORMAT_FLOAT, 4 );
+    bgra.channels[0]  = 2;
+    bgra.channels[2]  = 0;
+    const Case cases[] = {
+        { "float4 -> half4 ", floats.data(), CU_AD_FORMAT_FLOAT, outputFormat( CU_AD_FORMAT_HALF ) },
+        { "half4 -> float4 ", halves.data(), CU_AD_FORMAT_HALF, outputFormat( CU_AD_FORMAT_FLOAT ) },
+        { "float4 -> unorm8", floats.data(), CU_AD_FORMAT_FLOAT, outputFormat( CU_AD_FORMAT_UNSIGNED_INT8 ) },
+        { "float4 -> srgb8 ", floats.data(), CU_AD_FORMAT_FLOAT, outputFormat( CU_AD_FORMAT_UNSIGNED_INT8, 4, true ) },
+        { "half4 -> unorm8 ", halves.data(), CU_AD_FORMAT_HALF, outputFormat( CU_AD_FORMAT_UNSIGNED_INT8 ) },
+        { "half4 -> half2  ", halves.data(), CU_AD_FORMAT_HALF, outputFormat( CU_AD_FORMAT_HALF, 2 ) },
+        { "float4 -> bgra  ", floats.data(), CU_AD_FORMAT_FLOAT, bgra },
+    };
+    for( const Case& c : cases )
+    {
+        const auto start = std::chrono::steady_clock::now();
+        convertPixels( c.src, c.srcFormat, 4, numPixels, c.format, dest.data() );
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        std::cout << c.name << ": " << numPixels / seconds / 1.0e6 << " Mpixels/s per thread\n";
+    }
+}
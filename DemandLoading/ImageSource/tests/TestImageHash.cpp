@@ -0,0 +1,363 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "ImageSourceTestConfig.h"
+
+#include <OptiXToolkit/ImageSource/CheckerBoardImage.h>
+#include <OptiXToolkit/ImageSource/ConvertingImageSource.h>
+#include <OptiXToolkit/ImageSource/ImageHash.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+#include <OptiXToolkit/ImageSource/WrappedImageSource.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+ImageHashOptions singleThreaded()
+{
+    ImageHashOptions options;
+    options.numThreads = 1;
+    return options;
+}
+
+// Presents a checkerboard as an image with native tiles or scanline chunks, counting the whole
+// mip levels read.
+class PartialReadImage : public WrappedImageSource
+{
+  public:
+    PartialReadImage( unsigned int width, unsigned int height, unsigned int tileSize, unsigned int chunkHeight )
+        : WrappedImageSource( std::make_shared<CheckerBoardImage>( width, height, /*squaresPerSide=*/16 ) )
+        , m_tileSize( tileSize )
+        , m_chunkHeight( chunkHeight )
+    {
+    }
+
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override
+    {
+        ++m_numLevelsRead;
+        return WrappedImageSource::readMipLevel( dest, mipLevel, expectedWidth, expectedHeight, stream );
+    }
+
+    bool readScanlines( char* dest, unsigned int mipLevel, unsigned int firstRow, unsigned int numRows, CUstream stream ) override
+    {
+        if( m_chunkHeight == 0 )
+            return false;
+        const TextureInfo& info    = getInfo();
+        const unsigned int width   = std::max( 1U, info.width >> mipLevel );
+        const unsigned int height  = std::max( 1U, info.height >> mipLevel );
+        const size_t       rowSize = getImageSizeInBytes( info.format, info.numChannels, width, 1 );
+        std::vector<char>  level( rowSize * height );
+        if( !WrappedImageSource::readMipLevel( level.data(), mipLevel, width, height, stream ) )
+            return false;
+        std::memcpy( dest, &level[rowSize * firstRow], rowSize * std::min( numRows, height - firstRow ) );
+        return true;
+    }
+
+    unsigned int getScanlineChunkHeight() const override { return m_chunkHeight; }
+    unsigned int getTileWidth() const override { return m_tileSize; }
+    unsigned int getTileHeight() const override { return m_tileSize; }
+
+    unsigned int m_numLevelsRead = 0;
+
+  private:
+    unsigned int m_tileSize;
+    unsigned int m_chunkHeight;
+};
+
+}  // namespace
+
+TEST( TestImageHash, identicalImagesHaveEqualHashes )
+{
+    CheckerBoardImage image1( 256, 256, /*squaresPerSide=*/8 );
+    CheckerBoardImage image2( 256, 256, /*squaresPerSide=*/8 );
+
+    const ImageHash hash1 = computeImageHash( image1 );
+    const ImageHash hash2 = computeImageHash( image2 );
+
+    EXPECT_TRUE( hash1.isValid() );
+    EXPECT_EQ( hash1, hash2 );
+}
+
+TEST( TestImageHash, getHashHashesCoarseLevels )
+{
+    CheckerBoardImage image( 1024, 1024, /*squaresPerSide=*/8 );
+    ImageHashOptions  coarseLevels;
+    coarseLevels.maxLevelSize = COARSE_HASH_LEVEL_SIZE;
+
+    EXPECT_EQ( computeImageHash( image, coarseLevels ).fold(), image.getHash( CUstream{} ) );
+}
+
+TEST( TestImageHash, differentContentHasDifferentHash )
+{
+    CheckerBoardImage image1( 256, 256, /*squaresPerSide=*/8 );
+    CheckerBoardImage image2( 256, 256, /*squaresPerSide=*/16 );
+
+    EXPECT_NE( computeImageHash( image1 ), computeImageHash( image2 ) );
+}
+
+TEST( TestImageHash, differentHeaderHasDifferentHash )
+{
+    CheckerBoardImage image1( 256, 256, /*squaresPerSide=*/8, /*useMipmaps=*/true );
+    CheckerBoardImage image2( 256, 256, /*squaresPerSide=*/8, /*useMipmaps=*/false );
+
+    EXPECT_NE( computeImageHash( image1 ), computeImageHash( image2 ) );
+}
+
+TEST( TestImageHash, tilingDoesNotAffectHash )
+{
+    CheckerBoardImage image1( 256, 256, /*squaresPerSide=*/8, /*useMipmaps=*/true, /*tiled=*/true );
+    CheckerBoardImage image2( 256, 256, /*squaresPerSide=*/8, /*useMipmaps=*/true, /*tiled=*/false );
+
+    EXPECT_EQ( computeImageHash( image1 ), computeImageHash( image2 ) );
+}
+
+TEST( TestImageHash, hashIndependentOfThreadCount )
+{
+    // Large enough to span several hash blocks.
+    CheckerBoardImage image( 1024, 1024, /*squaresPerSide=*/16 );
+    ImageHashOptions  multiThreaded;
+    multiThreaded.numThreads = 4;
+
+    EXPECT_EQ( computeImageHash( image, singleThreaded() ), computeImageHash( image, multiThreaded ) );
+}
+
+TEST( TestImageHash, bandedReadsMatchWholeLevels )
+{
+    // Dimensions that are not multiples of the tile size or chunk height.
+    CheckerBoardImage wholeImage( 1000, 600, /*squaresPerSide=*/16 );
+    ImageHashOptions  wholeLevels;
+    wholeLevels.maxReadSize = 0;
+    ImageHashOptions bands;
+    bands.maxReadSize = 64 << 10;
+    const ImageHash hash = computeImageHash( wholeImage, wholeLevels );
+
+    PartialReadImage tiledImage( 1000, 600, /*tileSize=*/48, /*chunkHeight=*/0 );
+    EXPECT_EQ( hash, computeImageHash( tiledImage, bands ) );
+    PartialReadImage scanlineImage( 1000, 600, /*tileSize=*/0, /*chunkHeight=*/16 );
+    EXPECT_EQ( hash, computeImageHash( scanlineImage, bands ) );
+
+    // Only the levels that fit within maxReadSize are read whole.
+    TextureInfo info;
+    wholeImage.open( &info );
+    unsigned int numSmallLevels = 0;
+    for( unsigned int mipLevel = 0; mipLevel < info.numMipLevels; ++mipLevel )
+    {
+        const size_t levelSize = getImageSizeInBytes( info.format, info.numChannels, std::max( 1U, info.width >> mipLevel ),
+                                                      std::max( 1U, info.height >> mipLevel ) );
+        numSmallLevels += levelSize <= bands.maxReadSize ? 1 : 0;
+    }
+    EXPECT_LT( numSmallLevels, info.numMipLevels );
+    EXPECT_EQ( numSmallLevels, tiledImage.m_numLevelsRead );
+    EXPECT_EQ( numSmallLevels, scanlineImage.m_numLevelsRead );
+}
+
+TEST( TestImageHash, selectedLevelsAffectHash )
+{
+    CheckerBoardImage image( 256, 256, /*squaresPerSide=*/8 );
+    ImageHashOptions  finestLevel;
+    finestLevel.numMipLevels = 1;
+    ImageHashOptions coarseLevels;
+    coarseLevels.firstMipLevel = 2;
+
+    EXPECT_NE( computeImageHash( image ), computeImageHash( image, finestLevel ) );
+    EXPECT_NE( computeImageHash( image, finestLevel ), computeImageHash( image, coarseLevels ) );
+}
+
+TEST( TestImageHash, maxLevelSizeSkipsFineLevels )
+{
+    CheckerBoardImage image( 256, 256, /*squaresPerSide=*/8 );
+    ImageHashOptions  coarseLevels;
+    coarseLevels.maxLevelSize = 128;
+    ImageHashOptions fromLevel2;
+    fromLevel2.firstMipLevel = 2;
+    EXPECT_EQ( computeImageHash( image, fromLevel2 ), computeImageHash( image, coarseLevels ) );
+
+    // The coarsest selected level is hashed however large it is.
+    ImageHashOptions finestLevel;
+    finestLevel.numMipLevels = 1;
+    ImageHashOptions tinyFinestLevel = finestLevel;
+    tinyFinestLevel.maxLevelSize     = 1;
+    EXPECT_EQ( computeImageHash( image, finestLevel ), computeImageHash( image, tinyFinestLevel ) );
+}
+
+TEST( TestImageHash, indexPersistsEntries )
+{
+    const std::string indexFile = "TestImageHash-index.txt";
+    const std::string imageFile = getSourceDir() + "/Textures/level0.png";
+    std::remove( indexFile.c_str() );
+
+    CheckerBoardImage image( 64, 64, /*squaresPerSide=*/4 );
+    TextureInfo       info;
+    image.open( &info );
+    const ImageHash hash = computeImageHash( image );
+    {
+        ImageHashIndex index( indexFile );
+        index.insert( imageFile, info, hash );
+        EXPECT_TRUE( index.save() );
+    }
+
+    ImageHashIndex index( indexFile );
+    ImageHash      found{};
+    EXPECT_EQ( 1U, index.size() );
+    EXPECT_TRUE( index.find( imageFile, info, found ) );
+    EXPECT_EQ( hash, found );
+    std::remove( indexFile.c_str() );
+}
+
+TEST( TestImageHash, indexSavesConcurrently )
+{
+    const std::string indexFile = "TestImageHash-concurrent.txt";
+    const std::string imageFile = getSourceDir() + "/Textures/level0.png";
+    std::remove( indexFile.c_str() );
+
+    CheckerBoardImage image( 64, 64, /*squaresPerSide=*/4 );
+    TextureInfo       info;
+    image.open( &info );
+    const ImageHash   hash = computeImageHash( image );
+    std::atomic<bool> saved( true );
+    auto              writer = [&]() {
+        ImageHashIndex index( indexFile );
+        index.insert( imageFile, info, hash );
+        for( int i = 0; i < 20; ++i )
+            saved = index.save() && saved;
+    };
+    std::thread thread( writer );
+    writer();
+    thread.join();
+
+    // Each save renames its own temporary file into place, so the index is always complete.
+    EXPECT_TRUE( saved );
+    ImageHashIndex index( indexFile );
+    ImageHash      found{};
+    EXPECT_TRUE( index.find( imageFile, info, found ) );
+    EXPECT_EQ( hash, found );
+    std::remove( indexFile.c_str() );
+}
+
+TEST( TestImageHash, indexRejectsMismatchedInfo )
+{
+    const std::string imageFile = getSourceDir() + "/Textures/level0.png";
+    CheckerBoardImage image( 64, 64, /*squaresPerSide=*/4 );
+    TextureInfo       info;
+    image.open( &info );
+    ImageHashIndex index( "" );
+    index.insert( imageFile, info, computeImageHash( image ) );
+
+    TextureInfo otherInfo = info;
+    otherInfo.width *= 2;
+    ImageHash found{};
+    EXPECT_FALSE( index.find( imageFile, otherInfo, found ) );
+    EXPECT_FALSE( index.find( getSourceDir() + "/Textures/missing-file.png", info, found ) );
+}
+
+TEST( TestImageHash, indexDetectsRewritesWithinASecond )
+{
+    const std::string imageFile = "TestImageHash-rewritten.img";
+    std::ofstream( imageFile ) << "first";
+    CheckerBoardImage image( 64, 64, /*squaresPerSide=*/4 );
+    TextureInfo       info;
+    image.open( &info );
+    ImageHashIndex index( "" );
+    index.insert( imageFile, info, ImageHash{ 1, 0 } );
+
+    // Rewrite the file with the same size, usually within the same second.
+    std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+    std::ofstream( imageFile ) << "other";
+    ImageHash found{};
+    EXPECT_FALSE( index.find( imageFile, info, found ) );
+    std::remove( imageFile.c_str() );
+}
+
+TEST( TestImageHash, indexHashesImagesWithoutFilename )
+{
+    CheckerBoardImage image( 64, 64, /*squaresPerSide=*/4 );
+    ImageHashIndex    index( "" );
+
+    EXPECT_EQ( computeImageHash( image ), index.getHash( image, CUstream{} ) );
+    EXPECT_EQ( 0U, index.size() );
+}
+
+TEST( TestImageHash, indexDistinguishesFileVariants )
+{
+    const std::string imageFile = getSourceDir() + "/Textures/level0.png";
+    CheckerBoardImage image( 64, 64, /*squaresPerSide=*/4 );
+    TextureInfo       info;
+    image.open( &info );
+    ImageHashIndex index( "" );
+    index.insert( imageFile, info, ImageHash{ 1, 0 } );
+    index.insert( imageFile, info, ImageHash{ 2, 0 }, "unorm8:rgba:srgb" );
+
+    ImageHash found{};
+    EXPECT_TRUE( index.find( imageFile, info, found ) );
+    EXPECT_EQ( ( ImageHash{ 1, 0 } ), found );
+    EXPECT_TRUE( index.find( imageFile, info, found, "unorm8:rgba:srgb" ) );
+    EXPECT_EQ( ( ImageHash{ 2, 0 } ), found );
+    EXPECT_FALSE( index.find( imageFile, info, found, "unorm8:bgra" ) );
+}
+
+TEST( TestImageHash, indexHashesConversionsSeparately )
+{
+    // A checkerboard that claims to be read from a file, so that the index records its hashes.
+    class CheckerBoardFile : public CheckerBoardImage
+    {
+      public:
+        CheckerBoardFile()
+            : CheckerBoardImage( 64, 64, /*squaresPerSide=*/4 )
+        {
+        }
+        std::string getFilename() const override { return getSourceDir() + "/Textures/level0.png"; }
+    };
+    std::shared_ptr<ImageSource> file( std::make_shared<CheckerBoardFile>() );
+    OutputFormat                 linear;
+    linear.format = CU_AD_FORMAT_UNSIGNED_INT8;
+    OutputFormat srgb = linear;
+    srgb.srgb         = true;
+    OutputFormat swizzled = linear;
+    std::swap( swizzled.channels[0], swizzled.channels[2] );
+    ConvertingImageSource linearImage( file, linear );
+    ConvertingImageSource srgbImage( file, srgb );
+    ConvertingImageSource swizzledImage( file, swizzled );
+    ImageHashIndex        index( "" );
+
+    const ImageHash linearHash   = index.getHash( linearImage, CUstream{} );
+    const ImageHash srgbHash     = index.getHash( srgbImage, CUstream{} );
+    const ImageHash swizzledHash = index.getHash( swizzledImage, CUstream{} );
+    EXPECT_NE( linearHash, srgbHash );
+    EXPECT_NE( linearHash, swizzledHash );
+    EXPECT_EQ( 3U, index.size() );
+    EXPECT_EQ( linearHash, index.getHash( linearImage, CUstream{} ) );
+}
+
+// Benchmark of hash throughput on a large image.  Run with --gtest_also_run_disabled_tests.
+TEST( TestImageHash, DISABLED_benchmarkHashThroughput )
+{
+    CheckerBoardImage image( 4096, 4096, /*squaresPerSide=*/64 );
+    TextureInfo       info;
+    image.open( &info );
+    const double megabytes = getTextureSizeInBytes( info ) / ( 1024.0 * 1024.0 );
+
+    for( unsigned int numThreads : { 1U, 2U, 4U, 8U, 0U } )
+    {
+        ImageHashOptions options;
+        options.numThreads = numThreads;
+        const auto start   = std::chrono::steady_clock::now();
+        computeImageHash( image, options );
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        std::cout << "threads " << numThreads << ": " << megabytes / seconds << " MB/s (including image generation)\n";
+    }
+}
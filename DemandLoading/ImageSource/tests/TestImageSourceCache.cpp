@@ -5,13 +5,144 @@
 #include "Config.h"
 #include "ImageSourceTestConfig.h"
 
+#include <OptiXToolkit/ImageSource/BandwidthLimiter.h>
+#include <OptiXToolkit/ImageSource/CheckerBoardImage.h>
 #include <OptiXToolkit/ImageSource/ImageSourceCache.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
 #include <OptiXToolkit/ImageSource/TiledImageSource.h>
+#include <OptiXToolkit/ImageSource/WrappedImageSource.h>
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
 using namespace imageSource;
 
+namespace {
+
+// Image that counts its open file handles and fails reads when it is not open.  Scanline images
+// can read bands of rows, in which each byte holds the index of its row.  Async images leave
+// readTileAsync pending until the test completes it.
+class FakeFileImage : public ImageSourceBase
+{
+  public:
+    explicit FakeFileImage( std::atomic<int>& numOpenHandles, bool isScanline = false, bool isAsync = false )
+        : m_numOpenHandles( numOpenHandles )
+        , m_isScanline( isScanline )
+        , m_isAsync( isAsync )
+    {
+        m_info.width        = 64;
+        m_info.height       = 64;
+        m_info.format       = CU_AD_FORMAT_UNSIGNED_INT8;
+        m_info.numChannels  = 4;
+        m_info.numMipLevels = 1;
+        m_info.isValid      = true;
+        m_info.isTiled      = !isScanline;
+    }
+    ~FakeFileImage() override { close(); }
+
+    void open( TextureInfo* info ) override
+    {
+        if( !m_isOpen.exchange( true ) )
+        {
+            const int numOpen = ++m_numOpenHandles;
+            int       maxOpen = maxOpenHandles.load();
+            while( numOpen > maxOpen && !maxOpenHandles.compare_exchange_weak( maxOpen, numOpen ) )
+            {
+            }
+        }
+        if( info != nullptr )
+            *info = m_info;
+    }
+    void close() override
+    {
+        if( m_isOpen.exchange( false ) )
+            --m_numOpenHandles;
+    }
+    bool               isOpen() const override { return m_isOpen; }
+    const TextureInfo& getInfo() const override { return m_info; }
+    CUmemorytype       getFillType() const override { return CU_MEMORYTYPE_HOST; }
+    bool               readTile( char* dest, unsigned int /*mipLevel*/, const Tile& /*tile*/, CUstream /*stream*/ ) override
+    {
+        if( !m_isOpen )
+            return false;
+        *dest = 1;
+        std::this_thread::yield();
+        return m_isOpen;
+    }
+    std::future<bool> readTileAsync( char* dest, unsigned int mipLevel, const Tile& tile, CUstream stream ) override
+    {
+        if( !m_isAsync )
+            return ImageSource::readTileAsync( dest, mipLevel, tile, stream );
+        m_pendingRead = std::make_shared<std::promise<bool>>();
+        return m_pendingRead->get_future();
+    }
+    bool readMipLevel( char* /*dest*/, unsigned int /*mipLevel*/, unsigned int /*width*/, unsigned int /*height*/, CUstream /*stream*/ ) override
+    {
+        return m_isOpen;
+    }
+    bool readScanlines( char* dest, unsigned int /*mipLevel*/, unsigned int firstRow, unsigned int numRows, CUstream /*stream*/ ) override
+    {
+        if( !m_isOpen || !m_isScanline )
+            return false;
+        const size_t rowPitch = m_info.width * m_info.numChannels;
+        for( unsigned int row = firstRow; row < std::min( firstRow + numRows, m_info.height ); ++row )
+            std::fill_n( dest + ( row - firstRow ) * rowPitch, rowPitch, static_cast<char>( row ) );
+        return true;
+    }
+    unsigned int getScanlineChunkHeight() const override { return m_isOpen && m_isScanline ? SCANLINE_CHUNK_HEIGHT : 0; }
+    bool         readBaseColor( float4& /*dest*/ ) override { return false; }
+
+    std::shared_ptr<std::promise<bool>> getPendingRead() const { return m_pendingRead; }
+
+    static const unsigned int SCANLINE_CHUNK_HEIGHT = 16;
+    static std::atomic<int> maxOpenHandles;
+
+  private:
+    std::atomic<int>& m_numOpenHandles;
+    const bool                          m_isScanline;
+    const bool                          m_isAsync;
+    std::atomic<bool>                   m_isOpen{ false };
+    TextureInfo                         m_info{};
+    std::shared_ptr<std::promise<bool>> m_pendingRead;
+};
+
+std::atomic<int>   FakeFileImage::maxOpenHandles{ 0 };
+const unsigned int FakeFileImage::SCANLINE_CHUNK_HEIGHT;
+
+class TestLimitedImageSourceCache : public testing::Test
+{
+  protected:
+    void SetUp() override { FakeFileImage::maxOpenHandles = 0; }
+
+    std::shared_ptr<ImageSource> createImage( const std::string& path )
+    {
+        std::shared_ptr<FakeFileImage> image( std::make_shared<FakeFileImage>( m_numOpenHandles, /*isScanline=*/path.find( ".scanline" ) != std::string::npos,
+                                                                               /*isAsync=*/path.find( ".async" ) != std::string::npos ) );
+        m_images[path] = image;
+        return image;
+    }
+
+    bool readTile( ImageSource& image )
+    {
+        char data{};
+        return image.readTile( &data, 0, Tile{ 0, 0, 64, 64 }, CUstream{} );
+    }
+
+    std::atomic<int>                                     m_numOpenHandles{ 0 };
+    std::map<std::string, std::weak_ptr<FakeFileImage>> m_images;
+    ImageSourceCache                                     m_cache{ /*maxOpenImages=*/2, [this]( const std::string& path ) { return createImage( path ); } };
+};
+
+}  // namespace
+
 class TestImageSourceCache : public testing::Test
 {
   protected:
@@ -58,3 +189,189 @@ TEST_F( TestImageSourceCache, setAdaptedReturnsAdapted )
     EXPECT_EQ( adapted, image );
 }
 #endif
+
+TEST_F( TestLimitedImageSourceCache, getDoesNotOpen )
+{
+    std::shared_ptr<ImageSource> image = m_cache.get( "a" );
+
+    EXPECT_FALSE( image->isOpen() );
+    EXPECT_EQ( 0, m_numOpenHandles );
+}
+
+TEST_F( TestLimitedImageSourceCache, readOpensLazily )
+{
+    std::shared_ptr<ImageSource> image = m_cache.get( "a" );
+
+    EXPECT_TRUE( readTile( *image ) );
+    EXPECT_EQ( 1, m_numOpenHandles );
+    EXPECT_EQ( 1U, m_cache.getNumOpenImages() );
+}
+
+TEST_F( TestLimitedImageSourceCache, closesLeastRecentlyUsed )
+{
+    std::shared_ptr<ImageSource> a = m_cache.get( "a" );
+    std::shared_ptr<ImageSource> b = m_cache.get( "b" );
+    std::shared_ptr<ImageSource> c = m_cache.get( "c" );
+    TextureInfo                  info{};
+    a->open( &info );
+    EXPECT_TRUE( readTile( *b ) );
+    EXPECT_TRUE( readTile( *a ) );
+    EXPECT_TRUE( readTile( *c ) );  // closes b, the least recently used
+
+    const CacheStatistics stats = m_cache.getStatistics();
+    EXPECT_EQ( 2, m_numOpenHandles );
+    EXPECT_EQ( 2U, m_cache.getNumOpenImages() );
+    EXPECT_EQ( 3U, stats.numOpens );
+    EXPECT_EQ( 1U, stats.numCloses );
+    EXPECT_EQ( 1U, stats.numHandleHits );
+    EXPECT_EQ( 2U, stats.numHandleMisses );
+    // The closed image remains logically open and retains its info.
+    EXPECT_TRUE( b->isOpen() );
+    EXPECT_EQ( info, b->getInfo() );
+}
+
+TEST_F( TestLimitedImageSourceCache, closedImageReopensOnRead )
+{
+    std::shared_ptr<ImageSource> a = m_cache.get( "a" );
+    std::shared_ptr<ImageSource> b = m_cache.get( "b" );
+    std::shared_ptr<ImageSource> c = m_cache.get( "c" );
+    EXPECT_TRUE( readTile( *a ) );
+    EXPECT_TRUE( readTile( *b ) );
+    EXPECT_TRUE( readTile( *c ) );
+
+    EXPECT_TRUE( readTile( *a ) );
+
+    const CacheStatistics stats = m_cache.getStatistics();
+    EXPECT_EQ( 4U, stats.numOpens );
+    EXPECT_EQ( 2U, stats.numCloses );
+    EXPECT_EQ( 2, m_numOpenHandles );
+}
+
+TEST_F( TestLimitedImageSourceCache, boundedUnderConcurrentChurn )
+{
+    const unsigned int numImages      = 64;
+    const unsigned int numThreads     = 8;
+    const unsigned int readsPerThread = 2000;
+    std::atomic<int>   numFailedReads{ 0 };
+
+    auto worker = [&]( unsigned int seed ) {
+        std::mt19937                                rng( seed );
+        std::uniform_int_distribution<unsigned int> pick( 0, numImages - 1 );
+        for( unsigned int i = 0; i < readsPerThread; ++i )
+        {
+            std::shared_ptr<ImageSource> image = m_cache.get( std::to_string( pick( rng ) ) );
+            if( !readTile( *image ) )
+                ++numFailedReads;
+        }
+    };
+    std::vector<std::thread> threads;
+    for( unsigned int i = 0; i < numThreads; ++i )
+        threads.emplace_back( worker, i );
+    for( std::thread& thread : threads )
+        thread.join();
+
+    // Images with reads in flight cannot be closed, so each thread may hold one image open beyond the limit.
+    const CacheStatistics stats = m_cache.getStatistics();
+    EXPECT_EQ( 0, numFailedReads );
+    EXPECT_LE( FakeFileImage::maxOpenHandles, static_cast<int>( 2 + numThreads ) );
+    EXPECT_EQ( static_cast<int>( m_cache.getNumOpenImages() ), m_numOpenHandles.load() );
+    EXPECT_EQ( numImages, stats.numImageSources );
+    EXPECT_EQ( numThreads * readsPerThread, stats.numHandleHits + stats.numHandleMisses );
+    EXPECT_EQ( stats.numOpens - stats.numCloses, static_cast<unsigned long long>( m_numOpenHandles.load() ) );
+}
+
+TEST_F( TestLimitedImageSourceCache, readsScanlines )
+{
+    std::shared_ptr<ImageSource> a = m_cache.get( "a.scanline" );
+    std::shared_ptr<ImageSource> b = m_cache.get( "b" );
+    std::shared_ptr<ImageSource> c = m_cache.get( "c" );
+    a->open( nullptr );
+    EXPECT_TRUE( readTile( *b ) );
+    EXPECT_TRUE( readTile( *c ) );  // closes a, the least recently used
+
+    // The chunk height is retained while the wrapped image is closed, and reading reopens it.
+    EXPECT_EQ( 2, m_numOpenHandles );
+    EXPECT_EQ( FakeFileImage::SCANLINE_CHUNK_HEIGHT, a->getScanlineChunkHeight() );
+    std::vector<char> rows( 16 * 64 * 4 );
+    EXPECT_TRUE( a->readScanlines( rows.data(), 0, 16, 16, CUstream{} ) );
+    EXPECT_EQ( 16, rows.front() );
+    EXPECT_EQ( 31, rows.back() );
+    EXPECT_EQ( 4U, m_cache.getStatistics().numOpens );
+}
+
+TEST_F( TestLimitedImageSourceCache, tiledImageStreamsScanlines )
+{
+    TiledImageSource tiledImage( m_cache.get( "a.scanline" ) );
+    TextureInfo      info{};
+    tiledImage.open( &info );
+
+    EXPECT_TRUE( info.isTiled );
+    EXPECT_TRUE( tiledImage.isStreaming() );
+    std::vector<char> tile( 32 * 32 * 4 );
+    EXPECT_TRUE( tiledImage.readTile( tile.data(), 0, Tile{ 1, 1, 32, 32 }, CUstream{} ) );
+    EXPECT_EQ( 32, tile.front() );
+    EXPECT_EQ( 63, tile.back() );
+    EXPECT_EQ( 1U, tiledImage.getNumCachedBands() );
+}
+
+TEST_F( TestLimitedImageSourceCache, asyncReadPinsImageOpen )
+{
+    std::shared_ptr<ImageSource> a = m_cache.get( "a.async" );
+    std::shared_ptr<ImageSource> b = m_cache.get( "b" );
+    std::shared_ptr<ImageSource> c = m_cache.get( "c" );
+    std::shared_ptr<ImageSource> d = m_cache.get( "d" );
+    char                         data{};
+    std::future<bool>            result = a->readTileAsync( &data, 0, Tile{ 0, 0, 64, 64 }, CUstream{} );
+    EXPECT_TRUE( readTile( *b ) );
+    EXPECT_TRUE( readTile( *c ) );  // closes b, since a is busy
+    EXPECT_TRUE( m_images["a.async"].lock()->isOpen() );
+    EXPECT_FALSE( m_images["b"].lock()->isOpen() );
+
+    m_images["a.async"].lock()->getPendingRead()->set_value( true );
+    EXPECT_TRUE( result.get() );
+    EXPECT_TRUE( readTile( *d ) );  // closes a, the least recently used
+    EXPECT_FALSE( m_images["a.async"].lock()->isOpen() );
+    EXPECT_EQ( 2, m_numOpenHandles );
+    EXPECT_EQ( 2U, m_cache.getStatistics().numCloses );
+}
+
+TEST_F( TestLimitedImageSourceCache, asyncReadRetainsWrappedImage )
+{
+    std::shared_ptr<ImageSource>        image = m_cache.get( "a.async" );
+    std::weak_ptr<ImageSource>          weakImage( image );
+    char                                data{};
+    std::future<bool>                   result = WrappedImageSource( image ).readTileAsync( &data, 0, Tile{ 0, 0, 64, 64 }, CUstream{} );
+    std::shared_ptr<std::promise<bool>> pendingRead = m_images["a.async"].lock()->getPendingRead();
+    image.reset();
+    m_cache.set( "a.async", nullptr );
+
+    // The wrapper and the cache released the image, but the pending read retains it.
+    EXPECT_FALSE( weakImage.expired() );
+    pendingRead->set_value( true );
+    EXPECT_TRUE( result.get() );
+    result = std::future<bool>();
+    EXPECT_TRUE( weakImage.expired() );
+}
+
+TEST( TestThrottledImageSourceCache, throttlesCreatedImages )
+{
+    // A checkerboard that claims to be read from a file, so that it draws from the file's device limiter.
+    class CheckerBoardFile : public CheckerBoardImage
+    {
+      public:
+        CheckerBoardFile()
+            : CheckerBoardImage( 64, 64, /*squaresPerSide=*/4 )
+        {
+        }
+        std::string getFilename() const override { return getSourceDir() + "/Textures/level0.png"; }
+    };
+    ImageSourceCache cache( /*maxOpenImages=*/0, []( const std::string& ) { return std::make_shared<CheckerBoardFile>(); },
+                            /*throttleReads=*/true );
+    std::shared_ptr<BandwidthLimiter> limiter = BandwidthLimiter::getDeviceLimiter( getSourceDir() + "/Textures/level0.png" );
+    const unsigned long long          numOps  = limiter->getNumOpsGranted();
+
+    std::shared_ptr<ImageSource> image = cache.get( "a" );
+    std::vector<char>            data( 64 * 64 * 4 * sizeof( float ) );
+    EXPECT_TRUE( image->readTile( data.data(), 0, Tile{ 0, 0, 64, 64 }, CUstream{} ) );
+    EXPECT_EQ( numOps + 1, limiter->getNumOpsGranted() );
+}
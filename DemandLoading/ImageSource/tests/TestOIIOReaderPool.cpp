@@ -0,0 +1,159 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/OIIOReader.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <gtest/gtest.h>
+
+#include <OpenImageIO/imageio.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+const unsigned int TILE_SIZE = 64;
+
+uint8_t texelValue( unsigned int x, unsigned int y, unsigned int c )
+{
+    return static_cast<uint8_t>( x * 7 + y * 13 + c * 61 );
+}
+
+// Write a tiled, zip compressed RGBA8 TIFF whose texels are given by texelValue().
+void writeTiledTiff( const std::string& filename, unsigned int size )
+{
+    std::vector<uint8_t> texels( static_cast<size_t>( size ) * size * 4 );
+    for( unsigned int y = 0; y < size; ++y )
+        for( unsigned int x = 0; x < size; ++x )
+            for( unsigned int c = 0; c < 4; ++c )
+                texels[( static_cast<size_t>( y ) * size + x ) * 4 + c] = texelValue( x, y, c );
+
+    OIIO::ImageSpec spec( size, size, 4, OIIO::TypeDesc::UINT8 );
+    spec.tile_width  = TILE_SIZE;
+    spec.tile_height = TILE_SIZE;
+    spec.attribute( "compression", "zip" );
+    std::unique_ptr<OIIO::ImageOutput> output = OIIO::ImageOutput::create( filename );
+    ASSERT_TRUE( output && output->open( filename, spec ) );
+    ASSERT_TRUE( output->write_image( OIIO::TypeDesc::UINT8, texels.data() ) );
+    output->close();
+}
+
+// Read the tiles with the given number of threads, returning the number of mismatched texels.
+unsigned int readTiles( OIIOReader& reader, unsigned int numThreads )
+{
+    const unsigned int        numTilesX = reader.getInfo().width / TILE_SIZE;
+    const unsigned int        numTiles  = numTilesX * ( reader.getInfo().height / TILE_SIZE );
+    std::atomic<unsigned int> nextTile{ 0 };
+    std::atomic<unsigned int> numErrors{ 0 };
+
+    std::vector<std::thread> threads;
+    for( unsigned int i = 0; i < numThreads; ++i )
+    {
+        threads.emplace_back( [&] {
+            std::vector<uint8_t> tile( TILE_SIZE * TILE_SIZE * 4 );
+            for( unsigned int index = nextTile++; index < numTiles; index = nextTile++ )
+            {
+                const unsigned int tileX = index % numTilesX;
+                const unsigned int tileY = index / numTilesX;
+                reader.readTile( reinterpret_cast<char*>( tile.data() ), 0, Tile{ tileX, tileY, TILE_SIZE, TILE_SIZE }, nullptr );
+                for( unsigned int j = 0; j < tile.size(); ++j )
+                {
+                    const unsigned int x = tileX * TILE_SIZE + ( j / 4 ) % TILE_SIZE;
+                    const unsigned int y = tileY * TILE_SIZE + ( j / 4 ) / TILE_SIZE;
+                    if( tile[j] != texelValue( x, y, j % 4 ) )
+                        ++numErrors;
+                }
+            }
+        } );
+    }
+    for( std::thread& thread : threads )
+        thread.join();
+    return numErrors;
+}
+
+class TestOIIOReaderPool : public testing::Test
+{
+  public:
+    void SetUp() override { writeTiledTiff( m_filename, 512 ); }
+
+    void TearDown() override
+    {
+        OIIOReader::setInputLimits( 8, 64 );
+        std::remove( m_filename.c_str() );
+    }
+
+  protected:
+    const std::string m_filename{ "TestOIIOReaderPool.tif" };
+};
+
+}  // namespace
+
+TEST_F( TestOIIOReaderPool, concurrentReadsMatchImage )
+{
+    OIIOReader  reader( m_filename, /*readBaseColor=*/false );
+    TextureInfo info;
+    reader.open( &info );
+    ASSERT_TRUE( info.isTiled );
+    EXPECT_EQ( 1U, reader.getNumInputs() );
+
+    EXPECT_EQ( 0U, readTiles( reader, 8 ) );
+    EXPECT_EQ( 64ULL, reader.getNumTilesRead() );
+    EXPECT_LE( reader.getNumInputs(), 8U );
+}
+
+TEST_F( TestOIIOReaderPool, respectsInputLimits )
+{
+    OIIOReader::setInputLimits( 2, 64 );
+    OIIOReader reader( m_filename, /*readBaseColor=*/false );
+    reader.open( nullptr );
+    EXPECT_EQ( 0U, readTiles( reader, 8 ) );
+    EXPECT_LE( reader.getNumInputs(), 2U );
+
+    // With no inputs to spare, a second image still reads with its first input.
+    OIIOReader::setInputLimits( 8, 0 );
+    OIIOReader other( m_filename, /*readBaseColor=*/false );
+    other.open( nullptr );
+    EXPECT_EQ( 0U, readTiles( other, 4 ) );
+    EXPECT_EQ( 1U, other.getNumInputs() );
+}
+
+TEST_F( TestOIIOReaderPool, reopensAfterClose )
+{
+    OIIOReader reader( m_filename, /*readBaseColor=*/false );
+    reader.open( nullptr );
+    EXPECT_EQ( 0U, readTiles( reader, 4 ) );
+    reader.close();
+    EXPECT_FALSE( reader.isOpen() );
+    EXPECT_EQ( 0U, reader.getNumInputs() );
+
+    reader.open( nullptr );
+    EXPECT_EQ( 0U, readTiles( reader, 4 ) );
+}
+
+TEST_F( TestOIIOReaderPool, DISABLED_benchmarkThreadScaling )
+{
+    const std::string filename( "TestOIIOReaderPoolLarge.tif" );
+    writeTiledTiff( filename, 4096 );
+    for( unsigned int numThreads : { 1U, 2U, 4U, 8U } )
+    {
+        OIIOReader reader( filename, /*readBaseColor=*/false );
+        reader.open( nullptr );
+        const auto start = std::chrono::steady_clock::now();
+        EXPECT_EQ( 0U, readTiles( reader, numThreads ) );
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        std::cout << numThreads << " threads: " << reader.getNumTilesRead() / seconds << " tiles/s using "
+                  << reader.getNumInputs() << " inputs\n";
+    }
+    std::remove( filename.c_str() );
+}
@@ -0,0 +1,215 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/CheckerBoardImage.h>
+#include <OptiXToolkit/ImageSource/ProceduralImage.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+std::vector<float> readLevel( ProceduralImage& image, unsigned int mipLevel )
+{
+    const unsigned int width  = std::max( 1U, image.getInfo().width >> mipLevel );
+    const unsigned int height = std::max( 1U, image.getInfo().height >> mipLevel );
+    std::vector<float> texels( width * height * image.getInfo().numChannels );
+    EXPECT_TRUE( image.readMipLevel( reinterpret_cast<char*>( texels.data() ), mipLevel, width, height, nullptr ) );
+    return texels;
+}
+
+}  // namespace
+
+TEST( TestProceduralImage, checkerMatchesSquares )
+{
+    ProceduralGraph graph;
+    ProceduralImage image( graph, { graph.checker( 16, 16 ) }, 128, 128 );
+    TextureInfo     info;
+    image.open( &info );
+    EXPECT_EQ( 8U, info.numMipLevels );
+
+    // Squares are 8 texels wide, so no texel straddles a square.
+    std::vector<float> texels( 64 * 64 );
+    ASSERT_TRUE( image.readTile( reinterpret_cast<char*>( texels.data() ), 0, Tile{ 1, 0, 64, 64 }, nullptr ) );
+    for( unsigned int y = 0; y < 64; ++y )
+    {
+        for( unsigned int x = 0; x < 64; ++x )
+        {
+            const float expected = ( ( ( 64 + x ) / 8 + y / 8 ) & 1 ) ? 1.f : 0.f;
+            ASSERT_NEAR( expected, texels[y * 64 + x], 1e-5f ) << x << ", " << y;
+        }
+    }
+}
+
+TEST( TestProceduralImage, mipLevelsAverageFinerLevels )
+{
+    // Checkers and gradients are box filtered exactly, even where squares straddle texels.
+    ProceduralGraph             graph;
+    const ProceduralGraph::Node checker = graph.checker( 5, 3 );
+    const ProceduralGraph::Node ramp    = graph.gradient( 0.5f, 0.25f, 0.1f );
+    ProceduralImage image( graph, { checker, ramp, graph.mix( ramp, graph.constant( 1.f ), checker ), graph.constant( 1.f ) }, 256, 128 );
+    image.open( nullptr );
+
+    std::vector<float> finer = readLevel( image, 0 );
+    for( unsigned int level = 1; level < image.getInfo().numMipLevels; ++level )
+    {
+        const unsigned int       width  = std::max( 1U, 256U >> level );
+        const unsigned int       height = std::max( 1U, 128U >> level );
+        const std::vector<float> texels = readLevel( image, level );
+        for( unsigned int y = 0; y < height; ++y )
+        {
+            for( unsigned int x = 0; x < width; ++x )
+            {
+                // Only the first two channels are linear in the patterns.
+                for( unsigned int c = 0; c < 2; ++c )
+                {
+                    const unsigned int finerWidth = width * 2;
+                    const unsigned int y0         = std::min( 2 * y, ( 128U >> ( level - 1 ) ) - 1 );
+                    const unsigned int y1         = std::min( 2 * y + 1, ( 128U >> ( level - 1 ) ) - 1 );
+                    const float        average    = 0.25f
+                                          * ( finer[( y0 * finerWidth + 2 * x ) * 4 + c] + finer[( y0 * finerWidth + 2 * x + 1 ) * 4 + c]
+                                              + finer[( y1 * finerWidth + 2 * x ) * 4 + c] + finer[( y1 * finerWidth + 2 * x + 1 ) * 4 + c] );
+                    ASSERT_NEAR( average, texels[( y * width + x ) * 4 + c], 1e-4f ) << level << ": " << x << ", " << y;
+                }
+            }
+        }
+        finer = texels;
+    }
+
+    float4 color;
+    ASSERT_TRUE( image.readBaseColor( color ) );
+    EXPECT_NEAR( 0.5f, color.x, 0.05f );
+    EXPECT_NEAR( 0.1f + 0.25f + 0.125f, color.y, 1e-5f );
+    EXPECT_EQ( 1.f, color.w );
+}
+
+TEST( TestProceduralImage, noiseFadesToMeanAtCoarseLevels )
+{
+    ProceduralGraph graph;
+    ProceduralImage image( graph, { graph.noise( 16, 3, 7 ) }, 256, 256 );
+
+    const std::vector<float> fine = readLevel( image, 0 );
+    const auto               range = std::minmax_element( fine.begin(), fine.end() );
+    EXPECT_GE( *range.first, 0.f );
+    EXPECT_LE( *range.second, 1.f );
+    EXPECT_GT( *range.second - *range.first, 0.5f );
+
+    // Level 4 has 16x16 texels, one per cell of the coarsest octave.
+    for( float texel : readLevel( image, 4 ) )
+        ASSERT_EQ( 0.5f, texel );
+    float4 color;
+    ASSERT_TRUE( image.readBaseColor( color ) );
+    EXPECT_EQ( 0.5f, color.x );
+}
+
+TEST( TestProceduralImage, tilesMatchMipLevelAndPadWithBlack )
+{
+    ProceduralGraph             graph;
+    const ProceduralGraph::Node pattern = graph.smoothstep( graph.add( graph.noise( 4, 2 ), graph.gradient( 1, 0 ) ), 0.5f, 1.5f );
+    ProceduralImage image( graph, { pattern, graph.checker( 10, 10 ) }, 100, 70, CU_AD_FORMAT_UNSIGNED_INT8 );
+
+    std::vector<std::uint8_t> level( 100 * 70 * 2 );
+    ASSERT_TRUE( image.readMipLevel( reinterpret_cast<char*>( level.data() ), 0, 100, 70, nullptr ) );
+
+    // The tile straddles the right and bottom edges.
+    std::vector<std::uint8_t> tile( 64 * 64 * 2, 0xff );
+    ASSERT_TRUE( image.readTile( reinterpret_cast<char*>( tile.data() ), 0, Tile{ 1, 1, 64, 64 }, nullptr ) );
+    for( unsigned int y = 0; y < 64; ++y )
+    {
+        for( unsigned int x = 0; x < 64; ++x )
+        {
+            for( unsigned int c = 0; c < 2; ++c )
+            {
+                const bool         inside   = 64 + x < 100 && 64 + y < 70;
+                const std::uint8_t expected = inside ? level[( ( 64 + y ) * 100 + 64 + x ) * 2 + c] : 0;
+                ASSERT_EQ( expected, tile[( y * 64 + x ) * 2 + c] ) << x << ", " << y;
+            }
+        }
+    }
+}
+
+TEST( TestProceduralImage, avx2KernelsMatchBaselineKernels )
+{
+    ProceduralGraph             graph;
+    const ProceduralGraph::Node noise   = graph.noise( 5, 4, 7 );
+    const ProceduralGraph::Node checker = graph.checker( 9, 5 );
+    const ProceduralGraph::Node mixed   = graph.mix( graph.gradient( 1, -0.5f, 0.25f ), checker, graph.smoothstep( noise, 0.3f, 0.7f ) );
+    const ProceduralGraph::Node clamped = graph.clamp( graph.remap( graph.multiply( noise, checker ), 2.f, -0.25f ), 0.f, 1.f );
+
+    // Levels whose widths are not multiples of the vector width exercise the remainder loops.
+    ProceduralImage rgba( graph, { mixed, clamped, noise, checker }, 203, 77 );
+    ProceduralImage rg( graph, { mixed, clamped }, 203, 77, CU_AD_FORMAT_UNSIGNED_INT8 );
+    for( ProceduralImage* image : { &rgba, &rg } )
+    {
+        const TextureInfo& info = image->getInfo();
+        for( unsigned int mipLevel = 0; mipLevel < info.numMipLevels; ++mipLevel )
+        {
+            const unsigned int width  = std::max( 1U, info.width >> mipLevel );
+            const unsigned int height = std::max( 1U, info.height >> mipLevel );
+            const size_t       size   = getImageSizeInBytes( info.format, info.numChannels, width, height );
+            std::vector<char>  avx2( size );
+            std::vector<char>  baseline( size );
+            ProceduralImage::setUseAVX2( true );
+            ASSERT_TRUE( image->readMipLevel( avx2.data(), mipLevel, width, height, nullptr ) );
+            ProceduralImage::setUseAVX2( false );
+            ASSERT_TRUE( image->readMipLevel( baseline.data(), mipLevel, width, height, nullptr ) );
+            EXPECT_EQ( baseline, avx2 ) << "mip level " << mipLevel << ", " << info.numChannels << " channels";
+        }
+    }
+    ProceduralImage::setUseAVX2( true );
+}
+
+TEST( TestProceduralImage, compilesLiveNodesOnly )
+{
+    ProceduralGraph             graph;
+    const ProceduralGraph::Node a = graph.gradient( 1, 0 );
+    graph.noise( 8, 4 );  // unused
+    const ProceduralGraph::Node b = graph.remap( graph.clamp( a, 0.25f, 0.75f ), 2.f, -0.5f );
+    ProceduralImage             image( graph, { b }, 16, 16, CU_AD_FORMAT_FLOAT, /*useMipmaps=*/false );
+    EXPECT_EQ( 3U, image.getNumInstructions() );
+
+    const std::vector<float> texels = readLevel( image, 0 );
+    for( unsigned int x = 0; x < 16; ++x )
+        EXPECT_NEAR( std::min( 0.75f, std::max( 0.25f, ( x + 0.5f ) / 16.f ) ) * 2.f - 0.5f, texels[x], 1e-6f );
+}
+
+TEST( TestProceduralImage, DISABLED_benchmarkTilesPerSecond )
+{
+    const unsigned int   size     = 8192;
+    const unsigned int   numTiles = ( size / 64 ) * ( size / 64 );
+    std::vector<float4>  tile( 64 * 64 );
+    auto                 benchmark = [&]( ImageSource& image, const char* name ) {
+        const auto start = std::chrono::steady_clock::now();
+        for( unsigned int i = 0; i < numTiles; ++i )
+            image.readTile( reinterpret_cast<char*>( tile.data() ), 0, Tile{ i % ( size / 64 ), i / ( size / 64 ), 64, 64 }, nullptr );
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        std::cout << name << ": " << numTiles / seconds << " tiles/s\n";
+    };
+
+    CheckerBoardImage scalar( size, size, 16 );
+    benchmark( scalar, "CheckerBoardImage" );
+
+    ProceduralGraph             graph;
+    const ProceduralGraph::Node checker = graph.checker( 16, 16 );
+    ProceduralImage             checkers( graph, { checker, checker, checker, graph.constant( 0.f ) }, size, size );
+
+    ProceduralGraph             noiseGraph;
+    const ProceduralGraph::Node noise = noiseGraph.noise( 64, 4 );
+    ProceduralImage             noisy( noiseGraph, { noise, noise, noise, noiseGraph.constant( 1.f ) }, size, size );
+
+    // The AVX2 kernels are used only if the processor supports them.
+    for( bool useAVX2 : { false, true } )
+    {
+        ProceduralImage::setUseAVX2( useAVX2 );
+        benchmark( checkers, useAVX2 ? "ProceduralImage checker (AVX2)" : "ProceduralImage checker (SSE2)" );
+        benchmark( noisy, useAVX2 ? "ProceduralImage 4 octave noise (AVX2)" : "ProceduralImage 4 octave noise (SSE2)" );
+    }
+}
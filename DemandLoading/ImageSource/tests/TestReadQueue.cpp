@@ -0,0 +1,361 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "IoRing.h"
+#include "RandomAccessFile.h"
+#include "ReadQueue.h"
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+const size_t FILE_SIZE = 1 << 20;
+
+char expectedByte( unsigned long long offset )
+{
+    return static_cast<char>( offset * 7 + offset / 509 );
+}
+
+// Injects a fixed latency into each read call, modeling a network filesystem or a cold device.
+class SlowFile : public RandomAccessFile
+{
+  public:
+    explicit SlowFile( std::chrono::microseconds latency )
+        : m_latency( latency )
+    {
+    }
+
+    bool read( void* dest, size_t numBytes, unsigned long long offset ) const override
+    {
+        ++m_numCalls;
+        std::this_thread::sleep_for( m_latency );
+        return RandomAccessFile::read( dest, numBytes, offset );
+    }
+
+    bool read( const FileRead* reads, size_t numReads ) const override
+    {
+        ++m_numCalls;
+        std::this_thread::sleep_for( m_latency );
+        return RandomAccessFile::read( reads, numReads );
+    }
+
+    unsigned int getNumCalls() const { return m_numCalls; }
+
+  private:
+    std::chrono::microseconds         m_latency;
+    mutable std::atomic<unsigned int> m_numCalls{ 0 };
+};
+
+class TestReadQueue : public testing::Test
+{
+  public:
+    void SetUp() override
+    {
+        std::vector<char> bytes( FILE_SIZE );
+        for( size_t i = 0; i < bytes.size(); ++i )
+            bytes[i] = expectedByte( i );
+        std::ofstream file( m_filename, std::ios::binary );
+        file.write( bytes.data(), bytes.size() );
+    }
+
+    void TearDown() override
+    {
+        RandomAccessFile::setUseIoRing( true );
+        std::remove( m_filename.c_str() );
+    }
+
+  protected:
+    const std::string m_filename{ "TestReadQueue.bin" };
+
+    static bool isExpected( const std::vector<char>& dest, unsigned long long offset )
+    {
+        for( size_t i = 0; i < dest.size(); ++i )
+        {
+            if( dest[i] != expectedByte( offset + i ) )
+                return false;
+        }
+        return true;
+    }
+};
+
+}  // namespace
+
+TEST_F( TestReadQueue, readsBatchesInAnyOrder )
+{
+    RandomAccessFile file;
+    ASSERT_TRUE( file.open( m_filename ) );
+    EXPECT_EQ( FILE_SIZE, file.size() );
+
+    // Strided rows (coalesced across small gaps), distant ranges, an overlap, and an empty read.
+    const unsigned long long       offsets[] = { 4096, 0, 8192, 100000, 8200, 2048, 900000, 50 };
+    const size_t                   sizes[]   = { 1024, 1024, 1024, 300, 64, 1024, 4096, 0 };
+    std::vector<std::vector<char>> dests;
+    std::vector<FileRead>          reads;
+    for( size_t i = 0; i < 8; ++i )
+        dests.push_back( std::vector<char>( sizes[i] ) );
+    for( size_t i = 0; i < 8; ++i )
+        reads.push_back( FileRead{ dests[i].data(), sizes[i], offsets[i] } );
+
+    EXPECT_TRUE( file.read( reads.data(), reads.size() ) );
+    for( size_t i = 0; i < 8; ++i )
+        EXPECT_TRUE( isExpected( dests[i], offsets[i] ) ) << "read " << i;
+}
+
+TEST_F( TestReadQueue, readsScatteredBatchesWithAndWithoutIoRing )
+{
+    RandomAccessFile file;
+    ASSERT_TRUE( file.open( m_filename ) );
+
+    // Distant ranges are not coalesced, so each is a separate vectored read, more of them than fit
+    // in a ring at once.
+    std::vector<unsigned long long> offsets;
+    for( unsigned long long offset = 0; offset + 3 * 1024 < FILE_SIZE; offset += 7919 )
+        offsets.push_back( offset );
+    std::shuffle( offsets.begin(), offsets.end(), std::mt19937( 1 ) );
+
+    for( bool useIoRing : { true, false } )
+    {
+        RandomAccessFile::setUseIoRing( useIoRing );
+        EXPECT_EQ( useIoRing && IoRing::create( 8 ) != nullptr, RandomAccessFile::isIoRingAvailable() );
+
+        // Each range is read as two rows with a gap between them.
+        std::vector<std::vector<char>> dests( 2 * offsets.size(), std::vector<char>( 1024 ) );
+        std::vector<FileRead>          reads;
+        for( size_t i = 0; i < offsets.size(); ++i )
+        {
+            reads.push_back( FileRead{ dests[2 * i].data(), 1024, offsets[i] } );
+            reads.push_back( FileRead{ dests[2 * i + 1].data(), 1024, offsets[i] + 2048 } );
+        }
+        EXPECT_TRUE( file.read( reads.data(), reads.size() ) );
+        for( size_t i = 0; i < offsets.size(); ++i )
+        {
+            EXPECT_TRUE( isExpected( dests[2 * i], offsets[i] ) ) << "range " << i;
+            EXPECT_TRUE( isExpected( dests[2 * i + 1], offsets[i] + 2048 ) ) << "range " << i;
+        }
+    }
+}
+
+#ifndef _WIN32
+TEST_F( TestReadQueue, ioRingReportsEachRead )
+{
+    std::unique_ptr<IoRing> ring = IoRing::create( 4 );
+    if( !ring )
+        GTEST_SKIP() << "io_uring is unavailable";
+
+    const int fd = open( m_filename.c_str(), O_RDONLY );
+    ASSERT_GE( fd, 0 );
+    std::vector<std::vector<char>> dests( 10, std::vector<char>( 512 ) );
+    std::vector<iovec>             iov;
+    std::vector<IoRing::Read>      reads;
+    for( size_t i = 0; i < dests.size(); ++i )
+        iov.push_back( iovec{ dests[i].data(), dests[i].size() } );
+    for( size_t i = 0; i < dests.size(); ++i )
+        reads.push_back( IoRing::Read{ fd, &iov[i], 1, i * 100000ULL, -1 } );
+    // The last read is short, and the one before it is past the end of the file.
+    reads[8].offset = FILE_SIZE + 4096;
+    reads[9].offset = FILE_SIZE - 100;
+
+    EXPECT_TRUE( ring->readAll( reads.data(), reads.size() ) );
+    for( size_t i = 0; i < 8; ++i )
+    {
+        EXPECT_EQ( 512, reads[i].result );
+        EXPECT_TRUE( isExpected( dests[i], reads[i].offset ) ) << "read " << i;
+    }
+    EXPECT_EQ( 0, reads[8].result );
+    EXPECT_EQ( 100, reads[9].result );
+
+    // Errors are reported per read.
+    reads[0].fd = -1;
+    EXPECT_TRUE( ring->readAll( reads.data(), 1 ) );
+    EXPECT_EQ( -EBADF, reads[0].result );
+    close( fd );
+}
+#endif
+
+TEST_F( TestReadQueue, rejectsReadsPastEndOfFile )
+{
+    RandomAccessFile file;
+    ASSERT_TRUE( file.open( m_filename ) );
+    std::vector<char> dest( 16 );
+    const FileRead    reads[] = { { dest.data(), 8, 0 }, { dest.data() + 8, 8, FILE_SIZE - 4 } };
+    EXPECT_FALSE( file.read( reads, 2 ) );
+    EXPECT_FALSE( file.read( dest.data(), 8, FILE_SIZE - 4 ) );
+    EXPECT_TRUE( file.read( dest.data(), 8, FILE_SIZE - 8 ) );
+    EXPECT_FALSE( RandomAccessFile().open( "TestReadQueue-missing.bin" ) );
+}
+
+TEST_F( TestReadQueue, completesAllBatches )
+{
+    std::shared_ptr<RandomAccessFile> file( new RandomAccessFile );
+    ASSERT_TRUE( file->open( m_filename ) );
+
+    ReadQueue                       queue( 4 );
+    const unsigned int              numBatches = 200;
+    std::vector<std::vector<char>>  dests( numBatches, std::vector<char>( 4 * 512 ) );
+    std::vector<std::promise<bool>> results( numBatches );
+    for( unsigned int i = 0; i < numBatches; ++i )
+    {
+        // Each batch reads four strided rows into a contiguous buffer.
+        std::vector<FileRead> reads;
+        for( unsigned int row = 0; row < 4; ++row )
+            reads.push_back( FileRead{ &dests[i][row * 512], 512, i * 4096ULL + row * 8192 } );
+        std::promise<bool>* result = &results[i];
+        queue.submit( file, reads, [result]( bool ok ) { result->set_value( ok ); } );
+    }
+    for( unsigned int i = 0; i < numBatches; ++i )
+    {
+        EXPECT_TRUE( results[i].get_future().get() );
+        for( unsigned int row = 0; row < 4; ++row )
+            EXPECT_TRUE( isExpected( std::vector<char>( &dests[i][row * 512], &dests[i][( row + 1 ) * 512] ), i * 4096ULL + row * 8192 ) );
+    }
+}
+
+TEST_F( TestReadQueue, reportsFailedBatchesSeparately )
+{
+    std::shared_ptr<SlowFile> file( new SlowFile( std::chrono::microseconds( 1000 ) ) );
+    ASSERT_TRUE( file->open( m_filename ) );
+
+    // A single thread is kept busy by the first batch, so the rest are merged.
+    ReadQueue          queue( 1 );
+    std::vector<char>  dest( 3 * 64 );
+    std::promise<bool> results[3];
+    queue.submit( file, { FileRead{ dest.data(), 64, 0 } }, [&]( bool ok ) { results[0].set_value( ok ); } );
+    queue.submit( file, { FileRead{ dest.data() + 64, 64, FILE_SIZE } }, [&]( bool ok ) { results[1].set_value( ok ); } );
+    queue.submit( file, { FileRead{ dest.data() + 128, 64, 256 } }, [&]( bool ok ) { results[2].set_value( ok ); } );
+
+    EXPECT_TRUE( results[0].get_future().get() );
+    EXPECT_FALSE( results[1].get_future().get() );
+    EXPECT_TRUE( results[2].get_future().get() );
+    EXPECT_TRUE( isExpected( std::vector<char>( dest.begin() + 128, dest.end() ), 256 ) );
+}
+
+// Compare reading the rows of BC7 tiles synchronously, as a fill thread does, with queueing them
+// as batches, on a file with injected latency.
+TEST_F( TestReadQueue, DISABLED_benchmarkInjectedLatency )
+{
+    const std::chrono::microseconds latency( 200 );
+    const unsigned int              numTiles    = 256;
+    const unsigned int              rowsPerTile = 16;
+    const size_t                    rowSize     = 256;
+    const size_t                    rowPitch    = 4096;
+
+    std::shared_ptr<SlowFile> file( new SlowFile( latency ) );
+    ASSERT_TRUE( file->open( m_filename ) );
+    std::vector<char> dest( numTiles * rowsPerTile * rowSize );
+    auto tileReads = [&]( unsigned int tile ) {
+        std::vector<FileRead> reads;
+        for( unsigned int row = 0; row < rowsPerTile; ++row )
+            reads.push_back( FileRead{ &dest[( tile * rowsPerTile + row ) * rowSize], rowSize,
+                                       ( tile % 16 ) * rowSize + ( ( tile / 16 ) * rowsPerTile + row ) * rowPitch } );
+        return reads;
+    };
+
+    using Clock = std::chrono::steady_clock;
+    auto start  = Clock::now();
+    for( unsigned int tile = 0; tile < numTiles; ++tile )
+    {
+        for( const FileRead& read : tileReads( tile ) )
+            file->read( read.dest, read.size, read.offset );
+    }
+    const double syncTime = std::chrono::duration<double>( Clock::now() - start ).count();
+
+    start = Clock::now();
+    for( unsigned int tile = 0; tile < numTiles; ++tile )
+    {
+        const std::vector<FileRead> reads = tileReads( tile );
+        file->read( reads.data(), reads.size() );
+    }
+    const double vectoredTime = std::chrono::duration<double>( Clock::now() - start ).count();
+
+    const unsigned int              numCalls = file->getNumCalls();
+    ReadQueue                       queue( 8 );
+    std::vector<std::promise<bool>> results( numTiles );
+    start = Clock::now();
+    for( unsigned int tile = 0; tile < numTiles; ++tile )
+    {
+        std::promise<bool>* result = &results[tile];
+        queue.submit( file, tileReads( tile ), [result]( bool ok ) { result->set_value( ok ); } );
+    }
+    for( std::promise<bool>& result : results )
+        EXPECT_TRUE( result.get_future().get() );
+    const double queuedTime = std::chrono::duration<double>( Clock::now() - start ).count();
+
+    std::cout << numTiles << " tiles, " << latency.count() << " us latency per call\n"
+              << "  per-row reads:  " << syncTime * 1000.0 << " ms\n"
+              << "  vectored reads: " << vectoredTime * 1000.0 << " ms\n"
+              << "  read queue:     " << queuedTime * 1000.0 << " ms (" << file->getNumCalls() - numCalls << " calls)\n";
+}
+
+#ifndef _WIN32
+// Compare batches of scattered reads issued with preadv, one after another, and with io_uring, on
+// a file whose pages are evicted from the page cache before each pass, so that the reads wait on
+// the device.  Run it with the working directory on the device of interest.
+TEST_F( TestReadQueue, DISABLED_benchmarkIoRing )
+{
+    const std::string  filename     = "TestReadQueue-large.bin";
+    const size_t       fileSize     = size_t( 256 ) << 20;
+    const size_t       readSize     = 64 * 1024;
+    const unsigned int readsPerCall = 64;
+    const unsigned int numCalls     = 64;
+    {
+        std::vector<char> bytes( 1 << 20, 'x' );
+        std::ofstream     file( filename, std::ios::binary );
+        for( size_t offset = 0; offset < fileSize; offset += bytes.size() )
+            file.write( bytes.data(), bytes.size() );
+    }
+
+    std::vector<char>               dest( readsPerCall * readSize );
+    std::vector<unsigned long long> offsets;
+    std::mt19937                    rng( 1 );
+    for( unsigned int i = 0; i < numCalls * readsPerCall; ++i )
+        offsets.push_back( ( rng() % ( fileSize / readSize ) ) * readSize );
+
+    for( bool useIoRing : { false, true } )
+    {
+        RandomAccessFile::setUseIoRing( useIoRing );
+        RandomAccessFile file;
+        ASSERT_TRUE( file.open( filename ) );
+        const int fd = open( filename.c_str(), O_RDONLY );
+        ASSERT_GE( fd, 0 );
+        fdatasync( fd );
+        posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+        close( fd );
+
+        const auto start = std::chrono::steady_clock::now();
+        for( unsigned int call = 0; call < numCalls; ++call )
+        {
+            std::vector<FileRead> reads;
+            for( unsigned int i = 0; i < readsPerCall; ++i )
+                reads.push_back( FileRead{ &dest[i * readSize], readSize, offsets[call * readsPerCall + i] } );
+            EXPECT_TRUE( file.read( reads.data(), reads.size() ) );
+        }
+        const double time = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        std::cout << ( useIoRing ? "io_uring: " : "preadv:   " ) << numCalls << " batches of " << readsPerCall << " x "
+                  << readSize / 1024 << " KB reads in " << time * 1000.0 << " ms"
+                  << ( useIoRing && !RandomAccessFile::isIoRingAvailable() ? " (io_uring unavailable)" : "" ) << "\n";
+    }
+    std::remove( filename.c_str() );
+}
+#endif
@@ -0,0 +1,353 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/SharedTileCache.h>
+
+#include "MockImageSource.h"
+
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <gmock/gmock.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace testing;
+using namespace imageSource;
+
+namespace {
+
+const size_t TILE_SIZE = 16;
+
+// Decodes tiles filled with a value, counting the decodes.
+class CountingDecoder
+{
+  public:
+    explicit CountingDecoder( char value = 1 )
+        : m_value( value )
+    {
+    }
+
+    SharedTileCache::DecodeFunction function()
+    {
+        return [this]( char* dest ) {
+            ++m_numDecodes;
+            std::fill( dest, dest + TILE_SIZE, m_value );
+            return true;
+        };
+    }
+
+    unsigned int getNumDecodes() const { return m_numDecodes; }
+
+  private:
+    char                      m_value;
+    std::atomic<unsigned int> m_numDecodes{ 0 };
+};
+
+SharedTileCache::Key tileKey( unsigned long long imageId, unsigned int x )
+{
+    return { imageId, 0, Tile{ x, 0, 4, 1 }, SharedTileCache::READ_TILE };
+}
+
+}  // namespace
+
+TEST( TestSharedTileCache, decodesTileOnce )
+{
+    SharedTileCache cache( 1024 );
+    CountingDecoder decoder( 7 );
+
+    SharedTileCache::TileBuffer first  = cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decoder.function() );
+    SharedTileCache::TileBuffer second = cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decoder.function() );
+
+    ASSERT_TRUE( first );
+    EXPECT_EQ( first, second );
+    EXPECT_EQ( std::vector<char>( TILE_SIZE, 7 ), *first );
+    EXPECT_EQ( 1U, decoder.getNumDecodes() );
+    EXPECT_EQ( 1ULL, cache.getNumMisses() );
+    EXPECT_EQ( 1ULL, cache.getNumHits() );
+    EXPECT_EQ( TILE_SIZE, cache.getSize() );
+}
+
+TEST( TestSharedTileCache, distinguishesImagesLevelsTilesAndReadTypes )
+{
+    SharedTileCache cache( 1024 );
+    CountingDecoder decoder;
+
+    cache.findOrDecode( { 1, 0, Tile{ 0, 0, 4, 1 }, SharedTileCache::READ_TILE }, TILE_SIZE, decoder.function() );
+    cache.findOrDecode( { 2, 0, Tile{ 0, 0, 4, 1 }, SharedTileCache::READ_TILE }, TILE_SIZE, decoder.function() );
+    cache.findOrDecode( { 1, 1, Tile{ 0, 0, 4, 1 }, SharedTileCache::READ_TILE }, TILE_SIZE, decoder.function() );
+    cache.findOrDecode( { 1, 0, Tile{ 0, 1, 4, 1 }, SharedTileCache::READ_TILE }, TILE_SIZE, decoder.function() );
+    cache.findOrDecode( { 1, 0, Tile{ 0, 0, 4, 1 }, SharedTileCache::READ_MIP_LEVEL }, TILE_SIZE, decoder.function() );
+
+    EXPECT_EQ( 5U, decoder.getNumDecodes() );
+    EXPECT_EQ( 5U, cache.getNumTiles() );
+}
+
+TEST( TestSharedTileCache, coalescesConcurrentRequests )
+{
+    const unsigned int numThreads = 4;
+
+    SharedTileCache           cache( 1024 );
+    std::atomic<unsigned int> numDecodes{ 0 };
+
+    // The decode waits until the other requests are waiting for it.
+    auto decode = [&]( char* dest ) {
+        ++numDecodes;
+        while( cache.getNumCoalesced() < numThreads - 1 )
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        std::fill( dest, dest + TILE_SIZE, 3 );
+        return true;
+    };
+
+    std::vector<SharedTileCache::TileBuffer> buffers( numThreads );
+    std::vector<std::thread>                 threads;
+    for( unsigned int i = 0; i < numThreads; ++i )
+        threads.emplace_back( [&, i] { buffers[i] = cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decode ); } );
+    for( std::thread& thread : threads )
+        thread.join();
+
+    EXPECT_EQ( 1U, numDecodes.load() );
+    EXPECT_EQ( 1ULL, cache.getNumMisses() );
+    EXPECT_EQ( numThreads - 1, cache.getNumCoalesced() );
+    ASSERT_TRUE( buffers[0] );
+    for( const SharedTileCache::TileBuffer& buffer : buffers )
+        EXPECT_EQ( buffers[0], buffer );
+}
+
+TEST( TestSharedTileCache, evictsLeastRecentlyUsedTiles )
+{
+    SharedTileCache cache( 3 * TILE_SIZE );
+    CountingDecoder decoder;
+
+    cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decoder.function() );
+    cache.findOrDecode( tileKey( 1, 1 ), TILE_SIZE, decoder.function() );
+    cache.findOrDecode( tileKey( 1, 2 ), TILE_SIZE, decoder.function() );
+
+    // Use tile 0, so that tile 1 is the least recently used.
+    cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decoder.function() );
+    cache.findOrDecode( tileKey( 1, 3 ), TILE_SIZE, decoder.function() );
+
+    EXPECT_EQ( 4U, decoder.getNumDecodes() );
+    EXPECT_EQ( 1ULL, cache.getNumEvictions() );
+    EXPECT_EQ( 3 * TILE_SIZE, cache.getSize() );
+
+    cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decoder.function() );
+    EXPECT_EQ( 4U, decoder.getNumDecodes() );
+    cache.findOrDecode( tileKey( 1, 1 ), TILE_SIZE, decoder.function() );
+    EXPECT_EQ( 5U, decoder.getNumDecodes() );
+}
+
+TEST( TestSharedTileCache, evictedTilesRemainValid )
+{
+    SharedTileCache cache( TILE_SIZE );
+    CountingDecoder first( 1 );
+    CountingDecoder second( 2 );
+
+    SharedTileCache::TileBuffer tile = cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, first.function() );
+    cache.findOrDecode( tileKey( 1, 1 ), TILE_SIZE, second.function() );
+
+    EXPECT_EQ( 1ULL, cache.getNumEvictions() );
+    EXPECT_EQ( std::vector<char>( TILE_SIZE, 1 ), *tile );
+}
+
+TEST( TestSharedTileCache, skipsTilesLargerThanMaxSize )
+{
+    SharedTileCache cache( TILE_SIZE - 1 );
+    CountingDecoder decoder;
+
+    EXPECT_TRUE( cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decoder.function() ) );
+    EXPECT_TRUE( cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decoder.function() ) );
+
+    EXPECT_EQ( 2U, decoder.getNumDecodes() );
+    EXPECT_EQ( 0U, cache.getNumTiles() );
+    EXPECT_EQ( 0ULL, cache.getNumEvictions() );
+}
+
+TEST( TestSharedTileCache, doesNotCacheFailedDecodes )
+{
+    SharedTileCache cache( 1024 );
+    unsigned int    numDecodes = 0;
+    auto            fail       = [&]( char* ) {
+        ++numDecodes;
+        return false;
+    };
+
+    EXPECT_FALSE( cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, fail ) );
+    EXPECT_FALSE( cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, fail ) );
+
+    EXPECT_EQ( 2U, numDecodes );
+    EXPECT_EQ( 0U, cache.getNumTiles() );
+}
+
+TEST( TestSharedTileCache, rethrowsDecodeExceptions )
+{
+    SharedTileCache cache( 1024 );
+    CountingDecoder decoder;
+    auto            fail = []( char* ) -> bool { throw std::runtime_error( "decode failed" ); };
+
+    EXPECT_THROW( cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, fail ), std::runtime_error );
+
+    // The tile is no longer pending, so the next request decodes it.
+    EXPECT_TRUE( cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decoder.function() ) );
+    EXPECT_EQ( 1U, decoder.getNumDecodes() );
+}
+
+TEST( TestSharedTileCache, removesTilesOfImage )
+{
+    SharedTileCache cache( 1024 );
+    CountingDecoder decoder;
+
+    cache.findOrDecode( tileKey( 1, 0 ), TILE_SIZE, decoder.function() );
+    cache.findOrDecode( tileKey( 1, 1 ), TILE_SIZE, decoder.function() );
+    cache.findOrDecode( tileKey( 2, 0 ), TILE_SIZE, decoder.function() );
+
+    cache.removeImage( 1 );
+
+    EXPECT_EQ( 1U, cache.getNumTiles() );
+    EXPECT_EQ( TILE_SIZE, cache.getSize() );
+    cache.findOrDecode( tileKey( 2, 0 ), TILE_SIZE, decoder.function() );
+    EXPECT_EQ( 3U, decoder.getNumDecodes() );
+}
+
+namespace {
+
+class TestSharedCachedImageSource : public Test
+{
+  protected:
+    void SetUp() override
+    {
+        m_baseInfo.width        = 64;
+        m_baseInfo.height       = 64;
+        m_baseInfo.format       = CU_AD_FORMAT_UNSIGNED_INT8;
+        m_baseInfo.numChannels  = 4;
+        m_baseInfo.numMipLevels = 1;
+        m_baseInfo.isValid      = true;
+        m_baseInfo.isTiled      = true;
+        EXPECT_CALL( *m_baseImage, getInfo() ).WillRepeatedly( ReturnRef( m_baseInfo ) );
+    }
+
+    otk::testing::MockImageSourcePtr m_baseImage{ std::make_shared<otk::testing::MockImageSource>() };
+    TextureInfo                      m_baseInfo{};
+    std::shared_ptr<SharedTileCache> m_cache{ std::make_shared<SharedTileCache>( 1 << 20 ) };
+};
+
+}  // namespace
+
+TEST_F( TestSharedCachedImageSource, decodesTileOnceForAllLoaders )
+{
+    const Tile   tile{ 1, 2, 16, 16 };
+    const size_t tileSize = 16 * 16 * 4;
+    EXPECT_CALL( *m_baseImage, getFillType() ).WillRepeatedly( Return( CU_MEMORYTYPE_HOST ) );
+    EXPECT_CALL( *m_baseImage, readTile( NotNull(), 0, tile, _ ) ).WillOnce( Invoke( []( char* dest, unsigned, const Tile&, CUstream ) {
+        std::fill( dest, dest + tileSize, 42 );
+        return true;
+    } ) );
+    SharedCachedImageSource image( m_baseImage, m_cache );
+
+    // Each loader reads the tile into its own buffer.
+    const unsigned int             numLoaders = 4;
+    std::vector<std::vector<char>> dest( numLoaders, std::vector<char>( tileSize ) );
+    std::vector<std::thread>       threads;
+    for( unsigned int i = 0; i < numLoaders; ++i )
+        threads.emplace_back( [&, i] { EXPECT_TRUE( image.readTile( dest[i].data(), 0, tile, CUstream{} ) ); } );
+    for( std::thread& thread : threads )
+        thread.join();
+
+    for( const std::vector<char>& buffer : dest )
+        EXPECT_EQ( std::vector<char>( tileSize, 42 ), buffer );
+    EXPECT_EQ( 1ULL, m_cache->getNumMisses() );
+    EXPECT_EQ( numLoaders - 1, m_cache->getNumHits() + m_cache->getNumCoalesced() );
+}
+
+TEST_F( TestSharedCachedImageSource, failedReadIsRetried )
+{
+    const Tile tile{ 0, 0, 16, 16 };
+    EXPECT_CALL( *m_baseImage, getFillType() ).WillRepeatedly( Return( CU_MEMORYTYPE_HOST ) );
+    EXPECT_CALL( *m_baseImage, readTile( NotNull(), 0, tile, _ ) ).WillOnce( Return( false ) ).WillOnce( Return( true ) );
+    SharedCachedImageSource image( m_baseImage, m_cache );
+
+    std::vector<char> dest( 16 * 16 * 4 );
+    EXPECT_FALSE( image.readTile( dest.data(), 0, tile, CUstream{} ) );
+    EXPECT_TRUE( image.readTile( dest.data(), 0, tile, CUstream{} ) );
+    EXPECT_TRUE( image.readTile( dest.data(), 0, tile, CUstream{} ) );
+}
+
+TEST_F( TestSharedCachedImageSource, passesThroughDeviceImages )
+{
+    const Tile tile{ 0, 0, 16, 16 };
+    char       dest[1];
+    EXPECT_CALL( *m_baseImage, getFillType() ).WillRepeatedly( Return( CU_MEMORYTYPE_DEVICE ) );
+    EXPECT_CALL( *m_baseImage, readTile( dest, 0, tile, _ ) ).Times( 2 ).WillRepeatedly( Return( true ) );
+    SharedCachedImageSource image( m_baseImage, m_cache );
+
+    EXPECT_TRUE( image.readTile( dest, 0, tile, CUstream{} ) );
+    EXPECT_TRUE( image.readTile( dest, 0, tile, CUstream{} ) );
+    EXPECT_EQ( 0U, m_cache->getNumTiles() );
+}
+
+TEST_F( TestSharedCachedImageSource, removesTilesWhenDestroyed )
+{
+    const Tile tile{ 0, 0, 16, 16 };
+    EXPECT_CALL( *m_baseImage, getFillType() ).WillRepeatedly( Return( CU_MEMORYTYPE_HOST ) );
+    EXPECT_CALL( *m_baseImage, readTile( NotNull(), 0, tile, _ ) ).Times( 2 ).WillRepeatedly( Return( true ) );
+
+    std::vector<char> dest( 16 * 16 * 4 );
+    {
+        SharedCachedImageSource image( m_baseImage, m_cache );
+        EXPECT_TRUE( image.readTile( dest.data(), 0, tile, CUstream{} ) );
+        EXPECT_EQ( 1U, m_cache->getNumTiles() );
+    }
+    EXPECT_EQ( 0U, m_cache->getNumTiles() );
+
+    // A new wrapper of the same image doesn't find stale tiles.
+    SharedCachedImageSource image( m_baseImage, m_cache );
+    EXPECT_TRUE( image.readTile( dest.data(), 0, tile, CUstream{} ) );
+}
+
+TEST_F( TestSharedCachedImageSource, decodesMipLevelOnceForAllLoaders )
+{
+    const size_t levelSize = 32 * 32 * 4;
+    EXPECT_CALL( *m_baseImage, getFillType() ).WillRepeatedly( Return( CU_MEMORYTYPE_HOST ) );
+    EXPECT_CALL( *m_baseImage, readMipLevel( NotNull(), 1, 32, 32, _ ) ).WillOnce( Invoke( []( char* dest, unsigned, unsigned, unsigned, CUstream ) {
+        std::fill( dest, dest + levelSize, 42 );
+        return true;
+    } ) );
+    SharedCachedImageSource image( m_baseImage, m_cache );
+
+    std::vector<char> first( levelSize );
+    std::vector<char> second( levelSize );
+    EXPECT_TRUE( image.readMipLevel( first.data(), 1, 32, 32, CUstream{} ) );
+    EXPECT_TRUE( image.readMipLevel( second.data(), 1, 32, 32, CUstream{} ) );
+
+    EXPECT_EQ( std::vector<char>( levelSize, 42 ), first );
+    EXPECT_EQ( first, second );
+    EXPECT_EQ( 1ULL, m_cache->getNumMisses() );
+}
+
+TEST_F( TestSharedCachedImageSource, decodesMipTailOnceForAllLoaders )
+{
+    const uint2  levelDims[] = { { 64, 64 }, { 32, 32 }, { 16, 16 }, { 8, 8 } };
+    const size_t tailSize    = ( 16 * 16 + 8 * 8 ) * 4;
+    EXPECT_CALL( *m_baseImage, getFillType() ).WillRepeatedly( Return( CU_MEMORYTYPE_HOST ) );
+    EXPECT_CALL( *m_baseImage, readMipTail( NotNull(), 2, 4, levelDims, 4, _ ) )
+        .WillOnce( Invoke( []( char* dest, unsigned, unsigned, const uint2*, unsigned, CUstream ) {
+            std::fill( dest, dest + tailSize, 42 );
+            return true;
+        } ) );
+    SharedCachedImageSource image( m_baseImage, m_cache );
+
+    std::vector<char> first( tailSize );
+    std::vector<char> second( tailSize );
+    EXPECT_TRUE( image.readMipTail( first.data(), 2, 4, levelDims, 4, CUstream{} ) );
+    EXPECT_TRUE( image.readMipTail( second.data(), 2, 4, levelDims, 4, CUstream{} ) );
+
+    EXPECT_EQ( std::vector<char>( tailSize, 42 ), first );
+    EXPECT_EQ( first, second );
+    EXPECT_EQ( tailSize, m_cache->getSize() );
+}
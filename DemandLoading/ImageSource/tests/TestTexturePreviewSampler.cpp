@@ -0,0 +1,180 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/ProceduralImage.h>
+#include <OptiXToolkit/ImageSource/TexturePreviewSampler.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+// A 64x64 single channel image of the ramp 0.1 + 0.5 u + 0.25 v, whose texels are the ramp at
+// their centers.
+std::shared_ptr<ImageSource> createRampImage()
+{
+    ProceduralGraph graph;
+    return std::make_shared<ProceduralImage>( graph, std::vector<ProceduralGraph::Node>{ graph.gradient( 0.5f, 0.25f, 0.1f ) }, 64, 64 );
+}
+
+std::shared_ptr<ImageSource> createCheckerImage( unsigned int width, unsigned int height )
+{
+    ProceduralGraph             graph;
+    const ProceduralGraph::Node checker = graph.checker( 16, 16 );
+    const ProceduralGraph::Node ramp    = graph.gradient( 1.f, 0.5f );
+    return std::make_shared<ProceduralImage>( graph, std::vector<ProceduralGraph::Node>{ checker, ramp, graph.multiply( checker, ramp ),
+                                                                                       graph.constant( 1.f ) },
+                                              width, height );
+}
+
+TexturePreviewDescriptor makeDescriptor( unsigned int filterMode, CUaddress_mode addressMode = CU_TR_ADDRESS_MODE_WRAP )
+{
+    TexturePreviewDescriptor desc;
+    desc.filterMode     = filterMode;
+    desc.addressMode[0] = addressMode;
+    desc.addressMode[1] = addressMode;
+    return desc;
+}
+
+}  // namespace
+
+TEST( TestTexturePreviewSampler, bicubicReproducesLinearRamp )
+{
+    // Cubic B-splines reproduce linear functions, so away from the edges the bicubic sample is the
+    // ramp itself, and its derivatives are the ramp slopes.
+    TexturePreviewSampler sampler( createRampImage(), makeDescriptor( FILTER_BICUBIC, CU_TR_ADDRESS_MODE_CLAMP ) );
+    EXPECT_EQ( 7U, sampler.getInfo().numMipLevels );
+    const float2 ddx{ 1.f / 256, 0.f };
+    const float2 ddy{ 0.f, 1.f / 256 };
+    for( float s = 0.1f; s < 0.9f; s += 0.0371f )
+    {
+        for( float t = 0.1f; t < 0.9f; t += 0.0419f )
+        {
+            float4 result, drds, drdt;
+            sampler.sample( s, t, ddx, ddy, &result, &drds, &drdt );
+            ASSERT_NEAR( 0.1f + 0.5f * s + 0.25f * t, result.x, 1e-5f ) << s << ", " << t;
+            ASSERT_NEAR( 0.5f, drds.x, 1e-3f );
+            ASSERT_NEAR( 0.25f, drdt.x, 1e-3f );
+
+            // Missing channels read as zero, and alpha as one.
+            ASSERT_EQ( 0.f, result.y );
+            ASSERT_NEAR( 1.f, result.w, 1e-6f );
+        }
+    }
+}
+
+TEST( TestTexturePreviewSampler, bilinearInterpolatesTexels )
+{
+    TexturePreviewDescriptor desc = makeDescriptor( FILTER_BILINEAR, CU_TR_ADDRESS_MODE_CLAMP );
+    desc.mipmapFilterMode         = CU_TR_FILTER_MODE_POINT;
+    TexturePreviewSampler sampler( createRampImage(), desc );
+
+    // Texel centers give the texels, and points between them the average of their neighbors.
+    const float2 ddx{ 1.f / 128, 0.f };
+    const float2 ddy{ 0.f, 1.f / 128 };
+    float4       center, between;
+    sampler.sample( 10.5f / 64, 20.5f / 64, ddx, ddy, &center );
+    EXPECT_NEAR( 0.1f + 0.5f * 10.5f / 64 + 0.25f * 20.5f / 64, center.x, 1e-6f );
+    sampler.sample( 11.f / 64, 21.f / 64, ddx, ddy, &between );
+    EXPECT_NEAR( 0.1f + 0.5f * 11.f / 64 + 0.25f * 21.f / 64, between.x, 1e-6f );
+
+    // Point filtering returns the texel containing the sample.
+    TexturePreviewSampler pointSampler( createRampImage(), makeDescriptor( FILTER_POINT ) );
+    float4                point;
+    pointSampler.sample( 10.9f / 64, 20.1f / 64, ddx, ddy, &point );
+    EXPECT_EQ( center.x, point.x );
+}
+
+TEST( TestTexturePreviewSampler, footprintSelectsMipLevel )
+{
+    // A footprint of 32 texels selects the 4x4 level, where each texel averages 4x4 checker squares.
+    for( unsigned int filterMode : { FILTER_BILINEAR, FILTER_BICUBIC, FILTER_SMARTBICUBIC } )
+    {
+        TexturePreviewSampler sampler( createCheckerImage( 128, 128 ), makeDescriptor( filterMode ) );
+        float4                result;
+        sampler.sample( 0.3f, 0.6f, float2{ 0.25f, 0.f }, float2{ 0.f, 0.25f }, &result );
+        EXPECT_NEAR( 0.5f, result.x, 1e-3f ) << filterMode;
+        EXPECT_NEAR( 1.f, result.w, 1e-6f );
+    }
+
+    // Anisotropic footprints keep detail along the short axis, which the checkers average away.
+    TexturePreviewSampler sampler( createCheckerImage( 128, 128 ), makeDescriptor( FILTER_BILINEAR ) );
+    float4                result;
+    sampler.sample( 0.3f, 0.6f, float2{ 0.25f, 0.f }, float2{ 0.f, 1.f / 64 }, &result );
+    EXPECT_NEAR( 0.5f, result.x, 0.05f );
+}
+
+TEST( TestTexturePreviewSampler, wrapAddressMode )
+{
+    TexturePreviewSampler sampler( createCheckerImage( 64, 32 ), makeDescriptor( FILTER_BICUBIC ) );
+    const float2          ddx{ 1.f / 200, 0.f };
+    const float2          ddy{ 0.f, 1.f / 100 };
+    for( float s = -0.02f; s < 0.05f; s += 0.01f )
+    {
+        float4 a, b;
+        sampler.sample( s, 0.99f, ddx, ddy, &a );
+        sampler.sample( s + 1.f, -0.01f, ddx, ddy, &b );
+        EXPECT_NEAR( a.x, b.x, 1e-5f );
+        EXPECT_NEAR( a.y, b.y, 1e-5f );
+    }
+}
+
+TEST( TestTexturePreviewSampler, sampleImageMatchesSample )
+{
+    const unsigned int width  = 70;
+    const unsigned int height = 45;
+    const float2       uv00{ 0.2f, 0.3f };
+    const float2       uv11{ 0.6f, 0.5f };
+
+    // Smart bicubic blends linear and cubic filtering at this footprint.
+    const float2          ddx{ 0.012f, 0.002f };
+    const float2          ddy{ -0.001f, 0.01f };
+    TexturePreviewSampler sampler( createCheckerImage( 128, 128 ), makeDescriptor( FILTER_SMARTBICUBIC ) );
+
+    std::vector<float4> image( width * height ), drds( width * height ), drdt( width * height );
+    sampler.sampleImage( width, height, uv00, uv11, ddx, ddy, image.data(), drds.data(), drdt.data(), 3 );
+    for( unsigned int y = 0; y < height; ++y )
+    {
+        for( unsigned int x = 0; x < width; ++x )
+        {
+            const float xf = ( x + 0.5f ) / width;
+            const float yf = ( y + 0.5f ) / height;
+            float4      expected, expectedDrds, expectedDrdt;
+            sampler.sample( ( 1.f - xf ) * uv00.x + xf * uv11.x, ( 1.f - yf ) * uv00.y + yf * uv11.y, ddx, ddy, &expected,
+                            &expectedDrds, &expectedDrdt );
+            const unsigned int index = y * width + x;
+            ASSERT_EQ( 0, memcmp( &expected, &image[index], sizeof( float4 ) ) ) << x << ", " << y;
+            ASSERT_EQ( 0, memcmp( &expectedDrds, &drds[index], sizeof( float4 ) ) ) << x << ", " << y;
+            ASSERT_EQ( 0, memcmp( &expectedDrdt, &drdt[index], sizeof( float4 ) ) ) << x << ", " << y;
+        }
+    }
+}
+
+TEST( TestTexturePreviewSampler, DISABLED_benchmarkSamplesPerSecond )
+{
+    const unsigned int width  = 1024;
+    const unsigned int height = 1024;
+    std::vector<float4> image( width * height ), drds( width * height );
+    for( unsigned int filterMode : { FILTER_POINT, FILTER_BILINEAR, FILTER_BICUBIC, FILTER_SMARTBICUBIC } )
+    {
+        TexturePreviewSampler sampler( createCheckerImage( 2048, 2048 ), makeDescriptor( filterMode ) );
+        for( float scale : { 0.5f, 4.f } )
+        {
+            const float2 ddx{ scale / width, 0.f };
+            const float2 ddy{ 0.f, scale / height };
+            const auto   start = std::chrono::steady_clock::now();
+            sampler.sampleImage( width, height, float2{ 0.f, 0.f }, float2{ 1.f, 1.f }, ddx, ddy, image.data(), drds.data() );
+            const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+            std::cout << "filter mode " << filterMode << ", footprint " << scale * 2 << " texels: "
+                      << width * height / seconds * 1e-6 << " M samples/s\n";
+        }
+    }
+}
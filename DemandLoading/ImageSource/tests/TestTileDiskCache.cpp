@@ -0,0 +1,343 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <OptiXToolkit/ImageSource/TileDiskCache.h>
+#include <OptiXToolkit/ImageSource/TextureInfo.h>
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <ftw.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace imageSource;
+
+namespace {
+
+const unsigned int TILE_SIZE = 16;
+
+// A file-backed RGBA8 image whose texels depend on their position, which counts the tiles it decodes.
+class FileImage : public ImageSourceBase
+{
+  public:
+    explicit FileImage( const std::string& filename, const std::string& variant = std::string() )
+        : m_filename( filename )
+        , m_variant( variant )
+    {
+        m_info.width        = 64;
+        m_info.height       = 48;
+        m_info.format       = CU_AD_FORMAT_UNSIGNED_INT8;
+        m_info.numChannels  = 4;
+        m_info.numMipLevels = 1;
+        m_info.isValid      = true;
+        m_info.isTiled      = true;
+    }
+
+    static unsigned char texel( unsigned int x, unsigned int y, unsigned int c ) { return static_cast<unsigned char>( x + 3 * y + 101 * c ); }
+
+    void open( TextureInfo* info ) override
+    {
+        m_isOpen = true;
+        if( info != nullptr )
+            *info = m_info;
+    }
+    void               close() override { m_isOpen = false; }
+    bool               isOpen() const override { return m_isOpen; }
+    const TextureInfo& getInfo() const override { return m_info; }
+    CUmemorytype       getFillType() const override { return CU_MEMORYTYPE_HOST; }
+    std::string        getFilename() const override { return m_filename; }
+    std::string        getFileVariant() const override { return m_variant; }
+    bool               readBaseColor( float4& /*dest*/ ) override { return false; }
+    bool readMipLevel( char* /*dest*/, unsigned int /*mipLevel*/, unsigned int /*width*/, unsigned int /*height*/, CUstream /*stream*/ ) override
+    {
+        return false;
+    }
+
+    bool readTile( char* dest, unsigned int /*mipLevel*/, const Tile& tile, CUstream /*stream*/ ) override
+    {
+        for( unsigned int y = 0; y < tile.height; ++y )
+            for( unsigned int x = 0; x < tile.width; ++x )
+                for( unsigned int c = 0; c < 4; ++c )
+                    *dest++ = static_cast<char>( texel( tile.x * tile.width + x, tile.y * tile.height + y, c ) );
+        ++m_numTilesDecoded;
+        return true;
+    }
+
+    std::atomic<unsigned int> m_numTilesDecoded{ 0 };
+
+  private:
+    std::string m_filename;
+    std::string m_variant;
+    TextureInfo m_info{};
+    bool        m_isOpen = false;
+};
+
+bool tileMatches( const std::vector<char>& dest, const Tile& tile )
+{
+    for( unsigned int i = 0; i < TILE_SIZE * TILE_SIZE * 4; ++i )
+    {
+        const unsigned int x = tile.x * TILE_SIZE + ( i / 4 ) % TILE_SIZE;
+        const unsigned int y = tile.y * TILE_SIZE + ( i / 4 ) / TILE_SIZE;
+        if( static_cast<unsigned char>( dest[i] ) != FileImage::texel( x, y, i % 4 ) )
+            return false;
+    }
+    return true;
+}
+
+// Read every tile of the image, returning false if any is wrong.
+bool readAllTiles( ImageSource& image )
+{
+    std::vector<char> dest( TILE_SIZE * TILE_SIZE * 4 );
+    for( unsigned int y = 0; y < 3; ++y )
+    {
+        for( unsigned int x = 0; x < 4; ++x )
+        {
+            const Tile tile{ x, y, TILE_SIZE, TILE_SIZE };
+            if( !image.readTile( dest.data(), 0, tile, nullptr ) || !tileMatches( dest, tile ) )
+                return false;
+        }
+    }
+    return true;
+}
+
+#ifndef _WIN32
+int removeEntry( const char* path, const struct stat* /*status*/, int /*type*/, struct FTW* /*ftw*/ )
+{
+    return std::remove( path );
+}
+#endif
+
+class TestTileDiskCache : public testing::Test
+{
+  public:
+    void SetUp() override
+    {
+        std::ofstream( m_imageFilename ) << "image";
+        m_options.directory = m_directory;
+    }
+
+    void TearDown() override
+    {
+        std::remove( m_imageFilename.c_str() );
+#ifndef _WIN32
+        nftw( m_directory.c_str(), removeEntry, 16, FTW_DEPTH | FTW_PHYS );
+#endif
+    }
+
+  protected:
+    const std::string    m_directory{ "TestTileDiskCache.dir" };
+    const std::string    m_imageFilename{ "TestTileDiskCache.img" };
+    TileDiskCacheOptions m_options;
+
+    ImageHash key( unsigned long long value ) const { return ImageHash{ value, ~value }; }
+};
+
+}  // namespace
+
+TEST_F( TestTileDiskCache, readsTilesWrittenByEarlierRun )
+{
+    {
+        auto                  cache = std::make_shared<TileDiskCache>( m_options );
+        auto                  image = std::make_shared<FileImage>( m_imageFilename );
+        DiskCachedImageSource cached( image, cache );
+        cached.open( nullptr );
+        ASSERT_TRUE( cached.isCaching() );
+        EXPECT_TRUE( readAllTiles( cached ) );
+        EXPECT_EQ( 12U, image->m_numTilesDecoded );
+        EXPECT_EQ( 12ULL, cache->getNumMisses() );
+    }
+
+    auto                  cache = std::make_shared<TileDiskCache>( m_options );
+    auto                  image = std::make_shared<FileImage>( m_imageFilename );
+    DiskCachedImageSource cached( image, cache );
+    cached.open( nullptr );
+    EXPECT_TRUE( readAllTiles( cached ) );
+    EXPECT_EQ( 0U, image->m_numTilesDecoded );
+    EXPECT_EQ( 12ULL, cache->getNumHits() );
+}
+
+TEST_F( TestTileDiskCache, passesThroughImagesWithoutFiles )
+{
+    auto                  image = std::make_shared<FileImage>( "" );
+    DiskCachedImageSource cached( image, std::make_shared<TileDiskCache>( m_options ) );
+    cached.open( nullptr );
+    EXPECT_FALSE( cached.isCaching() );
+    EXPECT_TRUE( readAllTiles( cached ) );
+    EXPECT_TRUE( readAllTiles( cached ) );
+    EXPECT_EQ( 24U, image->m_numTilesDecoded );
+}
+
+TEST_F( TestTileDiskCache, rejectsCorruptBlobs )
+{
+    TileDiskCache     cache( m_options );
+    std::vector<char> data( 1000, 'x' );
+    std::vector<char> dest( data.size() );
+    cache.write( key( 1 ), data.data(), data.size() );
+    ASSERT_TRUE( cache.read( key( 1 ), dest.data(), dest.size() ) );
+    EXPECT_EQ( data, dest );
+
+    // Flip a byte of the tile data.
+    {
+        std::fstream file( cache.getBlobPath( key( 1 ) ), std::ios::in | std::ios::out | std::ios::binary );
+        file.seekp( 500 );
+        file.put( 'y' );
+    }
+    EXPECT_FALSE( cache.read( key( 1 ), dest.data(), dest.size() ) );
+    EXPECT_EQ( 1ULL, cache.getNumCorruptBlobs() );
+    EXPECT_FALSE( std::ifstream( cache.getBlobPath( key( 1 ) ) ).good() );
+
+    // A request of a different size is a miss.
+    cache.write( key( 2 ), data.data(), data.size() );
+    EXPECT_FALSE( cache.read( key( 2 ), dest.data(), dest.size() - 1 ) );
+}
+
+TEST_F( TestTileDiskCache, cleanupRemovesLeastRecentlyUsedTiles )
+{
+    m_options.maxSize        = 10000;
+    m_options.maxPendingUses = 1;
+    TileDiskCache     cache( m_options );
+    std::vector<char> data( 1000, 'x' );
+    for( unsigned long long i = 0; i < 8; ++i )
+    {
+        cache.write( key( i ), data.data(), data.size() );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+    }
+    ASSERT_TRUE( cache.read( key( 0 ), data.data(), data.size() ) );
+    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+
+    // Two more tiles exceed the cache size, so the three least recently used are removed.
+    for( unsigned long long i = 8; i < 10; ++i )
+        cache.write( key( i ), data.data(), data.size() );
+    cache.cleanup();
+
+    EXPECT_TRUE( cache.read( key( 0 ), data.data(), data.size() ) );
+    for( unsigned long long i = 1; i < 4; ++i )
+        EXPECT_FALSE( cache.read( key( i ), data.data(), data.size() ) ) << i;
+    for( unsigned long long i = 4; i < 10; ++i )
+        EXPECT_TRUE( cache.read( key( i ), data.data(), data.size() ) ) << i;
+}
+
+TEST_F( TestTileDiskCache, keysTilesByFileVariant )
+{
+    auto                  cache = std::make_shared<TileDiskCache>( m_options );
+    auto                  red   = std::make_shared<FileImage>( m_imageFilename, "channels=R" );
+    auto                  green = std::make_shared<FileImage>( m_imageFilename, "channels=G" );
+    DiskCachedImageSource cachedRed( red, cache );
+    DiskCachedImageSource cachedGreen( green, cache );
+    cachedRed.open( nullptr );
+    cachedGreen.open( nullptr );
+    EXPECT_TRUE( readAllTiles( cachedRed ) );
+    EXPECT_TRUE( readAllTiles( cachedGreen ) );
+    EXPECT_EQ( 12U, red->m_numTilesDecoded );
+    EXPECT_EQ( 12U, green->m_numTilesDecoded );
+}
+
+TEST_F( TestTileDiskCache, cleanupMeasuresBlobsMissingFromIndex )
+{
+    std::vector<char> data( 1000, 'x' );
+    {
+        TileDiskCache cache( m_options );
+        for( unsigned long long i = 0; i < 10; ++i )
+            cache.write( key( i ), data.data(), data.size() );
+    }
+    // Lose the uses recorded by the writer, as if it was killed before recording them.
+    std::remove( ( m_directory + "/index" ).c_str() );
+
+    m_options.maxSize = 5000;
+    TileDiskCache cache( m_options );
+    cache.cleanup();
+    unsigned int numBlobs = 0;
+    for( unsigned long long i = 0; i < 10; ++i )
+        numBlobs += std::ifstream( cache.getBlobPath( key( i ) ) ).good() ? 1 : 0;
+    EXPECT_EQ( 3U, numBlobs );
+}
+
+#ifndef _WIN32
+TEST_F( TestTileDiskCache, cleanupRemovesAbandonedTempFiles )
+{
+    TileDiskCache     cache( m_options );
+    std::vector<char> data( 1000, 'x' );
+    cache.write( key( 1 ), data.data(), data.size() );
+
+    const std::string blobPath      = cache.getBlobPath( key( 1 ) );
+    const std::string abandonedPath = blobPath + ".1.0.tmp";
+    const std::string pendingPath   = blobPath + ".2.0.tmp";
+    std::ofstream( abandonedPath ) << "partial";
+    std::ofstream( pendingPath ) << "partial";
+    const time_t  dayAgo = time( nullptr ) - 24 * 3600;
+    const utimbuf times{ dayAgo, dayAgo };
+    ASSERT_EQ( 0, utime( abandonedPath.c_str(), &times ) );
+
+    cache.cleanup();
+    EXPECT_FALSE( std::ifstream( abandonedPath ).good() );
+    EXPECT_TRUE( std::ifstream( pendingPath ).good() );
+    EXPECT_TRUE( cache.read( key( 1 ), data.data(), data.size() ) );
+}
+
+TEST_F( TestTileDiskCache, sharesTilesAcrossProcesses )
+{
+    // Children read all the tiles concurrently, in different orders, so that some decode and
+    // write tiles while others read them.
+    const int        numChildren = 6;
+    std::vector<int> children;
+    for( int i = 0; i < numChildren; ++i )
+    {
+        const pid_t pid = fork();
+        if( pid == 0 )
+        {
+            bool ok = true;
+            {
+                m_options.maxPendingUses = 4;
+                auto                  cache = std::make_shared<TileDiskCache>( m_options );
+                DiskCachedImageSource cached( std::make_shared<FileImage>( m_imageFilename ), cache );
+                cached.open( nullptr );
+                std::vector<char> dest( TILE_SIZE * TILE_SIZE * 4 );
+                for( unsigned int pass = 0; pass < 20 && ok; ++pass )
+                {
+                    for( unsigned int j = 0; j < 12 && ok; ++j )
+                    {
+                        const unsigned int index = ( j * 5 + i + pass ) % 12;
+                        const Tile         tile{ index % 4, index / 4, TILE_SIZE, TILE_SIZE };
+                        ok = cached.readTile( dest.data(), 0, tile, nullptr ) && tileMatches( dest, tile );
+                    }
+                }
+                ok = ok && cache->getNumCorruptBlobs() == 0;
+            }
+            _exit( ok ? 0 : 1 );
+        }
+        ASSERT_GT( pid, 0 );
+        children.push_back( pid );
+    }
+    for( int pid : children )
+    {
+        int status = 0;
+        ASSERT_EQ( pid, waitpid( pid, &status, 0 ) );
+        EXPECT_TRUE( WIFEXITED( status ) && WEXITSTATUS( status ) == 0 );
+    }
+
+    // Every tile is now cached, and the index is intact.
+    auto                  cache = std::make_shared<TileDiskCache>( m_options );
+    auto                  image = std::make_shared<FileImage>( m_imageFilename );
+    DiskCachedImageSource cached( image, cache );
+    cached.open( nullptr );
+    EXPECT_TRUE( readAllTiles( cached ) );
+    EXPECT_EQ( 0U, image->m_numTilesDecoded );
+    cache->cleanup();
+    EXPECT_TRUE( readAllTiles( cached ) );
+    EXPECT_EQ( 0U, image->m_numTilesDecoded );
+}
+#endif
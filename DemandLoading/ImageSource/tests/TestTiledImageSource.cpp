@@ -13,6 +13,9 @@
 #include <gmock/gmock.h>
 
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
 
 using namespace testing;
 
@@ -354,6 +357,29 @@ TEST_F( TestTiledImageSource, readMipTailReadsMipLevels )
                                             pixelSizeInBytes, m_stream ) );
 }
 
+TEST_F( TestTiledImageSource, readMipTailAdvancesByBlocks )
+{
+    // Block-compressed textures pass a pixel size of zero, so the level offsets follow from the format.
+    m_baseInfo.format      = CU_AD_FORMAT_BC1_UNORM;
+    m_baseInfo.numChannels = 4;
+    ExpectationSet open{ expectOpen() };
+    create();
+    const unsigned int numMipLevels{ 5 };
+    std::vector<uint2> mipLevelDims;
+    std::vector<char>  dest( 256 );
+    size_t             offset = 0;
+    for( unsigned int i = 0, size = 16; i < numMipLevels; ++i, size /= 2 )
+    {
+        mipLevelDims.push_back( make_uint2( size, size ) );
+        EXPECT_CALL( *m_baseImage, readMipLevel( dest.data() + offset, i, size, size, m_stream ) ).WillOnce( Return( true ) );
+        offset += imageSource::getImageSizeInBytes( m_baseInfo.format, m_baseInfo.numChannels, size, size );
+    }
+    m_tiledImage->open( nullptr );
+
+    EXPECT_TRUE( m_tiledImage->readMipTail( dest.data(), 0, numMipLevels, mipLevelDims.data(), /*pixelSizeInBytes=*/0, m_stream ) );
+    EXPECT_EQ( 128U + 32U + 3 * 8U, offset );
+}
+
 TEST_F( TestTiledImageSource, tracksTileReadCount )
 {
     ExpectationSet open{ expectOpen() };
@@ -432,3 +458,137 @@ TEST_F( TestTiledImageSourcePassThrough, getNumTilesRead )
 
     EXPECT_EQ( 13, m_tiledImage->getNumTilesRead() );
 }
+
+namespace {
+
+// Untiled RGBA8 image that can read partial mip levels, as a scanline EXR can.  Each texel holds
+// its coordinates.
+class ScanlineImage : public imageSource::ImageSourceBase
+{
+  public:
+    ScanlineImage( unsigned int width, unsigned int height )
+    {
+        m_info.width        = width;
+        m_info.height       = height;
+        m_info.format       = CU_AD_FORMAT_UNSIGNED_INT8;
+        m_info.numChannels  = 4;
+        m_info.numMipLevels = 1;
+        m_info.isValid      = true;
+        m_info.isTiled      = false;
+    }
+
+    static std::array<unsigned char, 4> texel( unsigned int x, unsigned int y )
+    {
+        return { static_cast<unsigned char>( x ), static_cast<unsigned char>( x >> 8 ), static_cast<unsigned char>( y ),
+                 static_cast<unsigned char>( y >> 8 ) };
+    }
+
+    void open( imageSource::TextureInfo* info ) override
+    {
+        m_isOpen = true;
+        if( info != nullptr )
+            *info = m_info;
+    }
+    void                            close() override { m_isOpen = false; }
+    bool                            isOpen() const override { return m_isOpen; }
+    const imageSource::TextureInfo& getInfo() const override { return m_info; }
+    CUmemorytype                    getFillType() const override { return CU_MEMORYTYPE_HOST; }
+    bool readTile( char* /*dest*/, unsigned int /*mipLevel*/, const imageSource::Tile& /*tile*/, CUstream /*stream*/ ) override
+    {
+        return false;
+    }
+    bool readMipLevel( char* dest, unsigned int mipLevel, unsigned int /*width*/, unsigned int /*height*/, CUstream stream ) override
+    {
+        return readScanlines( dest, mipLevel, 0, m_info.height, stream );
+    }
+    bool readBaseColor( float4& /*dest*/ ) override { return false; }
+
+    bool readScanlines( char* dest, unsigned int /*mipLevel*/, unsigned int firstRow, unsigned int numRows, CUstream /*stream*/ ) override
+    {
+        for( unsigned int y = firstRow; y < std::min( firstRow + numRows, m_info.height ); ++y )
+        {
+            for( unsigned int x = 0; x < m_info.width; ++x )
+            {
+                const std::array<unsigned char, 4> value = texel( x, y );
+                dest = std::copy( value.begin(), value.end(), dest );
+            }
+        }
+        m_numRowsRead += numRows;
+        return true;
+    }
+    unsigned int getScanlineChunkHeight() const override { return 16; }
+
+    unsigned int m_numRowsRead = 0;
+
+  private:
+    imageSource::TextureInfo m_info{};
+    bool                     m_isOpen = false;
+};
+
+std::array<unsigned char, 4> getTexel( const std::vector<char>& texels, unsigned int x, unsigned int y, unsigned int width )
+{
+    std::array<unsigned char, 4> result;
+    std::copy_n( &texels[( y * width + x ) * 4], 4, result.begin() );
+    return result;
+}
+
+}  // namespace
+
+TEST( TestTiledImageSourceStreaming, readsTilesFromCachedBands )
+{
+    auto                          base = std::make_shared<ScanlineImage>( 500, 1000 );
+    imageSource::TiledImageSource tiledImage( base, /*maxCachedBands=*/2 );
+    imageSource::TextureInfo      info{};
+    tiledImage.open( &info );
+    ASSERT_TRUE( tiledImage.isStreaming() );
+    EXPECT_TRUE( info.isTiled );
+    EXPECT_EQ( 1U, info.numMipLevels );
+
+    // Read every tile, including partial tiles at the right and bottom edges.
+    std::vector<char> dest( 64 * 64 * 4 );
+    for( unsigned int tileY = 0; tileY < 16; ++tileY )
+    {
+        for( unsigned int tileX = 0; tileX < 8; ++tileX )
+        {
+            const imageSource::Tile tile{ tileX, tileY, 64, 64 };
+            ASSERT_TRUE( tiledImage.readTile( dest.data(), 0, tile, nullptr ) );
+            for( unsigned int y = 0; y < 64 && tileY * 64 + y < info.height; ++y )
+            {
+                for( unsigned int x = 0; x < 64 && tileX * 64 + x < info.width; ++x )
+                    ASSERT_EQ( ScanlineImage::texel( tileX * 64 + x, tileY * 64 + y ), getTexel( dest, x, y, 64 ) );
+            }
+        }
+        EXPECT_LE( tiledImage.getNumCachedBands(), 2U );
+    }
+
+    // Each band was decoded once, since the tiles were read a row at a time.
+    EXPECT_EQ( info.height, base->m_numRowsRead );
+    EXPECT_EQ( 128ULL, tiledImage.getNumTilesRead() );
+}
+
+TEST( TestTiledImageSourceStreaming, buildsCoarserLevelsFromBands )
+{
+    auto                          base = std::make_shared<ScanlineImage>( 256, 200 );
+    imageSource::TiledImageSource tiledImage( base, /*maxCachedBands=*/3, /*buildMipLevels=*/true );
+    imageSource::TextureInfo      info{};
+    tiledImage.open( &info );
+    ASSERT_EQ( 9U, info.numMipLevels );
+
+    // Levels are point sampled from the next finer level.
+    std::vector<char> level2( 64 * 50 * 4 );
+    ASSERT_TRUE( tiledImage.readMipLevel( level2.data(), 2, 64, 50, nullptr ) );
+    for( unsigned int y = 0; y < 50; ++y )
+    {
+        for( unsigned int x = 0; x < 64; ++x )
+            ASSERT_EQ( ScanlineImage::texel( x * 4, y * 4 ), getTexel( level2, x, y, 64 ) );
+    }
+
+    std::vector<char> tile( 64 * 64 * 4 );
+    ASSERT_TRUE( tiledImage.readTile( tile.data(), 1, imageSource::Tile{ 1, 1, 64, 64 }, nullptr ) );
+    for( unsigned int y = 0; y < 36; ++y )
+    {
+        for( unsigned int x = 0; x < 64; ++x )
+            ASSERT_EQ( ScanlineImage::texel( ( 64 + x ) * 2, ( 64 + y ) * 2 ), getTexel( tile, x, y, 64 ) );
+    }
+    EXPECT_LE( tiledImage.getNumCachedBands(), 3U );
+}
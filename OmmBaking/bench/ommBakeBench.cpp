@@ -0,0 +1,777 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+// Benchmark of Opacity Micromap baking over glTF scenes with alpha textures.
+//
+// All alpha masked and alpha blended mesh primitives of a scene are baked together, once per combination of
+// the requested formats and subdivision scales. The base color alpha of each primitive is converted to an
+// opacity state texture. Per bake, the stage timings reported by BakeOptions::stageCallback, the
+// de-duplication ratio, the output size and the fraction of unknown micro-triangle states are written as JSON.
+
+#include <OptiXToolkit/CuOmmBaking/CuBuffer.h>
+#include <OptiXToolkit/CuOmmBaking/CuOmmBaking.h>
+
+#include <cuda_runtime.h>
+
+#ifdef _MSC_VER
+#define STBI_MSC_SECURE_CRT
+#endif
+
+#define TINYGLTF_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <tinygltf/tiny_gltf.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using Json = nlohmann::json;
+
+const uint32_t NUM_STAGES = ( uint32_t )cuOmmBaking::BakeStage::MAX_NUM;
+
+const char* const STAGE_NAMES[NUM_STAGES] = { "setup", "sort", "assignment", "layout", "evaluation" };
+
+// Check status returned by a CUDA call.
+inline void check( cudaError_t status )
+{
+    if( status != cudaSuccess )
+        throw std::runtime_error( cudaGetErrorString( status ) );
+}
+
+// Check status returned by a CuOmmBaking call.
+inline void check( cuOmmBaking::Result status )
+{
+    if( status != cuOmmBaking::Result::SUCCESS )
+        throw std::runtime_error( "Omm baking failure." );
+}
+
+// Buffer in host memory for host baking, or in device memory for device baking.
+class Buffer
+{
+  public:
+    void alloc( size_t sizeInBytes, bool onDevice )
+    {
+        m_onDevice    = onDevice;
+        m_sizeInBytes = sizeInBytes;
+        if( onDevice )
+            check( m_device.alloc( sizeInBytes ) );
+        else
+            m_host.assign( ( sizeInBytes + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ), 0 );  // 8 byte aligned
+    }
+
+    void allocAndUpload( const void* data, size_t sizeInBytes, bool onDevice )
+    {
+        alloc( sizeInBytes, onDevice );
+        if( onDevice )
+            check( m_device.upload( static_cast<const unsigned char*>( data ) ) );
+        else if( sizeInBytes )
+            memcpy( m_host.data(), data, sizeInBytes );
+    }
+
+    CUdeviceptr get() const { return m_onDevice ? m_device.get() : reinterpret_cast<CUdeviceptr>( m_host.data() ); }
+
+    size_t sizeInBytes() const { return m_sizeInBytes; }
+
+    template <typename T>
+    std::vector<T> download() const
+    {
+        std::vector<T> data( m_sizeInBytes / sizeof( T ) );
+        if( m_onDevice )
+            check( cudaMemcpy( data.data(), reinterpret_cast<const void*>( m_device.get() ), data.size() * sizeof( T ), cudaMemcpyDeviceToHost ) );
+        else if( !data.empty() )
+            memcpy( data.data(), m_host.data(), data.size() * sizeof( T ) );
+        return data;
+    }
+
+  private:
+    bool                    m_onDevice    = false;
+    size_t                  m_sizeInBytes = 0;
+    std::vector<uint64_t>   m_host;
+    CuBuffer<unsigned char> m_device;
+};
+
+// Bake inputs of a scene in host memory.
+struct Scene
+{
+    struct Texture
+    {
+        std::vector<uint32_t>  states;
+        uint32_t               width  = 0;
+        uint32_t               height = 0;
+        cudaTextureAddressMode addressMode[2];
+        float                  filterKernelWidthInTexels;
+    };
+
+    struct Primitive
+    {
+        std::vector<float2> texCoords;
+        std::vector<uint3>  indices;
+        uint32_t            texture;
+    };
+
+    std::vector<Texture>   textures;
+    std::vector<Primitive> primitives;
+
+    uint32_t numTriangles() const
+    {
+        uint32_t numTriangles = 0;
+        for( const Primitive& primitive : primitives )
+            numTriangles += ( uint32_t )primitive.indices.size();
+        return numTriangles;
+    }
+};
+
+cudaTextureAddressMode toAddressMode( int wrap )
+{
+    switch( wrap )
+    {
+        case TINYGLTF_TEXTURE_WRAP_CLAMP_TO_EDGE:
+            return cudaAddressModeClamp;
+        case TINYGLTF_TEXTURE_WRAP_MIRRORED_REPEAT:
+            return cudaAddressModeMirror;
+        default:
+            return cudaAddressModeWrap;
+    }
+}
+
+// Read element i of an accessor as floats, converting normalized integer components.
+void readFloats( const tinygltf::Model& model, const tinygltf::Accessor& accessor, size_t i, float* out, int numComponents )
+{
+    const tinygltf::BufferView& view   = model.bufferViews[accessor.bufferView];
+    const unsigned char*        data   = model.buffers[view.buffer].data.data() + view.byteOffset + accessor.byteOffset;
+    const int                   stride = accessor.ByteStride( view );
+    if( stride <= 0 )
+        throw std::runtime_error( "Invalid texture coordinate accessor." );
+
+    const unsigned char* elem = data + i * stride;
+
+    for( int c = 0; c < numComponents; ++c )
+    {
+        switch( accessor.componentType )
+        {
+            case TINYGLTF_COMPONENT_TYPE_FLOAT:
+                memcpy( &out[c], elem + c * sizeof( float ), sizeof( float ) );
+                break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                out[c] = elem[c] / 255.f;
+                break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+                uint16_t value;
+                memcpy( &value, elem + c * sizeof( uint16_t ), sizeof( uint16_t ) );
+                out[c] = value / 65535.f;
+            }
+            break;
+            default:
+                throw std::runtime_error( "Unsupported texture coordinate component type." );
+        }
+    }
+}
+
+// Read element i of an index accessor.
+uint32_t readIndex( const tinygltf::Model& model, const tinygltf::Accessor& accessor, size_t i )
+{
+    const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+    const unsigned char* elem = model.buffers[view.buffer].data.data() + view.byteOffset + accessor.byteOffset + i * accessor.ByteStride( view );
+
+    switch( accessor.componentType )
+    {
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return *elem;
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+            uint16_t value;
+            memcpy( &value, elem, sizeof( value ) );
+            return value;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: {
+            uint32_t value;
+            memcpy( &value, elem, sizeof( value ) );
+            return value;
+        }
+        default:
+            throw std::runtime_error( "Unsupported index component type." );
+    }
+}
+
+// Convert the alpha of an image to opacity states. Masked alpha is either transparent or opaque,
+// blended alpha is unknown unless fully transparent or fully opaque.
+Scene::Texture createStateTexture( const tinygltf::Model& model, const tinygltf::Material& material, const tinygltf::Texture& texture )
+{
+    const tinygltf::Image& image = model.images[texture.source];
+    if( image.image.empty() || image.width <= 0 || image.height <= 0 )
+        throw std::runtime_error( "Image " + image.uri + " is not loaded." );
+
+    const bool   mask        = ( material.alphaMode == "MASK" );
+    const float  cutoff      = ( float )material.alphaCutoff;
+    const float  alphaFactor = material.pbrMetallicRoughness.baseColorFactor.size() == 4 ? ( float )material.pbrMetallicRoughness.baseColorFactor[3] : 1.f;
+    const size_t bytesPerComponent = image.bits / 8;
+
+    Scene::Texture result;
+    result.width  = ( uint32_t )image.width;
+    result.height = ( uint32_t )image.height;
+    // tightly packed rows of 2 bit states
+    result.states.assign( ( 2 * ( size_t )result.width * result.height + 31 ) / 32, 0 );
+
+    for( uint32_t y = 0; y < result.height; ++y )
+    {
+        for( uint32_t x = 0; x < result.width; ++x )
+        {
+            float alpha = 1.f;
+            if( image.component == 4 )
+            {
+                const unsigned char* texel = image.image.data() + ( ( size_t )y * result.width + x ) * 4 * bytesPerComponent;
+                if( bytesPerComponent == 1 )
+                    alpha = texel[3] / 255.f;
+                else
+                {
+                    uint16_t value;
+                    memcpy( &value, texel + 3 * bytesPerComponent, sizeof( value ) );
+                    alpha = value / 65535.f;
+                }
+            }
+            alpha *= alphaFactor;
+
+            cuOmmBaking::OpacityState state;
+            if( mask )
+                state = ( alpha >= cutoff ) ? cuOmmBaking::OpacityState::STATE_OPAQUE : cuOmmBaking::OpacityState::STATE_TRANSPARENT;
+            else if( alpha <= 0.f )
+                state = cuOmmBaking::OpacityState::STATE_TRANSPARENT;
+            else if( alpha >= 1.f )
+                state = cuOmmBaking::OpacityState::STATE_OPAQUE;
+            else
+                state = cuOmmBaking::OpacityState::STATE_UNKNOWN;
+
+            const size_t bit = 2 * ( ( size_t )y * result.width + x );
+            result.states[bit / 32] |= ( uint32_t )state << ( bit & 31 );
+        }
+    }
+
+    tinygltf::Sampler sampler;
+    if( texture.sampler >= 0 )
+        sampler = model.samplers[texture.sampler];
+    result.addressMode[0]            = toAddressMode( sampler.wrapS );
+    result.addressMode[1]            = toAddressMode( sampler.wrapT );
+    result.filterKernelWidthInTexels = ( sampler.magFilter == TINYGLTF_TEXTURE_FILTER_NEAREST ) ? 0.f : 1.f;
+
+    return result;
+}
+
+// Load the alpha textured triangle primitives of a glTF scene.
+Scene loadScene( const std::string& path )
+{
+    tinygltf::Model    model;
+    tinygltf::TinyGLTF loader;
+    std::string        err, warn;
+
+    const bool binary = std::filesystem::path( path ).extension() == ".glb";
+    const bool loaded = binary ? loader.LoadBinaryFromFile( &model, &err, &warn, path ) : loader.LoadASCIIFromFile( &model, &err, &warn, path );
+    if( !loaded )
+        throw std::runtime_error( "Failed to load " + path + ": " + err );
+
+    Scene scene;
+
+    // state textures are shared by primitives with the same material
+    std::map<int, uint32_t> materialTextures;
+
+    for( const tinygltf::Mesh& mesh : model.meshes )
+    {
+        for( const tinygltf::Primitive& primitive : mesh.primitives )
+        {
+            if( primitive.mode != TINYGLTF_MODE_TRIANGLES || primitive.material < 0 )
+                continue;
+
+            const tinygltf::Material&    material = model.materials[primitive.material];
+            const tinygltf::TextureInfo& info     = material.pbrMetallicRoughness.baseColorTexture;
+            if( material.alphaMode == "OPAQUE" || info.index < 0 )
+                continue;
+
+            const auto texCoordAttribute = primitive.attributes.find( "TEXCOORD_" + std::to_string( info.texCoord ) );
+            if( texCoordAttribute == primitive.attributes.end() )
+                continue;
+
+            const tinygltf::Accessor& texCoordAccessor = model.accessors[texCoordAttribute->second];
+            if( texCoordAccessor.sparse.isSparse || texCoordAccessor.bufferView < 0 )
+                throw std::runtime_error( "Sparse texture coordinates are not supported." );
+
+            Scene::Primitive result;
+
+            result.texCoords.resize( texCoordAccessor.count );
+            for( size_t i = 0; i < texCoordAccessor.count; ++i )
+                readFloats( model, texCoordAccessor, i, &result.texCoords[i].x, 2 );
+
+            if( primitive.indices >= 0 )
+            {
+                const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
+                if( indexAccessor.sparse.isSparse || indexAccessor.bufferView < 0 )
+                    throw std::runtime_error( "Sparse indices are not supported." );
+
+                for( size_t i = 0; i + 2 < indexAccessor.count; i += 3 )
+                    result.indices.push_back( { readIndex( model, indexAccessor, i ), readIndex( model, indexAccessor, i + 1 ), readIndex( model, indexAccessor, i + 2 ) } );
+            }
+            else
+            {
+                for( uint32_t i = 0; i + 2 < ( uint32_t )texCoordAccessor.count; i += 3 )
+                    result.indices.push_back( { i, i + 1, i + 2 } );
+            }
+
+            if( result.indices.empty() )
+                continue;
+
+            auto texture = materialTextures.find( primitive.material );
+            if( texture == materialTextures.end() )
+            {
+                scene.textures.push_back( createStateTexture( model, material, model.textures[info.index] ) );
+                texture = materialTextures.emplace( primitive.material, ( uint32_t )scene.textures.size() - 1 ).first;
+            }
+            result.texture = texture->second;
+
+            scene.primitives.push_back( std::move( result ) );
+        }
+    }
+
+    return scene;
+}
+
+// Accumulates the time spent per baking stage, using CUDA events for device bakes and the host clock for host bakes.
+class StageTimer
+{
+  public:
+    explicit StageTimer( bool onDevice )
+        : m_onDevice( onDevice )
+    {
+    }
+
+    ~StageTimer()
+    {
+        for( cudaEvent_t event : m_events )
+            cudaEventDestroy( event );
+    }
+
+    static void callback( cuOmmBaking::BakeStage stage, bool end, cudaStream_t stream, void* userData )
+    {
+        static_cast<StageTimer*>( userData )->record( ( uint32_t )stage, end, stream );
+    }
+
+    // Milliseconds per stage, accumulated over all bakes since the last reset. Synchronizes with the device.
+    std::array<double, NUM_STAGES> getMilliseconds()
+    {
+        for( const Interval& interval : m_intervals )
+        {
+            float ms = 0.f;
+            check( cudaEventSynchronize( interval.end ) );
+            check( cudaEventElapsedTime( &ms, interval.begin, interval.end ) );
+            m_milliseconds[interval.stage] += ms;
+        }
+        m_intervals.clear();
+        m_numEventsUsed = 0;
+        return m_milliseconds;
+    }
+
+    void reset()
+    {
+        m_milliseconds.fill( 0 );
+        m_intervals.clear();
+        m_numEventsUsed = 0;
+    }
+
+  private:
+    struct Interval
+    {
+        uint32_t    stage;
+        cudaEvent_t begin;
+        cudaEvent_t end;
+    };
+
+    void record( uint32_t stage, bool end, cudaStream_t stream )
+    {
+        if( !m_onDevice )
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if( end )
+                m_milliseconds[stage] += std::chrono::duration<double, std::milli>( now - m_hostBegin[stage] ).count();
+            else
+                m_hostBegin[stage] = now;
+            return;
+        }
+
+        cudaEvent_t event = nextEvent();
+        check( cudaEventRecord( event, stream ) );
+        if( end )
+            m_intervals.push_back( { stage, m_deviceBegin[stage], event } );
+        else
+            m_deviceBegin[stage] = event;
+    }
+
+    // events are reused across bakes once their intervals are collected
+    cudaEvent_t nextEvent()
+    {
+        if( m_numEventsUsed == m_events.size() )
+        {
+            cudaEvent_t event;
+            check( cudaEventCreate( &event ) );
+            m_events.push_back( event );
+        }
+        return m_events[m_numEventsUsed++];
+    }
+
+    bool                                                  m_onDevice;
+    std::array<double, NUM_STAGES>                        m_milliseconds = {};
+    std::array<std::chrono::steady_clock::time_point, NUM_STAGES> m_hostBegin;
+    std::array<cudaEvent_t, NUM_STAGES>                   m_deviceBegin = {};
+    std::vector<cudaEvent_t>                              m_events;
+    size_t                                                m_numEventsUsed = 0;
+    std::vector<Interval>                                 m_intervals;
+};
+
+struct BenchOptions
+{
+    bool                                    host = false;
+    int                                     iterations = 3;
+    std::vector<float>                      subdivisionScales = { 0.5f, 1.f, 2.f };
+    std::vector<OptixOpacityMicromapFormat> formats = { OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE, OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE };
+};
+
+// Bake a scene with the given format and subdivision scale, and report the timings and output statistics.
+Json benchmark( const Scene& scene, const BenchOptions& bench, OptixOpacityMicromapFormat format, float subdivisionScale )
+{
+    const bool onDevice = !bench.host;
+
+    // upload the inputs
+    std::vector<Buffer> textureBuffers( scene.textures.size() );
+    std::vector<Buffer> texCoordBuffers( scene.primitives.size() ), indexBuffers( scene.primitives.size() );
+    std::vector<cuOmmBaking::TextureDesc>   textures( scene.primitives.size() );
+    std::vector<cuOmmBaking::BakeInputDesc> inputs( scene.primitives.size() );
+
+    for( size_t i = 0; i < scene.textures.size(); ++i )
+        textureBuffers[i].allocAndUpload( scene.textures[i].states.data(), scene.textures[i].states.size() * sizeof( uint32_t ), onDevice );
+
+    for( size_t i = 0; i < scene.primitives.size(); ++i )
+    {
+        const Scene::Primitive& primitive = scene.primitives[i];
+        const Scene::Texture&   texture   = scene.textures[primitive.texture];
+
+        texCoordBuffers[i].allocAndUpload( primitive.texCoords.data(), primitive.texCoords.size() * sizeof( float2 ), onDevice );
+        indexBuffers[i].allocAndUpload( primitive.indices.data(), primitive.indices.size() * sizeof( uint3 ), onDevice );
+
+        cuOmmBaking::TextureDesc& desc         = textures[i];
+        desc                                   = {};
+        desc.type                              = cuOmmBaking::TextureType::STATE;
+        desc.state.width                       = texture.width;
+        desc.state.height                      = texture.height;
+        desc.state.pitchInBits                 = 2 * texture.width;
+        desc.state.stateBuffer                 = textureBuffers[primitive.texture].get();
+        desc.state.filterKernelWidthInTexels   = texture.filterKernelWidthInTexels;
+        desc.state.addressMode[0]              = texture.addressMode[0];
+        desc.state.addressMode[1]              = texture.addressMode[1];
+
+        cuOmmBaking::BakeInputDesc& input = inputs[i];
+        input                             = {};
+        input.texCoordFormat              = cuOmmBaking::TexCoordFormat::UV32_FLOAT2;
+        input.texCoordBuffer              = texCoordBuffers[i].get();
+        input.numTexCoords                = ( unsigned )primitive.texCoords.size();
+        input.indexFormat                 = cuOmmBaking::IndexFormat::I32_UINT;
+        input.indexBuffer                 = indexBuffers[i].get();
+        input.numIndexTriplets            = ( unsigned )primitive.indices.size();
+        input.numTextures                 = 1;
+        input.textures                    = &textures[i];
+    }
+
+    StageTimer timer( onDevice );
+
+    cuOmmBaking::BakeOptions options = {};
+    options.flags                    = cuOmmBaking::BakeFlags::ENABLE_POST_BAKE_INFO;
+    if( bench.host )
+        options.flags = options.flags | cuOmmBaking::BakeFlags::BAKE_ON_HOST;
+    options.format                = format;
+    options.subdivisionScale      = subdivisionScale;
+    options.stageCallback         = &StageTimer::callback;
+    options.stageCallbackUserData = &timer;
+
+    std::vector<cuOmmBaking::BakeInputBuffers> inputBuffers( inputs.size() );
+    cuOmmBaking::BakeBuffers                   buffers = {};
+
+    const auto preBakeBegin = std::chrono::steady_clock::now();
+    check( cuOmmBaking::GetPreBakeInfo( &options, ( unsigned )inputs.size(), inputs.data(), inputBuffers.data(), &buffers ) );
+    const double preBakeMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - preBakeBegin ).count();
+
+    Buffer data, descs, histogram, postBakeInfo, temp;
+    data.alloc( buffers.outputBufferSizeInBytes, onDevice );
+    descs.alloc( buffers.numMicromapDescs * sizeof( OptixOpacityMicromapDesc ), onDevice );
+    histogram.alloc( buffers.numMicromapHistogramEntries * sizeof( OptixOpacityMicromapHistogramEntry ), onDevice );
+    postBakeInfo.alloc( sizeof( cuOmmBaking::PostBakeInfo ), onDevice );
+    temp.alloc( buffers.tempBufferSizeInBytes, onDevice );
+
+    buffers.outputBuffer                   = data.get();
+    buffers.perMicromapDescBuffer          = descs.get();
+    buffers.micromapHistogramEntriesBuffer = histogram.get();
+    buffers.postBakeInfoBuffer             = postBakeInfo.get();
+    buffers.tempBuffer                     = temp.get();
+
+    std::vector<Buffer> indices( inputs.size() ), usageCounts( inputs.size() );
+    for( size_t i = 0; i < inputs.size(); ++i )
+    {
+        indices[i].alloc( inputBuffers[i].indexBufferSizeInBytes, onDevice );
+        usageCounts[i].alloc( inputBuffers[i].numMicromapUsageCounts * sizeof( OptixOpacityMicromapUsageCount ), onDevice );
+        inputBuffers[i].indexBuffer               = indices[i].get();
+        inputBuffers[i].micromapUsageCountsBuffer = usageCounts[i].get();
+    }
+
+    // the first bake warms up, the others are timed
+    double bakeMs = 0;
+    for( int i = 0; i <= bench.iterations; ++i )
+    {
+        if( i == 1 )
+            timer.reset();
+
+        const auto begin = std::chrono::steady_clock::now();
+        check( cuOmmBaking::BakeOpacityMicromaps( &options, ( unsigned )inputs.size(), inputs.data(), inputBuffers.data(), &buffers, 0 ) );
+        if( onDevice )
+            check( cudaDeviceSynchronize() );
+        if( i > 0 )
+            bakeMs += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - begin ).count();
+    }
+    const std::array<double, NUM_STAGES> stageMs = timer.getMilliseconds();
+
+    // output statistics
+    const cuOmmBaking::PostBakeInfo info = postBakeInfo.download<cuOmmBaking::PostBakeInfo>()[0];
+
+    const std::vector<uint8_t>                  ommData  = data.download<uint8_t>();
+    const std::vector<OptixOpacityMicromapDesc> ommDescs = descs.download<OptixOpacityMicromapDesc>();
+
+    uint64_t numMicroTriangles = 0, numUnknown = 0;
+    for( uint32_t i = 0; i < info.numMicromapDescs; ++i )
+    {
+        const OptixOpacityMicromapDesc& desc  = ommDescs[i];
+        const uint64_t                  count = 1ull << ( 2 * desc.subdivisionLevel );
+        numMicroTriangles += count;
+
+        // the 2-state format has no unknown states
+        if( format != OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE )
+            continue;
+
+        for( uint64_t j = 0; j < count; ++j )
+        {
+            const uint32_t state = ( ommData[desc.byteOffset + j / 4] >> ( 2 * ( j % 4 ) ) ) & 3;
+            if( state == OPTIX_OPACITY_MICROMAP_STATE_UNKNOWN_TRANSPARENT || state == OPTIX_OPACITY_MICROMAP_STATE_UNKNOWN_OPAQUE )
+                numUnknown++;
+        }
+    }
+
+    // triangles referencing an omm, rather than a predefined state
+    uint64_t numOmmTriangles = 0, indexBytes = 0;
+    for( size_t i = 0; i < inputs.size(); ++i )
+    {
+        indexBytes += indices[i].sizeInBytes();
+        if( buffers.indexFormat == cuOmmBaking::IndexFormat::I16_UINT )
+        {
+            for( int16_t index : indices[i].download<int16_t>() )
+                numOmmTriangles += ( index >= 0 );
+        }
+        else if( buffers.indexFormat == cuOmmBaking::IndexFormat::I32_UINT )
+        {
+            for( int32_t index : indices[i].download<int32_t>() )
+                numOmmTriangles += ( index >= 0 );
+        }
+    }
+
+    Json result;
+    result["format"]           = ( format == OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE ) ? 4 : 2;
+    result["subdivisionScale"] = subdivisionScale;
+    result["triangles"]        = scene.numTriangles();
+    result["ommTriangles"]     = numOmmTriangles;
+    result["omms"]             = info.numMicromapDescs;
+    result["dedupRatio"]       = info.numMicromapDescs ? ( double )numOmmTriangles / info.numMicromapDescs : 0.;
+    result["outputBytes"]      = info.compactedSizeInBytes;
+    result["descBytes"]        = ( uint64_t )info.numMicromapDescs * sizeof( OptixOpacityMicromapDesc );
+    result["indexBytes"]       = indexBytes;
+    result["tempBytes"]        = buffers.tempBufferSizeInBytes;
+    result["microTriangles"]   = numMicroTriangles;
+    result["unknownFraction"]  = numMicroTriangles ? ( double )numUnknown / numMicroTriangles : 0.;
+
+    Json& timings          = result["timingsMs"];
+    timings["preBakeInfo"] = preBakeMs;
+    for( uint32_t stage = 0; stage < NUM_STAGES; ++stage )
+        timings[STAGE_NAMES[stage]] = bench.iterations ? stageMs[stage] / bench.iterations : 0.;
+    timings["bake"] = bench.iterations ? bakeMs / bench.iterations : 0.;
+
+    return result;
+}
+
+// glTF files in a file or directory path, in sorted order.
+std::vector<std::string> findScenes( const std::string& path )
+{
+    std::vector<std::string> scenes;
+
+    auto isScene = []( const std::filesystem::path& file ) { return file.extension() == ".gltf" || file.extension() == ".glb"; };
+
+    if( std::filesystem::is_directory( path ) )
+    {
+        for( const auto& entry : std::filesystem::recursive_directory_iterator( path ) )
+            if( entry.is_regular_file() && isScene( entry.path() ) )
+                scenes.push_back( entry.path().string() );
+        std::sort( scenes.begin(), scenes.end() );
+    }
+    else if( isScene( path ) )
+        scenes.push_back( path );
+    else
+        throw std::runtime_error( "Not a glTF scene or directory: " + path );
+
+    return scenes;
+}
+
+template <typename T, typename Parse>
+std::vector<T> parseList( const std::string& list, const Parse& parse )
+{
+    std::vector<T>     values;
+    std::istringstream stream( list );
+    std::string        item;
+    while( std::getline( stream, item, ',' ) )
+        values.push_back( parse( item ) );
+    return values;
+}
+
+void printUsageAndExit( const char* argv0 )
+{
+    // clang-format off
+    std::cerr
+        << "\nUsage  : " << argv0 << " [options] <scene.gltf|scene.glb|directory>...\n"
+        << "Options: --help | -h                         Print this usage message\n"
+        << "         --host                              Bake on host threads (BakeFlags::BAKE_ON_HOST). No CUDA device is used.\n"
+        << "         --scales <s0,s1,...>                Subdivision scales to bake with (default 0.5,1,2).\n"
+        << "         --formats <f0,f1,...>               Formats to bake with, 2 or 4 state (default 2,4).\n"
+        << "         --iterations | -i <n>               Number of timed bakes per setting, after one warm up bake (default 3).\n"
+        << "         --output | -o <filename>            Write the JSON report to a file instead of stdout.\n"
+        << "\n";
+    // clang-format on
+    exit( 1 );
+}
+
+}  // namespace
+
+int main( int argc, char* argv[] )
+{
+    BenchOptions             bench;
+    std::string              outputFile;
+    std::vector<std::string> paths;
+
+    for( int i = 1; i < argc; ++i )
+    {
+        const std::string arg( argv[i] );
+        bool              lastArg = ( i == argc - 1 );
+
+        if( arg == "--help" || arg == "-h" )
+        {
+            printUsageAndExit( argv[0] );
+        }
+        else if( arg == "--host" )
+        {
+            bench.host = true;
+        }
+        else if( arg == "--scales" && !lastArg )
+        {
+            bench.subdivisionScales = parseList<float>( argv[++i], []( const std::string& item ) { return std::stof( item ); } );
+        }
+        else if( arg == "--formats" && !lastArg )
+        {
+            bench.formats = parseList<OptixOpacityMicromapFormat>( argv[++i], []( const std::string& item ) {
+                return ( std::stoi( item ) == 2 ) ? OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE : OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE;
+            } );
+        }
+        else if( ( arg == "--iterations" || arg == "-i" ) && !lastArg )
+        {
+            bench.iterations = std::max( 0, std::stoi( argv[++i] ) );
+        }
+        else if( ( arg == "--output" || arg == "-o" ) && !lastArg )
+        {
+            outputFile = argv[++i];
+        }
+        else if( arg.size() > 1 && arg[0] == '-' )
+        {
+            std::cerr << "Unknown option '" << arg << "'\n";
+            printUsageAndExit( argv[0] );
+        }
+        else
+        {
+            paths.push_back( arg );
+        }
+    }
+
+    if( paths.empty() )
+        printUsageAndExit( argv[0] );
+
+    try
+    {
+        Json report;
+        report["bakeOnHost"] = bench.host;
+        report["iterations"] = bench.iterations;
+
+        if( !bench.host )
+        {
+            int            device;
+            cudaDeviceProp props;
+            check( cudaFree( nullptr ) );
+            check( cudaGetDevice( &device ) );
+            check( cudaGetDeviceProperties( &props, device ) );
+            report["device"] = props.name;
+        }
+
+        Json& results = report["scenes"];
+        results       = Json::array();
+
+        for( const std::string& path : paths )
+        {
+            for( const std::string& file : findScenes( path ) )
+            {
+                const auto  loadBegin = std::chrono::steady_clock::now();
+                const Scene scene     = loadScene( file );
+                const double loadMs   = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - loadBegin ).count();
+
+                Json sceneResult;
+                sceneResult["scene"]      = file;
+                sceneResult["loadMs"]     = loadMs;
+                sceneResult["primitives"] = scene.primitives.size();
+                sceneResult["textures"]   = scene.textures.size();
+                sceneResult["triangles"]  = scene.numTriangles();
+
+                Json& bakes = sceneResult["bakes"];
+                bakes       = Json::array();
+
+                if( scene.primitives.empty() )
+                    std::cerr << file << ": no alpha textured primitives\n";
+                else
+                {
+                    for( OptixOpacityMicromapFormat format : bench.formats )
+                        for( float subdivisionScale : bench.subdivisionScales )
+                            bakes.push_back( benchmark( scene, bench, format, subdivisionScale ) );
+                }
+
+                results.push_back( sceneResult );
+            }
+        }
+
+        if( outputFile.empty() )
+            std::cout << report.dump( 2 ) << std::endl;
+        else
+            std::ofstream( outputFile ) << report.dump( 2 ) << std::endl;
+    }
+    catch( const std::exception& e )
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -34,7 +34,14 @@ namespace cuOmmBaking {
     /// Flags used in BakeOptions::flags.
     enum class BakeFlags : uint32_t {
         NONE                  = 0u,
-        ENABLE_POST_BAKE_INFO = 1u << 1 ///< Baking will write post bake info.
+        ENABLE_POST_BAKE_INFO = 1u << 1, ///< Baking will write post bake info.
+        BAKE_ON_HOST          = 1u << 2, ///< Baking runs on host threads. All buffers passed to baking are in host memory.
+                                         ///< Only TextureType::STATE textures are supported. The results may differ slightly from device
+                                         ///< baking, see BakeOpacityMicromaps.
+        ADAPTIVE_SUBDIVISION  = 1u << 3  ///< Subdivision levels are assigned by opacity content rather than by area. Within the size limit,
+                                         ///< levels are raised where they resolve the most unknown micro-triangles per byte, so omms over
+                                         ///< uniform regions stay coarse and omms over opacity edges are refined. The subdivisionScale
+                                         ///< target remains an upper bound on the level.
     };
 
     // Define flag operators.
@@ -42,6 +49,32 @@ namespace cuOmmBaking {
     inline constexpr BakeFlags operator&( BakeFlags x, BakeFlags y ) { return static_cast< BakeFlags > ( static_cast< uint32_t >( x ) & static_cast< uint32_t >( y ) ); }
     inline constexpr BakeFlags operator~( BakeFlags x) { return static_cast< BakeFlags > ( ~static_cast< uint32_t >( x ) ); }
 
+    /// Stages of Opacity Micromap baking, reported to a BakeStageCallback.
+    enum class BakeStage : uint32_t
+    {
+        SETUP,       ///< Texture summed area table construction, input setup, uniform triangle detection and duplicate hashing.
+        SORT,        ///< Sorting triangles by their duplicate hash.
+        ASSIGNMENT,  ///< Duplicate detection and Opacity Micromap index assignment.
+        LAYOUT,      ///< Subdivision level assignment, Opacity Micromap byte offsets and histograms.
+        EVALUATION,  ///< Evaluation of the micro-triangle opacity states.
+
+        MAX_NUM
+    };
+
+    /// Instrumentation callback, called at the begin and the end of each baking stage.
+    ///
+    /// When baking on the device, the work of the stage is enqueued in stream between the begin and end calls,
+    /// so the stage can be timed by recording CUDA events in stream. With BakeFlags::BAKE_ON_HOST, stream is zero
+    /// and the work of the stage is complete at the end call. Batched baking reports the setup, sort and assignment
+    /// stages once per batch.
+    ///
+    /// \see BakeOptions::stageCallback
+    typedef void ( *BakeStageCallback )( BakeStage stage, bool end, cudaStream_t stream, void* userData );
+
+    /// Opaque handle to a persistent cache of baked Opacity Micromaps.
+    /// \see CreateBakeCache
+    struct BakeCache;
+
     /// This struct specifies options for Opacity Micromap baking.
     struct BakeOptions
     {
@@ -79,6 +112,37 @@ namespace cuOmmBaking {
         /// 
         /// If set to zero, no target subdivision level is used.
         float subdivisionScale = 0.5f;
+
+        /// Optional cache of previously baked Opacity Micromaps.
+        /// Opacity Micromaps found in the cache are copied instead of evaluated, and newly evaluated Opacity Micromaps are added to the cache.
+        /// Cached Opacity Micromaps are keyed by their texture coordinates, the contents and sampling parameters of their texture, 
+        /// their subdivision level and format. Triangles whose texture coordinates differ by a rotation of their vertices, 
+        /// or by whole texture periods under wrap or mirror addressing, share their cache entries. The Opacity Micromaps of
+        /// translated triangles may differ from their uncached bakes in a few micro triangles, due to rounding.
+        /// The cache is accessed on the host, so device bakes with a cache synchronize with the stream.
+        /// Inputs with TextureType::CUDA textures can not be baked with a cache.
+        ///
+        /// \see CreateBakeCache
+        BakeCache* cache = nullptr;
+
+        /// Maximum size of the temporary buffer in bytes.
+        /// If non-zero, the input triangles are processed in batches, sized such that BakeBuffers::tempBufferSizeInBytes does not exceed this limit.
+        /// Opacity Micromaps are de-duplicated across batches, so the outputs are identical to baking all triangles at once.
+        /// The de-duplication uses host memory proportional to the number of unique Opacity Micromaps.
+        /// The de-duplication is done on the host, so batched device bakes synchronize with the stream after each batch.
+        ///
+        /// If set to zero, all triangles are processed at once.
+        ///
+        /// \see BakeBuffers::tempBufferSizeInBytes
+        size_t maximumTempSizeInBytes = 0;
+
+        /// Optional instrumentation callback, called at the begin and end of each baking stage.
+        ///
+        /// \see BakeStageCallback
+        BakeStageCallback stageCallback = nullptr;
+
+        /// User data passed to stageCallback.
+        void* stageCallbackUserData = nullptr;
     };
 
     /// Format of texture coordinates used in BakeInputDesc::texCoordFormat.
@@ -463,6 +527,7 @@ namespace cuOmmBaking {
     /// This function is thread-safe. 
     /// This function does NOT execute any device tasks, does NOT access input/output device memory and does NOT synchronize with the device.
     /// Device buffers specified in BakeInputDesc may be left zero for this call.
+    /// With BakeFlags::BAKE_ON_HOST this function makes no CUDA calls.
     ///  
     /// \param[in]  options                 Baking options.
     /// \param[in]  numInputs               Number of elements in inputs (must be at least 1).
@@ -487,6 +552,10 @@ namespace cuOmmBaking {
     /// 
     /// This function is thread-safe. 
     /// This function does NOT synchronize with the device, all device tasks is executed asynchronously in the provided stream.
+    /// 
+    /// With BakeFlags::BAKE_ON_HOST, all input and output buffers are host memory, the baking runs synchronously on host threads
+    /// and the stream is ignored. The device code is compiled with fast math, so the host and device outputs
+    /// may differ in the states of micro triangles on opacity boundaries and in the subdivision levels of opacity micromaps.
     ///  
     /// \param[in] options            Baking options.
     /// \param[in] numInputs          Number of elements in inputs (must be at least 1).
@@ -502,4 +571,53 @@ namespace cuOmmBaking {
         const BakeBuffers*       buffers,
         cudaStream_t             stream = 0 );
 
+    /// This struct specifies options for creating a bake cache.
+    struct BakeCacheOptions
+    {
+        /// Path of the cache file. The file is created if it does not exist.
+        const char* path = nullptr;
+
+        /// Size of the cache file in bytes. When the cache is full, the oldest Opacity Micromaps are evicted.
+        /// Opening an existing cache file with a different size discards its contents.
+        unsigned long long sizeInBytes = 1ull << 30;
+    };
+
+    /// Cache statistics, accumulated since the cache was created.
+    struct BakeCacheStatistics
+    {
+        unsigned long long numHits;       ///< Number of Opacity Micromaps found in the cache.
+        unsigned long long numMisses;     ///< Number of Opacity Micromaps not found in the cache.
+        unsigned long long numInserts;    ///< Number of Opacity Micromaps added to the cache.
+        unsigned long long numEvictions;  ///< Number of Opacity Micromaps evicted from the cache.
+        unsigned long long numMicromaps;  ///< Number of Opacity Micromaps currently in the cache.
+        unsigned long long usedBytes;     ///< Number of bytes of cache storage currently in use.
+    };
+
+    /// Open or create a persistent cache of baked Opacity Micromaps.
+    ///
+    /// The cache is a memory mapped file that persists across runs, so repeated bakes of the same geometry and textures 
+    /// skip the evaluation of their Opacity Micromaps. A cache file is used by a single process at a time.
+    /// Cache files that were not closed properly are discarded when opened.
+    /// The cache may be shared by concurrent BakeOpacityMicromaps calls.
+    ///
+    /// \param[in]  options   Cache options.
+    /// \param[out] outCache  The created cache.
+    Result CreateBakeCache(
+        const BakeCacheOptions* options,
+        BakeCache**             outCache );
+
+    /// Close a bake cache, flushing its contents to the cache file.
+    ///
+    /// \param[in] cache  The cache to destroy.
+    Result DestroyBakeCache(
+        BakeCache* cache );
+
+    /// Query the statistics of a bake cache.
+    ///
+    /// \param[in]  cache          The cache.
+    /// \param[out] outStatistics  The cache statistics.
+    Result GetBakeCacheStatistics(
+        const BakeCache*     cache,
+        BakeCacheStatistics* outStatistics );
+
 }  // namespace cuOmmBaking
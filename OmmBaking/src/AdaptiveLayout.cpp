@@ -0,0 +1,136 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "AdaptiveLayout.h"
+
+#include "Bake.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <queue>
+#include <vector>
+
+namespace {
+
+// Raising the subdivision level of an omm.
+struct Upgrade
+{
+    float    gainPerByte;
+    uint32_t ommIndex;
+    uint32_t subdivisionLevel;
+    uint32_t extraSizeInBytes;
+
+    // the largest gain per byte has the highest priority, ties are broken by the lowest omm index.
+    bool operator<( const Upgrade& other ) const
+    {
+        if( gainPerByte != other.gainPerByte )
+            return gainPerByte < other.gainPerByte;
+        return ommIndex > other.ommIndex;
+    }
+};
+
+uint32_t getMaxSubdivisionLevel( const OmmUnknownStatistics& stats )
+{
+    return std::min<uint32_t>( stats.maxSubdivisionLevel, OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL );
+}
+
+// Find the upgrade of an omm from its current subdivision level with the largest gain per byte, within the available size.
+// Returns false if no upgrade within the available size reduces the weighted unknown fraction.
+bool findUpgrade( const OmmUnknownStatistics& stats, uint32_t ommIndex, uint32_t subdivisionLevel, uint64_t availableSizeInBytes, uint32_t logStatesPerByte, Upgrade& outUpgrade )
+{
+    const float    unknownFraction = getExpectedUnknownFraction( stats, subdivisionLevel );
+    const uint32_t sizeInBytes     = getOmmSizeInBytes( subdivisionLevel, logStatesPerByte );
+
+    bool found = false;
+    for( uint32_t level = subdivisionLevel + 1; level <= getMaxSubdivisionLevel( stats ); ++level )
+    {
+        const uint32_t extraSizeInBytes = getOmmSizeInBytes( level, logStatesPerByte ) - sizeInBytes;
+
+        // the size only grows with the level
+        if( extraSizeInBytes > availableSizeInBytes )
+            break;
+
+        // levels beyond level 1 always take more bytes
+        assert( extraSizeInBytes > 0 );
+
+        const float gain = stats.weight * ( unknownFraction - getExpectedUnknownFraction( stats, level ) );
+        if( !( gain > 0.f ) )
+            continue;
+
+        const float gainPerByte = gain / ( float )extraSizeInBytes;
+        if( !found || gainPerByte > outUpgrade.gainPerByte )
+        {
+            outUpgrade = Upgrade{ gainPerByte, ommIndex, level, extraSizeInBytes };
+            found      = true;
+        }
+    }
+    return found;
+}
+
+}  // namespace
+
+float getExpectedUnknownFraction( const OmmUnknownStatistics& stats, uint32_t subdivisionLevel )
+{
+    assert( stats.numProbeLevels > 0 && stats.numProbeLevels <= ADAPTIVE_LAYOUT_NUM_PROBE_LEVELS );
+
+    if( subdivisionLevel < stats.numProbeLevels )
+        return stats.unknownFraction[subdivisionLevel];
+
+    const uint32_t lastLevel       = stats.numProbeLevels - 1;
+    const float    unknownFraction = stats.unknownFraction[lastLevel];
+
+    float rate = 0.5f;
+    if( lastLevel > 0 && stats.unknownFraction[lastLevel - 1] > 0.f )
+        rate = std::min( 1.f, std::max( 0.5f, unknownFraction / stats.unknownFraction[lastLevel - 1] ) );
+
+    return unknownFraction * powf( rate, ( float )( subdivisionLevel - lastLevel ) );
+}
+
+uint32_t assignAdaptiveSubdivisionLevels( const OmmUnknownStatistics* stats, uint32_t numOmms, uint32_t maxSizeInBytes, OptixOpacityMicromapFormat format, uint32_t* outSubdivisionLevels )
+{
+    const uint32_t logStatesPerByte = getLogStatesPerByte( format );
+
+    uint64_t sizeInBytes = 0;
+    for( uint32_t i = 0; i < numOmms; ++i )
+    {
+        outSubdivisionLevels[i] = std::min( 1u, getMaxSubdivisionLevel( stats[i] ) );
+        sizeInBytes += getOmmSizeInBytes( outSubdivisionLevels[i], logStatesPerByte );
+    }
+
+    auto getAvailableSizeInBytes = [&]() -> uint64_t { return ( sizeInBytes < maxSizeInBytes ) ? maxSizeInBytes - sizeInBytes : 0; };
+
+    std::priority_queue<Upgrade> upgrades;
+
+    Upgrade upgrade;
+    for( uint32_t i = 0; i < numOmms; ++i )
+    {
+        if( findUpgrade( stats[i], i, outSubdivisionLevels[i], getAvailableSizeInBytes(), logStatesPerByte, upgrade ) )
+            upgrades.push( upgrade );
+    }
+
+    while( !upgrades.empty() )
+    {
+        const Upgrade top = upgrades.top();
+        upgrades.pop();
+
+        const uint32_t ommIndex = top.ommIndex;
+
+        // the upgrade no longer fits, retry the omm with the remaining size
+        if( top.extraSizeInBytes > getAvailableSizeInBytes() )
+        {
+            if( findUpgrade( stats[ommIndex], ommIndex, outSubdivisionLevels[ommIndex], getAvailableSizeInBytes(), logStatesPerByte, upgrade ) )
+                upgrades.push( upgrade );
+            continue;
+        }
+
+        outSubdivisionLevels[ommIndex] = top.subdivisionLevel;
+        sizeInBytes += top.extraSizeInBytes;
+
+        if( findUpgrade( stats[ommIndex], ommIndex, outSubdivisionLevels[ommIndex], getAvailableSizeInBytes(), logStatesPerByte, upgrade ) )
+            upgrades.push( upgrade );
+    }
+
+    return ( uint32_t )sizeInBytes;
+}
@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include <optix.h>
+
+#include <cstdint>
+
+// Number of subdivision levels, starting at level zero, at which the unknown micro triangles of an omm are counted.
+const uint32_t ADAPTIVE_LAYOUT_NUM_PROBE_LEVELS = 4;
+
+// Unknown micro triangle statistics of an opacity micromap, from which its subdivision level is chosen.
+// Unknown micro triangles are those that are neither fully transparent nor fully opaque.
+struct OmmUnknownStatistics
+{
+    // weight of the unknown fraction of the omm, its area in texels.
+    float weight;
+    // upper bound on the subdivision level, from the target micro-triangle density.
+    uint32_t maxSubdivisionLevel;
+    // number of subdivision levels with a counted unknown fraction. at least one.
+    uint32_t numProbeLevels;
+    // fraction of unknown micro triangles per counted subdivision level.
+    float unknownFraction[ADAPTIVE_LAYOUT_NUM_PROBE_LEVELS];
+};
+
+// Expected fraction of unknown micro triangles at a subdivision level.
+// Beyond the counted levels, the unknown fraction decays geometrically at the rate between the last two counted levels.
+// The rate is at most halving per level, as for unknown micro triangles straddling opacity edges, whose number doubles
+// with each level while the number of micro triangles quadruples. Unknown texels are not resolved by any level, so
+// omms over unknown texels keep their unknown fraction.
+float getExpectedUnknownFraction( const OmmUnknownStatistics& stats, uint32_t subdivisionLevel );
+
+// Assign subdivision levels to omms, minimizing the total weighted expected unknown fraction within the size limit.
+// All omms start at subdivision level 1, the largest level of a single byte. Levels are then raised greedily, by
+// the largest reduction of weighted unknown fraction per byte first. An omm may skip levels, so that a level
+// without gain does not block a later level with gain. Returns the total size of the omms in bytes, which does
+// not exceed maxSizeInBytes unless the omms at level 1 already exceed it.
+uint32_t assignAdaptiveSubdivisionLevels( const OmmUnknownStatistics* stats, uint32_t numOmms, uint32_t maxSizeInBytes, OptixOpacityMicromapFormat format, uint32_t* outSubdivisionLevels );
@@ -0,0 +1,365 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+// Per element operations of the baking pipeline, shared by the device kernels and the host backend.
+// Both backends call these for every triangle, opacity micromap and micro triangle, so that they
+// apply the same rules.
+//
+// Note: when compiled by nvcc, optix_micromap.h requires a host implementation of __uint_as_float to be
+// declared before this header is included (see CuOmmBakingImpl.cu).
+
+#include "AdaptiveLayout.h"
+#include "CuOmmBakingImpl.h"
+#include "Evaluate.h"
+#include "Triangle.h"
+#include "Util/Intrinsics.h"
+
+#include <optix_micromap.h>
+
+inline __device__ __host__ OpacityStateSet sampleTextureState( const TextureInput* textures, Triangle triangle, unsigned resolution )
+{
+    const TextureData& texture = textures[triangle.texture].data;
+
+    const float2 scale = { ( float )texture.width, ( float )texture.height };
+
+    float2 uv0 = triangle.uv0 * scale;
+    float2 uv1 = triangle.uv1 * scale;
+    float2 uv2 = triangle.uv2 * scale;
+
+    return sampleMemoryTexture( texture, uv0, uv1, uv2, texture.filterKernelRadiusInTexels, resolution );
+}
+
+// Classify an input triangle as uniform or not. Non-uniform triangles get a hash key for duplicate detection.
+// The index is relative to the first triangle of the params.
+inline __device__ __host__ void setupTriangle( const SetupBakeInputParams& params, uint32_t index, TriangleID& outId, uint32_t& outKey )
+{
+    TriangleID id = {};
+    id.triangleIndex = params.firstTriangle + index;
+    id.inputIndex = params.inputIdx;
+
+    Triangle triangle = loadTriangle( params.input, id.triangleIndex );
+
+    OpacityStateSet state = {};
+    // filter out invalid triangles
+    if( !isnan( triangle.Area() ) )
+        state = sampleTextureState( params.textures, triangle, 16 );
+
+    id.uniform = 1;
+    if( params.format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE )
+    {
+        // conservatively mark everything as opaque except fully transparent triangles.
+        if( state.isTransparent() )
+        {
+            id.state = OPTIX_OPACITY_MICROMAP_STATE_TRANSPARENT;
+        }
+        else if( state.hasTransparent() )
+        {
+            // has a mixture of transparent and non-transparent states.
+            id.uniform = 0;
+        }
+        else
+        {
+            // mixtures of opaque and unknown are marked as opaque.
+            id.state = OPTIX_OPACITY_MICROMAP_STATE_OPAQUE;
+        }
+    }
+    else // OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE
+    {
+        if( !state.isUniform() )
+        {
+            // has a mixture of states
+            id.uniform = 0;
+        }
+        else
+        {
+            if( state.isTransparent() )
+            {
+                id.state = OPTIX_OPACITY_MICROMAP_STATE_TRANSPARENT;
+            }
+            else if( state.isOpaque() )
+            {
+                id.state = OPTIX_OPACITY_MICROMAP_STATE_OPAQUE;
+            }
+            else
+            {
+                id.state = OPTIX_OPACITY_MICROMAP_STATE_UNKNOWN_OPAQUE;
+            }
+        }
+    }
+
+    uint32_t key = 0;
+    if( id.uniform == 0 )
+    {
+        key = hash( canonicalizeTriangle( triangle, params.textures ) );
+    }
+
+    outId = id;
+    outKey = key;
+}
+
+// Returns true if a triangle shares the omm of the preceding triangle with the same hash key.
+inline __device__ __host__ bool isDuplicateTriangle( const BakeInput* bakeInputs, TriangleID prevId, TriangleID id )
+{
+    Triangle nextTriangle = loadTriangle( bakeInputs[id.inputIndex].desc, id.triangleIndex );
+    Triangle prevTriangle = loadTriangle( bakeInputs[prevId.inputIndex].desc, prevId.triangleIndex );
+
+    if( prevTriangle.texture != nextTriangle.texture )
+        return false;
+
+    // compare the canonicalized triangles to match near identical triangles and match under wrapping.
+    nextTriangle = canonicalizeTriangle( nextTriangle, bakeInputs[id.inputIndex].inTextures );
+    prevTriangle = canonicalizeTriangle( prevTriangle, bakeInputs[id.inputIndex].inTextures );
+
+    return !( nextTriangle != prevTriangle );
+}
+
+// Returns true if the triangle at the index of the hash sorted triangle list starts a new group of duplicates.
+inline __device__ __host__ bool isFirstOmmOccurance( const MarkFirstOmmOccuranceParams& params, uint32_t index )
+{
+    TriangleID id = params.inTriangleIDs[index];
+
+    // skip fully opaque/transparent triangles
+    if( id.uniform )
+        return false;
+
+    // early out hash check. if the hashes don't match there's no need to perform the costly collision check.
+    if( index > 0 && params.inHashKeys[index - 1] == params.inHashKeys[index] )
+        return !isDuplicateTriangle( params.inBakeInputs, params.inTriangleIDs[index - 1], id );
+
+    return true;
+}
+
+// Area in texels of the omm of a triangle.
+inline __device__ __host__ float getOmmAreaInTexels( const BakeInput& input, uint32_t triangleIndex )
+{
+    Triangle triangle = loadTriangle( input.desc, triangleIndex );
+
+    const TextureInput& textureInput = input.inTextures[triangle.texture];
+    float2 scale = {
+        ( float )textureInput.data.width,
+        ( float )textureInput.data.height };
+    triangle.uv0 *= scale;
+    triangle.uv1 *= scale;
+    triangle.uv2 *= scale;
+
+    return triangle.Area();
+}
+
+// Predefined omm index of a uniform triangle.
+inline __device__ __host__ uint32_t getPredefinedAssignment( TriangleID id )
+{
+    if( id.state == 0 )
+        return ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_TRANSPARENT;
+    else if( id.state == 1 )
+        return ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_OPAQUE;
+    else if( id.state == 2 )
+        return ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_UNKNOWN_TRANSPARENT;
+    return ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_UNKNOWN_OPAQUE;
+}
+
+// Encode an omm index into an index buffer.
+inline __device__ __host__ void storeAssignment( void* assignments, cuOmmBaking::IndexFormat indexFormat, uint32_t index, uint32_t assignment )
+{
+    if( indexFormat == cuOmmBaking::IndexFormat::I16_UINT )
+        ( ( uint16_t* )assignments )[index] = ( uint16_t )assignment;
+    else
+        ( ( uint32_t* )assignments )[index] = assignment;
+}
+
+// Write the omm index of the triangle at the index of the hash sorted triangle list to its input's index buffer.
+// The first triangle of each duplicate group writes its id and area as representative of the group.
+inline __device__ __host__ void assignTriangle( const GenerateAssignmentParams& params, uint32_t index )
+{
+    TriangleID id = params.inTriangleIDs[index];
+    uint32_t   assignment = 0;
+    if( !id.uniform ) {
+        assignment = params.inAssignment[index] - 1;
+
+        // crude method to prevent omm array overflow by marking any excess omms as unkown.
+        if( assignment >= params.maxOmms )
+        {
+            assignment = ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_UNKNOWN_OPAQUE;
+        }
+        // write out a representative triangle id for each duplicate group
+        else if( index == 0 || assignment != ( params.inAssignment[index - 1] - 1 ) )
+        {
+            params.outOmmTriangleId[assignment] = id;
+            params.outOmmArea[assignment] = getOmmAreaInTexels( params.inBakeInputs[id.inputIndex], id.triangleIndex );
+        }
+    } else {
+        assignment = getPredefinedAssignment( id );
+    }
+
+    storeAssignment( params.inBakeInputs[id.inputIndex].outAssignments, params.indexFormat, id.triangleIndex, assignment );
+}
+
+// log2 of the number of micro triangle states per byte
+inline __device__ __host__ uint32_t getLogStatesPerByte( OptixOpacityMicromapFormat format )
+{
+    return ( format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE ) ? 3 : 2;
+}
+
+// size in bytes of an opacity micromap
+inline __device__ __host__ uint32_t getOmmSizeInBytes( uint32_t subdivisionLevel, uint32_t logStatesPerByte )
+{
+    return 1u << ( max( 2u * subdivisionLevel, logStatesPerByte ) - logStatesPerByte );
+}
+
+// Subdivision level with the number of micro triangles closest to the target in log2 space.
+// This is max( 1, round( log2( numMicroTriangles ) / 2 ) ), evaluated exactly from the float exponent.
+inline __device__ __host__ uint32_t getTargetSubdivisionLevel( float numMicroTriangles )
+{
+    // zero, negative and nan targets result in the minimum level
+    if( !( numMicroTriangles > 0.f ) )
+        return 1;
+
+    if( isinf( numMicroTriangles ) )
+        return ~0u;
+
+    // numMicroTriangles = m * 2^e with m in [0.5,1), so log2( numMicroTriangles ) / 2 is in [(e-1)/2,e/2)
+    int e;
+    frexpf( numMicroTriangles, &e );
+
+    return ( uint32_t )max( 1, e / 2 );
+}
+
+// Subdivision level of an opacity micromap, maximized within its area weighted share of the omm array.
+inline __device__ __host__ uint32_t getOmmSubdivisionLevel( const GenerateLayoutParams& params, float area, float sumArea, uint32_t numOmms )
+{
+    const uint32_t logStatesPerByte = getLogStatesPerByte( params.format );
+
+    // the normalized weight determines the available share of omm data in bytes for this omm.
+    // the subdivision level is maximized within this available size bytes.
+    // the size share needs to be conservative to prevent over allocation and buffer overflow due to numerical rounding.
+    float normalizedWeight = ( sumArea > 0 )
+        ? fdivRz( area, sumArea )
+        : frcpRd( ( float )numOmms );
+    uint32_t maxSizeInBytes = float2uintRz( floorf( fmafRz( normalizedWeight, ( float )( params.maxOmmArraySizeInBytes - numOmms ), 1.f ) ) );
+    uint32_t maxLogSizeInBytes = 31 - clz( maxSizeInBytes );
+    uint32_t maxSubdivisionLevel = ( maxLogSizeInBytes + logStatesPerByte ) / 2;
+
+    uint32_t subdivisionLevel = maxSubdivisionLevel;
+
+    // clamp the subdivision level based on the target micro-triangle density
+    if( params.microTrianglesPerTexel )
+    {
+        float numMicroTriangles = area * params.microTrianglesPerTexel;
+
+        uint32_t targetSubdivisionLevel = getTargetSubdivisionLevel( numMicroTriangles );
+
+        if( subdivisionLevel > targetSubdivisionLevel )
+            subdivisionLevel = targetSubdivisionLevel;
+    }
+
+    if( subdivisionLevel > OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL )
+        subdivisionLevel = OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL;
+
+    return subdivisionLevel;
+}
+
+// Decode an omm index from an index buffer. Predefined I16 indices are sign extended to their I32 values.
+inline __device__ __host__ uint32_t loadAssignment( const void* assignments, cuOmmBaking::IndexFormat indexFormat, uint32_t index )
+{
+    if( indexFormat == cuOmmBaking::IndexFormat::I16_UINT )
+    {
+        uint16_t assignment16 = ( ( const uint16_t* )assignments )[index];
+
+        // preserve predefined assignments
+        if( assignment16 >= ( uint16_t )( -4 ) )
+            return ( uint32_t )( int32_t )( int16_t )assignment16;
+        return assignment16;
+    }
+
+    return ( ( const uint32_t* )assignments )[index];
+}
+
+// Opacity state of a micro triangle of the opacity micromap on a triangle.
+inline __device__ __host__ OpacityStateSet evaluateMicroTriangleOpacity( const TextureInput* textures, Triangle triangle, uint32_t subdivisionLevel, uint32_t microTriangleIndex )
+{
+    float2 uv0, uv1, uv2;
+    optixMicromapIndexToBaseBarycentrics(
+        microTriangleIndex,
+        subdivisionLevel,
+        uv0, uv1, uv2 );
+
+    float2 du = triangle.uv1 - triangle.uv0;
+    float2 dv = triangle.uv2 - triangle.uv0;
+
+    // convert micro-triangle uvs to texture uvs
+    triangle.uv1 = triangle.uv0 + uv1.x * du + uv1.y * dv;
+    triangle.uv2 = triangle.uv0 + uv2.x * du + uv2.y * dv;
+    triangle.uv0 += uv0.x * du + uv0.y * dv;
+
+    return sampleTextureState( textures, triangle, 1 );
+}
+
+// Count the unknown micro triangles of an omm at the lowest subdivision levels, using its representative triangle.
+inline __device__ __host__ void generateOmmUnknownStatistics( const GenerateUnknownStatisticsParams& params, uint32_t ommIndex )
+{
+    const TriangleID id    = params.inTriangleIdPerOmm[ommIndex];
+    const BakeInput& input = params.inBakeInputs[id.inputIndex];
+
+    const Triangle triangle = loadTriangle( input.desc, id.triangleIndex );
+
+    OmmUnknownStatistics stats;
+    stats.weight              = params.inOmmArea[ommIndex];
+    stats.maxSubdivisionLevel = params.microTrianglesPerTexel
+        ? getTargetSubdivisionLevel( stats.weight * params.microTrianglesPerTexel )
+        : OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL;
+    stats.numProbeLevels = min( ADAPTIVE_LAYOUT_NUM_PROBE_LEVELS, min( stats.maxSubdivisionLevel, ( uint32_t )OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL ) + 1 );
+
+    for( uint32_t level = 0; level < ADAPTIVE_LAYOUT_NUM_PROBE_LEVELS; ++level )
+    {
+        const uint32_t numMicroTriangles = 1u << ( 2 * level );
+
+        uint32_t numUnknown = 0;
+        if( level < stats.numProbeLevels )
+        {
+            for( uint32_t microTriangleIndex = 0; microTriangleIndex < numMicroTriangles; ++microTriangleIndex )
+            {
+                const OpacityStateSet state = evaluateMicroTriangleOpacity( input.inTextures, triangle, level, microTriangleIndex );
+                if( !state.isTransparent() && !state.isOpaque() )
+                    numUnknown++;
+            }
+        }
+
+        stats.unknownFraction[level] = ( float )numUnknown / ( float )numMicroTriangles;
+    }
+
+    params.outStats[ommIndex] = stats;
+}
+
+// Gather the representative triangle of an omm, offsetting its texture index to index the texture inputs of all bake inputs.
+inline __device__ __host__ void gatherOmmTriangle( const GatherOmmTrianglesParams& params, uint32_t ommIndex )
+{
+    const TriangleID id    = params.inTriangleIdPerOmm[ommIndex];
+    const BakeInput& input = params.inBakeInputs[id.inputIndex];
+
+    Triangle triangle = loadTriangle( input.desc, id.triangleIndex );
+    triangle.texture += ( uint64_t )( input.inTextures - params.inTextures );
+
+    params.outTriangles[ommIndex] = triangle;
+}
+
+// Convert an evaluated opacity state set to the micro triangle state of the omm format.
+inline __device__ __host__ uint32_t getMicroTriangleState( OpacityStateSet state, OptixOpacityMicromapFormat format )
+{
+    if( format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE )
+    {
+        // all but fully transparent micro triangles are marked as opaque
+        if( state.isTransparent() )
+            return OPTIX_OPACITY_MICROMAP_STATE_TRANSPARENT;
+        return OPTIX_OPACITY_MICROMAP_STATE_OPAQUE;
+    }
+    else // OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE
+    {
+        if( state.isTransparent() )
+            return OPTIX_OPACITY_MICROMAP_STATE_TRANSPARENT;
+        else if( state.isOpaque() )
+            return OPTIX_OPACITY_MICROMAP_STATE_OPAQUE;
+        return OPTIX_OPACITY_MICROMAP_STATE_UNKNOWN_OPAQUE;
+    }
+}
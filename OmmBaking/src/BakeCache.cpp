@@ -0,0 +1,573 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "BakeCache.h"
+
+#include "Util/Exception.h"
+#include "Util/Blake2b.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+namespace cuOmmBaking {
+
+namespace {
+
+const char     FILE_MAGIC[8] = { 'O', 'T', 'K', 'O', 'M', 'M', 'C', '1' };
+const uint32_t FILE_VERSION  = 2;
+
+const uint64_t EMPTY_SLOT = ~0ull;
+
+// Smallest supported cache file.
+const uint64_t MIN_FILE_SIZE = 64 * 1024;
+
+// Average bytes of cache file per index slot.
+const uint64_t BYTES_PER_SLOT = 128;
+
+uint64_t alignUp( uint64_t value, uint64_t alignment )
+{
+    return ( value + alignment - 1 ) & ~( alignment - 1 );
+}
+
+uint32_t computeChecksum( const void* data, uint32_t sizeInBytes )
+{
+    Blake2b hasher;
+    hasher.update( data, sizeInBytes );
+    return ( uint32_t )hasher.finish().lo;
+}
+
+}  // namespace
+
+struct BakeCache::FileHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t dirty;  // set while the file is open
+
+    // layout
+    uint64_t fileSize;
+    uint64_t numSlots;
+    uint64_t arenaOffset;
+    uint64_t arenaSize;
+
+    // ring buffer of records. records occupy [tail, head) or, when wrapped, [tail, wrapEnd) and [0, head).
+    uint64_t head;
+    uint64_t tail;
+    uint64_t wrapEnd;
+    uint32_t wrapped;
+    uint32_t reserved;
+    uint64_t numRecords;  // records in the ring, including records superseded by a re-append
+    uint64_t usedBytes;   // bytes of records in the ring
+
+    uint64_t numEntries;  // occupied index slots
+};
+
+struct BakeCache::Slot
+{
+    uint64_t lo;
+    uint64_t hi;
+    uint64_t offset;  // record offset in the arena, or EMPTY_SLOT
+};
+
+struct BakeCache::RecordHeader
+{
+    uint64_t lo;
+    uint64_t hi;
+    uint32_t sizeInBytes;
+    uint32_t checksum;
+};
+
+// Read-write shared mapping of an exclusively locked file.
+class BakeCache::MappedFile
+{
+  public:
+    MappedFile( const std::string& path, uint64_t sizeInBytes )
+        : m_size( sizeInBytes )
+    {
+#ifdef _WIN32
+        m_handle = CreateFileA( path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+        if( m_handle == INVALID_HANDLE_VALUE )
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value " + path + " for options.path. Cannot open the cache file." );
+
+        OVERLAPPED overlapped{};
+        if( !LockFileEx( m_handle, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &overlapped ) )
+        {
+            CloseHandle( m_handle );
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value " + path + " for options.path. The cache file is in use." );
+        }
+
+        LARGE_INTEGER fileSize{};
+        GetFileSizeEx( m_handle, &fileSize );
+        if( ( uint64_t )fileSize.QuadPart != sizeInBytes )
+        {
+            LARGE_INTEGER newSize;
+            newSize.QuadPart = ( LONGLONG )sizeInBytes;
+            SetFilePointerEx( m_handle, newSize, nullptr, FILE_BEGIN );
+            SetEndOfFile( m_handle );
+        }
+
+        m_mapping = CreateFileMappingA( m_handle, nullptr, PAGE_READWRITE, ( DWORD )( sizeInBytes >> 32 ), ( DWORD )sizeInBytes, nullptr );
+        if( m_mapping )
+            m_data = MapViewOfFile( m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, ( SIZE_T )sizeInBytes );
+        if( !m_data )
+        {
+            if( m_mapping )
+                CloseHandle( m_mapping );
+            CloseHandle( m_handle );
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value " + path + " for options.path. Cannot map the cache file." );
+        }
+#else
+        m_fd = ::open( path.c_str(), O_RDWR | O_CREAT, 0666 );
+        if( m_fd < 0 )
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value " + path + " for options.path. Cannot open the cache file." );
+
+        if( flock( m_fd, LOCK_EX | LOCK_NB ) != 0 )
+        {
+            ::close( m_fd );
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value " + path + " for options.path. The cache file is in use." );
+        }
+
+        struct stat status;
+        if( fstat( m_fd, &status ) != 0 || ( ( uint64_t )status.st_size != sizeInBytes && ftruncate( m_fd, ( off_t )sizeInBytes ) != 0 ) )
+        {
+            ::close( m_fd );
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value " + path + " for options.path. Cannot resize the cache file." );
+        }
+
+        m_data = mmap( nullptr, ( size_t )sizeInBytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0 );
+        if( m_data == MAP_FAILED )
+        {
+            ::close( m_fd );
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value " + path + " for options.path. Cannot map the cache file." );
+        }
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        UnmapViewOfFile( m_data );
+        CloseHandle( m_mapping );
+        CloseHandle( m_handle );
+#else
+        munmap( m_data, ( size_t )m_size );
+        ::close( m_fd );  // releases the lock
+#endif
+    }
+
+    void* data() const { return m_data; }
+
+    // Synchronously write the first sizeInBytes bytes of the mapping to disk.
+    void flush( uint64_t sizeInBytes )
+    {
+#ifdef _WIN32
+        FlushViewOfFile( m_data, ( SIZE_T )sizeInBytes );
+        FlushFileBuffers( m_handle );
+#else
+        msync( m_data, ( size_t )sizeInBytes, MS_SYNC );
+#endif
+    }
+
+    void flush() { flush( m_size ); }
+
+  private:
+    uint64_t m_size = 0;
+    void*    m_data = nullptr;
+#ifdef _WIN32
+    HANDLE m_handle  = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+BakeCache::BakeCache( const std::string& path, uint64_t sizeInBytes )
+{
+    if( sizeInBytes < MIN_FILE_SIZE )
+        throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value " + std::to_string( sizeInBytes ) + " for options.sizeInBytes. Must be at least " + std::to_string( MIN_FILE_SIZE ) + "." );
+
+    m_file.reset( new MappedFile( path, sizeInBytes ) );
+
+    m_header = ( FileHeader* )m_file->data();
+
+    // the index takes about one slot per BYTES_PER_SLOT bytes, rounded down to a power of two.
+    uint64_t numSlots = 1;
+    while( numSlots * 2 <= sizeInBytes / BYTES_PER_SLOT )
+        numSlots *= 2;
+
+    const uint64_t arenaOffset = alignUp( alignUp( sizeof( FileHeader ), 64 ) + numSlots * sizeof( Slot ), 64 );
+
+    m_slots = ( Slot* )( ( uint8_t* )m_file->data() + alignUp( sizeof( FileHeader ), 64 ) );
+    m_arena = ( uint8_t* )m_file->data() + arenaOffset;
+
+    FileHeader layout = {};
+    memcpy( layout.magic, FILE_MAGIC, sizeof( FILE_MAGIC ) );
+    layout.version     = FILE_VERSION;
+    layout.fileSize    = sizeInBytes;
+    layout.numSlots    = numSlots;
+    layout.arenaOffset = arenaOffset;
+    layout.arenaSize   = ( sizeInBytes - arenaOffset ) & ~7ull;
+
+    if( !isValid( layout ) )
+    {
+        *m_header = layout;
+        initialize();
+    }
+
+    // mark the file as open, so that it is reset if it isn't closed properly.
+    m_header->dirty = 1;
+    m_file->flush( sizeof( FileHeader ) );
+}
+
+BakeCache::~BakeCache()
+{
+    m_file->flush();
+    m_header->dirty = 0;
+    m_file->flush( sizeof( FileHeader ) );
+}
+
+bool BakeCache::isValid( const FileHeader& layout ) const
+{
+    const FileHeader& header = *m_header;
+
+    if( memcmp( header.magic, layout.magic, sizeof( FILE_MAGIC ) ) != 0 || header.version != layout.version || header.dirty != 0 )
+        return false;
+
+    if( header.fileSize != layout.fileSize || header.numSlots != layout.numSlots || header.arenaOffset != layout.arenaOffset || header.arenaSize != layout.arenaSize )
+        return false;
+
+    if( header.head > header.arenaSize || header.tail > header.arenaSize || header.wrapEnd > header.arenaSize || header.numEntries > header.numSlots )
+        return false;
+
+    return true;
+}
+
+void BakeCache::initialize()
+{
+    m_header->dirty      = 0;
+    m_header->head       = 0;
+    m_header->tail       = 0;
+    m_header->wrapEnd    = 0;
+    m_header->wrapped    = 0;
+    m_header->numRecords = 0;
+    m_header->usedBytes  = 0;
+    m_header->numEntries = 0;
+
+    for( uint64_t i = 0; i < m_header->numSlots; ++i )
+        m_slots[i] = Slot{ 0, 0, EMPTY_SLOT };
+}
+
+BakeCache::Slot* BakeCache::findSlot( const BakeCacheKey& key )
+{
+    const uint64_t mask = m_header->numSlots - 1;
+
+    // the index is never full, so the probing ends at an empty slot.
+    for( uint64_t i = key.lo & mask;; i = ( i + 1 ) & mask )
+    {
+        Slot& slot = m_slots[i];
+        if( slot.offset == EMPTY_SLOT )
+            return nullptr;
+        if( slot.lo == key.lo && slot.hi == key.hi )
+            return &slot;
+    }
+}
+
+void BakeCache::insertSlot( const BakeCacheKey& key, uint64_t offset )
+{
+    const uint64_t mask = m_header->numSlots - 1;
+
+    uint64_t i = key.lo & mask;
+    while( m_slots[i].offset != EMPTY_SLOT )
+        i = ( i + 1 ) & mask;
+
+    m_slots[i] = Slot{ key.lo, key.hi, offset };
+    m_header->numEntries++;
+}
+
+void BakeCache::eraseSlot( Slot* slot )
+{
+    const uint64_t mask = m_header->numSlots - 1;
+
+    // backward shift deletion keeps the probe sequences of the following slots intact without tombstones.
+    uint64_t i = slot - m_slots;
+    for( uint64_t j = ( i + 1 ) & mask; m_slots[j].offset != EMPTY_SLOT; j = ( j + 1 ) & mask )
+    {
+        const uint64_t home = m_slots[j].lo & mask;
+
+        // the entry at j stays if its home slot lies cyclically in (i, j].
+        const bool stays = ( i <= j ) ? ( i < home && home <= j ) : ( i < home || home <= j );
+        if( stays )
+            continue;
+
+        m_slots[i] = m_slots[j];
+        i          = j;
+    }
+
+    m_slots[i].offset = EMPTY_SLOT;
+    m_header->numEntries--;
+}
+
+BakeCache::RecordHeader* BakeCache::getRecord( uint64_t offset )
+{
+    const uint64_t arenaSize = m_header->arenaSize;
+
+    if( ( offset & 7 ) != 0 || offset + sizeof( RecordHeader ) > arenaSize )
+        return nullptr;
+
+    RecordHeader* record = ( RecordHeader* )( m_arena + offset );
+    if( record->sizeInBytes > arenaSize - offset - sizeof( RecordHeader ) )
+        return nullptr;
+
+    return record;
+}
+
+void BakeCache::evictOldest()
+{
+    FileHeader& header = *m_header;
+
+    assert( header.numRecords );
+
+    RecordHeader* record = getRecord( header.tail );
+    if( !record )
+    {
+        // the ring is corrupt.
+        initialize();
+        return;
+    }
+
+    // records superseded by a re-append are no longer indexed at this offset.
+    Slot* slot = findSlot( { record->lo, record->hi } );
+    if( slot && slot->offset == header.tail )
+    {
+        eraseSlot( slot );
+        m_statistics.numEvictions++;
+    }
+
+    const uint64_t recordSize = alignUp( sizeof( RecordHeader ) + record->sizeInBytes, 8 );
+
+    header.tail += recordSize;
+    header.usedBytes -= recordSize;
+    header.numRecords--;
+
+    if( header.wrapped && header.tail == header.wrapEnd )
+    {
+        header.tail    = 0;
+        header.wrapped = 0;
+    }
+
+    if( header.numRecords == 0 )
+    {
+        header.head    = 0;
+        header.tail    = 0;
+        header.wrapped = 0;
+    }
+}
+
+uint64_t BakeCache::allocate( uint64_t recordSize )
+{
+    FileHeader& header = *m_header;
+
+    for( ;; )
+    {
+        if( !header.wrapped )
+        {
+            // free space follows the head up to the end of the arena.
+            if( header.arenaSize - header.head >= recordSize )
+                break;
+
+            // continue at the start of the arena
+            header.wrapEnd = header.head;
+            header.head    = 0;
+            header.wrapped = 1;
+        }
+        else
+        {
+            // free space lies between the head and the tail.
+            if( header.tail - header.head >= recordSize && !( header.head == header.tail && header.numRecords ) )
+                break;
+
+            evictOldest();
+        }
+    }
+
+    const uint64_t offset = header.head;
+
+    header.head += recordSize;
+    header.usedBytes += recordSize;
+    header.numRecords++;
+
+    return offset;
+}
+
+bool BakeCache::insertRecord( const BakeCacheKey& key, const void* data, uint32_t sizeInBytes )
+{
+    const uint64_t recordSize = alignUp( sizeof( RecordHeader ) + sizeInBytes, 8 );
+
+    // oversized records would evict most of the cache.
+    if( recordSize > m_header->arenaSize / 2 )
+        return false;
+
+    // keep the index at most three quarters full for short probe sequences.
+    while( 4 * ( m_header->numEntries + 1 ) > 3 * m_header->numSlots )
+        evictOldest();
+
+    const uint64_t offset = allocate( recordSize );
+
+    RecordHeader* record = ( RecordHeader* )( m_arena + offset );
+    record->lo           = key.lo;
+    record->hi           = key.hi;
+    record->sizeInBytes  = sizeInBytes;
+    record->checksum     = computeChecksum( data, sizeInBytes );
+    memcpy( record + 1, data, sizeInBytes );
+
+    insertSlot( key, offset );
+
+    return true;
+}
+
+bool BakeCache::find( const BakeCacheKey& key, void* data, uint32_t sizeInBytes )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    Slot* slot = findSlot( key );
+    if( !slot )
+    {
+        m_statistics.numMisses++;
+        return false;
+    }
+
+    const uint64_t offset = slot->offset;
+
+    RecordHeader* record = getRecord( offset );
+    if( !record || record->lo != key.lo || record->hi != key.hi || record->sizeInBytes != sizeInBytes
+        || record->checksum != computeChecksum( record + 1, sizeInBytes ) )
+    {
+        eraseSlot( slot );
+        m_statistics.numMisses++;
+        return false;
+    }
+
+    memcpy( data, record + 1, sizeInBytes );
+    m_statistics.numHits++;
+
+    // re-append records that are about to be evicted.
+    const FileHeader& header   = *m_header;
+    const uint64_t    distance = ( offset >= header.tail ) ? offset - header.tail : header.wrapEnd - header.tail + offset;
+    if( distance < header.arenaSize / 4 )
+    {
+        eraseSlot( slot );
+        insertRecord( key, data, sizeInBytes );
+    }
+
+    return true;
+}
+
+bool BakeCache::insert( const BakeCacheKey& key, const void* data, uint32_t sizeInBytes )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    if( findSlot( key ) )
+        return true;
+
+    if( !insertRecord( key, data, sizeInBytes ) )
+        return false;
+
+    m_statistics.numInserts++;
+    return true;
+}
+
+void BakeCache::clear()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    initialize();
+    m_header->dirty = 1;
+}
+
+void BakeCache::flush()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_file->flush();
+}
+
+BakeCacheStatistics BakeCache::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    BakeCacheStatistics statistics = m_statistics;
+    statistics.numMicromaps        = m_header->numEntries;
+    statistics.usedBytes           = m_header->usedBytes;
+    return statistics;
+}
+
+Result CreateBakeCache( const BakeCacheOptions* options, BakeCache** outCache )
+{
+    try
+    {
+        if( options == 0 )
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value for options. Must not be zero." );
+
+        if( options->path == 0 || options->path[0] == 0 )
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value for options.path. Must not be empty." );
+
+        if( outCache == 0 )
+            throw Exception( Result::ERROR_INVALID_VALUE, "Invalid value for outCache. Must not be zero." );
+
+        *outCache = new BakeCache( options->path, options->sizeInBytes );
+    }
+    catch( const Exception& exception )
+    {
+        std::cerr << exception.what() << std::endl;
+        return exception.getResult();
+    }
+    catch( ... )
+    {
+        return Result::ERROR_INTERNAL;
+    }
+
+    return Result::SUCCESS;
+}
+
+Result DestroyBakeCache( BakeCache* cache )
+{
+    if( cache == 0 )
+    {
+        std::cerr << "Invalid value for cache. Must not be zero." << std::endl;
+        return Result::ERROR_INVALID_VALUE;
+    }
+
+    delete cache;
+
+    return Result::SUCCESS;
+}
+
+Result GetBakeCacheStatistics( const BakeCache* cache, BakeCacheStatistics* outStatistics )
+{
+    if( cache == 0 || outStatistics == 0 )
+    {
+        std::cerr << "Invalid value for " << ( cache ? "outStatistics" : "cache" ) << ". Must not be zero." << std::endl;
+        return Result::ERROR_INVALID_VALUE;
+    }
+
+    *outStatistics = cache->getStatistics();
+
+    return Result::SUCCESS;
+}
+
+}  // namespace cuOmmBaking
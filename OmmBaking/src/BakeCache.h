@@ -0,0 +1,94 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include <OptiXToolkit/CuOmmBaking/CuOmmBaking.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace cuOmmBaking {
+
+// 128 bit content key of a cached opacity micromap.
+struct BakeCacheKey
+{
+    uint64_t lo;
+    uint64_t hi;
+};
+
+inline bool operator==( const BakeCacheKey& a, const BakeCacheKey& b )
+{
+    return a.lo == b.lo && a.hi == b.hi;
+}
+
+// Persistent cache of baked opacity micromaps in a memory mapped file.
+//
+// The file holds a header, an open addressing hash index and a ring buffer of records. Each record
+// holds a key, a checksum and the micromap data. Records are appended at the head of the ring,
+// and the oldest records are evicted at the tail to make room. Micromaps that are found while among
+// the oldest quarter of the ring are re-appended at the head, which approximates least recently
+// used eviction without tracking the use of every record.
+//
+// The file is locked while the cache is open. A dirty flag is set while the file is open, so files
+// that were not closed properly, as well as files of a different layout, are reset on open. Records
+// are validated by their checksum when found. All methods are threadsafe.
+struct BakeCache
+{
+  public:
+    // Open or create the cache file. Throws an Exception if the file can't be opened, mapped or locked.
+    BakeCache( const std::string& path, uint64_t sizeInBytes );
+
+    // Flush and close the cache file.
+    ~BakeCache();
+
+    BakeCache( const BakeCache& ) = delete;
+    BakeCache& operator=( const BakeCache& ) = delete;
+
+    // Copy the micromap with the given key into data, which holds sizeInBytes bytes.
+    // Returns false if the micromap is not cached, corrupt or of a different size.
+    bool find( const BakeCacheKey& key, void* data, uint32_t sizeInBytes );
+
+    // Add a micromap to the cache, evicting the oldest micromaps as needed.
+    // Returns false if the micromap is too large for the cache.
+    bool insert( const BakeCacheKey& key, const void* data, uint32_t sizeInBytes );
+
+    // Remove all micromaps.
+    void clear();
+
+    // Write the mapped file contents to disk.
+    void flush();
+
+    BakeCacheStatistics getStatistics() const;
+
+  private:
+    struct FileHeader;
+    struct Slot;
+    struct RecordHeader;
+
+    class MappedFile;
+
+    void          initialize();
+    bool          isValid( const FileHeader& layout ) const;
+    Slot*         findSlot( const BakeCacheKey& key );
+    void          eraseSlot( Slot* slot );
+    void          insertSlot( const BakeCacheKey& key, uint64_t offset );
+    uint64_t      allocate( uint64_t recordSize );
+    void          evictOldest();
+    RecordHeader* getRecord( uint64_t offset );
+    bool          insertRecord( const BakeCacheKey& key, const void* data, uint32_t sizeInBytes );
+
+    std::unique_ptr<MappedFile> m_file;
+
+    FileHeader* m_header = nullptr;
+    Slot*       m_slots  = nullptr;
+    uint8_t*    m_arena  = nullptr;
+
+    mutable std::mutex  m_mutex;
+    BakeCacheStatistics m_statistics = {};
+};
+
+}  // namespace cuOmmBaking
@@ -4,13 +4,19 @@
 
 #include "Util/BufferLayout.h"
 #include "Util/Exception.h"
+#include "Util/Blake2b.h"
 
+#include "AdaptiveLayout.h"
 #include "CuOmmBakingImpl.h"
+#include "DuplicateTable.h"
+#include "HostBaking.h"
 #include "Texture.h"
+#include "Triangle.h"
 
 #include <algorithm>
 #include <cmath>
 #include <cstdarg>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <string>
@@ -94,6 +100,18 @@ void CudaMemsetAsync( BufferLayout<T>& out, cudaStream_t stream )
     OMM_CUDA_CHECK( cudaMemsetAsync( out.access(), 0, out.getNumBytes(), stream ) );
 }
 
+template <typename T>
+void HostMemcpy( BufferLayout<T>& out, const std::vector<T>& in )
+{
+    memcpy( out.access(), in.data(), out.getNumBytes() );
+}
+
+template <typename T>
+void HostMemset( BufferLayout<T>& out )
+{
+    memset( out.access(), 0, out.getNumBytes() );
+}
+
 uint32_t getNumTriangles( const BakeInputDesc& input )
 {
     return ( input.indexFormat != IndexFormat::NONE ? input.numIndexTriplets : ( input.numTexCoords / 3 ) );
@@ -177,6 +195,14 @@ public:
 
         virtual cudaError_t build( void* temp, size_t& tempStorageInBytes, cudaStream_t stream ) = 0;
 
+        // build the summed area table in host memory, for baking on the host.
+        virtual void buildHost() = 0;
+
+        // content key of the texture and its sampling parameters, for the bake cache.
+        virtual BakeCacheKey getCacheKey( const cuOmmBaking::TextureDesc& desc, cudaStream_t stream ) const = 0;
+
+        uint32_t getId() const { return m_id; }
+
         virtual TextureData get( const cuOmmBaking::TextureDesc& /*desc*/ )
         {
             TextureData textureInput = {};
@@ -205,9 +231,11 @@ public:
         StateTexture(
             uint32_t           id,
             const uint8_t*     input,
+            bool               isHostInput,
             StateTextureConfig config )
             : TextureBase( id, config.width, config.height )
             , m_input( input )
+            , m_isHostInput( isHostInput )
             , m_config( config )
         {}
 
@@ -216,6 +244,58 @@ public:
             return ::launchSummedAreaTable( temp, tempStorageInBytes, m_config, m_input, m_satBuf.isMaterialized() ? m_satBuf.access() : 0, stream );
         }
 
+        void buildHost()
+        {
+            ::hostSummedAreaTable( m_config, m_input, m_satBuf.access() );
+        }
+
+        BakeCacheKey getCacheKey( const cuOmmBaking::TextureDesc& desc, cudaStream_t stream ) const
+        {
+            // the states are hashed on the host, device inputs are downloaded first.
+            const uint8_t*       input = m_input;
+            std::vector<uint8_t> hostInput;
+            if( !m_isHostInput )
+            {
+                hostInput.resize( ( ( uint64_t )( m_config.height - 1 ) * m_config.pitchInBits + 2 * m_config.width + 7 ) / 8 );
+                OMM_CUDA_CHECK( cudaMemcpyAsync( hostInput.data(), m_input, hostInput.size(), cudaMemcpyDeviceToHost, stream ) );
+                OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+                input = hostInput.data();
+            }
+
+            Blake2b hasher;
+            hasher.update( m_config.width );
+            hasher.update( m_config.height );
+            hasher.update( desc.state.addressMode[0] );
+            hasher.update( desc.state.addressMode[1] );
+            hasher.update( desc.state.filterKernelWidthInTexels );
+
+            // hash the rows of states, excluding the padding between rows.
+            const uint32_t rowBits = 2 * m_config.width;
+            std::vector<uint8_t> row( ( rowBits + 7 ) / 8 );
+            for( uint32_t y = 0; y < m_config.height; ++y )
+            {
+                const uint64_t rowBegin = ( uint64_t )y * m_config.pitchInBits;
+                const uint64_t rowEnd   = rowBegin + rowBits;
+                for( uint32_t i = 0; i < row.size(); ++i )
+                {
+                    const uint64_t bit   = rowBegin + 8 * i;
+                    const uint32_t shift = bit & 7;
+
+                    uint32_t value = input[bit / 8] >> shift;
+                    if( shift && ( bit / 8 + 1 ) * 8 < rowEnd )
+                        value |= input[bit / 8 + 1] << ( 8 - shift );
+                    row[i] = ( uint8_t )value;
+                }
+                if( rowBits & 7 )
+                    row.back() &= ( uint8_t )( ( 1u << ( rowBits & 7 ) ) - 1 );
+
+                hasher.update( row.data(), row.size() );
+            }
+
+            const Blake2b::Digest digest = hasher.finish();
+            return { digest.lo, digest.hi };
+        }
+
         virtual TextureData get( const cuOmmBaking::TextureDesc& desc )
         {
             TextureData input = TextureBase::get( desc );
@@ -227,8 +307,9 @@ public:
             return input;
         }
     private:
-        const uint8_t*     m_input  = {};
-        StateTextureConfig m_config = {};
+        const uint8_t*     m_input       = {};
+        bool               m_isHostInput = {};
+        StateTextureConfig m_config      = {};
     };
 
     struct CudaTexture : public TextureBase
@@ -254,6 +335,18 @@ public:
             return ::launchSummedAreaTable( temp, tempStorageInBytes, m_config, m_texture, m_satBuf.isMaterialized() ? m_satBuf.access() : 0, stream );
         }
 
+        void buildHost()
+        {
+            // rejected when the baker is constructed
+            throw Exception( Result::ERROR_INTERNAL, stringf( "Cuda textures can not be baked on the host." ) );
+        }
+
+        BakeCacheKey getCacheKey( const cuOmmBaking::TextureDesc& /*desc*/, cudaStream_t /*stream*/ ) const
+        {
+            // rejected when the baker is constructed
+            throw Exception( Result::ERROR_INTERNAL, stringf( "Cuda textures can not be cached." ) );
+        }
+
         virtual TextureData get( const cuOmmBaking::TextureDesc& desc )
         {
             TextureData input = TextureBase::get( desc );
@@ -298,6 +391,9 @@ public:
         Baker::m_options = *options;
         Baker::m_inputs = std::vector<BakeInputDesc>( inputs, inputs + numInputs );
 
+        m_isHostBake = ( ( m_options.flags & BakeFlags::BAKE_ON_HOST ) == BakeFlags::BAKE_ON_HOST );
+        m_isBatched = ( m_options.maximumTempSizeInBytes != 0 );
+
         uint64_t numTexels = 0;
         uint32_t numTextureReferences = 0;
         uint32_t numUniqueTextures = 0;
@@ -372,6 +468,12 @@ public:
                     {
                     case TextureType::CUDA:
                     {
+                        if( m_isHostBake )
+                            throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value of %u for inputs[%zu].textures[%zu].type. Cuda textures can not be baked with BakeFlags::BAKE_ON_HOST.", ( uint32_t )input.textures[i].type, inputIdx, i ) );
+
+                        if( m_options.cache )
+                            throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value of %u for inputs[%zu].textures[%zu].type. Cuda textures can not be baked with options.cache.", ( uint32_t )input.textures[i].type, inputIdx, i ) );
+
                         cudaChannelFormatDesc chanDesc = {};
                         cudaResourceDesc      resDesc = {};
                         cudaExtent            extent = {};
@@ -542,7 +644,7 @@ public:
                         if( config.height > maxExtent )
                             throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value of %u for inputs[%zu].textures[%zu].state.height must not exceed %u.", config.height, inputIdx, i, maxExtent ) );
                                                 
-                        std::unique_ptr<StateTexture> stateTexture( new StateTexture( numUniqueTextures, ( const uint8_t* )input.textures[i].state.stateBuffer, config ) );
+                        std::unique_ptr<StateTexture> stateTexture( new StateTexture( numUniqueTextures, ( const uint8_t* )input.textures[i].state.stateBuffer, m_isHostBake, config ) );
                         texture.reset( stateTexture.release() );
 
                         width = config.width;
@@ -554,19 +656,23 @@ public:
                         break;
                     };
 
-                    size_t tempStorageInBytes = 0;
-                    cudaError_t error = texture->build( 0, tempStorageInBytes, 0 );
-
-                    if( error == cudaErrorInvalidChannelDescriptor )
-                    {
-                        throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Unsupported format for inputs[%zu].textures[%zu].cuda.texObject.", inputIdx, i ) );
-                    }
-                    else
+                    // the host builds the summed area tables without temporary storage
+                    if( !m_isHostBake )
                     {
-                        OMM_CUDA_CHECK( error );
-                    }
+                        size_t tempStorageInBytes = 0;
+                        cudaError_t error = texture->build( 0, tempStorageInBytes, 0 );
 
-                    satTempStorageInBytes = std::max( satTempStorageInBytes, tempStorageInBytes );
+                        if( error == cudaErrorInvalidChannelDescriptor )
+                        {
+                            throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Unsupported format for inputs[%zu].textures[%zu].cuda.texObject.", inputIdx, i ) );
+                        }
+                        else
+                        {
+                            OMM_CUDA_CHECK( error );
+                        }
+
+                        satTempStorageInBytes = std::max( satTempStorageInBytes, tempStorageInBytes );
+                    }
 
                     texture->aggregateInto( m_satAggregateBuf );
 
@@ -623,13 +729,19 @@ public:
         m_inputBuf.setNumElems( numInputs );
 
         m_numTriangles = static_cast<uint32_t>(totalNumTriangles);
-        m_inIdBuf.setNumElems( m_numTriangles );
-        m_outIdBuf.setNumElems( m_numTriangles );
-        m_inHashBuf.setNumElems( m_numTriangles );
-        m_outHashBuf.setNumElems( m_numTriangles );
 
-        m_inMarkersBuf.setNumElems( m_numTriangles );
-        m_outAssignmentBuf.setNumElems( m_numTriangles );
+        // in batched mode, the batch buffers are sized below to fit the temp memory limit,
+        // and the markers and flat assignment are not used.
+        if( !m_isBatched )
+        {
+            m_inIdBuf.setNumElems( m_numTriangles );
+            m_outIdBuf.setNumElems( m_numTriangles );
+            m_inHashBuf.setNumElems( m_numTriangles );
+            m_outHashBuf.setNumElems( m_numTriangles );
+
+            m_inMarkersBuf.setNumElems( m_numTriangles );
+            m_outAssignmentBuf.setNumElems( m_numTriangles );
+        }
 
         // conservative upper bound at minimum of 1 byte per omm
         m_maxNumOmms = std::min( Baker::m_options.maximumSizeInBytes, m_numTriangles );
@@ -637,6 +749,11 @@ public:
         m_sumAreaBuf.setNumElems( 1 );
 
         m_ommAreaBuf.setNumElems( m_maxNumOmms );
+        if( m_options.cache )
+            m_ommTriangleBuf.setNumElems( m_maxNumOmms );
+        // the host stages keep the adaptive layout statistics in host memory
+        if( ( m_options.flags & BakeFlags::ADAPTIVE_SUBDIVISION ) == BakeFlags::ADAPTIVE_SUBDIVISION && !m_isHostBake )
+            m_statsBuf.setNumElems( m_maxNumOmms );
         m_descBuf.setNumElems( m_maxNumOmms );
         m_numOmmsBuf.setNumElems( 1 );
         m_histogramBuf.setNumElems( OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL+1 );
@@ -644,36 +761,36 @@ public:
                 
         m_dataBuf.setNumElems( ( Baker::m_options.maximumSizeInBytes + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ) );
 
+        // the host stages need no temporary storage. in batched mode, the sort temp storage is sized for a batch below,
+        // and the flat assignment is not scanned.
+        if( !m_isHostBake )
         {
-            size_t tempSizeInBytes = 0;
-            cudaError_t error = SortPairs<uint32_t, TriangleID>()( 0, tempSizeInBytes, 0, 0, 0, 0, m_numTriangles, 0, sizeof( uint32_t ) * 8, 0 );
-            OMM_CUDA_CHECK( error );
-
-            m_sortTempBuf.setNumBytes( tempSizeInBytes ).setAlignmentInBytes( CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES );
-        }
+            if( !m_isBatched )
+            {
+                m_sortTempBuf.setNumBytes( getSortTempSizeInBytes( m_numTriangles ) ).setAlignmentInBytes( CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES );
 
-        {
-            size_t tempSizeInBytes = 0;
-            cudaError_t error = InclusiveSum<uint32_t*, uint32_t*>()( 0, tempSizeInBytes, 0, 0, m_numTriangles );
-            OMM_CUDA_CHECK( error );
+                size_t tempSizeInBytes = 0;
+                cudaError_t error = InclusiveSum<uint32_t*, uint32_t*>()( 0, tempSizeInBytes, 0, 0, m_numTriangles );
+                OMM_CUDA_CHECK( error );
 
-            m_sumTempBuf.setNumBytes( tempSizeInBytes ).setAlignmentInBytes( CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES );
-        }
+                m_sumTempBuf.setNumBytes( tempSizeInBytes ).setAlignmentInBytes( CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES );
+            }
 
-        {
-            size_t tempSizeInBytes = 0;
-            cudaError_t error = ReduceRoundUp<float*, float*, float>()( 0, tempSizeInBytes, 0, 0, m_numTriangles );
-            OMM_CUDA_CHECK( error );
+            {
+                size_t tempSizeInBytes = 0;
+                cudaError_t error = ReduceRoundUp<float*, float*, float>()( 0, tempSizeInBytes, 0, 0, m_maxNumOmms );
+                OMM_CUDA_CHECK( error );
 
-            m_reduceTempBuf.setNumBytes( tempSizeInBytes ).setAlignmentInBytes( CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES );
-        }
+                m_reduceTempBuf.setNumBytes( tempSizeInBytes ).setAlignmentInBytes( CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES );
+            }
 
-        {
-            size_t tempSizeInBytes = 0;
-            cudaError_t error = launchGenerateStartOffsets( 0, tempSizeInBytes, 0, 0, m_maxNumOmms, m_options.format, 0 );
-            OMM_CUDA_CHECK( error );
+            {
+                size_t tempSizeInBytes = 0;
+                cudaError_t error = launchGenerateStartOffsets( 0, tempSizeInBytes, 0, 0, m_maxNumOmms, m_options.format, 0 );
+                OMM_CUDA_CHECK( error );
 
-            m_offsetTempBuf.setNumBytes( tempSizeInBytes ).setAlignmentInBytes( CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES );
+                m_offsetTempBuf.setNumBytes( tempSizeInBytes ).setAlignmentInBytes( CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES );
+            }
         }
 
         /* Visualization of buffer usage in the different phases of baking.
@@ -692,6 +809,8 @@ public:
         * m_ommIdBuf         64b             min( nByte, nTri )  .   .   .   .   .   .   xxxxxxxxxxxxxxxxxxxxx
         * m_sumAreaBuf       32b             1                   .   .   .   .   .   .   .   xxxxx   .   .   .
         * m_ommAreaBuf       32b             min( nByte, nTri )  .   .   .   .   .   .   xxxxxxxxx   .   .   .
+        * m_statsBuf         224b            min( nByte, nTri )  .   .   .   .   .   .   .   .   x   .   .   .
+        * m_ommTriangleBuf   256b            min( nByte, nTri )  .   .   .   .   .   .   .   .   .   .   .   xxx
         * m_inputBuf                                             .   xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
         * m_textureBuf                                           .   xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
         * m_sortTempBuf                                          .   .   .   x   .   .   .   .   .   .   .   .
@@ -707,22 +826,38 @@ public:
         * 
         */
 
+        // In batched mode, the batch buffers are placed after all other temporary buffers instead. See below.
+        if( m_isBatched )
+        {
+            m_batchBuf
+                .aggregate( m_inIdBuf )
+                .aggregate( m_outIdBuf )
+                .aggregate( m_inHashBuf )
+                .aggregate( m_outHashBuf )
+                .aggregate( m_sortTempBuf );
+        }
+        else
+        {
+            m_overlay[0].overlay( m_inIdBuf );
+            m_overlay[1].overlay( m_inHashBuf );
+            m_overlay[2].overlay( m_outHashBuf );
+            m_overlay[3].overlay( m_sortTempBuf );
+        }
+
         m_overlay[0]
-            .overlay( m_inIdBuf )
             .overlay( m_inMarkersBuf )
             .overlay( m_ommIdBuf );
 
         m_overlay[1]
-            .overlay( m_inHashBuf )
             .overlay( m_ommAreaBuf );
 
         m_overlay[2]
-            .overlay( m_outHashBuf )
-            .overlay( m_outAssignmentBuf );
+            .overlay( m_outAssignmentBuf )
+            .overlay( m_statsBuf )
+            .overlay( m_ommTriangleBuf );
 
         m_overlay[3]
             .overlay( m_satTempBuf )
-            .overlay( m_sortTempBuf )
             .overlay( m_sumTempBuf )
             .overlay( m_reduceTempBuf )
             .overlay( m_offsetTempBuf );
@@ -733,9 +868,9 @@ public:
         // Overlap a temporary buffer with an output buffer to save memory.
         // This results in larger memory requirements for the descriptor buffer when the 
         // omm array size limit constrains the maximum number of omms in the array.
-        m_outOmmDesc
-            .overlay( m_descBuf )
-            .overlay( m_outIdBuf );
+        m_outOmmDesc.overlay( m_descBuf );
+        if( !m_isBatched )
+            m_outOmmDesc.overlay( m_outIdBuf );
 
         // must match struct PostBakeInfo layout
         m_postBakeInfo.aggregate( m_numOmmsBuf ).aggregate( m_sizeInBytesBuf );
@@ -756,6 +891,44 @@ public:
         else
             m_temp.aggregate( m_postBakeInfo );
 
+        if( m_isBatched )
+        {
+            // The batch size is maximized within the temp memory limit, which must at least fit a single triangle.
+            // The size of an aligned temp buffer doesn't depend on its address, so it is resolved up front.
+            m_temp.materialize();
+
+            const size_t paddingInBytes     = m_temp.getAlignmentInBytes() - 1;
+            const size_t batchOffsetInBytes = ( m_temp.getNumBytes() + alignof( TriangleID ) - 1 ) & ~( alignof( TriangleID ) - 1 );
+            const size_t bytesPerTriangle   = 2 * sizeof( TriangleID ) + 2 * sizeof( uint32_t );
+
+            // device bakes sort the batches in the batch buffers, after the per triangle buffers
+            auto getBatchSizeInBytes = [&]( uint32_t batchSize ) -> size_t {
+                size_t sizeInBytes = batchSize * bytesPerTriangle;
+                if( !m_isHostBake )
+                    sizeInBytes += CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES - 1 + getSortTempSizeInBytes( batchSize );
+                return sizeInBytes;
+            };
+
+            const size_t minTempSizeInBytes = paddingInBytes + batchOffsetInBytes + getBatchSizeInBytes( 1 );
+            if( m_options.maximumTempSizeInBytes < minTempSizeInBytes )
+                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %zu for options.maximumTempSizeInBytes. Must be at least %zu bytes.", m_options.maximumTempSizeInBytes, minTempSizeInBytes ) );
+
+            const size_t availableSizeInBytes = m_options.maximumTempSizeInBytes - paddingInBytes - batchOffsetInBytes;
+
+            m_batchSize = ( uint32_t )std::min<size_t>( m_numTriangles, availableSizeInBytes / bytesPerTriangle );
+
+            // the sort temp size grows with the batch size, so the batch size is reduced until the sort fits as well
+            while( m_batchSize > 1 && getBatchSizeInBytes( m_batchSize ) > availableSizeInBytes )
+                m_batchSize = std::max<uint32_t>( 1, std::min<uint32_t>( m_batchSize - 1, ( uint32_t )( ( uint64_t )m_batchSize * availableSizeInBytes / getBatchSizeInBytes( m_batchSize ) ) ) );
+
+            m_inIdBuf.setNumElems( m_batchSize );
+            m_outIdBuf.setNumElems( m_batchSize );
+            m_inHashBuf.setNumElems( m_batchSize );
+            m_outHashBuf.setNumElems( m_batchSize );
+            if( !m_isHostBake )
+                m_sortTempBuf.setNumBytes( getSortTempSizeInBytes( m_batchSize ) ).setAlignmentInBytes( CUB_TEMP_BUFFER_ALIGNMENT_IN_BYTES );
+        }
+
         if( buffers )
         {
             static_assert( std::alignment_of<OptixOpacityMicromapUsageCount>::value <= BufferAlignmentInBytes::MICROMAP_USAGE_COUNTS, "alignment must at least match the element type" );
@@ -803,6 +976,7 @@ public:
             m_outOmmHistogram.materialize( ( OptixOpacityMicromapHistogramEntry* )buffers->micromapHistogramEntriesBuffer );
             m_outPostBakeInfo.materialize( ( unsigned char* )buffers->postBakeInfoBuffer );
             m_temp.materialize( ( unsigned char* )buffers->tempBuffer );
+            materializeBatchBuffers( ( unsigned char* )buffers->tempBuffer );
 
             if( ( m_options.flags & BakeFlags::ENABLE_POST_BAKE_INFO ) == BakeFlags::ENABLE_POST_BAKE_INFO )
             {
@@ -816,8 +990,8 @@ public:
                 throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %zu for buffers->numMicromapDescs. Must be at least %zu.", buffers->numMicromapDescs, m_outOmmDesc.getNumElems() ) );
             if( m_outOmmHistogram.getNumElems() > buffers->numMicromapHistogramEntries )
                 throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %zu for buffers->numMicromapHistogramEntries. Must be at least %zu.", buffers->numMicromapHistogramEntries, m_outOmmHistogram.getNumElems() ) );
-            if( m_temp.getNumBytes() > buffers->tempBufferSizeInBytes )
-                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %zu for buffers->tempBufferSizeInBytes. Must be at least %zu bytes.", buffers->tempBufferSizeInBytes, m_temp.getNumBytes() ) );
+            if( getTempSizeInBytes() > buffers->tempBufferSizeInBytes )
+                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %zu for buffers->tempBufferSizeInBytes. Must be at least %zu bytes.", buffers->tempBufferSizeInBytes, getTempSizeInBytes() ) );
         }
         else
         {
@@ -826,6 +1000,7 @@ public:
             m_outOmmHistogram.materialize();
             m_outPostBakeInfo.materialize();
             m_temp.materialize();
+            materializeBatchBuffers( 0 );
         }
 
         if( inputBuffers )
@@ -876,7 +1051,7 @@ public:
         preBake.numMicromapDescs = m_outOmmDesc.getNumElems();
         preBake.numMicromapHistogramEntries = m_outOmmHistogram.getNumElems();
         preBake.postBakeInfoBufferSizeInBytes = m_outPostBakeInfo.getNumBytes();
-        preBake.tempBufferSizeInBytes = m_temp.getNumBytes() + (m_temp.getAlignmentInBytes() - 1); // add padding so realigning user temp input won't cause an overflow
+        preBake.tempBufferSizeInBytes = getTempSizeInBytes() + (m_temp.getAlignmentInBytes() - 1); // add padding so realigning user temp input won't cause an overflow
 
         return preBake;
     }
@@ -889,35 +1064,9 @@ public:
         return preBake;
     }
 
-    void execute( cudaStream_t stream )
+    // Setup the bake and texture input descriptors, referencing the internal texture and output buffers.
+    void setupInputs( std::vector<BakeInput>& bakeInputs, std::vector<TextureInput>& textureInputs )
     {
-        uint32_t maxOmmArraySizeInBytes = m_dataBuf.getNumBytes();
-
-        int device;
-        OMM_CUDA_CHECK( cudaGetDevice( &device ) );
-
-        cudaDeviceProp props;
-        OMM_CUDA_CHECK( cudaGetDeviceProperties( &props, device ) );
-
-        uint32_t numThreads = props.multiProcessorCount * 512u;
-
-        // 1. Build texture summed area tables.
-
-        // build opacity summed area tables per texture
-        for( auto itr : m_textureMap )
-        {
-            size_t tempStorageInBytes = m_satTempBuf.getNumBytes();
-
-            cudaError_t error = itr.second->build( m_satTempBuf.access(), tempStorageInBytes, stream );
-            OMM_CUDA_CHECK( error );
-
-            // dump( "sat:", itr.second.satBuf );
-        }
-
-        // 2. Upload bake and texture input descriptors.
-
-        std::vector<TextureInput> textureInputs;
-        std::vector<BakeInput> bakeInputs;
         bakeInputs.resize( m_inputs.size() );
         textureInputs.resize( m_textureBuf.getNumElems() );
 
@@ -976,87 +1125,65 @@ public:
 
             textureInputOffset += m_inputs[i].numTextures;
         }
+    }
 
-        CudaMemcpyAsync( m_textureBuf, textureInputs, stream );
-        CudaMemcpyAsync( m_inputBuf, bakeInputs, stream );
-
-        // 3. Setup triangles, detect uniforms and generate hashes for duplicate detection.
-
-        uint32_t triangleOffset = 0;
-        for( uint32_t i = 0; i < m_inputs.size(); ++i )
+    void execute( cudaStream_t stream )
+    {
+        if( m_isHostBake )
         {
-            SetupBakeInputParams params = {};
+            executeHost();
+            return;
+        }
 
-            params.numTriangles   = getNumTriangles( m_inputs[i] );
-            params.inputIdx       = i;
-            params.outTriangleIDs = m_inIdBuf.access() + triangleOffset;
-            params.outHashKeys    = m_inHashBuf.access() + triangleOffset;
-            params.textures       = bakeInputs[i].inTextures;
-            params.input          = m_inputs[i];
-            params.format         = m_options.format;
+        uint32_t maxOmmArraySizeInBytes = m_dataBuf.getNumBytes();
 
-            OMM_CUDA_CHECK( launchSetupBakeInput( params, stream ) );
+        int device;
+        OMM_CUDA_CHECK( cudaGetDevice( &device ) );
 
-            triangleOffset += params.numTriangles;
-        }
+        cudaDeviceProp props;
+        OMM_CUDA_CHECK( cudaGetDeviceProperties( &props, device ) );
 
-        // 4. Sort triangles by their hash keys
+        uint32_t numThreads = props.multiProcessorCount * 512u;
 
-        {
-            // sort triangles by hash key
-            size_t tempSizeInBytes = m_sortTempBuf.getNumBytes();
-            cudaError_t error = SortPairs<uint32_t, TriangleID>()(
-                m_sortTempBuf.access(), tempSizeInBytes, m_inHashBuf.access(), m_outHashBuf.access(), m_inIdBuf.access(), m_outIdBuf.access(), m_numTriangles, 0, sizeof( uint32_t ) * 8, stream );
-            OMM_CUDA_CHECK( error );
-        }
+        reportStage( BakeStage::SETUP, false, stream );
 
-        // 5. Find and mark the start of duplicate groups in the sorted triangle list.
+        // 1. Build texture summed area tables.
 
+        // build opacity summed area tables per texture
+        for( auto itr : m_textureMap )
         {
-            MarkFirstOmmOccuranceParams params;
-            params.numTriangles = m_numTriangles;
-            params.inHashKeys = m_outHashBuf.access();
-            params.inTriangleIDs = m_outIdBuf.access();
-            params.outMarkers = m_inMarkersBuf.access();
-            params.inBakeInputs = m_inputBuf.access();
+            size_t tempStorageInBytes = m_satTempBuf.getNumBytes();
 
-            OMM_CUDA_CHECK( launchMarkFirstOmmOccurance( params, stream ) );
+            cudaError_t error = itr.second->build( m_satTempBuf.access(), tempStorageInBytes, stream );
+            OMM_CUDA_CHECK( error );
+
+            // dump( "sat:", itr.second.satBuf );
         }
 
-        // 6. Generate flat omm assignment
+        // 2. Upload bake and texture input descriptors.
 
-        {
-            size_t tempSizeInBytes = m_sumTempBuf.getNumBytes();
-            cudaError_t error = InclusiveSum<uint32_t*, uint32_t*>()(
-                m_sumTempBuf.access(), tempSizeInBytes, m_inMarkersBuf.access(), m_outAssignmentBuf.access(), m_numTriangles, stream );
-            OMM_CUDA_CHECK( error );
-        }
+        std::vector<TextureInput> textureInputs;
+        std::vector<BakeInput> bakeInputs;
+        setupInputs( bakeInputs, textureInputs );
 
-        // 7. Scatter the assignments into the per-input assigment buffers. Output omm area.
+        CudaMemcpyAsync( m_textureBuf, textureInputs, stream );
+        CudaMemcpyAsync( m_inputBuf, bakeInputs, stream );
 
-        CudaMemsetAsync( m_ommAreaBuf, stream );
+        // 3-7. Generate the omm assignment. With a temp memory limit, the triangles are processed in batches.
 
-        {
-            GenerateAssignmentParams params;
-            params.numTriangles = m_numTriangles;
-            params.inTriangleIDs = m_outIdBuf.access();
-            params.maxOmms = m_maxNumOmms;
-            params.outNumOmms = m_numOmmsBuf.access();
-            params.inAssignment = m_outAssignmentBuf.access();
-            params.outOmmTriangleId = m_ommIdBuf.access();
-            params.outOmmArea = m_ommAreaBuf.access();
-            params.inBakeInputs = m_inputBuf.access();
-            params.indexFormat = m_indexFormat;
+        if( m_isBatched )
+            assignOmmsBatched( bakeInputs, stream );
+        else
+            assignOmms( bakeInputs, stream );
 
-            OMM_CUDA_CHECK( launchGenerateAssignment( params, stream ) );
-        }
+        reportStage( BakeStage::LAYOUT, false, stream );
 
         // 8. Sum the omm area. Use roundup mode to compute a conservative upper bound on the sum.
         // Rounding up is necceseary to prevent overflows in the assignment.
 
         {
             size_t tempSizeInBytes = m_reduceTempBuf.getNumBytes();
-            cudaError_t error = ReduceRoundUp<float*, float*, float>()( m_reduceTempBuf.access(), tempSizeInBytes, m_ommAreaBuf.access(), m_sumAreaBuf.access(), m_numTriangles, stream );
+            cudaError_t error = ReduceRoundUp<float*, float*, float>()( m_reduceTempBuf.access(), tempSizeInBytes, m_ommAreaBuf.access(), m_sumAreaBuf.access(), m_maxNumOmms, stream );
             OMM_CUDA_CHECK( error );
         }
 
@@ -1083,7 +1210,46 @@ public:
             params.microTrianglesPerTexel = ( m_options.subdivisionScale != 0.f ) ? ( 1.f / ( m_options.subdivisionScale * m_options.subdivisionScale ) ) : 0.f;
             params.format = m_options.format;
 
-            OMM_CUDA_CHECK( launchGenerateLayout( params, m_numTriangles, stream ) );
+            if( ( m_options.flags & BakeFlags::ADAPTIVE_SUBDIVISION ) == BakeFlags::ADAPTIVE_SUBDIVISION )
+            {
+                // the unknown micro triangles are counted on the device, but the greedy level assignment is sequential.
+                // the statistics are downloaded, the levels assigned on the host and the layout uploaded.
+                GenerateUnknownStatisticsParams statsParams;
+                statsParams.inNumOmms              = m_numOmmsBuf.access();
+                statsParams.inOmmArea              = m_ommAreaBuf.access();
+                statsParams.inTriangleIdPerOmm     = m_ommIdBuf.access();
+                statsParams.inBakeInputs           = m_inputBuf.access();
+                statsParams.microTrianglesPerTexel = params.microTrianglesPerTexel;
+                statsParams.outStats               = m_statsBuf.access();
+
+                OMM_CUDA_CHECK( launchGenerateUnknownStatistics( statsParams, m_maxNumOmms, stream ) );
+
+                uint32_t numOmms = 0, sizeInBytes = 0;
+                OMM_CUDA_CHECK( cudaMemcpyAsync( &numOmms, m_numOmmsBuf.access(), sizeof( uint32_t ), cudaMemcpyDeviceToHost, stream ) );
+                OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+
+                std::vector<OmmUnknownStatistics>     stats( numOmms );
+                std::vector<OptixOpacityMicromapDesc> descs( numOmms );
+                OMM_CUDA_CHECK( cudaMemcpyAsync( stats.data(), m_statsBuf.access(), numOmms * sizeof( OmmUnknownStatistics ), cudaMemcpyDeviceToHost, stream ) );
+                OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+
+                params.inNumOmms     = &numOmms;
+                params.ioDescs       = descs.data();
+                params.ioSizeInBytes = &sizeInBytes;
+                params.ioHistogram   = histogram.data();
+
+                hostGenerateAdaptiveLayout( params, stats.data() );
+
+                // the host buffers must stay alive until the uploads complete
+                OMM_CUDA_CHECK( cudaMemcpyAsync( m_descBuf.access(), descs.data(), numOmms * sizeof( OptixOpacityMicromapDesc ), cudaMemcpyHostToDevice, stream ) );
+                OMM_CUDA_CHECK( cudaMemcpyAsync( m_sizeInBytesBuf.access(), &sizeInBytes, sizeof( uint32_t ), cudaMemcpyHostToDevice, stream ) );
+                CudaMemcpyAsync( m_histogramBuf, histogram, stream );
+                OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+            }
+            else
+            {
+                OMM_CUDA_CHECK( launchGenerateLayout( params, m_numTriangles, stream ) );
+            }
         }
 
         // 10. Generate omm desc byte offsets by summing over the omm sizes in bytes.
@@ -1112,10 +1278,68 @@ public:
             OMM_CUDA_CHECK( launchGenerateInputHistogram( params, stream ) );
         }
 
-        // 12. Evaluate the opacity states of all micro triangles in the opacity micromap array
+        reportStage( BakeStage::LAYOUT, true, stream );
+        reportStage( BakeStage::EVALUATION, false, stream );
+
+        // 12. Evaluate the opacity states of all micro triangles in the opacity micromap array, or copy them from the cache
 
         CudaMemsetAsync( m_dataBuf, stream );
 
+        // the cache is accessed on the host. the omms found in it are uploaded and marked uniform, so the evaluation
+        // skips them, and the evaluated omms are downloaded and added to it afterwards.
+        std::vector<BakeCacheKey>             textureCacheKeys;
+        std::vector<OptixOpacityMicromapDesc> descs;
+        std::vector<TriangleID>               ommIds;
+        std::vector<Triangle>                 ommTriangles;
+        std::vector<uint8_t>                  data;
+
+        OmmCacheParams cacheParams = {};
+        if( m_options.cache )
+        {
+            textureCacheKeys = getTextureCacheKeys( stream );
+
+            uint32_t numOmms = 0, sizeInBytes = 0;
+            OMM_CUDA_CHECK( cudaMemcpyAsync( &numOmms, m_numOmmsBuf.access(), sizeof( uint32_t ), cudaMemcpyDeviceToHost, stream ) );
+            OMM_CUDA_CHECK( cudaMemcpyAsync( &sizeInBytes, m_sizeInBytesBuf.access(), sizeof( uint32_t ), cudaMemcpyDeviceToHost, stream ) );
+            OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+
+            {
+                GatherOmmTrianglesParams params;
+                params.numOmms            = numOmms;
+                params.inTriangleIdPerOmm = m_ommIdBuf.access();
+                params.inBakeInputs       = m_inputBuf.access();
+                params.inTextures         = m_textureBuf.access();
+                params.outTriangles       = m_ommTriangleBuf.access();
+                OMM_CUDA_CHECK( launchGatherOmmTriangles( params, stream ) );
+            }
+
+            descs.resize( numOmms );
+            ommIds.resize( numOmms );
+            ommTriangles.resize( numOmms );
+            data.resize( sizeInBytes );
+
+            OMM_CUDA_CHECK( cudaMemcpyAsync( descs.data(), m_descBuf.access(), numOmms * sizeof( OptixOpacityMicromapDesc ), cudaMemcpyDeviceToHost, stream ) );
+            OMM_CUDA_CHECK( cudaMemcpyAsync( ommIds.data(), m_ommIdBuf.access(), numOmms * sizeof( TriangleID ), cudaMemcpyDeviceToHost, stream ) );
+            OMM_CUDA_CHECK( cudaMemcpyAsync( ommTriangles.data(), m_ommTriangleBuf.access(), numOmms * sizeof( Triangle ), cudaMemcpyDeviceToHost, stream ) );
+            OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+
+            cacheParams.numOmms            = numOmms;
+            cacheParams.inDescs            = descs.data();
+            cacheParams.inTriangles        = ommTriangles.data();
+            cacheParams.inTextures         = textureInputs.data();
+            cacheParams.inTextureCacheKeys = textureCacheKeys.data();
+            cacheParams.ioTriangleIdPerOmm = ommIds.data();
+            cacheParams.ioData             = data.data();
+            cacheParams.format             = m_options.format;
+            cacheParams.cache              = m_options.cache;
+
+            hostFindCachedOmms( cacheParams );
+
+            // the host buffers must stay alive until the uploads complete, which the download below guarantees
+            OMM_CUDA_CHECK( cudaMemcpyAsync( m_dataBuf.access(), data.data(), sizeInBytes, cudaMemcpyHostToDevice, stream ) );
+            OMM_CUDA_CHECK( cudaMemcpyAsync( m_ommIdBuf.access(), ommIds.data(), numOmms * sizeof( TriangleID ), cudaMemcpyHostToDevice, stream ) );
+        }
+
         // evaluate the opacity of all microtriangles in the array
         {
             EvaluateOmmOpacityParams params;
@@ -1133,61 +1357,687 @@ public:
             // use the maximum data size as a limit for the number of threads launched
             OMM_CUDA_CHECK( launchEvaluateOmmOpacity( params, std::min<uint32_t>( numThreads, maxThreads ), stream ) );
         }
-    }
 
-private:
-
-    void validate( const BakeOptions& options )
-    {
-        if( ( options.flags & ~( BakeFlags::ENABLE_POST_BAKE_INFO ) ) != BakeFlags::NONE )
-            throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %u for options.flags. Contains invalid flags.", (uint32_t) options.flags ) );
-
-        if( options.subdivisionScale < 0.f || std::isnan( options.subdivisionScale ) )
-            throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %f for options.subdivisionScale. Must be real positive value.", options.subdivisionScale ) );
-
-        switch( options.format )
+        if( m_options.cache )
         {
-        case OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE:
-        case OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE:
-            break;
-        default:
-            throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %i for options.format.", options.format ) );
-            break;
+            OMM_CUDA_CHECK( cudaMemcpyAsync( data.data(), m_dataBuf.access(), data.size(), cudaMemcpyDeviceToHost, stream ) );
+            OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+
+            hostInsertCachedOmms( cacheParams );
         }
+
+        reportStage( BakeStage::EVALUATION, true, stream );
     }
 
-    void validate( const TextureDesc& texture, uint32_t inputIdx, uint32_t textureIdx, bool isPreBake )
+    // Host version of execute. Runs the same stages on host memory, synchronously.
+    // The host stages need no temporary storage for sorting and scanning.
+    void executeHost()
     {
-        switch( texture.type )
-        {
-        case TextureType::CUDA:
-            if( texture.cuda.texObject == 0 )
-                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value for inputs[%u].textures[%u].cuda.texObject. Must not be zero.", inputIdx, textureIdx ) );
+        uint32_t maxOmmArraySizeInBytes = m_dataBuf.getNumBytes();
 
-            if( std::isnan(texture.cuda.transparencyCutoff) )
-                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %f for inputs[%u].textures[%u].cuda.transparencyCutoff.",
-                    texture.cuda.transparencyCutoff, inputIdx, textureIdx ) );
+        reportStage( BakeStage::SETUP, false, 0 );
 
-            if( std::isnan( texture.cuda.opacityCutoff ) )
-                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %f for inputs[%u].textures[%u].cuda.opacityCutoff.",
-                    texture.cuda.opacityCutoff, inputIdx, textureIdx ) );
+        // 1. Build texture summed area tables.
 
-            if( texture.cuda.transparencyCutoff > texture.cuda.opacityCutoff )
-                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %f for inputs[%u].textures[%u].cuda.transparencyCutoff. Must not be larger than value %f of inputs[%u].textures[%u].cuda.opacityCutoff.",
-                    texture.cuda.transparencyCutoff, inputIdx, textureIdx, texture.cuda.opacityCutoff, inputIdx, textureIdx ) );
-            break;
-        case TextureType::STATE:
-        {
-            auto validateAddressMode = [&]( uint32_t dim ) {
-                switch( texture.state.addressMode[dim] )
-                {
-                case cudaAddressModeWrap:
-                case cudaAddressModeClamp:
-                case cudaAddressModeMirror:
-                    break;
-                default:
-                    throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %u for inputs[%u].textures[%u].state.addressMode[%i].",
-                        texture.state.addressMode[dim], inputIdx, textureIdx, dim ) );
+        for( auto itr : m_textureMap )
+            itr.second->buildHost();
+
+        // 2. Setup bake and texture input descriptors.
+
+        std::vector<TextureInput> textureInputs;
+        std::vector<BakeInput> bakeInputs;
+        setupInputs( bakeInputs, textureInputs );
+
+        HostMemcpy( m_textureBuf, textureInputs );
+        HostMemcpy( m_inputBuf, bakeInputs );
+
+        // 3-7. Generate the omm assignment. With a temp memory limit, the triangles are processed in batches.
+
+        if( m_isBatched )
+            assignOmmsHostBatched( bakeInputs );
+        else
+            assignOmmsHost( bakeInputs );
+
+        reportStage( BakeStage::LAYOUT, false, 0 );
+
+        // 8. Sum the omm area, in the same order and rounding mode as the device.
+
+        hostReduceRoundUp( m_ommAreaBuf.access(), m_sumAreaBuf.access(), m_maxNumOmms );
+
+        // 9. Generate omm descriptors, assign subdivision levels, compute total omm array size and subdivision level histogram.
+        //    With adaptive subdivision, the levels are assigned by the unknown micro triangles of the omms instead of their area.
+
+        HostMemset( m_sizeInBytesBuf );
+
+        // initialize the histogram
+        std::vector<OptixOpacityMicromapHistogramEntry> histogram( m_histogramBuf.getNumElems(), OptixOpacityMicromapHistogramEntry { 0, 0, m_options.format } );
+        for( size_t i = 0; i < histogram.size(); ++i )
+            histogram[i].subdivisionLevel = i;
+        HostMemcpy( m_histogramBuf, histogram );
+
+        // assign subdivision levels to omms
+        {
+            GenerateLayoutParams params;
+            params.inOmmArea = m_ommAreaBuf.access();
+            params.inSumArea = m_sumAreaBuf.access();
+            params.inNumOmms = m_numOmmsBuf.access();
+            params.ioDescs = m_descBuf.access();
+            params.maxOmmArraySizeInBytes = maxOmmArraySizeInBytes;
+            params.ioSizeInBytes = m_sizeInBytesBuf.access();
+            params.ioHistogram = m_histogramBuf.access();
+            params.microTrianglesPerTexel = ( m_options.subdivisionScale != 0.f ) ? ( 1.f / ( m_options.subdivisionScale * m_options.subdivisionScale ) ) : 0.f;
+            params.format = m_options.format;
+
+            if( ( m_options.flags & BakeFlags::ADAPTIVE_SUBDIVISION ) == BakeFlags::ADAPTIVE_SUBDIVISION )
+            {
+                std::vector<OmmUnknownStatistics> stats( *m_numOmmsBuf.access() );
+
+                GenerateUnknownStatisticsParams statsParams;
+                statsParams.inNumOmms              = m_numOmmsBuf.access();
+                statsParams.inOmmArea              = m_ommAreaBuf.access();
+                statsParams.inTriangleIdPerOmm     = m_ommIdBuf.access();
+                statsParams.inBakeInputs           = m_inputBuf.access();
+                statsParams.microTrianglesPerTexel = params.microTrianglesPerTexel;
+                statsParams.outStats               = stats.data();
+
+                hostGenerateUnknownStatistics( statsParams );
+                hostGenerateAdaptiveLayout( params, stats.data() );
+            }
+            else
+            {
+                hostGenerateLayout( params );
+            }
+        }
+
+        // 10. Generate omm desc byte offsets by summing over the omm sizes in bytes.
+
+        hostGenerateStartOffsets( m_descBuf.access(), *m_numOmmsBuf.access(), m_options.format );
+
+        // 11. Generate per-input usage histograms.
+
+        std::vector<OptixOpacityMicromapUsageCount> usage( m_outOmmUsageDescs[0].getNumElems(), OptixOpacityMicromapUsageCount{ 0, 0, m_options.format } );
+        for( size_t i = 0; i < usage.size(); ++i )
+            usage[i].subdivisionLevel = i;
+
+        for( uint32_t i = 0; i < m_inputs.size(); ++i )
+        {
+            HostMemcpy( m_outOmmUsageDescs[i], usage );
+
+            GenerateInputHistogramParams params;
+            params.indexFormat  = m_indexFormat;
+            params.numTriangles = getNumTriangles( m_inputs[i] );
+            params.inAssignment = bakeInputs[i].outAssignments;
+            params.inDescs      = m_descBuf.access();
+            params.ioHistogram  = m_outOmmUsageDescs[i].access();
+            hostGenerateInputHistogram( params );
+        }
+
+        reportStage( BakeStage::LAYOUT, true, 0 );
+        reportStage( BakeStage::EVALUATION, false, 0 );
+
+        // 12. Evaluate the opacity states of all micro triangles in the opacity micromap array, or copy them from the cache
+
+        HostMemset( m_dataBuf );
+
+        std::vector<BakeCacheKey> textureCacheKeys;
+
+        OmmCacheParams cacheParams = {};
+        if( m_options.cache )
+        {
+            textureCacheKeys = getTextureCacheKeys( 0 );
+
+            GatherOmmTrianglesParams params;
+            params.numOmms            = *m_numOmmsBuf.access();
+            params.inTriangleIdPerOmm = m_ommIdBuf.access();
+            params.inBakeInputs       = m_inputBuf.access();
+            params.inTextures         = m_textureBuf.access();
+            params.outTriangles       = m_ommTriangleBuf.access();
+            hostGatherOmmTriangles( params );
+
+            cacheParams.numOmms            = *m_numOmmsBuf.access();
+            cacheParams.inDescs            = m_descBuf.access();
+            cacheParams.inTriangles        = m_ommTriangleBuf.access();
+            cacheParams.inTextures         = m_textureBuf.access();
+            cacheParams.inTextureCacheKeys = textureCacheKeys.data();
+            cacheParams.ioTriangleIdPerOmm = m_ommIdBuf.access();
+            cacheParams.ioData             = ( uint8_t* )m_dataBuf.access();
+            cacheParams.format             = m_options.format;
+            cacheParams.cache              = m_options.cache;
+
+            hostFindCachedOmms( cacheParams );
+        }
+
+        {
+            EvaluateOmmOpacityParams params;
+            params.inNumOmms = m_numOmmsBuf.access();
+            params.inSizeInBytes = m_sizeInBytesBuf.access();
+            params.inDescs = m_descBuf.access();
+            params.ioData = m_dataBuf.access();
+            params.inTriangleIdPerOmm = m_ommIdBuf.access();
+            params.inBakeInputs = m_inputBuf.access();
+            params.dataSizeInBytes = m_dataBuf.getNumBytes();
+            params.format = m_options.format;
+
+            hostEvaluateOmmOpacity( params );
+        }
+
+        if( m_options.cache )
+            hostInsertCachedOmms( cacheParams );
+
+        reportStage( BakeStage::EVALUATION, true, 0 );
+    }
+
+private:
+
+    // content keys of all textures for the bake cache, indexed by texture id.
+    std::vector<BakeCacheKey> getTextureCacheKeys( cudaStream_t stream ) const
+    {
+        std::vector<BakeCacheKey> keys( m_textureMap.size() );
+        for( const auto& itr : m_textureMap )
+            keys[itr.second->getId()] = itr.second->getCacheKey( itr.first, stream );
+        return keys;
+    }
+
+    // Steps 3 to 7 of execute.
+    void assignOmms( const std::vector<BakeInput>& bakeInputs, cudaStream_t stream )
+    {
+        // 3. Setup triangles, detect uniforms and generate hashes for duplicate detection.
+
+        uint32_t triangleOffset = 0;
+        for( uint32_t i = 0; i < m_inputs.size(); ++i )
+        {
+            SetupBakeInputParams params = {};
+
+            params.numTriangles   = getNumTriangles( m_inputs[i] );
+            params.inputIdx       = i;
+            params.outTriangleIDs = m_inIdBuf.access() + triangleOffset;
+            params.outHashKeys    = m_inHashBuf.access() + triangleOffset;
+            params.textures       = bakeInputs[i].inTextures;
+            params.input          = m_inputs[i];
+            params.format         = m_options.format;
+
+            OMM_CUDA_CHECK( launchSetupBakeInput( params, stream ) );
+
+            triangleOffset += params.numTriangles;
+        }
+
+        reportStage( BakeStage::SETUP, true, stream );
+        reportStage( BakeStage::SORT, false, stream );
+
+        // 4. Sort triangles by their hash keys
+
+        {
+            // sort triangles by hash key
+            size_t tempSizeInBytes = m_sortTempBuf.getNumBytes();
+            cudaError_t error = SortPairs<uint32_t, TriangleID>()(
+                m_sortTempBuf.access(), tempSizeInBytes, m_inHashBuf.access(), m_outHashBuf.access(), m_inIdBuf.access(), m_outIdBuf.access(), m_numTriangles, 0, sizeof( uint32_t ) * 8, stream );
+            OMM_CUDA_CHECK( error );
+        }
+
+        reportStage( BakeStage::SORT, true, stream );
+        reportStage( BakeStage::ASSIGNMENT, false, stream );
+
+        // 5. Find and mark the start of duplicate groups in the sorted triangle list.
+
+        {
+            MarkFirstOmmOccuranceParams params;
+            params.numTriangles = m_numTriangles;
+            params.inHashKeys = m_outHashBuf.access();
+            params.inTriangleIDs = m_outIdBuf.access();
+            params.outMarkers = m_inMarkersBuf.access();
+            params.inBakeInputs = m_inputBuf.access();
+
+            OMM_CUDA_CHECK( launchMarkFirstOmmOccurance( params, stream ) );
+        }
+
+        // 6. Generate flat omm assignment
+
+        {
+            size_t tempSizeInBytes = m_sumTempBuf.getNumBytes();
+            cudaError_t error = InclusiveSum<uint32_t*, uint32_t*>()(
+                m_sumTempBuf.access(), tempSizeInBytes, m_inMarkersBuf.access(), m_outAssignmentBuf.access(), m_numTriangles, stream );
+            OMM_CUDA_CHECK( error );
+        }
+
+        // 7. Scatter the assignments into the per-input assigment buffers. Output omm area.
+
+        CudaMemsetAsync( m_ommAreaBuf, stream );
+
+        {
+            GenerateAssignmentParams params;
+            params.numTriangles = m_numTriangles;
+            params.inTriangleIDs = m_outIdBuf.access();
+            params.maxOmms = m_maxNumOmms;
+            params.outNumOmms = m_numOmmsBuf.access();
+            params.inAssignment = m_outAssignmentBuf.access();
+            params.outOmmTriangleId = m_ommIdBuf.access();
+            params.outOmmArea = m_ommAreaBuf.access();
+            params.inBakeInputs = m_inputBuf.access();
+            params.indexFormat = m_indexFormat;
+
+            OMM_CUDA_CHECK( launchGenerateAssignment( params, stream ) );
+        }
+
+        reportStage( BakeStage::ASSIGNMENT, true, stream );
+    }
+
+    // Steps 3 to 7 of execute, processing the triangles in batches. As in assignOmmsHostBatched, the omms of each batch
+    // are merged into a table of unique omms on the host. The batches are set up and sorted on the device, and the sorted
+    // batch is downloaded. The duplicate checks against the previous triangles of the table need the input triangles, so
+    // they run on the device before the batch is merged. The omm indices of the batch triangles in order of discovery
+    // are uploaded to the index buffers, and are remapped to single pass order a range at a time after all batches.
+    void assignOmmsBatched( const std::vector<BakeInput>& bakeInputs, cudaStream_t stream )
+    {
+        // the setup of steps 1 and 2 is reported separately from the setup of the batches
+        reportStage( BakeStage::SETUP, true, stream );
+
+        const uint32_t indexSizeInBytes = ( m_indexFormat == IndexFormat::I16_UINT ) ? sizeof( uint16_t ) : sizeof( uint32_t );
+
+        std::vector<uint32_t> triangleOffsetPerInput( m_inputs.size() );
+        for( uint32_t i = 1; i < m_inputs.size(); ++i )
+            triangleOffsetPerInput[i] = triangleOffsetPerInput[i - 1] + getNumTriangles( m_inputs[i - 1] );
+
+        // host copies of a sorted batch, and of the index buffer range of a batch
+        std::vector<uint32_t>   hashKeys( m_batchSize ), duplicates( m_batchSize );
+        std::vector<TriangleID> triangleIds( m_batchSize ), previousIds( m_batchSize );
+        std::vector<uint8_t>    assignments( m_batchSize * indexSizeInBytes );
+
+        DuplicateTable table;
+
+        uint32_t inputIdx      = 0;
+        uint32_t inputTriangle = 0;
+        for( uint32_t batchBegin = 0; batchBegin < m_numTriangles; batchBegin += m_batchSize )
+        {
+            const uint32_t batchSize = std::min( m_batchSize, m_numTriangles - batchBegin );
+
+            reportStage( BakeStage::SETUP, false, stream );
+
+            // 3. Setup the batch triangles, which may span multiple inputs.
+
+            const uint32_t batchInputIdx = inputIdx;
+            for( uint32_t batchOffset = 0; batchOffset < batchSize; )
+            {
+                // skip completed inputs
+                while( inputTriangle == getNumTriangles( m_inputs[inputIdx] ) )
+                {
+                    inputIdx++;
+                    inputTriangle = 0;
+                }
+
+                SetupBakeInputParams params = {};
+
+                params.numTriangles   = std::min( batchSize - batchOffset, getNumTriangles( m_inputs[inputIdx] ) - inputTriangle );
+                params.firstTriangle  = inputTriangle;
+                params.inputIdx       = inputIdx;
+                params.outTriangleIDs = m_inIdBuf.access() + batchOffset;
+                params.outHashKeys    = m_inHashBuf.access() + batchOffset;
+                params.textures       = bakeInputs[inputIdx].inTextures;
+                params.input          = m_inputs[inputIdx];
+                params.format         = m_options.format;
+
+                OMM_CUDA_CHECK( launchSetupBakeInput( params, stream ) );
+
+                batchOffset += params.numTriangles;
+                inputTriangle += params.numTriangles;
+            }
+
+            reportStage( BakeStage::SETUP, true, stream );
+            reportStage( BakeStage::SORT, false, stream );
+
+            // 4. Sort the batch triangles by their hash keys
+
+            {
+                size_t tempSizeInBytes = m_sortTempBuf.getNumBytes();
+                cudaError_t error = SortPairs<uint32_t, TriangleID>()(
+                    m_sortTempBuf.access(), tempSizeInBytes, m_inHashBuf.access(), m_outHashBuf.access(), m_inIdBuf.access(), m_outIdBuf.access(), batchSize, 0, sizeof( uint32_t ) * 8, stream );
+                OMM_CUDA_CHECK( error );
+            }
+
+            reportStage( BakeStage::SORT, true, stream );
+            reportStage( BakeStage::ASSIGNMENT, false, stream );
+
+            // 5. Compare the batch triangles with their previous triangles on the device, and merge the batch into the table of unique omms.
+
+            OMM_CUDA_CHECK( cudaMemcpyAsync( hashKeys.data(), m_outHashBuf.access(), batchSize * sizeof( uint32_t ), cudaMemcpyDeviceToHost, stream ) );
+            OMM_CUDA_CHECK( cudaMemcpyAsync( triangleIds.data(), m_outIdBuf.access(), batchSize * sizeof( TriangleID ), cudaMemcpyDeviceToHost, stream ) );
+            OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+
+            table.findPreviousTriangles( hashKeys.data(), triangleIds.data(), batchSize, previousIds.data() );
+
+            // the unsorted batch buffers are free after sorting
+            OMM_CUDA_CHECK( cudaMemcpyAsync( m_inIdBuf.access(), previousIds.data(), batchSize * sizeof( TriangleID ), cudaMemcpyHostToDevice, stream ) );
+
+            {
+                MarkBatchDuplicatesParams params;
+                params.numTriangles          = batchSize;
+                params.inTriangleIDs         = m_outIdBuf.access();
+                params.inPreviousTriangleIDs = m_inIdBuf.access();
+                params.inBakeInputs          = m_inputBuf.access();
+                params.outDuplicates         = m_inHashBuf.access();
+
+                OMM_CUDA_CHECK( launchMarkBatchDuplicates( params, stream ) );
+            }
+
+            OMM_CUDA_CHECK( cudaMemcpyAsync( duplicates.data(), m_inHashBuf.access(), batchSize * sizeof( uint32_t ), cudaMemcpyDeviceToHost, stream ) );
+            OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+
+            hostAddMarkedBatch( table, hashKeys.data(), triangleIds.data(), duplicates.data(), batchSize, triangleOffsetPerInput.data(), batchBegin, assignments.data(), m_indexFormat );
+
+            // upload the omm indices of the batch, in order of discovery, to the index buffers of the inputs it spans.
+            // the next download synchronizes before the host buffers are reused.
+            for( uint32_t i = batchInputIdx; i <= inputIdx; ++i )
+            {
+                const uint32_t begin = std::max( batchBegin, triangleOffsetPerInput[i] );
+                const uint32_t end   = std::min( batchBegin + batchSize, triangleOffsetPerInput[i] + getNumTriangles( m_inputs[i] ) );
+                if( begin >= end )
+                    continue;
+
+                unsigned char* dst = ( unsigned char* )bakeInputs[i].outAssignments + ( size_t )( begin - triangleOffsetPerInput[i] ) * indexSizeInBytes;
+                OMM_CUDA_CHECK( cudaMemcpyAsync( dst, assignments.data() + ( size_t )( begin - batchBegin ) * indexSizeInBytes, ( size_t )( end - begin ) * indexSizeInBytes, cudaMemcpyHostToDevice, stream ) );
+            }
+
+            reportStage( BakeStage::ASSIGNMENT, true, stream );
+        }
+
+        reportStage( BakeStage::ASSIGNMENT, false, stream );
+
+        // 6. Output a representative triangle and the area of all omms in single pass order.
+
+        const std::vector<uint32_t> finalIndices = table.getFinalIndices();
+
+        const uint32_t numOmms = std::min( m_maxNumOmms, table.getNumOmms() );
+
+        std::vector<TriangleID> ommIds( numOmms );
+        for( uint32_t i = 0; i < table.getNumOmms(); ++i )
+        {
+            // excess omms are marked as unknown by hostRemapBatchedAssignment
+            if( finalIndices[i] < m_maxNumOmms )
+                ommIds[finalIndices[i]] = table.getTriangleId( i );
+        }
+
+        OMM_CUDA_CHECK( cudaMemcpyAsync( m_ommIdBuf.access(), ommIds.data(), numOmms * sizeof( TriangleID ), cudaMemcpyHostToDevice, stream ) );
+        OMM_CUDA_CHECK( cudaMemcpyAsync( m_numOmmsBuf.access(), &numOmms, sizeof( uint32_t ), cudaMemcpyHostToDevice, stream ) );
+
+        CudaMemsetAsync( m_ommAreaBuf, stream );
+
+        {
+            GenerateBatchedOmmAreaParams params;
+            params.numOmms            = numOmms;
+            params.inTriangleIdPerOmm = m_ommIdBuf.access();
+            params.inBakeInputs       = m_inputBuf.access();
+            params.outOmmArea         = m_ommAreaBuf.access();
+
+            OMM_CUDA_CHECK( launchGenerateBatchedOmmArea( params, stream ) );
+        }
+
+        // 7. Remap the omm indices to single pass order, a batch sized range of the index buffers at a time.
+
+        for( uint32_t i = 0; i < m_inputs.size(); ++i )
+        {
+            const uint32_t numTriangles = getNumTriangles( m_inputs[i] );
+            for( uint32_t begin = 0; begin < numTriangles; begin += m_batchSize )
+            {
+                const uint32_t rangeSize   = std::min( m_batchSize, numTriangles - begin );
+                unsigned char* rangeBuffer = ( unsigned char* )bakeInputs[i].outAssignments + ( size_t )begin * indexSizeInBytes;
+
+                OMM_CUDA_CHECK( cudaMemcpyAsync( assignments.data(), rangeBuffer, ( size_t )rangeSize * indexSizeInBytes, cudaMemcpyDeviceToHost, stream ) );
+                OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+
+                hostRemapBatchedAssignment( assignments.data(), m_indexFormat, rangeSize, finalIndices.data(), m_maxNumOmms );
+
+                OMM_CUDA_CHECK( cudaMemcpyAsync( rangeBuffer, assignments.data(), ( size_t )rangeSize * indexSizeInBytes, cudaMemcpyHostToDevice, stream ) );
+            }
+        }
+
+        // the host buffers must stay alive until the uploads complete
+        OMM_CUDA_CHECK( cudaStreamSynchronize( stream ) );
+
+        reportStage( BakeStage::ASSIGNMENT, true, stream );
+    }
+
+    // Host version of steps 3 to 7 of execute.
+    void assignOmmsHost( const std::vector<BakeInput>& bakeInputs )
+    {
+        // 3. Setup triangles, detect uniforms and generate hashes for duplicate detection.
+
+        uint32_t triangleOffset = 0;
+        for( uint32_t i = 0; i < m_inputs.size(); ++i )
+        {
+            SetupBakeInputParams params = {};
+
+            params.numTriangles   = getNumTriangles( m_inputs[i] );
+            params.inputIdx       = i;
+            params.outTriangleIDs = m_inIdBuf.access() + triangleOffset;
+            params.outHashKeys    = m_inHashBuf.access() + triangleOffset;
+            params.textures       = bakeInputs[i].inTextures;
+            params.input          = m_inputs[i];
+            params.format         = m_options.format;
+
+            hostSetupBakeInput( params );
+
+            triangleOffset += params.numTriangles;
+        }
+
+        reportStage( BakeStage::SETUP, true, 0 );
+        reportStage( BakeStage::SORT, false, 0 );
+
+        // 4. Sort triangles by their hash keys
+
+        hostSortPairs( m_inHashBuf.access(), m_outHashBuf.access(), m_inIdBuf.access(), m_outIdBuf.access(), m_numTriangles );
+
+        reportStage( BakeStage::SORT, true, 0 );
+        reportStage( BakeStage::ASSIGNMENT, false, 0 );
+
+        // 5. Find and mark the start of duplicate groups in the sorted triangle list.
+
+        {
+            MarkFirstOmmOccuranceParams params;
+            params.numTriangles = m_numTriangles;
+            params.inHashKeys = m_outHashBuf.access();
+            params.inTriangleIDs = m_outIdBuf.access();
+            params.outMarkers = m_inMarkersBuf.access();
+            params.inBakeInputs = m_inputBuf.access();
+
+            hostMarkFirstOmmOccurance( params );
+        }
+
+        // 6. Generate flat omm assignment
+
+        hostInclusiveSum( m_inMarkersBuf.access(), m_outAssignmentBuf.access(), m_numTriangles );
+
+        // 7. Scatter the assignments into the per-input assigment buffers. Output omm area.
+
+        HostMemset( m_ommAreaBuf );
+
+        {
+            GenerateAssignmentParams params;
+            params.numTriangles = m_numTriangles;
+            params.inTriangleIDs = m_outIdBuf.access();
+            params.maxOmms = m_maxNumOmms;
+            params.outNumOmms = m_numOmmsBuf.access();
+            params.inAssignment = m_outAssignmentBuf.access();
+            params.outOmmTriangleId = m_ommIdBuf.access();
+            params.outOmmArea = m_ommAreaBuf.access();
+            params.inBakeInputs = m_inputBuf.access();
+            params.indexFormat = m_indexFormat;
+
+            hostGenerateAssignment( params );
+        }
+
+        reportStage( BakeStage::ASSIGNMENT, true, 0 );
+    }
+
+    // Host version of steps 3 to 7 of execute, processing the triangles in batches.
+    // The omms of each batch are merged into a table of unique omms, and the omm indices of the batch
+    // triangles in order of discovery are written to the index buffers. After all batches, the omms
+    // are put in the same order as in a single pass, and the omm indices are remapped accordingly.
+    void assignOmmsHostBatched( const std::vector<BakeInput>& bakeInputs )
+    {
+        // the setup of steps 1 and 2 is reported separately from the setup of the batches
+        reportStage( BakeStage::SETUP, true, 0 );
+
+        DuplicateTable table;
+
+        uint32_t inputIdx      = 0;
+        uint32_t inputTriangle = 0;
+        for( uint32_t batchBegin = 0; batchBegin < m_numTriangles; batchBegin += m_batchSize )
+        {
+            const uint32_t batchSize = std::min( m_batchSize, m_numTriangles - batchBegin );
+
+            reportStage( BakeStage::SETUP, false, 0 );
+
+            // 3. Setup the batch triangles, which may span multiple inputs.
+
+            for( uint32_t batchOffset = 0; batchOffset < batchSize; )
+            {
+                // skip completed inputs
+                while( inputTriangle == getNumTriangles( m_inputs[inputIdx] ) )
+                {
+                    inputIdx++;
+                    inputTriangle = 0;
+                }
+
+                SetupBakeInputParams params = {};
+
+                params.numTriangles   = std::min( batchSize - batchOffset, getNumTriangles( m_inputs[inputIdx] ) - inputTriangle );
+                params.firstTriangle  = inputTriangle;
+                params.inputIdx       = inputIdx;
+                params.outTriangleIDs = m_inIdBuf.access() + batchOffset;
+                params.outHashKeys    = m_inHashBuf.access() + batchOffset;
+                params.textures       = bakeInputs[inputIdx].inTextures;
+                params.input          = m_inputs[inputIdx];
+                params.format         = m_options.format;
+
+                hostSetupBakeInput( params );
+
+                batchOffset += params.numTriangles;
+                inputTriangle += params.numTriangles;
+            }
+
+            reportStage( BakeStage::SETUP, true, 0 );
+            reportStage( BakeStage::SORT, false, 0 );
+
+            // 4. Sort the batch triangles by their hash keys
+
+            hostSortPairs( m_inHashBuf.access(), m_outHashBuf.access(), m_inIdBuf.access(), m_outIdBuf.access(), batchSize );
+
+            reportStage( BakeStage::SORT, true, 0 );
+            reportStage( BakeStage::ASSIGNMENT, false, 0 );
+
+            // 5. Merge the batch into the table of unique omms.
+
+            hostAddBatch( table, m_outHashBuf.access(), m_outIdBuf.access(), batchSize, m_inputBuf.access(), m_indexFormat );
+
+            reportStage( BakeStage::ASSIGNMENT, true, 0 );
+        }
+
+        reportStage( BakeStage::ASSIGNMENT, false, 0 );
+
+        // 6. Output a representative triangle and the area of all omms in single pass order.
+
+        const std::vector<uint32_t> finalIndices = table.getFinalIndices();
+
+        HostMemset( m_ommAreaBuf );
+
+        {
+            GenerateAssignmentParams params = {};
+            params.maxOmms = m_maxNumOmms;
+            params.outNumOmms = m_numOmmsBuf.access();
+            params.outOmmTriangleId = m_ommIdBuf.access();
+            params.outOmmArea = m_ommAreaBuf.access();
+            params.inBakeInputs = m_inputBuf.access();
+
+            hostGenerateBatchedOmms( table, finalIndices.data(), params );
+        }
+
+        // 7. Remap the omm indices to single pass order.
+
+        for( uint32_t i = 0; i < m_inputs.size(); ++i )
+            hostRemapBatchedAssignment( bakeInputs[i].outAssignments, m_indexFormat, getNumTriangles( m_inputs[i] ), finalIndices.data(), m_maxNumOmms );
+
+        reportStage( BakeStage::ASSIGNMENT, true, 0 );
+    }
+
+    // Report the begin or end of a baking stage to the instrumentation callback.
+    void reportStage( BakeStage stage, bool end, cudaStream_t stream ) const
+    {
+        if( m_options.stageCallback )
+            m_options.stageCallback( stage, end, stream, m_options.stageCallbackUserData );
+    }
+
+    // Size of the temporary storage of sorting a number of triangles on the device.
+    size_t getSortTempSizeInBytes( uint32_t numTriangles ) const
+    {
+        size_t tempSizeInBytes = 0;
+        cudaError_t error = SortPairs<uint32_t, TriangleID>()( 0, tempSizeInBytes, 0, 0, 0, 0, numTriangles, 0, sizeof( uint32_t ) * 8, 0 );
+        OMM_CUDA_CHECK( error );
+        return tempSizeInBytes;
+    }
+
+    // Place the batch buffers after the temp buffer.
+    void materializeBatchBuffers( unsigned char* tempBuffer )
+    {
+        if( m_isBatched )
+            m_batchBuf.materialize( ( unsigned char* )( ( uintptr_t )tempBuffer + m_temp.getNumBytes() ) );
+    }
+
+    // Size of the temp buffer, including the batch buffers.
+    size_t getTempSizeInBytes() const
+    {
+        return m_temp.getNumBytes() + ( m_isBatched ? m_batchBuf.getNumBytes() : 0 );
+    }
+
+    void validate( const BakeOptions& options )
+    {
+        if( ( options.flags & ~( BakeFlags::ENABLE_POST_BAKE_INFO | BakeFlags::BAKE_ON_HOST | BakeFlags::ADAPTIVE_SUBDIVISION ) ) != BakeFlags::NONE )
+            throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %u for options.flags. Contains invalid flags.", (uint32_t) options.flags ) );
+
+        if( options.subdivisionScale < 0.f || std::isnan( options.subdivisionScale ) )
+            throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %f for options.subdivisionScale. Must be real positive value.", options.subdivisionScale ) );
+
+        switch( options.format )
+        {
+        case OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE:
+        case OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE:
+            break;
+        default:
+            throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %i for options.format.", options.format ) );
+            break;
+        }
+    }
+
+    void validate( const TextureDesc& texture, uint32_t inputIdx, uint32_t textureIdx, bool isPreBake )
+    {
+        switch( texture.type )
+        {
+        case TextureType::CUDA:
+            if( texture.cuda.texObject == 0 )
+                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value for inputs[%u].textures[%u].cuda.texObject. Must not be zero.", inputIdx, textureIdx ) );
+
+            if( std::isnan(texture.cuda.transparencyCutoff) )
+                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %f for inputs[%u].textures[%u].cuda.transparencyCutoff.",
+                    texture.cuda.transparencyCutoff, inputIdx, textureIdx ) );
+
+            if( std::isnan( texture.cuda.opacityCutoff ) )
+                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %f for inputs[%u].textures[%u].cuda.opacityCutoff.",
+                    texture.cuda.opacityCutoff, inputIdx, textureIdx ) );
+
+            if( texture.cuda.transparencyCutoff > texture.cuda.opacityCutoff )
+                throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %f for inputs[%u].textures[%u].cuda.transparencyCutoff. Must not be larger than value %f of inputs[%u].textures[%u].cuda.opacityCutoff.",
+                    texture.cuda.transparencyCutoff, inputIdx, textureIdx, texture.cuda.opacityCutoff, inputIdx, textureIdx ) );
+            break;
+        case TextureType::STATE:
+        {
+            auto validateAddressMode = [&]( uint32_t dim ) {
+                switch( texture.state.addressMode[dim] )
+                {
+                case cudaAddressModeWrap:
+                case cudaAddressModeClamp:
+                case cudaAddressModeMirror:
+                    break;
+                default:
+                    throw Exception( Result::ERROR_INVALID_VALUE, stringf( "Invalid value %u for inputs[%u].textures[%u].state.addressMode[%i].",
+                        texture.state.addressMode[dim], inputIdx, textureIdx, dim ) );
                 }
             };
 
@@ -1373,6 +2223,13 @@ private:
     BakeOptions                m_options;
     std::vector<BakeInputDesc> m_inputs;
 
+    // all buffers are in host memory and the baking runs on the host.
+    bool m_isHostBake = false;
+
+    // the triangles are processed in batches of m_batchSize triangles, to limit the temp buffer size.
+    bool     m_isBatched = false;
+    uint32_t m_batchSize = 0;
+
     uint32_t m_numTriangles;
     
     // conservative upper bound
@@ -1412,6 +2269,8 @@ private:
     BufferLayout<TriangleID>   m_ommIdBuf;
     BufferLayout<float>        m_sumAreaBuf;
     BufferLayout<float>        m_ommAreaBuf;
+    BufferLayout<OmmUnknownStatistics> m_statsBuf;
+    BufferLayout<Triangle>     m_ommTriangleBuf;
     BufferLayout<BakeInput>   m_inputBuf;
     BufferLayout<TextureInput> m_textureBuf;
 
@@ -1421,6 +2280,9 @@ private:
     // auxiliary buffers to facilitate overlaying of temporary buffers with disjoint lifetimes
     BufferLayout<> m_overlay[4];
 
+    // per batch temporary buffers, placed after the temp buffer in batched mode
+    BufferLayout<> m_batchBuf;
+
     // texture descriptors mapping to summed area table encoding.
     TextureMap m_textureMap;
 };
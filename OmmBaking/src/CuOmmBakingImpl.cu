@@ -3,8 +3,6 @@
 //
 
 #include "CuOmmBakingImpl.h"
-#include "Evaluate.h"
-#include "Triangle.h"
 #include "SummedAreaTable.h"
 
 #include <assert.h>
@@ -44,91 +42,14 @@ __device__ __host__ float __uint_as_float( unsigned int i )
     return result.f;
 }
 
-__device__ OpacityStateSet sampleTextureState( const TextureInput* textures, Triangle triangle, unsigned resolution )
-{
-    const TextureData& texture = textures[triangle.texture].data;
-
-    const float2 scale = { ( float )texture.width, ( float )texture.height };
-
-    float2 uv0 = triangle.uv0 * scale;
-    float2 uv1 = triangle.uv1 * scale;
-    float2 uv2 = triangle.uv2 * scale;
-
-    return sampleMemoryTexture( texture, uv0, uv1, uv2, texture.filterKernelRadiusInTexels, resolution );
-}
-
-#include <optix_micromap.h>
+#include "Bake.h"
 
 __global__ void setupBakeInput( SetupBakeInputParams params )
 {
     uint32_t index = threadIdx.x + blockIdx.x * blockDim.x;
 
     if( index < params.numTriangles )
-    {
-        TriangleID id = {};
-        id.triangleIndex = index;
-        id.inputIndex = params.inputIdx;
-
-        Triangle triangle = loadTriangle( params.input, index );
-
-        OpacityStateSet state = {};
-        // filter out invalid triangles
-        if( !isnan( triangle.Area() ) )
-            state = sampleTextureState( params.textures, triangle, 16 );
-
-        id.uniform = 1;
-        if( params.format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE )
-        {
-            // conservatively mark everything as opaque except fully transparent triangles.
-            if( state.isTransparent() )
-            {
-                id.state = OPTIX_OPACITY_MICROMAP_STATE_TRANSPARENT;
-            }
-            else if( state.hasTransparent() )
-            {
-                // has a mixture of transparent and non-transparent states.
-                id.uniform = 0;
-            }
-            else
-            {
-                // mixtures of opaque and unknown are marked as opaque.
-                id.state = OPTIX_OPACITY_MICROMAP_STATE_OPAQUE;
-            }
-        }
-        else // OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE
-        {
-            if( !state.isUniform() )
-            {
-                // has a mixture of states
-                id.uniform = 0;
-            }
-            else
-            {
-                if( state.isTransparent() )
-                {
-                    id.state = OPTIX_OPACITY_MICROMAP_STATE_TRANSPARENT;
-                }
-                else if( state.isOpaque() )
-                {
-                    id.state = OPTIX_OPACITY_MICROMAP_STATE_OPAQUE;
-                }
-                else
-                {
-                    id.state = OPTIX_OPACITY_MICROMAP_STATE_UNKNOWN_OPAQUE;
-                }
-            }
-        }
-
-        uint32_t key = 0;
-        if( id.uniform == 0 )
-        {
-            id.uniform = 0;
-            key = hash( canonicalizeTriangle( triangle, params.textures ) );
-        }
-
-        params.outTriangleIDs[index] = id;
-        params.outHashKeys[index] = key;
-    }
+        setupTriangle( params, index, params.outTriangleIDs[index], params.outHashKeys[index] );
 }
 
 __host__ cudaError_t launchSetupBakeInput( SetupBakeInputParams params, cudaStream_t stream )
@@ -146,47 +67,7 @@ __global__ void markFirstOmmOccurance( MarkFirstOmmOccuranceParams params )
     uint32_t index = threadIdx.x + blockIdx.x * blockDim.x;
 
     if( index < params.numTriangles )
-    {
-        bool isNewDuplicateGroup;
-
-        TriangleID id = params.inTriangleIDs[index];
-
-        // skip fully opaque/transparent triangles
-        if( id.uniform )
-        {
-            isNewDuplicateGroup = false;
-        }
-        else
-        {
-            // early out hash check. if the hashes don't match there's no need to perform the costly collision check.
-            if( index > 0 && params.inHashKeys[index - 1] == params.inHashKeys[index] )
-            {
-                TriangleID prevId = params.inTriangleIDs[index-1];
-
-                Triangle nextTriangle = loadTriangle( params.inBakeInputs[id.inputIndex].desc, id.triangleIndex );
-                Triangle prevTriangle = loadTriangle( params.inBakeInputs[prevId.inputIndex].desc, prevId.triangleIndex );
-
-                if( prevTriangle.texture != nextTriangle.texture )
-                {
-                    isNewDuplicateGroup = true;
-                }
-                else
-                {
-                    // compare the canonicalized triangles to match near identical triangles and match under wrapping.
-                    nextTriangle = canonicalizeTriangle( nextTriangle, params.inBakeInputs[id.inputIndex].inTextures );
-                    prevTriangle = canonicalizeTriangle( prevTriangle, params.inBakeInputs[id.inputIndex].inTextures );
-
-                    isNewDuplicateGroup = ( nextTriangle != prevTriangle );
-                }                
-            }
-            else
-            {
-                isNewDuplicateGroup = true;
-            }
-        }
-
-        params.outMarkers[index] = isNewDuplicateGroup ? 1 : 0;
-    }
+        params.outMarkers[index] = isFirstOmmOccurance( params, index ) ? 1 : 0;
 }
 
 __host__ cudaError_t launchMarkFirstOmmOccurance( MarkFirstOmmOccuranceParams params, cudaStream_t stream )
@@ -205,51 +86,7 @@ __global__ void generateAssignment( GenerateAssignmentParams params )
 
     if( index < params.numTriangles )
     {
-        TriangleID id = params.inTriangleIDs[index];
-        uint32_t   assignment;
-        if( !id.uniform ) {
-            assignment = params.inAssignment[index] - 1;
-
-            // crude method to prevent omm array overflow by marking any excess omms as unkown. 
-            if( assignment >= params.maxOmms )
-            {
-                assignment = ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_UNKNOWN_OPAQUE;
-            }
-            // write out a representative triangle id for each duplicate group
-            else if( index == 0 || assignment != (params.inAssignment[index - 1] - 1) )
-            {
-                params.outOmmTriangleId[assignment] = id;
-
-                const BakeInput& input = params.inBakeInputs[id.inputIndex];
-
-                Triangle triangle = loadTriangle( input.desc, id.triangleIndex );
-
-                // compute area in texels
-                const TextureInput& textureInput = input.inTextures[triangle.texture];
-                float2 scale = {
-                    ( float )textureInput.data.width,
-                    ( float )textureInput.data.height };
-                triangle.uv0 *= scale;
-                triangle.uv1 *= scale;
-                triangle.uv2 *= scale;
-
-                params.outOmmArea[assignment] = triangle.Area();
-            }
-        } else if( id.state == 0 ) {
-            assignment = ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_TRANSPARENT;
-        } else if( id.state == 1 ) {
-            assignment = ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_OPAQUE;
-        } else if( id.state == 2 ) {
-            assignment = ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_UNKNOWN_TRANSPARENT;
-        } else if( id.state == 3 ) {
-            assignment = ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_UNKNOWN_OPAQUE;
-        }
-
-        void* outAssignments = params.inBakeInputs[id.inputIndex].outAssignments;
-        if( params.indexFormat == cuOmmBaking::IndexFormat::I16_UINT )
-            (( uint16_t* )outAssignments)[id.triangleIndex] = assignment;
-        else
-            (( uint32_t* )outAssignments)[id.triangleIndex] = assignment;
+        assignTriangle( params, index );
     }
     else if( index == params.numTriangles )
     {
@@ -268,6 +105,48 @@ __host__ cudaError_t launchGenerateAssignment( GenerateAssignmentParams params,
     return cudaGetLastError();
 }
 
+__global__ void markBatchDuplicates( MarkBatchDuplicatesParams params )
+{
+    uint32_t index = threadIdx.x + blockIdx.x * blockDim.x;
+
+    if( index < params.numTriangles )
+    {
+        const TriangleID id = params.inTriangleIDs[index];
+        params.outDuplicates[index] = ( !id.uniform && isDuplicateTriangle( params.inBakeInputs, params.inPreviousTriangleIDs[index], id ) ) ? 1 : 0;
+    }
+}
+
+__host__ cudaError_t launchMarkBatchDuplicates( MarkBatchDuplicatesParams params, cudaStream_t stream )
+{
+    unsigned int numThreads = params.numTriangles;
+    dim3     threadsPerBlock( 128, 1 );
+    uint32_t numBlocks = ( uint32_t )( ( numThreads + threadsPerBlock.x - 1 ) / threadsPerBlock.x );
+    if( numThreads )
+        markBatchDuplicates<<<numBlocks, threadsPerBlock, 0, stream>>>( params );
+    return cudaGetLastError();
+}
+
+__global__ void generateBatchedOmmArea( GenerateBatchedOmmAreaParams params )
+{
+    uint32_t index = threadIdx.x + blockIdx.x * blockDim.x;
+
+    if( index < params.numOmms )
+    {
+        const TriangleID id = params.inTriangleIdPerOmm[index];
+        params.outOmmArea[index] = getOmmAreaInTexels( params.inBakeInputs[id.inputIndex], id.triangleIndex );
+    }
+}
+
+__host__ cudaError_t launchGenerateBatchedOmmArea( GenerateBatchedOmmAreaParams params, cudaStream_t stream )
+{
+    unsigned int numThreads = params.numOmms;
+    dim3     threadsPerBlock( 128, 1 );
+    uint32_t numBlocks = ( uint32_t )( ( numThreads + threadsPerBlock.x - 1 ) / threadsPerBlock.x );
+    if( numThreads )
+        generateBatchedOmmArea<<<numBlocks, threadsPerBlock, 0, stream>>>( params );
+    return cudaGetLastError();
+}
+
 __global__ void __launch_bounds__(128) generateLayout( GenerateLayoutParams params )
 {
     // Ideally, we'd launch one correctly sized kernel per omm.
@@ -292,39 +171,13 @@ __global__ void __launch_bounds__(128) generateLayout( GenerateLayoutParams para
         const uint32_t numOmms = *params.inNumOmms;
         const float    sumArea = params.inSumArea ? *params.inSumArea : 0;
 
-        const uint32_t logStatesPerByte = ( params.format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE ) ? 3 : 2;
+        const uint32_t logStatesPerByte = getLogStatesPerByte( params.format );
 
         while( index < numOmms )
         {
-            const float area = params.inOmmArea[index];
-
-            // the normalized weight determines the available share of omm data in bytes for this omm.
-            // the subdivision level is maximized within this available size bytes.
-            // the size share needs to be conservative to prevent over allocation and buffer overflow due to numerical rounding.
-            float normalizedWeight = ( sumArea > 0 )
-                ? __fdiv_rz( area, sumArea )
-                : __frcp_rd( ( float )numOmms );
-            uint32_t maxSizeInBytes = ( uint32_t )floorf( __fmaf_rz( normalizedWeight, ( float )( params.maxOmmArraySizeInBytes - numOmms ), 1.f ) );
-            uint32_t maxLogSizeInBytes = 31 - __clz( maxSizeInBytes );
-            uint32_t maxSubdivisionLevel = ( maxLogSizeInBytes + logStatesPerByte ) / 2;
-
-            uint32_t subdivisionLevel = maxSubdivisionLevel;
-
-            // clamp the subdivision level based on the target micro-triangle density
-            if( params.microTrianglesPerTexel )
-            {
-                float numMicroTriangles = area * params.microTrianglesPerTexel;
+            const uint32_t subdivisionLevel = getOmmSubdivisionLevel( params, params.inOmmArea[index], sumArea, numOmms );
 
-                uint32_t targetSubdivisionLevel = max( 1u, (uint32_t)roundf( 0.5f * log2f( numMicroTriangles ) ) );
-                
-                if( subdivisionLevel > targetSubdivisionLevel )
-                    subdivisionLevel = targetSubdivisionLevel;
-            }
-
-            if( subdivisionLevel > OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL )
-                subdivisionLevel = OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL;
-
-            sizeInBytes += 1u << ( max( 2u * subdivisionLevel, logStatesPerByte ) - logStatesPerByte );
+            sizeInBytes += getOmmSizeInBytes( subdivisionLevel, logStatesPerByte );
 
             assert( subdivisionLevel > 0 );
             assert( subdivisionLevel <= OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL );
@@ -416,7 +269,7 @@ struct OmmSizeInBytesInputIterator
     __device__ value_type operator[]( uint32_t offset ) const
     {
         uint32_t     ommIdx = offset;
-        unsigned int sizeInBytes = ( 1u << ( max( 2u * desc[ommIdx].subdivisionLevel, logStatesPerByte ) - logStatesPerByte ) );
+        unsigned int sizeInBytes = getOmmSizeInBytes( desc[ommIdx].subdivisionLevel, logStatesPerByte );
         return sizeInBytes ? sizeInBytes : 1;
     }
 
@@ -434,7 +287,7 @@ __host__ cudaError_t launchGenerateStartOffsets(
     OptixOpacityMicromapFormat format,
     cudaStream_t stream )
 {
-    const uint32_t logStatesPerByte = ( format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE ) ? 3 : 2;
+    const uint32_t logStatesPerByte = getLogStatesPerByte( format );
 
     OmmSizeInBytesInputIterator in( inDesc, logStatesPerByte );
     ByteOffsetOutputIterator out( outDesc );
@@ -455,21 +308,7 @@ __global__ void __launch_bounds__( 128 ) GenerateInputHistogram( GenerateInputHi
 
     if( index < params.numTriangles )
     {
-        uint32_t assignment;
-        if( params.indexFormat == cuOmmBaking::IndexFormat::I16_UINT )
-        {
-            uint16_t assignment16 = ( ( const uint16_t* )params.inAssignment )[index];
-
-            // preserve predefined assignments
-            if( assignment16 >= ( uint16_t )( -4 ) )
-                assignment = (uint32_t)(int32_t)(int16_t)assignment16;
-            else
-                assignment = assignment16;
-        }
-        else
-        {
-            assignment = ( ( const uint32_t* )params.inAssignment )[index];
-        }
+        uint32_t assignment = loadAssignment( params.inAssignment, params.indexFormat, index );
 
         // skip predefined assignments
         if( assignment < ( uint32_t )( -4 ) )
@@ -495,27 +334,6 @@ __host__ cudaError_t launchGenerateInputHistogram( GenerateInputHistogramParams
     return cudaGetLastError();
 }
 
-__device__ OpacityStateSet evaluateMicroTriangleOpacity( const BakeInput* input, uint32_t subdivisionLevel, TriangleID id, uint32_t microTriangleIndex )
-{
-    float2 uv0, uv1, uv2;
-    optixMicromapIndexToBaseBarycentrics(
-        microTriangleIndex,
-        subdivisionLevel,
-        uv0, uv1, uv2 );
-
-    Triangle triangle = loadTriangle( input[id.inputIndex].desc, id.triangleIndex );
-
-    float2 du = triangle.uv1 - triangle.uv0;
-    float2 dv = triangle.uv2 - triangle.uv0;
-
-    // convert micro-triangle uvs to texture uvs
-    triangle.uv1 = triangle.uv0 + uv1.x * du + uv1.y * dv;
-    triangle.uv2 = triangle.uv0 + uv2.x * du + uv2.y * dv;
-    triangle.uv0 += uv0.x * du + uv0.y * dv;
-
-    return sampleTextureState( input[id.inputIndex].inTextures, triangle, 1 );
-}
-
 struct Or
 {
     /// logical or operator, returns <tt>a | b</tt>
@@ -541,7 +359,7 @@ __global__ void __launch_bounds__( 128 ) evaluateOmmOpacity( EvaluateOmmOpacityP
     
     assert( sizeInBytes <= params.dataSizeInBytes );
 
-    const uint32_t logStatesPerByte = ( params.format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE ) ? 3 : 2;
+    const uint32_t logStatesPerByte = getLogStatesPerByte( params.format );
 
     const uint64_t numMicroTriangles = ( uint64_t )sizeInBytes << logStatesPerByte;
     
@@ -549,6 +367,7 @@ __global__ void __launch_bounds__( 128 ) evaluateOmmOpacity( EvaluateOmmOpacityP
     for( ; __any_sync(~0u, index < numMicroTriangles); index += indexStride )
     {
         OpacityStateSet state = {};
+        bool            isCached = false;
 
         if( index < numMicroTriangles )
         {
@@ -565,14 +384,16 @@ __global__ void __launch_bounds__( 128 ) evaluateOmmOpacity( EvaluateOmmOpacityP
 
             TriangleID id = params.inTriangleIdPerOmm[ommIndex];
 
-            assert( !id.uniform );
+            // omms copied from the bake cache are marked uniform and keep their data.
+            isCached = id.uniform;
 
             uint32_t subdivisionLevel = desc.subdivisionLevel;
 
             // 2-state subdiv level 0 and 1, and 4-state subdiv level 0 cover less than one byte.
-            if( microTriangleIndex < ( 1u << ( 2 * subdivisionLevel ) ) )
+            if( !isCached && microTriangleIndex < ( 1u << ( 2 * subdivisionLevel ) ) )
             {
-                state = evaluateMicroTriangleOpacity( params.inBakeInputs, subdivisionLevel, id, microTriangleIndex );
+                const BakeInput& input = params.inBakeInputs[id.inputIndex];
+                state = evaluateMicroTriangleOpacity( input.inTextures, loadTriangle( input.desc, id.triangleIndex ), subdivisionLevel, microTriangleIndex );
             }
         }
 
@@ -581,12 +402,7 @@ __global__ void __launch_bounds__( 128 ) evaluateOmmOpacity( EvaluateOmmOpacityP
 
         if( params.format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE )
         {
-            // all but fully transparent micro triangles are marked as opaque
-            uint32_t opacityState;
-            if( state.isTransparent() )
-                opacityState = OPTIX_OPACITY_MICROMAP_STATE_TRANSPARENT;
-            else
-                opacityState = OPTIX_OPACITY_MICROMAP_STATE_OPAQUE;
+            uint32_t opacityState = isCached ? 0 : getMicroTriangleState( state, params.format );
 
             uint32_t mask = ( uint32_t )opacityState << ( lane );
 
@@ -606,13 +422,7 @@ __global__ void __launch_bounds__( 128 ) evaluateOmmOpacity( EvaluateOmmOpacityP
         }
         else // OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE
         {
-            uint32_t opacityState;
-            if( state.isTransparent() )
-                opacityState = OPTIX_OPACITY_MICROMAP_STATE_TRANSPARENT;
-            else if( state.isOpaque() )
-                opacityState = OPTIX_OPACITY_MICROMAP_STATE_OPAQUE;
-            else
-                opacityState = OPTIX_OPACITY_MICROMAP_STATE_UNKNOWN_OPAQUE;
+            uint32_t opacityState = isCached ? 0 : getMicroTriangleState( state, params.format );
 
             uint64_t mask = ( uint64_t )opacityState << ( 2 * lane );
 
@@ -642,6 +452,41 @@ __host__ cudaError_t launchEvaluateOmmOpacity( EvaluateOmmOpacityParams params,
     return cudaGetLastError();
 }
 
+__global__ void gatherOmmTriangles( GatherOmmTrianglesParams params )
+{
+    uint32_t index = threadIdx.x + blockIdx.x * blockDim.x;
+
+    if( index < params.numOmms )
+        gatherOmmTriangle( params, index );
+}
+
+__host__ cudaError_t launchGatherOmmTriangles( GatherOmmTrianglesParams params, cudaStream_t stream )
+{
+    dim3     threadsPerBlock( 128, 1 );
+    uint32_t numBlocks = ( uint32_t )( ( params.numOmms + threadsPerBlock.x - 1 ) / threadsPerBlock.x );
+    if( params.numOmms )
+        gatherOmmTriangles<<<numBlocks, threadsPerBlock, 0, stream>>>( params );
+    return cudaGetLastError();
+}
+
+__global__ void __launch_bounds__( 128 ) generateUnknownStatistics( GenerateUnknownStatisticsParams params )
+{
+    // the number of omms is not known on the host, so the launch covers the maximum number of omms.
+    uint32_t index = threadIdx.x + blockIdx.x * blockDim.x;
+
+    if( index < *params.inNumOmms )
+        generateOmmUnknownStatistics( params, index );
+}
+
+__host__ cudaError_t launchGenerateUnknownStatistics( GenerateUnknownStatisticsParams params, unsigned int numThreads, cudaStream_t stream )
+{
+    dim3     threadsPerBlock( 128, 1 );
+    uint32_t numBlocks = ( uint32_t )( ( numThreads + threadsPerBlock.x - 1 ) / threadsPerBlock.x );
+    if( numThreads )
+        generateUnknownStatistics<<<numBlocks, threadsPerBlock, 0, stream>>>( params );
+    return cudaGetLastError();
+}
+
 /**
  * \brief Rounding up sum functor
  */
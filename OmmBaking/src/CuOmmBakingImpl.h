@@ -71,12 +71,14 @@ struct SetupBakeInputParams
 {
     // number of input triangles.
     uint32_t numTriangles;
+    // index of the first input triangle.
+    uint32_t firstTriangle;
     // index of the current input.
     uint32_t inputIdx;
 
-    // ids for all input triangles.
+    // ids for all input triangles, starting at the first triangle.
     TriangleID* outTriangleIDs;
-    // hash keys for all input triangles.
+    // hash keys for all input triangles, starting at the first triangle.
     uint32_t* outHashKeys;
 
     // texture inputs for this bake input
@@ -134,6 +136,35 @@ struct GenerateAssignmentParams
     float* outOmmArea;
 };
 
+struct MarkBatchDuplicatesParams
+{
+    uint32_t numTriangles;
+
+    // batch triangle ids, sorted by hash key.
+    const TriangleID* inTriangleIDs;
+    // per batch triangle, the triangle it is compared with. see DuplicateTable::findPreviousTriangles.
+    const TriangleID* inPreviousTriangleIDs;
+    // bake input descriptors.
+    const BakeInput* inBakeInputs;
+
+    // set to one if a non-uniform triangle is a duplicate of its previous triangle.
+    uint32_t* outDuplicates;
+};
+
+struct GenerateBatchedOmmAreaParams
+{
+    // total number of opacticy micromaps.
+    uint32_t numOmms;
+
+    // per omm triangle ID of one of the triangles in the dupplicate group.
+    const TriangleID* inTriangleIdPerOmm;
+    // bake input descriptors.
+    const BakeInput* inBakeInputs;
+
+    // area in texels per opacticy micromap.
+    float* outOmmArea;
+};
+
 struct GenerateLayoutParams
 {
     // per opacticy micromaps area in texels.
@@ -187,6 +218,7 @@ struct EvaluateOmmOpacityParams
     void* ioData;
 
     // per omm triangle ID of one of the triangles in the dupplicate group.
+    // omms marked uniform were copied from the bake cache and are not evaluated.
     const TriangleID* inTriangleIdPerOmm;
 
     // bake input descriptors.
@@ -199,6 +231,48 @@ struct EvaluateOmmOpacityParams
     OptixOpacityMicromapFormat format;
 };
 
+struct Triangle;
+
+struct GatherOmmTrianglesParams
+{
+    uint32_t numOmms;
+
+    // per omm triangle ID of one of the triangles in the dupplicate group.
+    const TriangleID* inTriangleIdPerOmm;
+
+    // bake input descriptors.
+    const BakeInput* inBakeInputs;
+
+    // texture inputs of all bake inputs.
+    const TextureInput* inTextures;
+
+    // per omm representative triangle. the texture index is offset to index inTextures.
+    Triangle* outTriangles;
+};
+
+struct OmmUnknownStatistics;
+
+struct GenerateUnknownStatisticsParams
+{
+    // total number of opacticy micromaps.
+    const uint32_t* inNumOmms;
+
+    // per opacticy micromaps area in texels.
+    const float* inOmmArea;
+
+    // per omm triangle ID of one of the triangles in the dupplicate group.
+    const TriangleID* inTriangleIdPerOmm;
+
+    // bake input descriptors.
+    const BakeInput* inBakeInputs;
+
+    // target subdivision level in micro-triangles per texel.
+    float microTrianglesPerTexel;
+
+    // per omm unknown micro triangle statistics.
+    OmmUnknownStatistics* outStats;
+};
+
 // setup all a single bake input.
 cudaError_t launchSetupBakeInput( SetupBakeInputParams params, cudaStream_t stream );
 
@@ -208,6 +282,12 @@ cudaError_t launchMarkFirstOmmOccurance( MarkFirstOmmOccuranceParams params, cud
 // generate omm assignments for all triangles in all bake inputs.
 cudaError_t launchGenerateAssignment( GenerateAssignmentParams params, cudaStream_t stream );
 
+// compare the triangles of a sorted batch with their previous triangles, for the de-duplication across batches.
+cudaError_t launchMarkBatchDuplicates( MarkBatchDuplicatesParams params, cudaStream_t stream );
+
+// output the area of all omms of a batched bake.
+cudaError_t launchGenerateBatchedOmmArea( GenerateBatchedOmmAreaParams params, cudaStream_t stream );
+
 // generate the omm layout, dynamically assigning subdivision levels.
 cudaError_t launchGenerateLayout( GenerateLayoutParams params, unsigned int numThreads, cudaStream_t stream );
 
@@ -227,6 +307,12 @@ cudaError_t launchGenerateInputHistogram( GenerateInputHistogramParams params, c
 // evaluate the opacity of all micro triangles in all opacity micro maps.
 cudaError_t launchEvaluateOmmOpacity( EvaluateOmmOpacityParams params, unsigned int numThreads, cudaStream_t stream );
 
+// gather the representative triangles of all omms, for the bake cache.
+cudaError_t launchGatherOmmTriangles( GatherOmmTrianglesParams params, cudaStream_t stream );
+
+// count the unknown micro triangles of all omms at the lowest subdivision levels, for the adaptive layout.
+cudaError_t launchGenerateUnknownStatistics( GenerateUnknownStatisticsParams params, unsigned int numThreads, cudaStream_t stream );
+
 // Functor encapsulating cuda cub Reduction.
 // The template implementations are exlicitly instanciated in OmmBakingImpl.cu
 template <
@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "DuplicateTable.h"
+
+#include <algorithm>
+
+std::vector<uint32_t> DuplicateTable::getFinalIndices() const
+{
+    const uint32_t numOmms = getNumOmms();
+
+    // sort by hash key, and by order of addition within equal hash keys
+    std::vector<uint64_t> keys( numOmms );
+    for( uint32_t i = 0; i < numOmms; ++i )
+        keys[i] = ( ( uint64_t )m_hashKeys[i] << 32 ) | i;
+    std::sort( keys.begin(), keys.end() );
+
+    std::vector<uint32_t> finalIndices( numOmms );
+    for( uint32_t i = 0; i < numOmms; ++i )
+        finalIndices[( uint32_t )keys[i]] = i;
+
+    return finalIndices;
+}
+
+void DuplicateTable::findPreviousTriangles( const uint32_t* hashKeys, const TriangleID* triangleIds, uint32_t numTriangles, TriangleID* outPreviousIds ) const
+{
+    // the batch is sorted by hash key, so the preceding triangles with the same hash key form a run
+    uint32_t last = ~0u;
+    for( uint32_t i = 0; i < numTriangles; ++i )
+    {
+        const TriangleID id = triangleIds[i];
+        outPreviousIds[i]   = id;
+
+        if( last != ~0u && hashKeys[last] != hashKeys[i] )
+            last = ~0u;
+
+        if( id.uniform )
+            continue;
+
+        if( last != ~0u )
+        {
+            outPreviousIds[i] = triangleIds[last];
+        }
+        else
+        {
+            auto itr = m_lastTriangles.find( hashKeys[i] );
+            if( itr != m_lastTriangles.end() )
+                outPreviousIds[i] = itr->second.triangleId;
+        }
+
+        last = i;
+    }
+}
@@ -0,0 +1,76 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include "CuOmmBakingImpl.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Table of the unique opacity micromaps of triangles that are de-duplicated in batches.
+//
+// The table reproduces the duplicate detection of a single pass over all triangles sorted by hash key,
+// where a triangle shares the opacity micromap of the preceding triangle with the same hash key if the
+// two are duplicates. Batches must be added in input order, with the triangles of each batch stably
+// sorted by hash key. The table tracks the last added triangle per hash key, which is then the same
+// preceding triangle as in the single pass. Sorting the opacity micromaps by hash key and order of
+// addition yields the single pass opacity micromap order.
+class DuplicateTable
+{
+  public:
+    // Add a non-uniform triangle. Returns the index of its opacity micromap, in order of addition.
+    // isDuplicate( previousId, id ) returns true if triangle id shares the opacity micromap of the
+    // previously added triangle with the same hash key.
+    template <typename IsDuplicate>
+    uint32_t add( uint32_t hashKey, TriangleID id, const IsDuplicate& isDuplicate )
+    {
+        const uint32_t numOmms = getNumOmms();
+
+        auto  result = m_lastTriangles.emplace( hashKey, LastTriangle{ id, numOmms } );
+        auto& last   = result.first->second;
+        if( !result.second )
+        {
+            const bool duplicate = isDuplicate( last.triangleId, id );
+            last.triangleId      = id;
+            if( duplicate )
+                return last.ommIndex;
+            last.ommIndex = numOmms;
+        }
+
+        m_hashKeys.push_back( hashKey );
+        m_triangleIds.push_back( id );
+
+        return numOmms;
+    }
+
+    uint32_t getNumOmms() const { return ( uint32_t )m_hashKeys.size(); }
+
+    // The first triangle of an opacity micromap.
+    TriangleID getTriangleId( uint32_t ommIndex ) const { return m_triangleIds[ommIndex]; }
+
+    // Index of each opacity micromap in the single pass order, indexed by order of addition.
+    std::vector<uint32_t> getFinalIndices() const;
+
+    // The triangles that add passes to isDuplicate, for a batch that is yet to be added. This allows the duplicate
+    // checks of a batch to run ahead of adding it, e.g. on the device. The previous triangle of a non-uniform triangle
+    // is the preceding non-uniform triangle in the batch with the same hash key, or else the last added triangle with
+    // the same hash key. Triangles without a previous triangle, and uniform triangles, which are not added, are their
+    // own previous triangle.
+    void findPreviousTriangles( const uint32_t* hashKeys, const TriangleID* triangleIds, uint32_t numTriangles, TriangleID* outPreviousIds ) const;
+
+  private:
+    struct LastTriangle
+    {
+        TriangleID triangleId;
+        uint32_t   ommIndex;
+    };
+
+    std::unordered_map<uint32_t, LastTriangle> m_lastTriangles;
+
+    // per opacity micromap, in order of addition
+    std::vector<uint32_t>   m_hashKeys;
+    std::vector<TriangleID> m_triangleIds;
+};
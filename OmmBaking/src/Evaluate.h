@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cuda_runtime.h>
+#include "Util/Intrinsics.h"
 #include "Util/VecMath.h"
 #include "Util/Rasterize.h"
 #include "CuOmmBakingImpl.h"
@@ -12,22 +13,22 @@
 // Struct to track opacity states in an area.
 struct OpacityStateSet
 {
-    __device__ OpacityStateSet() {}
+    inline __device__ __host__ OpacityStateSet() {}
 
-    __device__ OpacityStateSet( uint32_t transparent, uint32_t opaque, uint32_t unknown )
+    inline __device__ __host__ OpacityStateSet( uint32_t transparent, uint32_t opaque, uint32_t unknown )
     {
         h.x = (transparent != 0);
         h.y = (opaque != 0 );
         h.z = (unknown != 0 );
     }
 
-    __device__ OpacityStateSet& operator+=( OpacityStateSet state )
+    inline __device__ __host__ OpacityStateSet& operator+=( OpacityStateSet state )
     {
         *this = *this + state;
         return *this;
     }
 
-    __device__ OpacityStateSet operator+( OpacityStateSet state ) const
+    inline __device__ __host__ OpacityStateSet operator+( OpacityStateSet state ) const
     {
         // we don't actually care about the count, just if it's zero or not.
         // by using logic or we don't have to deal with overflows.
@@ -35,7 +36,7 @@ struct OpacityStateSet
     }
 
     // return true if the set is a mixture of multiple states
-    __device__ bool isMixed() const
+    inline __device__ __host__ bool isMixed() const
     {
         if( ( ( h.x != 0 ) + ( h.y != 0 ) + ( h.z != 0 ) ) > 1 )
             return true;
@@ -43,7 +44,7 @@ struct OpacityStateSet
     }
 
     // return true if the set has only transparent states
-    __device__ bool isTransparent() const
+    inline __device__ __host__ bool isTransparent() const
     {
         if( ( h.x != 0 ) && ( h.y == 0 ) && ( h.z == 0 ) )
             return true;
@@ -51,7 +52,7 @@ struct OpacityStateSet
     }
 
     // return true if the set has only opaque states
-    __device__ bool isOpaque() const
+    inline __device__ __host__ bool isOpaque() const
     {
         if( ( h.x == 0 ) && ( h.y != 0 ) && ( h.z == 0 ) )
             return true;
@@ -59,7 +60,7 @@ struct OpacityStateSet
     }
 
     // return true if the set has transparent states
-    __device__ bool hasTransparent() const
+    inline __device__ __host__ bool hasTransparent() const
     {
         if( h.x != 0 )
             return true;
@@ -67,7 +68,7 @@ struct OpacityStateSet
     }
 
     // return true if the set is single state
-    __device__ bool isUniform() const
+    inline __device__ __host__ bool isUniform() const
     {
         if( ( ( h.x != 0 ) + ( h.y != 0 ) + ( h.z != 0 ) ) == 1 )
             return true;
@@ -78,7 +79,7 @@ struct OpacityStateSet
     uint3 h = {};
 };
 
-__device__ OpacityStateSet evalSumTableTile( const TextureData& texture )
+inline __device__ __host__ OpacityStateSet evalSumTableTile( const TextureData& texture )
 {
     const int width = texture.width;
     const int height = texture.height;
@@ -93,7 +94,7 @@ __device__ OpacityStateSet evalSumTableTile( const TextureData& texture )
 
 // evaluate a range within one tile in the sum table
 // pre: the aabb should be within the range [0,width)x[0,height)
-__device__ OpacityStateSet evalSumTableTile( const TextureData& texture, int2 lo, int2 hi, int2 tile )
+inline __device__ __host__ OpacityStateSet evalSumTableTile( const TextureData& texture, int2 lo, int2 hi, int2 tile )
 {
     int width = texture.width;
     int height = texture.height;
@@ -127,7 +128,7 @@ __device__ OpacityStateSet evalSumTableTile( const TextureData& texture, int2 lo
 
 
 // pre: the aabb should not be more 2^15 texels in either dimension to prevent overflows
-__device__ OpacityStateSet evalSumTable( const TextureData& texture, int2 inLo, int2 inHi )
+inline __device__ __host__ OpacityStateSet evalSumTable( const TextureData& texture, int2 inLo, int2 inHi )
 {
     int2 lo = inLo, hi = inHi;
 
@@ -194,7 +195,7 @@ __device__ OpacityStateSet evalSumTable( const TextureData& texture, int2 inLo,
     return states;
 }
 
-__device__ OpacityStateSet sampleMemoryTexture( const TextureData& texture, float2 uv0, float2 uv1, float2 uv2, float filterKernelRadiusInTexels, unsigned int resolution = 1 )
+inline __device__ __host__ OpacityStateSet sampleMemoryTexture( const TextureData& texture, float2 uv0, float2 uv1, float2 uv2, float filterKernelRadiusInTexels, unsigned int resolution = 1 )
 {
     auto eval = [&]( int2 lo, int2 hi ) -> OpacityStateSet { return evalSumTable( texture, lo, hi ); };
 
@@ -235,8 +236,8 @@ __device__ OpacityStateSet sampleMemoryTexture( const TextureData& texture, floa
     flo.x = modff( flo_tile.x, &ilo_tile.x );
     flo.y = modff( flo_tile.y, &ilo_tile.y );
 
-    // float to int conversion overflow may result in an undefined tile index, but we don't care
-    int2 lo_tile = { ( int )ilo_tile.x, ( int )ilo_tile.y };
+    // float to int conversion overflow saturates the tile index, but we don't care
+    int2 lo_tile = { float2intRz( ilo_tile.x ), float2intRz( ilo_tile.y ) };
     if( flo.x < 0 )
         flo.x += 1.f, lo_tile.x++;
     if( flo.y < 0 )
@@ -267,10 +268,10 @@ __device__ OpacityStateSet sampleMemoryTexture( const TextureData& texture, floa
     int height = texture.height;
 
     int2 lo, hi;
-    lo.x = ( int )floorf( flo.x );
-    lo.y = ( int )floorf( flo.y );
-    hi.x = max( lo.x, ( int )( ceilf( fhi.x ) - 1.f ) );
-    hi.y = max( lo.y, ( int )( ceilf( fhi.y ) - 1.f ) );
+    lo.x = float2intRz( floorf( flo.x ) );
+    lo.y = float2intRz( floorf( flo.y ) );
+    hi.x = max( lo.x, float2intRz( ceilf( fhi.x ) - 1.f ) );
+    hi.y = max( lo.y, float2intRz( ceilf( fhi.y ) - 1.f ) );
 
     // upper-left corner
     OpacityStateSet states = evalSumTableTile( texture, lo, make_int2( min( hi.x, width - 1 ), min( hi.y, height - 1 ) ), lo_tile );
@@ -0,0 +1,759 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "HostBaking.h"
+
+#include "AdaptiveLayout.h"
+#include "Bake.h"
+#include "Util/Blake2b.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Incremented when changes to the omm evaluation invalidate cached omms.
+const uint64_t OMM_CACHE_KEY_VERSION = 3;
+
+// Minimum number of items per band, to keep the thread launch overhead small compared to the work.
+const uint32_t MIN_ITEMS_PER_BAND = 4096;
+
+uint32_t getNumThreads()
+{
+    const uint32_t numThreads = std::thread::hardware_concurrency();
+    return numThreads ? numThreads : 1;
+}
+
+// Number of bands to split numItems items into.
+uint32_t getNumBands( uint32_t numItems )
+{
+    return std::max( 1u, std::min( getNumThreads(), numItems / MIN_ITEMS_PER_BAND ) );
+}
+
+// Split [0,numItems) into numBands contiguous bands of nearly equal size and call func( band, begin, end )
+// for each of them, concurrently when there is more than one band. The first band runs on the calling thread.
+template <typename Func>
+void parallelBands( uint32_t numItems, uint32_t numBands, const Func& func )
+{
+    auto bandBegin = [&]( uint32_t band ) { return ( uint32_t )( ( uint64_t )numItems * band / numBands ); };
+
+    std::vector<std::thread> threads;
+    threads.reserve( numBands - 1 );
+    for( uint32_t band = 1; band < numBands; ++band )
+    {
+        const uint32_t begin = bandBegin( band );
+        const uint32_t end   = bandBegin( band + 1 );
+        threads.emplace_back( [&func, band, begin, end]() { func( band, begin, end ); } );
+    }
+
+    func( 0, 0, bandBegin( 1 ) );
+
+    for( std::thread& thread : threads )
+        thread.join();
+}
+
+// Call func( index ) for all indices in [0,numItems). Threads dynamically grab chunks of indices,
+// balancing items with varying amounts of work.
+template <typename Func>
+void parallelFor( uint32_t numItems, uint32_t chunkSize, const Func& func )
+{
+    std::atomic<uint32_t> next( 0 );
+
+    auto worker = [&]() {
+        for( ;; )
+        {
+            const uint32_t begin = next.fetch_add( chunkSize );
+            if( begin >= numItems )
+                break;
+
+            const uint32_t end = std::min( numItems, begin + chunkSize );
+            for( uint32_t i = begin; i < end; ++i )
+                func( i );
+        }
+    };
+
+    const uint32_t numThreads = std::max( 1u, std::min( getNumThreads(), ( numItems + chunkSize - 1 ) / chunkSize ) );
+
+    std::vector<std::thread> threads;
+    threads.reserve( numThreads - 1 );
+    for( uint32_t i = 1; i < numThreads; ++i )
+        threads.emplace_back( worker );
+
+    worker();
+
+    for( std::thread& thread : threads )
+        thread.join();
+}
+
+// (num-transparent,num-opaque) state counts of a texel, matching StateTextureInputFunctor.
+uint2 loadStateCounts( const StateTextureConfig& config, const uint8_t* states, uint32_t x, uint32_t y )
+{
+    const uint32_t bidx = x * 2 + y * config.pitchInBits;
+
+    const uint32_t byte  = ( bidx >> 3 );
+    const uint32_t shift = ( bidx & 7 );
+
+    const cuOmmBaking::OpacityState state = ( cuOmmBaking::OpacityState )( ( states[byte] >> shift ) & 0x3 );
+
+    if( state == cuOmmBaking::OpacityState::STATE_TRANSPARENT )
+        return make_uint2( 2, 0 );  // tranparent
+    else if( state == cuOmmBaking::OpacityState::STATE_OPAQUE )
+        return make_uint2( 0, 2 );  // opaque
+    else if( state == cuOmmBaking::OpacityState::STATE_RESERVED )
+        return make_uint2( 1, 1 );  // updatable
+
+    return make_uint2( 0, 0 );  // unknown
+}
+
+// Number of elements summed per block by hostReduceRoundUp.
+const uint32_t REDUCE_ROUND_UP_BLOCK_SIZE = 1024;
+
+// rounding up sum of a block of up to REDUCE_ROUND_UP_BLOCK_SIZE elements, adding the upper half of the block to the lower half.
+// the summation order is fixed, so the sum does not depend on the number of threads.
+float reduceRoundUpBlock( const float* in, uint32_t numItems )
+{
+    const uint32_t halfBlockSize = REDUCE_ROUND_UP_BLOCK_SIZE / 2;
+
+    float sums[halfBlockSize];
+    for( uint32_t lane = 0; lane < halfBlockSize; ++lane )
+    {
+        const float lo = ( lane < numItems ) ? in[lane] : 0.f;
+        const float hi = ( lane + halfBlockSize < numItems ) ? in[lane + halfBlockSize] : 0.f;
+        sums[lane]     = faddRu( lo, hi );
+    }
+
+    for( uint32_t stride = halfBlockSize / 2; stride > 0; stride /= 2 )
+        for( uint32_t lane = 0; lane < stride; ++lane )
+            sums[lane] = faddRu( sums[lane], sums[lane + stride] );
+
+    return sums[0];
+}
+
+// Period of the texture along a dimension in uv units, or zero if the address mode doesn't repeat the texture.
+float getPeriodInUV( cudaTextureAddressMode addressMode )
+{
+    switch( addressMode )
+    {
+    case cudaAddressModeWrap:
+        return 1.f;
+    case cudaAddressModeMirror:
+        return 2.f;
+    default:
+        return 0.f;
+    }
+}
+
+bool isLess( float2 a, float2 b )
+{
+    return a.x < b.x || ( a.x == b.x && a.y < b.y );
+}
+
+// Content key of an omm. The key covers all inputs to its evaluation, with the triangle in a canonical form, so that
+// omms of translated and rotated copies of a triangle share their cache entry:
+// - Under wrap and mirror addressing, the triangle is translated by whole texture periods, that is by a whole number
+//   of texels, so that its smallest coordinates lie in the first period. This leaves the sampled texels unchanged.
+// - The vertices are rotated to start at the smallest vertex. The micromap layout follows the vertex order, so the
+//   cache holds micromaps in the canonical vertex order, and the rotation of the omm triangle is returned.
+cuOmmBaking::BakeCacheKey getOmmCacheKey( const OmmCacheParams& params, uint32_t ommIndex, uint32_t& rotation )
+{
+    const Triangle&     triangle = params.inTriangles[ommIndex];
+    const TextureInput& texture  = params.inTextures[triangle.texture];
+
+    float2 uv[3] = { triangle.uv0, triangle.uv1, triangle.uv2 };
+
+    const float2 period = { getPeriodInUV( texture.data.addressMode[0] ), getPeriodInUV( texture.data.addressMode[1] ) };
+    float2       base   = { 0.f, 0.f };
+    if( period.x )
+        base.x = period.x * floorf( std::min( { uv[0].x, uv[1].x, uv[2].x } ) / period.x );
+    if( period.y )
+        base.y = period.y * floorf( std::min( { uv[0].y, uv[1].y, uv[2].y } ) / period.y );
+
+    for( float2& vertex : uv )
+        vertex = vertex - base;
+
+    // lexicographically smallest rotation of the vertices
+    rotation = 0;
+    for( uint32_t r = 1; r < 3; ++r )
+    {
+        for( uint32_t i = 0; i < 3; ++i )
+        {
+            const float2 a = uv[( r + i ) % 3];
+            const float2 b = uv[( rotation + i ) % 3];
+            if( isLess( a, b ) )
+                rotation = r;
+            if( isLess( a, b ) || isLess( b, a ) )
+                break;
+        }
+    }
+
+    Blake2b hasher;
+    hasher.update( OMM_CACHE_KEY_VERSION );
+    hasher.update( params.inTextureCacheKeys[texture.data.id] );
+    for( uint32_t i = 0; i < 3; ++i )
+        hasher.update( uv[( rotation + i ) % 3] );
+    hasher.update( params.inDescs[ommIndex].subdivisionLevel );
+    hasher.update( ( uint32_t )params.format );
+
+    const Blake2b::Digest digest = hasher.finish();
+    return { digest.lo, digest.hi };
+}
+
+// Centroid of a micro triangle in the barycentrics of the triangle with its vertices rotated to start at vertex rotation.
+float2 getRotatedCentroid( uint32_t microTriangleIndex, uint32_t level, uint32_t rotation )
+{
+    float2 b0, b1, b2;
+    optixMicromapIndexToBaseBarycentrics( microTriangleIndex, level, b0, b1, b2 );
+
+    const float u          = ( b0.x + b1.x + b2.x ) / 3.f;
+    const float v          = ( b0.y + b1.y + b2.y ) / 3.f;
+    const float weights[3] = { 1.f - u - v, u, v };
+
+    return make_float2( weights[( rotation + 1 ) % 3], weights[( rotation + 2 ) % 3] );
+}
+
+bool containsPoint( uint32_t microTriangleIndex, uint32_t level, float2 p )
+{
+    float2 b0, b1, b2;
+    optixMicromapIndexToBaseBarycentrics( microTriangleIndex, level, b0, b1, b2 );
+
+    auto isLeft = [&p]( float2 a, float2 b ) { return ( b.x - a.x ) * ( p.y - a.y ) - ( b.y - a.y ) * ( p.x - a.x ) > 0.f; };
+
+    const bool left = isLeft( b0, b1 );
+    return isLeft( b1, b2 ) == left && isLeft( b2, b0 ) == left;
+}
+
+uint32_t loadMicroTriangleState( const uint8_t* data, uint32_t index, uint32_t bitsPerState )
+{
+    const uint32_t bit = index * bitsPerState;
+    return ( data[bit / 8] >> ( bit % 8 ) ) & ( ( 1u << bitsPerState ) - 1 );
+}
+
+// Copy the states of the micro triangles in the subtree of a micro triangle at the given level to the subtree of the
+// same micro triangle in the micromap of the rotated triangle. The children of micro triangle i are the micro
+// triangles 4 * i to 4 * i + 3 at the next level, so the children in the rotated micromap are found by their centroids.
+void rotateMicroTriangles( const uint8_t* in, uint8_t* out, uint32_t index, uint32_t rotatedIndex, uint32_t level, uint32_t subdivisionLevel, uint32_t bitsPerState, uint32_t rotation )
+{
+    if( level == subdivisionLevel )
+    {
+        const uint32_t bit = rotatedIndex * bitsPerState;
+        out[bit / 8] |= ( uint8_t )( loadMicroTriangleState( in, index, bitsPerState ) << ( bit % 8 ) );
+        return;
+    }
+
+    for( uint32_t child = 4 * index; child < 4 * index + 4; ++child )
+    {
+        const float2 centroid = getRotatedCentroid( child, level + 1, rotation );
+
+        uint32_t rotatedChild = 4 * rotatedIndex;
+        while( rotatedChild < 4 * rotatedIndex + 3 && !containsPoint( rotatedChild, level + 1, centroid ) )
+            ++rotatedChild;
+
+        rotateMicroTriangles( in, out, child, rotatedChild, level + 1, subdivisionLevel, bitsPerState, rotation );
+    }
+}
+
+// Permute the micro triangles of a micromap for the triangle with its vertices rotated to start at vertex rotation.
+// The states past the last micro triangle in the last byte are copied as is. out must be zeroed.
+void rotateMicromap( const uint8_t* in, uint8_t* out, uint32_t subdivisionLevel, OptixOpacityMicromapFormat format, uint32_t rotation )
+{
+    const uint32_t logStatesPerByte = getLogStatesPerByte( format );
+    const uint32_t bitsPerState     = 8 >> logStatesPerByte;
+    const uint32_t numStates        = getOmmSizeInBytes( subdivisionLevel, logStatesPerByte ) << logStatesPerByte;
+
+    rotateMicroTriangles( in, out, 0, 0, 0, subdivisionLevel, bitsPerState, rotation );
+
+    for( uint32_t index = 1u << ( 2 * subdivisionLevel ); index < numStates; ++index )
+    {
+        const uint32_t bit = index * bitsPerState;
+        out[bit / 8] |= ( uint8_t )( loadMicroTriangleState( in, index, bitsPerState ) << ( bit % 8 ) );
+    }
+}
+
+}  // namespace
+
+void hostSummedAreaTable( StateTextureConfig config, const uint8_t* input, uint2* outputSat )
+{
+    const uint32_t width  = config.width;
+    const uint32_t height = config.height;
+
+    // sum the rows, writing out transposed into the column major table
+    parallelBands( height, std::min( height, getNumBands( width * height ) ), [&]( uint32_t, uint32_t begin, uint32_t end ) {
+        for( uint32_t y = begin; y < end; ++y )
+        {
+            uint2 sum = make_uint2( 0, 0 );
+            for( uint32_t x = 0; x < width; ++x )
+            {
+                const uint2 v = loadStateCounts( config, input, x, y );
+                sum.x += v.x;
+                sum.y += v.y;
+                outputSat[x * height + y] = sum;
+            }
+        }
+    } );
+
+    // sum the contiguous columns in place
+    parallelBands( width, std::min( width, getNumBands( width * height ) ), [&]( uint32_t, uint32_t begin, uint32_t end ) {
+        for( uint32_t x = begin; x < end; ++x )
+        {
+            uint2* column = outputSat + ( size_t )x * height;
+            for( uint32_t y = 1; y < height; ++y )
+            {
+                column[y].x += column[y - 1].x;
+                column[y].y += column[y - 1].y;
+            }
+        }
+    } );
+}
+
+void hostSetupBakeInput( SetupBakeInputParams params )
+{
+    parallelBands( params.numTriangles, getNumBands( params.numTriangles ), [&]( uint32_t, uint32_t begin, uint32_t end ) {
+        for( uint32_t i = begin; i < end; ++i )
+            setupTriangle( params, i, params.outTriangleIDs[i], params.outHashKeys[i] );
+    } );
+}
+
+void hostSortPairs( uint32_t* keysIn, uint32_t* keysOut, TriangleID* valuesIn, TriangleID* valuesOut, uint32_t numItems )
+{
+    // stable least significant digit radix sort, one byte per pass.
+    // each band counts its digits, and scatters its items in order to the offsets following all
+    // smaller digits and all equal digits of preceding bands. this preserves the order of equal keys.
+    const uint32_t numBands = getNumBands( numItems );
+
+    std::vector<uint32_t> offsets( numBands * 256 );
+
+    uint32_t*   keys[2]   = { keysIn, keysOut };
+    TriangleID* values[2] = { valuesIn, valuesOut };
+    uint32_t    current   = 0;
+
+    for( uint32_t shift = 0; shift < 32; shift += 8 )
+    {
+        const uint32_t*   inKeys   = keys[current];
+        const TriangleID* inValues = values[current];
+
+        std::fill( offsets.begin(), offsets.end(), 0 );
+        parallelBands( numItems, numBands, [&]( uint32_t band, uint32_t begin, uint32_t end ) {
+            uint32_t* counts = offsets.data() + band * 256;
+            for( uint32_t i = begin; i < end; ++i )
+                counts[( inKeys[i] >> shift ) & 0xFF]++;
+        } );
+
+        // skip the pass when all keys share the same digit
+        bool uniform = false;
+        for( uint32_t digit = 0; digit < 256 && !uniform; ++digit )
+        {
+            uint32_t count = 0;
+            for( uint32_t band = 0; band < numBands; ++band )
+                count += offsets[band * 256 + digit];
+            uniform = ( count == numItems );
+        }
+        if( uniform )
+            continue;
+
+        // exclusive scan over digits, then bands
+        uint32_t sum = 0;
+        for( uint32_t digit = 0; digit < 256; ++digit )
+        {
+            for( uint32_t band = 0; band < numBands; ++band )
+            {
+                const uint32_t count        = offsets[band * 256 + digit];
+                offsets[band * 256 + digit] = sum;
+                sum += count;
+            }
+        }
+
+        uint32_t*   outKeys   = keys[current ^ 1];
+        TriangleID* outValues = values[current ^ 1];
+
+        parallelBands( numItems, numBands, [&]( uint32_t band, uint32_t begin, uint32_t end ) {
+            uint32_t* bandOffsets = offsets.data() + band * 256;
+            for( uint32_t i = begin; i < end; ++i )
+            {
+                const uint32_t dst = bandOffsets[( inKeys[i] >> shift ) & 0xFF]++;
+                outKeys[dst]       = inKeys[i];
+                outValues[dst]     = inValues[i];
+            }
+        } );
+
+        current ^= 1;
+    }
+
+    if( current == 0 )
+    {
+        memcpy( keysOut, keysIn, numItems * sizeof( uint32_t ) );
+        memcpy( valuesOut, valuesIn, numItems * sizeof( TriangleID ) );
+    }
+}
+
+void hostMarkFirstOmmOccurance( MarkFirstOmmOccuranceParams params )
+{
+    parallelBands( params.numTriangles, getNumBands( params.numTriangles ), [&]( uint32_t, uint32_t begin, uint32_t end ) {
+        for( uint32_t i = begin; i < end; ++i )
+            params.outMarkers[i] = isFirstOmmOccurance( params, i ) ? 1 : 0;
+    } );
+}
+
+void hostAddBatch( DuplicateTable& table, const uint32_t* hashKeys, const TriangleID* triangleIds, uint32_t numTriangles, const BakeInput* bakeInputs, cuOmmBaking::IndexFormat indexFormat )
+{
+    auto isDuplicate = [bakeInputs]( TriangleID prevId, TriangleID id ) { return isDuplicateTriangle( bakeInputs, prevId, id ); };
+
+    // the table is updated in sorted order
+    for( uint32_t i = 0; i < numTriangles; ++i )
+    {
+        const TriangleID id = triangleIds[i];
+
+        const uint32_t assignment = id.uniform ? getPredefinedAssignment( id ) : table.add( hashKeys[i], id, isDuplicate );
+
+        storeAssignment( bakeInputs[id.inputIndex].outAssignments, indexFormat, id.triangleIndex, assignment );
+    }
+}
+
+void hostAddMarkedBatch(
+    DuplicateTable&          table,
+    const uint32_t*          hashKeys,
+    const TriangleID*        triangleIds,
+    const uint32_t*          duplicates,
+    uint32_t                 numTriangles,
+    const uint32_t*          triangleOffsetPerInput,
+    uint32_t                 batchBegin,
+    void*                    outAssignments,
+    cuOmmBaking::IndexFormat indexFormat )
+{
+    // the table is updated in sorted order
+    for( uint32_t i = 0; i < numTriangles; ++i )
+    {
+        const TriangleID id = triangleIds[i];
+
+        const uint32_t assignment = id.uniform ? getPredefinedAssignment( id ) : table.add( hashKeys[i], id, [&]( TriangleID, TriangleID ) { return duplicates[i] != 0; } );
+
+        storeAssignment( outAssignments, indexFormat, triangleOffsetPerInput[id.inputIndex] + id.triangleIndex - batchBegin, assignment );
+    }
+}
+
+void hostGenerateBatchedOmms( const DuplicateTable& table, const uint32_t* finalIndices, GenerateAssignmentParams params )
+{
+    const uint32_t numOmms = table.getNumOmms();
+
+    parallelBands( numOmms, getNumBands( numOmms ), [&]( uint32_t, uint32_t begin, uint32_t end ) {
+        for( uint32_t i = begin; i < end; ++i )
+        {
+            const uint32_t ommIndex = finalIndices[i];
+
+            // excess omms are marked as unknown by hostRemapBatchedAssignment
+            if( ommIndex >= params.maxOmms )
+                continue;
+
+            const TriangleID id = table.getTriangleId( i );
+
+            params.outOmmTriangleId[ommIndex] = id;
+            params.outOmmArea[ommIndex]       = getOmmAreaInTexels( params.inBakeInputs[id.inputIndex], id.triangleIndex );
+        }
+    } );
+
+    *params.outNumOmms = std::min( params.maxOmms, numOmms );
+}
+
+void hostRemapBatchedAssignment( void* assignments, cuOmmBaking::IndexFormat indexFormat, uint32_t numTriangles, const uint32_t* finalIndices, uint32_t maxOmms )
+{
+    parallelBands( numTriangles, getNumBands( numTriangles ), [&]( uint32_t, uint32_t begin, uint32_t end ) {
+        for( uint32_t i = begin; i < end; ++i )
+        {
+            uint32_t assignment = loadAssignment( assignments, indexFormat, i );
+
+            // skip predefined assignments
+            if( assignment >= ( uint32_t )( -4 ) )
+                continue;
+
+            assignment = finalIndices[assignment];
+
+            // crude method to prevent omm array overflow by marking any excess omms as unkown, as in assignTriangle.
+            if( assignment >= maxOmms )
+                assignment = ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_UNKNOWN_OPAQUE;
+
+            storeAssignment( assignments, indexFormat, i, assignment );
+        }
+    } );
+}
+
+void hostInclusiveSum( const uint32_t* in, uint32_t* out, uint32_t numItems )
+{
+    // scan the bands independently, then offset each band by the sum of the preceding bands
+    const uint32_t numBands = getNumBands( numItems );
+
+    std::vector<uint32_t> bandSums( numBands );
+    parallelBands( numItems, numBands, [&]( uint32_t band, uint32_t begin, uint32_t end ) {
+        uint32_t sum = 0;
+        for( uint32_t i = begin; i < end; ++i )
+            out[i] = ( sum += in[i] );
+        bandSums[band] = sum;
+    } );
+
+    if( numBands == 1 )
+        return;
+
+    parallelBands( numItems, numBands, [&]( uint32_t band, uint32_t begin, uint32_t end ) {
+        uint32_t offset = 0;
+        for( uint32_t i = 0; i < band; ++i )
+            offset += bandSums[i];
+        for( uint32_t i = begin; i < end; ++i )
+            out[i] += offset;
+    } );
+}
+
+void hostGenerateAssignment( GenerateAssignmentParams params )
+{
+    parallelBands( params.numTriangles, getNumBands( params.numTriangles ), [&]( uint32_t, uint32_t begin, uint32_t end ) {
+        for( uint32_t i = begin; i < end; ++i )
+            assignTriangle( params, i );
+    } );
+
+    // copy total number of omms, clamped to the maximum number of omms
+    *params.outNumOmms = params.numTriangles ? std::min( params.maxOmms, params.inAssignment[params.numTriangles - 1] ) : 0u;
+}
+
+void hostReduceRoundUp( const float* in, float* out, uint32_t numItems )
+{
+    const uint32_t blockSize = REDUCE_ROUND_UP_BLOCK_SIZE;
+
+    std::vector<float> sums, partials;
+    const float*       blockIn = in;
+    uint32_t           n       = numItems;
+    while( n > blockSize )
+    {
+        partials.resize( ( n + blockSize - 1 ) / blockSize );
+        parallelBands( ( uint32_t )partials.size(), std::min( ( uint32_t )partials.size(), getNumBands( n ) ), [&]( uint32_t, uint32_t begin, uint32_t end ) {
+            for( uint32_t block = begin; block < end; ++block )
+                partials[block] = reduceRoundUpBlock( blockIn + block * blockSize, std::min( blockSize, n - block * blockSize ) );
+        } );
+
+        sums.swap( partials );
+        blockIn = sums.data();
+        n       = ( uint32_t )sums.size();
+    }
+
+    *out = reduceRoundUpBlock( blockIn, n );
+}
+
+void hostGenerateLayout( GenerateLayoutParams params )
+{
+    const uint32_t numOmms = *params.inNumOmms;
+    const float    sumArea = params.inSumArea ? *params.inSumArea : 0;
+
+    const uint32_t logStatesPerByte = getLogStatesPerByte( params.format );
+
+    const uint32_t numBands = getNumBands( numOmms );
+
+    // sizes and histograms are accumulated per band
+    std::vector<uint32_t> sizeInBytes( numBands );
+    std::vector<uint32_t> histograms( numBands * ( OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL + 1 ) );
+
+    parallelBands( numOmms, numBands, [&]( uint32_t band, uint32_t begin, uint32_t end ) {
+        uint32_t* histogram = histograms.data() + band * ( OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL + 1 );
+        for( uint32_t i = begin; i < end; ++i )
+        {
+            const uint32_t subdivisionLevel = getOmmSubdivisionLevel( params, params.inOmmArea[i], sumArea, numOmms );
+
+            sizeInBytes[band] += getOmmSizeInBytes( subdivisionLevel, logStatesPerByte );
+
+            OptixOpacityMicromapDesc desc = {};
+            desc.byteOffset = 0;
+            desc.subdivisionLevel = subdivisionLevel;
+            desc.format = params.format;
+
+            params.ioDescs[i] = desc;
+
+            histogram[subdivisionLevel]++;
+        }
+    } );
+
+    for( uint32_t band = 0; band < numBands; ++band )
+    {
+        *params.ioSizeInBytes += sizeInBytes[band];
+        for( uint32_t level = 0; level <= OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL; ++level )
+            params.ioHistogram[level].count += histograms[band * ( OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL + 1 ) + level];
+    }
+}
+
+void hostGenerateUnknownStatistics( GenerateUnknownStatisticsParams params )
+{
+    parallelFor( *params.inNumOmms, 16, [&]( uint32_t ommIndex ) { generateOmmUnknownStatistics( params, ommIndex ); } );
+}
+
+void hostGenerateAdaptiveLayout( GenerateLayoutParams params, const OmmUnknownStatistics* inStats )
+{
+    const uint32_t numOmms = *params.inNumOmms;
+
+    std::vector<uint32_t> subdivisionLevels( numOmms );
+    *params.ioSizeInBytes += assignAdaptiveSubdivisionLevels( inStats, numOmms, params.maxOmmArraySizeInBytes, params.format, subdivisionLevels.data() );
+
+    for( uint32_t i = 0; i < numOmms; ++i )
+    {
+        OptixOpacityMicromapDesc desc = {};
+        desc.byteOffset = 0;
+        desc.subdivisionLevel = subdivisionLevels[i];
+        desc.format = params.format;
+
+        params.ioDescs[i] = desc;
+
+        params.ioHistogram[subdivisionLevels[i]].count++;
+    }
+}
+
+void hostGenerateStartOffsets( OptixOpacityMicromapDesc* descs, uint32_t numItems, OptixOpacityMicromapFormat format )
+{
+    const uint32_t logStatesPerByte = getLogStatesPerByte( format );
+
+    uint32_t byteOffset = 0;
+    for( uint32_t i = 0; i < numItems; ++i )
+    {
+        const uint32_t sizeInBytes = getOmmSizeInBytes( descs[i].subdivisionLevel, logStatesPerByte );
+        descs[i].byteOffset = byteOffset;
+        byteOffset += sizeInBytes ? sizeInBytes : 1;
+    }
+}
+
+void hostGenerateInputHistogram( GenerateInputHistogramParams params )
+{
+    const uint32_t numBands = getNumBands( params.numTriangles );
+
+    std::vector<uint32_t> histograms( numBands * ( OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL + 1 ) );
+
+    parallelBands( params.numTriangles, numBands, [&]( uint32_t band, uint32_t begin, uint32_t end ) {
+        uint32_t* histogram = histograms.data() + band * ( OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL + 1 );
+        for( uint32_t i = begin; i < end; ++i )
+        {
+            uint32_t assignment = loadAssignment( params.inAssignment, params.indexFormat, i );
+
+            // skip predefined assignments
+            if( assignment < ( uint32_t )( -4 ) )
+                histogram[params.inDescs[assignment].subdivisionLevel]++;
+        }
+    } );
+
+    for( uint32_t band = 0; band < numBands; ++band )
+        for( uint32_t level = 0; level <= OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL; ++level )
+            params.ioHistogram[level].count += histograms[band * ( OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL + 1 ) + level];
+}
+
+void hostEvaluateOmmOpacity( EvaluateOmmOpacityParams params )
+{
+    const uint32_t numOmms = *params.inNumOmms;
+
+    assert( *params.inSizeInBytes <= params.dataSizeInBytes );
+
+    const uint32_t logStatesPerByte = getLogStatesPerByte( params.format );
+    const uint32_t statesPerByte    = 1u << logStatesPerByte;
+    const uint32_t bitsPerState     = 8 / statesPerByte;
+
+    uint8_t* data = ( uint8_t* )params.ioData;
+
+    // omms cover disjoint byte ranges, so each omm is written by a single thread without synchronization.
+    // the omm sizes vary by orders of magnitude, so the omms are distributed dynamically in small chunks.
+    parallelFor( numOmms, 16, [&]( uint32_t ommIndex ) {
+        const OptixOpacityMicromapDesc desc = params.inDescs[ommIndex];
+
+        const TriangleID id = params.inTriangleIdPerOmm[ommIndex];
+
+        // omms copied from the bake cache are marked uniform
+        if( id.uniform )
+            return;
+
+        const BakeInput& input    = params.inBakeInputs[id.inputIndex];
+        const Triangle   triangle = loadTriangle( input.desc, id.triangleIndex );
+
+        const uint32_t subdivisionLevel  = desc.subdivisionLevel;
+        const uint32_t numMicroTriangles = 1u << ( 2 * subdivisionLevel );
+        const uint32_t sizeInBytes       = getOmmSizeInBytes( subdivisionLevel, logStatesPerByte );
+
+        assert( desc.byteOffset + sizeInBytes <= params.dataSizeInBytes );
+
+        uint32_t microTriangleIndex = 0;
+        for( uint32_t byte = 0; byte < sizeInBytes; ++byte )
+        {
+            uint8_t value = 0;
+            for( uint32_t i = 0; i < statesPerByte; ++i, ++microTriangleIndex )
+            {
+                OpacityStateSet state = {};
+
+                // 2-state subdiv level 0 and 1, and 4-state subdiv level 0 cover less than one byte.
+                if( microTriangleIndex < numMicroTriangles )
+                    state = evaluateMicroTriangleOpacity( input.inTextures, triangle, subdivisionLevel, microTriangleIndex );
+
+                value |= ( uint8_t )( getMicroTriangleState( state, params.format ) << ( i * bitsPerState ) );
+            }
+
+            data[desc.byteOffset + byte] |= value;
+        }
+    } );
+}
+
+void hostGatherOmmTriangles( GatherOmmTrianglesParams params )
+{
+    parallelBands( params.numOmms, getNumBands( params.numOmms ), [&]( uint32_t, uint32_t begin, uint32_t end ) {
+        for( uint32_t i = begin; i < end; ++i )
+            gatherOmmTriangle( params, i );
+    } );
+}
+
+void hostFindCachedOmms( OmmCacheParams params )
+{
+    const uint32_t logStatesPerByte = getLogStatesPerByte( params.format );
+
+    parallelFor( params.numOmms, 16, [&]( uint32_t ommIndex ) {
+        const OptixOpacityMicromapDesc desc        = params.inDescs[ommIndex];
+        const uint32_t                 sizeInBytes = getOmmSizeInBytes( desc.subdivisionLevel, logStatesPerByte );
+
+        uint32_t                        rotation;
+        const cuOmmBaking::BakeCacheKey key = getOmmCacheKey( params, ommIndex, rotation );
+
+        bool found;
+        if( rotation == 0 )
+        {
+            found = params.cache->find( key, params.ioData + desc.byteOffset, sizeInBytes );
+        }
+        else
+        {
+            // rotate the cached micromap from the canonical vertex order back to the vertex order of the omm triangle
+            std::vector<uint8_t> canonical( sizeInBytes );
+            found = params.cache->find( key, canonical.data(), sizeInBytes );
+            if( found )
+                rotateMicromap( canonical.data(), params.ioData + desc.byteOffset, desc.subdivisionLevel, params.format, 3 - rotation );
+        }
+
+        if( found )
+            params.ioTriangleIdPerOmm[ommIndex].uniform = 1;
+    } );
+}
+
+void hostInsertCachedOmms( OmmCacheParams params )
+{
+    const uint32_t logStatesPerByte = getLogStatesPerByte( params.format );
+
+    parallelFor( params.numOmms, 16, [&]( uint32_t ommIndex ) {
+        // skip the omms that were found in the cache
+        if( params.ioTriangleIdPerOmm[ommIndex].uniform )
+            return;
+
+        const OptixOpacityMicromapDesc desc        = params.inDescs[ommIndex];
+        const uint32_t                 sizeInBytes = getOmmSizeInBytes( desc.subdivisionLevel, logStatesPerByte );
+
+        uint32_t                        rotation;
+        const cuOmmBaking::BakeCacheKey key = getOmmCacheKey( params, ommIndex, rotation );
+
+        if( rotation == 0 )
+        {
+            params.cache->insert( key, params.ioData + desc.byteOffset, sizeInBytes );
+        }
+        else
+        {
+            std::vector<uint8_t> canonical( sizeInBytes );
+            rotateMicromap( params.ioData + desc.byteOffset, canonical.data(), desc.subdivisionLevel, params.format, rotation );
+            params.cache->insert( key, canonical.data(), sizeInBytes );
+        }
+    } );
+}
@@ -0,0 +1,119 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include "BakeCache.h"
+#include "CuOmmBakingImpl.h"
+#include "DuplicateTable.h"
+#include "Texture.h"
+
+// Host implementations of the baking pipeline stages, used when baking with BakeFlags::BAKE_ON_HOST.
+// Each function matches the corresponding device launch, but operates on host memory and runs
+// synchronously, split over all hardware threads. The results do not depend on the number of threads.
+// The device kernels are compiled with fast math, so the host and device results can differ slightly.
+
+// build the transposed (column major) summed area table of a state texture.
+void hostSummedAreaTable( StateTextureConfig config, const uint8_t* input, uint2* outputSat );
+
+// setup all a single bake input.
+void hostSetupBakeInput( SetupBakeInputParams params );
+
+// stable sort of triangle ids by their hash keys. the input buffers are used as temporary storage.
+void hostSortPairs( uint32_t* keysIn, uint32_t* keysOut, TriangleID* valuesIn, TriangleID* valuesOut, uint32_t numItems );
+
+// scan the sorted triangle list and mark the start of duplicate groups.
+void hostMarkFirstOmmOccurance( MarkFirstOmmOccuranceParams params );
+
+// add the triangles of a batch, sorted by hash key, to the table of unique omms. writes the predefined omm index of
+// uniform triangles, and the index in order of addition to the table of non-uniform triangles to the index buffers.
+void hostAddBatch( DuplicateTable& table, const uint32_t* hashKeys, const TriangleID* triangleIds, uint32_t numTriangles, const BakeInput* bakeInputs, cuOmmBaking::IndexFormat indexFormat );
+
+// add the triangles of a batch of a device bake, sorted by hash key, to the table of unique omms. the duplicate checks
+// against the previous triangles of DuplicateTable::findPreviousTriangles are evaluated on the device. writes the omm
+// indices, as hostAddBatch, to a host copy of the index buffer range of the batch. the batch starts at triangle
+// batchBegin of all triangles of all inputs, and input i starts at triangle triangleOffsetPerInput[i].
+void hostAddMarkedBatch(
+    DuplicateTable&          table,
+    const uint32_t*          hashKeys,
+    const TriangleID*        triangleIds,
+    const uint32_t*          duplicates,
+    uint32_t                 numTriangles,
+    const uint32_t*          triangleOffsetPerInput,
+    uint32_t                 batchBegin,
+    void*                    outAssignments,
+    cuOmmBaking::IndexFormat indexFormat );
+
+// output the representative triangle id and area of the unique omms in their final order, and the number of omms.
+// only the omms, triangle ids and bake inputs of the params are used.
+void hostGenerateBatchedOmms( const DuplicateTable& table, const uint32_t* finalIndices, GenerateAssignmentParams params );
+
+// remap the omm indices of the batched triangles of a bake input to the final omm order.
+// omms beyond the maximum number of omms are marked as unknown.
+void hostRemapBatchedAssignment( void* assignments, cuOmmBaking::IndexFormat indexFormat, uint32_t numTriangles, const uint32_t* finalIndices, uint32_t maxOmms );
+
+// inclusive prefix sum.
+void hostInclusiveSum( const uint32_t* in, uint32_t* out, uint32_t numItems );
+
+// generate omm assignments for all triangles in all bake inputs.
+void hostGenerateAssignment( GenerateAssignmentParams params );
+
+// rounding up sum, in a fixed order.
+void hostReduceRoundUp( const float* in, float* out, uint32_t numItems );
+
+// generate the omm layout, dynamically assigning subdivision levels.
+void hostGenerateLayout( GenerateLayoutParams params );
+
+// count the unknown micro triangles of all omms at the lowest subdivision levels, for the adaptive layout.
+void hostGenerateUnknownStatistics( GenerateUnknownStatisticsParams params );
+
+// generate the omm layout, assigning subdivision levels by the unknown micro triangles of each omm rather than by area.
+// also used by device bakes, on downloaded statistics, as the greedy assignment is sequential.
+void hostGenerateAdaptiveLayout( GenerateLayoutParams params, const OmmUnknownStatistics* inStats );
+
+// generate omm descriptor byte offsets from subdivision levels.
+void hostGenerateStartOffsets( OptixOpacityMicromapDesc* descs, uint32_t numItems, OptixOpacityMicromapFormat format );
+
+// generate the subdivision level usage histogram for a bake input.
+void hostGenerateInputHistogram( GenerateInputHistogramParams params );
+
+// evaluate the opacity of all micro triangles in all opacity micro maps.
+void hostEvaluateOmmOpacity( EvaluateOmmOpacityParams params );
+
+// gather the representative triangles of all omms, for the bake cache.
+void hostGatherOmmTriangles( GatherOmmTrianglesParams params );
+
+// Bake cache lookups and insertions of the omms of a bake, for both host and device bakes. All pointers are host memory.
+struct OmmCacheParams
+{
+    uint32_t numOmms;
+
+    // descriptors for each opacticy micromap.
+    const OptixOpacityMicromapDesc* inDescs;
+
+    // per omm representative triangle, as gathered by hostGatherOmmTriangles or launchGatherOmmTriangles.
+    const Triangle* inTriangles;
+
+    // texture inputs of all bake inputs.
+    const TextureInput* inTextures;
+
+    // content key of each texture, indexed by texture id.
+    const cuOmmBaking::BakeCacheKey* inTextureCacheKeys;
+
+    // per omm triangle ID. omms found in the cache are marked uniform, so the evaluation skips them.
+    TriangleID* ioTriangleIdPerOmm;
+
+    // raw micro triangle opacity data.
+    uint8_t* ioData;
+
+    OptixOpacityMicromapFormat format;
+
+    cuOmmBaking::BakeCache* cache;
+};
+
+// copy the omms found in the cache into the data, which must be zeroed, and mark them uniform.
+void hostFindCachedOmms( OmmCacheParams params );
+
+// add the evaluated omms, those not marked uniform, to the cache.
+void hostInsertCachedOmms( OmmCacheParams params );
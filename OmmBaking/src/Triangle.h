@@ -5,12 +5,13 @@
 #pragma once
 
 #include "CuOmmBakingImpl.h"
+#include "Util/Intrinsics.h"
 #include "Util/XXH.h"
 #include "Util/VecMath.h"
 
 namespace {
 
-    __device__ bool operator!=( float2 a0, float2 a1 )
+    inline __device__ __host__ bool operator!=( float2 a0, float2 a1 )
     {
         return a0.x != a1.x || a0.y != a1.y;
     }
@@ -18,12 +19,12 @@ namespace {
 
 struct Triangle
 {
-    __device__ bool operator!=( Triangle key )
+    inline __device__ __host__ bool operator!=( Triangle key )
     {
         return uv0 != key.uv0 || uv1 != key.uv1 || uv2 != key.uv2 || texture != key.texture;
     }
 
-    __device__ float Area() const
+    inline __device__ __host__ float Area() const
     {
         const float2 e0 = uv1 - uv0;
         const float2 e1 = uv2 - uv0;
@@ -35,7 +36,7 @@ struct Triangle
     uint64_t texture;
 };
 
-__device__ uint3 loadIndices( const cuOmmBaking::BakeInputDesc& inputDesc, unsigned int index )
+inline __device__ __host__ uint3 loadIndices( const cuOmmBaking::BakeInputDesc& inputDesc, unsigned int index )
 {
     const void* indexPtr = ( const char* )inputDesc.indexBuffer + index * inputDesc.indexTripletStrideInBytes;
 
@@ -62,13 +63,13 @@ __device__ uint3 loadIndices( const cuOmmBaking::BakeInputDesc& inputDesc, unsig
     return idx3;
 }
 
-__device__ float2 loadTexcoord( const cuOmmBaking::BakeInputDesc& inputDesc, unsigned int index )
+inline __device__ __host__ float2 loadTexcoord( const cuOmmBaking::BakeInputDesc& inputDesc, unsigned int index )
 {
     const float* texcoord = ( const float* )( ( const char* )inputDesc.texCoordBuffer + index * inputDesc.texCoordStrideInBytes );
     return make_float2( texcoord[0], texcoord[1] );
 }
 
-__device__ Triangle loadTriangle( const cuOmmBaking::BakeInputDesc& inputDesc, unsigned int index )
+inline __device__ __host__ Triangle loadTriangle( const cuOmmBaking::BakeInputDesc& inputDesc, unsigned int index )
 {
     Triangle tri;
 
@@ -114,7 +115,7 @@ __device__ Triangle loadTriangle( const cuOmmBaking::BakeInputDesc& inputDesc, u
 }
 
 // convert uv to quantized (integer) representation
-__device__ float2 quantizeUV( float2 uv, const TextureInput& textureInput )
+inline __device__ __host__ float2 quantizeUV( float2 uv, const TextureInput& textureInput )
 {
     float2 f = textureInput.quantizationFrequency;
 
@@ -128,7 +129,7 @@ __device__ float2 quantizeUV( float2 uv, const TextureInput& textureInput )
 }
 
 // snap uv to the nearest quantizable value
-__device__ float2 snapUV( float2 uv, const TextureInput& textureInput )
+inline __device__ __host__ float2 snapUV( float2 uv, const TextureInput& textureInput )
 {
     float2 f = textureInput.quantizationFrequency;
     float2 p = textureInput.quantizationPeriod;
@@ -143,7 +144,7 @@ __device__ float2 snapUV( float2 uv, const TextureInput& textureInput )
 }
 
 // unwrap and quantize triangle coordinates
-__device__ Triangle canonicalizeTriangle( Triangle in, const TextureInput* textureInputs )
+inline __device__ __host__ Triangle canonicalizeTriangle( Triangle in, const TextureInput* textureInputs )
 {
     const TextureInput& textureInput = textureInputs[in.texture];
 
@@ -177,9 +178,9 @@ __device__ Triangle canonicalizeTriangle( Triangle in, const TextureInput* textu
     return out;
 }
 
-__device__ uint32_t hash( Triangle key )
+inline __device__ __host__ uint32_t hash( Triangle key )
 {
-    const uint32_t data[8] = { __float_as_uint( key.uv0.x ), __float_as_uint( key.uv0.y ), __float_as_uint( key.uv1.x ), __float_as_uint( key.uv1.y ), __float_as_uint( key.uv2.x ), __float_as_uint( key.uv2.y ), ( uint32_t )( key.texture & 0xFFFFFFFF ), ( uint32_t )( key.texture >> 32 ) };
+    const uint32_t data[8] = { floatAsUint( key.uv0.x ), floatAsUint( key.uv0.y ), floatAsUint( key.uv1.x ), floatAsUint( key.uv1.y ), floatAsUint( key.uv2.x ), floatAsUint( key.uv2.y ), ( uint32_t )( key.texture & 0xFFFFFFFF ), ( uint32_t )( key.texture >> 32 ) };
 
     return XXH( { data[0], data[1], data[2], data[3] }, { data[4], data[5], data[6], data[7] } );
 }
\ No newline at end of file
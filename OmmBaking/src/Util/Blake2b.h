@@ -0,0 +1,180 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Streaming unkeyed BLAKE2b (RFC 7693), used for content addressing on the host.
+// This is the same hash that the ImageSource library uses for its image hashes and tile disk cache,
+// so both content-addressed caches share one collision resistant hash.
+// Feeding the same bytes in any split over update calls yields the same digest.
+class Blake2b
+{
+  public:
+    static const unsigned int BLOCK_SIZE      = 128;
+    static const unsigned int MAX_DIGEST_SIZE = 64;
+
+    struct Digest
+    {
+        uint64_t lo;
+        uint64_t hi;
+    };
+
+    // Begin a new hash producing a digest of the given size in bytes, between 1 and MAX_DIGEST_SIZE.
+    explicit Blake2b( unsigned int digestSize = 16 )
+        : m_digestSize( digestSize )
+    {
+        for( int i = 0; i < 8; ++i )
+            m_state[i] = iv( i );
+        // parameter block: digest length, no key, fanout 1, depth 1.
+        m_state[0] ^= 0x01010000ull ^ digestSize;
+    }
+
+    void update( const void* data, size_t size )
+    {
+        const uint8_t* bytes = ( const uint8_t* )data;
+        while( size > 0 )
+        {
+            // the final block is compressed with the last block flag, so a full buffer is only compressed once more input arrives.
+            if( m_bufferSize == BLOCK_SIZE )
+            {
+                addToCounter( BLOCK_SIZE );
+                compress( m_buffer, false );
+                m_bufferSize = 0;
+            }
+            const size_t n = ( size < BLOCK_SIZE - m_bufferSize ) ? size : BLOCK_SIZE - m_bufferSize;
+            memcpy( m_buffer + m_bufferSize, bytes, n );
+            m_bufferSize += n;
+            bytes += n;
+            size -= n;
+        }
+    }
+
+    template <typename T>
+    void update( const T& value )
+    {
+        update( &value, sizeof( T ) );
+    }
+
+    // Write the getDigestSize() byte digest. No further updates are allowed.
+    void finish( void* digest )
+    {
+        addToCounter( m_bufferSize );
+        memset( m_buffer + m_bufferSize, 0, BLOCK_SIZE - m_bufferSize );
+        compress( m_buffer, true );
+
+        uint8_t* out = ( uint8_t* )digest;
+        for( unsigned int i = 0; i < m_digestSize; ++i )
+            out[i] = ( uint8_t )( m_state[i / 8] >> ( 8 * ( i % 8 ) ) );
+    }
+
+    // Finish a 16 byte digest, returned as two little endian words.
+    Digest finish()
+    {
+        uint8_t bytes[16];
+        finish( bytes );
+        return { load64( bytes ), load64( bytes + 8 ) };
+    }
+
+    unsigned int getDigestSize() const { return m_digestSize; }
+
+  private:
+    static uint64_t iv( int i )
+    {
+        static const uint64_t IV[8] = { 0x6a09e667f3bcc908ull, 0xbb67ae8584caa73bull, 0x3c6ef372fe94f82bull,
+                                        0xa54ff53a5f1d36f1ull, 0x510e527fade682d1ull, 0x9b05688c2b3e6c1full,
+                                        0x1f83d9abfb41bd6bull, 0x5be0cd19137e2179ull };
+        return IV[i];
+    }
+
+    static const uint8_t* sigma( int round )
+    {
+        static const uint8_t SIGMA[10][16] = {
+            { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },  //
+            { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },  //
+            { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },  //
+            { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },  //
+            { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },  //
+            { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },  //
+            { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },  //
+            { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },  //
+            { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },  //
+            { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },  //
+        };
+        // rounds 10 and 11 reuse the permutations of rounds 0 and 1.
+        return SIGMA[round % 10];
+    }
+
+    static uint64_t rotr( uint64_t x, int r ) { return ( x >> r ) | ( x << ( 64 - r ) ); }
+
+    static uint64_t load64( const uint8_t* bytes )
+    {
+        uint64_t v = 0;
+        for( int i = 7; i >= 0; --i )
+            v = ( v << 8 ) | bytes[i];
+        return v;
+    }
+
+    static void mix( uint64_t* v, int a, int b, int c, int d, uint64_t x, uint64_t y )
+    {
+        v[a] = v[a] + v[b] + x;
+        v[d] = rotr( v[d] ^ v[a], 32 );
+        v[c] = v[c] + v[d];
+        v[b] = rotr( v[b] ^ v[c], 24 );
+        v[a] = v[a] + v[b] + y;
+        v[d] = rotr( v[d] ^ v[a], 16 );
+        v[c] = v[c] + v[d];
+        v[b] = rotr( v[b] ^ v[c], 63 );
+    }
+
+    void addToCounter( uint64_t size )
+    {
+        m_counter[0] += size;
+        if( m_counter[0] < size )
+            ++m_counter[1];
+    }
+
+    void compress( const uint8_t* block, bool isLastBlock )
+    {
+        uint64_t m[16];
+        for( int i = 0; i < 16; ++i )
+            m[i] = load64( block + 8 * i );
+
+        uint64_t v[16];
+        for( int i = 0; i < 8; ++i )
+        {
+            v[i]     = m_state[i];
+            v[i + 8] = iv( i );
+        }
+        v[12] ^= m_counter[0];
+        v[13] ^= m_counter[1];
+        if( isLastBlock )
+            v[14] = ~v[14];
+
+        for( int round = 0; round < 12; ++round )
+        {
+            const uint8_t* s = sigma( round );
+            mix( v, 0, 4, 8, 12, m[s[0]], m[s[1]] );
+            mix( v, 1, 5, 9, 13, m[s[2]], m[s[3]] );
+            mix( v, 2, 6, 10, 14, m[s[4]], m[s[5]] );
+            mix( v, 3, 7, 11, 15, m[s[6]], m[s[7]] );
+            mix( v, 0, 5, 10, 15, m[s[8]], m[s[9]] );
+            mix( v, 1, 6, 11, 12, m[s[10]], m[s[11]] );
+            mix( v, 2, 7, 8, 13, m[s[12]], m[s[13]] );
+            mix( v, 3, 4, 9, 14, m[s[14]], m[s[15]] );
+        }
+
+        for( int i = 0; i < 8; ++i )
+            m_state[i] ^= v[i] ^ v[i + 8];
+    }
+
+    uint64_t     m_state[8];
+    uint64_t     m_counter[2] = {};
+    uint8_t      m_buffer[BLOCK_SIZE];
+    size_t       m_bufferSize = 0;
+    unsigned int m_digestSize;
+};
@@ -0,0 +1,151 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Host and device versions of the CUDA intrinsics used by the baking kernels.
+// The host versions reproduce the IEEE results of the intrinsics, including the directed rounding modes and
+// the saturating float to integer conversions.
+// Host code using these must not be compiled with floating point contraction or fast math.
+
+// reinterpret the bits of a float as an unsigned int
+inline __device__ __host__ uint32_t floatAsUint( float f )
+{
+#if defined( __CUDA_ARCH__ )
+    return __float_as_uint( f );
+#else
+    uint32_t u;
+    memcpy( &u, &f, sizeof( u ) );
+    return u;
+#endif
+}
+
+// float to int conversion rounding toward zero. out of range values saturate and nan converts to zero.
+inline __device__ __host__ int float2intRz( float f )
+{
+#if defined( __CUDA_ARCH__ )
+    return __float2int_rz( f );
+#else
+    if( f != f )
+        return 0;
+    if( f >= 2147483648.f )
+        return INT_MAX;
+    if( f <= -2147483648.f )
+        return INT_MIN;
+    return ( int )f;
+#endif
+}
+
+// float to unsigned int conversion rounding toward zero. out of range values saturate and nan converts to zero.
+inline __device__ __host__ uint32_t float2uintRz( float f )
+{
+#if defined( __CUDA_ARCH__ )
+    return __float2uint_rz( f );
+#else
+    if( !( f > 0.f ) )
+        return 0;
+    if( f >= 4294967296.f )
+        return UINT_MAX;
+    return ( uint32_t )f;
+#endif
+}
+
+// number of leading zero bits, 32 for zero
+inline __device__ __host__ uint32_t clz( uint32_t x )
+{
+#if defined( __CUDA_ARCH__ )
+    return __clz( x );
+#else
+    uint32_t n = 0;
+    while( n < 32 && ( x & ( 0x80000000u >> n ) ) == 0 )
+        ++n;
+    return n;
+#endif
+}
+
+// a / b, rounded toward zero
+inline __device__ __host__ float fdivRz( float a, float b )
+{
+#if defined( __CUDA_ARCH__ )
+    return __fdiv_rz( a, b );
+#else
+    // the rounded to nearest quotient is at most one ulp away from the rounded toward zero quotient.
+    // its product with the divisor is exact in double precision and tells if it overshoots.
+    float q = a / b;
+    if( std::isfinite( b ) && b != 0.f && std::fabs( ( double )q * ( double )b ) > std::fabs( ( double )a ) )
+        q = std::nextafter( q, 0.f );
+    return q;
+#endif
+}
+
+// 1 / x, rounded down
+inline __device__ __host__ float frcpRd( float x )
+{
+#if defined( __CUDA_ARCH__ )
+    return __frcp_rd( x );
+#else
+    float q = 1.f / x;
+    if( std::isfinite( x ) && x != 0.f )
+    {
+        // the product is exact in double precision. q is too large if q * x overshoots one in the direction of x.
+        const double p = ( double )q * ( double )x;
+        if( x > 0.f ? ( p > 1.0 ) : ( p < 1.0 ) )
+            q = std::nextafter( q, -INFINITY );
+    }
+    return q;
+#endif
+}
+
+// a * b + c with a single rounding toward zero
+inline __device__ __host__ float fmafRz( float a, float b, float c )
+{
+#if defined( __CUDA_ARCH__ )
+    return __fmaf_rz( a, b, c );
+#else
+    // the product is exact in double precision, the sum is split in a rounded sum and its exact error.
+    const double p  = ( double )a * ( double )b;
+    const double s  = p + ( double )c;
+    const double bb = s - p;
+    const double e  = ( p - ( s - bb ) ) + ( ( double )c - bb );
+
+    // f is one of the two floats enclosing the exact result s + e. step toward zero if it overshoots.
+    float        f = ( float )s;
+    const double d = ( double )f - s;
+    if( ( s > 0.0 && d > e ) || ( s < 0.0 && d < e ) )
+        f = std::nextafter( f, 0.f );
+    return f;
+#endif
+}
+
+// a + b, rounded up
+inline __device__ __host__ float faddRu( float a, float b )
+{
+#if defined( __CUDA_ARCH__ )
+    return __fadd_ru( a, b );
+#else
+    float s = a + b;
+    if( std::isfinite( s ) )
+    {
+        // exact rounding error of the sum
+        const float bb = s - a;
+        const float e  = ( a - ( s - bb ) ) + ( b - bb );
+        if( e > 0.f )
+            s = std::nextafter( s, INFINITY );
+    }
+    else if( s == -INFINITY && std::isfinite( a ) && std::isfinite( b ) )
+    {
+        // negative overflow rounds up to the lowest finite value
+        s = -FLT_MAX;
+    }
+    return s;
+#endif
+}
@@ -6,20 +6,22 @@
 
 #include <cfloat>
 
+#include "Intrinsics.h"
+
 namespace rasterize
 {
-    __device__ float cross( const float2& a, const float2& b )
+    inline __device__ __host__ float cross( const float2& a, const float2& b )
     {
         return a.x * b.y - a.y * b.x;
     }
 
-    __device__ float2 perp( const float2& a )
+    inline __device__ __host__ float2 perp( const float2& a )
     {
         return { a.y, -a.x };
     }
 
     template <typename T>
-    __device__ void swap( T& a, T& b )
+    inline __device__ __host__ void swap( T& a, T& b )
     {
         T tmp = a;
         a = b;
@@ -27,13 +29,13 @@ namespace rasterize
     }
 
     template <typename T>
-    __device__ T min( const T& a, const T& b )
+    inline __device__ __host__ T min( const T& a, const T& b )
     {
         return ( a > b ) ? b : a;
     }
 
     template <typename T>
-    __device__ T max( const T& a, const T& b )
+    inline __device__ __host__ T max( const T& a, const T& b )
     {
         return ( a < b ) ? b : a;
     }
@@ -42,7 +44,7 @@ namespace rasterize
     // the triangle is rasterized in up to N non-overlapping integer AABB in texel space.
     // the function returns the sum of all AABB evaluations.
     template <typename T, typename U>
-    __device__ T rasterize( U            eval,  // evaluation function
+    inline __device__ __host__ T rasterize( U            eval,  // evaluation function
         float2       v0,
         float2       v1,
         float2       v2,
@@ -92,7 +94,7 @@ namespace rasterize
         const float inv2 = 1.f / n2.x;  // degenerate long edge doesn't matter
 
         const float by = floorf( v0.y - w );
-        const int   dy = ( int )ceilf( ( v2.y + w ) - by );
+        const int   dy = float2intRz( ceilf( ( v2.y + w ) - by ) );
 
         // clamp iteration count.
         // there's no point in evaluate multiple consequitive 'stripes' within a single texel scanline.
@@ -145,13 +147,13 @@ namespace rasterize
                 }
 
                 int2 lo = {
-                    ( int )floorf( fminf( interval.x, prev_interval.x ) ),
-                    ( int )prev_y  // already rounded
+                    float2intRz( floorf( fminf( interval.x, prev_interval.x ) ) ),
+                    float2intRz( prev_y )  // already rounded
                 };
 
                 int2 hi = {
-                    max( lo.x, ( int )ceilf( fmaxf( interval.y, prev_interval.y ) ) - 1 ),
-                    ( int )next_y - 1  // already rounded
+                    max( lo.x, float2intRz( ceilf( fmaxf( interval.y, prev_interval.y ) ) ) - 1 ),
+                    float2intRz( next_y ) - 1  // already rounded
                 };
 
                 states += eval( lo, hi );
@@ -26,7 +26,7 @@
 //  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
 
-__device__ unsigned int XXH( const uint4& p )
+inline __device__ __host__ unsigned int XXH( const uint4& p )
 {
     constexpr unsigned int PRIME32_2 = 2246822519u, PRIME32_3 = 3266489917u;
     constexpr unsigned int PRIME32_4 = 668265263u, PRIME32_5 = 374761393u;
@@ -41,7 +41,7 @@ __device__ unsigned int XXH( const uint4& p )
     return h32 ^ ( h32 >> 16 );
 }
 
-__device__ unsigned int XXH( const uint4& p0, const uint4& p1 )
+inline __device__ __host__ unsigned int XXH( const uint4& p0, const uint4& p1 )
 {
     constexpr unsigned int PRIME32_2 = 2246822519u, PRIME32_3 = 3266489917u;
     constexpr unsigned int PRIME32_4 = 668265263u, PRIME32_5 = 374761393u;
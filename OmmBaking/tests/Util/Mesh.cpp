@@ -186,6 +186,16 @@ cudaError_t Mesh::create( const std::vector<float2>& texCoords, const std::vecto
     OMM_CUDA_CHECK( m_indices.allocAndUpload( raw_indices ) );
     OMM_CUDA_CHECK( m_textures.allocAndUpload( raw_textures ) );
 
+    // 8 byte aligned host copies satisfy all baking buffer alignment requirements.
+    auto copyToHost = []( const std::vector<char>& raw, std::vector<uint64_t>& host ) {
+        host.assign( ( raw.size() + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ), 0 );
+        if( !raw.empty() )
+            memcpy( host.data(), raw.data(), raw.size() );
+    };
+    copyToHost( raw_indices, m_hostIndices );
+    copyToHost( raw_texCoords, m_hostTexCoords );
+    copyToHost( raw_textures, m_hostTextures );
+
     m_numVertices  = (uint32_t)vertices.size();
     m_numTexCoords = (uint32_t)texCoords.size();
     m_numIndices   = (uint32_t)indices.size();
@@ -216,3 +226,13 @@ cuOmmBaking::BakeInputDesc Mesh::getBakingInputDesc() const
     return desc;
 }
 
+cuOmmBaking::BakeInputDesc Mesh::getHostBakingInputDesc() const
+{
+    cuOmmBaking::BakeInputDesc desc = getBakingInputDesc();
+
+    desc.texCoordBuffer     = m_hostTexCoords.empty() ? 0 : ( CUdeviceptr )m_hostTexCoords.data();
+    desc.indexBuffer        = m_hostIndices.empty() ? 0 : ( CUdeviceptr )m_hostIndices.data();
+    desc.textureIndexBuffer = m_hostTextures.empty() ? 0 : ( CUdeviceptr )m_hostTextures.data();
+
+    return desc;
+}
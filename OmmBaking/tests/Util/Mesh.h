@@ -50,6 +50,10 @@ class Mesh
         m_texCoords.free();
         m_textures.free();
 
+        m_hostIndices.clear();
+        m_hostTexCoords.clear();
+        m_hostTextures.clear();
+
         m_format = {};
 
         m_numVertices  = 0;
@@ -62,6 +66,9 @@ class Mesh
 
     cuOmmBaking::BakeInputDesc getBakingInputDesc() const;
 
+    // Baking input referencing host memory copies of the device buffers, for BakeFlags::BAKE_ON_HOST.
+    cuOmmBaking::BakeInputDesc getHostBakingInputDesc() const;
+
   private:
     void swap( Mesh& source ) noexcept
     {
@@ -70,6 +77,10 @@ class Mesh
         std::swap( source.m_texCoords, m_texCoords );
         std::swap( source.m_textures, m_textures );
 
+        std::swap( source.m_hostIndices, m_hostIndices );
+        std::swap( source.m_hostTexCoords, m_hostTexCoords );
+        std::swap( source.m_hostTextures, m_hostTextures );
+
         std::swap( source.m_format, m_format );
 
         std::swap( source.m_numVertices, m_numVertices );
@@ -82,6 +93,10 @@ class Mesh
     CuBuffer<char> m_texCoords;
     CuBuffer<char> m_textures;
 
+    std::vector<uint64_t> m_hostIndices;
+    std::vector<uint64_t> m_hostTexCoords;
+    std::vector<uint64_t> m_hostTextures;
+
     Format   m_format       = {};
     uint32_t m_numVertices  = 0;
     uint32_t m_numTexCoords = 0;
@@ -82,6 +82,9 @@ cuOmmBaking::Result OptixOmmArray::create( OptixDeviceContext context, const cuO
     inputUsageDescOffset.push_back( outOmmUsageDescSize );
 
     CUDA_CHECK( d_indices.alloc( outOmmIndexBufferSizeInBytes ) );
+
+    // host baking reads its inputs from and writes its outputs to host memory. the outputs are uploaded after the bake.
+    const bool bakeOnHost = ( options.flags & cuOmmBaking::BakeFlags::BAKE_ON_HOST ) == cuOmmBaking::BakeFlags::BAKE_ON_HOST;
     
     HistogramEntries_t           histogram;
     cuOmmBaking::PostBakeInfo  postInfo = {};
@@ -114,41 +117,68 @@ cuOmmBaking::Result OptixOmmArray::create( OptixDeviceContext context, const cuO
         // materialize to obtain the buffer size
         downloadAggregateBuf.materialize();
 
-        // allocate the post bake buffer
-        d_downloadAggregate.alloc( downloadAggregateBuf.getNumBytes() );
+        // properly aligned host buffer for the aggregate buffer. TODO: eventually use aligned_alloc (c++17)
+        std::vector<unsigned char> h_postBuildData( downloadAggregateBuf.getNumBytes() + downloadAggregateBuf.getAlignmentInBytes() );
+        void* ptr = h_postBuildData.data(); size_t space = h_postBuildData.size();
+        ptr = std::align( downloadAggregateBuf.getAlignmentInBytes(), downloadAggregateBuf.getNumBytes(), ptr, space );
 
-        // rematerialize with the actual device pointer
-        downloadAggregateBuf.materialize( (unsigned char*)d_downloadAggregate.get() );
+        if( bakeOnHost )
+        {
+            // the host bake writes the aggregate buffer directly
+            downloadAggregateBuf.materialize( ( unsigned char* )ptr );
+        }
+        else
+        {
+            // allocate the post bake buffer
+            d_downloadAggregate.alloc( downloadAggregateBuf.getNumBytes() );
+
+            // rematerialize with the actual device pointer
+            downloadAggregateBuf.materialize( (unsigned char*)d_downloadAggregate.get() );
+        }
 
         CUDA_CHECK( d_temp.alloc( buffers.tempBufferSizeInBytes ) );
         CUDA_CHECK( d_output.alloc( buffers.outputBufferSizeInBytes ) );
         CUDA_CHECK( d_perMicromapDescs.alloc( buffers.numMicromapDescs ) );
 
-        outOmmIndexBufferSizeInBytes = 0;
+        // host memory for the host bake, 8 byte aligned to satisfy all baking buffer alignment requirements
+        std::vector<uint64_t> h_temp, h_output, h_perMicromapDescs, h_indices;
+        if( bakeOnHost )
+        {
+            h_temp.resize( ( buffers.tempBufferSizeInBytes + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ) );
+            h_output.resize( ( buffers.outputBufferSizeInBytes + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ) );
+            h_perMicromapDescs.resize( ( buffers.numMicromapDescs * sizeof( OptixOpacityMicromapDesc ) + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ) );
+            h_indices.resize( ( outOmmIndexBufferSizeInBytes + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ) );
+        }
+
+        const CUdeviceptr indices = bakeOnHost ? ( CUdeviceptr )h_indices.data() : d_indices.get();
         for( uint32_t i = 0; i < numInputs; ++i )
         {
-            inputBuffers[i].indexBuffer = d_indices.get() + inputIndexBufferOffsetInBytes[i];
+            inputBuffers[i].indexBuffer = indices + inputIndexBufferOffsetInBytes[i];
             inputBuffers[i].micromapUsageCountsBuffer = (CUdeviceptr)(usageBuf.access() + inputUsageDescOffset[i]);
         }
 
-        buffers.outputBuffer = d_output.get();
-        buffers.perMicromapDescBuffer = d_perMicromapDescs.get();
+        buffers.outputBuffer = bakeOnHost ? ( CUdeviceptr )h_output.data() : d_output.get();
+        buffers.perMicromapDescBuffer = bakeOnHost ? ( CUdeviceptr )h_perMicromapDescs.data() : d_perMicromapDescs.get();
         buffers.micromapHistogramEntriesBuffer = ( CUdeviceptr )histogramBuf.access();
         if( ( options.flags & cuOmmBaking::BakeFlags::ENABLE_POST_BAKE_INFO ) == cuOmmBaking::BakeFlags::ENABLE_POST_BAKE_INFO )
             buffers.postBakeInfoBuffer = ( CUdeviceptr )infoBuf.access();
-        buffers.tempBuffer = d_temp.get();
+        buffers.tempBuffer = bakeOnHost ? ( CUdeviceptr )h_temp.data() : d_temp.get();
 
         OMM_CHECK( cuOmmBaking::BakeOpacityMicromaps( &options, numInputs, inputs, inputBuffers.data(), &buffers, 0 ) );
 
-        // download the aggregate buffer into a properly aligned host buffer. TODO: eventually use aligned_alloc (c++17)
-        std::vector<unsigned char> h_postBuildData( downloadAggregateBuf.getNumBytes() + downloadAggregateBuf.getAlignmentInBytes() );
-        void* ptr = h_postBuildData.data(); size_t space = h_postBuildData.size();
-        ptr = std::align( downloadAggregateBuf.getAlignmentInBytes(), downloadAggregateBuf.getNumBytes(), ptr, space );
-
-        // rematerialize the buffer layout on the host buffer
-        downloadAggregateBuf.materialize( ( unsigned char* )ptr );
+        if( bakeOnHost )
+        {
+            CUDA_CHECK( cudaMemcpy( ( void* )d_output.get(), h_output.data(), buffers.outputBufferSizeInBytes, cudaMemcpyHostToDevice ) );
+            CUDA_CHECK( cudaMemcpy( ( void* )d_perMicromapDescs.get(), h_perMicromapDescs.data(), buffers.numMicromapDescs * sizeof( OptixOpacityMicromapDesc ), cudaMemcpyHostToDevice ) );
+            CUDA_CHECK( cudaMemcpy( ( void* )d_indices.get(), h_indices.data(), outOmmIndexBufferSizeInBytes, cudaMemcpyHostToDevice ) );
+        }
+        else
+        {
+            // rematerialize the buffer layout on the host buffer
+            downloadAggregateBuf.materialize( ( unsigned char* )ptr );
 
-        CUDA_CHECK( d_downloadAggregate.download( (unsigned char*)downloadAggregateBuf.access() ) );
+            CUDA_CHECK( d_downloadAggregate.download( (unsigned char*)downloadAggregateBuf.access() ) );
+        }
         for( uint32_t i = 0; i < numInputs; ++i )
         {
             usage[i] = UsageCounts_t( usageBuf.access() + inputUsageDescOffset[i], usageBuf.access() + inputUsageDescOffset[i + 1] );
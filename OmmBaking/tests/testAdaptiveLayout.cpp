@@ -0,0 +1,162 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "AdaptiveLayout.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {  // anonymous
+
+OmmUnknownStatistics makeStats( float weight, std::vector<float> unknownFraction, uint32_t maxSubdivisionLevel = OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL )
+{
+    OmmUnknownStatistics stats = {};
+    stats.weight               = weight;
+    stats.maxSubdivisionLevel  = maxSubdivisionLevel;
+    stats.numProbeLevels       = ( uint32_t )unknownFraction.size();
+    std::copy( unknownFraction.begin(), unknownFraction.end(), stats.unknownFraction );
+    return stats;
+}
+
+uint32_t getSizeInBytes( uint32_t subdivisionLevel, OptixOpacityMicromapFormat format )
+{
+    const uint32_t logStatesPerByte = ( format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE ) ? 3 : 2;
+    return 1u << ( std::max( 2 * subdivisionLevel, logStatesPerByte ) - logStatesPerByte );
+}
+
+std::vector<uint32_t> assignLevels( const std::vector<OmmUnknownStatistics>& stats, uint32_t maxSizeInBytes, OptixOpacityMicromapFormat format = OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE )
+{
+    std::vector<uint32_t> levels( stats.size() );
+    const uint32_t sizeInBytes = assignAdaptiveSubdivisionLevels( stats.data(), ( uint32_t )stats.size(), maxSizeInBytes, format, levels.data() );
+
+    uint32_t expectedSizeInBytes = 0;
+    for( uint32_t level : levels )
+        expectedSizeInBytes += getSizeInBytes( level, format );
+    EXPECT_EQ( expectedSizeInBytes, sizeInBytes );
+
+    return levels;
+}
+
+}  // namespace
+
+TEST( AdaptiveLayoutTest, ExpectedUnknownFraction )
+{
+    const OmmUnknownStatistics stats = makeStats( 1.f, { 1.f, 0.75f, 0.5f } );
+
+    EXPECT_EQ( 1.f, getExpectedUnknownFraction( stats, 0 ) );
+    EXPECT_EQ( 0.75f, getExpectedUnknownFraction( stats, 1 ) );
+    EXPECT_EQ( 0.5f, getExpectedUnknownFraction( stats, 2 ) );
+
+    // beyond the counted levels, the unknown fraction decays at the rate of the last two levels
+    EXPECT_FLOAT_EQ( 0.5f * 2.f / 3.f, getExpectedUnknownFraction( stats, 3 ) );
+    EXPECT_FLOAT_EQ( 0.5f * 4.f / 9.f, getExpectedUnknownFraction( stats, 4 ) );
+
+    // at most halving per level
+    EXPECT_FLOAT_EQ( 0.05f, getExpectedUnknownFraction( makeStats( 1.f, { 1.f, 0.1f } ), 2 ) );
+    EXPECT_FLOAT_EQ( 0.25f, getExpectedUnknownFraction( makeStats( 1.f, { 0.5f } ), 1 ) );
+}
+
+TEST( AdaptiveLayoutTest, UnknownTexelsStayCoarse )
+{
+    // the first omm covers unknown texels, which no subdivision level resolves
+    const std::vector<OmmUnknownStatistics> stats = { makeStats( 4.f, { 1.f, 1.f, 1.f, 1.f } ), makeStats( 1.f, { 1.f, 1.f, 0.5f, 0.25f } ) };
+
+    EXPECT_EQ( 1.f, getExpectedUnknownFraction( stats[0], 8 ) );
+
+    const std::vector<uint32_t> levels = assignLevels( stats, 2 + 64 );
+
+    EXPECT_EQ( 1u, levels[0] );
+    EXPECT_EQ( 4u, levels[1] );
+}
+
+TEST( AdaptiveLayoutTest, ResolvedOmmsStayCoarse )
+{
+    // the first omm is resolved at level 1, the second has an opacity edge
+    const std::vector<OmmUnknownStatistics> stats = { makeStats( 1.f, { 1.f, 0.f, 0.f, 0.f } ), makeStats( 1.f, { 1.f, 1.f, 0.5f, 0.25f } ) };
+
+    const std::vector<uint32_t> levels = assignLevels( stats, 2 + 64 );
+
+    EXPECT_EQ( 1u, levels[0] );
+    EXPECT_EQ( 4u, levels[1] );
+}
+
+TEST( AdaptiveLayoutTest, SkipsLevelsWithoutGain )
+{
+    // only level 3 resolves unknown micro triangles
+    const std::vector<OmmUnknownStatistics> stats = { makeStats( 1.f, { 1.f, 1.f, 1.f, 0.f } ) };
+
+    EXPECT_EQ( 3u, assignLevels( stats, 16 )[0] );
+
+    // level 3 does not fit
+    EXPECT_EQ( 1u, assignLevels( stats, 15 )[0] );
+}
+
+TEST( AdaptiveLayoutTest, PrefersLargerWeight )
+{
+    const std::vector<OmmUnknownStatistics> stats = { makeStats( 1.f, { 1.f, 0.5f } ), makeStats( 4.f, { 1.f, 0.5f } ) };
+
+    // the size fits a single level 2 omm
+    const std::vector<uint32_t> levels = assignLevels( stats, 1 + 4 );
+
+    EXPECT_EQ( 1u, levels[0] );
+    EXPECT_EQ( 2u, levels[1] );
+}
+
+TEST( AdaptiveLayoutTest, MaximumSubdivisionLevel )
+{
+    const std::vector<OmmUnknownStatistics> stats = { makeStats( 1.f, { 1.f, 0.5f }, 3 ), makeStats( 1.f, { 1.f, 0.5f }, 20 ) };
+
+    const std::vector<uint32_t> levels = assignLevels( stats, ~0u );
+
+    EXPECT_EQ( 3u, levels[0] );
+    EXPECT_EQ( ( uint32_t )OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL, levels[1] );
+}
+
+TEST( AdaptiveLayoutTest, InsufficientSize )
+{
+    const std::vector<OmmUnknownStatistics> stats( 4, makeStats( 1.f, { 1.f, 1.f } ) );
+
+    // all omms are at least one byte
+    EXPECT_EQ( std::vector<uint32_t>( 4, 1 ), assignLevels( stats, 2 ) );
+}
+
+TEST( AdaptiveLayoutTest, SizeLimit )
+{
+    std::mt19937                          rng( 1 );
+    std::uniform_real_distribution<float> fraction( 0.f, 1.f );
+    std::uniform_int_distribution<int>    numProbeLevels( 1, ADAPTIVE_LAYOUT_NUM_PROBE_LEVELS );
+    std::uniform_int_distribution<int>    maxLevel( 1, OPTIX_OPACITY_MICROMAP_MAX_SUBDIVISION_LEVEL );
+
+    std::vector<OmmUnknownStatistics> stats;
+    for( int i = 0; i < 1000; ++i )
+    {
+        std::vector<float> unknownFraction( numProbeLevels( rng ) );
+        for( float& f : unknownFraction )
+            f = fraction( rng );
+        std::sort( unknownFraction.rbegin(), unknownFraction.rend() );
+        stats.push_back( makeStats( 100.f * fraction( rng ), unknownFraction, maxLevel( rng ) ) );
+    }
+
+    for( OptixOpacityMicromapFormat format : { OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE, OPTIX_OPACITY_MICROMAP_FORMAT_4_STATE } )
+    {
+        for( uint32_t maxSizeInBytes : { 1000u, 1001u, 4000u, 100000u, 1u << 24 } )
+        {
+            SCOPED_TRACE( maxSizeInBytes );
+
+            const std::vector<uint32_t> levels = assignLevels( stats, maxSizeInBytes, format );
+
+            uint32_t sizeInBytes = 0;
+            for( size_t i = 0; i < stats.size(); ++i )
+            {
+                EXPECT_GE( levels[i], 1u );
+                EXPECT_LE( levels[i], stats[i].maxSubdivisionLevel );
+                sizeInBytes += getSizeInBytes( levels[i], format );
+            }
+            EXPECT_LE( sizeInBytes, maxSizeInBytes );
+        }
+    }
+}
@@ -0,0 +1,289 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "BakeCache.h"
+
+#include <OptiXToolkit/CuOmmBaking/CuOmmBaking.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace cuOmmBaking;
+
+namespace {  // anonymous
+
+const uint64_t CACHE_SIZE = 64 * 1024;
+
+BakeCacheKey makeKey( uint32_t i )
+{
+    return { 0x9e3779b97f4a7c15ull * ( i + 1 ), ~( uint64_t )i };
+}
+
+// Micromap data that depends on the key index.
+std::vector<uint8_t> makeData( uint32_t i, uint32_t sizeInBytes )
+{
+    std::vector<uint8_t> data( sizeInBytes );
+    for( uint32_t j = 0; j < sizeInBytes; ++j )
+        data[j] = ( uint8_t )( i * 31 + j * 7 + 1 );
+    return data;
+}
+
+std::vector<char> readFile( const std::string& path )
+{
+    std::ifstream file( path, std::ios::binary );
+    return std::vector<char>( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+}
+
+void writeFile( const std::string& path, const std::vector<char>& contents )
+{
+    std::ofstream file( path, std::ios::binary | std::ios::trunc );
+    file.write( contents.data(), contents.size() );
+}
+
+class BakeCacheTest : public testing::Test
+{
+  protected:
+    void TearDown() override
+    {
+        m_cache.reset();
+        std::remove( m_path.c_str() );
+        std::remove( m_copyPath.c_str() );
+    }
+
+    void open( uint64_t sizeInBytes = CACHE_SIZE ) { m_cache.reset( new BakeCache( m_path, sizeInBytes ) ); }
+
+    void insert( uint32_t i, uint32_t sizeInBytes ) { EXPECT_TRUE( m_cache->insert( makeKey( i ), makeData( i, sizeInBytes ).data(), sizeInBytes ) ); }
+
+    bool contains( uint32_t i, uint32_t sizeInBytes )
+    {
+        std::vector<uint8_t> data( sizeInBytes );
+        if( !m_cache->find( makeKey( i ), data.data(), sizeInBytes ) )
+            return false;
+        EXPECT_EQ( makeData( i, sizeInBytes ), data );
+        return true;
+    }
+
+    const std::string          m_path{ "testBakeCache.omm" };
+    const std::string          m_copyPath{ "testBakeCacheCopy.omm" };
+    std::unique_ptr<BakeCache> m_cache;
+};
+
+}  // namespace
+
+TEST_F( BakeCacheTest, InsertAndFind )
+{
+    open();
+
+    insert( 0, 16 );
+    insert( 1, 64 );
+
+    EXPECT_TRUE( contains( 0, 16 ) );
+    EXPECT_TRUE( contains( 1, 64 ) );
+    EXPECT_FALSE( contains( 2, 16 ) );
+
+    BakeCacheStatistics statistics = m_cache->getStatistics();
+    EXPECT_EQ( 2u, statistics.numHits );
+    EXPECT_EQ( 1u, statistics.numMisses );
+    EXPECT_EQ( 2u, statistics.numInserts );
+    EXPECT_EQ( 2u, statistics.numMicromaps );
+    EXPECT_EQ( 0u, statistics.numEvictions );
+}
+
+TEST_F( BakeCacheTest, InsertExistingKey )
+{
+    open();
+
+    insert( 0, 16 );
+    insert( 0, 16 );
+
+    EXPECT_EQ( 1u, m_cache->getStatistics().numInserts );
+    EXPECT_EQ( 1u, m_cache->getStatistics().numMicromaps );
+}
+
+TEST_F( BakeCacheTest, SizeMismatchIsMiss )
+{
+    open();
+
+    insert( 0, 16 );
+
+    std::vector<uint8_t> data( 32 );
+    EXPECT_FALSE( m_cache->find( makeKey( 0 ), data.data(), 32 ) );
+}
+
+TEST_F( BakeCacheTest, OversizedMicromapIsRejected )
+{
+    open();
+
+    std::vector<uint8_t> data( CACHE_SIZE / 2 );
+    EXPECT_FALSE( m_cache->insert( makeKey( 0 ), data.data(), ( uint32_t )data.size() ) );
+    EXPECT_EQ( 0u, m_cache->getStatistics().numMicromaps );
+}
+
+TEST_F( BakeCacheTest, Persistence )
+{
+    open();
+    for( uint32_t i = 0; i < 32; ++i )
+        insert( i, 4 << ( i % 5 ) );
+    m_cache.reset();
+
+    open();
+    EXPECT_EQ( 32u, m_cache->getStatistics().numMicromaps );
+    for( uint32_t i = 0; i < 32; ++i )
+        EXPECT_TRUE( contains( i, 4 << ( i % 5 ) ) );
+}
+
+TEST_F( BakeCacheTest, Clear )
+{
+    open();
+    insert( 0, 16 );
+    m_cache->clear();
+
+    EXPECT_FALSE( contains( 0, 16 ) );
+    EXPECT_EQ( 0u, m_cache->getStatistics().numMicromaps );
+    EXPECT_EQ( 0u, m_cache->getStatistics().usedBytes );
+}
+
+TEST_F( BakeCacheTest, EvictsOldest )
+{
+    open();
+
+    const uint32_t numMicromaps = 2000;
+    for( uint32_t i = 0; i < numMicromaps; ++i )
+        insert( i, 200 );
+
+    BakeCacheStatistics statistics = m_cache->getStatistics();
+    EXPECT_GT( statistics.numEvictions, 0u );
+    EXPECT_EQ( numMicromaps, statistics.numMicromaps + statistics.numEvictions );
+    EXPECT_LE( statistics.usedBytes, CACHE_SIZE );
+
+    // the cached micromaps are the most recently inserted ones. found micromaps are re-appended,
+    // so look them up from oldest to newest.
+    const uint32_t numCached = ( uint32_t )statistics.numMicromaps;
+    EXPECT_FALSE( contains( 0, 200 ) );
+    EXPECT_FALSE( contains( numMicromaps - numCached - 1, 200 ) );
+    for( uint32_t i = numMicromaps - numCached; i < numMicromaps; ++i )
+        EXPECT_TRUE( contains( i, 200 ) );
+    EXPECT_EQ( numCached, m_cache->getStatistics().numMicromaps );
+}
+
+TEST_F( BakeCacheTest, FoundMicromapsSurviveEviction )
+{
+    open();
+
+    // micromap 0 is found regularly while other micromaps stream through the cache
+    insert( 0, 200 );
+    for( uint32_t i = 1; i < 2000; ++i )
+    {
+        insert( i, 200 );
+        if( i % 16 == 0 )
+        {
+            EXPECT_TRUE( contains( 0, 200 ) );
+        }
+    }
+
+    EXPECT_TRUE( contains( 0, 200 ) );
+    EXPECT_FALSE( contains( 1, 200 ) );
+}
+
+TEST_F( BakeCacheTest, IndexLoadIsBounded )
+{
+    open();
+
+    // many tiny micromaps are limited by the index rather than the storage
+    for( uint32_t i = 0; i < 10000; ++i )
+        insert( i, 1 );
+
+    const BakeCacheStatistics statistics = m_cache->getStatistics();
+    EXPECT_GT( statistics.numEvictions, 0u );
+    EXPECT_TRUE( contains( 9999, 1 ) );
+}
+
+TEST_F( BakeCacheTest, CorruptMicromapIsMiss )
+{
+    open();
+    insert( 7, 64 );
+    m_cache.reset();
+
+    // flip a byte of the stored data
+    std::vector<uint8_t> data     = makeData( 7, 64 );
+    std::vector<char>    pattern( data.begin(), data.end() );
+    std::vector<char>    contents = readFile( m_path );
+    auto location = std::search( contents.begin(), contents.end(), pattern.begin(), pattern.end() );
+    ASSERT_NE( contents.end(), location );
+    location[10] ^= 1;
+    writeFile( m_path, contents );
+
+    open();
+    EXPECT_FALSE( contains( 7, 64 ) );
+    EXPECT_EQ( 0u, m_cache->getStatistics().numMicromaps );
+}
+
+TEST_F( BakeCacheTest, UncleanFileIsReset )
+{
+    open();
+    insert( 0, 16 );
+    m_cache->flush();
+
+    // a copy of the file while it is open appears to be left by a crashed process
+    writeFile( m_copyPath, readFile( m_path ) );
+
+    BakeCache copy( m_copyPath, CACHE_SIZE );
+    EXPECT_EQ( 0u, copy.getStatistics().numMicromaps );
+}
+
+TEST_F( BakeCacheTest, ResizeResets )
+{
+    open();
+    insert( 0, 16 );
+    m_cache.reset();
+
+    open( 2 * CACHE_SIZE );
+    EXPECT_FALSE( contains( 0, 16 ) );
+
+    insert( 1, 16 );
+    EXPECT_TRUE( contains( 1, 16 ) );
+}
+
+TEST_F( BakeCacheTest, FileInUse )
+{
+    BakeCacheOptions options;
+    options.path        = m_path.c_str();
+    options.sizeInBytes = CACHE_SIZE;
+
+    BakeCache* cache = nullptr;
+    ASSERT_EQ( Result::SUCCESS, CreateBakeCache( &options, &cache ) );
+
+    BakeCache* other = nullptr;
+    EXPECT_EQ( Result::ERROR_INVALID_VALUE, CreateBakeCache( &options, &other ) );
+
+    BakeCacheStatistics statistics = {};
+    EXPECT_EQ( Result::SUCCESS, GetBakeCacheStatistics( cache, &statistics ) );
+    EXPECT_EQ( Result::SUCCESS, DestroyBakeCache( cache ) );
+
+    // the file is released
+    ASSERT_EQ( Result::SUCCESS, CreateBakeCache( &options, &other ) );
+    EXPECT_EQ( Result::SUCCESS, DestroyBakeCache( other ) );
+}
+
+TEST_F( BakeCacheTest, InvalidOptions )
+{
+    BakeCache* cache = nullptr;
+
+    BakeCacheOptions options;
+    EXPECT_EQ( Result::ERROR_INVALID_VALUE, CreateBakeCache( &options, &cache ) );
+    EXPECT_EQ( Result::ERROR_INVALID_VALUE, CreateBakeCache( nullptr, &cache ) );
+
+    options.path        = m_path.c_str();
+    options.sizeInBytes = 1024;
+    EXPECT_EQ( Result::ERROR_INVALID_VALUE, CreateBakeCache( &options, &cache ) );
+
+    EXPECT_EQ( Result::ERROR_INVALID_VALUE, DestroyBakeCache( nullptr ) );
+}
@@ -0,0 +1,87 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "Util/Blake2b.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {  // anonymous
+
+std::string toHex( const std::vector<uint8_t>& digest )
+{
+    std::string hex;
+    for( uint8_t byte : digest )
+    {
+        char buffer[3];
+        std::snprintf( buffer, sizeof( buffer ), "%02x", byte );
+        hex += buffer;
+    }
+    return hex;
+}
+
+std::string hashHex( const std::vector<uint8_t>& message, unsigned int digestSize, size_t chunkSize )
+{
+    Blake2b hasher( digestSize );
+    for( size_t begin = 0; begin < message.size(); begin += chunkSize )
+        hasher.update( message.data() + begin, std::min( chunkSize, message.size() - begin ) );
+    std::vector<uint8_t> digest( digestSize );
+    hasher.finish( digest.data() );
+    return toHex( digest );
+}
+
+std::vector<uint8_t> makeMessage( size_t size )
+{
+    std::vector<uint8_t> message( size );
+    for( size_t i = 0; i < size; ++i )
+        message[i] = ( uint8_t )( i % 251 );
+    return message;
+}
+
+}  // namespace
+
+// RFC 7693, Appendix A.
+TEST( Blake2bTest, MatchesRfc7693Example )
+{
+    const std::vector<uint8_t> abc{ 'a', 'b', 'c' };
+    EXPECT_EQ(
+        "ba80a53f981c4d0d6a2797b69f12f6e94c212f14685ac4b74b12bb6fdbffa2d1"
+        "7d87c5392aab792dc252d5de4533cc9518d38aa8dbf1925ab92386edd4009923",
+        hashHex( abc, 64, 1 ) );
+}
+
+// The remaining digests are those of the BLAKE2 reference implementation, as checked by the ImageSource tests.
+TEST( Blake2bTest, HashesEmptyMessage )
+{
+    EXPECT_EQ(
+        "786a02f742015903c6c6fd852552d272912f4740e15847618a86e217f71f5419"
+        "d25e1031afee585313896444934eb04b903a685b1448b755d56f701afe9be2ce",
+        hashHex( std::vector<uint8_t>(), 64, 1 ) );
+}
+
+TEST( Blake2bTest, HashesExactlyOneBlock )
+{
+    std::vector<uint8_t> block( Blake2b::BLOCK_SIZE );
+    for( unsigned int i = 0; i < Blake2b::BLOCK_SIZE; ++i )
+        block[i] = ( uint8_t )i;
+    EXPECT_EQ( "a74787004ef589e31149183900d0294a", hashHex( block, 16, Blake2b::BLOCK_SIZE ) );
+
+    // the 16 byte digest is returned as little endian words.
+    Blake2b hasher;
+    hasher.update( block.data(), block.size() );
+    const Blake2b::Digest digest = hasher.finish();
+    EXPECT_EQ( 0xe389f54e008747a7ull, digest.lo );
+    EXPECT_EQ( 0x4a29d00039184911ull, digest.hi );
+}
+
+TEST( Blake2bTest, DigestDoesNotDependOnUpdateSizes )
+{
+    const std::vector<uint8_t> message = makeMessage( 1000 );
+    for( size_t chunkSize : { 1, 7, 128, 129, 1000 } )
+        EXPECT_EQ( "bca120dfd89cd95d82898473a5b01c90", hashHex( message, 16, chunkSize ) ) << chunkSize;
+}
@@ -56,6 +56,11 @@ cuOmmBaking::Result TestCommon::saveImageToFile( std::string imageNamePrefix, co
 }
 
 void TestCommon::compareImage()
+{
+    compareImage( m_imageNamePrefix );
+}
+
+void TestCommon::compareImage( const std::string& goldImageNamePrefix )
 {
 #ifdef GENERATE_GOLD_IMAGES
     EXPECT_TRUE( !"Generating gold image, no test result" );
@@ -67,7 +72,7 @@ void TestCommon::compareImage()
     float maxError;
 
     std::string imageName     = m_imageNamePrefix + ".ppm";
-    std::string goldImageName = TEST_OMM_BAKING_GOLD_DIR + m_imageNamePrefix + "_gold.ppm";
+    std::string goldImageName = TEST_OMM_BAKING_GOLD_DIR + goldImageNamePrefix + "_gold.ppm";
 
     try
     {
@@ -29,6 +29,9 @@ class TestCommon : public testing::Test
 
     void compareImage();
 
+    // Compare the last saved image with the gold image of another test.
+    void compareImage( const std::string& goldImageNamePrefix );
+
 private:
     std::string m_imageNamePrefix;
 };
@@ -0,0 +1,257 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "DuplicateTable.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Found by argument dependent lookup, so it is declared in the namespace of TriangleID.
+static bool operator==( TriangleID a, TriangleID b )
+{
+    return a.triangleIndex == b.triangleIndex && a.inputIndex == b.inputIndex && a.uniform == b.uniform && a.state == b.state;
+}
+
+namespace {  // anonymous
+
+// Triangles with a hash key and a value. Triangles with equal values are duplicates.
+struct TestTriangles
+{
+    std::vector<uint32_t> hashKeys;
+    std::vector<uint32_t> values;
+
+    bool isDuplicate( TriangleID prevId, TriangleID id ) const { return values[prevId.triangleIndex] == values[id.triangleIndex]; }
+
+    uint32_t size() const { return ( uint32_t )hashKeys.size(); }
+
+    // Triangle indices in [begin,end), stably sorted by hash key.
+    std::vector<uint32_t> sortedIndices( uint32_t begin, uint32_t end ) const
+    {
+        std::vector<uint32_t> indices( end - begin );
+        std::iota( indices.begin(), indices.end(), begin );
+        std::stable_sort( indices.begin(), indices.end(), [this]( uint32_t a, uint32_t b ) { return hashKeys[a] < hashKeys[b]; } );
+        return indices;
+    }
+};
+
+TriangleID makeId( uint32_t index )
+{
+    TriangleID id    = {};
+    id.triangleIndex = index;
+    return id;
+}
+
+// Omm index per triangle and first triangle per omm, from a single pass over the sorted triangles.
+void assignSinglePass( const TestTriangles& triangles, std::vector<uint32_t>& outAssignment, std::vector<uint32_t>& outFirstTriangles )
+{
+    outAssignment.assign( triangles.size(), 0 );
+    outFirstTriangles.clear();
+
+    const std::vector<uint32_t> sorted = triangles.sortedIndices( 0, triangles.size() );
+    for( uint32_t i = 0; i < sorted.size(); ++i )
+    {
+        const uint32_t index = sorted[i];
+        const bool     first = ( i == 0 ) || triangles.hashKeys[sorted[i - 1]] != triangles.hashKeys[index]
+                           || !triangles.isDuplicate( makeId( sorted[i - 1] ), makeId( index ) );
+        if( first )
+            outFirstTriangles.push_back( index );
+        outAssignment[index] = ( uint32_t )outFirstTriangles.size() - 1;
+    }
+}
+
+// Omm index per triangle and first triangle per omm, from batches of a duplicate table.
+void assignBatched( const TestTriangles& triangles, uint32_t batchSize, std::vector<uint32_t>& outAssignment, std::vector<uint32_t>& outFirstTriangles )
+{
+    DuplicateTable table;
+    auto isDuplicate = [&triangles]( TriangleID prevId, TriangleID id ) { return triangles.isDuplicate( prevId, id ); };
+
+    outAssignment.assign( triangles.size(), 0 );
+    for( uint32_t begin = 0; begin < triangles.size(); begin += batchSize )
+    {
+        for( uint32_t index : triangles.sortedIndices( begin, std::min( triangles.size(), begin + batchSize ) ) )
+            outAssignment[index] = table.add( triangles.hashKeys[index], makeId( index ), isDuplicate );
+    }
+
+    const std::vector<uint32_t> finalIndices = table.getFinalIndices();
+    ASSERT_EQ( table.getNumOmms(), finalIndices.size() );
+
+    for( uint32_t& assignment : outAssignment )
+        assignment = finalIndices[assignment];
+
+    outFirstTriangles.assign( table.getNumOmms(), ~0u );
+    for( uint32_t i = 0; i < table.getNumOmms(); ++i )
+        outFirstTriangles[finalIndices[i]] = table.getTriangleId( i ).triangleIndex;
+}
+
+TestTriangles makeRandomTriangles( uint32_t numTriangles, uint32_t numHashKeys, uint32_t numValues, uint32_t seed )
+{
+    std::mt19937                            rng( seed );
+    std::uniform_int_distribution<uint32_t> hashKey( 0, numHashKeys - 1 );
+    std::uniform_int_distribution<uint32_t> value( 0, numValues - 1 );
+
+    TestTriangles triangles;
+    for( uint32_t i = 0; i < numTriangles; ++i )
+    {
+        // collide most hash keys to exercise the duplicate checks
+        triangles.hashKeys.push_back( hashKey( rng ) * 0x9e3779b9u );
+        triangles.values.push_back( value( rng ) );
+    }
+    return triangles;
+}
+
+void expectSinglePassAssignment( const TestTriangles& triangles, uint32_t batchSize )
+{
+    std::vector<uint32_t> expectedAssignment, expectedFirstTriangles;
+    assignSinglePass( triangles, expectedAssignment, expectedFirstTriangles );
+
+    std::vector<uint32_t> assignment, firstTriangles;
+    assignBatched( triangles, batchSize, assignment, firstTriangles );
+
+    EXPECT_EQ( expectedAssignment, assignment );
+    EXPECT_EQ( expectedFirstTriangles, firstTriangles );
+}
+
+}  // namespace
+
+TEST( DuplicateTableTest, UniqueTriangles )
+{
+    DuplicateTable table;
+    auto isDuplicate = []( TriangleID, TriangleID ) { return true; };
+
+    EXPECT_EQ( 0u, table.add( 3, makeId( 0 ), isDuplicate ) );
+    EXPECT_EQ( 1u, table.add( 1, makeId( 1 ), isDuplicate ) );
+    EXPECT_EQ( 2u, table.add( 2, makeId( 2 ), isDuplicate ) );
+
+    // sorted by hash key
+    EXPECT_EQ( ( std::vector<uint32_t>{ 2, 0, 1 } ), table.getFinalIndices() );
+}
+
+TEST( DuplicateTableTest, Duplicates )
+{
+    DuplicateTable table;
+    auto isDuplicate = []( TriangleID, TriangleID ) { return true; };
+
+    EXPECT_EQ( 0u, table.add( 7, makeId( 0 ), isDuplicate ) );
+    EXPECT_EQ( 0u, table.add( 7, makeId( 1 ), isDuplicate ) );
+    EXPECT_EQ( 1u, table.getNumOmms() );
+
+    // the omm is represented by its first triangle
+    EXPECT_EQ( 0u, table.getTriangleId( 0 ).triangleIndex );
+}
+
+TEST( DuplicateTableTest, HashCollisions )
+{
+    TestTriangles triangles;
+    triangles.hashKeys = { 5, 5, 5, 5 };
+    triangles.values   = { 0, 1, 1, 0 };
+
+    DuplicateTable table;
+    auto isDuplicate = [&triangles]( TriangleID prevId, TriangleID id ) { return triangles.isDuplicate( prevId, id ); };
+
+    // only the preceding triangle with the same hash key is matched, as in the single pass
+    EXPECT_EQ( 0u, table.add( 5, makeId( 0 ), isDuplicate ) );
+    EXPECT_EQ( 1u, table.add( 5, makeId( 1 ), isDuplicate ) );
+    EXPECT_EQ( 1u, table.add( 5, makeId( 2 ), isDuplicate ) );
+    EXPECT_EQ( 2u, table.add( 5, makeId( 3 ), isDuplicate ) );
+
+    // order of addition within equal hash keys
+    EXPECT_EQ( ( std::vector<uint32_t>{ 0, 1, 2 } ), table.getFinalIndices() );
+}
+
+TEST( DuplicateTableTest, Empty )
+{
+    DuplicateTable table;
+
+    EXPECT_EQ( 0u, table.getNumOmms() );
+    EXPECT_TRUE( table.getFinalIndices().empty() );
+}
+
+TEST( DuplicateTableTest, MatchesSinglePass )
+{
+    const TestTriangles triangles = makeRandomTriangles( 2000, 64, 4, 1 );
+
+    for( uint32_t batchSize : { 1u, 3u, 64u, 1000u, 2000u } )
+    {
+        SCOPED_TRACE( batchSize );
+        expectSinglePassAssignment( triangles, batchSize );
+    }
+}
+
+TEST( DuplicateTableTest, PreviousTriangles )
+{
+    DuplicateTable table;
+    auto isDuplicate = []( TriangleID, TriangleID ) { return false; };
+
+    table.add( 5, makeId( 0 ), isDuplicate );
+    table.add( 5, makeId( 1 ), isDuplicate );
+
+    TriangleID uniform = makeId( 4 );
+    uniform.uniform    = 1;
+
+    const std::vector<uint32_t>   hashKeys    = { 3, 5, 5, 5, 9 };
+    const std::vector<TriangleID> triangleIds = { makeId( 2 ), makeId( 3 ), uniform, makeId( 5 ), makeId( 6 ) };
+
+    std::vector<TriangleID> previousIds( hashKeys.size() );
+    table.findPreviousTriangles( hashKeys.data(), triangleIds.data(), ( uint32_t )hashKeys.size(), previousIds.data() );
+
+    // new hash keys and uniform triangles have no previous triangle. the uniform triangle doesn't break the run
+    EXPECT_EQ( makeId( 2 ), previousIds[0] );
+    EXPECT_EQ( makeId( 1 ), previousIds[1] );
+    EXPECT_EQ( uniform, previousIds[2] );
+    EXPECT_EQ( makeId( 3 ), previousIds[3] );
+    EXPECT_EQ( makeId( 6 ), previousIds[4] );
+}
+
+TEST( DuplicateTableTest, MatchesSinglePassWithPreviousTriangles )
+{
+    const TestTriangles triangles = makeRandomTriangles( 2000, 64, 4, 3 );
+
+    std::vector<uint32_t> expectedAssignment, expectedFirstTriangles;
+    assignSinglePass( triangles, expectedAssignment, expectedFirstTriangles );
+
+    // the duplicate checks of each batch are evaluated before the batch is added
+    DuplicateTable        table;
+    std::vector<uint32_t> assignment( triangles.size() );
+    for( uint32_t begin = 0; begin < triangles.size(); begin += 128 )
+    {
+        const std::vector<uint32_t> sorted = triangles.sortedIndices( begin, std::min( triangles.size(), begin + 128 ) );
+
+        std::vector<uint32_t>   hashKeys;
+        std::vector<TriangleID> triangleIds;
+        for( uint32_t index : sorted )
+        {
+            hashKeys.push_back( triangles.hashKeys[index] );
+            triangleIds.push_back( makeId( index ) );
+        }
+
+        std::vector<TriangleID> previousIds( sorted.size() );
+        table.findPreviousTriangles( hashKeys.data(), triangleIds.data(), ( uint32_t )sorted.size(), previousIds.data() );
+
+        for( uint32_t i = 0; i < sorted.size(); ++i )
+        {
+            const bool duplicate = triangles.isDuplicate( previousIds[i], triangleIds[i] );
+            assignment[sorted[i]] = table.add( hashKeys[i], triangleIds[i], [&]( TriangleID prevId, TriangleID ) {
+                EXPECT_EQ( previousIds[i], prevId );
+                return duplicate;
+            } );
+        }
+    }
+
+    const std::vector<uint32_t> finalIndices = table.getFinalIndices();
+    for( uint32_t& index : assignment )
+        index = finalIndices[index];
+
+    EXPECT_EQ( expectedAssignment, assignment );
+}
+
+TEST( DuplicateTableTest, MatchesSinglePassUniqueHashKeys )
+{
+    const TestTriangles triangles = makeRandomTriangles( 2000, 1u << 20, 1u << 20, 2 );
+
+    expectSinglePassAssignment( triangles, 100 );
+}
@@ -0,0 +1,1054 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include "SourceDir.h"  // generated from SourceDir.h.in
+
+#include <OptiXToolkit/CuOmmBaking/CuBuffer.h>
+#include <OptiXToolkit/CuOmmBaking/CuOmmBaking.h>
+
+#include "Util/Image.h"
+#include "Util/Mesh.h"
+#include "Util/OptiXOmmArray.h"
+#include "Util/OptiXScene.h"
+
+#include "testCommon.h"
+
+#include <cuda_runtime.h>
+#include <gtest/gtest.h>
+
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <vector>
+
+namespace {  // anonymous
+
+// Host memory buffer. The 8 byte alignment satisfies all baking buffer alignment requirements.
+template <typename T>
+class HostBuffer
+{
+  public:
+    void alloc( size_t count )
+    {
+        m_count = count;
+        m_storage.assign( ( count * sizeof( T ) + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ), 0 );
+    }
+
+    T*          data() { return reinterpret_cast<T*>( m_storage.data() ); }
+    const T*    data() const { return reinterpret_cast<const T*>( m_storage.data() ); }
+    CUdeviceptr get() const { return reinterpret_cast<CUdeviceptr>( m_storage.data() ); }
+    size_t      count() const { return m_count; }
+    size_t      sizeInBytes() const { return m_count * sizeof( T ); }
+
+    const T& operator[]( size_t index ) const { return data()[index]; }
+
+  private:
+    std::vector<uint64_t> m_storage;
+    size_t                m_count = 0;
+};
+
+// Opacity state texture in host memory, converted from the alpha channel of an image like launchTextureToState.
+struct HostStateTexture
+{
+    HostBuffer<uint32_t> states;
+    uint32_t             width       = 0;
+    uint32_t             height      = 0;
+    uint32_t             pitchInBits = 0;
+    std::string          fileName;
+
+    void create( const std::string& imageFileName, uint32_t paddingInBits = 0, float transparencyCutoff = 0.f, float opacityCutoff = 1.f )
+    {
+        fileName = imageFileName;
+
+        ImageBuffer image = loadImage( fileName.c_str(), 4 );
+
+        width       = image.width();
+        height      = image.height();
+        pitchInBits = width * 2 + paddingInBits;
+
+        states.alloc( ( pitchInBits * height + 31 ) / 32 );
+        for( uint32_t y = 0; y < height; ++y )
+        {
+            for( uint32_t x = 0; x < width; ++x )
+            {
+                const float value = image.color( x, y ).w;
+
+                uint32_t state = ( uint32_t )cuOmmBaking::OpacityState::STATE_UNKNOWN;
+                if( value <= transparencyCutoff )
+                    state = ( uint32_t )cuOmmBaking::OpacityState::STATE_TRANSPARENT;
+                else if( value >= opacityCutoff )
+                    state = ( uint32_t )cuOmmBaking::OpacityState::STATE_OPAQUE;
+
+                const uint32_t bit = 2 * x + pitchInBits * y;
+                states.data()[bit / 32] |= state << ( bit & 31 );
+            }
+        }
+    }
+
+    cuOmmBaking::TextureDesc getTextureDesc( cudaTextureAddressMode addressModeU, cudaTextureAddressMode addressModeV, float filterKernelWidthInTexels = 1.f ) const
+    {
+        cuOmmBaking::TextureDesc desc = {};
+        desc.type                            = cuOmmBaking::TextureType::STATE;
+        desc.state.width                     = width;
+        desc.state.height                    = height;
+        desc.state.pitchInBits               = pitchInBits;
+        desc.state.addressMode[0]            = addressModeU;
+        desc.state.addressMode[1]            = addressModeV;
+        desc.state.stateBuffer               = states.get();
+        desc.state.filterKernelWidthInTexels = filterKernelWidthInTexels;
+        return desc;
+    }
+};
+
+// Baking outputs, downloaded to host memory.
+struct BakeResult
+{
+    cuOmmBaking::BakeBuffers  buffers      = {};
+    cuOmmBaking::PostBakeInfo postBakeInfo = {};
+
+    std::vector<uint8_t>                            data;
+    std::vector<OptixOpacityMicromapDesc>           descs;
+    std::vector<OptixOpacityMicromapHistogramEntry> histogram;
+
+    std::vector<std::vector<uint8_t>>                        indices;
+    std::vector<std::vector<OptixOpacityMicromapUsageCount>> usageCounts;
+};
+
+template <typename T>
+std::vector<T> toVector( const HostBuffer<T>& buffer )
+{
+    return std::vector<T>( buffer.data(), buffer.data() + buffer.count() );
+}
+
+class HostBakingTest : public TestCommon
+{
+  protected:
+    std::vector<Mesh>                                  meshes;
+    std::vector<float4>                                meshUvRanges;
+    std::vector<std::vector<unsigned>>                 meshTextureIds;
+    std::vector<HostStateTexture>                      textures;
+    std::vector<std::vector<cuOmmBaking::TextureDesc>> inputTextures;
+    std::vector<cuOmmBaking::BakeInputDesc>            inputs;
+
+    cuOmmBaking::BakeOptions options = {};
+
+    BakeResult result;
+
+    void SetUp() override
+    {
+        TestCommon::SetUp();
+        options.flags = cuOmmBaking::BakeFlags::ENABLE_POST_BAKE_INFO;
+    }
+
+    void addTexture( const std::string& fileName, uint32_t paddingInBits = 0 )
+    {
+        textures.emplace_back();
+        textures.back().create( getSourceDir() + "/Textures/" + fileName, paddingInBits );
+    }
+
+    void addMesh( float2 uvMin, float2 uvMax, uint2 gridRes, std::vector<unsigned> textureIds = { 0 },
+                  cudaTextureAddressMode addressModeU = cudaAddressModeWrap, cudaTextureAddressMode addressModeV = cudaAddressModeWrap,
+                  cuOmmBaking::IndexFormat indexFormat = cuOmmBaking::IndexFormat::I32_UINT,
+                  cuOmmBaking::IndexFormat textureIndexFormat = cuOmmBaking::IndexFormat::I32_UINT )
+    {
+        Mesh::Format format;
+        format.indexFormat        = indexFormat;
+        format.textureIndexFormat = textureIndexFormat;
+
+        meshes.emplace_back();
+        ASSERT_EQ( cudaSuccess, meshes.back().create( { 0, 0, 0 }, { 1, 1, 0 }, uvMin, uvMax, gridRes, ( unsigned )textureIds.size(), format ) );
+        meshUvRanges.push_back( { uvMin.x, uvMin.y, uvMax.x, uvMax.y } );
+        meshTextureIds.push_back( textureIds );
+
+        inputTextures.emplace_back();
+        for( unsigned id : textureIds )
+            inputTextures.back().push_back( textures[id].getTextureDesc( addressModeU, addressModeV ) );
+    }
+
+    void clearMeshes()
+    {
+        meshes.clear();
+        meshUvRanges.clear();
+        meshTextureIds.clear();
+        inputTextures.clear();
+    }
+
+    void setupInputs()
+    {
+        inputs.clear();
+        for( size_t i = 0; i < meshes.size(); ++i )
+        {
+            cuOmmBaking::BakeInputDesc desc = meshes[i].getHostBakingInputDesc();
+            desc.numTextures                = ( unsigned )inputTextures[i].size();
+            desc.textures                   = inputTextures[i].data();
+            inputs.push_back( desc );
+        }
+    }
+
+    cuOmmBaking::Result bakeOnHost( BakeResult& out )
+    {
+        setupInputs();
+
+        cuOmmBaking::BakeOptions hostOptions = options;
+        hostOptions.flags                    = hostOptions.flags | cuOmmBaking::BakeFlags::BAKE_ON_HOST;
+
+        std::vector<cuOmmBaking::BakeInputBuffers> inputBuffers( inputs.size() );
+        cuOmmBaking::BakeBuffers                   buffers = {};
+        cuOmmBaking::Result res = cuOmmBaking::GetPreBakeInfo( &hostOptions, ( unsigned )inputs.size(), inputs.data(), inputBuffers.data(), &buffers );
+        if( res != cuOmmBaking::Result::SUCCESS )
+            return res;
+
+        HostBuffer<uint8_t>                            data, temp;
+        HostBuffer<OptixOpacityMicromapDesc>           descs;
+        HostBuffer<OptixOpacityMicromapHistogramEntry> histogram;
+        HostBuffer<cuOmmBaking::PostBakeInfo>          postBakeInfo;
+        std::vector<HostBuffer<uint8_t>>                        indices( inputs.size() );
+        std::vector<HostBuffer<OptixOpacityMicromapUsageCount>> usageCounts( inputs.size() );
+
+        data.alloc( buffers.outputBufferSizeInBytes );
+        descs.alloc( buffers.numMicromapDescs );
+        histogram.alloc( buffers.numMicromapHistogramEntries );
+        postBakeInfo.alloc( 1 );
+        temp.alloc( buffers.tempBufferSizeInBytes );
+
+        buffers.outputBuffer                   = data.get();
+        buffers.perMicromapDescBuffer          = descs.get();
+        buffers.micromapHistogramEntriesBuffer = histogram.get();
+        buffers.postBakeInfoBuffer             = postBakeInfo.get();
+        buffers.tempBuffer                     = temp.get();
+
+        for( size_t i = 0; i < inputs.size(); ++i )
+        {
+            indices[i].alloc( inputBuffers[i].indexBufferSizeInBytes );
+            usageCounts[i].alloc( inputBuffers[i].numMicromapUsageCounts );
+            inputBuffers[i].indexBuffer               = indices[i].get();
+            inputBuffers[i].micromapUsageCountsBuffer = usageCounts[i].get();
+        }
+
+        res = cuOmmBaking::BakeOpacityMicromaps( &hostOptions, ( unsigned )inputs.size(), inputs.data(), inputBuffers.data(), &buffers );
+        if( res != cuOmmBaking::Result::SUCCESS )
+            return res;
+
+        out.buffers      = buffers;
+        out.postBakeInfo = postBakeInfo[0];
+        out.data         = toVector( data );
+        out.descs        = toVector( descs );
+        out.histogram    = toVector( histogram );
+        out.indices.clear();
+        out.usageCounts.clear();
+        for( size_t i = 0; i < inputs.size(); ++i )
+        {
+            out.indices.push_back( toVector( indices[i] ) );
+            out.usageCounts.push_back( toVector( usageCounts[i] ) );
+        }
+
+        return cuOmmBaking::Result::SUCCESS;
+    }
+
+    // Bake the same inputs on the device. The meshes are in device memory, the state textures are copied to device memory.
+    // A state texture shared by several meshes is copied once, so the device can match duplicates across the meshes.
+    cuOmmBaking::Result bakeOnDevice( BakeResult& out, bool useCache = false, bool useBatches = false )
+    {
+        std::vector<CuBuffer<char>>                        deviceBuffers;
+        std::map<CUdeviceptr, CUdeviceptr>                 deviceStateBuffers;
+        std::vector<std::vector<cuOmmBaking::TextureDesc>> deviceTextures = inputTextures;
+        std::vector<cuOmmBaking::BakeInputDesc>            deviceInputs;
+
+        auto upload = [&]( CUdeviceptr ptr, size_t sizeInBytes ) -> CUdeviceptr {
+            if( !ptr )
+                return 0;
+            deviceBuffers.emplace_back();
+            EXPECT_EQ( cudaSuccess, deviceBuffers.back().allocAndUpload( sizeInBytes, reinterpret_cast<const char*>( ptr ) ) );
+            return deviceBuffers.back().get();
+        };
+
+        deviceBuffers.reserve( textures.size() * meshes.size() );
+        for( size_t i = 0; i < meshes.size(); ++i )
+        {
+            cuOmmBaking::BakeInputDesc desc = meshes[i].getBakingInputDesc();
+
+            for( auto& texture : deviceTextures[i] )
+            {
+                CUdeviceptr& stateBuffer = deviceStateBuffers[texture.state.stateBuffer];
+                if( !stateBuffer )
+                    stateBuffer = upload( texture.state.stateBuffer, ( texture.state.pitchInBits * texture.state.height + 31 ) / 32 * sizeof( uint32_t ) );
+                texture.state.stateBuffer = stateBuffer;
+            }
+
+            desc.numTextures = ( unsigned )deviceTextures[i].size();
+            desc.textures    = deviceTextures[i].data();
+            deviceInputs.push_back( desc );
+        }
+
+        // the device bake is a reference without the cache and batches, unless requested
+        cuOmmBaking::BakeOptions deviceOptions = options;
+        deviceOptions.cache                    = useCache ? options.cache : nullptr;
+        deviceOptions.maximumTempSizeInBytes   = useBatches ? options.maximumTempSizeInBytes : 0;
+
+        std::vector<cuOmmBaking::BakeInputBuffers> inputBuffers( deviceInputs.size() );
+        cuOmmBaking::BakeBuffers                   buffers = {};
+        cuOmmBaking::Result res = cuOmmBaking::GetPreBakeInfo( &deviceOptions, ( unsigned )deviceInputs.size(), deviceInputs.data(), inputBuffers.data(), &buffers );
+        if( res != cuOmmBaking::Result::SUCCESS )
+            return res;
+
+        CuBuffer<uint8_t>                            data( buffers.outputBufferSizeInBytes ), temp( buffers.tempBufferSizeInBytes );
+        CuBuffer<OptixOpacityMicromapDesc>           descs( buffers.numMicromapDescs );
+        CuBuffer<OptixOpacityMicromapHistogramEntry> histogram( buffers.numMicromapHistogramEntries );
+        CuBuffer<cuOmmBaking::PostBakeInfo>          postBakeInfo( 1 );
+        std::vector<CuBuffer<uint8_t>>                        indices( deviceInputs.size() );
+        std::vector<CuBuffer<OptixOpacityMicromapUsageCount>> usageCounts( deviceInputs.size() );
+
+        buffers.outputBuffer                   = data.get();
+        buffers.perMicromapDescBuffer          = descs.get();
+        buffers.micromapHistogramEntriesBuffer = histogram.get();
+        buffers.postBakeInfoBuffer             = postBakeInfo.get();
+        buffers.tempBuffer                     = temp.get();
+
+        for( size_t i = 0; i < deviceInputs.size(); ++i )
+        {
+            EXPECT_EQ( cudaSuccess, indices[i].alloc( inputBuffers[i].indexBufferSizeInBytes ) );
+            EXPECT_EQ( cudaSuccess, usageCounts[i].alloc( inputBuffers[i].numMicromapUsageCounts ) );
+            inputBuffers[i].indexBuffer               = indices[i].get();
+            inputBuffers[i].micromapUsageCountsBuffer = usageCounts[i].get();
+        }
+
+        res = cuOmmBaking::BakeOpacityMicromaps( &deviceOptions, ( unsigned )deviceInputs.size(), deviceInputs.data(), inputBuffers.data(), &buffers );
+        if( res != cuOmmBaking::Result::SUCCESS )
+            return res;
+
+        std::vector<cuOmmBaking::PostBakeInfo> info;
+        EXPECT_EQ( cudaSuccess, data.download( out.data ) );
+        EXPECT_EQ( cudaSuccess, descs.download( out.descs ) );
+        EXPECT_EQ( cudaSuccess, histogram.download( out.histogram ) );
+        EXPECT_EQ( cudaSuccess, postBakeInfo.download( info ) );
+        out.buffers      = buffers;
+        out.postBakeInfo = info[0];
+
+        out.indices.resize( deviceInputs.size() );
+        out.usageCounts.resize( deviceInputs.size() );
+        for( size_t i = 0; i < deviceInputs.size(); ++i )
+        {
+            EXPECT_EQ( cudaSuccess, indices[i].download( out.indices[i] ) );
+            EXPECT_EQ( cudaSuccess, usageCounts[i].download( out.usageCounts[i] ) );
+        }
+
+        return cuOmmBaking::Result::SUCCESS;
+    }
+
+    uint32_t loadIndex( const BakeResult& res, size_t input, size_t triangle ) const
+    {
+        if( res.buffers.indexFormat == cuOmmBaking::IndexFormat::I16_UINT )
+        {
+            uint16_t index;
+            memcpy( &index, res.indices[input].data() + triangle * sizeof( uint16_t ), sizeof( index ) );
+            // sign extend predefined indices
+            return ( index >= ( uint16_t )( -4 ) ) ? ( uint32_t )( int32_t )( int16_t )index : index;
+        }
+        uint32_t index;
+        memcpy( &index, res.indices[input].data() + triangle * sizeof( uint32_t ), sizeof( index ) );
+        return index;
+    }
+
+    static uint32_t getNumTriangles( const cuOmmBaking::BakeInputDesc& desc )
+    {
+        return desc.indexFormat != cuOmmBaking::IndexFormat::NONE ? desc.numIndexTriplets : desc.numTexCoords / 3;
+    }
+
+    // Check the consistency of the host bake outputs, and compare with a device bake.
+    void validate()
+    {
+        const uint32_t numOmms          = result.postBakeInfo.numMicromapDescs;
+        const uint32_t logStatesPerByte = ( options.format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE ) ? 3 : 2;
+
+        ASSERT_LE( numOmms, result.descs.size() );
+        ASSERT_LE( result.postBakeInfo.compactedSizeInBytes, result.data.size() );
+
+        // the omms are tightly packed
+        uint32_t byteOffset = 0;
+        std::vector<uint32_t> histogram( result.histogram.size() );
+        for( uint32_t i = 0; i < numOmms; ++i )
+        {
+            const OptixOpacityMicromapDesc& desc = result.descs[i];
+            EXPECT_EQ( byteOffset, desc.byteOffset );
+            EXPECT_EQ( options.format, desc.format );
+            EXPECT_GE( desc.subdivisionLevel, 1u );
+            ASSERT_LT( desc.subdivisionLevel, histogram.size() );
+
+            const uint32_t sizeInBytes = 1u << ( std::max<uint32_t>( 2 * desc.subdivisionLevel, logStatesPerByte ) - logStatesPerByte );
+            byteOffset += sizeInBytes;
+            histogram[desc.subdivisionLevel]++;
+        }
+        EXPECT_EQ( byteOffset, result.postBakeInfo.compactedSizeInBytes );
+
+        for( size_t i = 0; i < histogram.size(); ++i )
+            EXPECT_EQ( histogram[i], result.histogram[i].count );
+
+        // all indices reference an omm or are predefined, and the usage counts match
+        for( size_t i = 0; i < inputs.size(); ++i )
+        {
+            std::vector<uint32_t> usage( result.usageCounts[i].size() );
+            for( uint32_t j = 0; j < getNumTriangles( inputs[i] ); ++j )
+            {
+                const uint32_t index = loadIndex( result, i, j );
+                if( index >= ( uint32_t )( -4 ) )
+                    continue;
+                ASSERT_LT( index, numOmms );
+                usage[result.descs[index].subdivisionLevel]++;
+            }
+            for( size_t j = 0; j < usage.size(); ++j )
+                EXPECT_EQ( usage[j], result.usageCounts[i][j].count );
+        }
+
+        // the device is compiled with fast math, so borderline triangles may bake differently, but the bakes agree closely
+        BakeResult device;
+        ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnDevice( device ) );
+
+        ASSERT_EQ( result.buffers.indexFormat, device.buffers.indexFormat );
+        EXPECT_NEAR( ( double )numOmms, ( double )device.postBakeInfo.numMicromapDescs, numOmms / 100.0 );
+
+        // triangles are assigned the same predefined states
+        uint32_t numTriangles = 0, numMismatches = 0;
+        for( size_t i = 0; i < inputs.size(); ++i )
+        {
+            for( uint32_t j = 0; j < getNumTriangles( inputs[i] ); ++j, ++numTriangles )
+            {
+                const uint32_t hostIndex   = loadIndex( result, i, j );
+                const uint32_t deviceIndex = loadIndex( device, i, j );
+                if( ( hostIndex >= ( uint32_t )( -4 ) || deviceIndex >= ( uint32_t )( -4 ) ) && hostIndex != deviceIndex )
+                    numMismatches++;
+            }
+        }
+        EXPECT_LE( numMismatches, numTriangles / 100 );
+    }
+
+    void runTest()
+    {
+        ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( result ) );
+        validate();
+    }
+
+    // Render the host baked omms like OmmBakingTest, and compare the image with the gold image of the equivalent device
+    // baked test. The renderer validates that the omms are conservative.
+    void renderAndCompare( const std::string& imageNamePrefix, const std::string& goldImageNamePrefix )
+    {
+        setupInputs();
+
+        cuOmmBaking::BakeOptions hostOptions = options;
+        hostOptions.flags                    = hostOptions.flags | cuOmmBaking::BakeFlags::BAKE_ON_HOST;
+
+        OptixOmmArray ommArray;
+        ASSERT_EQ( cuOmmBaking::Result::SUCCESS, ommArray.create( optixContext, hostOptions, inputs.data(), ( uint32_t )inputs.size() ) );
+
+        // the renderer can't render state textures, so it samples cuda textures of the images the states were converted from
+        std::vector<CuTexture>                             cudaTextures( textures.size() * meshes.size() );
+        std::vector<std::vector<cuOmmBaking::TextureDesc>> renderTextures( meshes.size() );
+        std::vector<cuOmmBaking::BakeInputDesc>            renderInputs;
+        for( size_t i = 0; i < meshes.size(); ++i )
+        {
+            for( size_t j = 0; j < meshTextureIds[i].size(); ++j )
+            {
+                const cuOmmBaking::StateTextureDesc& state = inputTextures[i][j].state;
+
+                cudaTextureDesc texDesc  = {};
+                texDesc.readMode         = cudaReadModeNormalizedFloat;
+                texDesc.filterMode       = cudaFilterModePoint;
+                texDesc.normalizedCoords = 1;
+                texDesc.addressMode[0]   = state.addressMode[0];
+                texDesc.addressMode[1]   = state.addressMode[1];
+                const cudaChannelFormatDesc channelDesc = cudaCreateChannelDesc<uchar4>();
+
+                CuTexture& texture = cudaTextures[i * textures.size() + meshTextureIds[i][j]];
+                ASSERT_EQ( cudaSuccess, texture.createFromFile( textures[meshTextureIds[i][j]].fileName.c_str(), 0, &texDesc, &channelDesc ) );
+
+                cuOmmBaking::TextureDesc desc = {};
+                desc.type                     = cuOmmBaking::TextureType::CUDA;
+                desc.cuda.texObject           = texture.getTexture();
+                desc.cuda.transparencyCutoff  = 0.f;
+                desc.cuda.opacityCutoff       = 1.f;
+                renderTextures[i].push_back( desc );
+            }
+
+            cuOmmBaking::BakeInputDesc desc = meshes[i].getBakingInputDesc();
+            desc.numTextures                = ( unsigned )renderTextures[i].size();
+            desc.textures                   = renderTextures[i].data();
+            renderInputs.push_back( desc );
+        }
+
+        OptixOmmScene scene;
+        ASSERT_EQ( OPTIX_SUCCESS, scene.build( optixContext, 0, 0, ommArray, renderInputs.data(), ( uint32_t )renderInputs.size() ) );
+
+        RenderOptions renderOptions    = {};
+        renderOptions.opacity_shading  = true;
+        renderOptions.validate_opacity = true;
+        renderOptions.windowMin        = { FLT_MAX, FLT_MAX };
+        renderOptions.windowMax        = { FLT_MIN, FLT_MIN };
+        renderOptions.force2state      = ( options.format == OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE );
+        for( const float4& range : meshUvRanges )
+        {
+            renderOptions.windowMin.x = std::min( range.x, renderOptions.windowMin.x );
+            renderOptions.windowMin.y = std::min( range.y, renderOptions.windowMin.y );
+            renderOptions.windowMax.x = std::max( range.z, renderOptions.windowMax.x );
+            renderOptions.windowMax.y = std::max( range.w, renderOptions.windowMax.y );
+        }
+
+        const int width  = 1024;
+        const int height = 1024;
+        EXPECT_EQ( OPTIX_SUCCESS, scene.render( width, height, renderOptions ) );
+        EXPECT_EQ( scene.getErrorCount(), 0u );
+
+        ASSERT_EQ( cuOmmBaking::Result::SUCCESS, saveImageToFile( imageNamePrefix, scene.getImage(), width, height ) );
+        scene.destroy();
+
+        compareImage( goldImageNamePrefix );
+    }
+};
+
+}  // namespace
+
+TEST_F( HostBakingTest, Base )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 1, 1 } );
+
+    runTest();
+
+    EXPECT_GE( result.postBakeInfo.numMicromapDescs, 1u );
+
+    if( HasFatalFailure() )
+        return;
+    renderAndCompare( "HostBakingTest_Base", "OmmBakingStateTexture_Base" );
+}
+
+TEST_F( HostBakingTest, Pitch )
+{
+    addTexture( "DuckHole/DuckHole.png", 68 );
+    addMesh( { 0, 0 }, { 1, 1 }, { 1, 1 } );
+
+    runTest();
+
+    EXPECT_GE( result.postBakeInfo.numMicromapDescs, 1u );
+
+    if( HasFatalFailure() )
+        return;
+    renderAndCompare( "HostBakingTest_Pitch", "OmmBakingStateTexture_Pitch" );
+}
+
+TEST_F( HostBakingTest, UwrapVwrap )
+{
+    // all tiles of the wrapped texture are identical, so the omms of the 3x3 tiles are shared
+    addTexture( "base/base.png" );
+    addMesh( { -1, -1 }, { 2, 2 }, { 3, 3 }, { 0 }, cudaAddressModeWrap, cudaAddressModeWrap );
+
+    runTest();
+
+    EXPECT_LE( result.postBakeInfo.numMicromapDescs, 2u );
+}
+
+TEST_F( HostBakingTest, UmirrorVmirror )
+{
+    addTexture( "base/base.png" );
+    addMesh( { -2, -2 }, { 2, 2 }, { 4, 4 }, { 0 }, cudaAddressModeMirror, cudaAddressModeMirror );
+
+    runTest();
+
+    EXPECT_LE( result.postBakeInfo.numMicromapDescs, 8u );
+}
+
+TEST_F( HostBakingTest, UclampVclamp )
+{
+    addTexture( "base/base.png" );
+    addMesh( { -1, -1 }, { 2, 2 }, { 3, 3 }, { 0 }, cudaAddressModeClamp, cudaAddressModeClamp );
+
+    runTest();
+
+    if( HasFatalFailure() )
+        return;
+    renderAndCompare( "HostBakingTest_UclampVclamp", "OmmBakingStateTexture_UclamVclamp" );
+}
+
+TEST_F( HostBakingTest, Format )
+{
+    options.format = OPTIX_OPACITY_MICROMAP_FORMAT_2_STATE;
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 5, 5 } );
+
+    runTest();
+}
+
+TEST_F( HostBakingTest, MaximumSize )
+{
+    options.maximumSizeInBytes = 64;
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 5, 5 } );
+
+    runTest();
+
+    EXPECT_LE( result.postBakeInfo.compactedSizeInBytes, options.maximumSizeInBytes );
+}
+
+TEST_F( HostBakingTest, SubdivisionScale )
+{
+    options.subdivisionScale = 10.f;
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 1, 1 } );
+
+    runTest();
+}
+
+TEST_F( HostBakingTest, MultiInput )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 1, 1 } );
+    addMesh( { 1, 1 }, { 2, 2 }, { 1, 1 } );
+
+    runTest();
+
+    EXPECT_LE( result.postBakeInfo.numMicromapDescs, 2u );
+}
+
+TEST_F( HostBakingTest, IndicesFormatNone )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 5, 5 }, { 0 }, cudaAddressModeWrap, cudaAddressModeWrap, cuOmmBaking::IndexFormat::NONE );
+
+    runTest();
+}
+
+TEST_F( HostBakingTest, IndicesFormatShort3 )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 5, 5 }, { 0 }, cudaAddressModeWrap, cudaAddressModeWrap, cuOmmBaking::IndexFormat::I16_UINT );
+
+    runTest();
+}
+
+TEST_F( HostBakingTest, TextureIndices )
+{
+    addTexture( "base/base.png" );
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 2, 2 }, { 4, 4 }, { 0, 1 }, cudaAddressModeWrap, cudaAddressModeWrap, cuOmmBaking::IndexFormat::I32_UINT, cuOmmBaking::IndexFormat::I8_UINT );
+    addMesh( { 2, 2 }, { 4, 4 }, { 10, 10 }, { 1, 0 }, cudaAddressModeWrap, cudaAddressModeWrap, cuOmmBaking::IndexFormat::I32_UINT, cuOmmBaking::IndexFormat::I16_UINT );
+
+    runTest();
+}
+
+TEST_F( HostBakingTest, ManyTriangles )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 256, 256 } );
+
+    runTest();
+
+    EXPECT_GE( result.postBakeInfo.numMicromapDescs, 1u );
+}
+
+TEST_F( HostBakingTest, CudaTextureNotSupported )
+{
+    addTexture( "base/base.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 1, 1 } );
+
+    // the texture object is never accessed
+    inputTextures[0][0]                  = {};
+    inputTextures[0][0].type             = cuOmmBaking::TextureType::CUDA;
+    inputTextures[0][0].cuda.texObject   = 1;
+    inputTextures[0][0].cuda.opacityCutoff = 1.f;
+
+    EXPECT_EQ( cuOmmBaking::Result::ERROR_INVALID_VALUE, bakeOnHost( result ) );
+}
+
+TEST_F( HostBakingTest, Cache )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addTexture( "base/base.png" );
+    addMesh( { 0, 0 }, { 2, 2 }, { 8, 8 }, { 0, 1 } );
+
+    BakeResult uncached;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( uncached ) );
+    const uint32_t numOmms = uncached.postBakeInfo.numMicromapDescs;
+
+    const std::string             path = "testHostBakingCache.omm";
+    cuOmmBaking::BakeCacheOptions cacheOptions;
+    cacheOptions.path        = path.c_str();
+    cacheOptions.sizeInBytes = 1 << 20;
+    std::remove( path.c_str() );
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::CreateBakeCache( &cacheOptions, &options.cache ) );
+
+    // the first bake evaluates all omms and fills the cache
+    runTest();
+    cuOmmBaking::BakeCacheStatistics statistics = {};
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::GetBakeCacheStatistics( options.cache, &statistics ) );
+    EXPECT_EQ( 0u, statistics.numHits );
+    EXPECT_EQ( numOmms, statistics.numInserts );
+
+    // the second bake, from a reopened cache, copies all omms
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::DestroyBakeCache( options.cache ) );
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::CreateBakeCache( &cacheOptions, &options.cache ) );
+    runTest();
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::GetBakeCacheStatistics( options.cache, &statistics ) );
+    EXPECT_EQ( numOmms, statistics.numHits );
+    EXPECT_EQ( 0u, statistics.numMisses );
+
+    EXPECT_EQ( uncached.data, result.data );
+    EXPECT_EQ( uncached.indices, result.indices );
+
+    // a texture with different contents misses the cache
+    textures[1].states.data()[0] ^= 1;
+    runTest();
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::GetBakeCacheStatistics( options.cache, &statistics ) );
+    EXPECT_GT( statistics.numMisses, 0u );
+
+    EXPECT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::DestroyBakeCache( options.cache ) );
+    std::remove( path.c_str() );
+}
+
+TEST_F( HostBakingTest, CacheCanonicalTriangles )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 8, 8 } );
+
+    const std::string             path = "testHostBakingCanonicalCache.omm";
+    cuOmmBaking::BakeCacheOptions cacheOptions;
+    cacheOptions.path        = path.c_str();
+    cacheOptions.sizeInBytes = 1 << 20;
+    std::remove( path.c_str() );
+    cuOmmBaking::BakeCache* cache = nullptr;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::CreateBakeCache( &cacheOptions, &cache ) );
+
+    options.cache = cache;
+    BakeResult original;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( original ) );
+    const uint32_t numOmms = original.postBakeInfo.numMicromapDescs;
+
+    // a copy translated by whole texture periods copies the omms of the original. its uncached bake may differ in a few
+    // micro triangles, as the evaluation of the translated texture coordinates rounds differently.
+    clearMeshes();
+    addMesh( { 1, -2 }, { 2, -1 }, { 8, 8 } );
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( result ) );
+    EXPECT_EQ( original.data, result.data );
+    EXPECT_EQ( original.indices, result.indices );
+
+    cuOmmBaking::BakeCacheStatistics statistics = {};
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::GetBakeCacheStatistics( cache, &statistics ) );
+    EXPECT_EQ( numOmms, statistics.numHits );
+
+    // copies with the vertices of all triangles rotated copy the rotated omms of the original
+    clearMeshes();
+    addMesh( { 0, 0 }, { 1, 1 }, { 8, 8 } );
+
+    // the grid of Mesh::create, with explicit triangles
+    std::vector<float2> texCoords;
+    std::vector<float3> vertices;
+    std::vector<uint3>  triangles;
+    for( uint32_t y = 0; y <= 8; y++ )
+        for( uint32_t x = 0; x <= 8; x++ )
+        {
+            texCoords.push_back( { x / 8.f, y / 8.f } );
+            vertices.push_back( { x / 8.f, y / 8.f, 0.f } );
+        }
+    for( uint32_t y = 0; y < 8; y++ )
+        for( uint32_t x = 0; x < 8; x++ )
+        {
+            triangles.push_back( { y * 9 + x, ( y + 1 ) * 9 + x, ( y + 1 ) * 9 + ( x + 1 ) } );
+            triangles.push_back( { y * 9 + x, ( y + 1 ) * 9 + ( x + 1 ), y * 9 + ( x + 1 ) } );
+        }
+
+    for( int rotation = 1; rotation < 3; ++rotation )
+    {
+        for( uint3& triangle : triangles )
+            triangle = { triangle.y, triangle.z, triangle.x };
+        ASSERT_EQ( cudaSuccess, meshes[0].create( texCoords, vertices, triangles, {} ) );
+
+        BakeResult expected;
+        options.cache = nullptr;
+        ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( expected ) );
+
+        options.cache = cache;
+        ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( result ) );
+        EXPECT_EQ( expected.data, result.data ) << rotation;
+        EXPECT_EQ( expected.indices, result.indices ) << rotation;
+
+        ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::GetBakeCacheStatistics( cache, &statistics ) );
+        EXPECT_EQ( ( rotation + 1 ) * numOmms, statistics.numHits ) << rotation;
+        EXPECT_EQ( numOmms, statistics.numInserts ) << rotation;
+    }
+
+    EXPECT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::DestroyBakeCache( cache ) );
+    std::remove( path.c_str() );
+}
+
+TEST_F( HostBakingTest, CacheOnDevice )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addTexture( "base/base.png" );
+    addMesh( { 0, 0 }, { 2, 2 }, { 8, 8 }, { 0, 1 } );
+
+    const std::string             path = "testHostBakingDeviceCache.omm";
+    cuOmmBaking::BakeCacheOptions cacheOptions;
+    cacheOptions.path        = path.c_str();
+    cacheOptions.sizeInBytes = 1 << 20;
+    std::remove( path.c_str() );
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::CreateBakeCache( &cacheOptions, &options.cache ) );
+
+    // the first device bake fills the cache, the second copies all omms from it
+    BakeResult evaluated, cached;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnDevice( evaluated, true ) );
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnDevice( cached, true ) );
+    const uint32_t numOmms = evaluated.postBakeInfo.numMicromapDescs;
+
+    cuOmmBaking::BakeCacheStatistics statistics = {};
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::GetBakeCacheStatistics( options.cache, &statistics ) );
+    EXPECT_EQ( numOmms, statistics.numInserts );
+    EXPECT_EQ( numOmms, statistics.numHits );
+    EXPECT_EQ( evaluated.data, cached.data );
+
+    EXPECT_EQ( cuOmmBaking::Result::SUCCESS, cuOmmBaking::DestroyBakeCache( options.cache ) );
+    std::remove( path.c_str() );
+}
+
+TEST_F( HostBakingTest, CacheCudaTextureNotSupported )
+{
+    addTexture( "base/base.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 1, 1 } );
+
+    // the texture object is never accessed
+    inputTextures[0][0]                    = {};
+    inputTextures[0][0].type               = cuOmmBaking::TextureType::CUDA;
+    inputTextures[0][0].cuda.texObject     = 1;
+    inputTextures[0][0].cuda.opacityCutoff = 1.f;
+    setupInputs();
+
+    // the cache is validated before it is used
+    options.cache = reinterpret_cast<cuOmmBaking::BakeCache*>( 1 );
+
+    std::vector<cuOmmBaking::BakeInputBuffers> inputBuffers( inputs.size() );
+    cuOmmBaking::BakeBuffers                   buffers = {};
+    EXPECT_EQ( cuOmmBaking::Result::ERROR_INVALID_VALUE, cuOmmBaking::GetPreBakeInfo( &options, ( unsigned )inputs.size(), inputs.data(), inputBuffers.data(), &buffers ) );
+}
+
+TEST_F( HostBakingTest, Batched )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addTexture( "base/base.png" );
+    addMesh( { 0, 0 }, { 2, 2 }, { 8, 8 }, { 0, 1 } );
+    addMesh( { -1, -1 }, { 2, 2 }, { 6, 6 }, { 1 }, cudaAddressModeMirror, cudaAddressModeMirror, cuOmmBaking::IndexFormat::I16_UINT );
+    const uint32_t numTriangles = 2 * 8 * 8 + 2 * 6 * 6;
+
+    BakeResult expected;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( expected ) );
+
+    // a batch of all triangles. each triangle less reduces the temp size by the same amount
+    options.maximumTempSizeInBytes = ~( size_t )0;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( result ) );
+    const size_t maxTempSizeInBytes = result.buffers.tempBufferSizeInBytes;
+    const size_t bytesPerTriangle   = 24;
+    const size_t minTempSizeInBytes = maxTempSizeInBytes - ( numTriangles - 1 ) * bytesPerTriangle;
+
+    for( size_t tempSizeInBytes : { minTempSizeInBytes, minTempSizeInBytes + 6 * bytesPerTriangle + 5, minTempSizeInBytes + 99 * bytesPerTriangle, maxTempSizeInBytes } )
+    {
+        SCOPED_TRACE( tempSizeInBytes );
+
+        options.maximumTempSizeInBytes = tempSizeInBytes;
+        runTest();
+
+        EXPECT_LE( result.buffers.tempBufferSizeInBytes, tempSizeInBytes );
+
+        // the desc buffer is no longer overlaid with the triangle ids, so only the used descs are compared
+        ASSERT_EQ( expected.postBakeInfo.numMicromapDescs, result.postBakeInfo.numMicromapDescs );
+        EXPECT_EQ( expected.postBakeInfo.compactedSizeInBytes, result.postBakeInfo.compactedSizeInBytes );
+        EXPECT_EQ( 0, memcmp( expected.descs.data(), result.descs.data(), expected.postBakeInfo.numMicromapDescs * sizeof( OptixOpacityMicromapDesc ) ) );
+        EXPECT_EQ( expected.data, result.data );
+        EXPECT_EQ( expected.indices, result.indices );
+    }
+
+    // the limit must fit a single triangle
+    options.maximumTempSizeInBytes = minTempSizeInBytes - 1;
+    EXPECT_EQ( cuOmmBaking::Result::ERROR_INVALID_VALUE, bakeOnHost( result ) );
+}
+
+TEST_F( HostBakingTest, BatchedMaximumSize )
+{
+    // more unique omms than fit the omm array
+    options.maximumSizeInBytes = 64;
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 16, 16 } );
+
+    BakeResult expected;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( expected ) );
+
+    options.maximumTempSizeInBytes = expected.buffers.tempBufferSizeInBytes;
+    runTest();
+
+    EXPECT_EQ( expected.data, result.data );
+    EXPECT_EQ( expected.indices, result.indices );
+    EXPECT_EQ( expected.postBakeInfo.numMicromapDescs, result.postBakeInfo.numMicromapDescs );
+}
+
+TEST_F( HostBakingTest, BatchedOnDevice )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addTexture( "base/base.png" );
+    addMesh( { 0, 0 }, { 2, 2 }, { 8, 8 }, { 0, 1 } );
+    addMesh( { -1, -1 }, { 2, 2 }, { 6, 6 }, { 1 }, cudaAddressModeMirror, cudaAddressModeMirror, cuOmmBaking::IndexFormat::I16_UINT );
+    const uint32_t numTriangles = 2 * 8 * 8 + 2 * 6 * 6;
+    setupInputs();
+
+    BakeResult expected;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnDevice( expected ) );
+
+    // a batch of all triangles. the sort temp storage doesn't grow for smaller batches, so each triangle less fits in
+    // a limit that is lower by the per triangle buffer size
+    options.maximumTempSizeInBytes = ~( size_t )0;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnDevice( result, false, true ) );
+    const size_t maxTempSizeInBytes = result.buffers.tempBufferSizeInBytes;
+    const size_t bytesPerTriangle   = 24;
+
+    for( uint32_t batchSize : { numTriangles, numTriangles / 2, 7u, 1u } )
+    {
+        const size_t tempSizeInBytes = maxTempSizeInBytes - ( numTriangles - batchSize ) * bytesPerTriangle;
+        SCOPED_TRACE( tempSizeInBytes );
+
+        options.maximumTempSizeInBytes = tempSizeInBytes;
+        ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnDevice( result, false, true ) );
+
+        EXPECT_LE( result.buffers.tempBufferSizeInBytes, tempSizeInBytes );
+
+        // the desc buffer is no longer overlaid with the triangle ids, so only the used descs are compared
+        ASSERT_EQ( expected.postBakeInfo.numMicromapDescs, result.postBakeInfo.numMicromapDescs );
+        EXPECT_EQ( expected.postBakeInfo.compactedSizeInBytes, result.postBakeInfo.compactedSizeInBytes );
+        EXPECT_EQ( 0, memcmp( expected.descs.data(), result.descs.data(), expected.postBakeInfo.numMicromapDescs * sizeof( OptixOpacityMicromapDesc ) ) );
+        EXPECT_EQ( expected.data, result.data );
+        EXPECT_EQ( expected.indices, result.indices );
+    }
+
+    // the limit must fit a single triangle
+    options.maximumTempSizeInBytes = 1;
+    EXPECT_EQ( cuOmmBaking::Result::ERROR_INVALID_VALUE, bakeOnDevice( result, false, true ) );
+}
+
+TEST_F( HostBakingTest, AdaptiveSubdivision )
+{
+    // the size limit is below the target density, so the subdivision levels are traded off between omms
+    options.maximumSizeInBytes = 1024;
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 8, 8 } );
+
+    // fraction of unknown micro triangles summed over all triangles, which have equal areas
+    auto sumUnknownFraction = [this]( const BakeResult& res ) {
+        double sum = 0;
+        for( uint32_t i = 0; i < getNumTriangles( inputs[0] ); ++i )
+        {
+            const uint32_t index = loadIndex( res, 0, i );
+            if( index == ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_UNKNOWN_TRANSPARENT
+                || index == ( uint32_t )OPTIX_OPACITY_MICROMAP_PREDEFINED_INDEX_FULLY_UNKNOWN_OPAQUE )
+                sum += 1;
+            if( index >= ( uint32_t )( -4 ) )
+                continue;
+
+            const OptixOpacityMicromapDesc& desc              = res.descs[index];
+            const uint32_t                  numMicroTriangles = 1u << ( 2 * desc.subdivisionLevel );
+
+            uint32_t numUnknown = 0;
+            for( uint32_t j = 0; j < numMicroTriangles; ++j )
+            {
+                const uint32_t state = ( res.data[desc.byteOffset + j / 4] >> ( 2 * ( j % 4 ) ) ) & 3;
+                if( state == OPTIX_OPACITY_MICROMAP_STATE_UNKNOWN_TRANSPARENT || state == OPTIX_OPACITY_MICROMAP_STATE_UNKNOWN_OPAQUE )
+                    numUnknown++;
+            }
+            sum += ( double )numUnknown / numMicroTriangles;
+        }
+        return sum;
+    };
+
+    BakeResult areaBased;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( areaBased ) );
+
+    options.flags = options.flags | cuOmmBaking::BakeFlags::ADAPTIVE_SUBDIVISION;
+    runTest();
+
+    EXPECT_LE( result.postBakeInfo.compactedSizeInBytes, options.maximumSizeInBytes );
+    EXPECT_EQ( areaBased.postBakeInfo.numMicromapDescs, result.postBakeInfo.numMicromapDescs );
+
+    // the same size limit leaves fewer unknown micro triangles
+    EXPECT_LT( sumUnknownFraction( result ), sumUnknownFraction( areaBased ) );
+}
+
+TEST_F( HostBakingTest, StageCallback )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 1, 1 }, { 8, 8 } );
+
+    struct Event
+    {
+        cuOmmBaking::BakeStage stage;
+        bool                   end;
+    };
+    std::vector<Event> events;
+
+    options.stageCallback = []( cuOmmBaking::BakeStage stage, bool end, cudaStream_t stream, void* userData ) {
+        EXPECT_EQ( nullptr, stream );
+        static_cast<std::vector<Event>*>( userData )->push_back( { stage, end } );
+    };
+    options.stageCallbackUserData = &events;
+
+    // only the host bake is run, runTest would add the events of the device comparison
+
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( result ) );
+
+    // each stage is reported once, in order
+    ASSERT_EQ( 2u * ( uint32_t )cuOmmBaking::BakeStage::MAX_NUM, events.size() );
+    for( size_t i = 0; i < events.size(); ++i )
+    {
+        EXPECT_EQ( ( uint32_t )( i / 2 ), ( uint32_t )events[i].stage );
+        EXPECT_EQ( i % 2 == 1, events[i].end );
+    }
+
+    // batched baking reports the setup, sort and assignment stages per batch. setup is reported once more for the
+    // textures and inputs, and assignment once more for the remap.
+    options.maximumTempSizeInBytes = ~( size_t )0;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( result ) );
+
+    events.clear();
+    options.maximumTempSizeInBytes = result.buffers.tempBufferSizeInBytes - 100 * 24;
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( result ) );
+
+    std::vector<uint32_t> numBegins( ( uint32_t )cuOmmBaking::BakeStage::MAX_NUM );
+    for( size_t i = 0; i < events.size(); ++i )
+    {
+        if( !events[i].end )
+        {
+            numBegins[( uint32_t )events[i].stage]++;
+            ASSERT_LT( i + 1, events.size() );
+            EXPECT_EQ( ( uint32_t )events[i].stage, ( uint32_t )events[i + 1].stage );
+            EXPECT_TRUE( events[i + 1].end );
+        }
+    }
+    const uint32_t numBatches = numBegins[( uint32_t )cuOmmBaking::BakeStage::SORT];
+    EXPECT_LT( 1u, numBatches );
+    EXPECT_EQ( numBatches + 1, numBegins[( uint32_t )cuOmmBaking::BakeStage::SETUP] );
+    EXPECT_EQ( numBatches + 1, numBegins[( uint32_t )cuOmmBaking::BakeStage::ASSIGNMENT] );
+    EXPECT_EQ( 1u, numBegins[( uint32_t )cuOmmBaking::BakeStage::LAYOUT] );
+    EXPECT_EQ( 1u, numBegins[( uint32_t )cuOmmBaking::BakeStage::EVALUATION] );
+}
+
+TEST_F( HostBakingTest, DISABLED_benchmarkTrianglesPerSecond )
+{
+    addTexture( "DuckHole/DuckHole.png" );
+    addMesh( { 0, 0 }, { 16, 16 }, { 512, 512 }, { 0 }, cudaAddressModeClamp, cudaAddressModeClamp );
+
+    const uint32_t numTriangles = 2 * 512 * 512;
+    const int      iterations   = 4;
+
+    ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( result ) );
+
+    auto start = std::chrono::steady_clock::now();
+    for( int i = 0; i < iterations; ++i )
+        ASSERT_EQ( cuOmmBaking::Result::SUCCESS, bakeOnHost( result ) );
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    std::cout << "Host baked " << result.postBakeInfo.numMicromapDescs << " omms of " << numTriangles << " triangles at "
+              << ( numTriangles * iterations / seconds ) << " triangles/s" << std::endl;
+}
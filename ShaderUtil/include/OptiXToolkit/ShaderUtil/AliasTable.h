@@ -10,8 +10,13 @@
 #include <math.h>
 #include <stdlib.h>
 #include <cuda_runtime.h>
+#include <OptiXToolkit/ShaderUtil/HostParallel.h>
 #include <OptiXToolkit/ShaderUtil/Preprocessor.h>
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #ifndef CUDA_CHECK
 #define CUDA_CHECK( call )                                                                                                                                                                                                                                                             \
     {                                                                                                                                                                                                                                                                                  \
@@ -63,8 +68,9 @@ inline void freeAliasTableHost( AliasTable& at )
     free( at.table );
 }
 
-/// Create an alias table (on the host) from a pdf array of the same size 
-inline void makeAliasTable( AliasTable& at, float* pdf )
+/// Create an alias table (on the host) from a pdf array of the same size, serially.  The pdf is
+/// overwritten.
+inline void makeAliasTableSerial( AliasTable& at, float* pdf )
 {
     // find average
     double dAve = 0.0f;
@@ -108,6 +114,188 @@ inline void makeAliasTable( AliasTable& at, float* pdf )
     }
 }
 
+/// Build the entries of an alias table from (double precision) weights normalized to an average
+/// of one, with the sweep construction of Vose's method: light items (weight <= 1) are visited in
+/// order and paired with the current heavy item (weight > 1), whose residual weight is reduced
+/// until it becomes light, at which point its own entry is paired with the next heavy item.  The
+/// items are the positions [lightBegin, lightEnd) for light items and [heavyBegin, heavyEnd) for
+/// heavy items of a sequence in which position i has table index index( i ) and weight
+/// weight( i ).  Unpaired items are appended to leftovers with their (residual) weights.
+template <class INDEX, class WEIGHT>
+void sweepAliasTable( AliasTable& at, const INDEX& index, const WEIGHT& weight, int lightBegin, int lightEnd,
+                      int heavyBegin, int heavyEnd, std::vector<std::pair<int, double>>& leftovers )
+{
+    int light = lightBegin;
+    while( light < lightEnd && weight( light ) > 1.0 )
+        ++light;
+    int heavy = heavyBegin;
+    while( heavy < heavyEnd && weight( heavy ) <= 1.0 )
+        ++heavy;
+
+    double residual = ( heavy < heavyEnd ) ? weight( heavy ) : 0.0;
+    while( heavy < heavyEnd )
+    {
+        if( residual > 1.0 )
+        {
+            if( light >= lightEnd )
+                break;
+            const double lightWeight = weight( light );
+            at.table[index( light )] = AliasRecord{ static_cast<float>( lightWeight ), index( heavy ) };
+            residual -= 1.0 - lightWeight;
+            do
+                ++light;
+            while( light < lightEnd && weight( light ) > 1.0 );
+        }
+        else
+        {
+            int next = heavy + 1;
+            while( next < heavyEnd && weight( next ) <= 1.0 )
+                ++next;
+            if( next >= heavyEnd )
+                break;
+            at.table[index( heavy )] = AliasRecord{ static_cast<float>( residual ), index( next ) };
+            residual += weight( next ) - 1.0;
+            heavy = next;
+        }
+    }
+
+    if( heavy < heavyEnd )
+    {
+        leftovers.push_back( std::make_pair( index( heavy ), residual ) );
+        for( int i = heavy + 1; i < heavyEnd; ++i )
+        {
+            if( weight( i ) > 1.0 )
+                leftovers.push_back( std::make_pair( index( i ), weight( i ) ) );
+        }
+    }
+    for( ; light < lightEnd; ++light )
+    {
+        if( weight( light ) <= 1.0 )
+            leftovers.push_back( std::make_pair( index( light ), weight( light ) ) );
+    }
+}
+
+/// Find the index at which the running sum of the values of a kind of item (light or heavy) in
+/// blocks of blockSize items reaches target, given the prefix sums of the blocks.
+template <class VALUE>
+int findAliasSplit( const std::vector<double>& blockPrefix, int blockSize, int size, double target, const VALUE& value )
+{
+    int block = 0;
+    while( block + 1 < static_cast<int>( blockPrefix.size() ) && blockPrefix[block + 1] < target )
+        ++block;
+    double sum = blockPrefix[block];
+    int i = block * blockSize;
+    for( ; i < size && sum < target; ++i )
+        sum += value( i );
+    return i;
+}
+
+/// Create an alias table (on the host) from a pdf array of the same size.
+///
+/// With numThreads == 1 (the default), or a pdf too small to split, the table is built serially by
+/// makeAliasTableSerial, which overwrites the pdf.  Otherwise (zero selects the number of hardware
+/// threads) the table is built by a parallel sweep, which leaves the pdf intact: the light (below
+/// average) and heavy (above average) items are split into bands of nearly equal total deficit and
+/// excess weight, each band is swept by a thread, and the items left over from the bands are swept
+/// serially.  The parallel table pairs items differently, but represents the same distribution:
+/// the probability it implies for each item matches the pdf to within float rounding (a relative
+/// error of about 1e-7), whereas the serial build leaves the rounding error of its float average,
+/// which grows with the size of the table, to the last item it pairs.
+inline void makeAliasTable( AliasTable& at, float* pdf, int numThreads = 1 )
+{
+    const int blockSize = 4096;
+    const int numBlocks = ( at.size + blockSize - 1 ) / blockSize;
+    const int numBands = otk::getHostBandCount( numBlocks, numThreads );
+    if( numThreads == 1 || numBands == 1 )
+    {
+        makeAliasTableSerial( at, pdf );
+        return;
+    }
+
+    // find average
+    std::vector<double> bandSums( numBands, 0.0 );
+    otk::parallelBands( at.size, numBands, [&]( int band, int begin, int end ) {
+        double bandSum = 0.0;
+        for( int i = begin; i < end; ++i )
+            bandSum += pdf[i];
+        bandSums[band] = bandSum;
+    } );
+    double dSum = 0.0;
+    for( int band = 0; band < numBands; ++band )
+        dSum += bandSums[band];
+    // The weights are normalized in double precision, so that the total deficit of the light items
+    // matches the total excess of the heavy items, instead of leaving the rounding error of a float
+    // average to the last item.
+    const double ave = dSum / at.size;
+    auto weight = [pdf, ave]( int i ) { return pdf[i] / ave; };
+
+    // Sum the deficit of the light items and the excess of the heavy items in blocks.
+    std::vector<double> lightPrefix( numBlocks + 1, 0.0 );
+    std::vector<double> heavyPrefix( numBlocks + 1, 0.0 );
+    otk::parallelBands( numBlocks, numBands, [&]( int, int blockBegin, int blockEnd ) {
+        for( int block = blockBegin; block < blockEnd; ++block )
+        {
+            double deficit = 0.0;
+            double excess = 0.0;
+            const int end = ( at.size < ( block + 1 ) * blockSize ) ? at.size : ( block + 1 ) * blockSize;
+            for( int i = block * blockSize; i < end; ++i )
+            {
+                const double w = weight( i );
+                if( w > 1.0 )
+                    excess += w - 1.0;
+                else
+                    deficit += 1.0 - w;
+            }
+            lightPrefix[block + 1] = deficit;
+            heavyPrefix[block + 1] = excess;
+        }
+    } );
+    for( int block = 0; block < numBlocks; ++block )
+    {
+        lightPrefix[block + 1] += lightPrefix[block];
+        heavyPrefix[block + 1] += heavyPrefix[block];
+    }
+
+    // Split the light and heavy items into bands with equal shares of the total deficit and excess.
+    const double total = ( lightPrefix[numBlocks] < heavyPrefix[numBlocks] ) ? lightPrefix[numBlocks] : heavyPrefix[numBlocks];
+    std::vector<int> lightSplits( numBands + 1, at.size );
+    std::vector<int> heavySplits( numBands + 1, at.size );
+    lightSplits[0] = 0;
+    heavySplits[0] = 0;
+    for( int band = 1; band < numBands; ++band )
+    {
+        const double target = total * band / numBands;
+        lightSplits[band] = findAliasSplit( lightPrefix, blockSize, at.size, target, [&weight]( int i ) {
+            const double w = weight( i );
+            return ( w <= 1.0 ) ? 1.0 - w : 0.0;
+        } );
+        heavySplits[band] = findAliasSplit( heavyPrefix, blockSize, at.size, target, [&weight]( int i ) {
+            const double w = weight( i );
+            return ( w > 1.0 ) ? w - 1.0 : 0.0;
+        } );
+    }
+
+    // Sweep the bands in parallel, then the items left over from all the bands.
+    auto identity = []( int i ) { return i; };
+    std::vector<std::vector<std::pair<int, double>>> bandLeftovers( numBands );
+    otk::parallelBands( numBands, numBands, [&]( int band, int, int ) {
+        sweepAliasTable( at, identity, weight, lightSplits[band], lightSplits[band + 1], heavySplits[band],
+                         heavySplits[band + 1], bandLeftovers[band] );
+    } );
+
+    std::vector<std::pair<int, double>> items;
+    for( const std::vector<std::pair<int, double>>& leftovers : bandLeftovers )
+        items.insert( items.end(), leftovers.begin(), leftovers.end() );
+    const int numItems = static_cast<int>( items.size() );
+    std::vector<std::pair<int, double>> remaining;
+    sweepAliasTable( at, [&items]( int i ) { return items[i].first; }, [&items]( int i ) { return items[i].second; },
+                     0, numItems, 0, numItems, remaining );
+
+    // Anything still unpaired differs from a weight of one only by rounding.
+    for( const std::pair<int, double>& item : remaining )
+        at.table[item.first] = AliasRecord{ 1.0f, item.first };
+}
+
 inline cudaError_t copyToDevice( AliasTable& atHost, AliasTable& atDev )
 {
     return cudaMemcpy( atDev.table, atHost.table, atHost.size * sizeof(AliasRecord), cudaMemcpyHostToDevice );
@@ -163,3 +351,207 @@ OTK_INLINE OTK_HOSTDEVICE float2 alias2D( const AliasTable& at, int width, int h
     return float2{( dx + i ) / width, ( dy + j ) / height};
 }
 
+/// Compute the density with which an alias table samples each of its entries, relative to a
+/// uniform density of one: the probability of keeping the entry itself, plus the probabilities of
+/// the entries that alias to it.  Entries with a probability of at least one are always kept.
+inline void getAliasTablePdf( const AliasTable& at, float* pdf )
+{
+    std::fill( pdf, pdf + at.size, 0.0f );
+    for( int i = 0; i < at.size; ++i )
+    {
+        const float prob = ( at.table[i].prob < 1.0f ) ? at.table[i].prob : 1.0f;
+        pdf[i] += prob;
+        if( prob < 1.0f )
+            pdf[at.table[i].alias] += 1.0f - prob;
+    }
+}
+
+/// Get the density of an alias2D sample uv from the entry densities made by getAliasTablePdf.
+OTK_INLINE OTK_HOSTDEVICE float getAlias2DPdf( const float* entryPdf, int width, int height, float2 uv )
+{
+    int col = static_cast<int>( uv.x * width );
+    int row = static_cast<int>( uv.y * height );
+    col = ( col < width - 1 ) ? ( col > 0 ? col : 0 ) : width - 1;
+    row = ( row < height - 1 ) ? ( row > 0 ? row : 0 ) : height - 1;
+    return entryPdf[row * width + col];
+}
+
+
+/// Number of entries in a block of a CompactAliasTable.  Aliases point within their block, so they
+/// fit in 16 bits.
+#define COMPACT_ALIAS_BLOCK_SIZE 65536
+
+/// A 4 byte alias table entry: the probability of keeping the entry in 16 bit fixed point (out of
+/// 65536), and the index of its alias within the block.
+struct CompactAliasRecord
+{
+    unsigned short prob;
+    unsigned short alias;
+};
+
+/// An alias table with half the footprint of AliasTable, for very large tables.  The items are
+/// split into blocks of COMPACT_ALIAS_BLOCK_SIZE, each with its own alias table of
+/// CompactAliasRecords, and a (small) AliasTable selects the block in proportion to its weight.
+///
+/// Within a block, the weights are rounded to integers summing to 65536 per entry, and the
+/// construction is exact in integers, so the only bias within a block is the rounding of the
+/// weights: the probability of each item differs from its share of the block by less than
+/// 1 / ( 65536 * blockSize ), and items with zero weight are never selected.  Items whose share is
+/// below that may be rounded to zero.  The block selection has the float precision of AliasTable.
+struct CompactAliasTable
+{
+    int size;
+    int numBlocks;
+    AliasTable blockTable;
+    CompactAliasRecord* table;
+};
+
+/// Allocate a compact alias table on the host
+inline void allocCompactAliasTableHost( CompactAliasTable& cat, int size )
+{
+    cat.size = size;
+    cat.numBlocks = ( size + COMPACT_ALIAS_BLOCK_SIZE - 1 ) / COMPACT_ALIAS_BLOCK_SIZE;
+    allocAliasTableHost( cat.blockTable, cat.numBlocks );
+    cat.table = (CompactAliasRecord*) malloc( cat.size * sizeof(CompactAliasRecord) );
+}
+
+/// Free a compact alias table on the host
+inline void freeCompactAliasTableHost( CompactAliasTable& cat )
+{
+    freeAliasTableHost( cat.blockTable );
+    free( cat.table );
+}
+
+/// Allocate a compact alias table on the device
+inline cudaError_t allocCompactAliasTableDevice( CompactAliasTable& cat, int size )
+{
+    cat.size = size;
+    cat.numBlocks = ( size + COMPACT_ALIAS_BLOCK_SIZE - 1 ) / COMPACT_ALIAS_BLOCK_SIZE;
+    CUDA_CHECK( allocAliasTableDevice( cat.blockTable, cat.numBlocks ) );
+    CUDA_CHECK( cudaMalloc( &cat.table, cat.size * sizeof(CompactAliasRecord) ) );
+    return cudaSuccess;
+}
+
+/// Free a compact alias table on the device
+inline cudaError_t freeCompactAliasTableDevice( CompactAliasTable& cat )
+{
+    CUDA_CHECK( freeAliasTableDevice( cat.blockTable ) );
+    CUDA_CHECK( cudaFree( cat.table ) );
+    return cudaSuccess;
+}
+
+/// Copy a compact alias table from the host to the device
+inline cudaError_t copyToDevice( CompactAliasTable& catHost, CompactAliasTable& catDev )
+{
+    CUDA_CHECK( copyToDevice( catHost.blockTable, catDev.blockTable ) );
+    return cudaMemcpy( catDev.table, catHost.table, catHost.size * sizeof(CompactAliasRecord), cudaMemcpyHostToDevice );
+}
+
+/// Build the block of a compact alias table with the given size starting at entry begin.  Returns
+/// the weight of the block.
+inline double makeCompactAliasBlock( CompactAliasTable& cat, const float* pdf, int begin, int blockSize )
+{
+    const unsigned long long unitsPerEntry = 65536;
+    CompactAliasRecord* records = &cat.table[begin];
+    double blockWeight = 0.0;
+    for( int i = 0; i < blockSize; ++i )
+        blockWeight += pdf[begin + i];
+    if( !( blockWeight > 0.0 ) )
+    {
+        for( int i = 0; i < blockSize; ++i )
+            records[i] = CompactAliasRecord{ 0xffff, static_cast<unsigned short>( i ) };
+        return 0.0;
+    }
+
+    // Round the weights to integer units, 65536 per entry on average, giving the units lost by
+    // rounding down to the items with the largest remainders.
+    const double scale = static_cast<double>( unitsPerEntry * blockSize ) / blockWeight;
+    std::vector<unsigned long long> units( blockSize );
+    std::vector<std::pair<double, int>> remainders( blockSize );
+    unsigned long long totalUnits = 0;
+    for( int i = 0; i < blockSize; ++i )
+    {
+        const double exact = ( pdf[begin + i] > 0.0f ) ? pdf[begin + i] * scale : 0.0;
+        units[i] = static_cast<unsigned long long>( exact );
+        totalUnits += units[i];
+        remainders[i] = std::pair<double, int>( exact - static_cast<double>( units[i] ), i );
+    }
+    const long long lostUnits = static_cast<long long>( unitsPerEntry * blockSize ) - static_cast<long long>( totalUnits );
+    if( lostUnits > 0 )
+    {
+        std::nth_element( remainders.begin(), remainders.begin() + ( lostUnits - 1 ), remainders.end(),
+                          []( const std::pair<double, int>& a, const std::pair<double, int>& b ) { return a.first > b.first; } );
+        for( long long i = 0; i < lostUnits; ++i )
+            units[remainders[i].second]++;
+    }
+
+    // Vose's method in integers: each light item (under 65536 units) keeps its units and takes the
+    // rest of its entry from a heavy item, which becomes light when it drops under 65536 units.
+    std::vector<int> light;
+    std::vector<int> heavy;
+    for( int i = 0; i < blockSize; ++i )
+        ( units[i] < unitsPerEntry ? light : heavy ).push_back( i );
+    while( !light.empty() && !heavy.empty() )
+    {
+        const int l = light.back();
+        light.pop_back();
+        const int h = heavy.back();
+        records[l] = CompactAliasRecord{ static_cast<unsigned short>( units[l] ), static_cast<unsigned short>( h ) };
+        units[h] -= unitsPerEntry - units[l];
+        if( units[h] < unitsPerEntry )
+        {
+            heavy.pop_back();
+            light.push_back( h );
+        }
+    }
+
+    // The units sum exactly, so the remaining items have exactly 65536 units, and keep their entry.
+    for( int i : heavy )
+        records[i] = CompactAliasRecord{ 0xffff, static_cast<unsigned short>( i ) };
+    for( int i : light )
+        records[i] = CompactAliasRecord{ 0xffff, static_cast<unsigned short>( i ) };
+    return blockWeight;
+}
+
+/// Create a compact alias table (on the host) from a pdf array of the same size.  The blocks are
+/// built in bands by numThreads threads (zero selects the number of hardware threads), which does
+/// not change the result.  The pdf is not modified.
+inline void makeCompactAliasTable( CompactAliasTable& cat, const float* pdf, int numThreads = 1 )
+{
+    std::vector<double> blockWeights( cat.numBlocks );
+    otk::parallelBands( cat.numBlocks, otk::getHostBandCount( cat.numBlocks, numThreads ), [&]( int, int blockBegin, int blockEnd ) {
+        for( int block = blockBegin; block < blockEnd; ++block )
+        {
+            const int begin = block * COMPACT_ALIAS_BLOCK_SIZE;
+            const int blockSize = ( cat.size - begin < COMPACT_ALIAS_BLOCK_SIZE ) ? cat.size - begin : COMPACT_ALIAS_BLOCK_SIZE;
+            blockWeights[block] = makeCompactAliasBlock( cat, pdf, begin, blockSize );
+        }
+    } );
+
+    // Build the block table from the double precision block weights.
+    double sum = 0.0;
+    for( double weight : blockWeights )
+        sum += weight;
+    const double ave = sum / cat.numBlocks;
+    std::vector<std::pair<int, double>> leftovers;
+    sweepAliasTable( cat.blockTable, []( int i ) { return i; }, [&blockWeights, ave]( int i ) { return blockWeights[i] / ave; }, 0,
+                     cat.numBlocks, 0, cat.numBlocks, leftovers );
+    for( const std::pair<int, double>& item : leftovers )
+        cat.blockTable.table[item.first] = AliasRecord{ 1.0f, item.first };
+}
+
+/// Sample a compact alias table with two 32 bit random numbers, the first selecting the block, and
+/// the second the entry in the block (high bits) and whether to take its alias (low bits).
+OTK_INLINE OTK_HOSTDEVICE int alias( const CompactAliasTable& cat, uint2 xi )
+{
+    const int block = alias( cat.blockTable, clampUnderOne( xi.x * scalbnf( 1.0f, -32 ) ) );
+    const int begin = block * COMPACT_ALIAS_BLOCK_SIZE;
+    const unsigned int blockSize = ( cat.size - begin < COMPACT_ALIAS_BLOCK_SIZE ) ? cat.size - begin : COMPACT_ALIAS_BLOCK_SIZE;
+
+    // Multiply-shift maps xi.y uniformly to an entry, with the fraction left in the low bits.
+    const unsigned long long scaled = static_cast<unsigned long long>( xi.y ) * blockSize;
+    const unsigned int entry = static_cast<unsigned int>( scaled >> 32 );
+    const unsigned int p = static_cast<unsigned int>( scaled ) >> 16;
+    const CompactAliasRecord record = cat.table[begin + entry];
+    return begin + static_cast<int>( ( p < record.prob ) ? entry : record.alias );
+}
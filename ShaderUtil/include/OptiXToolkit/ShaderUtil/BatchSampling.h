@@ -0,0 +1,621 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file BatchSampling.h
+/// Host versions of the ShaderUtil samplers that process batches of samples stored as structures of
+/// arrays, for CPU renderers and offline verification of light transport.
+///
+/// Each function takes count random numbers (or other inputs) as separate x and y arrays, and
+/// writes count results to separate arrays, matching the scalar functions.  On processors with
+/// AVX2, the table samplers process OTK_BATCH_LANES samples at a time, using gathers for the table
+/// lookups and running the binary searches of the lanes in lockstep.  The remaining samples, and
+/// all of them without AVX2, use the scalar functions in loops that the compiler can vectorize
+/// where they are branch free.
+///
+/// With GCC and Clang the AVX2 kernels are compiled with a target attribute and chosen at run time,
+/// so no compiler flags are needed.  MSVC has no such attribute, so there the kernels are used only
+/// when compiling with /arch:AVX2.  CUDA translation units use the scalar functions.
+
+#include <OptiXToolkit/ShaderUtil/AliasTable.h>
+#include <OptiXToolkit/ShaderUtil/CdfInversionTable.h>
+#include <OptiXToolkit/ShaderUtil/ISummedAreaTable.h>
+#include <OptiXToolkit/ShaderUtil/ray_cone.h>
+#include <OptiXToolkit/ShaderUtil/stochastic_filtering.h>
+
+#if !defined( __CUDACC__ ) && defined( __x86_64__ ) && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#define OTK_BATCH_USE_AVX2
+#define OTK_BATCH_AVX2 __attribute__( ( target( "avx2" ) ) )
+#include <immintrin.h>
+#elif !defined( __CUDACC__ ) && defined( _M_X64 ) && defined( __AVX2__ )
+#define OTK_BATCH_USE_AVX2
+#define OTK_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+/// Number of samples processed together by the batched table samplers.
+#define OTK_BATCH_LANES 8
+
+#ifdef OTK_BATCH_USE_AVX2
+namespace otk {
+
+/// Returns true if the processor supports AVX2.
+inline bool batchHasAVX2()
+{
+#if defined( _MSC_VER )
+    return true;  // compiled with /arch:AVX2
+#else
+    static const bool result = ( __builtin_cpu_init(), __builtin_cpu_supports( "avx2" ) != 0 );
+    return result;
+#endif
+}
+
+/// x - static_cast<int>( x ) for each lane, as frac() in AliasTable.h.
+OTK_BATCH_AVX2 inline __m256 batchFrac( __m256 x )
+{
+    return _mm256_sub_ps( x, _mm256_cvtepi32_ps( _mm256_cvttps_epi32( x ) ) );
+}
+
+/// ( x < limit ) ? x : value for each lane.
+OTK_BATCH_AVX2 inline __m256 batchClampUnder( __m256 x, float limit, float value )
+{
+    return _mm256_blendv_ps( _mm256_set1_ps( value ), x, _mm256_cmp_ps( x, _mm256_set1_ps( limit ), _CMP_LT_OQ ) );
+}
+
+/// static_cast<float> of unsigned ints.  The high half scales exactly, so the sum rounds once.
+OTK_BATCH_AVX2 inline __m256 batchUintToFloat( __m256i x )
+{
+    const __m256 hi = _mm256_cvtepi32_ps( _mm256_srli_epi32( x, 16 ) );
+    const __m256 lo = _mm256_cvtepi32_ps( _mm256_and_si256( x, _mm256_set1_epi32( 0xffff ) ) );
+    return _mm256_add_ps( _mm256_mul_ps( hi, _mm256_set1_ps( 65536.0f ) ), lo );
+}
+
+/// static_cast<unsigned int> of non-negative floats below 2^32.
+OTK_BATCH_AVX2 inline __m256i batchFloatToUint( __m256 x )
+{
+    const __m256  twoPow31 = _mm256_set1_ps( 2147483648.0f );
+    const __m256  big      = _mm256_cmp_ps( x, twoPow31, _CMP_GE_OQ );
+    const __m256i low      = _mm256_cvttps_epi32( _mm256_sub_ps( x, _mm256_and_ps( big, twoPow31 ) ) );
+    return _mm256_xor_si256( low, _mm256_and_si256( _mm256_castps_si256( big ), _mm256_set1_epi32( 0x80000000 ) ) );
+}
+
+/// a > b for each lane of unsigned ints.
+OTK_BATCH_AVX2 inline __m256i batchGreaterUint( __m256i a, __m256i b )
+{
+    const __m256i signBit = _mm256_set1_epi32( 0x80000000 );
+    return _mm256_cmpgt_epi32( _mm256_xor_si256( a, signBit ), _mm256_xor_si256( b, signBit ) );
+}
+
+/// sampleCdfBinSearch for each lane, searching the cdfs of the given width starting at element
+/// offsets base in cdf.
+OTK_BATCH_AVX2 inline __m256 batchCdfBinSearch( const float* cdf, __m256i base, int width, __m256 x )
+{
+    x = batchClampUnder( x, NEAR_ONE, NEAR_ONE );
+    __m256i left   = _mm256_setzero_si256();
+    __m256i right  = _mm256_set1_epi32( width - 1 );
+    const __m256i one = _mm256_set1_epi32( 1 );
+    __m256i active = _mm256_xor_si256( _mm256_cmpgt_epi32( left, right ), _mm256_set1_epi32( -1 ) );
+    while( !_mm256_testz_si256( active, active ) )
+    {
+        const __m256i mid       = _mm256_srai_epi32( _mm256_add_epi32( left, right ), 1 );
+        const __m256  cdfMid    = _mm256_mask_i32gather_ps( _mm256_setzero_ps(), cdf, _mm256_add_epi32( base, mid ), _mm256_castsi256_ps( active ), 4 );
+        const __m256i midBigger = _mm256_castps_si256( _mm256_cmp_ps( cdfMid, x, _CMP_GE_OQ ) );
+        right  = _mm256_blendv_epi8( right, _mm256_sub_epi32( mid, one ), _mm256_and_si256( midBigger, active ) );
+        left   = _mm256_blendv_epi8( left, _mm256_add_epi32( mid, one ), _mm256_andnot_si256( midBigger, active ) );
+        active = _mm256_xor_si256( _mm256_cmpgt_epi32( left, right ), _mm256_set1_epi32( -1 ) );
+    }
+
+    const __m256i index   = left;
+    const __m256  aboveLo = _mm256_castsi256_ps( _mm256_cmpgt_epi32( index, _mm256_setzero_si256() ) );
+    const __m256  belowHi = _mm256_castsi256_ps( _mm256_cmpgt_epi32( _mm256_set1_epi32( width ), index ) );
+    const __m256i offset  = _mm256_add_epi32( base, index );
+    const __m256  minVal  = _mm256_mask_i32gather_ps( _mm256_setzero_ps(), cdf, _mm256_sub_epi32( offset, one ), aboveLo, 4 );
+    const __m256  maxVal  = _mm256_mask_i32gather_ps( _mm256_set1_ps( NEAR_ONE ), cdf, offset, belowHi, 4 );
+    const __m256  rval    = _mm256_add_ps( _mm256_cvtepi32_ps( index ),
+                                          _mm256_div_ps( _mm256_sub_ps( x, minVal ), _mm256_sub_ps( maxVal, minVal ) ) );
+    const __m256 fwidth = _mm256_set1_ps( static_cast<float>( width ) );
+    return _mm256_blendv_ps( rval, _mm256_set1_ps( width * NEAR_ONE ), _mm256_cmp_ps( rval, fwidth, _CMP_GE_OQ ) );
+}
+
+/// sampleCdfDirectLookup for each lane, in the inverted cdfs of the given width (at least 2)
+/// starting at element offsets base in invCdf.
+OTK_BATCH_AVX2 inline __m256 batchCdfDirectLookup( const unsigned short* invCdf, __m256i base, int width, __m256 x )
+{
+    x = batchClampUnder( x, NEAR_ONE, NEAR_ONE );
+    const __m256  xw    = _mm256_mul_ps( x, _mm256_set1_ps( static_cast<float>( width ) ) );
+    const __m256i index = _mm256_cvttps_epi32( xw );
+    const __m256  frac  = _mm256_sub_ps( xw, _mm256_cvtepi32_ps( index ) );
+
+    // Load invCdf[index] and invCdf[index+1] as one 32-bit word, or invCdf[index-1] and
+    // invCdf[index] for the last entry of a row, so that the loads stay within the array.
+    const __m256i atEnd = _mm256_cmpgt_epi32( index, _mm256_set1_epi32( width - 2 ) );
+    const __m256i offset = _mm256_sub_epi32( _mm256_add_epi32( base, index ), _mm256_and_si256( atEnd, _mm256_set1_epi32( 1 ) ) );
+    const __m256i words = _mm256_i32gather_epi32( reinterpret_cast<const int*>( invCdf ), offset, 2 );
+    const __m256i lo    = _mm256_and_si256( words, _mm256_set1_epi32( 0xffff ) );
+    const __m256i hi    = _mm256_srli_epi32( words, 16 );
+    const __m256  a     = _mm256_cvtepi32_ps( _mm256_blendv_epi8( lo, hi, atEnd ) );
+    const __m256  b     = _mm256_blendv_ps( _mm256_cvtepi32_ps( hi ), _mm256_set1_ps( NEAR_64K ), _mm256_castsi256_ps( atEnd ) );
+    const __m256  value = _mm256_add_ps( _mm256_mul_ps( _mm256_sub_ps( _mm256_set1_ps( 1.0f ), frac ), a ), _mm256_mul_ps( frac, b ) );
+    return _mm256_mul_ps( value, _mm256_set1_ps( 1.0f / 65536.0f ) );
+}
+
+/// sampleCdfLinSearch for each lane, searching the cdfs (and inverted cdfs) of the given width (at
+/// least 2) starting at element offsets base.  The lanes step through their cdfs in lockstep until
+/// the last one finds its entry.
+OTK_BATCH_AVX2 inline __m256 batchCdfLinSearch( const float* cdf, const unsigned short* invCdf, __m256i base, int width, __m256 x )
+{
+    x = batchClampUnder( x, NEAR_ONE, NEAR_ONE );
+
+    // Start at the entry given by the inverted cdf, loaded as in batchCdfDirectLookup.
+    const __m256i one    = _mm256_set1_epi32( 1 );
+    const __m256i guess  = _mm256_cvttps_epi32( _mm256_mul_ps( x, _mm256_set1_ps( static_cast<float>( width - 1 ) ) ) );
+    const __m256i atEnd  = _mm256_cmpgt_epi32( guess, _mm256_set1_epi32( width - 2 ) );
+    const __m256i words  = _mm256_i32gather_epi32( reinterpret_cast<const int*>( invCdf ), _mm256_sub_epi32( _mm256_add_epi32( base, guess ), _mm256_and_si256( atEnd, one ) ), 2 );
+    const __m256i inv    = _mm256_blendv_epi8( _mm256_and_si256( words, _mm256_set1_epi32( 0xffff ) ), _mm256_srli_epi32( words, 16 ), atEnd );
+    __m256i       index  = _mm256_srai_epi32( _mm256_mullo_epi32( inv, _mm256_set1_epi32( width ) ), 16 );
+
+    __m256       result  = _mm256_set1_ps( width * NEAR_ONE );
+    __m256i      pending = _mm256_set1_epi32( -1 );
+    const __m256i iwidth = _mm256_set1_epi32( width );
+    while( !_mm256_testz_si256( pending, pending ) )
+    {
+        const __m256i offset = _mm256_add_epi32( base, index );
+        const __m256  maxVal = _mm256_mask_i32gather_ps( _mm256_setzero_ps(), cdf, offset, _mm256_castsi256_ps( pending ), 4 );
+        const __m256i found  = _mm256_and_si256( pending, _mm256_castps_si256( _mm256_cmp_ps( maxVal, x, _CMP_GT_OQ ) ) );
+        const __m256  aboveLo = _mm256_castsi256_ps( _mm256_and_si256( found, _mm256_cmpgt_epi32( index, _mm256_setzero_si256() ) ) );
+        const __m256  minVal = _mm256_mask_i32gather_ps( _mm256_setzero_ps(), cdf, _mm256_sub_epi32( offset, one ), aboveLo, 4 );
+        const __m256  rval   = _mm256_add_ps( _mm256_cvtepi32_ps( index ), _mm256_div_ps( _mm256_sub_ps( x, minVal ), _mm256_sub_ps( maxVal, minVal ) ) );
+        result  = _mm256_blendv_ps( result, rval, _mm256_castsi256_ps( found ) );
+        pending = _mm256_andnot_si256( found, pending );
+        index   = _mm256_add_epi32( index, one );
+        pending = _mm256_and_si256( pending, _mm256_cmpgt_epi32( iwidth, index ) );
+    }
+    return result;
+}
+
+/// The cell of a sample uv in a width x height table, as in getCdfInversionTablePdf, for each lane.
+OTK_BATCH_AVX2 inline __m256i batchCell( __m256 u, __m256 v, int width, int height )
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i col = _mm256_min_epi32( _mm256_max_epi32( _mm256_cvttps_epi32( _mm256_mul_ps( u, _mm256_set1_ps( static_cast<float>( width ) ) ) ), zero ), _mm256_set1_epi32( width - 1 ) );
+    const __m256i row = _mm256_min_epi32( _mm256_max_epi32( _mm256_cvttps_epi32( _mm256_mul_ps( v, _mm256_set1_ps( static_cast<float>( height ) ) ) ), zero ), _mm256_set1_epi32( height - 1 ) );
+    return _mm256_add_epi32( _mm256_mullo_epi32( row, _mm256_set1_epi32( width ) ), col );
+}
+
+/// getCdfInversionTablePdf for each lane.
+OTK_BATCH_AVX2 inline __m256 batchCdfInversionTablePdf( CdfInversionTable& cit, __m256 u, __m256 v )
+{
+    const __m256i zero    = _mm256_setzero_si256();
+    const __m256i one     = _mm256_set1_epi32( 1 );
+    const __m256  fwidth  = _mm256_set1_ps( static_cast<float>( cit.width ) );
+    const __m256  fheight = _mm256_set1_ps( static_cast<float>( cit.height ) );
+    const __m256i col = _mm256_min_epi32( _mm256_max_epi32( _mm256_cvttps_epi32( _mm256_mul_ps( u, fwidth ) ), zero ), _mm256_set1_epi32( cit.width - 1 ) );
+    const __m256i row = _mm256_min_epi32( _mm256_max_epi32( _mm256_cvttps_epi32( _mm256_mul_ps( v, fheight ) ), zero ), _mm256_set1_epi32( cit.height - 1 ) );
+    const __m256i offset = _mm256_add_epi32( _mm256_mullo_epi32( row, _mm256_set1_epi32( cit.width ) ), col );
+
+    const __m256 x1   = _mm256_i32gather_ps( cit.cdfRows, offset, 4 );
+    const __m256 x0   = _mm256_mask_i32gather_ps( _mm256_setzero_ps(), cit.cdfRows, _mm256_sub_epi32( offset, one ), _mm256_castsi256_ps( _mm256_cmpgt_epi32( col, zero ) ), 4 );
+    const __m256 y1   = _mm256_i32gather_ps( cit.cdfMarginal, row, 4 );
+    const __m256 y0   = _mm256_mask_i32gather_ps( _mm256_setzero_ps(), cit.cdfMarginal, _mm256_sub_epi32( row, one ), _mm256_castsi256_ps( _mm256_cmpgt_epi32( row, zero ) ), 4 );
+    const __m256 pdfX = _mm256_mul_ps( _mm256_sub_ps( x1, x0 ), fwidth );
+    const __m256 pdfY = _mm256_mul_ps( _mm256_sub_ps( y1, y0 ), fheight );
+    return _mm256_mul_ps( pdfX, pdfY );
+}
+
+}  // namespace otk
+#endif
+
+#ifdef OTK_BATCH_USE_AVX2
+namespace otk {
+
+/// The AVX2 kernel of alias2DBatch, which returns the number of samples it processed.
+OTK_BATCH_AVX2 inline int alias2DBatchAVX2( const AliasTable& at, int width, int height, int count, const float* xiX, const float* xiY, float* u, float* v, const float* entryPdf, float* pdf )
+{
+    int i = 0;
+    const __m256  one     = _mm256_set1_ps( 1.0f );
+    const __m256  mix     = _mm256_set1_ps( 102.31435f );
+    const __m256  fwidth  = _mm256_set1_ps( static_cast<float>( width ) );
+    const __m256  fheight = _mm256_set1_ps( static_cast<float>( height ) );
+    const __m256i iwidth  = _mm256_set1_epi32( width );
+    const float*  probs   = &at.table[0].prob;
+    const int*    aliases = &at.table[0].alias;
+    for( ; i + OTK_BATCH_LANES <= count; i += OTK_BATCH_LANES )
+    {
+        const __m256  x   = otk::batchClampUnder( _mm256_loadu_ps( &xiX[i] ), 1.0f, 0.9999999f );
+        const __m256  y   = otk::batchClampUnder( _mm256_loadu_ps( &xiY[i] ), 1.0f, 0.9999999f );
+        const __m256i idx = _mm256_add_epi32( _mm256_mullo_epi32( _mm256_cvttps_epi32( _mm256_mul_ps( y, fheight ) ), iwidth ),
+                                              _mm256_cvttps_epi32( _mm256_mul_ps( x, fwidth ) ) );
+        const __m256  p   = otk::batchFrac( _mm256_mul_ps( _mm256_mul_ps( mix, _mm256_add_ps( x, one ) ), _mm256_add_ps( y, one ) ) );
+
+        // Each AliasRecord is two 32-bit words, the prob and the alias.
+        const __m256i record = _mm256_slli_epi32( idx, 1 );
+        const __m256  accept = _mm256_cmp_ps( p, _mm256_i32gather_ps( probs, record, 4 ), _CMP_LT_OQ );
+
+        // The coordinates of the alias, with random offsets from the bits of p
+        const __m256i aliasIdx = _mm256_i32gather_epi32( aliases, record, 4 );
+        const __m256i aj = _mm256_cvttps_epi32( _mm256_div_ps( _mm256_cvtepi32_ps( aliasIdx ), fwidth ) );
+        const __m256i ai = _mm256_sub_epi32( aliasIdx, _mm256_mullo_epi32( aj, iwidth ) );
+        const __m256  dx = otk::batchFrac( _mm256_mul_ps( mix, p ) );
+        const __m256  dy = otk::batchFrac( _mm256_mul_ps( mix, dx ) );
+        const __m256  au = _mm256_div_ps( _mm256_add_ps( dx, _mm256_cvtepi32_ps( ai ) ), fwidth );
+        const __m256  av = _mm256_div_ps( _mm256_add_ps( dy, _mm256_cvtepi32_ps( aj ) ), fheight );
+        const __m256  su = _mm256_blendv_ps( au, x, accept );
+        const __m256  sv = _mm256_blendv_ps( av, y, accept );
+        _mm256_storeu_ps( &u[i], su );
+        _mm256_storeu_ps( &v[i], sv );
+        if( pdf != nullptr )
+            _mm256_storeu_ps( &pdf[i], _mm256_i32gather_ps( entryPdf, otk::batchCell( su, sv, width, height ), 4 ) );
+    }
+    return i;
+}
+
+}  // namespace otk
+#endif
+
+/// Sample count points (u,v) with alias2D, from the random numbers (xiX, xiY).  If pdf is not null,
+/// it receives getAlias2DPdf of each sample, looked up in the entry densities made by
+/// getAliasTablePdf.
+inline void alias2DBatch( const AliasTable& at, int width, int height, int count, const float* xiX, const float* xiY, float* u, float* v,
+                          const float* entryPdf = nullptr, float* pdf = nullptr )
+{
+    int i = 0;
+#ifdef OTK_BATCH_USE_AVX2
+    if( otk::batchHasAVX2() )
+        i = otk::alias2DBatchAVX2( at, width, height, count, xiX, xiY, u, v, entryPdf, pdf );
+#endif
+    for( ; i < count; ++i )
+    {
+        const float2 uv = alias2D( at, width, height, float2{xiX[i], xiY[i]} );
+        u[i] = uv.x;
+        v[i] = uv.y;
+        if( pdf != nullptr )
+            pdf[i] = getAlias2DPdf( entryPdf, width, height, uv );
+    }
+}
+
+#ifdef OTK_BATCH_USE_AVX2
+namespace otk {
+
+/// The AVX2 kernel of sampleCdfBinSearchBatch, which returns the number of samples it processed.
+OTK_BATCH_AVX2 inline int sampleCdfBinSearchBatchAVX2( CdfInversionTable& cit, int count, const float* xiX, const float* xiY, float* u, float* v, float* pdf )
+{
+    int i = 0;
+    const __m256  fwidth  = _mm256_set1_ps( static_cast<float>( cit.width ) );
+    const __m256  fheight = _mm256_set1_ps( static_cast<float>( cit.height ) );
+    const __m256i iwidth  = _mm256_set1_epi32( cit.width );
+    for( ; i + OTK_BATCH_LANES <= count; i += OTK_BATCH_LANES )
+    {
+        const __m256  y   = otk::batchCdfBinSearch( cit.cdfMarginal, _mm256_setzero_si256(), cit.height, _mm256_loadu_ps( &xiY[i] ) );
+        const __m256i row = _mm256_cvttps_epi32( y );
+        const __m256  x   = otk::batchCdfBinSearch( cit.cdfRows, _mm256_mullo_epi32( row, iwidth ), cit.width, _mm256_loadu_ps( &xiX[i] ) );
+        const __m256  su  = _mm256_div_ps( x, fwidth );
+        const __m256  sv  = _mm256_div_ps( y, fheight );
+        _mm256_storeu_ps( &u[i], su );
+        _mm256_storeu_ps( &v[i], sv );
+        if( pdf != nullptr )
+            _mm256_storeu_ps( &pdf[i], otk::batchCdfInversionTablePdf( cit, su, sv ) );
+    }
+    return i;
+}
+
+}  // namespace otk
+#endif
+
+/// Sample count points (u,v) with sampleCdfBinSearch, from the random numbers (xiX, xiY).  If pdf is
+/// not null, it receives getCdfInversionTablePdf of each sample.
+inline void sampleCdfBinSearchBatch( CdfInversionTable& cit, int count, const float* xiX, const float* xiY, float* u, float* v, float* pdf = nullptr )
+{
+    int i = 0;
+#ifdef OTK_BATCH_USE_AVX2
+    if( otk::batchHasAVX2() )
+        i = otk::sampleCdfBinSearchBatchAVX2( cit, count, xiX, xiY, u, v, pdf );
+#endif
+    for( ; i < count; ++i )
+    {
+        const float2 uv = sampleCdfBinSearch( cit, float2{xiX[i], xiY[i]} );
+        u[i] = uv.x;
+        v[i] = uv.y;
+        if( pdf != nullptr )
+            pdf[i] = getCdfInversionTablePdf( cit, uv );
+    }
+}
+
+#ifdef OTK_BATCH_USE_AVX2
+namespace otk {
+
+/// The AVX2 kernel of sampleCdfLinSearchBatch, which returns the number of samples it processed.
+OTK_BATCH_AVX2 inline int sampleCdfLinSearchBatchAVX2( CdfInversionTable& cit, int count, const float* xiX, const float* xiY, float* u, float* v, float* pdf )
+{
+    int i = 0;
+    const __m256  fwidth  = _mm256_set1_ps( static_cast<float>( cit.width ) );
+    const __m256  fheight = _mm256_set1_ps( static_cast<float>( cit.height ) );
+    const __m256i iwidth  = _mm256_set1_epi32( cit.width );
+    for( ; cit.width >= 2 && cit.height >= 2 && i + OTK_BATCH_LANES <= count; i += OTK_BATCH_LANES )
+    {
+        const __m256  y   = otk::batchCdfLinSearch( cit.cdfMarginal, cit.invCdfMarginal, _mm256_setzero_si256(), cit.height, _mm256_loadu_ps( &xiY[i] ) );
+        const __m256i row = _mm256_mullo_epi32( _mm256_cvttps_epi32( y ), iwidth );
+        const __m256  x   = otk::batchCdfLinSearch( cit.cdfRows, cit.invCdfRows, row, cit.width, _mm256_loadu_ps( &xiX[i] ) );
+        const __m256  su  = _mm256_div_ps( x, fwidth );
+        const __m256  sv  = _mm256_div_ps( y, fheight );
+        _mm256_storeu_ps( &u[i], su );
+        _mm256_storeu_ps( &v[i], sv );
+        if( pdf != nullptr )
+            _mm256_storeu_ps( &pdf[i], otk::batchCdfInversionTablePdf( cit, su, sv ) );
+    }
+    return i;
+}
+
+}  // namespace otk
+#endif
+
+/// Sample count points (u,v) with sampleCdfLinSearch, from the random numbers (xiX, xiY).  If pdf is
+/// not null, it receives getCdfInversionTablePdf of each sample.  The linear searches of the lanes
+/// run in lockstep, for as many steps as the longest search in each batch.
+inline void sampleCdfLinSearchBatch( CdfInversionTable& cit, int count, const float* xiX, const float* xiY, float* u, float* v, float* pdf = nullptr )
+{
+    int i = 0;
+#ifdef OTK_BATCH_USE_AVX2
+    if( otk::batchHasAVX2() )
+        i = otk::sampleCdfLinSearchBatchAVX2( cit, count, xiX, xiY, u, v, pdf );
+#endif
+    for( ; i < count; ++i )
+    {
+        const float2 uv = sampleCdfLinSearch( cit, float2{xiX[i], xiY[i]} );
+        u[i] = uv.x;
+        v[i] = uv.y;
+        if( pdf != nullptr )
+            pdf[i] = getCdfInversionTablePdf( cit, uv );
+    }
+}
+
+#ifdef OTK_BATCH_USE_AVX2
+namespace otk {
+
+/// The AVX2 kernel of sampleCdfDirectLookupBatch, which returns the number of samples it processed.
+OTK_BATCH_AVX2 inline int sampleCdfDirectLookupBatchAVX2( CdfInversionTable& cit, int count, const float* xiX, const float* xiY, float* u, float* v, float* pdf )
+{
+    int i = 0;
+    const __m256  fheight = _mm256_set1_ps( static_cast<float>( cit.height ) );
+    const __m256i iwidth  = _mm256_set1_epi32( cit.width );
+    for( ; cit.width >= 2 && cit.height >= 2 && i + OTK_BATCH_LANES <= count; i += OTK_BATCH_LANES )
+    {
+        const __m256  y   = otk::batchCdfDirectLookup( cit.invCdfMarginal, _mm256_setzero_si256(), cit.height, _mm256_loadu_ps( &xiY[i] ) );
+        const __m256i row = _mm256_cvttps_epi32( _mm256_mul_ps( y, fheight ) );
+        const __m256  x   = otk::batchCdfDirectLookup( cit.invCdfRows, _mm256_mullo_epi32( row, iwidth ), cit.width, _mm256_loadu_ps( &xiX[i] ) );
+        _mm256_storeu_ps( &u[i], x );
+        _mm256_storeu_ps( &v[i], y );
+        if( pdf != nullptr )
+            _mm256_storeu_ps( &pdf[i], otk::batchCdfInversionTablePdf( cit, x, y ) );
+    }
+    return i;
+}
+
+}  // namespace otk
+#endif
+
+/// Sample count points (u,v) with sampleCdfDirectLookup, from the random numbers (xiX, xiY).  If pdf
+/// is not null, it receives getCdfInversionTablePdf of each sample, which approximates the density
+/// of the direct lookup.
+inline void sampleCdfDirectLookupBatch( CdfInversionTable& cit, int count, const float* xiX, const float* xiY, float* u, float* v, float* pdf = nullptr )
+{
+    int i = 0;
+#ifdef OTK_BATCH_USE_AVX2
+    if( otk::batchHasAVX2() )
+        i = otk::sampleCdfDirectLookupBatchAVX2( cit, count, xiX, xiY, u, v, pdf );
+#endif
+    for( ; i < count; ++i )
+    {
+        const float2 uv = sampleCdfDirectLookup( cit, float2{xiX[i], xiY[i]} );
+        u[i] = uv.x;
+        v[i] = uv.y;
+        if( pdf != nullptr )
+            pdf[i] = getCdfInversionTablePdf( cit, uv );
+    }
+}
+
+#ifdef OTK_BATCH_USE_AVX2
+namespace otk {
+
+/// getISummedAreaTablePdf for each lane.
+OTK_BATCH_AVX2 inline __m256 batchISummedAreaTablePdf( ISummedAreaTable& sat, __m256 u, __m256 v )
+{
+    const __m256i zero    = _mm256_setzero_si256();
+    const __m256i one     = _mm256_set1_epi32( 1 );
+    const __m256i iheight = _mm256_set1_epi32( sat.height );
+    const int*    lastRow = reinterpret_cast<const int*>( &sat.val( 0, sat.height - 1 ) );
+    const int*    columns = reinterpret_cast<const int*>( sat.columnSums );
+    const __m256i col = _mm256_min_epi32( _mm256_max_epi32( _mm256_cvttps_epi32( _mm256_mul_ps( u, _mm256_set1_ps( static_cast<float>( sat.width ) ) ) ), zero ), _mm256_set1_epi32( sat.width - 1 ) );
+    const __m256i row = _mm256_min_epi32( _mm256_max_epi32( _mm256_cvttps_epi32( _mm256_mul_ps( v, _mm256_set1_ps( static_cast<float>( sat.height ) ) ) ), zero ), _mm256_set1_epi32( sat.height - 1 ) );
+    const __m256i column = _mm256_mullo_epi32( col, iheight );
+    const __m256i offset = _mm256_add_epi32( column, row );
+
+    const __m256i x1 = _mm256_i32gather_epi32( lastRow, col, 4 );
+    const __m256i x0 = _mm256_mask_i32gather_epi32( zero, lastRow, _mm256_sub_epi32( col, one ), _mm256_cmpgt_epi32( col, zero ), 4 );
+    const __m256i y1 = _mm256_i32gather_epi32( columns, offset, 4 );
+    const __m256i y0 = _mm256_mask_i32gather_epi32( zero, columns, _mm256_sub_epi32( offset, one ), _mm256_cmpgt_epi32( row, zero ), 4 );
+    const __m256i columnTotal = _mm256_i32gather_epi32( columns, _mm256_add_epi32( column, _mm256_sub_epi32( iheight, one ) ), 4 );
+    const float   total = static_cast<float>( sat.val( sat.width - 1, sat.height - 1 ) );
+
+    const __m256 pdfX = _mm256_mul_ps( _mm256_div_ps( batchUintToFloat( _mm256_sub_epi32( x1, x0 ) ), _mm256_set1_ps( total ) ),
+                                       _mm256_set1_ps( static_cast<float>( sat.width ) ) );
+    const __m256 pdfY = _mm256_mul_ps( _mm256_div_ps( batchUintToFloat( _mm256_sub_epi32( y1, y0 ) ), batchUintToFloat( columnTotal ) ),
+                                       _mm256_set1_ps( static_cast<float>( sat.height ) ) );
+    const __m256 empty = _mm256_castsi256_ps( _mm256_cmpeq_epi32( columnTotal, zero ) );
+    return _mm256_mul_ps( pdfX, _mm256_blendv_ps( pdfY, _mm256_set1_ps( 1.0f ), empty ) );
+}
+
+/// The AVX2 kernel of sampleBatch, which returns the number of samples it processed.
+OTK_BATCH_AVX2 inline int sampleBatchAVX2( ISummedAreaTable& sat, int count, const float* xiX, const float* xiY, float* u, float* v, float* pdf )
+{
+    int i = 0;
+    const __m256i one       = _mm256_set1_epi32( 1 );
+    const __m256i minusOne  = _mm256_set1_epi32( -1 );
+    const __m256  underOne  = _mm256_set1_ps( 0.999999f );
+    const __m256  fwidth    = _mm256_set1_ps( static_cast<float>( sat.width ) );
+    const __m256  fheight   = _mm256_set1_ps( static_cast<float>( sat.height ) );
+    const int*    lastRow   = reinterpret_cast<const int*>( &sat.val( 0, sat.height - 1 ) );
+    const int*    columns   = reinterpret_cast<const int*>( sat.columnSums );
+    const float   rectSum   = static_cast<float>( sat.val( sat.width - 1, sat.height - 1 ) );
+    for( ; i + OTK_BATCH_LANES <= count; i += OTK_BATCH_LANES )
+    {
+        // findColumnInRect over the whole table, searching the last row.
+        const __m256i targetX = otk::batchFloatToUint( _mm256_mul_ps( _mm256_min_ps( _mm256_loadu_ps( &xiX[i] ), underOne ), _mm256_set1_ps( rectSum ) ) );
+        __m256i x0 = minusOne;
+        __m256i x1 = _mm256_set1_epi32( sat.width - 1 );
+        __m256i active = _mm256_cmpgt_epi32( x1, _mm256_add_epi32( x0, one ) );
+        while( !_mm256_testz_si256( active, active ) )
+        {
+            const __m256i mid     = _mm256_srai_epi32( _mm256_add_epi32( x0, x1 ), 1 );
+            const __m256i midSum  = _mm256_mask_i32gather_epi32( _mm256_setzero_si256(), lastRow, mid, active, 4 );
+            const __m256i greater = otk::batchGreaterUint( midSum, targetX );
+            x1     = _mm256_blendv_epi8( x1, mid, _mm256_and_si256( greater, active ) );
+            x0     = _mm256_blendv_epi8( x0, mid, _mm256_andnot_si256( greater, active ) );
+            active = _mm256_cmpgt_epi32( x1, _mm256_add_epi32( x0, one ) );
+        }
+        __m256i sum0 = _mm256_mask_i32gather_epi32( _mm256_setzero_si256(), lastRow, x0, _mm256_cmpgt_epi32( x0, minusOne ), 4 );
+        __m256i sum1 = _mm256_i32gather_epi32( lastRow, x1, 4 );
+        const __m256 x = _mm256_add_ps( _mm256_cvtepi32_ps( _mm256_add_epi32( x0, one ) ),
+                                        _mm256_div_ps( otk::batchUintToFloat( _mm256_sub_epi32( targetX, sum0 ) ),
+                                                       otk::batchUintToFloat( _mm256_sub_epi32( sum1, sum0 ) ) ) );
+
+        // findRowInColumn in the column of x, which is past the table if x rounds up to its width.
+        const __m256i col     = _mm256_cvttps_epi32( x );
+        const __m256i inside  = _mm256_cmpgt_epi32( _mm256_set1_epi32( sat.width ), col );
+        const __m256i column  = _mm256_mullo_epi32( _mm256_min_epi32( col, _mm256_set1_epi32( sat.width - 1 ) ), _mm256_set1_epi32( sat.height ) );
+        const __m256i colSum  = _mm256_i32gather_epi32( columns, _mm256_add_epi32( column, _mm256_set1_epi32( sat.height - 1 ) ), 4 );
+        const __m256i targetY = otk::batchFloatToUint( _mm256_mul_ps( _mm256_min_ps( _mm256_loadu_ps( &xiY[i] ), underOne ), otk::batchUintToFloat( colSum ) ) );
+        __m256i y0 = minusOne;
+        __m256i y1 = _mm256_set1_epi32( sat.height - 1 );
+        active = _mm256_cmpgt_epi32( y1, _mm256_add_epi32( y0, one ) );
+        while( !_mm256_testz_si256( active, active ) )
+        {
+            const __m256i mid     = _mm256_srai_epi32( _mm256_add_epi32( y0, y1 ), 1 );
+            const __m256i midSum  = _mm256_mask_i32gather_epi32( _mm256_setzero_si256(), columns, _mm256_add_epi32( column, mid ), active, 4 );
+            const __m256i greater = otk::batchGreaterUint( midSum, targetY );
+            y1     = _mm256_blendv_epi8( y1, mid, _mm256_and_si256( greater, active ) );
+            y0     = _mm256_blendv_epi8( y0, mid, _mm256_andnot_si256( greater, active ) );
+            active = _mm256_cmpgt_epi32( y1, _mm256_add_epi32( y0, one ) );
+        }
+        sum0 = _mm256_mask_i32gather_epi32( _mm256_setzero_si256(), columns, _mm256_add_epi32( column, y0 ), _mm256_cmpgt_epi32( y0, minusOne ), 4 );
+        sum1 = _mm256_i32gather_epi32( columns, _mm256_add_epi32( column, y1 ), 4 );
+        __m256 y = _mm256_add_ps( _mm256_cvtepi32_ps( _mm256_add_epi32( y0, one ) ),
+                                  _mm256_div_ps( otk::batchUintToFloat( _mm256_sub_epi32( targetY, sum0 ) ),
+                                                 otk::batchUintToFloat( _mm256_sub_epi32( sum1, sum0 ) ) ) );
+        y = _mm256_blendv_ps( _mm256_set1_ps( 0.5f * ( sat.height - 1 ) ), y, _mm256_castsi256_ps( inside ) );
+
+        const __m256 su = _mm256_div_ps( x, fwidth );
+        const __m256 sv = _mm256_div_ps( y, fheight );
+        _mm256_storeu_ps( &u[i], su );
+        _mm256_storeu_ps( &v[i], sv );
+        if( pdf != nullptr )
+            _mm256_storeu_ps( &pdf[i], otk::batchISummedAreaTablePdf( sat, su, sv ) );
+    }
+    return i;
+}
+
+}  // namespace otk
+#endif
+
+/// Sample count points (u,v) with sample( sat, xi ), from the random numbers (xiX, xiY).  If pdf is
+/// not null, it receives getISummedAreaTablePdf of each sample.
+inline void sampleBatch( ISummedAreaTable& sat, int count, const float* xiX, const float* xiY, float* u, float* v, float* pdf = nullptr )
+{
+    int i = 0;
+#ifdef OTK_BATCH_USE_AVX2
+    if( otk::batchHasAVX2() )
+        i = otk::sampleBatchAVX2( sat, count, xiX, xiY, u, v, pdf );
+#endif
+    for( ; i < count; ++i )
+    {
+        const float2 uv = sample( sat, float2{xiX[i], xiY[i]} );
+        u[i] = uv.x;
+        v[i] = uv.y;
+        if( pdf != nullptr )
+            pdf[i] = getISummedAreaTablePdf( sat, uv );
+    }
+}
+
+#ifdef OTK_BATCH_USE_AVX2
+namespace otk {
+
+/// The AVX2 kernel of tentFilterBatch, which returns the number of samples it processed.
+OTK_BATCH_AVX2 inline int tentFilterBatchAVX2( int count, const float* xi, float* out )
+{
+    int i = 0;
+    const __m256 one = _mm256_set1_ps( 1.0f );
+    const __m256 two = _mm256_set1_ps( 2.0f );
+    for( ; i + OTK_BATCH_LANES <= count; i += OTK_BATCH_LANES )
+    {
+        const __m256 x     = _mm256_loadu_ps( &xi[i] );
+        const __m256 x2    = _mm256_mul_ps( x, two );
+        const __m256 lower = _mm256_add_ps( _mm256_set1_ps( -1.0f ), _mm256_sqrt_ps( x2 ) );
+        const __m256 upper = _mm256_sub_ps( one, _mm256_sqrt_ps( _mm256_sub_ps( two, x2 ) ) );
+        _mm256_storeu_ps( &out[i], _mm256_blendv_ps( upper, lower, _mm256_cmp_ps( x, _mm256_set1_ps( 0.5f ), _CMP_LT_OQ ) ) );
+    }
+    return i;
+}
+
+}  // namespace otk
+#endif
+
+/// Apply tentFilter to count values in [0,1), writing the results to out.
+inline void tentFilterBatch( int count, const float* xi, float* out )
+{
+    int i = 0;
+#ifdef OTK_BATCH_USE_AVX2
+    if( otk::batchHasAVX2() )
+        i = otk::tentFilterBatchAVX2( count, xi, out );
+#endif
+    for( ; i < count; ++i )
+        out[i] = tentFilter( xi[i] );
+}
+
+/// Apply boxMuller to count points (xiX, xiY), writing the Gaussian samples to (outX, outY).
+inline void boxMullerBatch( int count, const float* xiX, const float* xiY, float* outX, float* outY )
+{
+    for( int i = 0; i < count; ++i )
+    {
+        const float2 g = boxMuller( float2{xiX[i], xiY[i]} );
+        outX[i] = g.x;
+        outY[i] = g.y;
+    }
+}
+
+/// Apply sampleSharpenPos (or sampleSharpenNeg if negativeLobes is true) with the given kernel
+/// coefficients to count points (xiX, xiY), writing the results to (outX, outY).
+inline void sampleSharpenBatch( float4 posCoeff, float4 negCoeff, float negWeight, bool negativeLobes, int count,
+                                const float* xiX, const float* xiY, float* outX, float* outY )
+{
+    for( int i = 0; i < count; ++i )
+    {
+        const float2 xi = float2{xiX[i], xiY[i]};
+        const float2 s  = negativeLobes ? sampleSharpenNeg( posCoeff, negCoeff, negWeight, xi ) :
+                                          sampleSharpenPos( posCoeff, negCoeff, negWeight, xi );
+        outX[i] = s.x;
+        outY[i] = s.y;
+    }
+}
+
+/// Propagate count ray cones, stored as angle and width arrays, through the given distances.
+inline void propagateBatch( int count, float* angle, float* width, const float* distance )
+{
+    for( int i = 0; i < count; ++i )
+    {
+        const RayCone rc = propagate( RayCone{angle[i], width[i]}, distance[i] );
+        angle[i] = rc.angle;
+        width[i] = rc.width;
+    }
+}
+
+/// Update count ray cones, stored as angle and width arrays, for bsdf scattering events.
+inline void scatterBsdfBatch( int count, float* angle, float* width, const float* bsdfVal )
+{
+    for( int i = 0; i < count; ++i )
+    {
+        const RayCone rc = scatterBsdf( RayCone{angle[i], width[i]}, bsdfVal[i] );
+        angle[i] = rc.angle;
+        width[i] = rc.width;
+    }
+}
@@ -7,12 +7,14 @@
 /// \file CdfInversionTable.h
 /// Functions to invert and sample an environment map or other textured light source.
 
+#include <OptiXToolkit/ShaderUtil/HostParallel.h>
 #include <OptiXToolkit/ShaderUtil/Preprocessor.h>
 
 #include <cuda_runtime.h>
 
 #include <math.h>
 #include <cstdlib>
+#include <cstring>
 
 #ifndef CUDA_CHECK
 #define CUDA_CHECK( call )                                                                                                                                                                                                                                                             \
@@ -124,13 +126,21 @@ inline float invertPdf1D( float* pdf, int width )
     return sum;
 }
 
-/// Invert a 2D pdf (stored in cit.cdfRows) to a 2D cdf, along with its marginal
-inline void invertPdf2D( CdfInversionTable& cit )
+/// Invert a 2D pdf (stored in cit.cdfRows) to a 2D cdf, along with its marginal.  The rows are
+/// inverted in bands by numThreads threads (zero selects the number of hardware threads).  Each row
+/// is still summed in order, so the result does not depend on the number of threads.  If rowSums
+/// is not null, the unnormalized sums of the rows (height entries) are written to it, for use by
+/// updateCdfInversionTable.
+inline void invertPdf2D( CdfInversionTable& cit, int numThreads = 1, float* rowSums = nullptr )
 {
-    for( int j = 0; j < cit.height; ++j )
-    {
-        cit.cdfMarginal[j] = invertPdf1D( &cit.cdfRows[j * cit.width], cit.width );
-    }
+    otk::parallelBands( cit.height, otk::getHostBandCount( cit.height, numThreads ), [&cit]( int, int rowBegin, int rowEnd ) {
+        for( int j = rowBegin; j < rowEnd; ++j )
+        {
+            cit.cdfMarginal[j] = invertPdf1D( &cit.cdfRows[j * cit.width], cit.width );
+        }
+    } );
+    if( rowSums != nullptr )
+        memcpy( rowSums, cit.cdfMarginal, cit.height * sizeof( float ) );
     invertPdf1D( cit.cdfMarginal, cit.height );
 }
 
@@ -159,13 +169,50 @@ inline void invertCdf1D( float* cdf, int cdfWidth, unsigned short* invCdf, int i
     }
 }
 
-/// Invert a 2D cdf, along with its marginal
-inline void invertCdf2D( CdfInversionTable& cit )
+/// Invert a 2D cdf, along with its marginal.  The rows are inverted in bands by numThreads threads
+/// (zero selects the number of hardware threads), which does not change the result.
+inline void invertCdf2D( CdfInversionTable& cit, int numThreads = 1 )
+{
+    otk::parallelBands( cit.height, otk::getHostBandCount( cit.height, numThreads ), [&cit]( int, int rowBegin, int rowEnd ) {
+        for( int j = rowBegin; j < rowEnd; ++j )
+        {
+            invertCdf1D( &cit.cdfRows[j * cit.width], cit.width, &cit.invCdfRows[j * cit.width], cit.width );
+        }
+    } );
+    invertCdf1D( cit.cdfMarginal, cit.height, cit.invCdfMarginal, cit.height );
+}
+
+/// Update a CdfInversionTable made by invertPdf2D and invertCdf2D after the (unnormalized) pdf
+/// changed in rows y0..y1 (inclusive).  Normalizing a row changes all of its entries, so the touched
+/// rows are recomputed from the pdf in full, followed by the marginal, which is rebuilt from the row
+/// sums written by invertPdf2D (and updated here).  The result is identical to inverting the whole
+/// pdf again.  The rows are processed in bands by numThreads threads (zero selects the number of
+/// hardware threads).  If rowSums is null the whole table is rebuilt.
+inline void updateCdfInversionTable( CdfInversionTable& cit, float* rowSums, const float* pdf, int y0, int y1, int numThreads = 1 )
 {
-    for( int j = 0; j < cit.height; ++j )
+    if( rowSums == nullptr )
     {
-        invertCdf1D( &cit.cdfRows[j * cit.width], cit.width, &cit.invCdfRows[j * cit.width], cit.width );
+        memcpy( cit.cdfRows, pdf, cit.width * cit.height * sizeof( float ) );
+        invertPdf2D( cit, numThreads );
+        invertCdf2D( cit, numThreads );
+        return;
     }
+
+    y0 = ( y0 > 0 ) ? y0 : 0;
+    y1 = ( y1 < cit.height - 1 ) ? y1 : cit.height - 1;
+    const int numRows = y1 - y0 + 1;
+    otk::parallelBands( numRows, otk::getHostBandCount( numRows, numThreads ), [&]( int, int rowBegin, int rowEnd ) {
+        for( int j = y0 + rowBegin; j < y0 + rowEnd; ++j )
+        {
+            float* cdfRow = &cit.cdfRows[j * cit.width];
+            memcpy( cdfRow, &pdf[j * cit.width], cit.width * sizeof( float ) );
+            rowSums[j] = invertPdf1D( cdfRow, cit.width );
+            invertCdf1D( cdfRow, cit.width, &cit.invCdfRows[j * cit.width], cit.width );
+        }
+    } );
+
+    memcpy( cit.cdfMarginal, rowSums, cit.height * sizeof( float ) );
+    invertPdf1D( cit.cdfMarginal, cit.height );
     invertCdf1D( cit.cdfMarginal, cit.height, cit.invCdfMarginal, cit.height );
 }
 
@@ -202,6 +249,20 @@ OTK_INLINE OTK_HOSTDEVICE float2 sampleCdfBinSearch( CdfInversionTable& cit, flo
     return float2{x / cit.width, y / cit.height};
 }
 
+/// Get the pdf (over [0,1]^2) of the texel containing uv, which is the density of the binary and
+/// linear search samplers.  The direct lookup sampler approximates it.
+OTK_INLINE OTK_HOSTDEVICE float getCdfInversionTablePdf( CdfInversionTable& cit, float2 uv )
+{
+    int col = static_cast<int>( uv.x * cit.width );
+    int row = static_cast<int>( uv.y * cit.height );
+    col = ( col < cit.width - 1 ) ? ( col > 0 ? col : 0 ) : cit.width - 1;
+    row = ( row < cit.height - 1 ) ? ( row > 0 ? row : 0 ) : cit.height - 1;
+    const float* cdfRow = &cit.cdfRows[row * cit.width];
+    const float pdfX = ( cdfRow[col] - ( ( col > 0 ) ? cdfRow[col - 1] : 0.0f ) ) * cit.width;
+    const float pdfY = ( cit.cdfMarginal[row] - ( ( row > 0 ) ? cit.cdfMarginal[row - 1] : 0.0f ) ) * cit.height;
+    return pdfX * pdfY;
+}
+
 /// Sample a normalized 1D CDF by linear search
 OTK_INLINE OTK_HOSTDEVICE float sampleCdfLinSearch( float* cdf, unsigned short* invCdf, int width, float x )
 {
@@ -5,12 +5,15 @@
 #pragma once
 
 /// \file CubicFiltering.h
-/// Device-side functions for cubic filtering and sampling derivatives from a texture.
+/// Functions for cubic filtering and sampling derivatives from a texture.  The filter weights and
+/// gradient fixes are also compiled for the host, where imageSource::TexturePreviewSampler uses
+/// them; the texture fetches are device only.
 
-using namespace otk;
+#include <OptiXToolkit/ShaderUtil/vec_math.h>
 #include <OptiXToolkit/ShaderUtil/TextureUtil.h>
+using namespace otk;
 
-D_INLINE float4 cubicWeights( float x )
+OTK_INLINE OTK_HOSTDEVICE float4 cubicWeights( float x )
 {
     float4 weight;
     weight.x = -x*x*x      + 3.0f*x*x - 3.0f*x + 1.0f;
@@ -20,7 +23,7 @@ D_INLINE float4 cubicWeights( float x )
     return weight * (1.0f / 6.0f);
 }
 
-D_INLINE float4 cubicDerivativeWeights( float x )
+OTK_INLINE OTK_HOSTDEVICE float4 cubicDerivativeWeights( float x )
 {
     float4 weight;
     weight.x = -0.5f*x*x + x       - 0.5f;
@@ -30,25 +33,25 @@ D_INLINE float4 cubicDerivativeWeights( float x )
     return weight;
 }
 
-D_INLINE float4 linearWeights( float x )
+OTK_INLINE OTK_HOSTDEVICE float4 linearWeights( float x )
 {
     return float4{ 0.0f, 1.0f-x, x, 0.0f };
 }
 
-D_INLINE float4 linearDerivativeWeights( float x )
+OTK_INLINE OTK_HOSTDEVICE float4 linearDerivativeWeights( float x )
 {
     return float4{ x-1.0f, -x, 1.0f-x, x } * 0.5f; // finite difference
     //return float4{ 0.0f, -0.5f, 0.5f, 0.0f }; // actual linear derivative
 }
 
-D_INLINE float getPixelSpan( float2 ddx, float2 ddy, float width, float height )
+OTK_INLINE OTK_HOSTDEVICE float getPixelSpan( float2 ddx, float2 ddy, float width, float height )
 {
     float pixelSpanX = fmaxf( fabsf( ddx.x ), fabsf( ddy.x ) ) * width;
     float pixelSpanY = fmaxf( fabsf( ddx.y ), fabsf( ddy.y ) ) * height;
     return fmaxf( pixelSpanX, pixelSpanY ) + 1.0e-8f;
 }
 
-D_INLINE void fixGradients( float2& ddx, float2& ddy, int width, int height, int filterMode, bool conservative )
+OTK_INLINE OTK_HOSTDEVICE void fixGradients( float2& ddx, float2& ddy, int width, int height, int /*filterMode*/, bool conservative )
 {
     const float invAnisotropy = 1.0f / 16.0f; // FIXME: This should come from the texture
     const float invAniso2 = invAnisotropy * invAnisotropy;
@@ -87,6 +90,8 @@ D_INLINE void fixGradients( float2& ddx, float2& ddy, int width, int height, int
         ddy *= sqrtf( ddx2 / ( ddy2 * invAniso2 ) );
 }
 
+#ifdef __CUDACC__
+
 template <class TYPE> D_INLINE TYPE
 textureWeighted( CUtexObject texture, float i, float j, float4 wx, float4 wy, int mipLevel, int mipLevelWidth, int mipLevelHeight )
 {
@@ -245,3 +250,5 @@ textureCubic( CUtexObject texture, int texWidth, int texHeight,
             *dresultdt = lerp( drdt, *dresultdt, levelBlend );
     }
 }
+
+#endif // __CUDACC__
@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file HostParallel.h
+/// Helpers to split the host construction of sampling tables into bands processed by threads.
+
+#include <thread>
+#include <vector>
+
+namespace otk {
+
+/// Get the number of threads to use for a host table builder.  A numThreads of zero (or less)
+/// selects the number of hardware threads.
+inline int getHostThreadCount( int numThreads )
+{
+    if( numThreads > 0 )
+        return numThreads;
+    const int hardwareThreads = static_cast<int>( std::thread::hardware_concurrency() );
+    return hardwareThreads > 0 ? hardwareThreads : 1;
+}
+
+/// Get the number of bands to split count items into, given a numThreads argument.
+inline int getHostBandCount( int count, int numThreads )
+{
+    const int numBands = getHostThreadCount( numThreads );
+    return ( count < numBands ) ? ( count > 0 ? count : 1 ) : numBands;
+}
+
+/// Split the range [0,count) into numBands contiguous bands of nearly equal size, and call
+/// func( band, begin, end ) for each of them, concurrently when there is more than one band.
+/// A single band runs on the calling thread.
+template <class Func>
+void parallelBands( int count, int numBands, const Func& func )
+{
+    if( numBands <= 1 )
+    {
+        func( 0, 0, count );
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve( numBands - 1 );
+    for( int band = 1; band < numBands; ++band )
+    {
+        const int begin = static_cast<int>( static_cast<long long>( count ) * band / numBands );
+        const int end   = static_cast<int>( static_cast<long long>( count ) * ( band + 1 ) / numBands );
+        threads.emplace_back( [&func, band, begin, end]() { func( band, begin, end ); } );
+    }
+    func( 0, 0, static_cast<int>( static_cast<long long>( count ) / numBands ) );
+    for( std::thread& thread : threads )
+        thread.join();
+}
+
+}  // namespace otk
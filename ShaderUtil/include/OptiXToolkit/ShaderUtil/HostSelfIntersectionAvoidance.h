@@ -0,0 +1,139 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file HostSelfIntersectionAvoidance.h
+/// Host interface of Self Intersection Avoidance library, for tools that spawn rays from mesh
+/// surfaces on the CPU (light map baking, opacity micromap validation, ...).
+///
+/// The scalar functions follow the device implementation operation for operation, emulating its
+/// directed rounding exactly, so the host offsets carry the same error bounds.  The batched
+/// functions take structures of arrays and evaluate the same operations over whole batches, in loops
+/// the compiler vectorizes; their results are identical to the scalar functions.
+///
+/// Example use:
+///
+///     TriangleBatch triangles = { { v0x, v0y, v0z }, { v1x, v1y, v1z }, { v2x, v2y, v2z }, { baryU, baryV } };
+///     SpawnOffsetBatch spawn  = { { px, py, pz }, { nx, ny, nz }, offset };
+///
+///     // generate object space spawn points and offsets
+///     getSafeTriangleSpawnOffsetBatch( spawn, triangles, count );
+///
+///     // convert them to world space, in place, by the instance transform of each point
+///     transformSafeSpawnOffsetBatch( spawn, spawn, o2w, w2o, instanceIndices, count );
+///
+///     // offset the world space spawn points to self intersection safe front and back spawn points
+///     float* front[3] = { fx, fy, fz };
+///     float* back[3]  = { bx, by, bz };
+///     offsetSpawnPointBatch( front, back, spawn, count );
+///
+
+#include <OptiXToolkit/ShaderUtil/Preprocessor.h>
+#include <OptiXToolkit/ShaderUtil/Transform4.h>
+
+#include "SelfIntersectionAvoidanceTypes.h"
+
+namespace SelfIntersectionAvoidance {
+
+// Object space triangles and barycentric coordinates of a batch of spawn points, as structures of
+// arrays indexed by spawn point.  bary[0] and bary[1] are the weights of v1 and v2.
+struct TriangleBatch
+{
+    const float* v0[3];
+    const float* v1[3];
+    const float* v2[3];
+    const float* bary[2];
+};
+
+// Spawn points, unit length normals and safe offsets along the normals of a batch, as structures of
+// arrays indexed by spawn point.
+struct SpawnOffsetBatch
+{
+    float* position[3];
+    float* normal[3];
+    float* offset;
+};
+
+// Host version of getSafeTriangleSpawnOffset.
+//
+// \param[out] outPosition      base spawn position on the triangle, without the safe offset applied.
+// \param[out] outNormal        unit length triangle normal
+// \param[out] outOffset        offset along the triangle normal to avoid self intersection
+// \param[in]  v0               triangle vertex 0
+// \param[in]  v1               triangle vertex 1
+// \param[in]  v2               triangle vertex 2
+// \param[in]  bary             barycentric coordinates of spawn point
+inline void getSafeTriangleSpawnOffsetHost( float3&       outPosition,
+                                            float3&       outNormal,
+                                            float&        outOffset,
+                                            const float3& v0,
+                                            const float3& v1,
+                                            const float3& v2,
+                                            const float2& bary );
+
+// Host version of transformSafeSpawnOffset for a single instance transform.
+//
+// \paramp[out] outPosition     surface position in world space
+// \paramp[out] outNormal       unit length spawn point normal in world space
+// \paramp[out] outOffset       safe offset along normal in world space to avoid self intersection
+// \paramp[in]  inPosition      object space spawn point
+// \paramp[in]  inNormal        object space normal
+// \paramp[in]  inOffset        object space offset
+// \paramp[in]  o2w             object to world transform
+// \paramp[in]  w2o             world to object transform
+inline void transformSafeSpawnOffsetHost( float3&          outPosition,
+                                          float3&          outNormal,
+                                          float&           outOffset,
+                                          const float3&    inPosition,
+                                          const float3&    inNormal,
+                                          const float      inOffset,
+                                          const Matrix3x4& o2w,
+                                          const Matrix3x4& w2o );
+
+// Host version of offsetSpawnPoint.
+//
+// \param[out] outFront     offset spawn point on the front of the surface, safe from self intersection
+// \param[out] outBack      offset spawn point on the back of the surface, safe from self intersection
+// \param[in]  inPosition   spawn point on the surface
+// \param[in]  inNormal     surface normal
+// \param[in]  inOffset     safe offset to avoid self intersection
+inline void offsetSpawnPointHost( float3& outFront, float3& outBack, const float3& inPosition, const float3& inNormal, const float inOffset );
+
+// Generate spawn points and safe offsets on a batch of triangles, as getSafeTriangleSpawnOffsetHost.
+//
+// \param[out] out          spawn points, normals and offsets
+// \param[in]  triangles    triangle vertices and barycentric coordinates of the spawn points
+// \param[in]  count        number of spawn points
+inline void getSafeTriangleSpawnOffsetBatch( const SpawnOffsetBatch& out, const TriangleBatch& triangles, unsigned int count );
+
+// Transform a batch of object space spawn points and safe offsets into world space, as
+// transformSafeSpawnOffsetHost.  The output may alias the input.  The matrices are 4x4 homogeneous
+// transforms whose last row is ignored.
+//
+// \param[out] out              world space spawn points, normals and offsets
+// \param[in]  in               object space spawn points, normals and offsets
+// \param[in]  o2w              object to world transforms
+// \param[in]  w2o              world to object transforms
+// \param[in]  transformIndices index of the transform of each spawn point, or null to use the first transform for all
+// \param[in]  count            number of spawn points
+inline void transformSafeSpawnOffsetBatch( const SpawnOffsetBatch& out,
+                                           const SpawnOffsetBatch& in,
+                                           const otk::Transform4*  o2w,
+                                           const otk::Transform4*  w2o,
+                                           const unsigned int*     transformIndices,
+                                           unsigned int            count );
+
+// Offset a batch of spawn points to safe spawn points on either side of the surface, as
+// offsetSpawnPointHost.
+//
+// \param[out] outFront     x, y and z arrays of the front spawn points
+// \param[out] outBack      x, y and z arrays of the back spawn points
+// \param[in]  in           spawn points, normals and offsets
+// \param[in]  count        number of spawn points
+inline void offsetSpawnPointBatch( float* const outFront[3], float* const outBack[3], const SpawnOffsetBatch& in, unsigned int count );
+
+}  // namespace SelfIntersectionAvoidance
+
+#include "SelfIntersectionAvoidance/HostSelfIntersectionAvoidanceImpl.h"
@@ -6,10 +6,19 @@
 
 /// \file ISummedAreaTable.h
 
+#include <OptiXToolkit/ShaderUtil/HostParallel.h>
 #include <OptiXToolkit/ShaderUtil/Preprocessor.h>
 #include <math.h>
 #include <cuda_runtime.h>
 
+#include <cstring>
+#include <vector>
+
+#if !defined( __CUDA_ARCH__ ) && ( defined( __x86_64__ ) || defined( _M_X64 ) )
+#define OTK_SAT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 #ifndef CUDA_CHECK
 #define CUDA_CHECK( call )                                                                                                                                                                                                                                                             \
     {                                                                                                                                                                                                                                                                                  \
@@ -29,7 +38,7 @@ struct ISummedAreaTable
     int height;
     unsigned int* table;
     unsigned int* columnSums;
-    
+
     OTK_INLINE OTK_HOSTDEVICE unsigned int& val(int x, int y) { return table[y * width + x]; }
     OTK_INLINE OTK_HOSTDEVICE unsigned int* column(int x) { return &columnSums[x * height]; }
 };
@@ -74,57 +83,243 @@ inline cudaError_t copyToDevice( ISummedAreaTable& satHost, ISummedAreaTable& sa
     return cudaMemcpy( satDev.columnSums, satHost.columnSums, tableSize, cudaMemcpyHostToDevice );
 }
 
-/// Initialize a ISummedAreaTable for a pdf
-inline void initISummedAreaTable( ISummedAreaTable& sat, float* pdf )
+/// Replace a row of values by its inclusive prefix sums, modulo 2^32.
+inline void prefixSumRow( unsigned int* row, int width )
 {
-    double sum = 0.0;
-    int tableEntries = sat.width * sat.height;
-    for( int i = 0; i < tableEntries; ++i )
-        sum += pdf[i];
-    double scale = ( 0xffffffffU - tableEntries ) / sum;
+    int i = 0;
+    unsigned int carry = 0;
+#ifdef OTK_SAT_USE_SSE2
+    // Prefix sums of four values at a time within a register, plus the sum of the previous values.
+    __m128i carry4 = _mm_setzero_si128();
+    for( ; i + 4 <= width; i += 4 )
+    {
+        __m128i x = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &row[i] ) );
+        x = _mm_add_epi32( x, _mm_slli_si128( x, 4 ) );
+        x = _mm_add_epi32( x, _mm_slli_si128( x, 8 ) );
+        x = _mm_add_epi32( x, carry4 );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>( &row[i] ), x );
+        carry4 = _mm_shuffle_epi32( x, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+    }
+    carry = static_cast<unsigned int>( _mm_cvtsi128_si32( carry4 ) );
+#endif
+    for( ; i < width; ++i )
+    {
+        carry += row[i];
+        row[i] = carry;
+    }
+}
 
-    // Make summed area table
-    for( int j = 0; j < sat.height; ++j )
+/// Initialize a ISummedAreaTable from integer values, where value( x, y ) returns the value of
+/// entry (x,y).  The values plus one per entry must sum to at most 0xffffffff.  The work is split
+/// into bands of rows (and of columns for the column sums) processed by numThreads threads, with
+/// zero selecting the number of hardware threads.  The table entries are integer sums modulo 2^32,
+/// so they do not depend on the number of threads.
+template <typename ValueFunc>
+inline void initISummedAreaTableValues( ISummedAreaTable& sat, const ValueFunc& value, int numThreads = 1 )
+{
+    const int rowBands = otk::getHostBandCount( sat.height, numThreads );
+
+    // Make the summed area table of each band of rows, as prefix sums of each row (making sure
+    // each table entry has a positive value) accumulated down the band.
+    std::vector<int> bandStarts( rowBands + 1, sat.height );
+    otk::parallelBands( sat.height, rowBands, [&]( int band, int rowBegin, int rowEnd ) {
+        bandStarts[band] = rowBegin;
+        for( int j = rowBegin; j < rowEnd; ++j )
+        {
+            unsigned int* row = &sat.val( 0, j );
+            for( int i = 0; i < sat.width; ++i )
+                row[i] = 1 + value( i, j );
+            prefixSumRow( row, sat.width );
+            if( j > rowBegin )
+            {
+                const unsigned int* prevRow = &sat.val( 0, j - 1 );
+                for( int i = 0; i < sat.width; ++i )
+                    row[i] += prevRow[i];
+            }
+        }
+    } );
+
+    // Each band is offset by the last row of the previous bands, which is accumulated serially
+    // (one row per band) and then added to the bands in parallel.
+    if( rowBands > 1 )
     {
-        for( int i = 0; i < sat.width; ++i )
+        std::vector<unsigned int> offsets( static_cast<size_t>( rowBands ) * sat.width, 0 );
+        for( int band = 1; band < rowBands; ++band )
         {
-            // Make sure each table entry has a positive value
-            unsigned int val = 1 + static_cast<unsigned int>( pdf[ j * sat.width + i ] * scale );
-            if( i > 0 ) val += sat.val( i - 1, j );
-            if( i > 0 && j > 0 ) val -= sat.val( i - 1, j - 1 );
-            if( j > 0 ) val += sat.val( i, j - 1 );
-            sat.val( i, j ) = val;
+            const unsigned int* lastRow = &sat.val( 0, bandStarts[band] - 1 );
+            const unsigned int* prevOffset = &offsets[static_cast<size_t>( band - 1 ) * sat.width];
+            unsigned int*       offset = &offsets[static_cast<size_t>( band ) * sat.width];
+            for( int i = 0; i < sat.width; ++i )
+                offset[i] = prevOffset[i] + lastRow[i];
         }
+        otk::parallelBands( sat.height, rowBands, [&]( int band, int rowBegin, int rowEnd ) {
+            const unsigned int* offset = &offsets[static_cast<size_t>( band ) * sat.width];
+            for( int j = ( band > 0 ) ? rowBegin : rowEnd; j < rowEnd; ++j )
+            {
+                unsigned int* row = &sat.val( 0, j );
+                for( int i = 0; i < sat.width; ++i )
+                    row[i] += offset[i];
+            }
+        } );
     }
 
-    // Transpose pdf to sums by blocks
+    // Transpose the values to column sums by blocks, in bands of columns, accumulating the sums as the
+    // blocks are written.
     const int blockSize = 8;
-    for( int ystart = 0; ystart < sat.height; ystart += blockSize )
-    {
-        for( int xstart = 0; xstart < sat.width; xstart += blockSize )
+    const int columnBlocks = ( sat.width + blockSize - 1 ) / blockSize;
+    otk::parallelBands( columnBlocks, otk::getHostBandCount( columnBlocks, numThreads ), [&]( int, int blockBegin, int blockEnd ) {
+        const int xbegin = blockBegin * blockSize;
+        const int xend = ( sat.width < blockEnd * blockSize ) ? sat.width : blockEnd * blockSize;
+        std::vector<unsigned int> runningSums( xend - xbegin, 0 );
+        for( int ystart = 0; ystart < sat.height; ystart += blockSize )
         {
-            // Transpose a block
-            int xend = ( sat.width < xstart + blockSize ) ? sat.width : xstart + blockSize;
-            int yend = ( sat.height < ystart + blockSize ) ? sat.height : ystart + blockSize;
-            for( int y = ystart; y < yend; ++y )
+            const int yend = ( sat.height < ystart + blockSize ) ? sat.height : ystart + blockSize;
+            for( int xstart = xbegin; xstart < xend; xstart += blockSize )
             {
-                for( int x = xstart; x < xend; ++x )
+                // Transpose a block
+                const int xblockEnd = ( xend < xstart + blockSize ) ? xend : xstart + blockSize;
+                for( int y = ystart; y < yend; ++y )
                 {
-                    sat.columnSums[ x * sat.height + y ] = static_cast<unsigned int>( pdf[ y * sat.width + x ] * scale );
+                    for( int x = xstart; x < xblockEnd; ++x )
+                    {
+                        unsigned int& runningSum = runningSums[x - xbegin];
+                        runningSum += value( x, y );
+                        sat.columnSums[ x * sat.height + y ] = runningSum;
+                    }
                 }
             }
         }
+    } );
+}
+
+/// Initialize a ISummedAreaTable for a pdf, whose values are converted to integers by multiplying
+/// them by scale.  The scaled pdf plus one per entry must sum to at most 0xffffffff.
+inline void initISummedAreaTableWithScale( ISummedAreaTable& sat, const float* pdf, double scale, int numThreads = 1 )
+{
+    const int width = sat.width;
+    initISummedAreaTableValues(
+        sat, [pdf, scale, width]( int x, int y ) { return static_cast<unsigned int>( pdf[y * width + x] * scale ); }, numThreads );
+}
+
+/// Sum a width x height pdf in bands of rows processed by numThreads threads, combining the partial
+/// sums in band order.
+inline double sumISummedAreaTablePdf( const float* pdf, int width, int height, int numThreads )
+{
+    const int rowBands = otk::getHostBandCount( height, numThreads );
+    std::vector<double> bandSums( rowBands, 0.0 );
+    otk::parallelBands( height, rowBands, [&]( int band, int rowBegin, int rowEnd ) {
+        double bandSum = 0.0;
+        for( int i = rowBegin * width; i < rowEnd * width; ++i )
+            bandSum += pdf[i];
+        bandSums[band] = bandSum;
+    } );
+    double sum = 0.0;
+    for( int band = 0; band < rowBands; ++band )
+        sum += bandSums[band];
+    return sum;
+}
+
+/// Initialize a ISummedAreaTable for a pdf, scaling it to fill the integer range of the entries
+/// divided by headroom, and return the scale.  Callers that update the table keep the scale for
+/// updateISummedAreaTable.  A headroom above 1 lets updates brighten the pdf without rebuilding the
+/// table.  The work is split into bands of rows processed by numThreads threads, with zero
+/// selecting the number of hardware threads.  With a single thread the result is identical to a
+/// serial build; otherwise the double precision sum of the pdf used to scale the entries can round
+/// differently, which can change entries by a few units.
+inline double initISummedAreaTable( ISummedAreaTable& sat, float* pdf, int numThreads = 1, double headroom = 1.0 )
+{
+    const int tableEntries = sat.width * sat.height;
+    const double sum = sumISummedAreaTablePdf( pdf, sat.width, sat.height, numThreads );
+    const double scale = ( 0xffffffffU - tableEntries ) / ( sum * headroom );
+    initISummedAreaTableWithScale( sat, pdf, scale, numThreads );
+    return scale;
+}
+
+/// Update a ISummedAreaTable after the pdf changed within the rectangle [x0,x1] x [y0,y1]
+/// (inclusive), keeping the scale returned by the last build.  Only the table entries below and to
+/// the right of (x0,y0), and the column sums of columns x0..x1 from row y0 down, change, so the
+/// cost is proportional to that suffix of the table rather than to the whole table (see
+/// BlockedSummedAreaTable for a bounded cost).  If the updated pdf no longer fits the integer
+/// range of the entries, or has lost most of its precision by getting much darker, the table is
+/// rebuilt with a headroom of 2 instead, scale is set to the new scale, and the function returns
+/// false.
+inline bool updateISummedAreaTable( ISummedAreaTable& sat, double& scale, float* pdf, int x0, int y0, int x1, int y1, int numThreads = 1 )
+{
+    x0 = ( x0 > 0 ) ? x0 : 0;
+    y0 = ( y0 > 0 ) ? y0 : 0;
+    x1 = ( x1 < sat.width - 1 ) ? x1 : sat.width - 1;
+    y1 = ( y1 < sat.height - 1 ) ? y1 : sat.height - 1;
+    if( x0 > x1 || y0 > y1 )
+        return true;
+
+    // Find the change of each scaled pdf value in the rectangle, using the column sums to recover
+    // the old values.
+    const int rectWidth = x1 - x0 + 1;
+    std::vector<unsigned int> deltas( static_cast<size_t>( rectWidth ) * ( y1 - y0 + 1 ) );
+    long long totalDelta = 0;
+    bool fits = true;
+    for( int x = x0; x <= x1; ++x )
+    {
+        const unsigned int* column = sat.column( x );
+        unsigned int prevSum = ( y0 > 0 ) ? column[y0 - 1] : 0;
+        for( int y = y0; y <= y1; ++y )
+        {
+            const double scaled = pdf[y * sat.width + x] * scale;
+            fits = fits && scaled < 4294967296.0;
+            const unsigned int newValue = fits ? static_cast<unsigned int>( scaled ) : 0;
+            const unsigned int oldValue = column[y] - prevSum;
+            prevSum = column[y];
+            deltas[static_cast<size_t>( y - y0 ) * rectWidth + ( x - x0 )] = newValue - oldValue;
+            totalDelta += static_cast<long long>( newValue ) - static_cast<long long>( oldValue );
+        }
+    }
+
+    const long long total = static_cast<long long>( sat.val( sat.width - 1, sat.height - 1 ) ) + totalDelta;
+    if( !fits || total > 0xffffffffLL || total < 0x10000000LL )
+    {
+        scale = initISummedAreaTable( sat, pdf, numThreads, 2.0 );
+        return false;
     }
 
-    // Make column sums
-    for( int i = 0; i < sat.width; ++i )
+    // Accumulate the prefix sums of the delta rows down the rectangle, adding them to the table
+    // rows as they go.  Below the rectangle every row changes by the same amounts.
+    const int suffixWidth = sat.width - x0;
+    std::vector<unsigned int> rowDelta( suffixWidth, 0 );
+    std::vector<unsigned int> accumulated( suffixWidth, 0 );
+    for( int y = y0; y <= y1; ++y )
     {
-        unsigned int* column = sat.column(i);
-        for( int j = 1; j < sat.height; ++j )
+        memcpy( rowDelta.data(), &deltas[static_cast<size_t>( y - y0 ) * rectWidth], rectWidth * sizeof( unsigned int ) );
+        prefixSumRow( rowDelta.data(), rectWidth );
+        unsigned int* row = &sat.val( x0, y );
+        for( int i = 0; i < suffixWidth; ++i )
         {
-            column[j] += column[j-1];
+            accumulated[i] += rowDelta[( i < rectWidth ) ? i : rectWidth - 1];
+            row[i] += accumulated[i];
         }
     }
+    const int rowsBelow = sat.height - 1 - y1;
+    otk::parallelBands( rowsBelow, otk::getHostBandCount( rowsBelow, numThreads ), [&]( int, int rowBegin, int rowEnd ) {
+        for( int y = y1 + 1 + rowBegin; y < y1 + 1 + rowEnd; ++y )
+        {
+            unsigned int* row = &sat.val( x0, y );
+            for( int i = 0; i < suffixWidth; ++i )
+                row[i] += accumulated[i];
+        }
+    } );
+
+    // Accumulate the deltas down the columns of the rectangle.
+    for( int x = x0; x <= x1; ++x )
+    {
+        unsigned int* column = sat.column( x );
+        unsigned int runningDelta = 0;
+        for( int y = y0; y < sat.height; ++y )
+        {
+            if( y <= y1 )
+                runningDelta += deltas[static_cast<size_t>( y - y0 ) * rectWidth + ( x - x0 )];
+            column[y] += runningDelta;
+        }
+    }
+    return true;
 }
 
 /// Get Rectangle Sum in a ISummedAreaTable
@@ -218,3 +413,211 @@ OTK_INLINE OTK_HOSTDEVICE float2 sample( ISummedAreaTable& sat, float2 xi )
 {
     return sampleRect( sat, 0, 0, sat.width-1, sat.height-1, xi );
 }
+
+/// Get the density of a sample uv of the whole ISummedAreaTable, relative to a uniform density of
+/// one.  The column is chosen by the row sums, which count one extra per entry, and the row by the
+/// column sums, as sample does.
+OTK_INLINE OTK_HOSTDEVICE float getISummedAreaTablePdf( ISummedAreaTable& sat, float2 uv )
+{
+    int col = static_cast<int>( uv.x * sat.width );
+    int row = static_cast<int>( uv.y * sat.height );
+    col = ( col < sat.width - 1 ) ? ( col > 0 ? col : 0 ) : sat.width - 1;
+    row = ( row < sat.height - 1 ) ? ( row > 0 ? row : 0 ) : sat.height - 1;
+    const unsigned int* lastRow = &sat.val( 0, sat.height - 1 );
+    const unsigned int* column = sat.column( col );
+    const unsigned int columnWeight = lastRow[col] - ( ( col > 0 ) ? lastRow[col - 1] : 0 );
+    const unsigned int columnTotal = column[sat.height - 1];
+    const unsigned int value = column[row] - ( ( row > 0 ) ? column[row - 1] : 0 );
+    const float pdfX = static_cast<float>( columnWeight ) / static_cast<float>( lastRow[sat.width - 1] ) * sat.width;
+    const float pdfY = ( columnTotal > 0 ) ? static_cast<float>( value ) / static_cast<float>( columnTotal ) * sat.height : 1.0f;
+    return pdfX * pdfY;
+}
+
+/// A summed area table split into square blocks, each with its own ISummedAreaTable, plus a coarse
+/// ISummedAreaTable over the block totals.  Sampling picks a block from the coarse table and
+/// reuses the position within the chosen coarse entry to sample the block.  An update of a dirty
+/// rectangle rebuilds only the blocks it touches and the coarse table, so its cost is bounded by
+/// the rectangle size plus the number of blocks, wherever the rectangle lies.
+struct BlockedSummedAreaTable
+{
+    int width;
+    int height;
+    int blockSize;
+    ISummedAreaTable blockSums;  // one entry per block
+    unsigned int* table;         // blockSize * blockSize entries per block, blocks in row-major order
+    unsigned int* columnSums;
+
+    /// Return the table of block (bx,by).  Blocks on the right and bottom edges may be smaller.
+    OTK_INLINE OTK_HOSTDEVICE ISummedAreaTable block( int bx, int by ) const
+    {
+        const int offset = ( by * blockSums.width + bx ) * blockSize * blockSize;
+        const int w = ( width - bx * blockSize < blockSize ) ? width - bx * blockSize : blockSize;
+        const int h = ( height - by * blockSize < blockSize ) ? height - by * blockSize : blockSize;
+        return ISummedAreaTable{ w, h, &table[offset], &columnSums[offset] };
+    }
+};
+
+/// Allocate the BlockedSummedAreaTable on the host
+inline void allocBlockedSummedAreaTableHost( BlockedSummedAreaTable& bsat, int width, int height, int blockSize = 64 )
+{
+    bsat.width = width;
+    bsat.height = height;
+    bsat.blockSize = blockSize;
+    allocISummedAreaTableHost( bsat.blockSums, ( width + blockSize - 1 ) / blockSize, ( height + blockSize - 1 ) / blockSize );
+    const size_t entries = static_cast<size_t>( bsat.blockSums.width ) * bsat.blockSums.height * blockSize * blockSize;
+    bsat.table = reinterpret_cast<unsigned int*>( malloc( entries * sizeof(unsigned int) ) );
+    bsat.columnSums = reinterpret_cast<unsigned int*>( malloc( entries * sizeof(unsigned int) ) );
+}
+
+/// Free the BlockedSummedAreaTable on the host
+inline void freeBlockedSummedAreaTableHost( BlockedSummedAreaTable& bsat )
+{
+    freeISummedAreaTableHost( bsat.blockSums );
+    free( bsat.table );
+    free( bsat.columnSums );
+}
+
+/// Allocate the BlockedSummedAreaTable on the device
+inline cudaError_t allocBlockedSummedAreaTableDevice( BlockedSummedAreaTable& bsat, int width, int height, int blockSize = 64 )
+{
+    bsat.width = width;
+    bsat.height = height;
+    bsat.blockSize = blockSize;
+    CUDA_CHECK( allocISummedAreaTableDevice( bsat.blockSums, ( width + blockSize - 1 ) / blockSize, ( height + blockSize - 1 ) / blockSize ) );
+    const size_t entries = static_cast<size_t>( bsat.blockSums.width ) * bsat.blockSums.height * blockSize * blockSize;
+    CUDA_CHECK( cudaMalloc( &bsat.table, entries * sizeof(unsigned int) ) );
+    return cudaMalloc( &bsat.columnSums, entries * sizeof(unsigned int) );
+}
+
+/// Free the BlockedSummedAreaTable on the device
+inline cudaError_t freeBlockedSummedAreaTableDevice( BlockedSummedAreaTable& bsat )
+{
+    CUDA_CHECK( freeISummedAreaTableDevice( bsat.blockSums ) );
+    CUDA_CHECK( cudaFree( bsat.table ) );
+    return cudaFree( bsat.columnSums );
+}
+
+/// Copy BlockedSummedAreaTable data from the host to the device
+inline cudaError_t copyToDevice( BlockedSummedAreaTable& bsatHost, BlockedSummedAreaTable& bsatDev )
+{
+    CUDA_CHECK( copyToDevice( bsatHost.blockSums, bsatDev.blockSums ) );
+    const size_t entries = static_cast<size_t>( bsatHost.blockSums.width ) * bsatHost.blockSums.height * bsatHost.blockSize * bsatHost.blockSize;
+    CUDA_CHECK( cudaMemcpy( bsatDev.table, bsatHost.table, entries * sizeof( unsigned int ), cudaMemcpyHostToDevice ) );
+    return cudaMemcpy( bsatDev.columnSums, bsatHost.columnSums, entries * sizeof( unsigned int ), cudaMemcpyHostToDevice );
+}
+
+/// Rebuild the tables of blocks [bx0,bx1] x [by0,by1] (inclusive) from the pdf with the given scale,
+/// distributing the blocks over numThreads threads.
+inline void initBlockedSummedAreaTableBlocks( BlockedSummedAreaTable& bsat, const float* pdf, double scale, int bx0, int by0, int bx1, int by1, int numThreads )
+{
+    const int blocksWide = bx1 - bx0 + 1;
+    const int numBlocks = blocksWide * ( by1 - by0 + 1 );
+    otk::parallelBands( numBlocks, otk::getHostBandCount( numBlocks, numThreads ), [&]( int, int begin, int end ) {
+        for( int b = begin; b < end; ++b )
+        {
+            const int bx = bx0 + b % blocksWide;
+            const int by = by0 + b / blocksWide;
+            ISummedAreaTable block = bsat.block( bx, by );
+            const float* origin = &pdf[static_cast<size_t>( by * bsat.blockSize ) * bsat.width + bx * bsat.blockSize];
+            const int width = bsat.width;
+            initISummedAreaTableValues( block, [origin, scale, width]( int x, int y ) {
+                return static_cast<unsigned int>( origin[y * width + x] * scale );
+            } );
+        }
+    } );
+}
+
+/// Rebuild the coarse table of a BlockedSummedAreaTable from the totals of its blocks.
+inline void initBlockedSummedAreaTableBlockSums( BlockedSummedAreaTable& bsat )
+{
+    initISummedAreaTableValues( bsat.blockSums, [&bsat]( int bx, int by ) {
+        const ISummedAreaTable block = bsat.block( bx, by );
+        return block.table[block.width * block.height - 1];
+    } );
+}
+
+/// Initialize a BlockedSummedAreaTable for a pdf, whose values are converted to integers by
+/// multiplying them by scale.  The scaled pdf plus one per entry and one per block must sum to at
+/// most 0xffffffff.  The blocks are distributed over numThreads threads, with zero selecting the
+/// number of hardware threads.
+inline void initBlockedSummedAreaTableWithScale( BlockedSummedAreaTable& bsat, const float* pdf, double scale, int numThreads = 1 )
+{
+    initBlockedSummedAreaTableBlocks( bsat, pdf, scale, 0, 0, bsat.blockSums.width - 1, bsat.blockSums.height - 1, numThreads );
+    initBlockedSummedAreaTableBlockSums( bsat );
+}
+
+/// Initialize a BlockedSummedAreaTable for a pdf, scaling it to fill the integer range of the
+/// entries divided by headroom, and return the scale, as initISummedAreaTable does.
+inline double initBlockedSummedAreaTable( BlockedSummedAreaTable& bsat, float* pdf, int numThreads = 1, double headroom = 1.0 )
+{
+    const int entries = bsat.width * bsat.height + bsat.blockSums.width * bsat.blockSums.height;
+    const double sum = sumISummedAreaTablePdf( pdf, bsat.width, bsat.height, numThreads );
+    const double scale = ( 0xffffffffU - entries ) / ( sum * headroom );
+    initBlockedSummedAreaTableWithScale( bsat, pdf, scale, numThreads );
+    return scale;
+}
+
+/// Update a BlockedSummedAreaTable after the pdf changed within the rectangle [x0,x1] x [y0,y1]
+/// (inclusive), keeping the scale returned by the last build.  Only the blocks overlapping the
+/// rectangle and the coarse table are rebuilt.  As with updateISummedAreaTable, a pdf that no
+/// longer fits the entries, or has gotten much darker, rebuilds the whole table with a headroom of
+/// 2, sets scale to the new scale, and returns false.
+inline bool updateBlockedSummedAreaTable( BlockedSummedAreaTable& bsat, double& scale, float* pdf, int x0, int y0, int x1, int y1, int numThreads = 1 )
+{
+    x0 = ( x0 > 0 ) ? x0 : 0;
+    y0 = ( y0 > 0 ) ? y0 : 0;
+    x1 = ( x1 < bsat.width - 1 ) ? x1 : bsat.width - 1;
+    y1 = ( y1 < bsat.height - 1 ) ? y1 : bsat.height - 1;
+    if( x0 > x1 || y0 > y1 )
+        return true;
+
+    // Find the new total of the touched blocks, replacing their old totals.
+    const int bx0 = x0 / bsat.blockSize;
+    const int by0 = y0 / bsat.blockSize;
+    const int bx1 = x1 / bsat.blockSize;
+    const int by1 = y1 / bsat.blockSize;
+    long long total = static_cast<long long>( bsat.blockSums.val( bsat.blockSums.width - 1, bsat.blockSums.height - 1 ) );
+    bool fits = true;
+    for( int by = by0; by <= by1; ++by )
+    {
+        for( int bx = bx0; bx <= bx1; ++bx )
+        {
+            const ISummedAreaTable block = bsat.block( bx, by );
+            total -= block.table[block.width * block.height - 1];
+            const float* origin = &pdf[static_cast<size_t>( by * bsat.blockSize ) * bsat.width + bx * bsat.blockSize];
+            for( int y = 0; y < block.height; ++y )
+            {
+                for( int x = 0; x < block.width; ++x )
+                {
+                    const double scaled = origin[y * bsat.width + x] * scale;
+                    fits = fits && scaled < 4294967296.0;
+                    total += 1 + ( fits ? static_cast<long long>( scaled ) : 0 );
+                }
+            }
+        }
+    }
+    if( !fits || total > 0xffffffffLL || total < 0x10000000LL )
+    {
+        scale = initBlockedSummedAreaTable( bsat, pdf, numThreads, 2.0 );
+        return false;
+    }
+
+    initBlockedSummedAreaTableBlocks( bsat, pdf, scale, bx0, by0, bx1, by1, numThreads );
+    initBlockedSummedAreaTableBlockSums( bsat );
+    return true;
+}
+
+/// Compute a sample location within the BlockedSummedAreaTable
+OTK_INLINE OTK_HOSTDEVICE float2 sample( BlockedSummedAreaTable& bsat, float2 xi )
+{
+    // Choose a block, keeping the position within it as the sample within the block.
+    ISummedAreaTable& blockSums = bsat.blockSums;
+    const float x = findColumnInRect( blockSums, 0, 0, blockSums.width - 1, blockSums.height - 1, fminf( xi.x, 0.999999f ) );
+    const int bx = ( static_cast<int>( x ) < blockSums.width - 1 ) ? static_cast<int>( x ) : blockSums.width - 1;
+    const float y = findRowInColumn( blockSums, bx, 0, blockSums.height - 1, fminf( xi.y, 0.999999f ) );
+    const int by = ( static_cast<int>( y ) < blockSums.height - 1 ) ? static_cast<int>( y ) : blockSums.height - 1;
+
+    ISummedAreaTable block = bsat.block( bx, by );
+    const float2 s = sample( block, float2{ x - bx, y - by } );
+    return float2{ ( bx * bsat.blockSize + s.x * block.width ) / bsat.width, ( by * bsat.blockSize + s.y * block.height ) / bsat.height };
+}
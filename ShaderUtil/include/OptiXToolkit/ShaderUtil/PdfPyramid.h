@@ -0,0 +1,356 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file PdfPyramid.h
+/// Hierarchical sampling of a 2D pdf (such as an environment map) from a mip pyramid.
+
+#include <OptiXToolkit/ShaderUtil/HostParallel.h>
+#include <OptiXToolkit/ShaderUtil/Preprocessor.h>
+
+#include <cuda_runtime.h>
+
+#include <math.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifndef CUDA_CHECK
+#define CUDA_CHECK( call )                                                                                                                                                                                                                                                             \
+    {                                                                                                                                                                                                                                                                                  \
+        cudaError_t error = call;                                                                                                                                                                                                                                                      \
+        if( error != cudaSuccess )                                                                                                                                                                                                                                                     \
+        {                                                                                                                                                                                                                                                                              \
+            return error;                                                                                                                                                                                                                                             \
+        }                                                                                                                                                                                                                                                                              \
+    }
+#endif
+
+/// A mip pyramid of a pdf for hierarchical sample warping.  The coarsest (top) level is sampled with
+/// a small 2D cdf.  Each finer level stores, for every texel of the level above it, the fractions
+/// of its value held by its 2x2 children, grouped by parent and encoded as 16 bit floats with 12
+/// significant bits, so a level costs 2 bytes per texel (about 2.7 bytes per texel of the finest
+/// level in all, compared to 6 for a CdfInversionTable and 8 for an ISummedAreaTable).
+///
+/// A sample descends the levels, choosing a child column and then a row with the two components of
+/// the sample, which are rescaled at each step, so the warp is continuous and preserves
+/// stratification.  The pdf is piecewise constant over the texels of the finest level, and the pdf
+/// evaluated by evalPdfPyramid is exactly the density of the samples, since it is the product of
+/// the (encoded) fractions used to warp them.  It matches the input pdf to about 1e-4 relative
+/// error per level, except that nonzero fractions are at least 2^-16, so that every texel with a
+/// nonzero pdf can be sampled.
+struct PdfPyramid
+{
+    int width;  // finest level
+    int height;
+    int topWidth;  // coarsest level
+    int topHeight;
+    int numLevels;  // number of levels below the top
+    float* topCdfRows;  // (topWidth x topHeight) normalized cdf of each top row
+    float* topCdfMarginal;  // (topHeight) normalized cdf of the top rows
+    unsigned short* fractions;  // 4 encoded child fractions per parent texel, for the levels below the top
+};
+
+/// Get the number of fractions stored by a PdfPyramid
+inline size_t getPdfPyramidNumFractions( const PdfPyramid& pp )
+{
+    // The levels below the top hold 4, 16, 64, ... times as many texels as the top.
+    size_t numFractions = 0;
+    size_t levelSize = static_cast<size_t>( pp.topWidth ) * pp.topHeight;
+    for( int level = 0; level < pp.numLevels; ++level )
+    {
+        levelSize *= 4;
+        numFractions += levelSize;
+    }
+    return numFractions;
+}
+
+/// Set the dimensions of a PdfPyramid for a pdf of the given size.  The top level is the coarsest
+/// level that is at least topWidth x topHeight, halving the dimensions while both remain even.
+inline void setPdfPyramidSize( PdfPyramid& pp, int width, int height, int topWidth, int topHeight )
+{
+    pp.width = width;
+    pp.height = height;
+    pp.numLevels = 0;
+    while( width % 2 == 0 && height % 2 == 0 && width / 2 >= topWidth && height / 2 >= topHeight )
+    {
+        width /= 2;
+        height /= 2;
+        pp.numLevels++;
+    }
+    pp.topWidth = width;
+    pp.topHeight = height;
+}
+
+/// Allocate the PdfPyramid on the host
+inline void allocPdfPyramidHost( PdfPyramid& pp, int width, int height, int topWidth, int topHeight )
+{
+    setPdfPyramidSize( pp, width, height, topWidth, topHeight );
+    pp.topCdfRows = (float*) malloc( pp.topWidth * pp.topHeight * sizeof(float) );
+    pp.topCdfMarginal = (float*) malloc( pp.topHeight * sizeof(float) );
+    pp.fractions = (unsigned short*) malloc( getPdfPyramidNumFractions( pp ) * sizeof(unsigned short) );
+}
+
+/// Free the PdfPyramid on the host
+inline void freePdfPyramidHost( PdfPyramid& pp )
+{
+    free( pp.topCdfRows );
+    free( pp.topCdfMarginal );
+    free( pp.fractions );
+}
+
+/// Allocate the PdfPyramid on the device
+inline cudaError_t allocPdfPyramidDevice( PdfPyramid& pp, int width, int height, int topWidth, int topHeight )
+{
+    setPdfPyramidSize( pp, width, height, topWidth, topHeight );
+    CUDA_CHECK( cudaMalloc( &pp.topCdfRows, pp.topWidth * pp.topHeight * sizeof(float) ) );
+    CUDA_CHECK( cudaMalloc( &pp.topCdfMarginal, pp.topHeight * sizeof(float) ) );
+    return cudaMalloc( &pp.fractions, getPdfPyramidNumFractions( pp ) * sizeof(unsigned short) );
+}
+
+/// Free the PdfPyramid on the device
+inline cudaError_t freePdfPyramidDevice( PdfPyramid& pp )
+{
+    CUDA_CHECK( cudaFree( pp.topCdfRows ) );
+    CUDA_CHECK( cudaFree( pp.topCdfMarginal ) );
+    return cudaFree( pp.fractions );
+}
+
+/// Copy PdfPyramid data from the host to the device
+inline cudaError_t copyToDevice( PdfPyramid& ppHost, PdfPyramid& ppDev )
+{
+    const size_t topSize = ppHost.topWidth * ppHost.topHeight;
+    CUDA_CHECK( cudaMemcpy( ppDev.topCdfRows, ppHost.topCdfRows, topSize * sizeof(float), cudaMemcpyHostToDevice ) );
+    CUDA_CHECK( cudaMemcpy( ppDev.topCdfMarginal, ppHost.topCdfMarginal, ppHost.topHeight * sizeof(float), cudaMemcpyHostToDevice ) );
+    return cudaMemcpy( ppDev.fractions, ppHost.fractions, getPdfPyramidNumFractions( ppHost ) * sizeof(unsigned short), cudaMemcpyHostToDevice );
+}
+
+/// Encode a fraction in [0,1] as a 16 bit float with 12 significant bits.  Nonzero fractions are
+/// at least 2^-16, and zero encodes as zero.
+inline unsigned short encodePdfPyramidFraction( double fraction )
+{
+    if( fraction <= 0.0 )
+        return 0;
+    const float value = static_cast<float>( fraction > 1.0 / 65536.0 ? fraction : 1.0 / 65536.0 );
+    unsigned int bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    // Round the mantissa to 11 bits, and offset the exponent so that 2^-16 encodes as 1.
+    return static_cast<unsigned short>( ( ( bits + 0x800U ) >> 12 ) - ( 111U << 11 ) + 1U );
+}
+
+/// Decode a fraction encoded by encodePdfPyramidFraction
+OTK_INLINE OTK_HOSTDEVICE float decodePdfPyramidFraction( unsigned short code )
+{
+    const unsigned int bits = code ? ( code - 1U + ( 111U << 11 ) ) << 12 : 0U;
+#ifdef __CUDA_ARCH__
+    return __uint_as_float( bits );
+#else
+    float value;
+    memcpy( &value, &bits, sizeof( value ) );
+    return value;
+#endif
+}
+
+/// Make a normalized cdf in place from non-negative values, returning their sum.  A zero sum makes
+/// a uniform cdf.
+inline double makePdfPyramidCdf( float* cdf, int width )
+{
+    double sum = 0.0;
+    for( int i = 0; i < width; ++i )
+        sum += cdf[i];
+    double partialSum = 0.0;
+    for( int i = 0; i < width; ++i )
+    {
+        partialSum += ( sum > 0.0 ) ? cdf[i] : 1.0;
+        cdf[i] = static_cast<float>( partialSum / ( ( sum > 0.0 ) ? sum : width ) );
+    }
+    cdf[width - 1] = 1.0f;
+    return sum;
+}
+
+/// Initialize a PdfPyramid (allocated on the host) from a non-negative pdf of its finest size.
+/// The levels are summed and quantized in bands of rows by numThreads threads (zero selects the
+/// number of hardware threads), which does not change the result.
+inline void initPdfPyramid( PdfPyramid& pp, const float* pdf, int numThreads = 1 )
+{
+    // Sum the pdf into the coarser levels, finest first.
+    std::vector<std::vector<float>> sums( pp.numLevels );
+    const float* finer = pdf;
+    for( int level = pp.numLevels - 1; level >= 0; --level )
+    {
+        const int width = pp.topWidth << level;
+        const int height = pp.topHeight << level;
+        sums[level].resize( static_cast<size_t>( width ) * height );
+        float* coarser = sums[level].data();
+        otk::parallelBands( height, otk::getHostBandCount( height, numThreads ), [&]( int, int rowBegin, int rowEnd ) {
+            for( int j = rowBegin; j < rowEnd; ++j )
+            {
+                const float* row0 = &finer[static_cast<size_t>( 2 * j ) * 2 * width];
+                const float* row1 = row0 + 2 * width;
+                for( int i = 0; i < width; ++i )
+                    coarser[static_cast<size_t>( j ) * width + i] = ( row0[2 * i] + row0[2 * i + 1] ) + ( row1[2 * i] + row1[2 * i + 1] );
+            }
+        } );
+        finer = coarser;
+    }
+
+    // Quantize the fractions of each parent held by its children.
+    size_t offset = 0;
+    for( int level = 0; level < pp.numLevels; ++level )
+    {
+        const int parentWidth = pp.topWidth << level;
+        const int parentHeight = pp.topHeight << level;
+        const float* child = ( level + 1 < pp.numLevels ) ? sums[level + 1].data() : pdf;
+        unsigned short* fractions = &pp.fractions[offset];
+        otk::parallelBands( parentHeight, otk::getHostBandCount( parentHeight, numThreads ), [&]( int, int rowBegin, int rowEnd ) {
+            for( int j = rowBegin; j < rowEnd; ++j )
+            {
+                for( int i = 0; i < parentWidth; ++i )
+                {
+                    const size_t row0 = static_cast<size_t>( 2 * j ) * 2 * parentWidth + 2 * i;
+                    const size_t row1 = row0 + 2 * parentWidth;
+                    const float values[4] = { child[row0], child[row0 + 1], child[row1], child[row1 + 1] };
+                    const double sum = static_cast<double>( values[0] ) + values[1] + values[2] + values[3];
+                    unsigned short* group = &fractions[( static_cast<size_t>( j ) * parentWidth + i ) * 4];
+                    // An empty parent splits evenly.
+                    for( int c = 0; c < 4; ++c )
+                        group[c] = encodePdfPyramidFraction( ( sum > 0.0 ) ? values[c] / sum : 0.25 );
+                }
+            }
+        } );
+        offset += static_cast<size_t>( parentWidth ) * parentHeight * 4;
+    }
+
+    // Make the cdf of the top level.
+    const float* top = ( pp.numLevels > 0 ) ? sums[0].data() : pdf;
+    for( int j = 0; j < pp.topHeight; ++j )
+    {
+        float* cdfRow = &pp.topCdfRows[j * pp.topWidth];
+        for( int i = 0; i < pp.topWidth; ++i )
+            cdfRow[i] = top[j * pp.topWidth + i];
+        pp.topCdfMarginal[j] = static_cast<float>( makePdfPyramidCdf( cdfRow, pp.topWidth ) );
+    }
+    makePdfPyramidCdf( pp.topCdfMarginal, pp.topHeight );
+}
+
+/// Choose a bucket of a normalized cdf with x in [0,1), rescaling x to [0,1) within the bucket, and
+/// returning the probability of the bucket.
+OTK_INLINE OTK_HOSTDEVICE float searchPdfPyramidCdf( const float* cdf, int width, float& x, int& index )
+{
+    int left = 0;
+    int right = width - 1;
+    while( left < right )
+    {
+        const int mid = ( left + right ) >> 1;
+        if( cdf[mid] > x )
+            right = mid;
+        else
+            left = mid + 1;
+    }
+    index = left;
+    const float lo = ( index > 0 ) ? cdf[index - 1] : 0.0f;
+    const float prob = cdf[index] - lo;
+    x = fminf( ( x - lo ) / prob, 0.99999994f );
+    return prob;
+}
+
+/// Get the probability of a bucket of a normalized cdf
+OTK_INLINE OTK_HOSTDEVICE float getPdfPyramidCdfProb( const float* cdf, int index )
+{
+    return cdf[index] - ( ( index > 0 ) ? cdf[index - 1] : 0.0f );
+}
+
+/// Sample a PdfPyramid, returning texture coordinates in [0,1)^2, and optionally their pdf (with
+/// respect to area in texture space), which equals evalPdfPyramid at the sample.
+OTK_INLINE OTK_HOSTDEVICE float2 samplePdfPyramid( const PdfPyramid& pp, float2 xi, float* pdf = nullptr )
+{
+    float x = fminf( fmaxf( xi.x, 0.0f ), 0.99999994f );
+    float y = fminf( fmaxf( xi.y, 0.0f ), 0.99999994f );
+
+    // Choose a texel of the top level, by row and then column.
+    int row;
+    int column;
+    float prob = searchPdfPyramidCdf( pp.topCdfMarginal, pp.topHeight, y, row );
+    prob *= searchPdfPyramidCdf( &pp.topCdfRows[row * pp.topWidth], pp.topWidth, x, column );
+
+    // Descend the levels, choosing a child column and then a child row in each.
+    const unsigned short* fractions = pp.fractions;
+    int parentWidth = pp.topWidth;
+    for( int level = 0; level < pp.numLevels; ++level )
+    {
+        const unsigned short* group = &fractions[( row * parentWidth + column ) * 4];
+        const float f00 = decodePdfPyramidFraction( group[0] );
+        const float f10 = decodePdfPyramidFraction( group[1] );
+        const float f01 = decodePdfPyramidFraction( group[2] );
+        const float f11 = decodePdfPyramidFraction( group[3] );
+        const float left = f00 + f01;
+        const float right = f10 + f11;
+        const float total = left + right;
+
+        // Rounding can push the scaled sample past the last child with a nonzero fraction.
+        const float tx = x * total;
+        const int dx = ( tx < left || right == 0.0f ) ? 0 : 1;
+        const float columnTotal = dx ? right : left;
+        x = fminf( ( dx ? tx - left : tx ) / columnTotal, 0.99999994f );
+
+        const float upper = dx ? f10 : f00;
+        const float lower = dx ? f11 : f01;
+        const float ty = y * columnTotal;
+        const int dy = ( ty < upper || lower == 0.0f ) ? 0 : 1;
+        const float child = dy ? lower : upper;
+        y = fminf( ( dy ? ty - upper : ty ) / child, 0.99999994f );
+
+        prob *= child / total;
+        fractions += static_cast<size_t>( parentWidth ) * ( parentWidth / pp.topWidth ) * pp.topHeight * 4;
+        column = 2 * column + dx;
+        row = 2 * row + dy;
+        parentWidth *= 2;
+    }
+
+    if( pdf != nullptr )
+        *pdf = prob * ( static_cast<float>( pp.width ) * static_cast<float>( pp.height ) );
+    return float2{( column + x ) / pp.width, ( row + y ) / pp.height};
+}
+
+/// Evaluate the pdf of a PdfPyramid (with respect to area in texture space) at texture coordinates
+/// uv in [0,1]^2.
+OTK_INLINE OTK_HOSTDEVICE float evalPdfPyramid( const PdfPyramid& pp, float2 uv )
+{
+    int x = static_cast<int>( uv.x * pp.width );
+    int y = static_cast<int>( uv.y * pp.height );
+    x = ( x < 0 ) ? 0 : ( x < pp.width ? x : pp.width - 1 );
+    y = ( y < 0 ) ? 0 : ( y < pp.height ? y : pp.height - 1 );
+
+    // The probability of the top texel, computed as when sampling.
+    int row = y >> pp.numLevels;
+    int column = x >> pp.numLevels;
+    float prob = getPdfPyramidCdfProb( pp.topCdfMarginal, row );
+    prob *= getPdfPyramidCdfProb( &pp.topCdfRows[row * pp.topWidth], column );
+
+    // The fractions of the children on the path to the texel.
+    const unsigned short* fractions = pp.fractions;
+    int parentWidth = pp.topWidth;
+    for( int level = 0; level < pp.numLevels; ++level )
+    {
+        const int shift = pp.numLevels - 1 - level;
+        const int dx = ( x >> shift ) & 1;
+        const int dy = ( y >> shift ) & 1;
+        const unsigned short* group = &fractions[( row * parentWidth + column ) * 4];
+        const float f00 = decodePdfPyramidFraction( group[0] );
+        const float f10 = decodePdfPyramidFraction( group[1] );
+        const float f01 = decodePdfPyramidFraction( group[2] );
+        const float f11 = decodePdfPyramidFraction( group[3] );
+        const float total = ( f00 + f01 ) + ( f10 + f11 );
+        const float child = dy ? ( dx ? f11 : f01 ) : ( dx ? f10 : f00 );
+
+        prob *= child / total;
+        fractions += static_cast<size_t>( parentWidth ) * ( parentWidth / pp.topWidth ) * pp.topHeight * 4;
+        column = 2 * column + dx;
+        row = 2 * row + dy;
+        parentWidth *= 2;
+    }
+
+    return prob * ( static_cast<float>( pp.width ) * static_cast<float>( pp.height ) );
+}
@@ -7,9 +7,11 @@
 /// \file PdfTable.h
 /// Create a pdf table from a texture
 
+#include <OptiXToolkit/ShaderUtil/HostParallel.h>
 #include <OptiXToolkit/ShaderUtil/vec_math.h>
 
 #include <math.h>
+#include <vector>
 
 enum PdfBrightnessType { pbLUMINANCE, pbRGBSUM };
 enum PdfAngleType { paNONE, paLATLONG, paCUBEMAP };
@@ -17,43 +19,65 @@ enum PdfAngleType { paNONE, paLATLONG, paCUBEMAP };
 #define LUMINANCE( c ) ( 0.299f * float(c.x) + 0.587f * float(c.y) + 0.114f * float(c.z) )
 #define RGBSUM( c ) ( float(c.x) + float(c.y) + float(c.z) )
 
-/// Make a PDF array from an RGB image
+/// Make a PDF array from an RGB image.  The rows are processed in bands by numThreads threads
+/// (zero selects the number of hardware threads).  The pdf does not depend on the number of
+/// threads, and with a single thread neither does aveBrightness; otherwise aveBrightness differs
+/// only by the rounding of its double precision partial sums.
 template <class TYPE> 
 void makePdfTable( float* pdfTable, TYPE* srcArray, float* aveBrightness,
-                   int width, int height, PdfBrightnessType brightnessType, PdfAngleType angleType )
+                   int width, int height, PdfBrightnessType brightnessType, PdfAngleType angleType,
+                   int numThreads = 1 )
 {
-    double sumBrightnessAngle = 0.0f;
-    double sumAngleTerm = 0.0f;
+    const int numBands = otk::getHostBandCount( height, numThreads );
+    std::vector<double> bandBrightnessAngle( numBands, 0.0 );
+    std::vector<double> bandAngleTerm( numBands, 0.0 );
 
-    for( int j = 0; j < height; ++j )
-    {
-        float angleTerm = 1.0f;
-        if ( angleType == paLATLONG )
-        {
-            angleTerm = sinf( ( j + 0.5f ) * float( M_PIf ) / height );
-        }
+    otk::parallelBands( height, numBands, [&]( int band, int rowBegin, int rowEnd ) {
+        double sumBrightnessAngle = 0.0f;
+        double sumAngleTerm = 0.0f;
 
-        for( int i = 0; i < width; ++i )
+        for( int j = rowBegin; j < rowEnd; ++j )
         {
-            if( angleType == paCUBEMAP )
+            float angleTerm = 1.0f;
+            if ( angleType == paLATLONG )
             {
-                float x = ( 2.0f * i + 1.0f - width ) / float( width );
-                float y = ( 2.0f * j + 1.0f - height ) / float( height );
-                float d = sqrtf( x * x + y * y + 1.0f );
-                angleTerm = 1.0f / ( d * d * d );
+                angleTerm = sinf( ( j + 0.5f ) * float( M_PIf ) / height );
             }
 
-            TYPE c = srcArray[j * width + i];
-            float brightnessTerm;
-            if( brightnessType == pbRGBSUM )
-                brightnessTerm = RGBSUM( c );
-            else
-                brightnessTerm = LUMINANCE( c );
+            for( int i = 0; i < width; ++i )
+            {
+                if( angleType == paCUBEMAP )
+                {
+                    float x = ( 2.0f * i + 1.0f - width ) / float( width );
+                    float y = ( 2.0f * j + 1.0f - height ) / float( height );
+                    float d = sqrtf( x * x + y * y + 1.0f );
+                    angleTerm = 1.0f / ( d * d * d );
+                }
+
+                TYPE c = srcArray[j * width + i];
+                float brightnessTerm;
+                if( brightnessType == pbRGBSUM )
+                    brightnessTerm = RGBSUM( c );
+                else
+                    brightnessTerm = LUMINANCE( c );
 
-            pdfTable[j * width + i] = brightnessTerm * angleTerm;
-            sumBrightnessAngle += brightnessTerm * angleTerm;
-            sumAngleTerm += angleTerm;
+                pdfTable[j * width + i] = brightnessTerm * angleTerm;
+                sumBrightnessAngle += brightnessTerm * angleTerm;
+                sumAngleTerm += angleTerm;
+            }
         }
+
+        bandBrightnessAngle[band] = sumBrightnessAngle;
+        bandAngleTerm[band] = sumAngleTerm;
+    } );
+
+    // Combine the partial sums in band order, so the result does not depend on thread timing.
+    double sumBrightnessAngle = 0.0f;
+    double sumAngleTerm = 0.0f;
+    for( int band = 0; band < numBands; ++band )
+    {
+        sumBrightnessAngle += bandBrightnessAngle[band];
+        sumAngleTerm += bandAngleTerm[band];
     }
 
     *aveBrightness = static_cast<float>( sumBrightnessAngle / sumAngleTerm );
@@ -0,0 +1,421 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#pragma once
+
+/// \file HostSelfIntersectionAvoidanceImpl.h
+/// Host implementation of Self Intersection Avoidance library.
+///
+/// The device code bounds its rounding errors with directed rounding intrinsics (__fmaf_ru etc.).
+/// The host has no portable per-operation rounding modes, so the directed operations are evaluated
+/// exactly in double precision, as a sum and its rounding error, and rounded to the neighboring
+/// float in the requested direction.  Round to nearest operations map to float arithmetic and
+/// std::fma.  The batch loops vectorize when fma and sqrt compile to instructions, e.g. with
+/// -mfma -fno-math-errno (gcc, clang) or /arch:AVX2 (msvc).  Normalization uses an exact
+/// reciprocal square root where the device uses rsqrtf, so host and device offsets differ by a few
+/// ulps, but both are safe bounds.
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// The batch loops vectorize only if the operations are inlined into them.
+#if defined( _MSC_VER )
+#define OTK_SIA_HOST_INLINE __forceinline
+#else
+#define OTK_SIA_HOST_INLINE inline __attribute__( ( always_inline ) )
+#endif
+
+namespace SelfIntersectionAvoidance {
+namespace hostImpl {
+
+OTK_SIA_HOST_INLINE std::uint32_t floatBits( float f )
+{
+    std::uint32_t bits;
+    std::memcpy( &bits, &f, sizeof( bits ) );
+    return bits;
+}
+
+OTK_SIA_HOST_INLINE float bitsFloat( std::uint32_t bits )
+{
+    float f;
+    std::memcpy( &f, &bits, sizeof( f ) );
+    return f;
+}
+
+// round the unevaluated sum s + e, with |e| <= ulp(s)/2, to the nearest float not less than it
+// the selects are integer masks, so that loops over this vectorize
+OTK_SIA_HOST_INLINE float roundUp( double s, double e )
+{
+    const float         f    = static_cast<float>( s );
+    const std::uint32_t bits = floatBits( f );
+
+    // step to the next float up: +1 for positive floats, -1 for negative floats, to the smallest
+    // denormal from zero
+    const std::uint32_t zero = 0u - static_cast<std::uint32_t>( ( bits & 0x7fffffffu ) == 0 );
+    const std::uint32_t step = ( zero & ( 1u - bits ) ) | ( ~zero & ( 1u | ( 0u - ( bits >> 31 ) ) ) );
+    const std::uint32_t up   = 0u - static_cast<std::uint32_t>( ( s - static_cast<double>( f ) ) + e > 0.0 );
+    return bitsFloat( bits + ( up & step ) );
+}
+
+// exact sum of a and b, as s + e
+OTK_SIA_HOST_INLINE void twoSum( double& s, double& e, double a, double b )
+{
+    s              = a + b;
+    const double t = s - a;
+    e              = ( a - ( s - t ) ) + ( b - t );
+}
+
+// the product of two floats is exact in double precision
+OTK_SIA_HOST_INLINE float fmul_ru( float a, float b )
+{
+    return roundUp( static_cast<double>( a ) * b, 0.0 );
+}
+
+OTK_SIA_HOST_INLINE float fadd_ru( float a, float b )
+{
+    double s, e;
+    twoSum( s, e, a, b );
+    return roundUp( s, e );
+}
+
+OTK_SIA_HOST_INLINE float fsub_ru( float a, float b )
+{
+    return fadd_ru( a, -b );
+}
+
+OTK_SIA_HOST_INLINE float fmaf_ru( float a, float b, float c )
+{
+    double s, e;
+    twoSum( s, e, static_cast<double>( a ) * b, c );
+    return roundUp( s, e );
+}
+
+OTK_SIA_HOST_INLINE float fmaf_rd( float a, float b, float c )
+{
+    return -fmaf_ru( -a, b, -c );
+}
+
+OTK_SIA_HOST_INLINE float fmul_rn( float a, float b )
+{
+    return a * b;
+}
+
+OTK_SIA_HOST_INLINE float fadd_rn( float a, float b )
+{
+    return a + b;
+}
+
+OTK_SIA_HOST_INLINE float fsub_rn( float a, float b )
+{
+    return a - b;
+}
+
+OTK_SIA_HOST_INLINE float fmaf_rn( float a, float b, float c )
+{
+    return std::fma( a, b, c );
+}
+
+OTK_SIA_HOST_INLINE float fmax( float a, float b )
+{
+    return a > b ? a : b;
+}
+
+OTK_SIA_HOST_INLINE float dot_rn( const float3& u, const float3& v )
+{
+    return fmaf_rn( u.x, v.x, fmaf_rn( u.y, v.y, fmul_rn( u.z, v.z ) ) );
+}
+
+OTK_SIA_HOST_INLINE float dot_abs_rn( const float3& u, const float3& v )
+{
+    return fmaf_rn( std::fabs( u.x ), std::fabs( v.x ),
+                    fmaf_rn( std::fabs( u.y ), std::fabs( v.y ), fmul_rn( std::fabs( u.z ), std::fabs( v.z ) ) ) );
+}
+
+OTK_SIA_HOST_INLINE float rsqrt( float f )
+{
+    return 1.f / std::sqrt( f );
+}
+
+OTK_SIA_HOST_INLINE float3 scale( const float3& u, float s )
+{
+    return float3{ fmul_rn( u.x, s ), fmul_rn( u.y, s ), fmul_rn( u.z, s ) };
+}
+
+OTK_SIA_HOST_INLINE float fmmsf_rn( const float a, const float b, const float c, const float d )
+{
+    const float cd = fmul_rn( c, d );
+    const float e  = fmaf_rn( -c, d, cd );
+    const float f  = fmaf_rn( a, b, -cd );
+    return fadd_rn( f, e );
+}
+
+OTK_SIA_HOST_INLINE float3 cross( const float3& a, const float3& b )
+{
+    return float3{ fmmsf_rn( a.y, b.z, a.z, b.y ), fmmsf_rn( a.z, b.x, a.x, b.z ), fmmsf_rn( a.x, b.y, a.y, b.x ) };
+}
+
+// p + offset * n, rounded up where ( n > 0 ) == ( sign > 0 ) and down elsewhere, as offsetSpawnPoint
+// rounds the front (sign 1) and back (sign -1) points; fmaf_rd( a, b, c ) is -fmaf_ru( -a, b, -c ),
+// so both roundings are one fmaf_ru with the signs flipped
+OTK_SIA_HOST_INLINE float offsetAway( float p, float n, float offset, float sign )
+{
+    const float s = ( n > 0.f ) ? sign : -sign;
+    return s * fmaf_ru( s * offset, n, s * p );
+}
+
+// error bound of the transform of p by the rows of a matrix, plus a custom error term
+OTK_SIA_HOST_INLINE float transformError( const float4& row, const float3& p, float c, float err )
+{
+    return fmaf_ru( c,
+                    fmaf_ru( std::fabs( p.x ), std::fabs( row.x ),
+                             fmaf_ru( std::fabs( p.y ), std::fabs( row.y ), fmul_ru( std::fabs( p.z ), std::fabs( row.z ) ) ) ),
+                    err );
+}
+
+OTK_SIA_HOST_INLINE float transformPoint( const float4& row, const float3& p )
+{
+    return fadd_rn( fmaf_rn( row.x, p.x, fmaf_rn( row.y, p.y, fmul_rn( row.z, p.z ) ) ), row.w );
+}
+
+// Batches are processed in chunks staged in local arrays, so that the loops over a chunk are free
+// of aliasing and the output of a batch may overwrite its input.
+const unsigned int CHUNK_SIZE = 64;
+
+inline void copyIn( float ( *dst )[CHUNK_SIZE], const float* const* src, unsigned int numArrays, unsigned int begin, unsigned int count )
+{
+    for( unsigned int j = 0; j < numArrays; ++j )
+        std::memcpy( dst[j], src[j] + begin, count * sizeof( float ) );
+}
+
+inline void copyOut( float* const* dst, const float ( *src )[CHUNK_SIZE], unsigned int numArrays, unsigned int begin, unsigned int count )
+{
+    for( unsigned int j = 0; j < numArrays; ++j )
+        std::memcpy( dst[j] + begin, src[j], count * sizeof( float ) );
+}
+
+OTK_SIA_HOST_INLINE void triangleSpawnOffset( float3&       outPosition,
+                                              float3&       outNormal,
+                                              float&        outOffset,
+                                              const float3& v0,
+                                              const float3& v1,
+                                              const float3& v2,
+                                              const float2& bary )
+{
+    // construct triangle edges
+    const float3 e1{ fsub_rn( v1.x, v0.x ), fsub_rn( v1.y, v0.y ), fsub_rn( v1.z, v0.z ) };
+    const float3 e2{ fsub_rn( v2.x, v0.x ), fsub_rn( v2.y, v0.y ), fsub_rn( v2.z, v0.z ) };
+
+    // interpolate triangle point, as getTrianglePointAndError
+    outPosition.x = fadd_rn( v0.x, fmaf_rn( bary.x, e1.x, fmul_rn( bary.y, e2.x ) ) );
+    outPosition.y = fadd_rn( v0.y, fmaf_rn( bary.x, e1.y, fmul_rn( bary.y, e2.y ) ) );
+    outPosition.z = fadd_rn( v0.z, fmaf_rn( bary.x, e1.z, fmul_rn( bary.y, e2.z ) ) );
+
+    constexpr float c0 = 5.9604648328104529e-08f;
+    constexpr float c1 = 1.1920930376163769e-07f;
+
+    const float eps_x = fmul_ru( c1, fadd_ru( fadd_ru( std::fabs( e1.x ), std::fabs( e2.x ) ), std::fabs( fsub_ru( e1.x, e2.x ) ) ) );
+    const float eps_y = fmul_ru( c1, fadd_ru( fadd_ru( std::fabs( e1.y ), std::fabs( e2.y ) ), std::fabs( fsub_ru( e1.y, e2.y ) ) ) );
+    const float eps_z = fmul_ru( c1, fadd_ru( fadd_ru( std::fabs( e1.z ), std::fabs( e2.z ) ), std::fabs( fsub_ru( e1.z, e2.z ) ) ) );
+
+    // reconstruction + triangle intersection epsilon...
+    const float eps = fmax( fmax( eps_x, eps_y ), eps_z );
+
+    const float3 tri_err{ fmaf_ru( c0, std::fabs( v0.x ), eps ), fmaf_ru( c0, std::fabs( v0.y ), eps ),
+                          fmaf_ru( c0, std::fabs( v0.z ), eps ) };
+
+    const float3 n = cross( e1, e2 );
+    outNormal      = scale( n, rsqrt( dot_rn( n, n ) ) );
+    outOffset      = dot_abs_rn( tri_err, outNormal );
+}
+
+OTK_SIA_HOST_INLINE void transformSpawnOffset( float3&          outPosition,
+                                               float3&          outNormal,
+                                               float&           outOffset,
+                                               const float3&    inPosition,
+                                               const float3&    inNormal,
+                                               const float      inOffset,
+                                               const Matrix3x4& o2w,
+                                               const Matrix3x4& w2o )
+{
+    // assuming 1 ulp error in the matrix elements, as getObjectToWorldTransformedPositionAndError
+    constexpr float c0 = 1.19209317972490680404007434844970703125E-7f;
+    constexpr float c1 = 1.19209317972490680404007434844970703125E-7f;
+
+    // transform object space point to world space and compute transformation error bounds in world space
+    const float3 wld_p{ transformPoint( o2w.row0, inPosition ), transformPoint( o2w.row1, inPosition ),
+                        transformPoint( o2w.row2, inPosition ) };
+    const float3 wld_err{ transformError( o2w.row0, inPosition, c1, fmul_ru( c0, std::fabs( o2w.row0.w ) ) ),
+                          transformError( o2w.row1, inPosition, c1, fmul_ru( c0, std::fabs( o2w.row1.w ) ) ),
+                          transformError( o2w.row2, inPosition, c1, fmul_ru( c0, std::fabs( o2w.row2.w ) ) ) };
+
+    // compute world space surface normal, as transposeTransformNormal
+    const float3 wld_n{ fmaf_rn( w2o.row0.x, inNormal.x, fmaf_rn( w2o.row1.x, inNormal.y, fmul_rn( w2o.row2.x, inNormal.z ) ) ),
+                        fmaf_rn( w2o.row0.y, inNormal.x, fmaf_rn( w2o.row1.y, inNormal.y, fmul_rn( w2o.row2.y, inNormal.z ) ) ),
+                        fmaf_rn( w2o.row0.z, inNormal.x, fmaf_rn( w2o.row1.z, inNormal.y, fmul_rn( w2o.row2.z, inNormal.z ) ) ) };
+
+    // error bounds for the world to object transform of the point, as getWorldToObjectTransformedPositionError
+    const float3 obj_err{ transformError( w2o.row0, wld_p, c1, fmul_ru( c0, std::fabs( w2o.row0.w ) ) ),
+                          transformError( w2o.row1, wld_p, c1, fmul_ru( c0, std::fabs( w2o.row1.w ) ) ),
+                          transformError( w2o.row2, wld_p, c1, fmul_ru( c0, std::fabs( w2o.row2.w ) ) ) };
+
+    // accumulate object space error into object space offset
+    const float obj_offset = fadd_ru( dot_abs_rn( obj_err, inNormal ), inOffset );
+
+    // normalize world space normal
+    const float rcp = rsqrt( dot_rn( wld_n, wld_n ) );
+    outNormal       = scale( wld_n, rcp );
+
+    // scale object space offset, accounting for world space normal normalization, and add world space error
+    outOffset   = fmaf_rn( obj_offset, rcp, dot_abs_rn( wld_err, outNormal ) );
+    outPosition = wld_p;
+}
+
+OTK_SIA_HOST_INLINE void offsetSpawnPoint( float3& outFront, float3& outBack, const float3& inPosition, const float3& inNormal, const float inOffset )
+{
+    // offset point along direction, rounding away from the position
+    outFront = float3{ offsetAway( inPosition.x, inNormal.x, inOffset, 1.f ), offsetAway( inPosition.y, inNormal.y, inOffset, 1.f ),
+                       offsetAway( inPosition.z, inNormal.z, inOffset, 1.f ) };
+    outBack  = float3{ offsetAway( inPosition.x, inNormal.x, -inOffset, -1.f ), offsetAway( inPosition.y, inNormal.y, -inOffset, -1.f ),
+                       offsetAway( inPosition.z, inNormal.z, -inOffset, -1.f ) };
+}
+
+}  // namespace hostImpl
+
+inline void getSafeTriangleSpawnOffsetHost( float3&       outPosition,
+                                            float3&       outNormal,
+                                            float&        outOffset,
+                                            const float3& v0,
+                                            const float3& v1,
+                                            const float3& v2,
+                                            const float2& bary )
+{
+    hostImpl::triangleSpawnOffset( outPosition, outNormal, outOffset, v0, v1, v2, bary );
+}
+
+inline void transformSafeSpawnOffsetHost( float3&          outPosition,
+                                          float3&          outNormal,
+                                          float&           outOffset,
+                                          const float3&    inPosition,
+                                          const float3&    inNormal,
+                                          const float      inOffset,
+                                          const Matrix3x4& o2w,
+                                          const Matrix3x4& w2o )
+{
+    hostImpl::transformSpawnOffset( outPosition, outNormal, outOffset, inPosition, inNormal, inOffset, o2w, w2o );
+}
+
+inline void offsetSpawnPointHost( float3& outFront, float3& outBack, const float3& inPosition, const float3& inNormal, const float inOffset )
+{
+    hostImpl::offsetSpawnPoint( outFront, outBack, inPosition, inNormal, inOffset );
+}
+
+inline void getSafeTriangleSpawnOffsetBatch( const SpawnOffsetBatch& out, const TriangleBatch& triangles, unsigned int count )
+{
+    using hostImpl::CHUNK_SIZE;
+
+    const float* const inputs[11] = { triangles.v0[0], triangles.v0[1], triangles.v0[2], triangles.v1[0], triangles.v1[1], triangles.v1[2],
+                                      triangles.v2[0], triangles.v2[1], triangles.v2[2], triangles.bary[0], triangles.bary[1] };
+    float* const       outputs[7]  = { out.position[0], out.position[1], out.position[2], out.normal[0], out.normal[1], out.normal[2], out.offset };
+
+    float in[11][CHUNK_SIZE];
+    float res[7][CHUNK_SIZE];
+    for( unsigned int begin = 0; begin < count; begin += CHUNK_SIZE )
+    {
+        const unsigned int chunkSize = count - begin < CHUNK_SIZE ? count - begin : CHUNK_SIZE;
+        hostImpl::copyIn( in, inputs, 11, begin, chunkSize );
+        for( unsigned int i = 0; i < chunkSize; ++i )
+        {
+            float3 p, n;
+            hostImpl::triangleSpawnOffset( p, n, res[6][i], float3{ in[0][i], in[1][i], in[2][i] }, float3{ in[3][i], in[4][i], in[5][i] },
+                                           float3{ in[6][i], in[7][i], in[8][i] }, float2{ in[9][i], in[10][i] } );
+            res[0][i] = p.x, res[1][i] = p.y, res[2][i] = p.z;
+            res[3][i] = n.x, res[4][i] = n.y, res[5][i] = n.z;
+        }
+        hostImpl::copyOut( outputs, res, 7, begin, chunkSize );
+    }
+}
+
+inline void transformSafeSpawnOffsetBatch( const SpawnOffsetBatch& out,
+                                           const SpawnOffsetBatch& in,
+                                           const otk::Transform4*  o2w,
+                                           const otk::Transform4*  w2o,
+                                           const unsigned int*     transformIndices,
+                                           unsigned int            count )
+{
+    using hostImpl::CHUNK_SIZE;
+
+    const float* const inputs[7]  = { in.position[0], in.position[1], in.position[2], in.normal[0], in.normal[1], in.normal[2], in.offset };
+    float* const       outputs[7] = { out.position[0], out.position[1], out.position[2], out.normal[0], out.normal[1], out.normal[2], out.offset };
+
+    float src[7][CHUNK_SIZE];
+    float res[7][CHUNK_SIZE];
+    float matrices[24][CHUNK_SIZE];
+    for( unsigned int begin = 0; begin < count; begin += CHUNK_SIZE )
+    {
+        const unsigned int chunkSize = count - begin < CHUNK_SIZE ? count - begin : CHUNK_SIZE;
+        hostImpl::copyIn( src, inputs, 7, begin, chunkSize );
+
+        // gather the matrices of the chunk; without indices, every point uses the first transform
+        for( unsigned int i = 0; i < chunkSize; ++i )
+        {
+            const unsigned int index = transformIndices ? transformIndices[begin + i] : 0;
+            for( unsigned int row = 0; row < 3; ++row )
+            {
+                const float4& forward = o2w[index].m[row];
+                const float4& inverse = w2o[index].m[row];
+                matrices[4 * row + 0][i]  = forward.x;
+                matrices[4 * row + 1][i]  = forward.y;
+                matrices[4 * row + 2][i]  = forward.z;
+                matrices[4 * row + 3][i]  = forward.w;
+                matrices[4 * row + 12][i] = inverse.x;
+                matrices[4 * row + 13][i] = inverse.y;
+                matrices[4 * row + 14][i] = inverse.z;
+                matrices[4 * row + 15][i] = inverse.w;
+            }
+        }
+
+        for( unsigned int i = 0; i < chunkSize; ++i )
+        {
+            const float( *m )[CHUNK_SIZE] = matrices;
+            const Matrix3x4 o2wMatrix{ float4{ m[0][i], m[1][i], m[2][i], m[3][i] }, float4{ m[4][i], m[5][i], m[6][i], m[7][i] },
+                                       float4{ m[8][i], m[9][i], m[10][i], m[11][i] } };
+            const Matrix3x4 w2oMatrix{ float4{ m[12][i], m[13][i], m[14][i], m[15][i] }, float4{ m[16][i], m[17][i], m[18][i], m[19][i] },
+                                       float4{ m[20][i], m[21][i], m[22][i], m[23][i] } };
+            float3          p, n;
+            hostImpl::transformSpawnOffset( p, n, res[6][i], float3{ src[0][i], src[1][i], src[2][i] }, float3{ src[3][i], src[4][i], src[5][i] },
+                                            src[6][i], o2wMatrix, w2oMatrix );
+            res[0][i] = p.x, res[1][i] = p.y, res[2][i] = p.z;
+            res[3][i] = n.x, res[4][i] = n.y, res[5][i] = n.z;
+        }
+        hostImpl::copyOut( outputs, res, 7, begin, chunkSize );
+    }
+}
+
+inline void offsetSpawnPointBatch( float* const outFront[3], float* const outBack[3], const SpawnOffsetBatch& in, unsigned int count )
+{
+    using hostImpl::CHUNK_SIZE;
+
+    const float* const inputs[7]  = { in.position[0], in.position[1], in.position[2], in.normal[0], in.normal[1], in.normal[2], in.offset };
+    float* const       outputs[6] = { outFront[0], outFront[1], outFront[2], outBack[0], outBack[1], outBack[2] };
+
+    float src[7][CHUNK_SIZE];
+    float res[6][CHUNK_SIZE];
+    for( unsigned int begin = 0; begin < count; begin += CHUNK_SIZE )
+    {
+        const unsigned int chunkSize = count - begin < CHUNK_SIZE ? count - begin : CHUNK_SIZE;
+        hostImpl::copyIn( src, inputs, 7, begin, chunkSize );
+        for( unsigned int i = 0; i < chunkSize; ++i )
+        {
+            float3 front, back;
+            hostImpl::offsetSpawnPoint( front, back, float3{ src[0][i], src[1][i], src[2][i] }, float3{ src[3][i], src[4][i], src[5][i] },
+                                        src[6][i] );
+            res[0][i] = front.x, res[1][i] = front.y, res[2][i] = front.z;
+            res[3][i] = back.x, res[4][i] = back.y, res[5][i] = back.z;
+        }
+        hostImpl::copyOut( outputs, res, 6, begin, chunkSize );
+    }
+}
+
+}  // namespace SelfIntersectionAvoidance
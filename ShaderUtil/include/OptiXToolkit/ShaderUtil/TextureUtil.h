@@ -6,12 +6,12 @@
 
 /// \file TextureUtil.h
 #include <OptiXToolkit/ShaderUtil/Preprocessor.h>
+#include <OptiXToolkit/ShaderUtil/vec_math.h>
 
 enum FilterMode { FILTER_POINT=0, FILTER_BILINEAR, FILTER_BICUBIC, FILTER_SMARTBICUBIC };
 
 /// Compute mip level from the texture gradients.
-#ifdef __CUDACC__
-OTK_INLINE OTK_DEVICE float getMipLevel( float2 ddx, float2 ddy, int texWidth, int texHeight, float invAnisotropy )
+OTK_INLINE OTK_HOSTDEVICE float getMipLevel( float2 ddx, float2 ddy, int texWidth, int texHeight, float invAnisotropy )
 {
     ddx = float2{ddx.x * texWidth, ddx.y * texHeight};
     ddy = float2{ddy.x * texWidth, ddy.y * texHeight};
@@ -35,4 +35,3 @@ OTK_INLINE OTK_DEVICE float getMipLevel( float2 ddx, float2 ddy, int texWidth, i
     const float mipLevel     = 0.5f * log2f( filterWidth2 );
     return mipLevel;
 }
-#endif
\ No newline at end of file
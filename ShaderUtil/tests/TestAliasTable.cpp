@@ -6,11 +6,17 @@
 #include <OptiXToolkit/ShaderUtil/AliasTable.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <random>
+#include <vector>
+
 class TestAliasTable : public testing::Test
 {
   public:
     void printAliasTable( AliasTable& at );
     void verifyAliasTable( AliasTable& at, float* pdf, float maxDiff );
+    void verifyAliasTableRelative( AliasTable& at, const std::vector<float>& pdf, double maxRelDiff );
+    std::vector<float> makeEnvironmentPdf( int width, int height );
 };
 
 void TestAliasTable::printAliasTable( AliasTable& at )
@@ -50,6 +56,51 @@ void TestAliasTable::verifyAliasTable( AliasTable& at, float* pdf, float maxDiff
     }
 }
 
+void TestAliasTable::verifyAliasTableRelative( AliasTable& at, const std::vector<float>& pdf, double maxRelDiff )
+{
+    // Make the pdf defined by the alias table in double precision, and compare it to the pdf
+    // relative to the larger of the pdf value and its average.
+    std::vector<double> atPdf( at.size, 0.0 );
+    const double ave = 1.0 / at.size;
+    for( int i = 0; i < at.size; ++i )
+    {
+        AliasRecord ar = at.table[i];
+        ASSERT_TRUE( ar.alias >= 0 && ar.alias < at.size );
+        ASSERT_TRUE( ar.prob >= 0.0f && ar.prob <= 1.0f );
+        atPdf[i] += ar.prob * ave;
+        atPdf[ar.alias] += ( 1.0 - ar.prob ) * ave;
+    }
+    for( int i = 0; i < at.size; ++i )
+    {
+        const double scale = ( pdf[i] > ave ) ? pdf[i] : ave;
+        ASSERT_NEAR( atPdf[i], pdf[i], maxRelDiff * scale ) << i;
+    }
+}
+
+// A normalized pdf resembling an environment map: a bright sky over a dark ground, with noise and
+// a few very bright pixels.
+std::vector<float> TestAliasTable::makeEnvironmentPdf( int width, int height )
+{
+    std::mt19937 rng( 7 );
+    std::uniform_real_distribution<float> noise( 0.0f, 1.0f );
+    std::vector<float> pdf( width * height );
+    double sum = 0.0;
+    for( int j = 0; j < height; ++j )
+    {
+        for( int i = 0; i < width; ++i )
+        {
+            float value = ( j < height / 2 ? 4.0f : 0.25f ) * noise( rng );
+            if( noise( rng ) < 0.0005f )
+                value = 1000.0f;
+            pdf[j * width + i] = value;
+            sum += value;
+        }
+    }
+    for( float& value : pdf )
+        value = static_cast<float>( value / sum );
+    return pdf;
+}
+
 TEST_F( TestAliasTable, TestMakeTable )
 {
     float pdf[5] = {0.1f, 0.1f, 0.3f, 0.5f, 0.0f};
@@ -75,3 +126,188 @@ TEST_F( TestAliasTable, testTableEdges )
     freeAliasTableHost( at );
 }
 
+TEST_F( TestAliasTable, TestParallelMatchesPdf )
+{
+    const int width = 300;
+    const int height = 200;
+    const std::vector<float> pdf = makeEnvironmentPdf( width, height );
+
+    // The serial build leaves the rounding error of its float average to the last item it pairs.
+    AliasTable at;
+    allocAliasTableHost( at, width * height );
+    std::vector<float> pdfCopy = pdf;
+    makeAliasTable( at, pdfCopy.data() );
+    verifyAliasTableRelative( at, pdf, 1e-2 );
+
+    // The parallel build leaves the pdf intact.
+    for( int numThreads : { 2, 3, 8 } )
+    {
+        pdfCopy = pdf;
+        makeAliasTable( at, pdfCopy.data(), numThreads );
+        EXPECT_TRUE( pdfCopy == pdf );
+        verifyAliasTableRelative( at, pdf, 1e-6 );
+    }
+
+    freeAliasTableHost( at );
+}
+
+TEST_F( TestAliasTable, DISABLED_benchmarkBuildTime )
+{
+    for( int width : { 1024, 4096, 8192 } )
+    {
+        const int height = width / 2;
+        const std::vector<float> pdf = makeEnvironmentPdf( width, height );
+        std::vector<float> pdfCopy;
+        AliasTable at;
+        allocAliasTableHost( at, width * height );
+        for( int numThreads : { 1, 2, 4, 8, 16 } )
+        {
+            pdfCopy = pdf;
+            const auto start = std::chrono::steady_clock::now();
+            makeAliasTable( at, pdfCopy.data(), numThreads );
+            const double ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+            printf( "makeAliasTable %dx%d, %2d threads: %8.2f ms\n", width, height, numThreads, ms );
+        }
+        freeAliasTableHost( at );
+    }
+}
+
+TEST_F( TestAliasTable, TestCompactMatchesPdf )
+{
+    // Three blocks, the last one partial, with some items of zero weight.
+    const int width = 500;
+    const int height = 300;
+    std::vector<float> pdf = makeEnvironmentPdf( width, height );
+    for( int i = 0; i < width * height; i += 7 )
+        pdf[i] = 0.0f;
+
+    CompactAliasTable cat;
+    allocCompactAliasTableHost( cat, width * height );
+    EXPECT_EQ( 3, cat.numBlocks );
+    makeCompactAliasTable( cat, pdf.data() );
+
+    // Within each block, the units (65536 per entry) assigned to each item add up exactly, and
+    // are the item's share of the block rounded up or down.
+    std::vector<double> blockPdf( cat.numBlocks, 0.0 );
+    for( int block = 0; block < cat.numBlocks; ++block )
+    {
+        const int begin = block * COMPACT_ALIAS_BLOCK_SIZE;
+        const int blockSize = std::min( COMPACT_ALIAS_BLOCK_SIZE, cat.size - begin );
+        std::vector<long long> units( blockSize, 0 );
+        double blockWeight = 0.0;
+        for( int i = 0; i < blockSize; ++i )
+        {
+            const CompactAliasRecord record = cat.table[begin + i];
+            ASSERT_LT( record.alias, blockSize );
+            if( record.alias == i )
+            {
+                units[i] += 65536;
+                continue;
+            }
+            units[i] += record.prob;
+            units[record.alias] += 65536 - record.prob;
+        }
+        for( int i = 0; i < blockSize; ++i )
+            blockWeight += pdf[begin + i];
+        for( int i = 0; i < blockSize; ++i )
+        {
+            const double expected = pdf[begin + i] / blockWeight * 65536.0 * blockSize;
+            if( pdf[begin + i] == 0.0f )
+                ASSERT_EQ( 0, units[i] ) << begin + i;
+            else
+                ASSERT_LT( fabs( units[i] - expected ), 1.0 ) << begin + i;
+        }
+        blockPdf[block] = blockWeight;
+    }
+
+    // The block table selects blocks by their weight.
+    double sum = 0.0;
+    for( double weight : blockPdf )
+        sum += weight;
+    std::vector<float> blockPdfFloat( cat.numBlocks );
+    for( int block = 0; block < cat.numBlocks; ++block )
+        blockPdfFloat[block] = static_cast<float>( blockPdf[block] / sum );
+    verifyAliasTableRelative( cat.blockTable, blockPdfFloat, 1e-6 );
+
+    freeCompactAliasTableHost( cat );
+}
+
+TEST_F( TestAliasTable, TestCompactSampling )
+{
+    const int size = 37;
+    std::vector<float> pdf( size );
+    for( int i = 0; i < size; ++i )
+        pdf[i] = ( i % 5 == 0 ) ? 0.0f : static_cast<float>( 1 + i % 4 ) / 80.0f;
+
+    CompactAliasTable cat;
+    allocCompactAliasTableHost( cat, size );
+    makeCompactAliasTable( cat, pdf.data() );
+
+    // The histogram of the samples matches the pdf to within five standard deviations.
+    const int numSamples = 1 << 20;
+    std::mt19937 rng( 19 );
+    std::vector<int> histogram( size, 0 );
+    for( int i = 0; i < numSamples; ++i )
+    {
+        const int index = alias( cat, uint2{ static_cast<unsigned int>( rng() ), static_cast<unsigned int>( rng() ) } );
+        ASSERT_TRUE( index >= 0 && index < size );
+        histogram[index]++;
+    }
+    double sum = 0.0;
+    for( float value : pdf )
+        sum += value;
+    for( int i = 0; i < size; ++i )
+    {
+        const double expected = pdf[i] / sum * numSamples;
+        if( pdf[i] == 0.0f )
+            EXPECT_EQ( 0, histogram[i] ) << i;
+        else
+            EXPECT_NEAR( expected, histogram[i], 5.0 * sqrt( expected ) ) << i;
+    }
+
+    freeCompactAliasTableHost( cat );
+}
+
+TEST_F( TestAliasTable, DISABLED_benchmarkCompactSamplesPerSecond )
+{
+    // Tables much larger than the caches, sampled at random.
+    const int width = 4096;
+    const int height = 4096;
+    const std::vector<float> pdf = makeEnvironmentPdf( width, height );
+    const int numSamples = 1 << 24;
+
+    // A linear congruential generator, cheap enough not to hide the cost of the table accesses.
+    unsigned int state = 1;
+    auto random = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    };
+
+    AliasTable at;
+    allocAliasTableHost( at, width * height );
+    std::vector<float> pdfCopy = pdf;
+    makeAliasTable( at, pdfCopy.data(), 0 );
+    long long checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for( int i = 0; i < numSamples; ++i )
+        checksum += alias( at, random() * ( 1.0f / 4294967296.0f ) );
+    double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    printf( "AliasTable %dx%d (%4.0f MB): %6.1f M samples/s (%lld)\n", width, height,
+            width * height * sizeof( AliasRecord ) / 1048576.0, numSamples / seconds * 1e-6, checksum );
+    freeAliasTableHost( at );
+
+    CompactAliasTable cat;
+    allocCompactAliasTableHost( cat, width * height );
+    makeCompactAliasTable( cat, pdf.data(), 0 );
+    checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for( int i = 0; i < numSamples; ++i )
+    {
+        const unsigned int x = random();
+        checksum += alias( cat, uint2{ x, random() } );
+    }
+    seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    printf( "CompactAliasTable %dx%d (%4.0f MB): %6.1f M samples/s (%lld)\n", width, height,
+            width * height * sizeof( CompactAliasRecord ) / 1048576.0, numSamples / seconds * 1e-6, checksum );
+    freeCompactAliasTableHost( cat );
+}
@@ -0,0 +1,324 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <stdio.h>
+#include <OptiXToolkit/ShaderUtil/BatchSampling.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <random>
+#include <vector>
+
+class TestBatchSampling : public testing::Test
+{
+  public:
+    void SetUp() override;
+
+    // An odd count, so that the batches end with a partial one.
+    const int   count  = 1003;
+    const int   width  = 96;
+    const int   height = 48;
+    std::vector<float> pdf;
+    std::vector<float> xiX;
+    std::vector<float> xiY;
+    std::vector<float> u;
+    std::vector<float> v;
+    std::vector<float> samplePdf;
+};
+
+void TestBatchSampling::SetUp()
+{
+    std::mt19937 rng( 17 );
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    pdf.resize( width * height );
+    for( int j = 0; j < height; ++j )
+        for( int i = 0; i < width; ++i )
+            pdf[j * width + i] = ( i >= width / 4 && i < width / 2 ) ? 0.0f : 0.1f + uniform( rng ) * uniform( rng ) * ( j + 1 );
+
+    xiX.resize( count );
+    xiY.resize( count );
+    for( int i = 0; i < count; ++i )
+    {
+        xiX[i] = uniform( rng );
+        xiY[i] = uniform( rng );
+    }
+    // Include the ends of the range.
+    xiX[0] = 0.0f;
+    xiY[0] = 0.0f;
+    xiX[1] = 0.99999994f;
+    xiY[1] = 0.99999994f;
+
+    u.assign( count, 0.0f );
+    v.assign( count, 0.0f );
+    samplePdf.assign( count, 0.0f );
+}
+
+TEST_F( TestBatchSampling, TestAlias2D )
+{
+    AliasTable at;
+    allocAliasTableHost( at, width * height );
+    std::vector<float> weights( pdf );
+    makeAliasTable( at, weights.data() );
+    std::vector<float> entryPdf( width * height );
+    getAliasTablePdf( at, entryPdf.data() );
+
+    alias2DBatch( at, width, height, count, xiX.data(), xiY.data(), u.data(), v.data(), entryPdf.data(), samplePdf.data() );
+    for( int i = 0; i < count; ++i )
+    {
+        const float2 uv = alias2D( at, width, height, float2{xiX[i], xiY[i]} );
+        ASSERT_EQ( uv.x, u[i] ) << i;
+        ASSERT_EQ( uv.y, v[i] ) << i;
+        ASSERT_EQ( getAlias2DPdf( entryPdf.data(), width, height, uv ), samplePdf[i] ) << i;
+        ASSERT_GT( samplePdf[i], 0.0f ) << i;
+    }
+
+    // The entry densities are the weights relative to their average.
+    double sum = 0.0;
+    for( float value : pdf )
+        sum += value;
+    const double average = sum / pdf.size();
+    for( int i = 0; i < width * height; ++i )
+        ASSERT_NEAR( pdf[i] / average, entryPdf[i], 1e-4 * pdf[i] / average + 1e-6 ) << i;
+    freeAliasTableHost( at );
+}
+
+TEST_F( TestBatchSampling, TestCdfInversionTable )
+{
+    CdfInversionTable cit;
+    allocCdfInversionTableHost( cit, width, height );
+    memcpy( cit.cdfRows, pdf.data(), width * height * sizeof( float ) );
+    invertPdf2D( cit );
+    invertCdf2D( cit );
+
+    sampleCdfBinSearchBatch( cit, count, xiX.data(), xiY.data(), u.data(), v.data(), samplePdf.data() );
+    for( int i = 0; i < count; ++i )
+    {
+        const float2 uv = sampleCdfBinSearch( cit, float2{xiX[i], xiY[i]} );
+        ASSERT_EQ( uv.x, u[i] ) << i;
+        ASSERT_EQ( uv.y, v[i] ) << i;
+        ASSERT_EQ( getCdfInversionTablePdf( cit, uv ), samplePdf[i] ) << i;
+        ASSERT_GT( samplePdf[i], 0.0f ) << i;
+    }
+
+    sampleCdfLinSearchBatch( cit, count, xiX.data(), xiY.data(), u.data(), v.data(), samplePdf.data() );
+    for( int i = 0; i < count; ++i )
+    {
+        const float2 uv = sampleCdfLinSearch( cit, float2{xiX[i], xiY[i]} );
+        ASSERT_EQ( uv.x, u[i] ) << i;
+        ASSERT_EQ( uv.y, v[i] ) << i;
+        ASSERT_EQ( getCdfInversionTablePdf( cit, uv ), samplePdf[i] ) << i;
+    }
+
+    // The interpolation of the direct lookup is a candidate for fused multiply-adds, so compare
+    // to within a few ulps.
+    sampleCdfDirectLookupBatch( cit, count, xiX.data(), xiY.data(), u.data(), v.data(), samplePdf.data() );
+    for( int i = 0; i < count; ++i )
+    {
+        const float2 uv = sampleCdfDirectLookup( cit, float2{xiX[i], xiY[i]} );
+        ASSERT_FLOAT_EQ( uv.x, u[i] ) << i;
+        ASSERT_FLOAT_EQ( uv.y, v[i] ) << i;
+    }
+
+    freeCdfInversionTableHost( cit );
+}
+
+TEST_F( TestBatchSampling, TestISummedAreaTable )
+{
+    ISummedAreaTable sat;
+    allocISummedAreaTableHost( sat, width, height );
+    initISummedAreaTable( sat, pdf.data() );
+
+    sampleBatch( sat, count, xiX.data(), xiY.data(), u.data(), v.data(), samplePdf.data() );
+    for( int i = 0; i < count; ++i )
+    {
+        const float2 uv = sample( sat, float2{xiX[i], xiY[i]} );
+        ASSERT_EQ( uv.x, u[i] ) << i;
+        ASSERT_EQ( uv.y, v[i] ) << i;
+        ASSERT_EQ( getISummedAreaTablePdf( sat, uv ), samplePdf[i] ) << i;
+        ASSERT_GT( samplePdf[i], 0.0f ) << i;
+    }
+
+    // The pdf of a sample is the pdf of its cell relative to the average, up to the quantization
+    // of the table.
+    double sum = 0.0;
+    for( float value : pdf )
+        sum += value;
+    const double average = sum / pdf.size();
+    for( int i = 0; i < count; ++i )
+    {
+        const int x = std::min( static_cast<int>( u[i] * width ), width - 1 );
+        const int y = std::min( static_cast<int>( v[i] * height ), height - 1 );
+        ASSERT_NEAR( pdf[y * width + x] / average, samplePdf[i], 1e-3 * pdf[y * width + x] / average ) << i;
+    }
+    freeISummedAreaTableHost( sat );
+}
+
+TEST_F( TestBatchSampling, TestFiltersAndRayCones )
+{
+    std::vector<float> outX( count );
+    std::vector<float> outY( count );
+
+    tentFilterBatch( count, xiX.data(), outX.data() );
+    for( int i = 0; i < count; ++i )
+        ASSERT_FLOAT_EQ( tentFilter( xiX[i] ), outX[i] ) << i;
+
+    boxMullerBatch( count - 1, &xiX[1], &xiY[1], outX.data(), outY.data() );
+    for( int i = 0; i < count - 1; ++i )
+    {
+        const float2 g = boxMuller( float2{xiX[i + 1], xiY[i + 1]} );
+        ASSERT_EQ( g.x, outX[i] ) << i;
+        ASSERT_EQ( g.y, outY[i] ) << i;
+    }
+
+    sampleSharpenBatch( LANCZOS, true, count, xiX.data(), xiY.data(), outX.data(), outY.data() );
+    for( int i = 0; i < count; ++i )
+    {
+        const float2 s = sampleSharpenNeg( LANCZOS, float2{xiX[i], xiY[i]} );
+        ASSERT_EQ( s.x, outX[i] ) << i;
+        ASSERT_EQ( s.y, outY[i] ) << i;
+    }
+
+    // Ray cones with angles and widths of both signs.
+    std::vector<float> angle( count );
+    std::vector<float> coneWidth( count );
+    for( int i = 0; i < count; ++i )
+    {
+        angle[i]     = 0.02f * ( xiX[i] - 0.5f );
+        coneWidth[i] = 0.1f * ( xiY[i] - 0.5f );
+    }
+    std::vector<float> batchAngle( angle );
+    std::vector<float> batchWidth( coneWidth );
+    propagateBatch( count, batchAngle.data(), batchWidth.data(), xiY.data() );
+    scatterBsdfBatch( count, batchAngle.data(), batchWidth.data(), xiX.data() );
+    for( int i = 0; i < count; ++i )
+    {
+        const RayCone rc = scatterBsdf( propagate( RayCone{angle[i], coneWidth[i]}, xiY[i] ), xiX[i] );
+        ASSERT_EQ( rc.angle, batchAngle[i] ) << i;
+        ASSERT_EQ( rc.width, batchWidth[i] ) << i;
+    }
+}
+
+// Time a scalar function on each sample of a batch, and the batched function on the whole batch.
+static void reportSamplesPerSecond( const char*                           name,
+                                    const std::function<float2( float2 )>& scalar,
+                                    const std::function<void()>&           batched,
+                                    const std::vector<float>&              bx,
+                                    const std::vector<float>&              by,
+                                    std::vector<float>&                    bu,
+                                    std::vector<float>&                    bv,
+                                    int                                    numBatches )
+{
+    const int batch = static_cast<int>( bx.size() );
+    float checksum = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for( int b = 0; b < numBatches; ++b )
+    {
+        for( int i = 0; i < batch; ++i )
+        {
+            const float2 uv = scalar( float2{bx[i], by[i]} );
+            bu[i] = uv.x;
+            bv[i] = uv.y;
+        }
+        checksum += bu[b] + bv[b];
+    }
+    const double scalarSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    start = std::chrono::steady_clock::now();
+    for( int b = 0; b < numBatches; ++b )
+    {
+        batched();
+        checksum += bu[b] + bv[b];
+    }
+    const double batchSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    const double numSamples = double( batch ) * numBatches;
+    printf( "%-24s scalar %7.1f M samples/s, batch %7.1f M samples/s (%f)\n", name, numSamples / scalarSeconds * 1e-6,
+            numSamples / batchSeconds * 1e-6, checksum );
+}
+
+TEST_F( TestBatchSampling, DISABLED_benchmarkSamplesPerSecond )
+{
+    const int tableWidth  = 4096;
+    const int tableHeight = 2048;
+    std::mt19937 rng( 1 );
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    std::vector<float> tablePdf( tableWidth * tableHeight );
+    for( float& value : tablePdf )
+        value = uniform( rng ) * uniform( rng );
+
+    const int batch = 1 << 16;
+    const int numBatches = 64;
+    std::vector<float> bx( batch );
+    std::vector<float> by( batch );
+    std::vector<float> bu( batch );
+    std::vector<float> bv( batch );
+    std::vector<float> bpdf( batch );
+    for( int i = 0; i < batch; ++i )
+    {
+        bx[i] = uniform( rng );
+        by[i] = uniform( rng );
+    }
+
+    auto report = [&]( const char* name, const std::function<float2( float2 )>& scalar, const std::function<void()>& batched ) {
+        reportSamplesPerSecond( name, scalar, batched, bx, by, bu, bv, numBatches );
+    };
+
+    AliasTable at;
+    allocAliasTableHost( at, tableWidth * tableHeight );
+    std::vector<float> weights( tablePdf );
+    makeAliasTable( at, weights.data(), 0 );
+    report( "alias2D", [&]( float2 xi ) { return alias2D( at, tableWidth, tableHeight, xi ); },
+            [&]() { alias2DBatch( at, tableWidth, tableHeight, batch, bx.data(), by.data(), bu.data(), bv.data() ); } );
+    std::vector<float> entryPdf( tableWidth * tableHeight );
+    getAliasTablePdf( at, entryPdf.data() );
+    report( "alias2D+pdf",
+            [&]( float2 xi ) {
+                const float2 uv = alias2D( at, tableWidth, tableHeight, xi );
+                return float2{uv.x, getAlias2DPdf( entryPdf.data(), tableWidth, tableHeight, uv )};
+            },
+            [&]() {
+                alias2DBatch( at, tableWidth, tableHeight, batch, bx.data(), by.data(), bu.data(), bv.data(), entryPdf.data(), bpdf.data() );
+            } );
+    freeAliasTableHost( at );
+
+    CdfInversionTable cit;
+    allocCdfInversionTableHost( cit, tableWidth, tableHeight );
+    memcpy( cit.cdfRows, tablePdf.data(), tableWidth * tableHeight * sizeof( float ) );
+    invertPdf2D( cit, 0 );
+    invertCdf2D( cit, 0 );
+    report( "sampleCdfBinSearch", [&]( float2 xi ) { return sampleCdfBinSearch( cit, xi ); },
+            [&]() { sampleCdfBinSearchBatch( cit, batch, bx.data(), by.data(), bu.data(), bv.data() ); } );
+    report( "sampleCdfLinSearch", [&]( float2 xi ) { return sampleCdfLinSearch( cit, xi ); },
+            [&]() { sampleCdfLinSearchBatch( cit, batch, bx.data(), by.data(), bu.data(), bv.data() ); } );
+    report( "sampleCdfDirectLookup", [&]( float2 xi ) { return sampleCdfDirectLookup( cit, xi ); },
+            [&]() { sampleCdfDirectLookupBatch( cit, batch, bx.data(), by.data(), bu.data(), bv.data() ); } );
+    report( "sampleCdfBinSearch+pdf",
+            [&]( float2 xi ) {
+                const float2 uv = sampleCdfBinSearch( cit, xi );
+                return float2{uv.x, getCdfInversionTablePdf( cit, uv )};
+            },
+            [&]() { sampleCdfBinSearchBatch( cit, batch, bx.data(), by.data(), bu.data(), bv.data(), bpdf.data() ); } );
+    freeCdfInversionTableHost( cit );
+
+    ISummedAreaTable sat;
+    allocISummedAreaTableHost( sat, tableWidth, tableHeight );
+    initISummedAreaTable( sat, tablePdf.data(), 0 );
+    report( "ISummedAreaTable sample", [&]( float2 xi ) { return sample( sat, xi ); },
+            [&]() { sampleBatch( sat, batch, bx.data(), by.data(), bu.data(), bv.data() ); } );
+    report( "ISummedAreaTable+pdf",
+            [&]( float2 xi ) {
+                const float2 uv = sample( sat, xi );
+                return float2{uv.x, getISummedAreaTablePdf( sat, uv )};
+            },
+            [&]() { sampleBatch( sat, batch, bx.data(), by.data(), bu.data(), bv.data(), bpdf.data() ); } );
+    freeISummedAreaTableHost( sat );
+
+    report( "tentFilter", []( float2 xi ) { return tentFilter( xi ); },
+            [&]() {
+                tentFilterBatch( batch, bx.data(), bu.data() );
+                tentFilterBatch( batch, by.data(), bv.data() );
+            } );
+    report( "boxMuller", []( float2 xi ) { return boxMuller( xi ); },
+            [&]() { boxMullerBatch( batch, bx.data(), by.data(), bu.data(), bv.data() ); } );
+}
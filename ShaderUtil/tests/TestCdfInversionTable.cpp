@@ -6,6 +6,10 @@
 #include <OptiXToolkit/ShaderUtil/CdfInversionTable.h>
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <random>
+#include <vector>
+
 class TestCdfInversionTable : public testing::Test
 {
   public:
@@ -165,3 +169,143 @@ TEST_F( TestCdfInversionTable, LinearAndBinarySearch )
 
     freeCdfInversionTableHost( cit );
 }
+
+TEST_F( TestCdfInversionTable, TestParallelMatchesSerial )
+{
+    const int w = 123;
+    const int h = 77;
+    std::mt19937 rng( 3 );
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    std::vector<float> pdf( w * h );
+    for( float& value : pdf )
+        value = uniform( rng ) * uniform( rng );
+
+    CdfInversionTable serial;
+    allocCdfInversionTableHost( serial, w, h );
+    memcpy( serial.cdfRows, pdf.data(), w * h * sizeof(float) );
+    invertPdf2D( serial );
+    invertCdf2D( serial );
+
+    // The rows are inverted independently, so the tables are bit-identical.
+    for( int numThreads : { 2, 5, 0 } )
+    {
+        CdfInversionTable cit;
+        allocCdfInversionTableHost( cit, w, h );
+        memcpy( cit.cdfRows, pdf.data(), w * h * sizeof(float) );
+        invertPdf2D( cit, numThreads );
+        invertCdf2D( cit, numThreads );
+        EXPECT_EQ( 0, memcmp( serial.cdfRows, cit.cdfRows, w * h * sizeof(float) ) );
+        EXPECT_EQ( 0, memcmp( serial.cdfMarginal, cit.cdfMarginal, h * sizeof(float) ) );
+        EXPECT_EQ( 0, memcmp( serial.invCdfRows, cit.invCdfRows, w * h * sizeof(short) ) );
+        EXPECT_EQ( 0, memcmp( serial.invCdfMarginal, cit.invCdfMarginal, h * sizeof(short) ) );
+        freeCdfInversionTableHost( cit );
+    }
+
+    freeCdfInversionTableHost( serial );
+}
+
+TEST_F( TestCdfInversionTable, TestUpdateMatchesRebuild )
+{
+    const int w = 123;
+    const int h = 77;
+    std::mt19937 rng( 7 );
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    std::vector<float> pdf( w * h );
+    for( float& value : pdf )
+        value = uniform( rng );
+
+    CdfInversionTable cit;
+    allocCdfInversionTableHost( cit, w, h );
+    std::vector<float> rowSums( h );
+    memcpy( cit.cdfRows, pdf.data(), w * h * sizeof(float) );
+    invertPdf2D( cit, 1, rowSums.data() );
+    invertCdf2D( cit );
+
+    // Paint a few rectangles, updating the table after each, and compare with a full rebuild.
+    CdfInversionTable rebuilt;
+    allocCdfInversionTableHost( rebuilt, w, h );
+    const int rects[3][4] = { { 10, 5, 30, 20 }, { 0, 60, 122, 76 }, { 100, 0, 110, 3 } };
+    for( const int* rect : rects )
+    {
+        for( int y = rect[1]; y <= rect[3]; ++y )
+            for( int x = rect[0]; x <= rect[2]; ++x )
+                pdf[y * w + x] = 5.0f * uniform( rng );
+        updateCdfInversionTable( cit, rowSums.data(), pdf.data(), rect[1], rect[3], 2 );
+
+        memcpy( rebuilt.cdfRows, pdf.data(), w * h * sizeof(float) );
+        invertPdf2D( rebuilt );
+        invertCdf2D( rebuilt );
+        EXPECT_EQ( 0, memcmp( rebuilt.cdfRows, cit.cdfRows, w * h * sizeof(float) ) );
+        EXPECT_EQ( 0, memcmp( rebuilt.cdfMarginal, cit.cdfMarginal, h * sizeof(float) ) );
+        EXPECT_EQ( 0, memcmp( rebuilt.invCdfRows, cit.invCdfRows, w * h * sizeof(short) ) );
+        EXPECT_EQ( 0, memcmp( rebuilt.invCdfMarginal, cit.invCdfMarginal, h * sizeof(short) ) );
+    }
+
+    freeCdfInversionTableHost( rebuilt );
+    freeCdfInversionTableHost( cit );
+}
+
+TEST_F( TestCdfInversionTable, DISABLED_benchmarkBuildTime )
+{
+    for( int w : { 1024, 4096, 8192 } )
+    {
+        const int h = w / 2;
+        std::vector<float> pdf( w * h );
+        for( int i = 0; i < w * h; ++i )
+            pdf[i] = static_cast<float>( ( static_cast<long long>( i ) * 7919 ) % 1000 );
+
+        CdfInversionTable cit;
+        allocCdfInversionTableHost( cit, w, h );
+        for( int numThreads : { 1, 2, 4, 8, 16 } )
+        {
+            memcpy( cit.cdfRows, pdf.data(), w * h * sizeof(float) );
+            const auto start = std::chrono::steady_clock::now();
+            invertPdf2D( cit, numThreads );
+            invertCdf2D( cit, numThreads );
+            const double ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+            printf( "invertPdf2D + invertCdf2D %dx%d, %2d threads: %8.2f ms\n", w, h, numThreads, ms );
+        }
+        freeCdfInversionTableHost( cit );
+    }
+}
+
+TEST_F( TestCdfInversionTable, DISABLED_benchmarkUpdateTime )
+{
+    const int w = 8192;
+    const int h = 4096;
+    std::vector<float> pdf( w * h );
+    for( int i = 0; i < w * h; ++i )
+        pdf[i] = static_cast<float>( ( static_cast<long long>( i ) * 7919 ) % 1000 );
+
+    CdfInversionTable cit;
+    allocCdfInversionTableHost( cit, w, h );
+    std::vector<float> rowSums( h );
+    memcpy( cit.cdfRows, pdf.data(), w * h * sizeof(float) );
+    const auto fullStart = std::chrono::steady_clock::now();
+    invertPdf2D( cit, 1, rowSums.data() );
+    invertCdf2D( cit );
+    const double fullMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - fullStart ).count();
+    printf( "invertPdf2D + invertCdf2D %dx%d: %8.2f ms\n", w, h, fullMs );
+
+    // Brush strokes of different sizes at random places.
+    std::mt19937 rng( 1 );
+    for( int brush : { 16, 64, 256 } )
+    {
+        const int numStrokes = 32;
+        double ms = 0.0;
+        for( int stroke = 0; stroke < numStrokes; ++stroke )
+        {
+            const int x0 = std::uniform_int_distribution<int>( 0, w - brush )( rng );
+            const int y0 = std::uniform_int_distribution<int>( 0, h - brush )( rng );
+            for( int y = y0; y < y0 + brush; ++y )
+                for( int x = x0; x < x0 + brush; ++x )
+                    pdf[y * w + x] = 2000.0f;
+            const auto start = std::chrono::steady_clock::now();
+            updateCdfInversionTable( cit, rowSums.data(), pdf.data(), y0, y0 + brush - 1 );
+            ms += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+        }
+        printf( "updateCdfInversionTable %dx%d, %3dx%-3d rect: %8.3f ms (%6.1fx faster than a rebuild)\n", w, h, brush,
+                brush, ms / numStrokes, fullMs * numStrokes / ms );
+    }
+    freeCdfInversionTableHost( cit );
+}
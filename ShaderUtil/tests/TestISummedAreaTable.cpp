@@ -7,6 +7,10 @@
 #include <OptiXToolkit/ShaderUtil/ISummedAreaTable.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+
 const float EPS = 0.00001f;
 
 class TestISummedAreaTable : public testing::Test
@@ -168,3 +172,276 @@ TEST_F( TestISummedAreaTable, TestSearchNonUniform )
 
     freeISummedAreaTableHost( sat );
 }
+
+TEST_F( TestISummedAreaTable, TestParallelMatchesSerial )
+{
+    // Integer pdf values sum exactly in any order, so every build has the same scale, and the
+    // tables are bit-identical.
+    const int width = 517;
+    const int height = 263;
+    std::mt19937 rng( 5 );
+    std::uniform_int_distribution<int> uniform( 1, 255 );
+    std::vector<float> pdf( width * height );
+    for( float& value : pdf )
+        value = static_cast<float>( uniform( rng ) );
+
+    ISummedAreaTable serial;
+    allocISummedAreaTableHost( serial, width, height );
+    initISummedAreaTable( serial, pdf.data() );
+    verifyTable( serial );
+
+    for( int numThreads : { 2, 3, 8, 0 } )
+    {
+        ISummedAreaTable sat;
+        allocISummedAreaTableHost( sat, width, height );
+        initISummedAreaTable( sat, pdf.data(), numThreads );
+        EXPECT_EQ( 0, memcmp( serial.table, sat.table, width * height * sizeof(unsigned int) ) );
+        EXPECT_EQ( 0, memcmp( serial.columnSums, sat.columnSums, width * height * sizeof(unsigned int) ) );
+        freeISummedAreaTableHost( sat );
+    }
+
+    freeISummedAreaTableHost( serial );
+}
+
+TEST_F( TestISummedAreaTable, TestUpdateMatchesRebuild )
+{
+    const int width = 317;
+    const int height = 163;
+    std::mt19937 rng( 9 );
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    std::vector<float> pdf( width * height );
+    for( float& value : pdf )
+        value = uniform( rng );
+
+    ISummedAreaTable sat;
+    allocISummedAreaTableHost( sat, width, height );
+    double scale = initISummedAreaTable( sat, pdf.data(), 1, 2.0 );
+
+    // An update with the headroom of the build is identical to a rebuild with the same scale.
+    ISummedAreaTable rebuilt;
+    allocISummedAreaTableHost( rebuilt, width, height );
+    const int rects[4][4] = { { 10, 5, 30, 20 }, { 0, 150, 316, 162 }, { 300, 0, 316, 3 }, { 0, 0, 0, 0 } };
+    for( const int* rect : rects )
+    {
+        for( int y = rect[1]; y <= rect[3]; ++y )
+            for( int x = rect[0]; x <= rect[2]; ++x )
+                pdf[y * width + x] = 2.0f * uniform( rng );
+        EXPECT_TRUE( updateISummedAreaTable( sat, scale, pdf.data(), rect[0], rect[1], rect[2], rect[3], 2 ) );
+
+        initISummedAreaTableWithScale( rebuilt, pdf.data(), scale );
+        EXPECT_EQ( 0, memcmp( rebuilt.table, sat.table, width * height * sizeof(unsigned int) ) );
+        EXPECT_EQ( 0, memcmp( rebuilt.columnSums, sat.columnSums, width * height * sizeof(unsigned int) ) );
+    }
+
+    // Brightening past the headroom rebuilds the table.
+    for( int y = 40; y < 100; ++y )
+        for( int x = 40; x < 100; ++x )
+            pdf[y * width + x] = 1000.0f;
+    EXPECT_FALSE( updateISummedAreaTable( sat, scale, pdf.data(), 40, 40, 99, 99 ) );
+    EXPECT_EQ( initISummedAreaTable( rebuilt, pdf.data(), 1, 2.0 ), scale );
+    EXPECT_EQ( 0, memcmp( rebuilt.table, sat.table, width * height * sizeof(unsigned int) ) );
+    EXPECT_EQ( 0, memcmp( rebuilt.columnSums, sat.columnSums, width * height * sizeof(unsigned int) ) );
+
+    freeISummedAreaTableHost( rebuilt );
+    freeISummedAreaTableHost( sat );
+}
+
+TEST_F( TestISummedAreaTable, TestBlockedSearchUniform )
+{
+    // A uniform pdf in equal blocks samples the same locations as a single table.
+    const int width = 256;
+    const int height = 128;
+    std::vector<float> pdf( width * height, 1.0f );
+    BlockedSummedAreaTable bsat;
+    allocBlockedSummedAreaTableHost( bsat, width, height, 32 );
+    initBlockedSummedAreaTable( bsat, pdf.data() );
+    EXPECT_EQ( 8, bsat.blockSums.width );
+    EXPECT_EQ( 4, bsat.blockSums.height );
+    verifyTable( bsat.blockSums );
+
+    const int gridSize = 11;
+    for( int j=0; j<=gridSize; ++j )
+    {
+        for( int i=0; i<=gridSize; ++i )
+        {
+            float2 s = float2{float(i)/gridSize, float(j)/gridSize};
+            float2 t = sample( bsat, s );
+            EXPECT_NEAR( fminf( s.x, 0.999999f ), t.x, 10 * EPS );
+            EXPECT_NEAR( fminf( s.y, 0.999999f ), t.y, 10 * EPS );
+        }
+    }
+    freeBlockedSummedAreaTableHost( bsat );
+}
+
+TEST_F( TestISummedAreaTable, TestBlockedSearchNonUniform )
+{
+    // Only the top left quarter is lit, and it doesn't align with the (partial) blocks.
+    const int width = 45;
+    const int height = 37;
+    std::vector<float> pdf( width * height, 0.0f );
+    for( int y = 0; y < 18; ++y )
+        for( int x = 0; x < 22; ++x )
+            pdf[y * width + x] = 1.0f + ( x + y ) % 3;
+    BlockedSummedAreaTable bsat;
+    allocBlockedSummedAreaTableHost( bsat, width, height, 8 );
+    initBlockedSummedAreaTable( bsat, pdf.data() );
+
+    // Samples land in the lit region, in proportion to the pdf of each block.
+    std::mt19937 rng( 3 );
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    std::vector<int> counts( bsat.blockSums.width * bsat.blockSums.height, 0 );
+    const int numSamples = 100000;
+    for( int i = 0; i < numSamples; ++i )
+    {
+        const float2 t = sample( bsat, float2{ uniform( rng ), uniform( rng ) } );
+        const int x = static_cast<int>( t.x * width );
+        const int y = static_cast<int>( t.y * height );
+        ASSERT_LT( x, 22 );
+        ASSERT_LT( y, 18 );
+        ++counts[( y / 8 ) * bsat.blockSums.width + x / 8];
+    }
+    double total = 0.0;
+    for( float value : pdf )
+        total += value;
+    for( int by = 0; by < bsat.blockSums.height; ++by )
+    {
+        for( int bx = 0; bx < bsat.blockSums.width; ++bx )
+        {
+            double blockSum = 0.0;
+            for( int y = by * 8; y < std::min( height, by * 8 + 8 ); ++y )
+                for( int x = bx * 8; x < std::min( width, bx * 8 + 8 ); ++x )
+                    blockSum += pdf[y * width + x];
+            EXPECT_NEAR( blockSum / total, counts[by * bsat.blockSums.width + bx] / double( numSamples ), 0.01 );
+        }
+    }
+    freeBlockedSummedAreaTableHost( bsat );
+}
+
+TEST_F( TestISummedAreaTable, TestBlockedUpdateMatchesRebuild )
+{
+    const int width = 317;
+    const int height = 163;
+    std::mt19937 rng( 9 );
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    std::vector<float> pdf( width * height );
+    for( float& value : pdf )
+        value = uniform( rng );
+
+    BlockedSummedAreaTable bsat;
+    allocBlockedSummedAreaTableHost( bsat, width, height, 32 );
+    double scale = initBlockedSummedAreaTable( bsat, pdf.data(), 1, 2.0 );
+    BlockedSummedAreaTable rebuilt;
+    allocBlockedSummedAreaTableHost( rebuilt, width, height, 32 );
+    const size_t blockEntries = static_cast<size_t>( bsat.blockSums.width ) * bsat.blockSums.height;
+    auto expectEqualTables = [&]() {
+        for( int by = 0; by < bsat.blockSums.height; ++by )
+        {
+            for( int bx = 0; bx < bsat.blockSums.width; ++bx )
+            {
+                const ISummedAreaTable a = bsat.block( bx, by );
+                const ISummedAreaTable b = rebuilt.block( bx, by );
+                EXPECT_EQ( 0, memcmp( a.table, b.table, a.width * a.height * sizeof(unsigned int) ) );
+                EXPECT_EQ( 0, memcmp( a.columnSums, b.columnSums, a.width * a.height * sizeof(unsigned int) ) );
+            }
+        }
+        EXPECT_EQ( 0, memcmp( rebuilt.blockSums.table, bsat.blockSums.table, blockEntries * sizeof(unsigned int) ) );
+        EXPECT_EQ( 0, memcmp( rebuilt.blockSums.columnSums, bsat.blockSums.columnSums, blockEntries * sizeof(unsigned int) ) );
+    };
+    const int rects[4][4] = { { 10, 5, 30, 20 }, { 0, 150, 316, 162 }, { 300, 0, 316, 3 }, { 0, 0, 0, 0 } };
+    for( const int* rect : rects )
+    {
+        for( int y = rect[1]; y <= rect[3]; ++y )
+            for( int x = rect[0]; x <= rect[2]; ++x )
+                pdf[y * width + x] = 2.0f * uniform( rng );
+        EXPECT_TRUE( updateBlockedSummedAreaTable( bsat, scale, pdf.data(), rect[0], rect[1], rect[2], rect[3], 2 ) );
+        initBlockedSummedAreaTableWithScale( rebuilt, pdf.data(), scale );
+        expectEqualTables();
+    }
+
+    // Brightening past the headroom rebuilds the table.
+    for( int y = 40; y < 100; ++y )
+        for( int x = 40; x < 100; ++x )
+            pdf[y * width + x] = 1000.0f;
+    EXPECT_FALSE( updateBlockedSummedAreaTable( bsat, scale, pdf.data(), 40, 40, 99, 99 ) );
+    EXPECT_EQ( initBlockedSummedAreaTable( rebuilt, pdf.data(), 1, 2.0 ), scale );
+    expectEqualTables();
+
+    freeBlockedSummedAreaTableHost( rebuilt );
+    freeBlockedSummedAreaTableHost( bsat );
+}
+
+TEST_F( TestISummedAreaTable, DISABLED_benchmarkBuildTime )
+{
+    for( int width : { 1024, 4096, 8192 } )
+    {
+        const int height = width / 2;
+        std::vector<float> pdf( width * height );
+        for( int i = 0; i < width * height; ++i )
+            pdf[i] = static_cast<float>( ( static_cast<long long>( i ) * 7919 ) % 1000 );
+
+        ISummedAreaTable sat;
+        allocISummedAreaTableHost( sat, width, height );
+        for( int numThreads : { 1, 2, 4, 8, 16 } )
+        {
+            const auto start = std::chrono::steady_clock::now();
+            initISummedAreaTable( sat, pdf.data(), numThreads );
+            const double ms = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+            printf( "initISummedAreaTable %dx%d, %2d threads: %8.2f ms\n", width, height, numThreads, ms );
+        }
+        freeISummedAreaTableHost( sat );
+    }
+}
+
+TEST_F( TestISummedAreaTable, DISABLED_benchmarkUpdateTime )
+{
+    const int width = 8192;
+    const int height = 4096;
+    std::vector<float> pdf( width * height );
+    for( int i = 0; i < width * height; ++i )
+        pdf[i] = static_cast<float>( ( static_cast<long long>( i ) * 7919 ) % 1000 );
+
+    ISummedAreaTable sat;
+    allocISummedAreaTableHost( sat, width, height );
+    const auto fullStart = std::chrono::steady_clock::now();
+    double scale = initISummedAreaTable( sat, pdf.data(), 1, 2.0 );
+    const double fullMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - fullStart ).count();
+    printf( "initISummedAreaTable %dx%d: %8.2f ms\n", width, height, fullMs );
+
+    BlockedSummedAreaTable bsat;
+    allocBlockedSummedAreaTableHost( bsat, width, height );
+    const auto blockedStart = std::chrono::steady_clock::now();
+    double blockedScale = initBlockedSummedAreaTable( bsat, pdf.data(), 1, 2.0 );
+    const double blockedMs = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - blockedStart ).count();
+    printf( "initBlockedSummedAreaTable %dx%d: %8.2f ms\n", width, height, blockedMs );
+
+    // Brush strokes of different sizes at random places.  The cost of an update depends on the
+    // size of the suffix of the table below and to the right of the stroke.
+    std::mt19937 rng( 1 );
+    for( int brush : { 16, 64, 256 } )
+    {
+        const int numStrokes = 32;
+        double ms = 0.0;
+        double blockedMs = 0.0;
+        int rebuilds = 0;
+        for( int stroke = 0; stroke < numStrokes; ++stroke )
+        {
+            const int x0 = std::uniform_int_distribution<int>( 0, width - brush )( rng );
+            const int y0 = std::uniform_int_distribution<int>( 0, height - brush )( rng );
+            for( int y = y0; y < y0 + brush; ++y )
+                for( int x = x0; x < x0 + brush; ++x )
+                    pdf[y * width + x] = static_cast<float>( ( x * 31 + y ) % 1000 );
+            const auto start = std::chrono::steady_clock::now();
+            rebuilds += updateISummedAreaTable( sat, scale, pdf.data(), x0, y0, x0 + brush - 1, y0 + brush - 1 ) ? 0 : 1;
+            const auto blockedStart = std::chrono::steady_clock::now();
+            rebuilds += updateBlockedSummedAreaTable( bsat, blockedScale, pdf.data(), x0, y0, x0 + brush - 1, y0 + brush - 1 ) ? 0 : 1;
+            ms += std::chrono::duration<double, std::milli>( blockedStart - start ).count();
+            blockedMs += std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - blockedStart ).count();
+        }
+        printf( "updateISummedAreaTable %dx%d, %3dx%-3d rect: %8.3f ms (%6.1fx faster than a rebuild)\n",
+                width, height, brush, brush, ms / numStrokes, fullMs * numStrokes / ms );
+        printf( "updateBlockedSummedAreaTable %dx%d, %3dx%-3d rect: %8.3f ms (%6.1fx faster than a rebuild, %d rebuilds)\n",
+                width, height, brush, brush, blockedMs / numStrokes, fullMs * numStrokes / blockedMs, rebuilds );
+    }
+    freeBlockedSummedAreaTableHost( bsat );
+    freeISummedAreaTableHost( sat );
+}
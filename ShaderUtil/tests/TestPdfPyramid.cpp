@@ -0,0 +1,217 @@
+// SPDX-FileCopyrightText: Copyright (c) 2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+// SPDX-License-Identifier: BSD-3-Clause
+//
+
+#include <stdio.h>
+#include <OptiXToolkit/ShaderUtil/CdfInversionTable.h>
+#include <OptiXToolkit/ShaderUtil/PdfPyramid.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+class TestPdfPyramid : public testing::Test
+{
+  public:
+    std::vector<float> makePdf( int width, int height );
+};
+
+// A pdf with a smooth gradient, a dark (zero) quadrant, and a few very bright texels.
+std::vector<float> TestPdfPyramid::makePdf( int width, int height )
+{
+    std::mt19937 rng( 11 );
+    std::uniform_real_distribution<float> noise( 0.0f, 1.0f );
+    std::vector<float> pdf( width * height );
+    for( int j = 0; j < height; ++j )
+    {
+        for( int i = 0; i < width; ++i )
+        {
+            float value = ( i < width / 2 && j >= height / 2 ) ? 0.0f : 0.1f + float( i + j ) / ( width + height ) * noise( rng );
+            if( noise( rng ) < 0.002f )
+                value = 500.0f;
+            pdf[j * width + i] = value;
+        }
+    }
+    return pdf;
+}
+
+TEST_F( TestPdfPyramid, TestLevels )
+{
+    PdfPyramid pp;
+    setPdfPyramidSize( pp, 1024, 512, 16, 8 );
+    EXPECT_EQ( 6, pp.numLevels );
+    EXPECT_EQ( 16, pp.topWidth );
+    EXPECT_EQ( 8, pp.topHeight );
+    EXPECT_EQ( size_t( 1024 * 512 + 512 * 256 + 256 * 128 + 128 * 64 + 64 * 32 + 32 * 16 ), getPdfPyramidNumFractions( pp ) );
+
+    // Halving stops at the requested top size, or when a dimension becomes odd.
+    setPdfPyramidSize( pp, 1024, 512, 20, 8 );
+    EXPECT_EQ( 32, pp.topWidth );
+    setPdfPyramidSize( pp, 96, 40, 1, 1 );
+    EXPECT_EQ( 3, pp.numLevels );
+    EXPECT_EQ( 12, pp.topWidth );
+    EXPECT_EQ( 5, pp.topHeight );
+}
+
+TEST_F( TestPdfPyramid, TestPdfMatchesInput )
+{
+    const int width = 256;
+    const int height = 128;
+    const std::vector<float> pdf = makePdf( width, height );
+    double sum = 0.0;
+    for( float value : pdf )
+        sum += value;
+
+    PdfPyramid pp;
+    allocPdfPyramidHost( pp, width, height, 4, 2 );
+    initPdfPyramid( pp, pdf.data() );
+    EXPECT_EQ( 6, pp.numLevels );
+
+    // The pdf is normalized, zero where the input is zero, and within quantization of the input
+    // elsewhere, which is coarsest for texels much dimmer than their neighbors.
+    double integral = 0.0;
+    for( int j = 0; j < height; ++j )
+    {
+        for( int i = 0; i < width; ++i )
+        {
+            const float value = evalPdfPyramid( pp, float2{ ( i + 0.5f ) / width, ( j + 0.5f ) / height } );
+            const double expected = pdf[j * width + i] / sum * width * height;
+            if( expected == 0.0 )
+                ASSERT_EQ( 0.0f, value );
+            else
+                ASSERT_NEAR( expected, value, 2e-3 * expected ) << i << ", " << j;
+            integral += value;
+        }
+    }
+    EXPECT_NEAR( 1.0, integral / ( width * height ), 1e-5 );
+
+    freePdfPyramidHost( pp );
+}
+
+TEST_F( TestPdfPyramid, TestSamplePdfIsExact )
+{
+    const int width = 64;
+    const int height = 32;
+    const std::vector<float> pdf = makePdf( width, height );
+
+    PdfPyramid pp;
+    allocPdfPyramidHost( pp, width, height, 2, 1 );
+    initPdfPyramid( pp, pdf.data() );
+
+    // The pdf returned by each sample matches evaluation, and the histogram of samples matches it.
+    const int numSamples = 1 << 20;
+    std::mt19937 rng( 13 );
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    std::vector<int> histogram( width * height, 0 );
+    for( int i = 0; i < numSamples; ++i )
+    {
+        float samplePdf = 0.0f;
+        const float2 uv = samplePdfPyramid( pp, float2{ uniform( rng ), uniform( rng ) }, &samplePdf );
+        ASSERT_TRUE( uv.x >= 0.0f && uv.x < 1.0f && uv.y >= 0.0f && uv.y < 1.0f );
+        ASSERT_EQ( evalPdfPyramid( pp, uv ), samplePdf );
+        ASSERT_GT( samplePdf, 0.0f );
+        histogram[static_cast<int>( uv.y * height ) * width + static_cast<int>( uv.x * width )]++;
+    }
+
+    // Each texel gets its expected count to within five standard deviations.
+    for( int j = 0; j < height; ++j )
+    {
+        for( int i = 0; i < width; ++i )
+        {
+            const double expected = evalPdfPyramid( pp, float2{ ( i + 0.5f ) / width, ( j + 0.5f ) / height } ) * double( numSamples ) / ( width * height );
+            EXPECT_NEAR( expected, histogram[j * width + i], 5.0 * sqrt( expected ) + 1.0 ) << i << ", " << j;
+        }
+    }
+
+    // The warp is continuous, so nearby samples map to nearby points away from texel boundaries.
+    const float2 a = samplePdfPyramid( pp, float2{ 0.3f, 0.6f } );
+    const float2 b = samplePdfPyramid( pp, float2{ 0.3f + 1e-6f, 0.6f + 1e-6f } );
+    EXPECT_NEAR( a.x, b.x, 1e-3f );
+    EXPECT_NEAR( a.y, b.y, 1e-3f );
+
+    freePdfPyramidHost( pp );
+}
+
+TEST_F( TestPdfPyramid, TestZeroPdfIsUniform )
+{
+    std::vector<float> pdf( 32 * 16, 0.0f );
+    PdfPyramid pp;
+    allocPdfPyramidHost( pp, 32, 16, 4, 2 );
+    initPdfPyramid( pp, pdf.data() );
+    EXPECT_NEAR( 1.0f, evalPdfPyramid( pp, float2{ 0.3f, 0.7f } ), 1e-4f );
+    float samplePdf = 0.0f;
+    const float2 uv = samplePdfPyramid( pp, float2{ 0.25f, 0.75f }, &samplePdf );
+    EXPECT_NEAR( 0.25f, uv.x, 1e-4f );
+    EXPECT_NEAR( 0.75f, uv.y, 1e-4f );
+    EXPECT_NEAR( 1.0f, samplePdf, 1e-4f );
+    freePdfPyramidHost( pp );
+}
+
+TEST_F( TestPdfPyramid, TestParallelMatchesSerial )
+{
+    const int width = 256;
+    const int height = 128;
+    const std::vector<float> pdf = makePdf( width, height );
+
+    PdfPyramid serial;
+    allocPdfPyramidHost( serial, width, height, 8, 4 );
+    initPdfPyramid( serial, pdf.data() );
+    PdfPyramid pp;
+    allocPdfPyramidHost( pp, width, height, 8, 4 );
+    initPdfPyramid( pp, pdf.data(), 3 );
+    EXPECT_EQ( 0, memcmp( serial.fractions, pp.fractions, getPdfPyramidNumFractions( pp ) * sizeof( unsigned short ) ) );
+    EXPECT_EQ( 0, memcmp( serial.topCdfRows, pp.topCdfRows, pp.topWidth * pp.topHeight * sizeof( float ) ) );
+    EXPECT_EQ( 0, memcmp( serial.topCdfMarginal, pp.topCdfMarginal, pp.topHeight * sizeof( float ) ) );
+    freePdfPyramidHost( pp );
+    freePdfPyramidHost( serial );
+}
+
+TEST_F( TestPdfPyramid, DISABLED_benchmarkSamplesPerSecond )
+{
+    const int width = 8192;
+    const int height = 4096;
+    const std::vector<float> pdf = makePdf( width, height );
+    const int numSamples = 1 << 24;
+    std::mt19937 rng( 1 );
+    std::uniform_real_distribution<float> uniform( 0.0f, 1.0f );
+    std::vector<float2> xi( 1 << 16 );
+    for( float2& sample : xi )
+        sample = float2{ uniform( rng ), uniform( rng ) };
+
+    for( int topWidth : { 16, 64, 256 } )
+    {
+        PdfPyramid pp;
+        allocPdfPyramidHost( pp, width, height, topWidth, topWidth / 2 );
+        initPdfPyramid( pp, pdf.data(), 0 );
+        float checksum = 0.0f;
+        const auto start = std::chrono::steady_clock::now();
+        for( int i = 0; i < numSamples; ++i )
+        {
+            float samplePdf;
+            const float2 uv = samplePdfPyramid( pp, xi[i & ( xi.size() - 1 )], &samplePdf );
+            checksum += uv.x + samplePdf * 1e-9f;
+        }
+        const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+        printf( "PdfPyramid %dx%d, top %dx%d: %6.1f M samples/s (%1.2f bytes/texel) %f\n", width, height, pp.topWidth,
+                pp.topHeight, numSamples / seconds * 1e-6,
+                ( getPdfPyramidNumFractions( pp ) * 2.0 + ( pp.topWidth + 1 ) * pp.topHeight * 4.0 ) / ( double( width ) * height ), checksum );
+        freePdfPyramidHost( pp );
+    }
+
+    // The binary search sampler of a CdfInversionTable for reference.
+    CdfInversionTable cit;
+    allocCdfInversionTableHost( cit, width, height );
+    memcpy( cit.cdfRows, pdf.data(), width * height * sizeof( float ) );
+    invertPdf2D( cit, 0 );
+    float checksum = 0.0f;
+    const auto start = std::chrono::steady_clock::now();
+    for( int i = 0; i < numSamples; ++i )
+    {
+        const float2 uv = sampleCdfBinSearch( cit, xi[i & ( xi.size() - 1 )] );
+        checksum += uv.x;
+    }
+    const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    printf( "CdfInversionTable binary search %dx%d: %6.1f M samples/s %f\n", width, height, numSamples / seconds * 1e-6, checksum );
+    freeCdfInversionTableHost( cit );
+}
@@ -67,3 +67,28 @@ TEST_F( TestPdfTable, TestBrightnessModes )
     makePdfTable<float4>( pdf.data(), emap.data(), &aveBrightness, w, h, pbRGBSUM, paNONE );
     EXPECT_EQ( pdf[0], 1+2+3 );
 }
+
+TEST_F( TestPdfTable, TestParallelMatchesSerial )
+{
+    int w = 37;
+    int h = 23;
+    std::vector<float4> emap( w * h );
+    for( int i = 0; i < w * h; ++i )
+        emap[i] = float4{ float( i % 7 ), float( i % 11 ), float( i % 13 ), 0.0f };
+    std::vector<float> serialPdf( w * h );
+    std::vector<float> pdf( w * h );
+
+    for( PdfAngleType angleType : { paNONE, paLATLONG, paCUBEMAP } )
+    {
+        float serialAve = 0.0f;
+        makePdfTable<float4>( serialPdf.data(), emap.data(), &serialAve, w, h, pbLUMINANCE, angleType );
+        for( int numThreads : { 2, 4, 0 } )
+        {
+            // The pdf is identical, and the average differs only by the rounding of partial sums.
+            float aveBrightness = 0.0f;
+            makePdfTable<float4>( pdf.data(), emap.data(), &aveBrightness, w, h, pbLUMINANCE, angleType, numThreads );
+            EXPECT_TRUE( pdf == serialPdf );
+            EXPECT_NEAR( serialAve, aveBrightness, 1e-6f * serialAve );
+        }
+    }
+}
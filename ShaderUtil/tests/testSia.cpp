@@ -4,7 +4,13 @@
 
 #include "testSia.h"
 
+#include <OptiXToolkit/ShaderUtil/HostSelfIntersectionAvoidance.h>
+
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
 #include <vector>
 #include <cmath>
 
@@ -692,3 +698,291 @@ TEST_F( SelfIntersectionAvoidanceTest, InstInst )
     opt.transforms.push_back( getInstance() );
     runTest( opt, "SelfIntersectionAvoidanceTest_InstInst" );
 }
+
+namespace {  // anonymous
+
+// Host spawn point batches, as structures of arrays.
+struct HostSpawnPoints
+{
+    explicit HostSpawnPoints( unsigned int count )
+        : data( 17 * count )
+    {
+        float* p = data.data();
+        for( unsigned int c = 0; c < 3; ++c )
+        {
+            v0[c]       = p + ( 0 + c ) * count;
+            v1[c]       = p + ( 3 + c ) * count;
+            v2[c]       = p + ( 6 + c ) * count;
+            position[c] = p + ( 9 + c ) * count;
+            normal[c]   = p + ( 12 + c ) * count;
+        }
+        bary[0] = p + 15 * count;
+        bary[1] = p + 16 * count;
+        offset.resize( count );
+    }
+
+    HostSpawnPoints( const HostSpawnPoints& other )
+        : HostSpawnPoints( static_cast<unsigned int>( other.offset.size() ) )
+    {
+        data   = other.data;
+        offset = other.offset;
+    }
+
+    HostSpawnPoints& operator=( const HostSpawnPoints& ) = delete;
+
+    SelfIntersectionAvoidance::TriangleBatch triangles() const
+    {
+        return { { v0[0], v0[1], v0[2] }, { v1[0], v1[1], v1[2] }, { v2[0], v2[1], v2[2] }, { bary[0], bary[1] } };
+    }
+
+    SelfIntersectionAvoidance::SpawnOffsetBatch spawn()
+    {
+        return { { position[0], position[1], position[2] }, { normal[0], normal[1], normal[2] }, offset.data() };
+    }
+
+    std::vector<float> data;
+    std::vector<float> offset;
+    float*             v0[3];
+    float*             v1[3];
+    float*             v2[3];
+    float*             bary[2];
+    float*             position[3];
+    float*             normal[3];
+};
+
+// Random triangles of varying size and position, with random barycentrics.
+HostSpawnPoints getRandomSpawnPoints( unsigned int count, std::mt19937& rng )
+{
+    std::uniform_real_distribution<float> unit( 0.f, 1.f );
+    std::uniform_real_distribution<float> signedUnit( -1.f, 1.f );
+    HostSpawnPoints                       points( count );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        const float center = 100.f * signedUnit( rng );
+        const float size   = std::pow( 10.f, 3.f * signedUnit( rng ) );
+        for( unsigned int c = 0; c < 3; ++c )
+        {
+            points.v0[c][i] = center + size * signedUnit( rng );
+            points.v1[c][i] = center + size * signedUnit( rng );
+            points.v2[c][i] = center + size * signedUnit( rng );
+        }
+        const float u = unit( rng );
+        const float v = unit( rng );
+        points.bary[0][i] = u + v > 1.f ? 1.f - u : u;
+        points.bary[1][i] = u + v > 1.f ? 1.f - v : v;
+    }
+    return points;
+}
+
+// Random affine object to world transforms, with world to object transforms inverted in double precision.
+void getRandomTransforms( std::vector<otk::Transform4>& o2w, std::vector<otk::Transform4>& w2o, unsigned int count, std::mt19937& rng )
+{
+    std::uniform_real_distribution<float> signedUnit( -1.f, 1.f );
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        double m[3][4];
+        for( unsigned int r = 0; r < 3; ++r )
+        {
+            for( unsigned int c = 0; c < 3; ++c )
+                m[r][c] = static_cast<float>( ( r == c ? 2.f : 0.f ) + signedUnit( rng ) );
+            m[r][3] = static_cast<float>( 1000.f * signedUnit( rng ) );
+        }
+        const double det = m[0][0] * ( m[1][1] * m[2][2] - m[1][2] * m[2][1] ) - m[0][1] * ( m[1][0] * m[2][2] - m[1][2] * m[2][0] )
+                           + m[0][2] * ( m[1][0] * m[2][1] - m[1][1] * m[2][0] );
+        double inv[3][4];
+        for( unsigned int r = 0; r < 3; ++r )
+        {
+            for( unsigned int c = 0; c < 3; ++c )
+            {
+                const unsigned int r1 = ( c + 1 ) % 3, r2 = ( c + 2 ) % 3, c1 = ( r + 1 ) % 3, c2 = ( r + 2 ) % 3;
+                inv[r][c] = ( m[r1][c1] * m[r2][c2] - m[r1][c2] * m[r2][c1] ) / det;
+            }
+        }
+        for( unsigned int r = 0; r < 3; ++r )
+            inv[r][3] = -( inv[r][0] * m[0][3] + inv[r][1] * m[1][3] + inv[r][2] * m[2][3] );
+
+        otk::Transform4 forward, inverse;
+        float4*         fwdRows[3] = { &forward.m[0], &forward.m[1], &forward.m[2] };
+        float4*         invRows[3] = { &inverse.m[0], &inverse.m[1], &inverse.m[2] };
+        for( unsigned int r = 0; r < 3; ++r )
+        {
+            *fwdRows[r] = make_float4( float( m[r][0] ), float( m[r][1] ), float( m[r][2] ), float( m[r][3] ) );
+            *invRows[r] = make_float4( float( inv[r][0] ), float( inv[r][1] ), float( inv[r][2] ), float( inv[r][3] ) );
+        }
+        forward.m[3] = inverse.m[3] = make_float4( 0.f, 0.f, 0.f, 1.f );
+        o2w.push_back( forward );
+        w2o.push_back( inverse );
+    }
+}
+
+Matrix3x4 toMatrix3x4( const otk::Transform4& t )
+{
+    return { t.m[0], t.m[1], t.m[2] };
+}
+
+// Signed distance of a world space point, transformed to object space, from the triangle plane, in
+// double precision.
+double planeDistance( const HostSpawnPoints& points, unsigned int i, const otk::Transform4& w2o, const float3& p )
+{
+    double q[3];
+    const float4* rows[3] = { &w2o.m[0], &w2o.m[1], &w2o.m[2] };
+    for( unsigned int r = 0; r < 3; ++r )
+        q[r] = double( rows[r]->x ) * p.x + double( rows[r]->y ) * p.y + double( rows[r]->z ) * p.z + rows[r]->w;
+    double e1[3], e2[3], d[3];
+    for( unsigned int c = 0; c < 3; ++c )
+    {
+        e1[c] = double( points.v1[c][i] ) - points.v0[c][i];
+        e2[c] = double( points.v2[c][i] ) - points.v0[c][i];
+        d[c]  = q[c] - points.v0[c][i];
+    }
+    const double n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+    return n[0] * d[0] + n[1] * d[1] + n[2] * d[2];
+}
+
+} // namespace
+
+TEST( SelfIntersectionAvoidanceHost, BatchMatchesScalar )
+{
+    using namespace SelfIntersectionAvoidance;
+
+    const unsigned int           count = 10000;
+    std::mt19937                 rng( 7 );
+    HostSpawnPoints              points = getRandomSpawnPoints( count, rng );
+    std::vector<otk::Transform4> o2w, w2o;
+    getRandomTransforms( o2w, w2o, 4, rng );
+    std::vector<unsigned int> transformIndices( count );
+    for( unsigned int i = 0; i < count; ++i )
+        transformIndices[i] = rng() % 4;
+
+    // object space, then world space
+    getSafeTriangleSpawnOffsetBatch( points.spawn(), points.triangles(), count );
+    HostSpawnPoints objectPoints = points;
+    HostSpawnPoints worldPoints  = points;
+    transformSafeSpawnOffsetBatch( worldPoints.spawn(), objectPoints.spawn(), o2w.data(), w2o.data(), transformIndices.data(), count );
+
+    // in place transforms give the same result
+    transformSafeSpawnOffsetBatch( points.spawn(), points.spawn(), o2w.data(), w2o.data(), transformIndices.data(), count );
+    ASSERT_EQ( 0, memcmp( worldPoints.data.data(), points.data.data(), worldPoints.data.size() * sizeof( float ) ) );
+    ASSERT_EQ( 0, memcmp( worldPoints.offset.data(), points.offset.data(), count * sizeof( float ) ) );
+
+    // without indices, all points use the first transform
+    HostSpawnPoints singlePoints = objectPoints;
+    transformSafeSpawnOffsetBatch( singlePoints.spawn(), singlePoints.spawn(), o2w.data(), w2o.data(), nullptr, count );
+
+    std::vector<float> front( 3 * count ), back( 3 * count );
+    float*             frontXyz[3] = { &front[0], &front[count], &front[2 * count] };
+    float*             backXyz[3]  = { &back[0], &back[count], &back[2 * count] };
+    offsetSpawnPointBatch( frontXyz, backXyz, worldPoints.spawn(), count );
+
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        float3 objP, objN;
+        float  objOffset;
+        getSafeTriangleSpawnOffsetHost( objP, objN, objOffset, make_float3( points.v0[0][i], points.v0[1][i], points.v0[2][i] ),
+                                        make_float3( points.v1[0][i], points.v1[1][i], points.v1[2][i] ),
+                                        make_float3( points.v2[0][i], points.v2[1][i], points.v2[2][i] ),
+                                        make_float2( points.bary[0][i], points.bary[1][i] ) );
+        ASSERT_EQ( 0, memcmp( &objOffset, &objectPoints.offset[i], sizeof( float ) ) ) << i;
+        for( unsigned int c = 0; c < 3; ++c )
+        {
+            ASSERT_EQ( 0, memcmp( &( &objP.x )[c], &objectPoints.position[c][i], sizeof( float ) ) ) << i;
+            ASSERT_EQ( 0, memcmp( &( &objN.x )[c], &objectPoints.normal[c][i], sizeof( float ) ) ) << i;
+        }
+
+        for( unsigned int t : { transformIndices[i], 0U } )
+        {
+            const HostSpawnPoints& batch = t == transformIndices[i] ? worldPoints : singlePoints;
+            float3                 wldP, wldN;
+            float                  wldOffset;
+            transformSafeSpawnOffsetHost( wldP, wldN, wldOffset, objP, objN, objOffset, toMatrix3x4( o2w[t] ), toMatrix3x4( w2o[t] ) );
+            ASSERT_EQ( 0, memcmp( &wldOffset, &batch.offset[i], sizeof( float ) ) ) << i;
+            for( unsigned int c = 0; c < 3; ++c )
+            {
+                ASSERT_EQ( 0, memcmp( &( &wldP.x )[c], &batch.position[c][i], sizeof( float ) ) ) << i;
+                ASSERT_EQ( 0, memcmp( &( &wldN.x )[c], &batch.normal[c][i], sizeof( float ) ) ) << i;
+            }
+        }
+
+        float3 wldP = make_float3( worldPoints.position[0][i], worldPoints.position[1][i], worldPoints.position[2][i] );
+        float3 wldN = make_float3( worldPoints.normal[0][i], worldPoints.normal[1][i], worldPoints.normal[2][i] );
+        float3 frontP, backP;
+        offsetSpawnPointHost( frontP, backP, wldP, wldN, worldPoints.offset[i] );
+        for( unsigned int c = 0; c < 3; ++c )
+        {
+            ASSERT_EQ( 0, memcmp( &( &frontP.x )[c], &front[c * count + i], sizeof( float ) ) ) << i;
+            ASSERT_EQ( 0, memcmp( &( &backP.x )[c], &back[c * count + i], sizeof( float ) ) ) << i;
+        }
+    }
+}
+
+TEST( SelfIntersectionAvoidanceHost, OffsetsSeparateSurface )
+{
+    using namespace SelfIntersectionAvoidance;
+
+    const unsigned int           count = 100000;
+    std::mt19937                 rng( 11 );
+    HostSpawnPoints              points = getRandomSpawnPoints( count, rng );
+    std::vector<otk::Transform4> o2w, w2o;
+    getRandomTransforms( o2w, w2o, 8, rng );
+    std::vector<unsigned int> transformIndices( count );
+    for( unsigned int i = 0; i < count; ++i )
+        transformIndices[i] = rng() % 8;
+
+    getSafeTriangleSpawnOffsetBatch( points.spawn(), points.triangles(), count );
+    transformSafeSpawnOffsetBatch( points.spawn(), points.spawn(), o2w.data(), w2o.data(), transformIndices.data(), count );
+    std::vector<float> front( 3 * count ), back( 3 * count );
+    float*             frontXyz[3] = { &front[0], &front[count], &front[2 * count] };
+    float*             backXyz[3]  = { &back[0], &back[count], &back[2 * count] };
+    offsetSpawnPointBatch( frontXyz, backXyz, points.spawn(), count );
+
+    // The front and back spawn points lie on either side of the triangle, back in object space.
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        const otk::Transform4& t = w2o[transformIndices[i]];
+        EXPECT_LT( 0.0, planeDistance( points, i, t, make_float3( front[i], front[count + i], front[2 * count + i] ) ) ) << i;
+        EXPECT_GT( 0.0, planeDistance( points, i, t, make_float3( back[i], back[count + i], back[2 * count + i] ) ) ) << i;
+    }
+}
+
+TEST( SelfIntersectionAvoidanceHost, DISABLED_benchmarkPointsPerSecond )
+{
+    using namespace SelfIntersectionAvoidance;
+
+    const unsigned int           count = 1 << 20;
+    std::mt19937                 rng( 3 );
+    HostSpawnPoints              points = getRandomSpawnPoints( count, rng );
+    std::vector<otk::Transform4> o2w, w2o;
+    getRandomTransforms( o2w, w2o, 16, rng );
+    std::vector<unsigned int> transformIndices( count );
+    for( unsigned int i = 0; i < count; ++i )
+        transformIndices[i] = rng() % 16;
+    std::vector<float> front( 3 * count ), back( 3 * count );
+    float*             frontXyz[3] = { &front[0], &front[count], &front[2 * count] };
+    float*             backXyz[3]  = { &back[0], &back[count], &back[2 * count] };
+
+    auto start = std::chrono::steady_clock::now();
+    for( unsigned int i = 0; i < count; ++i )
+    {
+        float3 p, n, frontP, backP;
+        float  offset;
+        getSafeTriangleSpawnOffsetHost( p, n, offset, make_float3( points.v0[0][i], points.v0[1][i], points.v0[2][i] ),
+                                        make_float3( points.v1[0][i], points.v1[1][i], points.v1[2][i] ),
+                                        make_float3( points.v2[0][i], points.v2[1][i], points.v2[2][i] ),
+                                        make_float2( points.bary[0][i], points.bary[1][i] ) );
+        const unsigned int t = transformIndices[i];
+        transformSafeSpawnOffsetHost( p, n, offset, p, n, offset, toMatrix3x4( o2w[t] ), toMatrix3x4( w2o[t] ) );
+        offsetSpawnPointHost( frontP, backP, p, n, offset );
+        front[i] = frontP.x, front[count + i] = frontP.y, front[2 * count + i] = frontP.z;
+        back[i] = backP.x, back[count + i] = backP.y, back[2 * count + i] = backP.z;
+    }
+    const double scalarSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    start = std::chrono::steady_clock::now();
+    getSafeTriangleSpawnOffsetBatch( points.spawn(), points.triangles(), count );
+    transformSafeSpawnOffsetBatch( points.spawn(), points.spawn(), o2w.data(), w2o.data(), transformIndices.data(), count );
+    offsetSpawnPointBatch( frontXyz, backXyz, points.spawn(), count );
+    const double batchSeconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    std::cout << "scalar: " << count / scalarSeconds * 1e-6 << " M points/s\n";
+    std::cout << "batch:  " << count / batchSeconds * 1e-6 << " M points/s\n";
+}
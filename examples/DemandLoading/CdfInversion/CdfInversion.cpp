@@ -159,44 +159,47 @@ void CdfInversionApp::createTexture()
     imageSource->readMipLevel( imgData, m_tableMipLevel, tableWidth, tableHeight, CUstream{0} );
     printf( "Time to load image: %0.4f sec.\n", elapsed( imageLoadStart ) );
 
+    // Build the tables with all the hardware threads.
+    const int numThreads = 0;
+
     TIMEPOINT makePdfStart = now();
     float* pdf = reinterpret_cast<float*>( malloc( tableWidth * tableHeight * sizeof(float) ) );
     if( texInfo.format == CU_AD_FORMAT_UNSIGNED_INT8 )
     {
         makePdfTable<uchar4>( pdf, (uchar4*)imgData, &hostEmapInversionTable.aveValue, 
-                              tableWidth, tableHeight, pbLUMINANCE, paLATLONG );
+                              tableWidth, tableHeight, pbLUMINANCE, paLATLONG, numThreads );
     }
     else if( texInfo.format == CU_AD_FORMAT_HALF )
     {
         makePdfTable<half4>( pdf, (half4*)imgData, &hostEmapInversionTable.aveValue, 
-                             tableWidth, tableHeight, pbLUMINANCE, paLATLONG );
+                             tableWidth, tableHeight, pbLUMINANCE, paLATLONG, numThreads );
     } 
     else if( texInfo.format == CU_AD_FORMAT_FLOAT )
     {
         makePdfTable<float4>( pdf, (float4*)imgData, &hostEmapInversionTable.aveValue, 
-                             tableWidth, tableHeight, pbLUMINANCE, paLATLONG );
+                             tableWidth, tableHeight, pbLUMINANCE, paLATLONG, numThreads );
     }
     printf( "Time to make pdf table: %0.4f sec.\n", elapsed( makePdfStart ) );
 
     // Make summed area table on host
     TIMEPOINT makeSummedAreaTableStart = now();
-    initISummedAreaTable( hostEmapSummedAreaTable, pdf );
+    initISummedAreaTable( hostEmapSummedAreaTable, pdf, numThreads );
     printf( "Time to make summed area table: %0.4f sec.\n", elapsed( makeSummedAreaTableStart ) );
 
     // Make cdf table on host
     memcpy( hostEmapInversionTable.cdfRows, pdf, tableWidth * tableHeight * sizeof(float) );
     TIMEPOINT makeCdfStart = now();
-    invertPdf2D( hostEmapInversionTable );
+    invertPdf2D( hostEmapInversionTable, numThreads );
     printf( "Time to make cdf table: %0.4f sec.\n", elapsed( makeCdfStart ) );
 
     // Invert cdf table on  host
     TIMEPOINT invertCdfStart = now();
-    invertCdf2D( hostEmapInversionTable );
+    invertCdf2D( hostEmapInversionTable, numThreads );
     printf( "Time to invert cdf table: %0.4f sec.\n", elapsed( invertCdfStart ) );
 
     // Make alias table on host
     TIMEPOINT makeAliasTableStart = now();
-    makeAliasTable( hostEmapAliasTable, pdf );
+    makeAliasTable( hostEmapAliasTable, pdf, numThreads );
     printf( "Time to make alias table: %0.4f sec.\n", elapsed( makeAliasTableStart ) );
 
     // Copy tables to devices
@@ -8,6 +8,7 @@
 #include <OptiXToolkit/ImageSource/WrappedImageSource.h>
 
 #include <mutex>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -25,6 +26,12 @@ class PbrtAlphaMapImageSource : public imageSource::WrappedImageSource
 
     bool readTile( char* buffer, unsigned int mipLevel, const imageSource::Tile& tile, CUstream stream ) override;
 
+    /// Tiles are converted after they are read, so they are read synchronously.
+    std::future<bool> readTileAsync( char* buffer, unsigned int mipLevel, const imageSource::Tile& tile, CUstream stream ) override
+    {
+        return ImageSource::readTileAsync( buffer, mipLevel, tile, stream );
+    }
+
     bool readMipLevel( char* buffer, unsigned int mipLevel, unsigned int expectedWidth, unsigned int expectedHeight, CUstream stream ) override;
 
     bool readMipTail( char*        dest,
@@ -34,6 +41,22 @@ class PbrtAlphaMapImageSource : public imageSource::WrappedImageSource
                       unsigned int pixelSizeInBytes,
                       CUstream     stream ) override;
 
+    /// The texels are binarized alpha values rather than the colors of the file.
+    std::string getFileVariant() const override
+    {
+        const std::string variant = WrappedImageSource::getFileVariant();
+        return variant.empty() ? "pbrt-alpha" : variant + "/pbrt-alpha";
+    }
+
+    /// Partial mip levels are not converted, so they can't be read.
+    bool readScanlines( char* /*dest*/, unsigned int /*mipLevel*/, unsigned int /*firstRow*/, unsigned int /*numRows*/, CUstream /*stream*/ ) override
+    {
+        return false;
+    }
+
+    /// Partial mip levels are not converted, so they can't be read.
+    unsigned int getScanlineChunkHeight() const override { return 0; }
+
   private:
     void getBaseInfo();
     void convertBasePixels( char* buffer, unsigned int width, unsigned int height );
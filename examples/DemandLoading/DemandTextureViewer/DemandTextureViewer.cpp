@@ -65,7 +65,7 @@ ImageSourcePtr DemandTextureViewer::createImageSource( const std::string& textur
 
 void DemandTextureViewer::createTexture( const std::string& textureName, bool tile, bool mipmap )
 {
-    ImageSourcePtr imageSource( createImageSource( textureName, tile, mipmap ) );
+    ImageSourcePtr imageSource( shareImageTiles( createImageSource( textureName, tile, mipmap ) ) );
 
     demandLoading::TextureDescriptor texDesc = makeTextureDescriptor( CU_TR_ADDRESS_MODE_CLAMP, FILTER_BILINEAR );
     for( OTKAppPerDeviceOptixState& state : m_perDeviceOptixStates )
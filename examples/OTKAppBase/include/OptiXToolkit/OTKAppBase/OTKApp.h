@@ -16,6 +16,7 @@
 #include <OptiXToolkit/DemandLoading/TextureDescriptor.h>
 
 #include <OptiXToolkit/ImageSource/ImageSource.h>
+#include <OptiXToolkit/ImageSource/SharedTileCache.h>
 #include <OptiXToolkit/ImageSources/MultiCheckerImage.h>
 
 #include <OptiXToolkit/OTKAppBase/OTKAppShapeMaker.h>
@@ -44,6 +45,7 @@ class OTKApp
     void resetAccumulator();
     void setMipScale( float scale ) { m_mipScale = scale; }
     void setMaxSubframes( int maxSubframes ) { m_maxSubframes = maxSubframes; }
+    void setSharedTileCacheSize( size_t size ) { m_sharedTileCacheSize = size; }
 
     SurfaceTexture makeSurfaceTex( int kd, int kdtex, int ks, int kstex, int kt, int kttex, float roughness, float ior );
     void addShapeToScene( std::vector<Vert>& shape, unsigned int materialId );
@@ -70,6 +72,7 @@ class OTKApp
     // Demand loading and texturing system
     demandLoading::TextureDescriptor makeTextureDescriptor( CUaddress_mode addressMode, FilterMode filterMode );
     std::shared_ptr<imageSource::ImageSource> createExrImage( const std::string& filePath );
+    std::shared_ptr<imageSource::ImageSource> shareImageTiles( std::shared_ptr<imageSource::ImageSource> image );
     
     // OptiX launches
     virtual void initView();
@@ -113,6 +116,10 @@ class OTKApp
     bool                      m_useSparseTextures = true;
     bool                      m_useCascadingTextureSizes = false;
 
+    // Decoded tiles shared by the demand loaders of all devices
+    std::shared_ptr<imageSource::SharedTileCache> m_sharedTileCache;
+    size_t                                        m_sharedTileCacheSize = size_t( 1 ) << 30;
+
     // Number of subframes to do
     int m_maxSubframes = 1000000;
 
@@ -441,7 +441,7 @@ std::shared_ptr<imageSource::ImageSource> OTKApp::createExrImage( const std::str
 {
     try
     {
-        return filePath.empty() ? std::shared_ptr<imageSource::ImageSource>() : imageSource::createImageSource( filePath );
+        return filePath.empty() ? std::shared_ptr<imageSource::ImageSource>() : shareImageTiles( imageSource::createImageSource( filePath ) );
     }
     catch( ... )
     {
@@ -450,8 +450,20 @@ std::shared_ptr<imageSource::ImageSource> OTKApp::createExrImage( const std::str
 }
 
 
+std::shared_ptr<imageSource::ImageSource> OTKApp::shareImageTiles( std::shared_ptr<imageSource::ImageSource> image )
+{
+    // Each device has its own demand loader. Read the tiles through the shared cache so that they are decoded once.
+    if( !m_sharedTileCache || !image )
+        return image;
+    return std::make_shared<imageSource::SharedCachedImageSource>( image, m_sharedTileCache );
+}
+
+
 void OTKApp::initDemandLoading( demandLoading::Options options )
 {
+    if( m_perDeviceOptixStates.size() > 1 && m_sharedTileCacheSize > 0 )
+        m_sharedTileCache = std::make_shared<imageSource::SharedTileCache>( m_sharedTileCacheSize );
+
     for( OTKAppPerDeviceOptixState& state : m_perDeviceOptixStates )
     {
         OTK_ERROR_CHECK( cudaSetDevice( state.device_idx ) );
@@ -474,6 +486,12 @@ void OTKApp::printDemandLoadingStats()
     std::cout << "Num textures:             " << stats[0].numTextures << "\n";
     std::cout << "Virtual texture Size:     " << stats[0].virtualTextureBytes / ( 1024.0 * 1024.0 ) << " MiB\n";
     std::cout << "Tiles read from disk:     " << stats[0].numTilesRead << "\n";
+    if( m_sharedTileCache )
+    {
+        std::cout << "Shared tile cache:        " << m_sharedTileCache->getNumMisses() << " decoded, "
+                  << m_sharedTileCache->getNumHits() + m_sharedTileCache->getNumCoalesced() << " shared, "
+                  << m_sharedTileCache->getNumEvictions() << " evicted\n";
+    }
     
     std::cout << "Max device memory used:   ";
     for( OTKAppPerDeviceOptixState& state : m_perDeviceOptixStates )